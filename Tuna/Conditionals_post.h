@@ -74,6 +74,11 @@
    */
   #define MAX_STEP_FREQUENCY 65535 // Max step frequency for Ultimaker (5000 pps / half step)
 
+  /**
+   * Stepper timer ticks per second. Timer1 runs with a /8 prescaler (see Stepper::init).
+   */
+  #define STEPPER_TIMER_RATE (F_CPU / 8)
+
   // MS1 MS2 Stepper Driver Microstepping mode table
   #define MICROSTEP1 LOW,LOW
   #define MICROSTEP2 HIGH,LOW
@@ -336,7 +341,7 @@
   #define ABL_GRID   0
   #define HAS_ABL    0
   #define HAS_LEVELING          0
-  #define PLANNER_LEVELING      0
+  #define PLANNER_LEVELING      ENABLED(MESH_COMPENSATION)
   #define HAS_PROBING_PROCEDURE 0
 
   /**
@@ -379,6 +384,14 @@
   // Shorthand
   #define GRID_MAX_POINTS ((GRID_MAX_POINTS_X) * (GRID_MAX_POINTS_Y))
 
+  // Square roots from the float multiplier instead of libm
+  #if ENABLED(FAST_SQRT)
+    #undef SQRT
+    #undef RSQRT
+    #define SQRT(x)  Tuna::fast_sqrt<FAST_SQRT_ITERATIONS>(x)
+    #define RSQRT(x) Tuna::rsqrt<FAST_SQRT_ITERATIONS>(x)
+  #endif
+
   // Add commands that need sub-codes to this list
   #define USE_GCODE_SUBCODES 0
 
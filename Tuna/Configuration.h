@@ -97,21 +97,65 @@
  * Select which serial port on the board will be used for communication with the host.
  * This allows the connection of wireless adapters (for instance) to non-default port pins.
  * Serial port 0 is always used by the Arduino bootloader regardless of this setting.
+ * Use -1 for the native USB port (USB CDC) of an MCU that has one (USBCON). Its
+ * transfers aren't paced by a baud rate, so BAUDRATE is ignored.
  *
- * :[0, 1, 2, 3, 4, 5, 6, 7]
+ * :[-1, 0, 1, 2, 3, 4, 5, 6, 7]
  */
 #define SERIAL_PORT 0
 
+/**
+ * Receive and transmit buffer sizes of each serial port, in bytes, up to 256.
+ * Powers of 2 are cheapest. A port with a receive buffer of 0 isn't built and
+ * costs no SRAM. The host port's receive buffer rides out USB bursts; port 2
+ * drives the LCD, which is sent whole pages.
+ */
+#define SERIAL0_RX_BUFFER_SIZE 256
+#define SERIAL0_TX_BUFFER_SIZE 64
+#define SERIAL1_RX_BUFFER_SIZE 0
+#define SERIAL1_TX_BUFFER_SIZE 0
+#define SERIAL2_RX_BUFFER_SIZE 64
+#define SERIAL2_TX_BUFFER_SIZE 128
+#define SERIAL3_RX_BUFFER_SIZE 0
+#define SERIAL3_TX_BUFFER_SIZE 0
+
 /**
  * This setting determines the communication speed of the printer.
  *
  * 250000 works in most cases, but you might try a lower speed if
  * you commonly experience drop-outs during host printing.
  *
- * :[2400, 9600, 19200, 38400, 57600, 115200, 250000]
+ * At 16 MHz, 250000, 500000 and 1000000 are exact, and the i3 Plus's
+ * USB bridge takes them all; 115200 is 2.1% off. The build stops on
+ * a rate more than 2.5% off, such as 230400.
+ *
+ * :[2400, 9600, 19200, 38400, 57600, 115200, 250000, 500000, 1000000]
  */
 #define BAUDRATE 115200
 
+/**
+ * The rate of the link to the LCD, on serial port 2. The panel has to be
+ * set to the same rate: its stock LCDFirmware/DWIN_SET/CONFIG.txt has
+ * R1=07, for 115200. For 250000, copy LCDFirmware/DWIN_SET_250000/CONFIG.txt,
+ * with R1=0C, over it. With another rate than 115200, the printer checks at
+ * boot which of the two the panel answers at, so a panel that wasn't
+ * updated still works.
+ *
+ * 250000 is exact at 16 MHz. 230400 and 460800 are 3.5% and 8.5% off, so
+ * the build stops on them.
+ *
+ * :[115200, 250000]
+ */
+#define LCD_BAUDRATE 115200
+
+/**
+ * The panel plays its boot animation, pages 1 to 10, before it shows the
+ * main menu. Define this to cut it short: the printer shows the main menu
+ * itself, this many ms after it has loaded its settings and started the
+ * heaters. 0 skips the animation altogether.
+ */
+//#define LCD_BOOT_ANIMATION_MS 500
+
 // Enable the Bluetooth serial interface on AT90USB devices
 //#define BLUETOOTH
 
@@ -342,6 +386,29 @@
 
 #endif // PIDTEMP
 
+/**
+ * Model Heater Manager
+ *
+ * Drive the hotend from a thermal model of it instead of the Simple manager's PWM table.
+ * The model knows the heater's power, the block's heat capacity, the heat it loses to the air
+ * with and without the part fan, and the heat the filament takes with it, and each update asks
+ * for the power that brings the block to the target within MODEL_RESPONSE_TIME seconds. Fan
+ * changes and extrusion are compensated before they show up as a temperature error.
+ *
+ * M303 measures the heat capacity and the losses and saves them to EEPROM. The heater power is
+ * the heater's rating (W) at your supply voltage. Changing the manager changes the EEPROM layout.
+ */
+//#define MODEL_HEATER_MANAGER
+#if ENABLED(MODEL_HEATER_MANAGER)
+  #define MODEL_HEATER_POWER            40.0    // W
+  #define MODEL_FILAMENT_HEAT_CAPACITY  0.0056  // J/K per mm of filament (1.75mm PLA: 0.0056, 2.85mm PLA: 0.0149)
+  #define MODEL_RESPONSE_TIME           2.0     // s, how quickly the model closes a temperature gap
+  // Defaults until M303 has been run
+  #define MODEL_HEAT_CAPACITY           16.7    // J/K
+  #define MODEL_AMBIENT_LOSS            0.068   // W/K
+  #define MODEL_FAN_LOSS                0.097   // W/K, at full fan
+#endif
+
 //===========================================================================
 //============================= PID > Bed Temperature Control ===============
 //===========================================================================
@@ -354,6 +421,7 @@
 // If your configuration is significantly different than this and you don't understand the issues involved, you probably
 // shouldn't use bed PID until someone else verifies your hardware works.
 // If this is enabled, find your own PID constants below.
+// The bed is then driven by Thermal::Manager::Pid, set with M304, and its gains are kept in EEPROM.
 //#define PIDTEMPBED
 
 //#define BED_LIMIT_SWITCHING
@@ -475,6 +543,7 @@
 
 // Enable this feature if all enabled endstop pins are interrupt-capable.
 // This will remove the need to poll the interrupt pins, saving many CPU cycles.
+// Not available on the Bi3 Plus: none of its endstop pins can raise an interrupt.
 //#define ENDSTOP_INTERRUPTS_FEATURE
 
 //=============================================================================
@@ -557,6 +626,50 @@ template <uint32_t _steps, uint32_t _microsteps, uint32_t _ratio> static constex
 #define DEFAULT_ZJERK                  2
 #define DEFAULT_EJERK                  35.0
 
+/**
+ * Travel Jerk (mm/s)
+ * Override with M286 X Y Z
+ *
+ * Moves that don't extrude start and stop with these instead of the jerk
+ * above, and use them at a junction with another travel. A junction with a
+ * printing move keeps the print limits, so print quality settings aren't
+ * touched. With JUNCTION_DEVIATION, travel junctions take their own
+ * deviation too (M286 J).
+ */
+#define TRAVEL_JERK
+#if ENABLED(TRAVEL_JERK)
+  #define DEFAULT_TRAVEL_XJERK         25.0
+  #define DEFAULT_TRAVEL_YJERK         12.0
+  #define DEFAULT_TRAVEL_ZJERK         2
+  #define TRAVEL_JUNCTION_DEVIATION_MM 0.05  // (mm) Used only with JUNCTION_DEVIATION
+#endif
+
+/**
+ * Junction Deviation
+ * Override with M205 J
+ *
+ * Limit the speed at each junction by the angle between the two segments
+ * instead of by the per-axis jerk. The planner treats the corner as an arc
+ * that deviates JUNCTION_DEVIATION_MM from the sharp corner and allows the
+ * speed the block acceleration can hold on that arc. Larger values corner
+ * faster. The jerk values above still set the speed for starting from rest.
+ */
+//#define JUNCTION_DEVIATION
+#if ENABLED(JUNCTION_DEVIATION)
+  #define JUNCTION_DEVIATION_MM 0.02  // (mm) Distance from the real junction edge
+#endif
+
+/**
+ * S-Curve Acceleration
+ *
+ * Ramp the speed of each block along a smooth S-curve (a 6th order Bezier
+ * in position) instead of at a constant acceleration. Each ramp takes as
+ * long as the planned constant-acceleration one, so blocks still finish on
+ * time, but the acceleration builds up and dies down gradually. Peaks are
+ * 1.875x the planned acceleration, against far less ringing at the corners.
+ */
+//#define S_CURVE_ACCELERATION
+
 /**
 * Default Preheating Presets
 * Specific to i3Plus+
@@ -1004,6 +1117,15 @@ constexpr const uint8_t DEFAULT_PREHEAT_PRESETS[3][2] = { // TODO fixme
 #define EEPROM_SETTINGS // Enable for M500 and M501 commands
 //#define DISABLE_M503    // Saves ~2700 bytes of __flashmem. Disable for release!
 #define EEPROM_CHITCHAT   // Give feedback on EEPROM commands. Disable to save __flashmem.
+//#define EEPROM_BACKGROUND_WRITE // Write changed bytes from the EEPROM interrupt, so M500 doesn't stop the printer for ~3.3 ms a byte
+#if ENABLED(EEPROM_BACKGROUND_WRITE)
+  #define EEPROM_WRITE_QUEUE 64   // Bytes waiting to be written (2-256). 3 bytes of SRAM each.
+#endif
+//#define SETTINGS_PROFILES       // Keep several sets of settings, switched with M506 P<profile>
+#if ENABLED(SETTINGS_PROFILES)
+  #define SETTINGS_PROFILE_COUNT 3    // Profiles, one after the other from EEPROM address 100
+  #define SETTINGS_PROFILE_SIZE 640   // EEPROM bytes each. M500 reports what a profile takes.
+#endif
 
 //
 // Host Keepalive
@@ -1151,6 +1273,18 @@ constexpr const uint8_t DEFAULT_PREHEAT_PRESETS[3][2] = { // TODO fixme
  */
 #define PRINTCOUNTER
 
+/**
+ * Save the print statistics to a ring of records instead of one fixed block,
+ * each save going to the next record with a higher sequence number, so each
+ * EEPROM cell is written once every PRINTCOUNTER_JOURNAL_SLOTS saves. Boot
+ * takes the newest intact record; statistics saved without the journal are
+ * carried over. Each record takes 19 bytes of EEPROM, from address 2048.
+ */
+//#define PRINTCOUNTER_JOURNAL
+#if ENABLED(PRINTCOUNTER_JOURNAL)
+  #define PRINTCOUNTER_JOURNAL_SLOTS 64
+#endif
+
 //=============================================================================
 //============================= LCD and SD support ============================
 //=============================================================================
@@ -47,6 +47,53 @@
   #endif
 #endif
 
+/**
+ * Fast Boot
+ *
+ * setup() doesn't wait for what it needn't. Temperature::init() returns without
+ * its 250 ms settle; manage_heater() only acts on a finished reading, so the
+ * heaters stay off until the first one comes in, early in loop(). With an
+ * LCD_BAUDRATE other than 115200, the probes that find the panel's rate go on
+ * from lcd::update() instead of holding setup() for up to a second. Until the
+ * first reading, M105 reports 0.
+ */
+//#define FAST_BOOT
+
+// ms between the thermal runaway and heating watch checks, whose periods are whole seconds.
+#define HEATER_CHECK_INTERVAL 250
+
+// us of each idle() pass the LCD and the host reports may use before they wait for the next pass,
+// leaving the rest to reading and planning commands. The heaters and their checks always run.
+#define IDLE_PASS_BUDGET 2000
+
+/**
+ * Parallel Print Start
+ *
+ * From the start of an SD print until its first extruding move, M109 and M190
+ * only set their targets. Homing and leveling then run while the heaters warm
+ * up, and the first move that extrudes waits for the temperatures the skipped
+ * M109/M190 would have, with the same windows and residency times.
+ */
+//#define PARALLEL_PRINT_START
+
+/**
+ * Predictive Heatup Wait
+ *
+ * M109 and M190 stop waiting as soon as the temperature, going on at the rate
+ * it is changing, will be within TEMP_HYSTERESIS (TEMP_BED_HYSTERESIS) of the
+ * target by the first extrusion, HEATUP_LEAD_TIME (HEATUP_BED_LEAD_TIME)
+ * seconds on, and is no more than HEATUP_PREDICT_WINDOW short of it now. The
+ * residency time is skipped then, and the moves before the first extrusion,
+ * such as the travel to a purge line, run while the heater finishes. Waits
+ * for cooling, with R, are left as they are.
+ */
+//#define PREDICTIVE_HEATUP_WAIT
+#if ENABLED(PREDICTIVE_HEATUP_WAIT)
+  #define HEATUP_LEAD_TIME 5          // (seconds) from the end of M109 to the first extrusion
+  #define HEATUP_BED_LEAD_TIME 5      // (seconds) from the end of M190 to the first extrusion
+  #define HEATUP_PREDICT_WINDOW 5     // (degC) the most the temperature may be short of the target
+#endif
+
 /**
  * Thermal Protection protects your printer from damage and fire if a
  * thermistor falls out or temperature sensors fail in any way.
@@ -174,6 +221,31 @@
 #define TEMP_SENSOR_AD595_OFFSET 0.0
 #define TEMP_SENSOR_AD595_GAIN   1.0
 
+/**
+ * Hotend Hardware PWM
+ *
+ * Drive the hotend heater from timer 0's OC0B output (D4 on the i3 Plus) at 976Hz instead of
+ * with the ~0.5Hz software PWM in the temperature ISR, which then only has the bed to switch.
+ * The heater's new duty takes effect as soon as manage_heater() sets it.
+ *
+ * The temperature ISR moves to timer 0's compare A interrupt, so OC0A (D13, LED_PIN) can't
+ * be used with analogWrite().
+ */
+#define HOTEND_HARDWARE_PWM
+
+/**
+ * Free-running ADC
+ *
+ * Let the ADC convert continuously and sum ADC_FREE_RUNNING_SAMPLES conversions into each
+ * sensor reading from its own interrupt, instead of taking one conversion per temperature
+ * ISR call. Readings are quieter and the temperature ISR only handles heater PWM, at the
+ * cost of a very short ADC interrupt at about 9.6kHz.
+ */
+//#define ADC_FREE_RUNNING
+#if ENABLED(ADC_FREE_RUNNING)
+  #define ADC_FREE_RUNNING_SAMPLES 16 // Conversions per reading (1-64)
+#endif
+
 /**
  * Controller Fan
  * To cool down the stepper drivers and MOSFETs.
@@ -198,6 +270,21 @@
 // if fan speed is [1 - (FAN_MIN_PWM-1)] it is set to FAN_MIN_PWM
 //#define FAN_MIN_PWM 50
 
+/**
+ * Fan Hardware PWM
+ *
+ * Drive the part fan from timer 3's OC3A output (D5 on the i3 Plus), with the
+ * kickstart, FAN_MIN_PWM and a ramp between speeds run by timer 3's overflow
+ * interrupt instead of the main loop. Each block's fan speed is set by the
+ * stepper as the block starts, so the fan changes with the move it was given
+ * for. The ramp is in duty steps per PWM period (about 2ms); 0 jumps straight
+ * to the new speed.
+ */
+//#define FAN_HARDWARE_PWM
+#if ENABLED(FAN_HARDWARE_PWM)
+  #define FAN_HARDWARE_PWM_RAMP 8
+#endif
+
 // @section extruder
 
 /**
@@ -242,6 +329,30 @@
 // enable this option. Override at any time with M120, M121.
 //#define ENDSTOPS_ALWAYS_ON_DEFAULT
 
+/**
+ * Endstop Port Sampling
+ *
+ * Check the endstops from the stepper interrupt by reading each input register they're on once,
+ * rather than each pin on its own, and test them all against the ones the move is heading for
+ * at once. Every endstop is sampled each time, so it's debounced the same whether it was being
+ * watched or not. Requires a Cartesian machine without DUAL_X_CARRIAGE, on an ATmega1280/2560.
+ */
+//#define ENDSTOP_PORT_SAMPLING
+
+/**
+ * Endstop Edge Latching
+ *
+ * The stepper interrupt polls the endstops, and a hit is only taken once it has read as triggered
+ * ENDSTOP_DEBOUNCE times in a row, by when the axis has moved on. With this, the position of the
+ * axis is latched at the first of those reads, and that is the position reported for the hit, so
+ * it no longer moves with the feedrate. The report also gives how long the hit took to confirm.
+ * Requires a Cartesian machine.
+ */
+//#define ENDSTOP_EDGE_LATCH
+
+// Reads in a row an endstop must be triggered for to be hit (2 to 8). Without this, 2.
+//#define ENDSTOP_DEBOUNCE 3
+
 // @section extras
 
 //#define Z_LATE_ENABLE // Enable Z the last moment. Needed if your Z driver overheats.
@@ -321,6 +432,29 @@
 #define HOMING_BUMP_DIVISOR {32, 32, 64}  // Re-Bump Speed Divisor (Divides the Homing Feedrate)
 #define QUICK_HOME  //if this is defined, if both x and y are to be homed, a diagonal move will be performed initially.
 
+/**
+ * Home X and Y together when both are homed: one diagonal approach, one back-off and one
+ * re-bump, each axis at its own feedrate. An endstop stops only its own axis, and the move
+ * ends when both have stopped, so the slower axis sets the time instead of the sum of both.
+ */
+#define PARALLEL_HOMING
+
+/**
+ * After backing off, come back at the homing feedrate to this far short of where the endstop
+ * was hit, and do only the rest at the bump feedrate. Z, with its slowest bump, gains the most.
+ * It has to cover the overshoot of the fast approach; comment it out to re-bump the whole way.
+ */
+#define HOMING_BUMP_SLOW_MM 0.5
+
+/**
+ * Re-home an axis that has been homed since startup, even with its stepper turned off since,
+ * from where it's believed to be: a move at the axis maximum feedrate to HOME_BUMP_MM short
+ * of the endstop replaces the approach and back-off, and the bump checks the position. If the
+ * endstop is hit before the bump, or not within it, the axis is homed the whole way instead.
+ * Disabling the motors from the LCD forgets the position, for moving the axes by hand.
+ */
+#define FAST_REHOME
+
 // When G28 is called, this option will make Y home before X
 //#define HOME_Y_BEFORE_X
 
@@ -337,6 +471,90 @@
 #define INVERT_Z_STEP_PIN false
 #define INVERT_E_STEP_PIN false
 
+/**
+ * Step Port Grouping
+ *
+ * Collect the X, Y and Z step bits of each port and pulse them with one
+ * port write, instead of writing each step pin on its own. On the Bi3 Plus
+ * the Y and Z step pins share PORTK, which also needs no critical section
+ * per pin inside the stepper ISR. Shortens the pulse phase at high step rates.
+ */
+//#define STEP_PORT_GROUPING
+
+/**
+ * Direction Port Grouping
+ *
+ * Work out the X, Y and Z direction pins' port bits when a block is planned,
+ * and point all three with one port write when the stepper starts it, instead
+ * of testing and writing each pin. On the Bi3 Plus they all sit on PORTK.
+ * Blocks in the same direction as the last still skip the write altogether.
+ */
+//#define DIR_PORT_GROUPING
+
+/**
+ * Motion Sync Events
+ *
+ * Let M104 and M140 take effect when the moves before them have run, rather
+ * than as soon as they are read, without waiting for the planner to empty.
+ * Each waits for the block planned after it and runs once the stepper starts
+ * that block. M279 P<id> reports "marker:<id>" the same way, for a host to
+ * follow the motion. Uses 5 * MOTION_SYNC_EVENT_SLOTS bytes of SRAM.
+ */
+//#define MOTION_SYNC_EVENTS
+#if ENABLED(MOTION_SYNC_EVENTS)
+  #define MOTION_SYNC_EVENT_SLOTS 8  // Events waiting at once (2-256)
+#endif
+
+/**
+ * Lazy Step Position
+ *
+ * Leave the stepper positions alone while a block runs, rather than adding
+ * every step to them in the stepper ISR, and add the block's steps once it
+ * ends. Anything that reads a position mid-block, such as M114 or a
+ * triggered endstop, works it out from the Bresenham counters, with a
+ * division. Arc blocks still count each step.
+ */
+//#define LAZY_STEP_POSITION
+
+/**
+ * Free-Running Stepper Timer
+ *
+ * Run Timer 1 free instead of restarting it at every stepper interrupt, and
+ * set each compare to the last one plus the interval. An interrupt that runs
+ * late no longer pushes every step after it back. One that misses its time
+ * runs as soon as it can, and the next is still due when it was meant to be.
+ * Requires LIN_ADVANCE, whose scheduler sets the compares.
+ */
+//#define STEPPER_FREE_RUNNING_TIMER
+
+/**
+ * Input Shaping
+ *
+ * Cancel the ringing of X and Y at their resonant frequency. Each step is put
+ * out in parts, the later ones delayed by a share of the ringing period, so that
+ * the parts' ringing cancels out. ZV uses two parts, 1/2 period apart. MZV uses
+ * three, 3/8 of a period apart, and copes better with a frequency that is a bit
+ * off. Find the frequency with buildroot/share/scripts/input_shaping_tower.py,
+ * and set it with M593 X|Y F<Hz> D<damping ratio> T<0: ZV, 1: MZV>. F0 turns
+ * the axis's shaper off, and homing always runs without it.
+ *
+ * Corners are rounded by the delay, about 1/(2 * frequency) of travel for ZV.
+ * The delayed steps of SHAPING_BUFFER_SIZE * SHAPING_MERGE_TIME (32ms by default)
+ * are held, enough for ZV down to 16Hz and MZV down to 22Hz; steps beyond that
+ * go out unshaped. Uses 4 * SHAPING_BUFFER_SIZE + 30 bytes of SRAM.
+ */
+//#define INPUT_SHAPING
+#if ENABLED(INPUT_SHAPING)
+  #define SHAPING_FREQ_X      40.0  // (Hz) Ringing frequency of X (10-200, or 0 for none)
+  #define SHAPING_FREQ_Y      30.0  // (Hz) Ringing frequency of Y, lower for the heavier bed
+  #define SHAPING_ZETA_X      0.15  // Damping ratio of the X ringing (0-0.9)
+  #define SHAPING_ZETA_Y      0.15  // Damping ratio of the Y ringing (0-0.9)
+  #define SHAPING_TYPE_X      0     // 0: ZV, 1: MZV
+  #define SHAPING_TYPE_Y      0
+  #define SHAPING_BUFFER_SIZE 128   // Entries of delayed steps (a power of 2, 16-256)
+  #define SHAPING_MERGE_TIME  256   // (us) The steps of this long go in one entry (up to 1000)
+#endif
+
 // Default stepper release if idle. Set to 0 to deactivate.
 // Steppers will shut down DEFAULT_STEPPER_DEACTIVE_TIME seconds after the last move when DISABLE_INACTIVE_? is true.
 // Time can be set by M18 and M84.
@@ -346,6 +564,20 @@
 #define DISABLE_INACTIVE_Z true  // set to false if the nozzle will fall down on your printed part when print has finished.
 #define DISABLE_INACTIVE_E true
 
+/**
+ * Driver Wake Lead
+ *
+ * A driver that was off needs a moment after it's enabled before its first step. When a
+ * block needs a driver that is off, the driver is enabled as the block is queued, and the
+ * stepper doesn't start that block until DRIVER_WAKE_LEAD ms later. The blocks queued
+ * ahead of it run meanwhile, so it only waits if the queue had run dry.
+ */
+//#define DRIVER_WAKE_LEAD 2
+
+// Turn the extruder driver off once nothing queued has extruded for this long (ms), as in
+// long travel, and back on with the next move that extrudes. Best with DRIVER_WAKE_LEAD.
+//#define E_TRAVEL_IDLE_MS 2000
+
 #define DEFAULT_MINIMUMFEEDRATE       0.0     // minimum feedrate
 #define DEFAULT_MINTRAVELFEEDRATE     0.0
 
@@ -366,6 +598,300 @@
 // If defined the movements slow down when the look ahead buffer is only half full
 #define SLOWDOWN
 
+// Slow down by the time the buffered moves take instead of by how many blocks there are,
+// once it drops below this many milliseconds, so short segments among long ones aren't
+// slowed while seconds of motion are still queued. ADVANCED_OK then also reports the
+// buffered time as Q<ms>, for hosts that pace their sending by it. Requires PRINT_TIME_ESTIMATE.
+//#define SLOWDOWN_BUFFER_MS 200
+
+// Compute the acceleration and deceleration points of each block with integer math
+// instead of soft-float. Matches the float trapezoid generator to within one step.
+#define INTEGER_TRAPEZOID_GENERATOR
+
+/**
+ * Move Coalescing
+ *
+ * Merge runs of short, nearly collinear G0/G1 moves (as slicers emit for infill
+ * and fine curves) into one planner block. This saves planner time and leaves
+ * more of the block buffer for lookahead.
+ *
+ * Moves are merged only while every end point stays within COALESCE_TOLERANCE_MM
+ * of the line of the run, the feedrate is unchanged and the extrusion per mm
+ * stays within COALESCE_E_RATIO_TOLERANCE of the first move.
+ */
+//#define MOVE_COALESCING
+#if ENABLED(MOVE_COALESCING)
+  #define COALESCE_TOLERANCE_MM       0.01  // (mm) Largest distance of a merged point from the merged move
+  #define COALESCE_E_RATIO_TOLERANCE  0.02  // Largest relative change in extrusion per mm
+  #define COALESCE_MAX_LENGTH_MM      5.0   // (mm) Longest merged move. Longer moves are not held.
+  // Merge the Z-only move of a layer change with the travel after it, when neither extrudes,
+  // into one diagonal block, so there is no stop between them. Z goes no faster than its own
+  // move asked for, and the planner keeps each axis within max_feedrate_mm_s.
+  //#define COALESCE_LAYER_CHANGE
+#endif
+
+/**
+ * Mesh Compensation
+ *
+ * Follow the bed in Z by a grid of heights measured by hand, such as with a feeler gauge at
+ * each point after Z homing: set them with M421 I<column> J<row> Z<mm>, turn it on with
+ * M420 S1 and keep both with M500. Between the points the bed is bilinear, worked out in
+ * fixed point for each planner end point. Moves are split only where they cross into
+ * another cell of the grid, so short moves cost nothing extra. Homing is done without it.
+ * Not with ARC_BLOCKS or FWRETRACT_LOOKAHEAD.
+ */
+//#define MESH_COMPENSATION
+#if ENABLED(MESH_COMPENSATION)
+  #define MESH_GRID_X 3            // Points across X (2-7)
+  #define MESH_GRID_Y 3            // Points across Y (2-7)
+  #define MESH_MIN_X  (X_MIN_POS + 10)
+  #define MESH_MAX_X  (X_MAX_POS - 10)
+  #define MESH_MIN_Y  (Y_MIN_POS + 10)
+  #define MESH_MAX_Y  (Y_MAX_POS - 10)
+#endif
+
+/**
+ * Ramp Tables
+ *
+ * Work out the first RAMP_TABLE_LENGTH acceleration and deceleration intervals
+ * of the next block from the main loop, while the current block is running.
+ * The stepper ISR then reads the step rate and timer interval from the table
+ * instead of computing them on every step, and falls back to computing them
+ * past the end of the table. Uses 16 * RAMP_TABLE_LENGTH + 50 bytes of SRAM.
+ */
+//#define RAMP_TABLES
+#if ENABLED(RAMP_TABLES)
+  #define RAMP_TABLE_LENGTH 16  // Intervals per ramp (1-255)
+#endif
+
+/**
+ * Step Rate Calibration
+ *
+ * Time the stepper ISR at startup, on a made-up block stepping every axis on
+ * every step event, at each multi-stepping level. The planner then slows any
+ * move whose step rate would keep the ISR busy for more than STEP_RATE_ISR_LOAD
+ * percent of the time, so it runs smoothly instead of stuttering.
+ * The measured rate is reported at startup. Endstop checks are not included.
+ */
+//#define STEP_RATE_CALIBRATION
+#if ENABLED(STEP_RATE_CALIBRATION)
+  #define STEP_RATE_ISR_LOAD 70 // (%) Largest share of the time the stepper ISR may use (1-100)
+#endif
+
+/**
+ * Live Speed Override
+ *
+ * A new feedrate percentage, from M220 or the LCD's Print Config page, also
+ * rescales the moves already in the planner, which are then replanned, so
+ * the change shows at once instead of a buffer later. As with the percentage
+ * itself, moves without X or Y are left alone, and no axis is taken past its
+ * max feedrate. The running move and the one after it keep their speeds.
+ */
+//#define LIVE_SPEED_OVERRIDE
+
+/**
+ * Quick Pause
+ *
+ * Pausing from the LCD brings the moves in the planner to a stop as soon as
+ * their acceleration allows, instead of running the whole buffer first. The
+ * moves after the stop, and the commands read after them, wait where they are
+ * until the print is resumed from the LCD, and then go on from rest. The
+ * running move and the one after it finish at their planned speeds. Host
+ * commands also wait while paused. Not with PARK_HEAD_ON_PAUSE, which parks
+ * after the buffer.
+ */
+//#define QUICK_PAUSE
+
+/**
+ * Quick Pause Park
+ *
+ * With QUICK_PAUSE, once the nozzle has stopped, draw the filament back, raise
+ * Z and move clear of the print. The held moves stay in the planner as they
+ * were planned, and resuming comes back the same way, primes, and runs them
+ * with all their lookahead, as if there had been no pause.
+ */
+//#define QUICK_PAUSE_PARK
+#if ENABLED(QUICK_PAUSE_PARK)
+  #define QUICK_PAUSE_PARK_X_POS            (X_MIN_POS + 10)   // (mm)
+  #define QUICK_PAUSE_PARK_Y_POS            (Y_MAX_POS - 10)   // (mm)
+  #define QUICK_PAUSE_PARK_Z_RAISE          10                 // (mm) Up from where the nozzle stopped, to Z_MAX_POS
+  #define QUICK_PAUSE_PARK_XY_FEEDRATE      100                // (mm/s)
+  #define QUICK_PAUSE_PARK_Z_FEEDRATE       5                  // (mm/s)
+  #define QUICK_PAUSE_PARK_RETRACT_LENGTH   2                  // (mm) Drawn back while parked, and primed again
+  #define QUICK_PAUSE_PARK_RETRACT_FEEDRATE 40                 // (mm/s)
+#endif
+
+/**
+ * Print Time Estimate
+ *
+ * Keep the time of the moves in the planner, from each block's trapezoid, and
+ * show the minutes left of a print on the LCD at VP 0x0006. The slicer's own
+ * estimate is taken from M73 R<minutes>, and counted from when the moves ahead
+ * of it finish; without M73, the elapsed time is scaled by the unread part of
+ * the file.
+ */
+//#define PRINT_TIME_ESTIMATE
+
+/**
+ * Fast Square Roots
+ *
+ * Take the planner's square roots from Tuna::rsqrt(), a few float multiplies,
+ * instead of libm's sqrt(), and normalize the junction vectors in
+ * recalculate_trapezoids() with it instead of with sqrt() and a divide.
+ * FAST_SQRT_ITERATIONS sets the precision: 1 is good to 0.18%, 2 to 5e-6 and
+ * 3 to about a float ulp, each costing three more multiplies.
+ */
+//#define FAST_SQRT
+#if ENABLED(FAST_SQRT)
+  #define FAST_SQRT_ITERATIONS 2  // Newton steps (1-3)
+#endif
+
+/**
+ * Math Benchmark
+ *
+ * M285 times sqrt(), 1 / sqrt(), Tuna::rsqrt() at each precision and the
+ * integer square roots, and reports their CPU cycles per call, to weigh
+ * FAST_SQRT on the printer itself. Run it with the printer idle, as the
+ * interrupts are counted in.
+ */
+//#define MATH_BENCHMARK
+
+/**
+ * Planner Profiling
+ *
+ * Time every block added to the planner and keep track of how deep the block
+ * buffer stays. Report with M296, and clear with M296 R. Replay a print with
+ * M296 R before and M296 after to compare planner changes on the printer itself.
+ */
+//#define PLANNER_PROFILING
+
+/**
+ * Thermal Log
+ *
+ * The heater, bed and fan managers log their calibrations to serial. LOG_LEVEL 0
+ * compiles every message out, 1 keeps what each calibration does, and 2 the
+ * steps in between as well. LOG_BINARY sends each message as a "log:<length>"
+ * line of raw bytes instead of formatting it: the flash addresses of its tag and
+ * format, and its arguments as they are. Formatting the messages is left to the
+ * host: buildroot/share/scripts/decode_log.py reads them with the build's .hex.
+ */
+#define LOG_LEVEL 2
+//#define LOG_BINARY
+
+/**
+ * ISR Profiling
+ *
+ * Time the stepper, advance and temperature interrupt handlers and count how
+ * often they run past their next deadline. Report with M297 (in CPU cycles,
+ * to within 8 cycles for the stepper and 64 for the temperature handler), and
+ * clear with M297 R. Each call costs a few extra cycles while enabled.
+ *
+ * Calls longer than their budget, in CPU cycles, are counted as over budget.
+ * With NESTED_INTERRUPTS the temperature handler's time includes the
+ * handlers that preempted it.
+ */
+//#define ISR_PROFILING
+#if ENABLED(ISR_PROFILING)
+  #define ISR_STEPPER_BUDGET      800   // 50us, half of a step at 10kHz
+  #define ISR_ADVANCE_BUDGET      400
+  #define ISR_TEMPERATURE_BUDGET 1600   // 100us
+#endif
+
+/**
+ * Nested Interrupts
+ *
+ * Let the stepper interrupt preempt the temperature handler and the ADC,
+ * instead of waiting for them to finish. They turn interrupts back on with
+ * their own sources masked, and put them back as they return. The stepper,
+ * serial, EEPROM and watchdog handlers still run with interrupts off. Stack
+ * use grows by one stepper interrupt on top of a temperature one.
+ */
+//#define NESTED_INTERRUPTS
+
+/**
+ * Pipeline Profiling
+ *
+ * Time each stage of the G-code pipeline to find what bounds a slow print:
+ * reading from SD, parsing, running G0/G1, other G, M and other commands,
+ * adding blocks to the planner, and waiting on a full planner. Report calls,
+ * total, average and max in microseconds with M291, and clear with M291 R.
+ * Command times include their parsing, planning and waiting.
+ */
+//#define PIPELINE_PROFILING
+
+/**
+ * Loop Latency Histogram
+ *
+ * Time every pass of loop(), a command with the idle() it runs, and count
+ * them in power-of-two bins of microseconds. M283 reports the bins, the
+ * longest pass with its command, and the passes that started with moves
+ * queued and ended with the planner empty while commands were waiting,
+ * which is when the main loop starved the motion. M283 R clears them.
+ */
+//#define LOOP_LATENCY_HISTOGRAM
+
+/**
+ * Serial Benchmark
+ *
+ * M289 S1 starts a dry run: every line is still read, checked, queued and
+ * parsed, and gets its "ok", but nothing other than M289 is carried out.
+ * M289 S0 ends it, and M289 reports the lines taken, the line errors, and
+ * the lines per second since it started. buildroot/share/scripts/
+ * serial_benchmark.py streams a standard line mix against it and reports
+ * throughput, "ok" latency and resends from the host side.
+ */
+//#define SERIAL_BENCHMARK
+
+/**
+ * Step Trace
+ *
+ * Record what the stepper ISR emitted: the block, step_events_completed, the
+ * interval to the next ISR, step_loops and the direction bits. Start recording
+ * every Nth ISR with M295 S<N> and stop with M295 S0. M295 prints and removes the
+ * recorded entries; once STEP_TRACE_LENGTH - 1 are waiting, new ones are dropped.
+ * buildroot/share/scripts/plot_step_trace.py turns a log of them into a velocity
+ * profile. Uses 8 * STEP_TRACE_LENGTH bytes of SRAM.
+ */
+//#define STEP_TRACE
+#if ENABLED(STEP_TRACE)
+  #define STEP_TRACE_LENGTH 64  // Entries in the trace ring (2-256)
+#endif
+
+/**
+ * Thermal Telemetry
+ *
+ * Record the hotend every N milliseconds: the time, its temperature and target, the
+ * heater PWM and the bed heater state. Start recording with M294 S<N> and stop with
+ * M294 S0. M294 sends and removes the recorded entries as a "telemetry:<count>" line
+ * followed by <count> binary 8-byte entries, so a tuning session can pull the data
+ * in bursts without M105 polling. buildroot/share/scripts/read_thermal_telemetry.py
+ * fetches and decodes them. Uses 8 * THERMAL_TELEMETRY_LENGTH bytes of SRAM.
+ */
+//#define THERMAL_TELEMETRY
+#if ENABLED(THERMAL_TELEMETRY)
+  #define THERMAL_TELEMETRY_LENGTH 64  // Entries in the telemetry ring (2-256)
+#endif
+
+/**
+ * Heater Power Budget
+ *
+ * Keep the hotend and the bed together within what the power supply can give them, so both can
+ * heat at once on a supply that can't run both at full power. While they would draw more than
+ * HEATER_POWER_BUDGET_WATTS, the heater with the longer time to its target (from its distance and
+ * its rate of rise) gets the power it asks for and the other heats with what is left. The budget is
+ * of the average power over each heater's PWM cycle. Without PIDTEMPBED the bed is all or nothing,
+ * so it waits for the hotend when there isn't room for all of it.
+ *
+ * The G-code still heats in the order it waits in: start both heaters (M140, M104) before waiting
+ * for either (M190, M109) for them to heat at once.
+ */
+//#define HEATER_POWER_BUDGET
+#if ENABLED(HEATER_POWER_BUDGET)
+  #define HEATER_POWER_BUDGET_WATTS 150  // For both heaters, less than the two below together
+  #define HEATER_POWER_HOTEND_WATTS 40   // The hotend heater at full power
+  #define HEATER_POWER_BED_WATTS 120     // The bed heater at full power
+#endif
+
 // Frequency limit
 // See nophead's blog for more info
 // Not working O
@@ -421,6 +947,40 @@
 // Include a page of printer information in the LCD Main Menu
 //#define LCD_INFO_MENU
 
+/**
+ * LCD Yield To Planner
+ *
+ * Hold back the LCD status and graph updates, and the statistics page,
+ * while the planner has fewer than LCD_YIELD_MOVES moves left, or an SD
+ * print has emptied the command queue, so that refilling them comes first
+ * and short segments don't stutter. An update is never held back for more
+ * than LCD_YIELD_MAX_MS. Key presses are still read.
+ */
+//#define LCD_YIELD_TO_PLANNER
+#if ENABLED(LCD_YIELD_TO_PLANNER)
+  #define LCD_YIELD_MOVES 4
+  #define LCD_YIELD_MAX_MS 1000
+#endif
+
+/**
+ * LCD Continuous Jog
+ *
+ * Jog X, Y and Z from the Move page for as long as a button is held, instead
+ * of a fixed step per press. Short blocks are queued straight to the planner,
+ * two at a time, and once the button is let go the last of them brakes to a
+ * stop. The buttons must repeat their key while held (set in the LCD's
+ * project), and the move stops LCD_JOG_RELEASE_MS after the last repeat.
+ * Each block is LCD_JOG_SEGMENT_MS of travel; two of them must be enough to
+ * stop from the jog feedrate, or the jog won't reach it.
+ */
+//#define LCD_CONTINUOUS_JOG
+#if ENABLED(LCD_CONTINUOUS_JOG)
+  #define LCD_JOG_XY_FEEDRATE 3000 // (mm/min)
+  #define LCD_JOG_Z_FEEDRATE 300   // (mm/min)
+  #define LCD_JOG_SEGMENT_MS 50
+  #define LCD_JOG_RELEASE_MS 150
+#endif
+
 // Scroll a longer status message into view
 //#define STATUS_MESSAGE_SCROLLING
 
@@ -502,6 +1062,161 @@
   // This allows hosts to request long names for files and folders with M33
   #define LONG_FILENAME_HOST_SUPPORT 1
 
+  /**
+   * SD Directory Index
+   *
+   * Count the current directory once and remember where each listed entry
+   * starts, with a hash of its short name, so the LCD file browser, presort()
+   * and lookups by name read one entry instead of walking the directory. The
+   * index is rebuilt after the card is initialized, the directory changes, or
+   * a file is written or deleted. Each entry costs 3 bytes of SRAM; entries
+   * past SD_DIR_INDEX_LIMIT are found by walking, as before.
+   */
+  //#define SD_DIR_INDEX
+  #if ENABLED(SD_DIR_INDEX)
+    #define SD_DIR_INDEX_LIMIT 64
+  #endif
+
+  /**
+   * SD Read-Ahead
+   *
+   * Read the next block of the file being printed into a second 512-byte
+   * buffer from idle(), 64 bytes at a time, while the current block is parsed.
+   * Crossing into the block then costs a copy instead of stalling the main
+   * loop for the whole SPI read. The first block of each cluster is still read
+   * on demand, as finding it needs the FAT. Costs 512 bytes of SRAM.
+   */
+  //#define SD_READ_AHEAD
+
+  /**
+   * SD Multiple Block Read
+   *
+   * While printing from SD, read the file's blocks through one multiple block
+   * read (CMD18) instead of a single block read (CMD17) for each, saving the
+   * command and the card's access time on every block after the first. The
+   * read ends at a seek, a pause, the end of the print, or any other card
+   * access, such as the FAT read at a cluster boundary, and starts again at
+   * the next block.
+   */
+  //#define SD_MULTIBLOCK_READ
+
+  /**
+   * SD Cluster Map
+   *
+   * Map the cluster chain of the file being printed when it's opened, as runs
+   * of consecutive clusters, so reads at cluster boundaries and seeks (as for
+   * a resume) don't read the FAT through the single block cache. Each run
+   * costs 6 bytes of SRAM. Most files are in a few runs; a file with more is
+   * mapped as far as they go.
+   */
+  //#define SD_CLUSTER_MAP
+  #if ENABLED(SD_CLUSTER_MAP)
+    #define SD_CLUSTER_MAP_RUNS 8
+  #endif
+
+  /**
+   * SD Block Scan
+   *
+   * Read a printed G-code file from the block in the SD cache instead of a
+   * byte at a time through the file: a comment, thumbnails included, is
+   * passed over with one search for the end of its line, and a command is
+   * copied up to the character that ends it. Leading spaces are dropped.
+   */
+  //#define SD_BLOCK_SCAN
+
+  /**
+   * SD Write Buffer
+   *
+   * Gather the lines of an M28 upload or an M928 log into whole blocks and
+   * write each straight to the card, instead of through the single block
+   * cache that also holds the FAT, so they don't push each other out. The
+   * file grows by SD_WRITE_ALLOC_CLUSTERS clusters at a time, as one run
+   * where the card has one, and is trimmed to its size by M29. The directory
+   * entry is written once, as the file is closed. Costs 512 bytes of SRAM.
+   */
+  //#define SD_WRITE_BUFFER
+  #if ENABLED(SD_WRITE_BUFFER)
+    #define SD_WRITE_ALLOC_CLUSTERS 8
+  #endif
+
+  /**
+   * Power-Loss Recovery
+   *
+   * At the first extruding move of each layer of an SD print, note the file
+   * position of that move with the position, temperatures, fan and feedrate
+   * before it, and have idle() write the record to PLR.BIN on the card. The
+   * file is made once, two blocks long; each record is one raw block write,
+   * to the block the last one didn't use, and doesn't wait for the card to
+   * finish it. A cut mid-write leaves the other record. At boot, a record
+   * left by an unfinished print is reported, and M1000 resumes the print from
+   * the start of that layer. "M1000 C" forgets it.
+   */
+  //#define POWER_LOSS_RECOVERY
+  #if ENABLED(POWER_LOSS_RECOVERY)
+    #define POWER_LOSS_ZRAISE 2 // (mm) Lift over the print for M1000 to home X and Y
+  #endif
+
+  /**
+   * SD Card Benchmark
+   *
+   * M288 S<blocks> reads that many blocks raw from the start of the card and
+   * reports the kB/s and how the block read times spread, from under 1 ms to
+   * over 16 ms. With a file selected by M23, it then reads as many bytes of
+   * the file with SdBaseFile::read() and with get(), as a print does, and
+   * reports those rates. Only the reads are timed. Not while printing.
+   */
+  //#define SD_BENCHMARK
+
+  /**
+   * Job Queue
+   *
+   * A file with the extension .GQ in the root of the card lists prints to run
+   * one after another, one to a line. Lines ending in .g, .gco or .gcode are
+   * printed from the root, and any other line is a command run between the
+   * prints, after the end of the one before, so the next job can start its
+   * preheat while the last one cools. ';' starts a comment. Start a queue by
+   * picking it from the LCD's file list, or with "M276 name.gq". Stopping the
+   * print from the LCD ends its queue, "M276 C" ends it after the print that
+   * is running, and M276 reports it.
+   */
+  //#define JOB_QUEUE
+
+  /**
+   * Firmware Update from SD
+   *
+   * At boot, an update image named FIRMWARE_UPDATE_FILE in the root of the
+   * card is checked against its XTEA CBC-MAC tag under FIRMWARE_UPDATE_KEY,
+   * and its version against SHORT_BUILD_VERSION. A good update for another
+   * version is copied as the raw image to FIRMWARE_UPDATE_STAGED_FILE and
+   * the board resets by the watchdog, for the bootloader to flash it. The
+   * application can't write its own flash, so this needs a bootloader that
+   * flashes that file from the card on reset, such as avr_boot. Once the new
+   * version boots, the staged copy is removed and the update is renamed to
+   * FIRMWARE_UPDATE_DONE_FILE; a bad or unflashed one goes to
+   * FIRMWARE_UPDATE_FAILED_FILE. buildroot/share/scripts/make_update_image.py
+   * makes an image from the build's .hex with the same key. Change the key!
+   */
+  //#define FIRMWARE_UPDATE
+  #if ENABLED(FIRMWARE_UPDATE)
+    #define FIRMWARE_UPDATE_FILE "FIRMWARE.TUN"
+    #define FIRMWARE_UPDATE_STAGED_FILE "FIRMWARE.BIN"
+    #define FIRMWARE_UPDATE_DONE_FILE "FIRMWARE.CUR"
+    #define FIRMWARE_UPDATE_FAILED_FILE "FIRMWARE.ERR"
+    #define FIRMWARE_UPDATE_KEY { 0x00000000, 0x00000000, 0x00000000, 0x00000000 }
+  #endif
+
+  /**
+   * SD Card on a USART
+   *
+   * For boards that wire the SD card to a USART instead of the SPI pins: TXD
+   * to the card's DI, RXD to its DO and XCK to its clock. The USART runs as an
+   * SPI master, and its double-buffered transmitter keeps the clock going
+   * between bytes, so blocks are read at the full F_CPU/2 rate. The USART
+   * can't also be a serial port: set its SERIALn buffer sizes to 0.
+   */
+  //#define SD_SPI_USART 1
+  //#define SD_SPI_USART_XCK_PIN -1  // Pin of the USART's XCK line
+
 #endif // SDSUPPORT
 
 /**
@@ -547,6 +1262,11 @@
   // The "WATCHDOG_RESET_MANUAL" goes around this by not using the hardware reset.
   //  However, THIS FEATURE IS UNSAFE!, as it will only work if interrupts are disabled. And the code could hang in an interrupt routine with interrupts disabled.
   //#define WATCHDOG_RESET_MANUAL
+
+  // Catch the main loop 2 seconds into a stall, half way to the reset, and note where it was: the
+  // interrupted address and the idle() task running. Reported as soon as the loop comes back, or
+  // at the next boot if it never did. Give the address to avr-addr2line with the .elf for the function.
+  //#define WATCHDOG_STALL_REPORT
 #endif
 
 // @section lcd
@@ -556,6 +1276,9 @@
  * the current position values. This feature is used primarily to adjust the Z
  * axis in the first layer of a print in real-time.
  *
+ * Babysteps are queued and taken by the stepper ISR between regular steps,
+ * at most one per axis each millisecond.
+ *
  * Warning: Does not respect endstops!
  */
 //#define BABYSTEPPING
@@ -609,6 +1332,18 @@
    */
   #define LIN_ADVANCE_E_D_RATIO 0 // The calculated ratio (or 0) according to the formula W * H / ((D / 2) ^ 2 * PI)
                                   // Example: 0.4 * 0.2 / ((1.75 / 2) ^ 2 * PI) = 0.033260135
+
+  /**
+   * Pulse the extruder at the end of each main stepper interrupt instead of from a
+   * separate advance interrupt interleaved with it. This saves an interrupt entry and
+   * the rescheduling of Timer 1 for every E step. Each main interrupt sends at most
+   * LIN_ADVANCE_E_STEPS_PER_ISR times as many E steps as it steps the other axes, and
+   * leaves the rest to the next one.
+   */
+  //#define LIN_ADVANCE_SHARED_TIMELINE
+  #if ENABLED(LIN_ADVANCE_SHARED_TIMELINE)
+    #define LIN_ADVANCE_E_STEPS_PER_ISR 2
+  #endif
 #endif
 
 // @section leveling
@@ -639,14 +1374,43 @@
 //
 //#define ARC_SUPPORT               // Disable this feature to save ~3226 bytes
 #if ENABLED(ARC_SUPPORT)
-  #define MM_PER_ARC_SEGMENT  1   // Length of each arc segment
+  #define MM_PER_ARC_SEGMENT  1   // Length of each arc segment, when ARC_CHORD_TOLERANCE is 0
+
+  /**
+   * Make arc segments as long as they can be while cutting at most ARC_CHORD_TOLERANCE inside
+   * the arc, between MIN_ARC_SEGMENT_MM and MAX_ARC_SEGMENT_MM. Small arcs then get short
+   * segments and large ones few long segments. Set 0 for segments of MM_PER_ARC_SEGMENT.
+   * Set at runtime with M287 S<tolerance> P<min> Q<max>.
+   */
+  #define ARC_CHORD_TOLERANCE 0.01  // (mm)
+  #define MIN_ARC_SEGMENT_MM  0.1   // (mm)
+  #define MAX_ARC_SEGMENT_MM  10    // (mm)
   #define N_ARC_CORRECTION   25   // Number of intertpolated segments between corrections
   #define ARC_P_CIRCLES         // Enable the 'P' parameter to specify complete circles
   #define CNC_WORKSPACE_PLANES  // Allow G2/G3 to operate in XY, ZX, or YZ planes
+
+  /**
+   * Queue an arc as a single planner block, which the stepper ISR traces step by step,
+   * instead of as segments of MM_PER_ARC_SEGMENT. The arc is then smooth at any size and
+   * takes one block of the buffer. Arcs that can't be a block (X and Y with different
+   * steps per mm, too large, or outside the soft endstops) are still segmented.
+   * Adds 16 bytes to each planner block, and arc blocks aren't slowed by SLOWDOWN.
+   */
+  //#define ARC_BLOCKS
 #endif
 
 // Support for G5 with XYZE destination and IJPQ offsets. Requires ~2666 bytes.
 #define BEZIER_CURVE_SUPPORT
+#if ENABLED(BEZIER_CURVE_SUPPORT)
+  /**
+   * Cut G5 curves into equal steps of the curve parameter, as many as keep each segment within
+   * BEZIER_TOLERANCE of the curve, and step along it by forward differences in fixed point.
+   * Every segment then costs a few additions. Disable to search for each step as Marlin does,
+   * which evaluates the curve several times per segment.
+   */
+  #define BEZIER_FORWARD_DIFFERENCING
+  #define BEZIER_TOLERANCE 0.05 // (mm)
+#endif
 
 // G38.2 and G38.3 Probe Target
 // Enable PROBE_DOUBLE_TOUCH if you want G38 to double touch
@@ -674,19 +1438,196 @@
 // @section hidden
 
 // The number of linear motions that can be in the plan at any give time.
-// THE BLOCK_BUFFER_SIZE NEEDS TO BE A POWER OF 2, i.g. 8,16,32 because shifts and ors are used to do the ring-buffering.
+// Any size works. Powers of 2 (8, 16, 32) wrap with a mask and are marginally cheaper.
+// The build prints the remaining SRAM, so this can be sized to the available headroom.
 #if ENABLED(SDSUPPORT)
   #define BLOCK_BUFFER_SIZE 32 // SD,LCD,Buttons take more memory, block buffer needs to be smaller
 #else
   #define BLOCK_BUFFER_SIZE 32 // maximize block buffer
 #endif
 
+/**
+ * SRAM Budget
+ *
+ * Add up the largest static buffers at compile time: the planner's blocks, the
+ * command queue, the serial buffers, the SD card's file names, sort lists and
+ * block cache, and the stepper and telemetry buffers. The build fails unless
+ * they leave SRAM_STACK_RESERVE bytes of the 8 KB for the stack and the smaller
+ * statics. At boot, each is listed by the free memory, with all the statics as
+ * linked, so BLOCK_BUFFER_SIZE, BUFSIZE and the rest can be pushed to the limit.
+ */
+//#define SRAM_BUDGET
+#if ENABLED(SRAM_BUDGET)
+  #define SRAM_STACK_RESERVE 1024
+#endif
+
+/**
+ * Stack Painting
+ *
+ * Fill the free SRAM with a known byte at boot, before anything runs, so the
+ * deepest the stack has gone, with the ISRs nested on idle() and the handlers,
+ * can be found later by where the fill stops. M284 reports it with the free
+ * memory, and M284 R paints it again after a change. What a long print never
+ * touched is headroom BLOCK_BUFFER_SIZE and BUFSIZE can take.
+ */
+//#define STACK_PAINTING
+
+/**
+ * Scratch Arena
+ *
+ * Take the short-lived buffers from one static arena, as a second stack,
+ * instead of each having a static or a stack frame of its own. These are the
+ * injected command being queued, and, with PARSED_COMMAND_QUEUE, the line
+ * read from the SD card and the host's line with RX_LINE_FRAMING. Each is
+ * only used within one call, and never at the same time as the others, so
+ * they share the bytes. With STACK_PAINTING, M284 also reports the most the
+ * arena has held.
+ */
+//#define SCRATCH_ARENA
+#if ENABLED(SCRATCH_ARENA)
+  #define SCRATCH_ARENA_SIZE MAX_CMD_SIZE
+#endif
+
 // @section serial
 
 // The ASCII buffer for serial input
 #define MAX_CMD_SIZE 64
 #define BUFSIZE 16
 
+/**
+ * Parsed Command Queue
+ *
+ * Parse each command once, as it's queued, and keep its code and values in a
+ * record of about 40 bytes instead of MAX_CMD_SIZE of text. The command isn't
+ * scanned again when it runs, and BUFSIZE can be raised for the same SRAM.
+ *
+ * Lines that need their text are kept in a ring of TEXT_BUFSIZE lines: string
+ * arguments (M23, M28, M30, M32, M117, M118, M928), anything the fast parser
+ * would take as a string, and everything from M28 to M29.
+ *
+ * Requires FASTER_GCODE_PARSER.
+ */
+//#define PARSED_COMMAND_QUEUE
+#if ENABLED(PARSED_COMMAND_QUEUE)
+  #define PARSED_COMMAND_VALUES 5 // Values per command. G1 X Y Z E F needs 5, more are kept as text
+  #define TEXT_BUFSIZE 4
+#endif
+
+/**
+ * Compiled Macros
+ *
+ * The firmware's own command sequences, such as the LCD's, are compiled into
+ * parsed records as it's built and kept in flash. They're copied straight into
+ * the command queue, as many each pass as it has room for, ahead of serial and
+ * SD commands, instead of being copied out as text one line a pass and parsed
+ * again. They take no TEXT_BUFSIZE slots. Requires PARSED_COMMAND_QUEUE.
+ */
+//#define COMPILED_MACROS
+
+/**
+ * Shared Queue Pool
+ *
+ * Give the command queue and the planner's blocks one pool of SRAM, the size of
+ * BUFSIZE commands and BLOCK_BUFFER_SIZE blocks, and choose the split without a
+ * rebuild. "M292 B<blocks>" sets the planner blocks, the rest of the pool going to
+ * commands; it's saved with M500 and applied at the next boot. More blocks give
+ * more lookahead for short segments, more commands ride out host or SD hiccups.
+ *
+ * The planner's ring is then sized at run time and wraps by a comparison rather
+ * than a mask.
+ */
+//#define SHARED_QUEUE_POOL
+#if ENABLED(SHARED_QUEUE_POOL)
+  #define MIN_PLANNER_BLOCKS 8
+  #define MIN_COMMAND_SLOTS 4
+#endif
+
+/**
+ * Fast Linear Moves
+ *
+ * Read plain G0/G1 lines, holding only X Y Z E F words with values, in one
+ * pass straight into the move, without the general parser. Other lines, and
+ * any G0/G1 with another word, go through the parser as usual. With
+ * PARSED_COMMAND_QUEUE this only applies to lines kept as text.
+ */
+//#define FAST_LINEAR_MOVES
+
+/**
+ * Prefetch Linear Moves
+ *
+ * While a move waits for a free planner block, scan the next queued line as
+ * FAST_LINEAR_MOVES would, so a G0/G1 is ready to plan as soon as the block
+ * frees up. Requires FAST_LINEAR_MOVES, and not PARSED_COMMAND_QUEUE, which
+ * already parses lines as they're queued.
+ */
+//#define PREFETCH_LINEAR_MOVES
+
+/**
+ * Binary Streaming
+ *
+ * M293 switches the host serial port from text lines to CRC-checked binary
+ * packets, each holding one command already parsed by the host. They go
+ * straight into the parsed command queue and are acknowledged by sequence
+ * number as they're queued, so there's no "ok" round trip per line.
+ * See get_binary_commands() in Marlin_main.cpp for the format, and
+ * buildroot/share/scripts/stream_binary.py for a host side.
+ *
+ * Requires PARSED_COMMAND_QUEUE.
+ */
+//#define BINARY_STREAMING
+#if ENABLED(BINARY_STREAMING)
+  #define BINARY_STREAMING_TIMEOUT 500 // (ms) A packet stalled this long is dropped and asked for again
+#endif
+
+/**
+ * Host-Planned Blocks
+ *
+ * Lets the host send whole moves already planned, as BINARY_STREAMING packets
+ * whose payload starts with 'B': the steps and directions, the trapezoid's
+ * step events and rates, and the acceleration. They go into the block buffer
+ * as they are, after the commands queued before them, and the planner never
+ * replans them, so a host with the whole print in view does the lookahead.
+ * The host is trusted with every limit. See binary_stream_block() in
+ * Marlin_main.cpp for the format.
+ *
+ * Requires BINARY_STREAMING.
+ */
+//#define HOST_PLANNED_BLOCKS
+
+/**
+ * Step Queues
+ *
+ * An experimental mode for motion computed entirely on the host, such as
+ * input shaping or kinematics beyond what the ATmega can plan. M278 S1 hands
+ * the motors to a queue of step runs per axis, each an interval, a count and
+ * an add to the interval after every step. They arrive as BINARY_STREAMING
+ * packets whose payload starts with 'S', and a stepper ISR of their own puts
+ * them out while the planner sits empty. Endstops still stop an axis running
+ * onto them, and the heaters and their safety checks run as always. M278 S0
+ * hands the motors back once the queues have run dry. See
+ * binary_stream_steps() in Marlin_main.cpp for the format.
+ *
+ * Requires BINARY_STREAMING.
+ */
+//#define STEP_QUEUE_MODE
+#if ENABLED(STEP_QUEUE_MODE)
+  #define STEP_QUEUE_MOVES 8 // Runs queued per axis, a power of 2 from 4 to 64
+#endif
+
+/**
+ * Binary SD Files
+ *
+ * Print files converted on the host into records of commands already parsed,
+ * in the BINARY_STREAMING payload format, with coordinates as fixed point.
+ * They're found by their header when opened, and each record goes straight
+ * into the parsed command queue with no text to scan. Comments are dropped,
+ * so files are also a third the size or less. Other files print as usual.
+ * buildroot/share/scripts/gcode_to_binary.py converts G-code to a .tgc file.
+ *
+ * Requires PARSED_COMMAND_QUEUE and SDSUPPORT.
+ */
+//#define SD_BINARY_FILES
+
 // Transfer Buffer Size
 // To save 386 bytes of __flashmem (and TX_BUFFER_SIZE+3 bytes of RAM) set to 0.
 // To buffer a simple "ok" you need 4 bytes.
@@ -696,11 +1637,59 @@
 // :[0, 2, 4, 8, 16, 32, 64, 128, 256]
 #define TX_BUFFER_SIZE 128
 
+/**
+ * Receive Line Framing
+ *
+ * Frame the host's lines in the serial receive interrupt: comments and blank
+ * lines never reach the buffer, '\r' ends a line like '\n', and complete
+ * lines are counted. The main loop then copies one whole line at a time
+ * instead of reading and testing each byte. Comments no longer take up room
+ * in the receive buffer either. Needs the Arduino serial driver.
+ */
+//#define RX_LINE_FRAMING
+
+/**
+ * Drop Echo Lines
+ *
+ * While moves are queued, drop an "echo:" line rather than wait for room in
+ * the transmit buffer, so verbose output can't starve the planner. A line is
+ * cut off from the first byte that doesn't fit, and always ends in its '\n'.
+ * "ok", errors, and replies without "echo:" (M105, M114) never drop. How
+ * many lines were dropped is reported once there's room.
+ */
+//#define TX_DROP_ECHO
+
+/**
+ * Packed Strings
+ *
+ * Store the messages of SERIAL_*PGM() and SERIAL_*PAIR() with their common
+ * words as one byte each, and each distinct message once, however many
+ * places print it. The words are in string_dictionary.h, picked by rbbuild
+ * from the messages by how much they save; a rebuild picks them again. The
+ * words go back in as the message is sent. Saves about a third of the
+ * flash the messages take, less the dictionary's 1.2 kB.
+ */
+//#define PACKED_STRINGS
+
+/**
+ * Baud Rate G-code
+ *
+ * "M575 B<baud>" switches the host port to another rate after its "ok".
+ * Unless a line with a good checksum, or of plain text, or a good binary
+ * packet, comes in at the new rate within BAUD_RATE_FALLBACK seconds, the
+ * port goes back to the old one. BAUDRATE is still the rate at boot.
+ */
+//#define BAUD_RATE_GCODE
+#if ENABLED(BAUD_RATE_GCODE)
+  #define BAUD_RATE_FALLBACK 5 // (seconds)
+#endif
+
 // Enable an emergency-command parser to intercept certain commands as they
 // enter the serial receive buffer, so they cannot be blocked.
 // Currently handles M108, M112, M410
+// Runs in the receive interrupt, so they act even while the queue is full.
 // Does not work on boards using AT90USB (USBCON) processors!
-//#define EMERGENCY_PARSER
+#define EMERGENCY_PARSER
 
 // Bad Serial-connections can miss a received command by sending an 'ok'
 // Therefore some clients abort after 30 seconds in a timeout.
@@ -711,6 +1700,28 @@
 // Some clients will have this feature soon. This could make the NO_TIMEOUTS unnecessary.
 #define ADVANCED_OK 1
 
+// Send the "ok" for a serial line as soon as it's queued instead of once it has run,
+// so a host that waits for each "ok" keeps the queue full. There is still one "ok" per line,
+// so the host can't overrun the queue. M105 sends its own "ok", and M400 keeps its "ok" for
+// when the moves are done, as hosts use it to wait for them.
+//#define EARLY_OK
+
+/**
+ * Resend Window
+ *
+ * When a numbered line is lost or garbled, ask the host for just that line
+ * and keep the receive buffer, instead of flushing it. Up to
+ * RESEND_WINDOW_LINES good lines after the missing one are kept and run once
+ * it comes back; lines the host sends again after that are answered "ok" and
+ * dropped. Another error before the missing line arrives, or a line past the
+ * window, falls back to the usual flush and resend. Each kept line takes
+ * MAX_CMD_SIZE bytes of SRAM.
+ */
+//#define RESEND_WINDOW
+#if ENABLED(RESEND_WINDOW)
+  #define RESEND_WINDOW_LINES 4 // 1 to 8
+#endif
+
 // @section fwretract
 
 // Firmware based and LCD controlled retract
@@ -731,6 +1742,14 @@
 # define RETRACT_RECOVER_LENGTH_SWAP 0   // Default additional swap recover length (mm, added to retract length when recovering from extruder change)
 # define RETRACT_RECOVER_FEEDRATE 200    // Default feedrate for recovering from retraction (mm/s)
 # define RETRACT_RECOVER_FEEDRATE_SWAP 8 // Default feedrate for recovering from swap retraction (mm/s)
+
+/**
+ * Plan G10/G11 after the moves already queued instead of waiting for them to finish. The
+ * retract and recover are E-only blocks with the retract acceleration, so the move before
+ * one only slows to the jerk limits. The Z-hop is made by the next move, usually the travel,
+ * rising on its way, and is undone by the recover if a move made it.
+ */
+# define FWRETRACT_LOOKAHEAD
 #endif
 
 /**
@@ -1166,6 +2185,28 @@
  */
 #define AUTO_REPORT_TEMPERATURES
 
+/**
+ * Binary Status Report
+ *
+ * M277 sends one binary frame of the printer's state: the temperatures and targets as temp_t
+ * raw values, the heater PWMs, the stepper positions, the SD position and size, how full the
+ * planner and the command queue are, and the error flags. M277 S<ms> sends one every <ms>
+ * milliseconds instead, so a host can watch a printer without polling M105, M114 and M27.
+ * The frame is a "status:<length>" line, then <length> bytes with a CRC-16 at their end.
+ * buildroot/share/scripts/read_status_report.py decodes them.
+ */
+//#define BINARY_STATUS_REPORT
+
+/**
+ * Realtime Position Report
+ *
+ * M114 R reports where the steppers are right now, in mm and in steps, instead
+ * of waiting for the queued moves to finish as M114 does. It's one reading of
+ * the stepper counts and a multiply per axis, so a host can poll it at any rate
+ * while printing. The position still has any leveling in it.
+ */
+//#define M114_REALTIME
+
 /**
  * Include capabilities in M115 output
  */
@@ -1180,6 +2221,20 @@
  */
 //#define VOLUMETRIC_DEFAULT_ON
 
+/**
+ * Volumetric Extruder Limit
+ *
+ * Cap the speed of a printing move so its extruder feeds no more than the
+ * hotend can melt, in mm³ of filament per second. Set per extruder with
+ * M200 L<mm³/s>, 0 for no limit, and save it with M500. Only the moves that
+ * would go over it are slowed, from their E speed and the filament diameter.
+ * Retracts and primes aren't limited.
+ */
+//#define VOLUMETRIC_EXTRUDER_LIMIT
+#if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+  #define DEFAULT_VOLUMETRIC_EXTRUDER_LIMIT 0.00  // (mm³/s) Default limit of each extruder. 0 for none.
+#endif
+
 /**
  * Enable this option for a leaner build of Marlin that removes all
  * workspace offsets, simplifying coordinate transformations, leveling, etc.
@@ -1203,6 +2258,17 @@
  */
 #define FASTER_GCODE_PARSER
 
+/**
+ * Keep the float values of a command's parameters as they're converted, so a
+ * handler that reads the same one again doesn't parse the text again. Up to
+ * GCODE_VALUE_CACHE_SIZE values per command, 5 bytes of SRAM each. Requires
+ * FASTER_GCODE_PARSER.
+ */
+//#define GCODE_VALUE_CACHE
+#if ENABLED(GCODE_VALUE_CACHE)
+  #define GCODE_VALUE_CACHE_SIZE 4
+#endif
+
 /**
  * User-defined menu items that execute custom GCode
  */
@@ -35,7 +35,7 @@
 
 #include "MarlinConfig.h"
 
-#ifdef DEBUG_GCODE_PARSER
+#if defined(DEBUG_GCODE_PARSER) || ENABLED(COMPILED_MACROS)
 #include "gcode.h"
 #endif
 
@@ -191,10 +191,15 @@ void enable_all_steppers();
 void disable_e_steppers();
 void disable_all_steppers();
 
-void FlushSerialRequestResend();
+// Error paths, kept out of line and with the cold code so they don't crowd the hot paths that test for them
+void __cold __no_inline FlushSerialRequestResend();
 void ok_to_send();
 
-void kill(const char*);
+void __cold __no_inline kill(const char*);
+
+#if ENABLED(PARALLEL_PRINT_START)
+  void begin_parallel_start(); // An SD print is starting from its first line
+#endif
 
 void quickstop_stepper();
 
@@ -206,11 +211,28 @@ constexpr const uint8_t marlin_debug_flags = 0;
 #define DEBUGGING(F) (marlin_debug_flags & (DEBUG_## F))
 
 extern bool Running;
+extern uint8_t commands_in_queue;
+
+#if ENABLED(SHARED_QUEUE_POOL)
+  extern uint8_t queue_pool_blocks; // Planner blocks in the queue pool from the next boot (M292)
+#endif
 inline bool __forceinline __flatten is_running() { return  Running; }
 
 bool enqueue_and_echo_command(const char* cmd, bool say_ok=false); // Add a single command to the end of the buffer. Return false on failure.
 void enqueue_and_echo_commands(const Tuna::flash_string & __restrict cmd);          // Set one or more commands to be prioritized over the next Serial/SD command.
+#if ENABLED(COMPILED_MACROS)
+  void enqueue_macro(const ParsedCommand *steps, const uint8_t count);              // As above, for 'count' records in flash
+  template <uint8_t N>
+  inline void enqueue_macro(const gcode_macro<N> &macro) { enqueue_macro(macro.steps, N); }
+  // Commands written as G-code, compiled into records in flash: ENQUEUE_COMMANDS("M502\nM500")
+  #define ENQUEUE_COMMANDS(TEXT) do { static constexpr const auto _macro __flashmem = GCODE_MACRO(TEXT); enqueue_macro(_macro); } while (0)
+#else
+  #define ENQUEUE_COMMANDS(TEXT) enqueue_and_echo_commands(TEXT ""_p)
+#endif
 void clear_command_queue();
+#if ENABLED(PREFETCH_LINEAR_MOVES)
+  void prefetch_linear_move();
+#endif
 
 extern millis_t previous_cmd_ms;
 inline void refresh_cmd_timeout() { previous_cmd_ms = millis(); }
@@ -223,6 +245,11 @@ inline void refresh_cmd_timeout() { previous_cmd_ms = millis(); }
  * Feedrate scaling and conversion
  */
 extern int16_t feedrate_percentage;
+void set_feedrate_percentage(const int16_t percentage);
+
+#if ENABLED(PRINT_TIME_ESTIMATE)
+  uint16_t print_remaining_minutes();
+#endif
 
 #define MMM_TO_MMS(MM_M) ((MM_M)/60.0)
 #define MMS_TO_MMM(MM_S) ((MM_S)*60.0)
@@ -244,6 +271,7 @@ extern void set_destination_to_current();
 extern float current_position[XYZE];
 extern float destination[XYZE];
 extern float feedrate_mm_s;
+extern float last_param_feedrate_mm_s; // The modal G-code feedrate
 
 #if HAS_RESUME_CONTINUE
   extern volatile bool wait_for_user;
@@ -351,6 +379,10 @@ extern float soft_endstop_min[XYZ], soft_endstop_max[XYZ];
   void reset_bed_level();
 #endif
 
+#if ENABLED(MESH_COMPENSATION)
+  void set_bed_leveling_enabled(const bool enable=true);
+#endif
+
 #if ENABLED(ENABLE_LEVELING_FADE_HEIGHT)
   void set_z_fade_height(const float zfh);
 #endif
@@ -402,6 +434,10 @@ extern float soft_endstop_min[XYZ], soft_endstop_max[XYZ];
   extern int lpq_len;
 #endif
 
+#if ENABLED(ARC_SUPPORT)
+  extern float arc_chord_tolerance, arc_segment_min_mm, arc_segment_max_mm; // M287
+#endif
+
 #if ENABLED(FWRETRACT)
   extern bool autoretract_enabled;
   extern bool retracted[EXTRUDERS]; // extruder[n].retracted
@@ -419,6 +455,12 @@ extern float soft_endstop_min[XYZ], soft_endstop_max[XYZ];
 // Handling multiple extruders pins
 extern uint8_t active_extruder;
 
+#if ENABLED(SCRATCH_ARENA)
+  extern Tuna::scratch_arena<SCRATCH_ARENA_SIZE> scratch_arena;
+  // N 'T's from the scratch arena, for the scope it's declared in
+  template <typename T, usize N> using scratch_buffer = Tuna::scratch<T, N, scratch_arena>;
+#endif
+
 #if HAS_TEMP_HOTEND || HAS_TEMP_BED
   void print_heaterstates();
 #endif
@@ -102,6 +102,7 @@
    * M42  - Change pin status via gcode: M42 P<pin> S<value>. LED pin assumed if P is omitted.
    * M43  - Display pin status, watch pins for changes, watch endstops & toggle LED, Z servo probe test, toggle pins
    * M48  - Measure Z Probe repeatability: M48 P<points> X<pos> Y<pos> V<level> E<engage> L<legs>. (Requires Z_MIN_PROBE_REPEATABILITY_TEST)
+   * M73  - Set the print progress from the slicer: "M73 P<percent> R<minutes>". (Requires PRINT_TIME_ESTIMATE)
    * M75  - Start the print job timer.
    * M76  - Pause the print job timer.
    * M77  - Stop the print job timer.
@@ -127,7 +128,7 @@
    * M111 - Set debug flags: "M111 S<flagbits>". See flag bits defined in enum.h.
    * M112 - Emergency stop.
    * M113 - Get or set the timeout interval for Host Keepalive "busy" messages. (Requires HOST_KEEPALIVE_FEATURE)
-   * M114 - Report current position.
+   * M114 - Report current position. "M114 R" for where the steppers are now. (R requires M114_REALTIME)
    * M115 - Report capabilities. (Extended capabilities requires EXTENDED_CAPABILITIES_REPORT)
    * M117 - Display a message on the controller screen. (Requires an LCD)
    * M118 - Display a message in the host console.
@@ -150,6 +151,7 @@
    * M190 - Sxxx Wait for bed current temp to reach target temp. ** Waits only when heating! **
    *        Rxxx Wait for bed current temp to reach target temp. ** Waits for heating or cooling. **
    * M200 - Set filament diameter, D<diameter>, setting E axis units to cubic. (Use S0 to revert to linear units.)
+   *        L<mm³/s> sets the most the hotend melts. (Requires VOLUMETRIC_EXTRUDER_LIMIT)
    * M201 - Set max acceleration in units/s^2 for print moves: "M201 X<accel> Y<accel> Z<accel> E<accel>"
    * M202 - Set max acceleration in units/s^2 for travel moves: "M202 X<accel> Y<accel> Z<accel> E<accel>" ** UNUSED IN MARLIN! **
    * M203 - Set maximum feedrate: "M203 X<fr> Y<fr> Z<fr> E<fr>" in units/sec.
@@ -191,13 +193,15 @@
    * M406 - Disable Filament Sensor flow control. (Requires FILAMENT_WIDTH_SENSOR)
    * M407 - Display measured filament diameter in millimeters. (Requires FILAMENT_WIDTH_SENSOR)
    * M410 - Quickstop. Abort all planned moves.
-   * M420 - Enable/Disable Leveling (with current values) S1=enable S0=disable (Requires MESH_BED_LEVELING or ABL)
-   * M421 - Set a single Z coordinate in the Mesh Leveling grid. X<units> Y<units> Z<units> (Requires MESH_BED_LEVELING or AUTO_BED_LEVELING_UBL)
+   * M420 - Enable/Disable Leveling (with current values) S1=enable S0=disable, V to print the mesh (Requires MESH_COMPENSATION)
+   * M421 - Set a single Z coordinate in the mesh. I<column> J<row> Z<units>, or Q<units> to add to it (Requires MESH_COMPENSATION)
    * M428 - Set the home_offset based on the current_position. Nearest edge applies. (Disabled by NO_WORKSPACE_OFFSETS or DELTA)
    * M500 - Store parameters in EEPROM. (Requires EEPROM_SETTINGS)
    * M501 - Restore parameters from EEPROM. (Requires EEPROM_SETTINGS)
    * M502 - Revert to the default "factory settings". ** Does not write them to EEPROM! **
    * M503 - Print the current settings (in memory): "M503 S<verbose>". S0 specifies compact output.
+   * M506 - Switch to settings profile P, or save the current settings to it with S: "M506 P<profile> [S]". (Requires SETTINGS_PROFILES)
+   * M575 - Change the host baud rate: "M575 B<baud>". Falls back if nothing arrives at the new rate. (Requires BAUD_RATE_GCODE)
    * M600 - Pause for filament change: "M600 X<pos> Y<pos> Z<raise> E<first_retract> L<later_retract>". (Requires ADVANCED_PAUSE_FEATURE)
    * M665 - Set delta configurations: "M665 L<diagonal rod> R<delta radius> S<segments/s> A<rod A trim mm> B<rod B trim mm> C<rod C trim mm> I<tower A trim angle> J<tower B trim angle> K<tower C trim angle>" (Requires DELTA)
    * M666 - Set delta endstop adjustment. (Requires DELTA)
@@ -231,8 +235,26 @@
    * M364 - SCARA calibration: Move to cal-position PSIC (90 deg to Theta calibration position)
    *
    * ************ Custom codes - This can change to suit future G-code regulations
+   * M276 - Run the prints listed in a job queue file: "M276 name.gq". End it with "M276 C", report it with "M276". (Requires JOB_QUEUE)
+   * M277 - Send a binary status frame, or one every N ms with "M277 S<N>". (Requires BINARY_STATUS_REPORT)
+   * M278 - Hand the motors to the host's step queues, "M278 S1", and back, "M278 S0". Report them with "M278". (Requires STEP_QUEUE_MODE)
+   * M279 - Report "marker:<id>" once the moves before it have run: "M279 P<id>". (Requires MOTION_SYNC_EVENTS)
+   * M283 - Report the loop() pass times as a histogram, or reset them with "M283 R". (Requires LOOP_LATENCY_HISTOGRAM)
+   * M284 - Report the deepest the stack has been, "M284", and paint it again, "M284 R". (Requires STACK_PAINTING)
+   * M285 - Time the square roots in CPU cycles: "M285 S<calls>". (Requires MATH_BENCHMARK)
+   * M286 - Set the jerk of moves that don't extrude: "M286 X<jerk> Y<jerk> Z<jerk> J<deviation>". (Requires TRAVEL_JERK)
+   * M287 - Set how finely arcs are segmented: "M287 S<chord tolerance> P<min length> Q<max length>". (Requires ARC_SUPPORT)
+   * M288 - Benchmark the SD card reads, "M288 S<blocks>", and a file selected with M23. (Requires SD_BENCHMARK)
+   * M291 - Report G-code pipeline timing, or reset it with "M291 R". (Requires PIPELINE_PROFILING)
+   * M292 - Report the queue pool split, or give it B<blocks> planner blocks from the next boot. (Requires SHARED_QUEUE_POOL)
+   * M294 - Send the thermal telemetry, or record it every N ms with "M294 S<N>". (Requires THERMAL_TELEMETRY)
+   * M295 - Print the step trace, or record every Nth stepper ISR with "M295 S<N>". (Requires STEP_TRACE)
+   * M296 - Report planner profiling, or reset it with "M296 R". (Requires PLANNER_PROFILING)
+   * M297 - Report interrupt handler timing, or reset it with "M297 R". (Requires ISR_PROFILING)
+   * M593 - Set the input shaping of X and Y: "M593 [X|Y] F<frequency> D<damping ratio> T<0: ZV, 1: MZV>". (Requires INPUT_SHAPING)
    * M928 - Start SD logging: "M928 filename.gco". Stop with M29. (Requires SDSUPPORT)
    * M999 - Restart after being stopped by error
+   * M1000 - Resume an SD print after a power loss, or forget it with "M1000 C". (Requires POWER_LOSS_RECOVERY)
    *
    * "T" Codes
    *
@@ -247,6 +269,7 @@
 #include "stepper.h"
 #include "endstops.h"
 #include "thermal/thermal.hpp"
+#include "thermal/managers/managers.hpp"
 #include "cardreader.h"
 #include "configuration_store.h"
 #include "language.h"
@@ -259,9 +282,16 @@
 
 #include "planner_bezier.h"
 #include "watchdog.h"
+#include "interrupts.hpp"
+#include "profiling.hpp"
+#include "mesh.hpp"
 
 #include "Tuna_VM.hpp"
 
+#if ENABLED(BINARY_STREAMING)
+#include <util/crc16.h>
+#endif
+
 CardReader card;
 
 bool Running = true;
@@ -317,7 +347,111 @@ static uint24 gcode_N, gcode_LastN, Stopped_gcode_LastN = 0;
 uint8_t commands_in_queue = 0; // Count of commands in the queue
 static uint8_t cmd_queue_index_r = 0, // Ring buffer read position
 cmd_queue_index_w = 0; // Ring buffer write position
-static char command_queue[BUFSIZE][MAX_CMD_SIZE];
+#if ENABLED(PARSED_COMMAND_QUEUE)
+/**
+ * Commands are parsed as they're queued. A line that must stay text has a record
+ * with no letter, and the line itself waits in text_queue, in the same order.
+ */
+typedef ParsedCommand command_slot_t;
+static char text_queue[TEXT_BUFSIZE][MAX_CMD_SIZE];
+static uint8_t text_in_queue = 0,
+text_queue_index_r = 0,
+text_queue_index_w = 0;
+static bool queue_as_text = false; // From M28 or M928 to M29, lines are written to a file as text
+#else
+typedef char command_slot_t[MAX_CMD_SIZE];
+#endif
+
+#if ENABLED(SHARED_QUEUE_POOL)
+/**
+ * The planner's blocks, the command queue and its send_ok flags are laid out in one
+ * pool at boot: queue_pool_blocks blocks, then as many commands as fit after them.
+ * The pool holds BLOCK_BUFFER_SIZE blocks and BUFSIZE commands. Set with M292.
+ */
+#if ENABLED(POWER_LOSS_RECOVERY)
+#define COMMAND_SLOT_BYTES (sizeof(command_slot_t) + sizeof(uint32) + sizeof(bool))
+#else
+#define COMMAND_SLOT_BYTES (sizeof(command_slot_t) + sizeof(bool))
+#endif
+#define QUEUE_POOL_BYTES (BLOCK_BUFFER_SIZE * sizeof(block_t) + BUFSIZE * COMMAND_SLOT_BYTES)
+alignas(block_t) static uint8_t queue_pool[QUEUE_POOL_BYTES];
+static command_slot_t *command_queue;
+static bool *send_ok;
+#if ENABLED(POWER_LOSS_RECOVERY)
+static uint32 *command_sdpos;
+#endif
+static uint8_t command_queue_size;
+uint8_t queue_pool_blocks = BLOCK_BUFFER_SIZE; // From the EEPROM, applied at boot
+#define COMMAND_QUEUE_SIZE command_queue_size
+
+static constexpr const uint16_t queue_pool_block_limit = (QUEUE_POOL_BYTES - MIN_COMMAND_SLOTS * COMMAND_SLOT_BYTES) / sizeof(block_t);
+static constexpr const uint8_t queue_pool_max_blocks = (queue_pool_block_limit > 255) ? 255 : queue_pool_block_limit;
+
+/**
+ * Commands that fit in the pool next to 'blocks' planner blocks
+ */
+static uint8_t queue_pool_commands(const uint8_t blocks) {
+	const uint16_t commands = (QUEUE_POOL_BYTES - blocks * sizeof(block_t)) / COMMAND_SLOT_BYTES;
+	return (commands > 255) ? 255 : uint8_t(commands);
+}
+
+/**
+ * Split the pool as queue_pool_blocks asks, or as the defaults if that doesn't fit
+ */
+static void allocate_queue_pool() {
+	if (!WITHIN(queue_pool_blocks, MIN_PLANNER_BLOCKS, queue_pool_max_blocks)) queue_pool_blocks = BLOCK_BUFFER_SIZE;
+	const uint16_t block_bytes = queue_pool_blocks * sizeof(block_t);
+	command_queue_size = queue_pool_commands(queue_pool_blocks);
+	Planner::set_block_buffer(reinterpret_cast<block_t*>(queue_pool), queue_pool_blocks);
+	command_queue = reinterpret_cast<command_slot_t*>(queue_pool + block_bytes);
+	send_ok = reinterpret_cast<bool*>(queue_pool + block_bytes + command_queue_size * sizeof(command_slot_t));
+#if ENABLED(POWER_LOSS_RECOVERY)
+	command_sdpos = reinterpret_cast<uint32*>(send_ok + command_queue_size);
+#endif
+}
+#else
+static command_slot_t command_queue[BUFSIZE];
+static bool send_ok[BUFSIZE];
+#if ENABLED(POWER_LOSS_RECOVERY)
+static uint32 command_sdpos[BUFSIZE];
+#endif
+#define COMMAND_QUEUE_SIZE BUFSIZE
+#endif
+
+#if ENABLED(POWER_LOSS_RECOVERY)
+/**
+ * The SD file position of each queued command, for a checkpoint taken as it runs.
+ * The SD reader sets next_command_sdpos for the command it's about to queue.
+ */
+#define NO_SDPOS 0xFFFFFFFF
+static uint32 next_command_sdpos = NO_SDPOS;
+#endif
+
+#if ENABLED(PREFETCH_LINEAR_MOVES)
+static const char *prefetched_line = nullptr; // The queued line prefetch_linear_move() scanned, if any
+#endif
+
+/**
+ * True if a command of any kind can be queued
+ */
+inline bool __forceinline __flatten command_queue_has_room() {
+	return commands_in_queue < COMMAND_QUEUE_SIZE
+#if ENABLED(PARSED_COMMAND_QUEUE)
+		&& text_in_queue < TEXT_BUFSIZE
+#endif
+		;
+}
+
+/**
+ * The text of the command at the read position, or nullptr if it was queued parsed
+ */
+inline char * __forceinline __flatten queued_command_text() {
+#if ENABLED(PARSED_COMMAND_QUEUE)
+	return command_queue[cmd_queue_index_r].letter ? nullptr : text_queue[text_queue_index_r];
+#else
+	return command_queue[cmd_queue_index_r];
+#endif
+}
 
 /**
  * Next Injected Command pointer. nullptr if no commands are being injected.
@@ -326,12 +460,20 @@ static char command_queue[BUFSIZE][MAX_CMD_SIZE];
  */
 static Tuna::flash_string injected_commands_P = nullptr;
 
+#if ENABLED(COMPILED_MACROS)
+/**
+ * The next record of the injected macro, in flash, and how many are left
+ */
+static const ParsedCommand *injected_macro_P = nullptr;
+static uint8_t injected_macro_steps = 0;
+#endif
+
 /**
  * Feed rates are often configured with mm/m
  * but the planner and stepper like mm/s units.
  */
-static const float homing_feedrate_mm_s[] __flashmem = { HOMING_FEEDRATE_X, HOMING_FEEDRATE_Y, HOMING_FEEDRATE_Z, 0 };
-float __forceinline homing_feedrate(const AxisEnum a) { return pgm_read_float(&homing_feedrate_mm_s[a]); }
+static const flash_array<float, XYZE> homing_feedrate_mm_s __flashmem = { HOMING_FEEDRATE_X, HOMING_FEEDRATE_Y, HOMING_FEEDRATE_Z, 0 };
+float __forceinline homing_feedrate(const AxisEnum a) { return homing_feedrate_mm_s[a]; }
 
 float feedrate_mm_s = MMM_TO_MMS(1500.0);
 float last_param_feedrate_mm_s = MMM_TO_MMS(1500.0);
@@ -385,6 +527,43 @@ void retract(const bool retracting
 // Number of characters read in the current line of serial input
 static int serial_count = 0;
 
+#if DISABLED(RX_LINE_FRAMING)
+// XOR of the line's characters before its '*', and the index of the '*', kept as they're read
+static uint8_t serial_checksum = 0, serial_star = 0xFF;
+#endif
+
+#if ENABLED(BAUD_RATE_GCODE)
+/**
+ * The host port's baud rate, and the one M575 left, to go back to if nothing
+ * good arrives at the new one by baud_fallback_ms
+ */
+static uint32_t host_baud = BAUDRATE, fallback_baud = 0;
+static millis_t baud_fallback_ms;
+
+static void set_host_baud(const uint32_t baud) {
+	MYSERIAL.end(); // Sends what's left, and drops what came in, at the old rate
+	MYSERIAL.begin(baud);
+	serial_count = 0;
+	host_baud = baud;
+}
+
+/**
+ * A line or packet came in intact, so the host is at the new rate
+ */
+inline void __forceinline __flatten host_baud_confirmed() {
+	fallback_baud = 0;
+}
+
+/**
+ * Noise read at the wrong rate rarely comes out as only printable characters
+ */
+static bool is_printable(const char *text) {
+	for (; *text; ++text)
+		if (uint8_t(*text - ' ') > uint8_t('~' - ' ')) return false;
+	return true;
+}
+#endif
+
 // Inactivity shutdown
 millis_t previous_cmd_ms = 0;
 static millis_t max_inactive_time = 0;
@@ -393,6 +572,12 @@ static millis_t stepper_inactive_time = (DEFAULT_STEPPER_DEACTIVE_TIME) * 1000UL
 // Print Job Timer
 PrintCounter print_job_timer = PrintCounter();
 
+#if ENABLED(ARC_SUPPORT)                    // Initialized by settings.load()...
+float arc_chord_tolerance,                // M287 S - Most a segment cuts inside its arc, 0 for MM_PER_ARC_SEGMENT
+arc_segment_min_mm,                 // M287 P - Shortest segment
+arc_segment_max_mm;                 // M287 Q - Longest segment
+#endif
+
 #if ENABLED(FWRETRACT)                      // Initialized by settings.load()...
 bool autoretract_enabled,                 // M209 S - Autoretract switch
 retracted[EXTRUDERS] = { false };    // Which extruders are currently retracted
@@ -420,18 +605,34 @@ static uint8_t target_extruder;
 
 float cartes[XYZ] = { 0 };
 
-static bool send_ok[BUFSIZE];
-
 MarlinBusyState busy_state = NOT_BUSY;
-static millis_t next_busy_signal_ms = 0;
 uint8_t host_keepalive_interval = DEFAULT_KEEPALIVE_INTERVAL;
 
-float __forceinline __flatten pgm_read_any(const float *p) { return pgm_read_float_near(p); }
-signed char __forceinline __flatten pgm_read_any(const signed char *p) { return pgm_read_byte_near(p); }
+// Everything idle() only needs to do now and then, most urgent first. A watchdog stall report
+// gives the task by its number here, from 0.
+enum class periodic_task : uint8 {
+	heater_checks,
+	print_timer,
+	lcd_update,
+	host_keepalive,
+	auto_report,
+#if ENABLED(BINARY_STATUS_REPORT)
+	status_report,
+#endif
+	count
+};
+static scheduler<periodic_task> periodic;
+
+#if ENABLED(WATCHDOG_STALL_REPORT)
+uint8_t watchdog_task() {
+	const uint8_t task = periodic.running();
+	return (task == periodic.size) ? 0xFF : task;
+}
+#endif
 
 #define XYZ_CONSTS_FROM_CONFIG(type, array, CONFIG) \
-  static const __flashmem type array##_P[XYZ] = { X_##CONFIG, Y_##CONFIG, Z_##CONFIG }; \
-  static inline type array(AxisEnum axis) { return pgm_read_any(&array##_P[axis]); } \
+  static const flash_array<type, XYZ> array##_P __flashmem = { X_##CONFIG, Y_##CONFIG, Z_##CONFIG }; \
+  static inline type array(AxisEnum axis) { return array##_P[axis]; } \
   typedef void __void_##CONFIG##__
 
 XYZ_CONSTS_FROM_CONFIG(float, base_min_pos, MIN_POS);
@@ -453,11 +654,17 @@ void __forceinline __flatten get_available_commands();
 void __forceinline __flatten process_next_command();
 void __forceinline __flatten prepare_move_to_destination();
 
+#if ENABLED(MOVE_COALESCING)
+void flush_coalesced_move();
+#endif
+
 void __forceinline __flatten get_cartesian_from_steppers();
 void __forceinline __flatten set_current_from_steppers_for_axis(const AxisEnum axis);
 void __forceinline __flatten set_current_from_steppers();
 
-//void plan_arc(float target[XYZE], float* offset, uint8_t clockwise);
+#if ENABLED(ARC_SUPPORT)
+void plan_arc(const float (&target)[XYZE], float* offset, uint8_t clockwise);
+#endif
 
 void __forceinline __flatten plan_cubic_move(const float offset[4]);
 
@@ -471,15 +678,100 @@ void __forceinline __flatten report_current_position();
  * no kinematic translation. Used for homing axes and cartesian/core syncing.
  */
 void __forceinline __flatten sync_plan_position() {
+#if ENABLED(MOVE_COALESCING)
+	flush_coalesced_move();
+#endif
 	planner.set_position_mm(current_position[X_AXIS], current_position[Y_AXIS], current_position[Z_AXIS], current_position[E_AXIS]);
 }
-inline void __forceinline __flatten sync_plan_position_e() { planner.set_e_position_mm(current_position[E_AXIS]); }
+inline void __forceinline __flatten sync_plan_position_e() {
+#if ENABLED(MOVE_COALESCING)
+	flush_coalesced_move();
+#endif
+	planner.set_e_position_mm(current_position[E_AXIS]);
+}
 
 #define SYNC_PLAN_POSITION_KINEMATIC() sync_plan_position()
 
 #include "SdFatUtil.h"
 int __forceinline __flatten freeMemory() { return SdFatUtil::FreeRam(); }
 
+#if ENABLED(SCRATCH_ARENA)
+Tuna::scratch_arena<SCRATCH_ARENA_SIZE> scratch_arena;
+
+// The arena is sized for the buffers that can be taken at once, so one that doesn't fit is a bug
+void Tuna::scratch_full() {
+	kill(PSTR("Scratch arena full"));
+}
+#endif
+
+#if ENABLED(SRAM_BUDGET)
+/**
+ * The largest static buffers. The smaller statics and the stack have to make do with
+ * what they leave, so the build stops unless that's at least SRAM_STACK_RESERVE.
+ */
+constexpr const sram::region sram_regions[] __flashmem = {
+#if ENABLED(SHARED_QUEUE_POOL)
+	{ "Pool", sizeof(queue_pool) },
+#else
+	{ "Planner", sizeof(Planner::block_buffer) },
+	{ "Commands", sizeof(command_queue) + sizeof(send_ok)
+#if ENABLED(POWER_LOSS_RECOVERY)
+		+ sizeof(command_sdpos)
+#endif
+	},
+#endif
+#if ENABLED(PARSED_COMMAND_QUEUE)
+	{ "Text", sizeof(text_queue) },
+#endif
+	{ "Serial", 0
+#ifdef HAVE_HWSERIAL0
+		+ sizeof(HardwareSerial0)
+#endif
+#ifdef HAVE_HWSERIAL1
+		+ sizeof(HardwareSerial1)
+#endif
+#ifdef HAVE_HWSERIAL2
+		+ sizeof(HardwareSerial2)
+#endif
+#ifdef HAVE_HWSERIAL3
+		+ sizeof(HardwareSerial3)
+#endif
+	},
+	// The card's names and sort lists are members; the block cache is SdVolume's
+	{ "SD", sizeof(CardReader) + sizeof(cache_t)
+#if ENABLED(SD_READ_AHEAD)
+		+ sizeof(cache_t)
+#endif
+	},
+	{ "Stepper", Stepper::buffer_bytes() },
+#if ENABLED(THERMAL_TELEMETRY)
+	{ "Telemetry", sizeof(Temperature::telemetry) + sizeof(Temperature::telemetry_queue) },
+#endif
+#if ENABLED(SCRATCH_ARENA)
+	{ "Scratch", sizeof(scratch_arena) },
+#endif
+};
+static_assert(sram::fits(sram_regions, SRAM_STACK_RESERVE), "The static buffers leave less than SRAM_STACK_RESERVE of SRAM. Shrink them, or the reserve.");
+
+/**
+ * Print the budget: each buffer, their total, all the statics as linked, and the reserve
+ */
+static void report_sram_budget() {
+	constexpr const usize total = sram::total(sram_regions); // At compile time, as the regions are in flash
+	SERIAL_ECHO_START();
+	SERIAL_ECHOPGM("SRAM");
+	for (uint8_t i = 0; i < COUNT(sram_regions); i++) {
+		SERIAL_CHAR(' ');
+		serialprintPGM(sram_regions[i].name);
+		SERIAL_ECHOPAIR(":", sram::bytes(sram_regions, i));
+	}
+	SERIAL_ECHOPAIR(" total:", total);
+	SERIAL_ECHOPAIR(" static:", sram::static_bytes());
+	SERIAL_ECHOPAIR(" reserve:", SRAM_STACK_RESERVE);
+	SERIAL_ECHOLNPAIR(" of:", sram::size);
+}
+#endif
+
 /**
  * Inject the next "immediate" command, when possible, onto the front of the queue.
  * Return true if any immediate commands remain to inject.
@@ -487,9 +779,15 @@ int __forceinline __flatten freeMemory() { return SdFatUtil::FreeRam(); }
 static __forceinline __flatten bool drain_injected_commands_P() {
 	if (injected_commands_P) {
 		size_t i = 0;
-		char c, cmd[30];
-		strncpy_P(cmd, injected_commands_P.c_str(), sizeof(cmd) - 1);
-		cmd[sizeof(cmd) - 1] = '\0';
+		char c;
+		constexpr const size_t cmd_size = 30;
+#if ENABLED(SCRATCH_ARENA)
+		const scratch_buffer<char, cmd_size> cmd;
+#else
+		char cmd[cmd_size];
+#endif
+		strncpy_P(cmd, injected_commands_P.c_str(), cmd_size - 1);
+		cmd[cmd_size - 1] = '\0';
 		while ((c = cmd[i]) && c != '\n') i++; // find the end of this gcode command
 		cmd[i] = '\0';
 		if (__likely(enqueue_and_echo_command(cmd)))     // success?
@@ -514,32 +812,145 @@ void enqueue_and_echo_commands(const Tuna::flash_string & __restrict pgcode) {
 void __forceinline __flatten clear_command_queue() {
 	cmd_queue_index_r = cmd_queue_index_w;
 	commands_in_queue = 0;
+#if ENABLED(PREFETCH_LINEAR_MOVES)
+	prefetched_line = nullptr;
+#endif
+#if ENABLED(PARSED_COMMAND_QUEUE)
+	text_queue_index_r = text_queue_index_w;
+	text_in_queue = 0;
+#endif
+}
+
+/**
+ * Print an "ok"
+ *
+ * If ADVANCED_OK is enabled also include:
+ *   N<int>  Line number of the command, if any: from its text, or 'line' if there's none
+ *   P<int>  Planner space remaining
+ *   B<int>  Block queue space remaining
+ */
+static void print_ok(const char *text, const int32 line = -1) {
+	SERIAL_PROTOCOLPGM(MSG_OK);
+#if ENABLED(ADVANCED_OK)
+	if (text) {
+		if (__unlikely(*text == 'N')) {
+			SERIAL_PROTOCOL(' ');
+			SERIAL_ECHO(*text++);
+			while (NUMERIC_SIGNED(*text))
+				SERIAL_ECHO(*text++);
+		}
+	}
+	else if (__unlikely(line >= 0)) {
+		SERIAL_PROTOCOLPGM(" N");
+		SERIAL_PROTOCOL(line);
+	}
+	SERIAL_PROTOCOLPGM(" P"); SERIAL_PROTOCOL(int(planner.block_buffer_size() - planner.movesplanned() - 1));
+	SERIAL_PROTOCOLPGM(" B"); SERIAL_PROTOCOL(int(COMMAND_QUEUE_SIZE - commands_in_queue));
+#ifdef SLOWDOWN_BUFFER_MS
+	SERIAL_PROTOCOLPGM(" Q"); SERIAL_PROTOCOL(planner.queued_move_ms());
+#endif
+#else
+	UNUSED(text);
+	UNUSED(line);
+#endif
+	SERIAL_EOL();
 }
 
+#if ENABLED(EARLY_OK)
+/**
+ * Whether a line may be acknowledged when it's queued: not M105 or M400
+ */
+static bool ok_when_queued(const char *cmd) {
+	while (*cmd == ' ') ++cmd;
+	if (*cmd == 'N') {
+		++cmd;
+		while (NUMERIC_SIGNED(*cmd)) ++cmd;
+		while (*cmd == ' ') ++cmd;
+	}
+	if (*cmd != 'M') return true;
+	switch (parse::integer(cmd + 1)) {
+	case 105: case 400: return false;
+	default: return true;
+	}
+}
+#endif
+
 /**
  * Once a new command is in the ring buffer, call this to commit it
  */
 inline void __forceinline __flatten _commit_command(bool say_ok) {
 	send_ok[cmd_queue_index_w] = say_ok;
-  if (__unlikely(++cmd_queue_index_w >= BUFSIZE))
+#if ENABLED(POWER_LOSS_RECOVERY)
+	command_sdpos[cmd_queue_index_w] = next_command_sdpos;
+	next_command_sdpos = NO_SDPOS;
+#endif
+  if (__unlikely(++cmd_queue_index_w >= COMMAND_QUEUE_SIZE))
   {
     cmd_queue_index_w = 0;
   }
 	commands_in_queue++;
 }
 
+/**
+ * Commit a line and, with EARLY_OK, acknowledge it now if it asks for an "ok"
+ */
+inline void __forceinline __flatten _commit_line(const char* cmd, bool say_ok) {
+#if ENABLED(EARLY_OK)
+	if (say_ok && ok_when_queued(cmd)) {
+		_commit_command(false);
+		print_ok(cmd);
+		return;
+	}
+#else
+	UNUSED(cmd);
+#endif
+	_commit_command(say_ok);
+}
+
+#if DISABLED(PARSED_COMMAND_QUEUE)
+/**
+ * Serial input is read in place, into the queue slot at the write position.
+ * Before another line takes that slot, move a part-read line on to the next.
+ * Return false if there's no free slot after this one.
+ */
+static bool move_serial_line() {
+	if (__likely(!serial_count)) return true;
+	if (commands_in_queue >= COMMAND_QUEUE_SIZE - 1) return false;
+	const uint8_t next = (cmd_queue_index_w + 1 >= COMMAND_QUEUE_SIZE) ? 0 : cmd_queue_index_w + 1;
+	memcpy(command_queue[next], command_queue[cmd_queue_index_w], serial_count);
+	return true;
+}
+#endif
+
 /**
  * Copy a command from RAM into the main command buffer.
  * Return true if the command was successfully added.
  * Return false for a full buffer, or if the 'command' is a comment.
  */
 inline bool __forceinline __flatten _enqueuecommand(const char* cmd, bool say_ok = false) {
-  if (__unlikely(*cmd == ';') || __unlikely(commands_in_queue >= BUFSIZE))
+  if (__unlikely(*cmd == ';') || __unlikely(!command_queue_has_room()))
   {
     return false;
   }
+#if ENABLED(PARSED_COMMAND_QUEUE)
+	ParsedCommand &command = command_queue[cmd_queue_index_w];
+	const bool as_text = !parser.compile(cmd, command) || queue_as_text || card.saving;
+	if (__unlikely(command.letter == 'M')) switch (command.codenum) {
+		case 28: case 928: queue_as_text = true; break;
+		case 29: queue_as_text = false; break;
+		default: break;
+	}
+	if (__unlikely(as_text)) {
+		command.letter = '\0';
+		strcpy(text_queue[text_queue_index_w], cmd);
+		if (++text_queue_index_w >= TEXT_BUFSIZE) text_queue_index_w = 0;
+		text_in_queue++;
+	}
+#else
+	if (__unlikely(!move_serial_line())) return false;
 	strcpy(command_queue[cmd_queue_index_w], cmd);
-	_commit_command(say_ok);
+#endif
+	_commit_line(cmd, say_ok);
 	return true;
 }
 
@@ -557,6 +968,30 @@ bool enqueue_and_echo_command(const char* cmd, bool say_ok/*=false*/) {
 	return false;
 }
 
+#if ENABLED(COMPILED_MACROS)
+/**
+ * Copy the injected macro's records into the queue, as many as it has room for.
+ * They were parsed as the firmware was built, so they go in as they are.
+ * Return true if any remain.
+ */
+static bool drain_injected_macro() {
+	for (; injected_macro_steps && command_queue_has_room(); --injected_macro_steps) {
+		memcpy_P(&command_queue[cmd_queue_index_w], injected_macro_P++, sizeof(ParsedCommand));
+		_commit_command(false);
+	}
+	return injected_macro_steps;
+}
+
+/**
+ * Record a macro to run, made by GCODE_MACRO. Replaces the current one, if any.
+ */
+void enqueue_macro(const ParsedCommand *steps, const uint8_t count) {
+	injected_macro_P = steps;
+	injected_macro_steps = count;
+	drain_injected_macro();
+}
+#endif
+
 void __forceinline __flatten setup_killpin() {
 }
 
@@ -569,123 +1004,649 @@ void __forceinline __flatten suicide() {
 void __forceinline __flatten servo_init() {
 }
 
-void gcode_line_error(const char* err, bool doFlush = true) {
+#if ENABLED(SERIAL_BENCHMARK)
+/**
+ * A M289 S1 dry run: lines taken and rejected since it started
+ */
+static struct {
+	bool active;
+	uint32_t lines, errors;
+	millis_t start_ms;
+} benchmark;
+#endif
+
+#if ENABLED(RESEND_WINDOW)
+/**
+ * Good lines that came in after a missing one, kept until it's resent.
+ * Each is kept whole, as it was read, to be taken again in its turn.
+ */
+static struct {
+	uint8_t held;       // A bit for each slot in use
+	bool recovering;    // A resend was asked for, and the lines it repeats may come in again
+	uint24 line[RESEND_WINDOW_LINES];
+	uint8_t checksum[RESEND_WINDOW_LINES], star[RESEND_WINDOW_LINES];
+	char text[RESEND_WINDOW_LINES][MAX_CMD_SIZE];
+} resend_window;
+
+/**
+ * Give up on the kept lines. Each gets the "ok" its own resend
+ * request would have had, so a host counting them stays in step.
+ */
+static void drop_held_lines() {
+	for (uint8_t slot = 0; slot < RESEND_WINDOW_LINES; ++slot)
+		if (TEST(resend_window.held, slot)) print_ok(nullptr, int32(uint32(resend_window.line[slot])));
+	resend_window.held = 0;
+	resend_window.recovering = false;
+}
+#endif
+
+/**
+ * Ask the host for the line after the last one taken
+ */
+static void request_resend() {
+	SERIAL_PROTOCOLPGM(MSG_RESEND);
+	SERIAL_PROTOCOLLN(uint32(gcode_LastN + 1));
+	ok_to_send();
+}
+
+void __cold __no_inline gcode_line_error(const char* err, bool doFlush = true) {
+#if ENABLED(SERIAL_BENCHMARK)
+	if (benchmark.active) ++benchmark.errors;
+#endif
 	SERIAL_ERROR_START();
 	serialprintPGM(err);
 	SERIAL_ERRORLN(uint32(gcode_LastN));
 	//Serial.println(gcode_N);
+#if ENABLED(RESEND_WINDOW)
+	// The first error asks for just the one line, and the lines behind it stay to be kept.
+	// Another before it comes back falls back to a full resend.
+	if (doFlush) {
+		if (!resend_window.recovering) {
+			resend_window.recovering = true;
+			request_resend();
+		}
+		else {
+			drop_held_lines();
+			FlushSerialRequestResend();
+		}
+	}
+#else
 	if (doFlush) FlushSerialRequestResend();
+#endif
 	serial_count = 0;
 }
 
+#if ENABLED(RESEND_WINDOW)
 /**
- * Get all commands waiting on the serial port and queue them.
- * Exit when the buffer is full or when no more characters are
- * left on the serial port.
+ * Take a line with a good checksum that isn't the next one.
+ * Keep it if it's at most RESEND_WINDOW_LINES past the missing line, and
+ * answer it if it repeats one already taken while a resend is under way.
+ * Return false if it's an error after all.
  */
-inline void get_serial_commands() {
-	static char serial_line_buffer[MAX_CMD_SIZE];
-	static bool serial_comment_mode = false;
+static bool window_line(const char *serial_line, const uint8_t checksum, const uint8_t star) {
+	const int32 ahead = int32(uint32(gcode_N)) - int32(uint32(gcode_LastN)) - 1; // Lines past the missing one
 
-	/**
-	 * Loop while serial characters are incoming and the queue is not full
-	 */
-	while (commands_in_queue < BUFSIZE && MYSERIAL.available() > 0) {
+	if (ahead < 0) {
+		// A host resending from the missing line sends the kept ones again
+		if (!resend_window.recovering || ahead < -(RESEND_WINDOW_LINES + 1)) return false;
+		print_ok(nullptr, int32(uint32(gcode_N)));
+		return true;
+	}
+	if (ahead > RESEND_WINDOW_LINES) return false;
 
-		char serial_char = MYSERIAL.read();
+	uint8_t slot = RESEND_WINDOW_LINES;
+	for (uint8_t i = 0; i < RESEND_WINDOW_LINES; ++i) {
+		if (!TEST(resend_window.held, i)) {
+			if (slot == RESEND_WINDOW_LINES) slot = i;
+		}
+		else if (resend_window.line[i] == gcode_N) {
+			// Already kept, so this copy is only answered
+			print_ok(nullptr, int32(uint32(gcode_N)));
+			return true;
+		}
+	}
+	if (slot == RESEND_WINDOW_LINES) return false;
 
-		/**
-		 * If the character ends the line
-		 */
-		if (__unlikely(serial_char == '\n' || serial_char == '\r')) {
+	strcpy(resend_window.text[slot], serial_line);
+	resend_window.line[slot] = gcode_N;
+	resend_window.checksum[slot] = checksum;
+	resend_window.star[slot] = star;
+	SBI(resend_window.held, slot);
 
-			serial_comment_mode = false; // end of line == end of comment
+	if (!resend_window.recovering) gcode_line_error(PSTR(MSG_ERR_LINE_NO));
+	return true;
+}
+#endif
 
-			if (__unlikely(!serial_count)) continue; // skip empty lines
+#if ENABLED(BINARY_STREAMING)
 
-			serial_line_buffer[serial_count] = 0; // terminate string
-			serial_count = 0; //reset buffer
+/**
+ * Binary streaming, started by M293
+ *
+ * The host sends packets of one pre-parsed command each instead of text lines:
+ *
+ *   0xA5, seq, length, payload[length], CRC-16/XMODEM of seq, length and payload, low byte first
+ *
+ * The payload is the letter (G, M, or T) and the code as a little-endian uint16, then the
+ * parameters. 'A'-'Z' is followed by a little-endian int32, 'A'-'Z' | 0x80 by a float,
+ * 'a'-'z' | 0x80 by a little-endian int24 of thousandths, taken as a float, and 'a'-'z' is a
+ * parameter without a value. An empty payload goes back to text lines.
+ *
+ * Each packet is answered with "ack:<seq> B<free slots>" once it's queued, which may wait for
+ * the queue to drain, so the packets in flight must fit the serial receive buffer. A bad CRC,
+ * a gap in the sequence, or a payload that isn't a command gets "nak:<expected seq>" once, and
+ * the host sends again from there. Commands with a string argument need text lines.
+ *
+ * With HOST_PLANNED_BLOCKS a payload of 'B' and a host_block_t, little-endian as the AVR, is a
+ * move the host planned itself. See binary_stream_block(). With STEP_QUEUE_MODE a payload of
+ * 'S' holds runs of steps. See binary_stream_steps().
+ */
+static struct {
+	bool active;
+	bool resync;            // A nak was sent; stay quiet until the packet it asked for
+#if ENABLED(HOST_PLANNED_BLOCKS)
+	bool block_pending;     // The payload is a block, waiting for the commands ahead of it
+#endif
+#if ENABLED(STEP_QUEUE_MODE)
+	uint8_t steps_pending;  // The offset of the payload's next run to queue, 0 once they all are
+#endif
+	uint8_t state;
+	uint8_t seq;            // Expected next
+	uint8_t packet_seq;
+	uint8_t length, received;
+	uint16_t crc;
+	millis_t last_byte_ms;
+	uint8_t payload[PARSED_PAYLOAD_SIZE];
+} binary_stream;
+
+#if ENABLED(HOST_PLANNED_BLOCKS)
+	c_static_assert(1 + sizeof(host_block_t) <= PARSED_PAYLOAD_SIZE, "A host block frame must fit the binary streaming payload.");
+#endif
 
-			char* command = serial_line_buffer;
+enum BinaryStreamState : uint8_t { BINARY_SYNC, BINARY_SEQ, BINARY_LENGTH, BINARY_PAYLOAD, BINARY_CRC_LOW, BINARY_CRC_HIGH };
 
-			while (*command == ' ') command++; // skip any leading spaces
-			char *npos = __unlikely(*command == 'N') ? command : nullptr, // Require the N parameter to start the line
-				*apos = strchr(command, '*');
+static void binary_stream_nak() {
+	binary_stream.state = BINARY_SYNC;
+	if (binary_stream.resync) return;
+	binary_stream.resync = true;
+	SERIAL_PROTOCOLPGM("nak:");
+	SERIAL_PROTOCOLLN(int(binary_stream.seq));
+}
 
-			if (__unlikely(npos != nullptr)) {
+static void binary_stream_ack() {
+	binary_stream.resync = false;
+	SERIAL_PROTOCOLPGM("ack:");
+	SERIAL_PROTOCOL(int(binary_stream.seq++));
+	SERIAL_PROTOCOLPGM(" B");
+	SERIAL_PROTOCOLLN(int(COMMAND_QUEUE_SIZE - commands_in_queue));
+}
 
-				bool M110 = strstr_P(command, PSTR("M110")) != nullptr;
+#if ENABLED(HOST_PLANNED_BLOCKS)
 
-				if (M110) {
-					char* n2pos = strchr(command + 4, 'N');
-					if (n2pos) npos = n2pos;
-				}
+/**
+ * Queue a host-planned block once the commands ahead of it have run, so it moves in order with
+ * them, and there's room in the planner. Nothing more is read until then.
+ *
+ *   'B', direction bits, steps[XYZE] as uint24, then as uint24: the step event acceleration ends
+ *   on, the one deceleration starts after, the initial, nominal and final rates (step events/s),
+ *   the acceleration (step events/s²), and the LIN_ADVANCE multiplier (0 for none)
+ *
+ * The ack comes once it's in the planner. A block whose trapezoid doesn't fit its steps gets an
+ * error and is dropped. Positions move by the steps as sent: leveling, skew and every speed,
+ * acceleration and jerk limit are the host's. The first block after lines starts from a stop,
+ * and the first line after blocks starts from one too, so each side has to end at a safe speed.
+ */
+static void binary_stream_block() {
+	auto &s = binary_stream;
+	if (commands_in_queue || !planner.has_room()) return;
+	s.block_pending = false;
+
+	host_block_t block;
+	memcpy(&block, &s.payload[1], sizeof(block));
+	const bool queued =
+#if ENABLED(STEP_QUEUE_MODE)
+		!stepper.step_queue_active && // The planner's blocks would wait for M278 S0
+#endif
+		planner.buffer_host_block(block, active_extruder);
+	if (queued) {
+		LOOP_XYZE(i) {
+			const float mm = block.steps[i] * planner.steps_to_mm[i];
+			current_position[i] += TEST(block.direction_bits, i) ? -mm : mm;
+		}
+	}
+	else {
+		SERIAL_ERROR_START();
+		SERIAL_ERRORLNPGM("Host block refused");
+	}
 
-				gcode_N = strtol(npos + 1, nullptr, 10);
+	binary_stream_ack();
+}
 
-				if (gcode_N != gcode_LastN + 1 && !M110) {
-					gcode_line_error(PSTR(MSG_ERR_LINE_NO));
-					return;
-				}
+#endif // HOST_PLANNED_BLOCKS
 
-				if (apos) {
-					byte checksum = 0, count = 0;
-					while (command[count] != '*') checksum ^= command[count++];
+#if ENABLED(STEP_QUEUE_MODE)
 
-					if (strtol(apos + 1, nullptr, 10) != checksum) {
-						gcode_line_error(PSTR(MSG_ERR_CHECKSUM_MISMATCH));
-						return;
-					}
-					// if no errors, continue parsing
-				}
-				else {
-					gcode_line_error(PSTR(MSG_ERR_NO_CHECKSUM));
-					return;
-				}
+/**
+ * Queue the runs of a step packet as their axes' queues have room. Nothing more is read until
+ * they all are, and the ack comes then.
+ *
+ *   'S', then runs of 8 bytes each: the axis (0-3 for X, Y, Z, E) with bit 7 set for a motor
+ *   running backwards and bit 6 for a run that only keeps time, the interval as a uint24, the
+ *   count as a uint16 and the add as an int16
+ *
+ * Intervals are in stepper timer ticks, 0.5us, and the first of a run counts from the last
+ * event of its axis, so each axis has to be kept fed or kept in time with silent runs. Runs
+ * sent outside of M278 S1 get an error and are dropped.
+ */
+static void binary_stream_steps() {
+	auto &s = binary_stream;
+	for (; s.steps_pending < s.length; s.steps_pending += 8) {
+		const uint8_t *data = &s.payload[s.steps_pending];
+		const AxisEnum axis = AxisEnum(data[0] & 0x03);
+		step_run_t run;
+		run.flags = data[0] & (step_run_t::reverse | step_run_t::silent);
+		memcpy(&run.interval, &data[1], 3);
+		memcpy(&run.count, &data[4], 2);
+		memcpy(&run.add, &data[6], 2);
+		if (!stepper.queue_step_run(axis, run)) return;
+		switch (axis) {
+		case X_AXIS: enable_X(); break;
+		case Y_AXIS: enable_Y(); break;
+		case Z_AXIS: enable_Z(); break;
+		default: enable_E0(); break;
+		}
+	}
+	s.steps_pending = 0;
+	refresh_cmd_timeout(); // The motors stay on while the host keeps them busy
+	binary_stream_ack();
+}
 
-				gcode_LastN = gcode_N;
-				// if no errors, continue parsing
-			}
-			else if (__unlikely(apos != nullptr)) { // No '*' without 'N'
-				gcode_line_error(PSTR(MSG_ERR_NO_LINENUMBER_WITH_CHECKSUM), false);
-				return;
+#endif // STEP_QUEUE_MODE
+
+// Whether a packet waits to be queued, which holds up reading the next
+static inline bool binary_stream_held() {
+#if ENABLED(HOST_PLANNED_BLOCKS)
+	if (binary_stream.block_pending) return true;
+#endif
+#if ENABLED(STEP_QUEUE_MODE)
+	if (binary_stream.steps_pending) return true;
+#endif
+	return false;
+}
+
+/**
+ * Act on a packet that passed its CRC
+ */
+static void binary_stream_packet() {
+	auto &s = binary_stream;
+
+#if ENABLED(BAUD_RATE_GCODE)
+	host_baud_confirmed();
+#endif
+
+	if (int8_t(s.packet_seq - s.seq) < 0) return;   // Sent again after a nak; already queued
+	if (s.packet_seq != s.seq) { binary_stream_nak(); return; }
+
+	if (!s.length) {
+		s.active = false;
+#if ENABLED(EMERGENCY_PARSER)
+		emergency_parser_enabled = true;
+#endif
+#if ENABLED(RX_LINE_FRAMING)
+		MYSERIAL.set_line_framing(true);
+#endif
+	}
+#if ENABLED(HOST_PLANNED_BLOCKS)
+	else if (s.payload[0] == 'B') {
+		if (s.length != 1 + sizeof(host_block_t)) { binary_stream_nak(); return; }
+		s.block_pending = true;
+		binary_stream_block();
+		return;
+	}
+#endif
+#if ENABLED(STEP_QUEUE_MODE)
+	else if (s.payload[0] == 'S') {
+		if (s.length < 9 || (s.length - 1) % 8) { binary_stream_nak(); return; }
+		for (uint8_t i = 1; i < s.length; i += 8)
+			if (!(s.payload[i + 4] | s.payload[i + 5])) { binary_stream_nak(); return; } // A run of no events
+		if (!stepper.step_queue_active) {
+			SERIAL_ERROR_START();
+			SERIAL_ERRORLNPGM("Step queues not started");
+			binary_stream_ack();
+			return;
+		}
+		s.steps_pending = 1;
+		binary_stream_steps();
+		return;
+	}
+#endif
+	else {
+		ParsedCommand &command = command_queue[cmd_queue_index_w];
+		if (!parser.decode(s.payload, s.length, command)) { binary_stream_nak(); return; }
+
+#if DISABLED(EMERGENCY_PARSER)
+		// As for text lines, these act at once
+		if (__unlikely(command.letter == 'M')) switch (command.codenum) {
+		case 108:
+			wait_for_heatup = false;
+#if ENABLED(ULTIPANEL)
+			wait_for_user = false;
+#endif
+			break;
+		case 112: kill(PSTR(MSG_KILLED)); break;
+		case 410: quickstop_stepper(); break;
+		default: break;
+		}
+#endif
+
+		_commit_command(false);
+	}
+
+	binary_stream_ack();
+}
+
+/**
+ * Read binary packets from the serial port while the queue has room
+ */
+static void get_binary_commands() {
+	auto &s = binary_stream;
+
+	const millis_t ms = millis();
+	if (__unlikely(s.state != BINARY_SYNC) && ELAPSED(ms, s.last_byte_ms + BINARY_STREAMING_TIMEOUT)) binary_stream_nak();
+
+#if ENABLED(HOST_PLANNED_BLOCKS)
+	if (s.block_pending) binary_stream_block();
+#endif
+#if ENABLED(STEP_QUEUE_MODE)
+	if (s.steps_pending) binary_stream_steps();
+#endif
+
+	while (s.active && command_queue_has_room() && !binary_stream_held() && MYSERIAL.available() > 0) {
+		const uint8_t c = MYSERIAL.read();
+		s.last_byte_ms = ms;
+
+		if (s.state != BINARY_SYNC && s.state < BINARY_CRC_LOW) s.crc = _crc_xmodem_update(s.crc, c);
+
+		switch (s.state) {
+		case BINARY_SYNC:
+			if (c == 0xA5) { s.crc = 0; s.state = BINARY_SEQ; }
+			break;
+		case BINARY_SEQ:
+			s.packet_seq = c;
+			s.state = BINARY_LENGTH;
+			break;
+		case BINARY_LENGTH:
+			s.length = c;
+			s.received = 0;
+			if (s.length > sizeof(s.payload)) binary_stream_nak();
+			else s.state = s.length ? BINARY_PAYLOAD : BINARY_CRC_LOW;
+			break;
+		case BINARY_PAYLOAD:
+			s.payload[s.received++] = c;
+			if (s.received == s.length) s.state = BINARY_CRC_LOW;
+			break;
+		case BINARY_CRC_LOW:
+			s.crc ^= c;
+			s.state = BINARY_CRC_HIGH;
+			break;
+		case BINARY_CRC_HIGH:
+			s.crc ^= uint16_t(c) << 8;
+			s.state = BINARY_SYNC;
+			if (s.crc) binary_stream_nak();
+			else binary_stream_packet();
+			break;
+		}
+	}
+}
+
+#endif // BINARY_STREAMING
+
+/**
+ * Check a whole line from the host and queue it.
+ * Returns false if it was rejected, and no more lines should be taken now.
+ */
+static bool commit_serial_line(char *serial_line, uint8_t checksum, const uint8_t star) {
+	char* command = serial_line;
+
+	// skip any leading spaces, which the checksum doesn't cover
+	while (*command == ' ') {
+		command++;
+		checksum ^= ' ';
+	}
+	char *npos = __unlikely(*command == 'N') ? command : nullptr, // Require the N parameter to start the line
+		*apos = __unlikely(star != 0xFF) ? serial_line + star : nullptr;
+
+	if (__unlikely(npos != nullptr)) {
+
+		// M110 can only be the word after the line number
+		const char *word = npos + 1;
+		if (*word == '-') ++word;
+		while (NUMERIC(*word)) ++word;
+		while (*word == ' ') ++word;
+		const bool M110 = strncmp_P(word, PSTR("M110"), 4) == 0;
+
+		if (M110) {
+			char* n2pos = strchr(word + 4, 'N');
+			if (n2pos) npos = n2pos;
+#if ENABLED(RESEND_WINDOW)
+			// Kept lines are numbered from the old count
+			drop_held_lines();
+#endif
+		}
+
+		gcode_N = parse::integer(npos + 1);
+
+		if (gcode_N != gcode_LastN + 1 && !M110) {
+#if ENABLED(RESEND_WINDOW)
+			if (apos && parse::integer(apos + 1) == checksum && window_line(serial_line, checksum, star)) return true;
+#endif
+			gcode_line_error(PSTR(MSG_ERR_LINE_NO));
+			return false;
+		}
+
+		if (apos) {
+			if (parse::integer(apos + 1) != checksum) {
+				gcode_line_error(PSTR(MSG_ERR_CHECKSUM_MISMATCH));
+				return false;
 			}
+			// if no errors, continue parsing
+		}
+		else {
+			gcode_line_error(PSTR(MSG_ERR_NO_CHECKSUM));
+			return false;
+		}
 
-			// Movement commands alert when stopped
-			if (__unlikely(!is_running())) {
-				char* gpos = strchr(command, 'G');
-				if (gpos) {
-					const int codenum = strtol(gpos + 1, nullptr, 10);
-					switch (codenum) {
-					case 0:
-					case 1:
-					case 2:
-					case 3:
-						SERIAL_ERRORLNPGM(MSG_ERR_STOPPED);
-						LCD_MESSAGEPGM(MSG_STOPPED);
-						break;
-					}
-				}
+		gcode_LastN = gcode_N;
+#if ENABLED(RESEND_WINDOW)
+		// The line after the last kept one ends the resend
+		if (!resend_window.held) resend_window.recovering = false;
+#endif
+		// if no errors, continue parsing
+	}
+	else if (__unlikely(apos != nullptr)) { // No '*' without 'N'
+		gcode_line_error(PSTR(MSG_ERR_NO_LINENUMBER_WITH_CHECKSUM), false);
+		return false;
+	}
+
+	// Movement commands alert when stopped
+	if (__unlikely(!is_running())) {
+		char* gpos = strchr(command, 'G');
+		if (gpos) {
+			const int codenum = parse::integer(gpos + 1);
+			switch (codenum) {
+			case 0:
+			case 1:
+			case 2:
+			case 3:
+				SERIAL_ERRORLNPGM(MSG_ERR_STOPPED);
+				LCD_MESSAGEPGM(MSG_STOPPED);
+				break;
 			}
+		}
+	}
 
 #if DISABLED(EMERGENCY_PARSER)
-			// If command was e-stop process now
-			if (__unlikely(strcmp(command, "M108") == 0)) {
-				wait_for_heatup = false;
+	// If command was e-stop process now
+	if (__unlikely(strcmp(command, "M108") == 0)) {
+		wait_for_heatup = false;
 #if ENABLED(ULTIPANEL)
-				wait_for_user = false;
+		wait_for_user = false;
 #endif
-			}
-			if (__unlikely(strcmp(command, "M112") == 0)) kill(PSTR(MSG_KILLED));
-			if (__unlikely(strcmp(command, "M410") == 0)) { quickstop_stepper(); }
+	}
+	if (__unlikely(strcmp(command, "M112") == 0)) kill(PSTR(MSG_KILLED));
+	if (__unlikely(strcmp(command, "M410") == 0)) { quickstop_stepper(); }
 #endif
 
 #if defined(NO_TIMEOUTS) && NO_TIMEOUTS > 0
-			last_command_time = ms;
+	last_command_time = ms;
+#endif
+
+#if ENABLED(BAUD_RATE_GCODE)
+	// A line with a good checksum, or at least a plausible one
+	if (__unlikely(fallback_baud) && (npos || is_printable(command))) host_baud_confirmed();
+#endif
+
+	// Add the command to the queue
+#if ENABLED(PARSED_COMMAND_QUEUE)
+	_enqueuecommand(serial_line, true);
+#else
+	_commit_line(serial_line, true);
+#endif
+	return true;
+}
+
+#if ENABLED(RESEND_WINDOW)
+/**
+ * Take the kept lines that follow on from the last line taken, while the queue has room.
+ * Each goes through commit_serial_line() again, as if it had just come in.
+ * Return false while one is left that could be taken, so newer lines wait behind it.
+ */
+static bool commit_held_lines() {
+	for (;;) {
+		uint8_t slot = 0;
+		while (slot < RESEND_WINDOW_LINES && !(TEST(resend_window.held, slot) && resend_window.line[slot] == gcode_LastN + 1)) ++slot;
+		if (slot == RESEND_WINDOW_LINES) return true;
+		if (!command_queue_has_room()) return false;
+#if ENABLED(PARSED_COMMAND_QUEUE)
+		char *serial_line = resend_window.text[slot];
+#else
+		// Taken in place, like a line just read
+		if (!move_serial_line()) return false;
+		char *serial_line = command_queue[cmd_queue_index_w];
+		strcpy(serial_line, resend_window.text[slot]);
+#endif
+		// Cleared after, so the resend isn't over until the last one is taken
+		commit_serial_line(serial_line, resend_window.checksum[slot], resend_window.star[slot]);
+		CBI(resend_window.held, slot);
+	}
+}
+
+inline bool __forceinline held_lines_committed() {
+	return __likely(!resend_window.held) || commit_held_lines();
+}
+#endif
+
+#if DISABLED(RX_LINE_FRAMING)
+/**
+ * Add a character to the line being read, and to its checksum
+ */
+inline void __forceinline __flatten store_serial_char(char *serial_line, const char c) {
+	if (!serial_count) {
+		serial_checksum = 0;
+		serial_star = 0xFF;
+	}
+	if (serial_star == 0xFF) {
+		if (__unlikely(c == '*')) serial_star = serial_count;
+		else serial_checksum ^= c;
+	}
+	serial_line[serial_count++] = c;
+}
+#endif
+
+/**
+ * Get all commands waiting on the serial port and queue them.
+ * Exit when the buffer is full or when no more characters are
+ * left on the serial port.
+ */
+inline void get_serial_commands() {
+#if ENABLED(PARSED_COMMAND_QUEUE)
+	// Lines are parsed into records, not kept, so they need a buffer of their own
+#if DISABLED(SCRATCH_ARENA) || DISABLED(RX_LINE_FRAMING)
+	static char serial_line_buffer[MAX_CMD_SIZE];
+#endif
+#else
+	// The line is read and checked where it will be queued, to save a copy
+#define serial_line_buffer command_queue[cmd_queue_index_w]
+#endif
+#if DISABLED(RX_LINE_FRAMING)
+	static bool serial_comment_mode = false;
+#endif
+
+#if ENABLED(BAUD_RATE_GCODE)
+	if (__unlikely(fallback_baud) && ELAPSED(millis(), baud_fallback_ms)) {
+		set_host_baud(fallback_baud);
+		fallback_baud = 0;
+		SERIAL_ECHO_START();
+		SERIAL_ECHOLNPAIR("Baud rate restored: ", host_baud);
+	}
+#endif
+
+#if ENABLED(BINARY_STREAMING)
+	// A binary packet may time out while nothing arrives
+	if (__unlikely(binary_stream.active)) {
+		get_binary_commands();
+		return;
+	}
+#endif
+
+#if ENABLED(RESEND_WINDOW)
+	// Kept lines go before anything newer
+	if (!held_lines_committed()) return;
 #endif
 
-			// Add the command to the queue
-			_enqueuecommand(serial_line_buffer, true);
+	// An idle port costs one bit test
+	if (__likely(!serial<host_port>::rx_pending())) return;
+
+#if ENABLED(RX_LINE_FRAMING)
+	/**
+	 * The receive interrupt has stripped comments and counted the lines,
+	 * so take whole lines while the queue is not full
+	 */
+#if ENABLED(SCRATCH_ARENA) && ENABLED(PARSED_COMMAND_QUEUE)
+	// Each line is read whole and parsed here, so it only needs the buffer until this returns
+	const scratch_buffer<char, MAX_CMD_SIZE> serial_line_buffer;
+#endif
+	uint8_t checksum, star;
+	while (command_queue_has_room() && MYSERIAL.read_line(serial_line_buffer, MAX_CMD_SIZE, checksum, star) >= 0) {
+		if (!commit_serial_line(serial_line_buffer, checksum, star)) return;
+#if ENABLED(RESEND_WINDOW)
+		if (!held_lines_committed()) return;
+#endif
+	}
+#else
+	/**
+	 * Loop while serial characters are incoming and the queue is not full
+	 */
+	while (command_queue_has_room() && MYSERIAL.available() > 0) {
+
+		char serial_char = MYSERIAL.read();
+
+		/**
+		 * If the character ends the line
+		 */
+		if (__unlikely(serial_char == '\n' || serial_char == '\r')) {
+
+			serial_comment_mode = false; // end of line == end of comment
+
+			if (__unlikely(!serial_count)) continue; // skip empty lines
+
+			serial_line_buffer[serial_count] = 0; // terminate string
+			serial_count = 0; //reset buffer
+
+			if (!commit_serial_line(serial_line_buffer, serial_checksum, serial_star)) return;
+#if ENABLED(RESEND_WINDOW)
+			if (!held_lines_committed()) return;
+#endif
 		}
 		else if (__unlikely(serial_count >= MAX_CMD_SIZE - 1)) {
 			// Keep fetching, but ignore normal characters beyond the max length
@@ -695,18 +1656,131 @@ inline void get_serial_commands() {
 			if (MYSERIAL.available() > 0) {
 				// if we have one more character, copy it over
 				serial_char = MYSERIAL.read();
-				if (!serial_comment_mode) serial_line_buffer[serial_count++] = serial_char;
+				if (!serial_comment_mode) store_serial_char(serial_line_buffer, serial_char);
 			}
 			// otherwise do nothing
 		}
 		else { // it's not a newline, carriage return or escape char
 			if (serial_char == ';') serial_comment_mode = true;
-			if (!serial_comment_mode) serial_line_buffer[serial_count++] = serial_char;
+			if (!serial_comment_mode) store_serial_char(serial_line_buffer, serial_char);
 		}
 
 	} // queue has space, serial has data
+#endif
+#undef serial_line_buffer
+}
+
+/**
+ * The whole SD file has been read
+ */
+static void sd_file_printed() {
+	SERIAL_PROTOCOLLNPGM(MSG_FILE_PRINTED);
+	card.printingHasFinished();
+#if ENABLED(PRINTER_EVENT_LEDS)
+	LCD_MESSAGEPGM(MSG_INFO_COMPLETED_PRINTS);
+	set_led_color(0, 255, 0); // Green
+#if HAS_RESUME_CONTINUE
+	enqueue_and_echo_commands_P(PSTR("M0")); // end of the queue!
+#else
+	safe_delay(1000);
+#endif
+	set_led_color(0, 0, 0);   // OFF
+#endif
+	card.checkautostart(true);
+}
+
+#if ENABLED(SD_BINARY_FILES)
+
+/**
+ * Read a pre-parsed SD file, found by CardReader::openFile(), until the queue is full
+ *
+ * After the "TGC\x01" header each command is a record:
+ *
+ *   length, payload[length]            a command, as a BINARY_STREAMING payload
+ *   0x80 | length, text[length]        a line kept as text, without its newline or comment
+ *
+ * Records are read whole, so the position kept by a pause or a procedure call is always at
+ * the start of one. buildroot/share/scripts/gcode_to_binary.py converts G-code files.
+ */
+static void get_sdcard_records() {
+	while (command_queue_has_room()) {
+		const int16_t head = card.get();
+		if (__unlikely(head < 0)) {
+			if (card.eof()) sd_file_printed();
+			else {
+				SERIAL_ERROR_START();
+				SERIAL_ECHOLNPGM(MSG_SD_ERR_READ);
+			}
+			return;
+		}
+
+		const bool is_text = head & 0x80;
+		const uint8_t length = head & 0x7F;
+		if (__unlikely(length > (is_text ? MAX_CMD_SIZE - 1 : PARSED_PAYLOAD_SIZE))) {
+			SERIAL_ERROR_START();
+			SERIAL_ECHOLNPGM(MSG_SD_ERR_READ);
+			card.stopSDPrint();
+			return;
+		}
+
+		uint8_t record[max(PARSED_PAYLOAD_SIZE, MAX_CMD_SIZE)];
+		for (uint8_t i = 0; i < length; ++i) {
+			const int16_t n = card.get();
+			if (__unlikely(n < 0)) {
+				SERIAL_ERROR_START();
+				SERIAL_ECHOLNPGM(MSG_SD_ERR_READ);
+				return;
+			}
+			record[i] = uint8_t(n);
+		}
+
+#if ENABLED(POWER_LOSS_RECOVERY)
+		const uint32 record_pos = card.getIndex() - length; // Of the record's first byte
+#endif
+		if (is_text) {
+			if (!length) continue;
+			record[length] = '\0';
+#if ENABLED(POWER_LOSS_RECOVERY)
+			next_command_sdpos = record_pos;
+#endif
+			_enqueuecommand((char *)record);
+		}
+		else if (parser.decode(record, length, command_queue[cmd_queue_index_w])) {
+#if ENABLED(POWER_LOSS_RECOVERY)
+			next_command_sdpos = record_pos;
+#endif
+			_commit_command(false);
+		}
+		else {
+			SERIAL_ERROR_START();
+			SERIAL_ECHOLNPGM(MSG_SD_ERR_READ);
+		}
+	}
 }
 
+#endif // SD_BINARY_FILES
+
+#if ENABLED(SD_BLOCK_SCAN)
+
+/**
+ * The first '\n' or '\r' in [p, end), or end. Four bytes a pass, to skip
+ * comments and thumbnails without going through the line reader per byte.
+ */
+static inline const uint8_t * __forceinline __flatten find_line_end(const uint8_t *p, const uint8_t * const end) {
+#define IS_LINE_END(c) ((c) == '\n' || (c) == '\r')
+	for (; end - p >= 4; p += 4) {
+		if (IS_LINE_END(p[0])) return p;
+		if (IS_LINE_END(p[1])) return p + 1;
+		if (IS_LINE_END(p[2])) return p + 2;
+		if (IS_LINE_END(p[3])) return p + 3;
+	}
+	for (; p < end; ++p) if (IS_LINE_END(*p)) return p;
+#undef IS_LINE_END
+	return end;
+}
+
+#endif // SD_BLOCK_SCAN
+
 /**
  * Get commands from the SD Card until the command buffer is full
  * or until the end of the file is reached. The special character '#'
@@ -727,9 +1801,105 @@ inline void __forceinline __flatten get_sdcard_commands() {
 
 	if (__unlikely(commands_in_queue == 0)) stop_buffering = false;
 
+#if ENABLED(SD_BINARY_FILES)
+	if (card.binary_file) {
+		get_sdcard_records();
+		return;
+	}
+#endif
+
+#if ENABLED(PARSED_COMMAND_QUEUE)
+#if ENABLED(SCRATCH_ARENA)
+	// A line is always finished within the call, as sd_count starts over with each
+	const scratch_buffer<char, MAX_CMD_SIZE> sd_line_buffer;
+#else
+	static char sd_line_buffer[MAX_CMD_SIZE];
+#endif
+#define SD_LINE sd_line_buffer
+#else
+#define SD_LINE command_queue[cmd_queue_index_w]
+#endif
+
 	uint16_t sd_count = 0;
+
+	// Terminate the line read so far and queue it
+#if ENABLED(POWER_LOSS_RECOVERY)
+	uint32 line_pos = 0; // Of the line's first character
+#define LINE_STARTS_AT(P) (line_pos = (P))
+#else
+#define LINE_STARTS_AT(P) NOOP
+#endif
+
+	const auto commit_line = [&]() {
+		SD_LINE[sd_count] = '\0';
+		sd_count = 0;
+#if ENABLED(POWER_LOSS_RECOVERY)
+		next_command_sdpos = line_pos;
+#endif
+#if ENABLED(PARSED_COMMAND_QUEUE)
+		_enqueuecommand(sd_line_buffer);
+#else
+		_commit_command(false);
+#endif
+	};
+
 	bool card_eof = card.eof();
-	while (commands_in_queue < BUFSIZE && __likely(!card_eof) && __likely(!stop_buffering)) {
+	while (command_queue_has_room() && __likely(!card_eof) && __likely(!stop_buffering)) {
+#if DISABLED(PARSED_COMMAND_QUEUE)
+		// A part-read serial line is in the slot; it needs the next one
+		if (__unlikely(serial_count) && commands_in_queue >= COMMAND_QUEUE_SIZE - 1) break;
+#endif
+#if ENABLED(SD_BLOCK_SCAN)
+		/**
+		 * Take the rest of the cached block in runs, up to the end of one line: a comment
+		 * is passed over with a single search for its end. get() below loads the next block.
+		 */
+		const uint8_t *block;
+		if (const uint16_t length = card.span(block)) {
+#if ENABLED(POWER_LOSS_RECOVERY)
+			const uint32 block_pos = card.readPosition(); // Of block[0]
+#endif
+			const uint8_t *p = block;
+			const uint8_t * const end = block + length;
+			bool line_end = false;
+			while (p < end && !line_end && !stop_buffering) {
+				if (sd_comment_mode) {
+					p = find_line_end(p, end);
+					if (p == end) break;
+				}
+				const char sd_char = char(*p++);
+				switch (sd_char) {
+				case '#':
+					stop_buffering = true;
+					// fall through
+				case ':': case '\n': case '\r':
+					sd_comment_mode = false;
+					line_end = (sd_count != 0);
+					break;
+				case ';':
+					sd_comment_mode = true;
+					break;
+				case ' ':
+					if (!sd_count) break; // Leading spaces
+					// fall through
+				default:
+					if (__likely(sd_count < MAX_CMD_SIZE - 1)) {
+						if (!sd_count) {
+#if DISABLED(PARSED_COMMAND_QUEUE)
+							move_serial_line();
+#endif
+							LINE_STARTS_AT(block_pos + (p - 1 - block));
+						}
+						SD_LINE[sd_count++] = sd_char;
+					}
+					break;
+				}
+			}
+			card.consume(p - block);
+			if (line_end) commit_line();
+			continue;
+		}
+#endif
 		const int16_t n = card.get();
 		char sd_char = (char)n;
 		card_eof = card.eof();
@@ -738,19 +1908,7 @@ inline void __forceinline __flatten get_sdcard_commands() {
 			|| ((sd_char == '#' || sd_char == ':') && !sd_comment_mode)
 			) {
 			if (__unlikely(card_eof)) {
-				SERIAL_PROTOCOLLNPGM(MSG_FILE_PRINTED);
-				card.printingHasFinished();
-#if ENABLED(PRINTER_EVENT_LEDS)
-				LCD_MESSAGEPGM(MSG_INFO_COMPLETED_PRINTS);
-				set_led_color(0, 255, 0); // Green
-#if HAS_RESUME_CONTINUE
-				enqueue_and_echo_commands_P(PSTR("M0")); // end of the queue!
-#else
-				safe_delay(1000);
-#endif
-				set_led_color(0, 0, 0);   // OFF
-#endif
-				card.checkautostart(true);
+				sd_file_printed();
 			}
 			else if (__unlikely(n == -1)) {
 				SERIAL_ERROR_START();
@@ -762,10 +1920,7 @@ inline void __forceinline __flatten get_sdcard_commands() {
 
 			if (!sd_count) continue; // skip empty lines (and comment lines)
 
-			command_queue[cmd_queue_index_w][sd_count] = '\0'; // terminate string
-			sd_count = 0; // clear sd line buffer
-
-			_commit_command(false);
+			commit_line();
 		}
 		else if (__unlikely(sd_count >= MAX_CMD_SIZE - 1)) {
 			/**
@@ -775,25 +1930,100 @@ inline void __forceinline __flatten get_sdcard_commands() {
 		}
 		else {
 			if (sd_char == ';') sd_comment_mode = true;
-			if (__likely(!sd_comment_mode)) command_queue[cmd_queue_index_w][sd_count++] = sd_char;
+			if (__likely(!sd_comment_mode) && (sd_char != ' ' || sd_count)) { // not leading spaces
+				if (!sd_count) {
+#if DISABLED(PARSED_COMMAND_QUEUE)
+					move_serial_line();
+#endif
+					LINE_STARTS_AT(card.getIndex());
+				}
+				SD_LINE[sd_count++] = sd_char;
+			}
 		}
 	}
+#undef LINE_STARTS_AT
+#undef SD_LINE
+}
+
+#if ENABLED(POWER_LOSS_RECOVERY)
+
+/**
+ * M1000 queues the resume one command at a time, as room frees up, like
+ * drain_injected_commands_P(). -1 when there's nothing to queue.
+ */
+static int8_t recovery_step = -1;
+
+static bool drain_recovery_commands() {
+	if (recovery_step < 0) return false;
+
+	const CardReader::checkpoint_t &checkpoint = card.checkpoint;
+	char cmd[MAX_CMD_SIZE], value[16];
+	const auto number = [&value](const float f) { return dtostrf(f, 1, 3, value); };
+
+	switch (recovery_step) {
+		case 0: strcpy_P(cmd, PSTR("G90")); break; // The moves below are absolute
+		case 1: sprintf_P(cmd, PSTR("M140 S%u"), checkpoint.target_bed); break;
+		case 2: sprintf_P(cmd, PSTR("M104 S%u"), checkpoint.target_hotend); break;
+		case 3: sprintf_P(cmd, PSTR("M190 S%u"), checkpoint.target_bed); break;
+		case 4: sprintf_P(cmd, PSTR("M109 S%u"), checkpoint.target_hotend); break;
+		// The nozzle is where the layer started: take that as Z, and lift off the print to home X and Y
+		case 5: sprintf_P(cmd, PSTR("G92 Z%s"), number(checkpoint.position[Z_AXIS])); break;
+		case 6: sprintf_P(cmd, PSTR("G1 Z%s F%u"), number(checkpoint.position[Z_AXIS] + POWER_LOSS_ZRAISE), uint16_t(MMS_TO_MMM(homing_feedrate(Z_AXIS)))); break;
+		case 7: strcpy_P(cmd, PSTR("G28 X Y")); break;
+		case 8: {
+			char y[16];
+			dtostrf(checkpoint.position[Y_AXIS], 1, 3, y);
+			sprintf_P(cmd, PSTR("G1 X%s Y%s F%u"), number(checkpoint.position[X_AXIS]), y, uint16_t(MMS_TO_MMM(homing_feedrate(X_AXIS))));
+		} break;
+		case 9: sprintf_P(cmd, PSTR("G1 Z%s"), number(checkpoint.position[Z_AXIS])); break;
+		case 10: sprintf_P(cmd, PSTR("G92 E%s"), number(checkpoint.position[E_AXIS])); break;
+		case 11: sprintf_P(cmd, PSTR("M106 S%u"), checkpoint.fan_speed); break;
+		case 12: sprintf_P(cmd, PSTR("G1 F%s"), number(MMS_TO_MMM(checkpoint.feedrate_mm_s))); break;
+		case 13: strcpy_P(cmd, checkpoint.relative_e ? PSTR("M83") : PSTR("M82")); break;
+		case 14: strcpy_P(cmd, checkpoint.relative_mode ? PSTR("G91") : PSTR("G90")); break;
+		case 15: sprintf_P(cmd, PSTR("M23 %s"), checkpoint.path); break;
+		case 16: sprintf_P(cmd, PSTR("M26 S%lu"), (unsigned long)checkpoint.sdpos); break;
+		default: strcpy_P(cmd, PSTR("M24")); break;
+	}
+
+	if (__likely(enqueue_and_echo_command(cmd))) {
+		if (recovery_step >= 17) recovery_step = -1; // M24 is queued: done
+		else ++recovery_step;
+	}
+	return recovery_step >= 0;
 }
 
+#endif // POWER_LOSS_RECOVERY
+
 /**
  * Add to the circular command queue the next command from:
- *  - The command-injection queue (injected_commands_P)
+ *  - The command-injection queue (injected_macro_P, then injected_commands_P)
  *  - The active serial input (usually USB)
  *  - The SD card file being actively printed
  */
 void __forceinline __flatten get_available_commands() {
 
 	// if any immediate commands remain, don't get other commands yet
+#if ENABLED(COMPILED_MACROS)
+	if (__unlikely(drain_injected_macro())) return;
+#endif
 	if (__unlikely(drain_injected_commands_P())) return;
 
+#if ENABLED(POWER_LOSS_RECOVERY)
+	if (__unlikely(drain_recovery_commands())) return;
+#endif
+
 	get_serial_commands();
 
+#if ENABLED(PIPELINE_PROFILING)
+	if (card.sdprinting) {
+		const uint32 sd_start_us = micros();
+		get_sdcard_commands();
+		profiling::add(profiling::section::sd_read, sd_start_us);
+	}
+#else
 	get_sdcard_commands();
+#endif
 }
 
 /**
@@ -890,8 +2120,8 @@ static void set_axis_is_at_home(const AxisEnum axis) {
  * Some planner shorthand inline functions
  */
 inline float __forceinline __flatten get_homing_bump_feedrate(const AxisEnum axis) {
-	static const uint8_t homing_bump_divisor[] __flashmem = HOMING_BUMP_DIVISOR;
-	uint8_t hbd = pgm_read_byte(&homing_bump_divisor[axis]);
+	static const flash_array<uint8_t, XYZ> homing_bump_divisor __flashmem = HOMING_BUMP_DIVISOR;
+	uint8_t hbd = homing_bump_divisor[axis];
 	if (__unlikely(hbd < 1)) {
 		hbd = 10;
 		SERIAL_ECHO_START();
@@ -900,11 +2130,59 @@ inline float __forceinline __flatten get_homing_bump_feedrate(const AxisEnum axi
 	return homing_feedrate(axis) / hbd;
 }
 
+#if ENABLED(MESH_COMPENSATION)
+
+/**
+ * Move the planner from 'start' to 'end' in pieces, split only where the line crosses
+ * a row or column of the mesh, so each piece lies within one of its cells. The ends
+ * of every piece are compensated by the planner.
+ */
+static void mesh_line_to(const float (&start)[XYZE], const float (&end)[XYZE], const float fr_mm_s) {
+	const float x0 = RAW_X_POSITION(start[X_AXIS]), y0 = RAW_Y_POSITION(start[Y_AXIS]),
+	            dx = end[X_AXIS] - start[X_AXIS], dy = end[Y_AXIS] - start[Y_AXIS];
+	uint8_t cx = mesh::cell_x(x0), cy = mesh::cell_y(y0);
+	const uint8_t ex = mesh::cell_x(RAW_X_POSITION(end[X_AXIS])), ey = mesh::cell_y(RAW_Y_POSITION(end[Y_AXIS]));
+
+	while (cx != ex || cy != ey) {
+		// How far along the line the next column and the next row of points are
+		const float tx = (cx == ex) ? 2.0f : (mesh::point_x(cx < ex ? cx + 1 : cx) - x0) / dx,
+		            ty = (cy == ey) ? 2.0f : (mesh::point_y(cy < ey ? cy + 1 : cy) - y0) / dy,
+		            t = min(tx, ty);
+		if (tx <= ty) cx += (cx < ex) ? 1 : -1;
+		if (ty <= tx) cy += (cy < ey) ? 1 : -1; // Both, through a point of the mesh
+		float point[XYZE];
+		LOOP_XYZE(i) point[i] = start[i] + t * (end[i] - start[i]);
+		planner.buffer_line(point[X_AXIS], point[Y_AXIS], point[Z_AXIS], point[E_AXIS], fr_mm_s, active_extruder);
+	}
+
+	planner.buffer_line(end[X_AXIS], end[Y_AXIS], end[Z_AXIS], end[E_AXIS], fr_mm_s, active_extruder);
+}
+
+/**
+ * Turn mesh compensation on or off. The nozzle stays where it is, and
+ * current_position takes it up as seen with the mesh, or without.
+ */
+void set_bed_leveling_enabled(const bool enable/*=true*/) {
+	if (enable == mesh::active) return;
+#if ENABLED(MOVE_COALESCING)
+	flush_coalesced_move();
+#endif
+	stepper.synchronize();
+	mesh::active = enable;
+	set_current_from_steppers_for_axis(Z_AXIS);
+	sync_plan_position();
+}
+
+#endif // MESH_COMPENSATION
+
 /**
  * Move the planner to the current position from wherever it last moved
  * (or from wherever it has been told it is located).
  */
 inline void __forceinline __flatten line_to_current_position() {
+#if ENABLED(MOVE_COALESCING)
+	flush_coalesced_move();
+#endif
 	planner.buffer_line(current_position[X_AXIS], current_position[Y_AXIS], current_position[Z_AXIS], current_position[E_AXIS], feedrate_mm_s, active_extruder);
 }
 
@@ -913,10 +2191,170 @@ inline void __forceinline __flatten line_to_current_position() {
  * used by G0/G1/G2/G3/G5 and many other functions to set a destination.
  */
 inline void __forceinline __flatten line_to_destination(const float fr_mm_s) {
+#if ENABLED(MOVE_COALESCING)
+	flush_coalesced_move();
+#endif
+#if ENABLED(MESH_COMPENSATION)
+	if (mesh::active) {
+		mesh_line_to(current_position, destination, fr_mm_s);
+		return;
+	}
+#endif
 	planner.buffer_line(destination[X_AXIS], destination[Y_AXIS], destination[Z_AXIS], destination[E_AXIS], fr_mm_s, active_extruder);
 }
 inline void __forceinline __flatten line_to_destination() { line_to_destination(feedrate_mm_s); }
 
+#if ENABLED(MOVE_COALESCING)
+
+/**
+ * Move coalescing
+ *
+ * The latest XY move is held back instead of being sent to the planner. While the
+ * following moves continue along the same line (every end point within
+ * COALESCE_TOLERANCE_MM of it), at the same feedrate and extruding at the same rate
+ * per mm, they extend the held move rather than becoming blocks of their own.
+ *
+ * With COALESCE_LAYER_CHANGE, a Z move with no extrusion is held too, and the travel
+ * that follows it is merged with it.
+ *
+ * The held move is flushed to the planner by anything else that touches the planner,
+ * by any command that is not a linear move, and whenever the command queue runs dry.
+ */
+static bool coalesce_pending = false;
+#if ENABLED(COALESCE_LAYER_CHANGE)
+static bool coalesce_z_only = false;    // The held move is a layer change's Z move
+#endif
+static float coalesce_start[XYZE],      // Where the held move starts
+             coalesce_end[XYZE],        // Where the held move currently ends
+             coalesce_unit[XYZ],        // Direction of the first move of the run
+             coalesce_e_per_mm,         // Extrusion per mm of the first move of the run
+             coalesce_length,           // Length of the held move along coalesce_unit
+             coalesce_fr_mm_s;          // Feedrate of the held move
+
+void flush_coalesced_move() {
+	if (!coalesce_pending) return;
+	coalesce_pending = false;
+#if ENABLED(COALESCE_LAYER_CHANGE)
+	coalesce_z_only = false;
+#endif
+#if ENABLED(MESH_COMPENSATION)
+	if (mesh::active) {
+		mesh_line_to(coalesce_start, coalesce_end, coalesce_fr_mm_s);
+		return;
+	}
+#endif
+	planner.buffer_line(coalesce_end[X_AXIS], coalesce_end[Y_AXIS], coalesce_end[Z_AXIS], coalesce_end[E_AXIS], coalesce_fr_mm_s, active_extruder);
+}
+
+/**
+ * Move to destination, merging the move into the held one if it keeps to the same line.
+ */
+static void coalesce_line_to_destination(const float fr_mm_s) {
+	float delta[XYZ];
+	LOOP_XYZ(i) delta[i] = destination[i] - current_position[i];
+	const float length = SQRT(sq(delta[X_AXIS]) + sq(delta[Y_AXIS]) + sq(delta[Z_AXIS]));
+	const float inverse_length = 1.0f / length; // XY always differ here, so length > 0
+	const float e_per_mm = (destination[E_AXIS] - current_position[E_AXIS]) * inverse_length;
+
+#if ENABLED(COALESCE_LAYER_CHANGE)
+	if (coalesce_pending && coalesce_z_only) {
+		// A travel in XY alone, straight after the held Z move, goes with it as one diagonal block.
+		// Anything else sends the Z move on its own, and is taken as usual.
+		if (delta[Z_AXIS] != 0.0f || e_per_mm != 0.0f || memcmp(current_position, coalesce_end, sizeof(coalesce_end)))
+			flush_coalesced_move();
+		else {
+			coalesce_pending = coalesce_z_only = false;
+			const float dz = coalesce_end[Z_AXIS] - coalesce_start[Z_AXIS],
+			            merged_length = SQRT(sq(delta[X_AXIS]) + sq(delta[Y_AXIS]) + sq(dz)),
+			            merged_fr_mm_s = min(fr_mm_s, coalesce_fr_mm_s * merged_length / FABS(dz));
+#if ENABLED(MESH_COMPENSATION)
+			if (mesh::active) {
+				mesh_line_to(coalesce_start, destination, merged_fr_mm_s);
+				return;
+			}
+#endif
+			planner.buffer_line(destination[X_AXIS], destination[Y_AXIS], destination[Z_AXIS], destination[E_AXIS], merged_fr_mm_s, active_extruder);
+			return;
+		}
+	}
+#endif
+
+	if (coalesce_pending) {
+		// The move must start where the held one ends. Anything that moved current_position
+		// in between (a cold extrusion for one) starts a new run.
+		bool mergeable = fr_mm_s == coalesce_fr_mm_s && !memcmp(current_position, coalesce_end, sizeof(coalesce_end));
+
+		if (mergeable) {
+			// Distance of the new end point along and away from the line of the run
+			float along = 0.0f, offset_sq = 0.0f;
+			LOOP_XYZ(i) {
+				const float rel = destination[i] - coalesce_start[i];
+				along += rel * coalesce_unit[i];
+				offset_sq += sq(rel);
+			}
+			offset_sq -= sq(along);
+
+			mergeable =
+				along > coalesce_length &&
+				along <= COALESCE_MAX_LENGTH_MM &&
+				offset_sq <= sq(COALESCE_TOLERANCE_MM) &&
+				FABS(e_per_mm - coalesce_e_per_mm) <= FABS(coalesce_e_per_mm) * (COALESCE_E_RATIO_TOLERANCE);
+
+			if (mergeable) {
+				COPY(coalesce_end, destination);
+				coalesce_length = along;
+				return;
+			}
+		}
+
+		flush_coalesced_move();
+	}
+
+	// Moves that are already long gain nothing from being held
+	if (length >= COALESCE_MAX_LENGTH_MM) {
+		line_to_destination(fr_mm_s);
+		return;
+	}
+
+	// Start a new run with this move
+	COPY(coalesce_start, current_position);
+	COPY(coalesce_end, destination);
+	LOOP_XYZ(i) coalesce_unit[i] = delta[i] * inverse_length;
+	coalesce_e_per_mm = e_per_mm;
+	coalesce_length = length;
+	coalesce_fr_mm_s = fr_mm_s;
+	coalesce_pending = true;
+}
+
+/**
+ * G0/G1 and the Tuna linear move extensions are the only commands that may leave a move held.
+ */
+#if ENABLED(COALESCE_LAYER_CHANGE)
+/**
+ * Hold a move in Z alone, with no extrusion, to merge with the travel that may come next.
+ */
+static void coalesce_z_move_to_destination(const float fr_mm_s) {
+	flush_coalesced_move();
+	COPY(coalesce_start, current_position);
+	COPY(coalesce_end, destination);
+	coalesce_fr_mm_s = fr_mm_s;
+	coalesce_z_only = true;
+	coalesce_pending = true;
+}
+#endif
+
+static __forceinline bool is_linear_move_command() {
+	if (parser.command_letter != 'G') return false;
+	switch (parser.codenum) {
+	case 0: case 1: case 6: case 7: case 8: case 9: case 13: case 14:
+		return true;
+	default:
+		return false;
+	}
+}
+
+#endif // MOVE_COALESCING
+
 void __forceinline __flatten set_current_to_destination() { COPY(current_position, destination); }
 void __forceinline __flatten set_destination_to_current() { COPY(destination, current_position); }
 
@@ -985,9 +2423,9 @@ static void clean_up_after_endstop_or_probe_move() {
 }
 
 /**
- * Home an individual linear axis
+ * Home an individual linear axis, and return whether its endstop was hit
  */
-static void do_homing_move(const AxisEnum axis, arg_type<float> distance, arg_type<float> fr_mm_s = 0.0) {
+static bool do_homing_move(const AxisEnum axis, arg_type<float> distance, arg_type<float> fr_mm_s = 0.0) {
 
 	// Tell the planner we're at Z=0
 	current_position[axis] = 0;
@@ -998,8 +2436,51 @@ static void do_homing_move(const AxisEnum axis, arg_type<float> distance, arg_ty
 
 	stepper.synchronize();
 
+	const bool hit = TEST(endstops.endstop_hit_bits, axis);
 	endstops.hit_on_purpose();
+	return hit;
+}
+
+#if defined(HOMING_BUMP_SLOW_MM)
+/**
+ * The part of a bump, signed as the bump, that is done at the bump feedrate
+ */
+static float homing_bump_slow(arg_type<float> bump) {
+	return (bump < 0) ? -min(float(HOMING_BUMP_SLOW_MM), -bump) : min(float(HOMING_BUMP_SLOW_MM), bump);
+}
+#endif
+
+/**
+ * Bump into the endstop from HOME_BUMP_MM away from it, and return
+ * whether it was found no sooner and no later than expected
+ */
+static bool home_bump(const AxisEnum axis, arg_type<float> bump) {
+	bool early = false;
+
+#if defined(HOMING_BUMP_SLOW_MM)
+	// Come back at full speed to just short of the endstop
+	const float slow = homing_bump_slow(bump);
+	if (bump != slow) early = do_homing_move(axis, bump - slow);
+#else
+	const float slow = bump;
+#endif
+
+	// Slow move towards endstop until triggered
+	return do_homing_move(axis, 2 * slow, get_homing_bump_feedrate(axis)) && !early;
+}
+
+#if ENABLED(FAST_REHOME)
+/**
+ * For an axis homed before, the move from the current position to HOME_BUMP_MM short
+ * of its endstop. It's 0 unless that's a move towards the endstop, as only a move
+ * towards it is stopped by the endstop if the position turns out to be wrong.
+ */
+static float rehome_distance(const AxisEnum axis, arg_type<float> bump) {
+	if (!axis_homed[axis]) return 0;
+	const float distance = base_home_pos(axis) - RAW_POSITION(current_position[axis], axis) - bump;
+	return (distance * bump > 0) ? distance : 0;
 }
+#endif
 
 /**
  * Home an individual "raw axis" to its endstop.
@@ -1023,21 +2504,29 @@ static void homeaxis(const AxisEnum axis) {
 	const int axis_home_dir =
 		home_dir(axis);
 
-	// Fast move towards endstop until triggered
-	do_homing_move(axis, 1.5 * max_length(axis) * axis_home_dir);
-
 	// When homing Z with probe respect probe clearance
 	const float bump = axis_home_dir * (
 		home_bump_mm(axis)
 		);
 
-	// If a second homing move is configured...
-	if (bump) {
-		// Move away from the endstop by the axis HOME_BUMP_MM
-		do_homing_move(axis, -bump);
+#if ENABLED(FAST_REHOME)
+	// If the axis was homed before, go at full speed to where the back-off would end and bump from
+	// there. An endstop hit on the way, or not where the bump expects it, means the position was
+	// lost, and the axis is homed the whole way.
+	const float rehome = rehome_distance(axis, bump);
+	if (!rehome || do_homing_move(axis, rehome, planner.max_feedrate_mm_s[axis]) || !home_bump(axis, bump))
+#endif
+	{
+		// Fast move towards endstop until triggered
+		do_homing_move(axis, 1.5 * max_length(axis) * axis_home_dir);
+
+		// If a second homing move is configured...
+		if (bump) {
+			// Move away from the endstop by the axis HOME_BUMP_MM
+			do_homing_move(axis, -bump);
 
-		// Slow move towards endstop until triggered
-		do_homing_move(axis, 2 * bump, get_homing_bump_feedrate(axis));
+			home_bump(axis, bump);
+		}
 	}
 
 	// For cartesian/core machines,
@@ -1048,6 +2537,93 @@ static void homeaxis(const AxisEnum axis) {
 	destination[axis] = current_position[axis];
 } // homeaxis()
 
+#if ENABLED(PARALLEL_HOMING)
+
+/**
+ * Move X and Y together by the given distances, each at no more than its own feedrate.
+ * The endstops stop each axis on its own, and the move ends when both have stopped.
+ * Returns the endstop hit bits of the axes that were stopped.
+ */
+static uint8_t do_homing_move_xy(arg_type<float> dx, arg_type<float> dy, arg_type<float> fr_x, arg_type<float> fr_y) {
+	// The move takes as long as the slower axis needs
+	const float time_s = max(FABS(dx) / fr_x, FABS(dy) / fr_y);
+	if (!(time_s > 0)) return 0;
+
+	current_position[X_AXIS] = current_position[Y_AXIS] = 0;
+	sync_plan_position();
+	current_position[X_AXIS] = dx;
+	current_position[Y_AXIS] = dy;
+	planner.buffer_line(current_position[X_AXIS], current_position[Y_AXIS], current_position[Z_AXIS], current_position[E_AXIS], HYPOT(dx, dy) / time_s, active_extruder);
+
+	stepper.synchronize();
+
+	const uint8_t hit = endstops.endstop_hit_bits & (_BV(X_MIN) | _BV(Y_MIN));
+	endstops.hit_on_purpose();
+	return hit;
+}
+
+/**
+ * Bump X and Y together into their endstops from HOME_BUMP_MM away, and return
+ * whether both were found no sooner and no later than expected
+ */
+static bool home_bump_xy(arg_type<float> bump_x, arg_type<float> bump_y) {
+	uint8_t early = 0;
+
+#if defined(HOMING_BUMP_SLOW_MM)
+	// Come back at full speed to just short of the endstops
+	const float slow_x = homing_bump_slow(bump_x), slow_y = homing_bump_slow(bump_y);
+	early = do_homing_move_xy(bump_x - slow_x, bump_y - slow_y, homing_feedrate(X_AXIS), homing_feedrate(Y_AXIS));
+#else
+	const float slow_x = bump_x, slow_y = bump_y;
+#endif
+
+	// Slow move towards both endstops until both are triggered
+	const uint8_t hit = do_homing_move_xy(2 * slow_x, 2 * slow_y, get_homing_bump_feedrate(X_AXIS), get_homing_bump_feedrate(Y_AXIS));
+	return !early && hit == ((bump_x ? _BV(X_MIN) : 0) | (bump_y ? _BV(Y_MIN) : 0));
+}
+
+/**
+ * Home X and Y together: approach, back-off and re-bump are each one move for both axes
+ */
+static void quick_home_xy() {
+	const float bump_x = home_dir(X_AXIS) * home_bump_mm(X_AXIS),
+		bump_y = home_dir(Y_AXIS) * home_bump_mm(Y_AXIS);
+
+	endstops.stop_per_axis = true;
+
+#if ENABLED(FAST_REHOME)
+	// As in homeaxis(), both axes go at full speed to where the back-off would end, if they can
+	const float rehome_x = rehome_distance(X_AXIS, bump_x), rehome_y = rehome_distance(Y_AXIS, bump_y);
+	if (!rehome_x || !rehome_y
+		|| do_homing_move_xy(rehome_x, rehome_y, planner.max_feedrate_mm_s[X_AXIS], planner.max_feedrate_mm_s[Y_AXIS])
+		|| !home_bump_xy(bump_x, bump_y))
+#endif
+	{
+		const float fr_x = homing_feedrate(X_AXIS), fr_y = homing_feedrate(Y_AXIS);
+
+		// Fast move towards both endstops until both are triggered
+		do_homing_move_xy(1.5 * max_length(X_AXIS) * home_dir(X_AXIS), 1.5 * max_length(Y_AXIS) * home_dir(Y_AXIS), fr_x, fr_y);
+
+		if (bump_x || bump_y) {
+			// Move both away from the endstops by their HOME_BUMP_MM
+			do_homing_move_xy(-bump_x, -bump_y, fr_x, fr_y);
+
+			home_bump_xy(bump_x, bump_y);
+		}
+	}
+
+	endstops.stop_per_axis = false;
+
+	set_axis_is_at_home(X_AXIS);
+	set_axis_is_at_home(Y_AXIS);
+	sync_plan_position();
+
+	destination[X_AXIS] = current_position[X_AXIS];
+	destination[Y_AXIS] = current_position[Y_AXIS];
+}
+
+#else // !PARALLEL_HOMING
+
 static void quick_home_xy() {
 
   // Pretend the current position is 0,0
@@ -1067,12 +2643,116 @@ static void quick_home_xy() {
   set_axis_is_at_home(Y_AXIS);
 }
 
+#endif // !PARALLEL_HOMING
+
 /**
  * ***************************************************************************
  * ***************************** G-CODE HANDLING *****************************
  * ***************************************************************************
  */
 
+ /**
+  * The axis and feedrate words of the current GCode command, as the parser has them
+  */
+struct parser_words final {
+	static __forceinline bool seen(const AxisEnum axis) { return parser.seen(axis_codes[axis]); }
+	static __forceinline float value(const AxisEnum axis) { return parser.value_axis_units(axis); }
+	static __forceinline float feedrate() { return parser.linearval('F'); }
+};
+
+#if ENABLED(FAST_LINEAR_MOVES)
+
+/**
+ * The words of a plain G0/G1 line, read by scan_linear_move() instead of the parser
+ */
+struct linear_words_t final {
+	uint8_t seen;               // A bit per axis, then F
+	float value[XYZE + 1];
+};
+static linear_words_t linear_move_words;
+
+struct fast_words final {
+	static __forceinline bool seen(const AxisEnum axis) { return TEST(linear_move_words.seen, axis); }
+	static __forceinline float value(const AxisEnum axis) {
+#if ENABLED(INCH_MODE_SUPPORT)
+		return linear_move_words.value[axis] * parser.axis_unit_factor(axis);
+#else
+		return linear_move_words.value[axis];
+#endif
+	}
+	static __forceinline float feedrate() {
+		if (!TEST(linear_move_words.seen, XYZE)) return 0.0;
+#if ENABLED(INCH_MODE_SUPPORT)
+		return linear_move_words.value[XYZE] * parser.linear_unit_factor;
+#else
+		return linear_move_words.value[XYZE];
+#endif
+	}
+};
+
+/**
+ * Read a plain G0 or G1 line into linear_move_words in one pass: an optional line number,
+ * then only X Y Z E F words with values, then an optional checksum. Anything else, down to a
+ * word without a value, is left to the parser. Return the code, or -1 if the line isn't one.
+ */
+static int8_t scan_linear_move(const char *p, linear_words_t &words = linear_move_words) {
+	while (*p == ' ') ++p;
+	if (__unlikely(*p == 'N') && NUMERIC_SIGNED(p[1])) {
+		p += 2;
+		while (NUMERIC(*p)) ++p;
+		while (*p == ' ') ++p;
+	}
+
+	if (*p != 'G' || (p[1] != '0' && p[1] != '1') || DECIMAL(p[2])) return -1;
+	const int8_t code = p[1] - '0';
+	p += 2;
+
+	uint8_t seen = 0;
+	for (;;) {
+		while (*p == ' ') ++p;
+		uint8_t i;
+		switch (*p++) {
+		case 'X': i = X_AXIS; break;
+		case 'Y': i = Y_AXIS; break;
+		case 'Z': i = Z_AXIS; break;
+		case 'E': i = E_AXIS; break;
+		case 'F': i = XYZE; break;
+		case '\0': case '*':
+			words.seen = seen;
+			return code;
+		default: return -1;
+		}
+		while (*p == ' ') ++p;
+		if (!DECIMAL_SIGNED(*p)) return -1;
+		words.value[i] = Tuna::parse::decimal(p, p);
+		if (DECIMAL_SIGNED(*p)) return -1;  // Not a number the parser would read the same way
+		SBI(seen, i);
+	}
+}
+
+#if ENABLED(PREFETCH_LINEAR_MOVES)
+/**
+ * The line after the current one, scanned while the planner was full
+ */
+static struct {
+	int8_t code;                // From scan_linear_move()
+	linear_words_t words;
+} prefetched_move;
+
+/**
+ * Called while _buffer_line() waits for a free block. Scan the next queued
+ * line now, so it can go to the planner as soon as a block is free.
+ */
+void prefetch_linear_move() {
+	if (prefetched_line || commands_in_queue < 2) return;
+	const uint8_t next = (cmd_queue_index_r + 1 >= COMMAND_QUEUE_SIZE) ? 0 : cmd_queue_index_r + 1;
+	prefetched_move.code = scan_linear_move(command_queue[next], prefetched_move.words);
+	prefetched_line = command_queue[next];
+}
+#endif
+
+#endif // FAST_LINEAR_MOVES
+
  /**
   * Set XYZE destination and feedrate from the current GCode command
   *
@@ -1080,7 +2760,7 @@ static void quick_home_xy() {
   *  - Set to current for missing axis codes
   *  - Set the feedrate, if included
   */
-template <MovementType dimensional_move_type = MovementType::Linear, MovementMode move_mode = MovementMode::Modal, MovementMode extruder_move_mode = MovementMode::Modal>
+template <MovementType dimensional_move_type = MovementType::Linear, MovementMode move_mode = MovementMode::Modal, MovementMode extruder_move_mode = MovementMode::Modal, typename Words = parser_words>
 void __forceinline __flatten gcode_get_destination() {
   float max_feedrate = type_trait<float>::max;
 
@@ -1090,9 +2770,9 @@ void __forceinline __flatten gcode_get_destination() {
     __assume(motion::is_axial(i));
     const AxisEnum axis = motion::as_axis(i);
     __assume(axis >= X_AXIS && axis <= E_AXIS);
-    if (parser.seen(axis_codes[i]))
+    if (Words::seen(axis))
     {
-      const auto axis_move = parser.value_axis_units(axis);
+      const auto axis_move = Words::value(axis);
 
       const MovementMode mode = __likely(axis != E_AXIS) ? move_mode : extruder_move_mode;
 
@@ -1126,9 +2806,10 @@ void __forceinline __flatten gcode_get_destination() {
 	}
 
   // G0 still has an F parameter that's used by Cura, unfortunately.
-  if (__unlikely(parser.linearval('F') > 0.0))
+  const float param_feedrate = Words::feedrate();
+  if (__unlikely(param_feedrate > 0.0))
   {
-    last_param_feedrate_mm_s = MMM_TO_MMS(parser.value_feedrate());
+    last_param_feedrate_mm_s = MMM_TO_MMS(param_feedrate);
   }
 
   if constexpr (param_feed)
@@ -1139,9 +2820,6 @@ void __forceinline __flatten gcode_get_destination() {
   {
     feedrate_mm_s = max_feedrate;
   }
-
-	if (!DEBUGGING(DRYRUN))
-		print_job_timer.incFilamentUsed(destination[E_AXIS] - current_position[E_AXIS]);
 }
 
 /**
@@ -1163,38 +2841,31 @@ bool gcode_get_destination_e_absolute()
     last_param_feedrate_mm_s = MMM_TO_MMS(parser.value_feedrate());
   }
   feedrate_mm_s = last_param_feedrate_mm_s;
-
-  if (!DEBUGGING(DRYRUN))
-    print_job_timer.incFilamentUsed(destination[E_AXIS] - current_position[E_AXIS]);
 }
 
 /**
  * Output a "busy" message at regular intervals
  * while the machine is not accepting commands.
+ * Scheduled every host_keepalive_interval seconds.
  */
-void __forceinline __flatten host_keepalive() {
-	const millis_t ms = millis();
-	if (host_keepalive_interval && busy_state != NOT_BUSY) {
-		if (PENDING(ms, next_busy_signal_ms)) return;
-		switch (busy_state) {
-		case IN_HANDLER:
-		case IN_PROCESS:
-			SERIAL_ECHO_START();
-			SERIAL_ECHOLNPGM(MSG_BUSY_PROCESSING);
-			break;
-		case PAUSED_FOR_USER:
-			SERIAL_ECHO_START();
-			SERIAL_ECHOLNPGM(MSG_BUSY_PAUSED_FOR_USER);
-			break;
-		case PAUSED_FOR_INPUT:
-			SERIAL_ECHO_START();
-			SERIAL_ECHOLNPGM(MSG_BUSY_PAUSED_FOR_INPUT);
-			break;
-		default:
-			break;
-		}
+static void host_keepalive() {
+	switch (busy_state) {
+	case IN_HANDLER:
+	case IN_PROCESS:
+		SERIAL_ECHO_START();
+		SERIAL_ECHOLNPGM(MSG_BUSY_PROCESSING);
+		break;
+	case PAUSED_FOR_USER:
+		SERIAL_ECHO_START();
+		SERIAL_ECHOLNPGM(MSG_BUSY_PAUSED_FOR_USER);
+		break;
+	case PAUSED_FOR_INPUT:
+		SERIAL_ECHO_START();
+		SERIAL_ECHOLNPGM(MSG_BUSY_PAUSED_FOR_INPUT);
+		break;
+	default:
+		break;
 	}
-	next_busy_signal_ms = ms + host_keepalive_interval * 1000UL;
 }
 
 
@@ -1202,11 +2873,76 @@ void __forceinline __flatten host_keepalive() {
  ***************** GCode Handlers *****************
  **************************************************/
 
+#if ENABLED(PARALLEL_PRINT_START)
+
+static void wait_for_hotend(const bool no_wait_for_cooling);
+static void wait_for_bed(const bool no_wait_for_cooling);
+
+/**
+ * From the start of an SD print until its first extruding move, M109 and M190
+ * only set their targets and record the wait they skipped.
+ */
+static struct {
+	bool active;
+	bool hotend, hotend_no_wait_for_cooling;
+	bool bed, bed_no_wait_for_cooling;
+} parallel_start;
+
+void begin_parallel_start() {
+	parallel_start = {};
+	parallel_start.active = true;
+}
+
+static __forceinline bool defer_heatup_wait() {
+	return parallel_start.active && card.sdprinting;
+}
+
+/**
+ * Called before the first extruding move: wait for what M190 and M109 skipped.
+ */
+static void finish_parallel_start() {
+	const auto skipped = parallel_start;
+	parallel_start = {};
+	if (!card.sdprinting) return;
+
+#if ENABLED(MOVE_COALESCING)
+	flush_coalesced_move();
+#endif
+	if (skipped.bed) wait_for_bed(skipped.bed_no_wait_for_cooling);
+	if (skipped.hotend) wait_for_hotend(skipped.hotend_no_wait_for_cooling);
+}
+
+#endif // PARALLEL_PRINT_START
+
+#if ENABLED(POWER_LOSS_RECOVERY)
+
+/**
+ * Called by the first extruding move of each layer of an SD print: note where the
+ * print is, before that move, for idle() to save to PLR.BIN.
+ */
+static void power_loss_checkpoint() {
+	const uint32 sdpos = command_sdpos[cmd_queue_index_r];
+	if (sdpos == NO_SDPOS) return; // Not a command from the file
+
+	CardReader::checkpoint_t &checkpoint = card.checkpoint;
+	checkpoint.sdpos = sdpos;
+	COPY(checkpoint.position, current_position);
+	checkpoint.feedrate_mm_s = feedrate_mm_s;
+	checkpoint.target_hotend = Temperature::target_temperature.rounded_to<uint16>();
+	checkpoint.target_bed = Temperature::target_temperature_bed.rounded_to<uint16>();
+	checkpoint.fan_speed = fanSpeeds[0];
+	checkpoint.relative_mode = relative_mode;
+	checkpoint.relative_e = axis_relative_modes[E_AXIS];
+	card.checkpoint_pending = true;
+}
+
+#endif // POWER_LOSS_RECOVERY
+
  /**
   * G0, G1: Coordinated movement of X Y Z E axes
   */
 
-template <MovementType move_type, MovementMode dimensional_move_mode = MovementMode::Modal, MovementMode extruder_move_mode = MovementMode::Modal>
+template <MovementType move_type, MovementMode dimensional_move_mode = MovementMode::Modal, MovementMode extruder_move_mode = MovementMode::Modal, typename Words = parser_words>
 inline void __forceinline __flatten linear_move()
 {
   if (__unlikely(!is_running()))
@@ -1214,17 +2950,41 @@ inline void __forceinline __flatten linear_move()
     return;
   }
 
-  gcode_get_destination<move_type, dimensional_move_mode, extruder_move_mode>(); // For X Y Z E F
+  gcode_get_destination<move_type, dimensional_move_mode, extruder_move_mode, Words>(); // For X Y Z E F
+
+#if ENABLED(PARALLEL_PRINT_START)
+  // Homing and leveling ran while the heaters warmed up; extruding waits for them.
+  if (__unlikely(parallel_start.active) && destination[E_AXIS] > current_position[E_AXIS])
+  {
+    finish_parallel_start();
+  }
+#endif
+
+#if ENABLED(POWER_LOSS_RECOVERY)
+  // The first extrusion at a new height starts a layer; a Z-hop doesn't extrude.
+  if (__unlikely(card.sdprinting) && current_position[Z_AXIS] != card.checkpoint.position[Z_AXIS] && destination[E_AXIS] > current_position[E_AXIS])
+  {
+    power_loss_checkpoint();
+  }
+#endif
 
 #if ENABLED(FWRETRACT)
   if (MIN_AUTORETRACT <= MAX_AUTORETRACT) {
     // When M209 Autoretract is enabled, convert E-only moves to firmware retract/recover moves
-    if (autoretract_enabled && parser.seen('E') && !(parser.seen('X') || parser.seen('Y') || parser.seen('Z'))) {
+    if (autoretract_enabled && Words::seen(E_AXIS) && !(Words::seen(X_AXIS) || Words::seen(Y_AXIS) || Words::seen(Z_AXIS))) {
       const float echange = destination[E_AXIS] - current_position[E_AXIS];
       // Is this a retract or recover move?
       if (WITHIN(FABS(echange), MIN_AUTORETRACT, MAX_AUTORETRACT) && retracted[active_extruder] == (echange > 0.0)) {
+#if ENABLED(FWRETRACT_LOOKAHEAD)
+#if ENABLED(MOVE_COALESCING)
+        flush_coalesced_move();
+#endif
+        planner.shift_position_mm(E_AXIS, echange);     // Hide a G1-based retract/recover from the planner
+        current_position[E_AXIS] = destination[E_AXIS]; // AND from calculations
+#else
         current_position[E_AXIS] = destination[E_AXIS]; // Hide a G1-based retract/recover from calculations
         sync_plan_position_e();                         // AND from the planner
+#endif
         retract(echange < 0.0);                  // Firmware-based retract/recover (double-retract ignored)
         return;
       }
@@ -1286,10 +3046,10 @@ inline void __forceinline __flatten gcode_G11() { retract(false); }
  *    G3 X20 Y12 R14   ; CCW circle with r=14 ending at X20 Y12
  */
 
-/*
+#if ENABLED(ARC_SUPPORT)
 inline void gcode_G2_G3(bool clockwise) {
 	if (__likely(is_running())) {
-		gcode_get_destination();
+		gcode_get_destination<MovementType::Linear, MovementMode::Modal, MovementMode::Modal>();
 
 		float arc_offset[2] = { 0.0, 0.0 };
 		if (parser.seenval('R')) {
@@ -1326,7 +3086,7 @@ inline void gcode_G2_G3(bool clockwise) {
 		}
 	}
 }
-*/
+#endif // ARC_SUPPORT
 
 /**
  * G4: Dwell S<seconds> or P<milliseconds>
@@ -1381,6 +3141,7 @@ constexpr bool g29_in_progress = false;
  *
  *  None  Home to all axes with no parameters.
  *        With QUICK_HOME enabled XY will home together, then Z.
+ *        With PARALLEL_HOMING XY also back off and re-bump together.
  *
  * Cartesian parameters
  *
@@ -1393,6 +3154,17 @@ inline void gcode_G28(const bool always_home_all) {
 	// Wait for planner moves to finish!
 	stepper.synchronize();
 
+#if ENABLED(INPUT_SHAPING)
+	// The shaped steps trail the endstop checks, which would carry the motors past the trigger
+	stepper.refresh_shaping(true);
+#endif
+
+#if ENABLED(MESH_COMPENSATION)
+	// Home without the mesh, which doesn't hold until X and Y are known
+	const bool mesh_was_active = mesh::active;
+	set_bed_leveling_enabled(false);
+#endif
+
 	setup_for_endstop_or_probe_move();
 	endstops.enable(true); // Enable endstops for next homing move
 
@@ -1455,6 +3227,14 @@ inline void gcode_G28(const bool always_home_all) {
 
 	clean_up_after_endstop_or_probe_move();
 
+#if ENABLED(MESH_COMPENSATION)
+	set_bed_leveling_enabled(mesh_was_active);
+#endif
+
+#if ENABLED(INPUT_SHAPING)
+	stepper.refresh_shaping();
+#endif
+
 	lcd::refresh();
 
 	report_current_position();
@@ -1713,12 +3493,61 @@ inline void gcode_M33() {
 	card.printLongPath(parser.string_arg);
 }
 
-/**
- * M928: Start SD Write
- */
-inline void gcode_M928() {
-	card.openLogFile(parser.string_arg);
-}
+/**
+ * M928: Start SD Write
+ */
+inline void gcode_M928() {
+	card.openLogFile(parser.string_arg);
+}
+
+#if ENABLED(JOB_QUEUE)
+
+/**
+ * M276: Start, end or report a job queue
+ *
+ *   M276 <name.gq> = Run the prints the file lists, from the root of the card
+ *   M276 C         = End the queue once the print that is running is done
+ *   M276           = Report the queue
+ */
+inline void gcode_M276() {
+	const char *arg = parser.string_arg;
+	if (!arg || !*arg)
+		card.reportJobQueue();
+	else if (!strcasecmp_P(arg, PSTR("C"))) {
+		card.stopJobQueue();
+		card.reportJobQueue();
+	}
+	else
+		card.startJobQueue(arg);
+}
+
+#endif
+
+#if ENABLED(POWER_LOSS_RECOVERY)
+
+/**
+ * M1000: Resume the SD print that was cut off by a power loss, from the start of the
+ *        last layer initsd() found in PLR.BIN. The bed and hotend heat up, Z is set
+ *        to the layer's height, X and Y home with the nozzle lifted off the print,
+ *        and the file goes on from the layer's first extruding move.
+ *
+ *  C  Forget the checkpoint instead
+ */
+inline void gcode_M1000() {
+	if (parser.seen('C')) {
+		card.clear_checkpoint();
+		return;
+	}
+	if (!card.checkpoint_found || card.sdprinting || recovery_step >= 0 || strlen(card.checkpoint.path) + 4 >= MAX_CMD_SIZE) {
+		SERIAL_ERROR_START();
+		SERIAL_ERRORLNPGM(MSG_CHECKPOINT_NONE);
+		return;
+	}
+	card.checkpoint_found = false;
+	recovery_step = 0;
+}
+
+#endif // POWER_LOSS_RECOVERY
 
 /**
  * Sensitive pin test for M42, M226
@@ -1758,6 +3587,52 @@ inline void gcode_M42() {
 	}
 }
 
+#if ENABLED(PRINT_TIME_ESTIMATE)
+
+// The slicer's remaining time from the last M73 R, in ms from print_remaining_ms_at.
+// M73 runs once the moves before it are planned, so their queued time is added to it.
+static uint32_t print_remaining_ms = 0;
+static millis_t print_remaining_ms_at = 0;
+static bool print_remaining_known = false;
+
+/**
+ * M73: Set the print progress from the slicer
+ *
+ *   R<minutes> - Time left to print from this line, as the slicer estimates it
+ */
+inline void gcode_M73() {
+	if (parser.seenval('R')) {
+		print_remaining_ms = (parser.value_ulong() * 60000UL) + planner.queued_move_ms();
+		print_remaining_ms_at = millis();
+		print_remaining_known = true;
+	}
+}
+
+/**
+ * The minutes left of the running print. From M73 when the slicer sends it, or else
+ * the time so far scaled by the unread part of the file.
+ */
+uint16_t print_remaining_minutes() {
+	if (!print_job_timer.isRunning()) {
+		print_remaining_known = false;
+		return 0;
+	}
+
+	if (print_remaining_known) {
+		const millis_t elapsed = millis() - print_remaining_ms_at;
+		return (elapsed < print_remaining_ms) ? uint16_t(min((print_remaining_ms - elapsed) / 60000UL, 0xFFFFUL)) : 0;
+	}
+
+#if ENABLED(SDSUPPORT)
+	const uint8_t percent = card.percentDone();
+	if (percent > 0 && percent < 100)
+		return uint16_t(min((print_job_timer.duration() * (100 - percent)) / (percent * 60UL), 0xFFFFUL));
+#endif
+	return 0;
+}
+
+#endif // PRINT_TIME_ESTIMATE
+
 /**
  * M75: Start print timer
  */
@@ -1784,6 +3659,138 @@ inline void gcode_M78() {
 		print_job_timer.showStats();
 }
 
+/**
+ * Set the hot end's target as M104 does, stopping the print timer for a cool nozzle.
+ */
+static void set_hotend_target(arg_type<temp_t> temp) {
+	Temperature::setTargetHotend(temp);
+
+	/**
+	 * Stop the timer at the end of print. Start is managed by 'heat and wait' M109.
+	 * We use half EXTRUDE_MINTEMP here to allow nozzles to be put into hot
+	 * standby mode, for instance in a dual extruder setup, without affecting
+	 * the running print timer.
+	 */
+	if (float(temp) <= (EXTRUDE_MINTEMP) / 2) {
+		print_job_timer.stop();
+		LCD_MESSAGEPGM(WELCOME_MSG);
+	}
+
+	if (temp > Temperature::degHotend())
+		lcd::statusf(0, PSTR("E%i %s"), target_extruder + 1, MSG_HEATING);
+}
+
+#if ENABLED(MOTION_SYNC_EVENTS)
+
+/**
+ * Commands that take effect where they are in the motion, without draining the planner.
+ * An event waits in the ring for the next block to be planned, which counts it in its
+ * sync_events, and runs from manage_inactivity() once the stepper starts that block.
+ * When the planner runs empty the moves before every waiting event have run, so all run.
+ */
+enum class sync_event_t : uint8_t {
+	hotend_target, // M104
+	bed_target,    // M140
+	marker         // M279
+};
+
+struct sync_event_entry_t {
+	sync_event_t type;
+	temp_t temperature;
+	uint16_t marker;
+};
+
+static sync_event_entry_t sync_events[MOTION_SYNC_EVENT_SLOTS];
+static spsc_ring<MOTION_SYNC_EVENT_SLOTS> sync_event_queue;
+
+static void apply_sync_event(const sync_event_entry_t &event) {
+	switch (event.type) {
+	case sync_event_t::hotend_target: set_hotend_target(event.temperature); break;
+	case sync_event_t::bed_target: Temperature::setTargetBed(event.temperature); break;
+	case sync_event_t::marker: SERIAL_ECHOLNPAIR("marker:", event.marker); break;
+	}
+}
+
+// Runs the events whose blocks the stepper has started, or all of them once the planner is empty.
+static void run_sync_events() {
+	if (sync_event_queue.empty()) return;
+
+	uint8_t due;
+	{
+		Tuna::critical_section _critsec;
+		if (planner.blocks_queued()) {
+			due = Planner::sync_events_due;
+		}
+		else {
+			due = sync_event_queue.count();
+			Planner::sync_events_unplanned = 0;
+		}
+		Planner::sync_events_due = 0;
+	}
+
+	for (; due && !sync_event_queue.empty(); --due) {
+		apply_sync_event(sync_events[sync_event_queue.tail()]);
+		sync_event_queue.pop();
+	}
+}
+
+// Runs 'event' after the moves planned so far, at once if there are none.
+static void queue_sync_event(const sync_event_entry_t &event) {
+	if (!planner.blocks_queued()) {
+		run_sync_events();
+		apply_sync_event(event);
+		return;
+	}
+
+	while (sync_event_queue.full()) idle();
+
+	sync_events[sync_event_queue.head()] = event;
+	sync_event_queue.push();
+	++Planner::sync_events_unplanned;
+}
+
+/**
+ * M279: Report a marker once the moves before it have run
+ *
+ *   P = The marker, sent back as "marker:<P>"
+ */
+inline void gcode_M279() {
+	queue_sync_event({ sync_event_t::marker, temp_t{}, uint16_t(parser.ushortval('P')) });
+}
+
+#endif // MOTION_SYNC_EVENTS
+
+#if ENABLED(STEP_QUEUE_MODE)
+
+/**
+ * M278: Hand the motors to the step queues, or back to the planner
+ *
+ *   S1 = Start once the planner's moves are done. The host then sends runs of steps.
+ *   S0 = Stop once the queued runs are done, taking the position from the steppers
+ *
+ * Without S, report "step_queue:<1 if started> L<events put out late> H<axes stopped by endstops>".
+ */
+inline void gcode_M278() {
+	if (parser.seenval('S')) {
+		if (parser.value_bool())
+			stepper.start_step_queues();
+		else if (stepper.step_queue_active) {
+			stepper.stop_step_queues();
+			set_current_from_steppers();
+			current_position[E_AXIS] = stepper.get_axis_position_mm(E_AXIS);
+			SYNC_PLAN_POSITION_KINEMATIC();
+		}
+		return;
+	}
+
+	SERIAL_PROTOCOLPAIR("step_queue:", int(stepper.step_queue_active));
+	SERIAL_PROTOCOLPAIR(" L", uint16_t(stepper.step_queue_late));
+	SERIAL_PROTOCOLPGM(" H");
+	SERIAL_PROTOCOLLN(int(stepper.step_queue_halted));
+}
+
+#endif // STEP_QUEUE_MODE
+
 /**
  * M104: Set hot end temperature
  */
@@ -1793,51 +3800,34 @@ inline void __forceinline __flatten gcode_M104() {
 
 	if (__likely(parser.seenval('S'))) {
 		const temp_t temp = parser.value_celsius();
-    Temperature::setTargetHotend(temp);
-
-		/**
-		 * Stop the timer at the end of print. Start is managed by 'heat and wait' M109.
-		 * We use half EXTRUDE_MINTEMP here to allow nozzles to be put into hot
-		 * standby mode, for instance in a dual extruder setup, without affecting
-		 * the running print timer.
-		 */
-		if (parser.value_celsius() <= (EXTRUDE_MINTEMP) / 2) {
-			print_job_timer.stop();
-			LCD_MESSAGEPGM(WELCOME_MSG);
-		}
-
-		if (parser.value_celsius() > float(Temperature::degHotend()))
-			lcd::statusf(0, PSTR("E%i %s"), target_extruder + 1, MSG_HEATING);
+#if ENABLED(MOTION_SYNC_EVENTS)
+		queue_sync_event({ sync_event_t::hotend_target, temp, 0 });
+#else
+		set_hotend_target(temp);
+#endif
 	}
 
 	planner.autotemp_M104_M109();
 }
 
-void print_heater_state(const float &c, const float &t,
-#if ENABLED(SHOW_TEMP_ADC_VALUES)
-	const float r,
-#endif
-	const int8_t e = -2
-) {
-	SERIAL_PROTOCOLCHAR(' ');
-	SERIAL_PROTOCOLCHAR(
-		e == -1 ? 'B' : 'T'
+/**
+ * " T:c /t B:c /t @:p B@:p" between 'prefix' and 'suffix', formatted on the stack
+ * from the raw fixed-point temperatures and sent in a single write.
+ */
+template <usize P, usize S>
+static void write_heaterstates(const flash_char_array<P> &prefix, const flash_char_array<S> &suffix) {
+	Tuna::format::write<host_port>(
+		prefix,
+		" T:"_p, Temperature::degHotend(), " /"_p, Temperature::degTargetHotend(),
+		" B:"_p, Temperature::degBed(), " /"_p, Temperature::degTargetBed(),
+		" @:"_p, Temperature::getHeaterPower<Temperature::Manager::Hotend>(),
+		" B@:"_p, Temperature::getHeaterPower<Temperature::Manager::Bed>(),
+		suffix
 	);
-	SERIAL_PROTOCOLCHAR(':');
-	SERIAL_PROTOCOL(c);
-	SERIAL_PROTOCOLPAIR(" /", t);
 }
 
 void print_heaterstates() {
-	print_heater_state(Temperature::degHotend(), Temperature::degTargetHotend()
-	);
-	print_heater_state(Temperature::degBed(), Temperature::degTargetBed(),
-		-1 // BED
-	);
-	SERIAL_PROTOCOLPGM(" @:");
-	SERIAL_PROTOCOL(Temperature::getHeaterPower<Temperature::Manager::Hotend>());
-	SERIAL_PROTOCOLPGM(" B@:");
-	SERIAL_PROTOCOL(Temperature::getHeaterPower<Temperature::Manager::Bed>());
+	write_heaterstates(""_p, ""_p);
 }
 
 /**
@@ -1846,34 +3836,102 @@ void print_heaterstates() {
 inline void gcode_M105() {
 	if (get_target_extruder_from_command(105)) return;
 
-	SERIAL_PROTOCOLPGM(MSG_OK);
-	print_heaterstates();
-
-	SERIAL_EOL();
+	write_heaterstates(MSG_OK ""_p, "\n"_p);
 }
 
-static uint8_t auto_report_temp_interval;
-static millis_t next_temp_report_ms;
-
 /**
  * M155: Set temperature auto-report interval. M155 S<seconds>
  */
 inline void gcode_M155() {
 	if (parser.seenval('S')) {
-		auto_report_temp_interval = parser.value_byte();
+		uint8_t auto_report_temp_interval = parser.value_byte();
 		NOMORE(auto_report_temp_interval, 60);
-		next_temp_report_ms = millis() + 1000UL * auto_report_temp_interval;
+		periodic.set_period(periodic_task::auto_report, 1000UL * auto_report_temp_interval);
 	}
 }
 
-inline void auto_report_temperatures() {
-	if (auto_report_temp_interval && ELAPSED(millis(), next_temp_report_ms)) {
-		next_temp_report_ms = millis() + 1000UL * auto_report_temp_interval;
-		print_heaterstates();
-		SERIAL_EOL();
+/**
+ * Scheduled every M155 S seconds.
+ */
+static void auto_report_temperatures() {
+	write_heaterstates(""_p, "\n"_p);
+}
+
+#if ENABLED(BINARY_STATUS_REPORT)
+
+// The state sent by M277, little-endian. Temperatures are temp_t raw values (1/16 C).
+struct status_frame_t {
+	static constexpr uint8_t stopped = _BV(0), sd_printing = _BV(1), paused = _BV(2), endstop_hit = _BV(3), busy = _BV(4);
+
+	uint16 time;                  // millis(), wrapping
+	uint8 flags;
+	uint16 temperature, target;
+	uint16 bed_temperature, bed_target;
+	uint8 power, bed_power;
+	int24 position[NUM_AXIS];     // in steps, from count_position
+	uint32 sd_position, sd_size;  // 0 without a file open
+	uint8 moves_planned, commands_queued;
+};
+c_static_assert(sizeof(status_frame_t) == 35, "The host reads 35-byte status frames.");
+
+/**
+ * Send one status frame: "status:<length>", then the frame and its CRC-16/XMODEM, low byte
+ * first, and a newline.
+ */
+static void report_status() {
+	status_frame_t frame;
+	frame.time = uint16(millis());
+	frame.flags = (is_running() ? 0 : status_frame_t::stopped)
+		| (print_job_timer.isPaused() ? status_frame_t::paused : 0)
+		| (endstops.endstop_hit_bits ? status_frame_t::endstop_hit : 0)
+		| (busy_state != NOT_BUSY ? status_frame_t::busy : 0);
+	frame.temperature = uint16(Temperature::degHotend().raw());
+	frame.target = uint16(Temperature::degTargetHotend().raw());
+	frame.bed_temperature = uint16(Temperature::degBed().raw());
+	frame.bed_target = uint16(Temperature::degTargetBed().raw());
+	frame.power = Temperature::getHeaterPower<Temperature::Manager::Hotend>();
+	frame.bed_power = Temperature::getHeaterPower<Temperature::Manager::Bed>();
+	stepper.positions(frame.position);
+	frame.sd_position = frame.sd_size = 0;
+#if ENABLED(SDSUPPORT)
+	if (card.sdprinting) frame.flags |= status_frame_t::sd_printing;
+	if (card.isFileOpen()) {
+		frame.sd_position = card.getIndex();
+		frame.sd_size = card.getSize();
 	}
+#endif
+	frame.moves_planned = planner.movesplanned();
+	frame.commands_queued = commands_in_queue;
+
+	SERIAL_ECHOLNPAIR("status:", uint16(sizeof(frame) + 2));
+	const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&frame);
+	uint16_t crc = 0;
+	for (uint8_t i = 0; i < sizeof(frame); ++i) {
+		crc = _crc_xmodem_update(crc, bytes[i]);
+		SERIAL_CHAR(bytes[i]);
+	}
+	SERIAL_CHAR(uint8_t(crc));
+	SERIAL_CHAR(uint8_t(crc >> 8));
+	SERIAL_EOL();
+}
+
+/**
+ * M277: Send a binary status frame
+ *
+ *   S<ms> = Send one every <ms> milliseconds instead, 0 to stop
+ */
+inline void gcode_M277() {
+	if (parser.seen('S')) {
+		uint16_t interval = parser.value_ushort();
+		if (interval) NOLESS(interval, 50);
+		periodic.set_period(periodic_task::status_report, interval);
+	}
+	else
+		report_status();
 }
 
+#endif // BINARY_STATUS_REPORT
+
 /**
  * M106: Set Fan Speed
  *
@@ -1950,6 +4008,36 @@ inline void gcode_M109() {
 
 	planner.autotemp_M104_M109();
 
+#if ENABLED(PARALLEL_PRINT_START)
+	if (defer_heatup_wait()) {
+		parallel_start.hotend = true;
+		parallel_start.hotend_no_wait_for_cooling = no_wait_for_cooling;
+		return;
+	}
+#endif
+
+	wait_for_hotend(no_wait_for_cooling);
+}
+
+#if ENABLED(PREDICTIVE_HEATUP_WAIT)
+
+/**
+ * Whether a heater at 'temp', changing at 'rate' C/s, will be within 'hysteresis' of 'target'
+ * 'lead' seconds from now. Only close to the target, where the rise is already slowing, so a
+ * straight line from here errs low rather than high.
+ */
+static bool heatup_predicted(const float temp, const float target, const float rate, const float lead, const float hysteresis) {
+	if (temp < target - (HEATUP_PREDICT_WINDOW)) return false;
+	return FABS(target - (temp + rate * lead)) <= hysteresis;
+}
+
+#endif
+
+/**
+ * Wait for the hotend to reach its target and stay within TEMP_HYSTERESIS of it
+ * for TEMP_RESIDENCY_TIME seconds (or give up on cooling, see M109).
+ */
+static void wait_for_hotend(const bool no_wait_for_cooling) {
 	millis_t residency_start_ms = 0;
 	// Loop until the temperature has stabilized
 #define TEMP_CONDITIONS (!residency_start_ms || PENDING(now, residency_start_ms + (TEMP_RESIDENCY_TIME) * 1000UL))
@@ -1990,6 +4078,11 @@ inline void gcode_M109() {
 
 		const float temp_diff = FABS(target_temp - temp);
 
+#if ENABLED(PREDICTIVE_HEATUP_WAIT)
+		// Done already if it will be there by the first extrusion
+		if (!wants_to_cool && heatup_predicted(temp, target_temp, Temperature::get_temperature_rate<Temperature::Manager::Hotend>().celsius(), HEATUP_LEAD_TIME, TEMP_HYSTERESIS)) break;
+#endif
+
 		if (!residency_start_ms) {
 			// Start the TEMP_RESIDENCY_TIME timer when we reach target temp for the first time.
 			if (temp_diff < TEMP_WINDOW) residency_start_ms = now;
@@ -2038,6 +4131,22 @@ inline void gcode_M190() {
 	}
 	else return;
 
+#if ENABLED(PARALLEL_PRINT_START)
+	if (defer_heatup_wait()) {
+		parallel_start.bed = true;
+		parallel_start.bed_no_wait_for_cooling = no_wait_for_cooling;
+		return;
+	}
+#endif
+
+	wait_for_bed(no_wait_for_cooling);
+}
+
+/**
+ * Wait for the bed to reach its target and stay within TEMP_BED_HYSTERESIS of it
+ * for TEMP_BED_RESIDENCY_TIME seconds (or give up on cooling, see M190).
+ */
+static void wait_for_bed(const bool no_wait_for_cooling) {
 	millis_t residency_start_ms = 0;
 	// Loop until the temperature has stabilized
 #define TEMP_BED_CONDITIONS (!residency_start_ms || PENDING(now, residency_start_ms + (TEMP_BED_RESIDENCY_TIME) * 1000UL))
@@ -2080,6 +4189,10 @@ inline void gcode_M190() {
 
 		const float temp_diff = FABS(target_temp - temp);
 
+#if ENABLED(PREDICTIVE_HEATUP_WAIT)
+		if (!wants_to_cool && heatup_predicted(temp, target_temp, Temperature::get_temperature_rate<Temperature::Manager::Bed>().celsius(), HEATUP_BED_LEAD_TIME, TEMP_BED_HYSTERESIS)) break;
+#endif
+
 		if (!residency_start_ms) {
 			// Start the TEMP_BED_RESIDENCY_TIME timer when we reach target temp for the first time.
 			if (temp_diff < TEMP_BED_WINDOW) residency_start_ms = now;
@@ -2188,6 +4301,7 @@ inline void gcode_M113() {
 	if (parser.seenval('S')) {
 		host_keepalive_interval = parser.value_byte();
 		NOMORE(host_keepalive_interval, 60);
+		periodic.set_period(periodic_task::host_keepalive, host_keepalive_interval * 1000UL);
 	}
 	else {
 		SERIAL_ECHO_START();
@@ -2200,7 +4314,13 @@ inline void gcode_M113() {
  */
 inline void gcode_M140() {
 	if (__unlikely(DEBUGGING(DRYRUN))) return;
-	if (__likely(parser.seenval('S'))) Temperature::setTargetBed(parser.value_celsius());
+	if (__likely(parser.seenval('S'))) {
+#if ENABLED(MOTION_SYNC_EVENTS)
+		queue_sync_event({ sync_event_t::bed_target, parser.value_celsius(), 0 });
+#else
+		Temperature::setTargetBed(parser.value_celsius());
+#endif
+	}
 }
 
 /**
@@ -2276,19 +4396,23 @@ inline void gcode_M92() {
 		if (parser.seen(axis_codes[i])) {
 			if (i == E_AXIS) {
 				const float value = parser.value_per_axis_unit((AxisEnum)(E_AXIS + TARGET_EXTRUDER));
+				if (!(value > 0)) continue; // The planner divides by it
 				if (value < 20.0) {
 					float factor = planner.axis_steps_per_mm[E_AXIS + TARGET_EXTRUDER] / value; // increase e constants if M92 E14 is given for netfab.
 					planner.max_jerk[E_AXIS] *= factor;
 					planner.max_feedrate_mm_s[E_AXIS + TARGET_EXTRUDER] *= factor;
-					planner.max_acceleration_steps_per_s2[E_AXIS + TARGET_EXTRUDER] *= factor;
+					// The steps/s^2 limit is derived from this by refresh_positioning()
+					planner.max_acceleration_mm_per_s2[E_AXIS + TARGET_EXTRUDER] *= factor;
 				}
 				planner.axis_steps_per_mm[E_AXIS + TARGET_EXTRUDER] = value;
 			}
 			else {
-				planner.axis_steps_per_mm[i] = parser.value_per_axis_unit((AxisEnum)i);
+				const float value = parser.value_per_axis_unit((AxisEnum)i);
+				if (value > 0) planner.axis_steps_per_mm[i] = value;
 			}
 		}
 	}
+	// steps_to_mm, the steps/s^2 limits and the positions in steps follow from the steps per mm
 	planner.refresh_positioning();
 }
 
@@ -2308,10 +4432,38 @@ void __forceinline __flatten report_current_position() {
 	stepper.report_positions();
 }
 
+#if ENABLED(M114_REALTIME)
+/**
+ * Output where the steppers are now, without waiting for the moves, in mm and in steps
+ */
+static void report_realtime_position() {
+	float mm[XYZE];
+	stepper.get_positions_mm(mm);
+	SERIAL_PROTOCOLPGM("X:");
+	SERIAL_PROTOCOL(mm[X_AXIS]);
+	SERIAL_PROTOCOLPGM(" Y:");
+	SERIAL_PROTOCOL(mm[Y_AXIS]);
+	SERIAL_PROTOCOLPGM(" Z:");
+	SERIAL_PROTOCOL(mm[Z_AXIS]);
+	SERIAL_PROTOCOLPGM(" E:");
+	SERIAL_PROTOCOL(mm[E_AXIS]);
+
+	stepper.report_positions();
+}
+#endif
+
 /**
  * M114: Report current position to host
+ *
+ *   R = Report the steppers' position now, without waiting (Requires M114_REALTIME)
  */
 inline void gcode_M114() {
+#if ENABLED(M114_REALTIME)
+	if (parser.seen('R')) {
+		report_realtime_position();
+		return;
+	}
+#endif
 	stepper.synchronize();
 	report_current_position();
 }
@@ -2328,6 +4480,13 @@ inline void gcode_M115() {
 	// AUTOREPORT_TEMP (M155)
 	SERIAL_PROTOCOLLNPGM("Cap:AUTOREPORT_TEMP:1");
 
+	// BINARY_STATUS (M277)
+#if ENABLED(BINARY_STATUS_REPORT)
+	SERIAL_PROTOCOLLNPGM("Cap:BINARY_STATUS:1");
+#else
+	SERIAL_PROTOCOLLNPGM("Cap:BINARY_STATUS:0");
+#endif
+
 	// PROGRESS (M530 S L, M531 <file>, M532 X L)
 	SERIAL_PROTOCOLLNPGM("Cap:PROGRESS:0");
 
@@ -2351,90 +4510,439 @@ inline void gcode_M115() {
 	SERIAL_PROTOCOLLNPGM("Cap:CASE_LIGHT_BRIGHTNESS:0");
 
 	// EMERGENCY_PARSER (M108, M112, M410)
+#if ENABLED(EMERGENCY_PARSER)
+	SERIAL_PROTOCOLLNPGM("Cap:EMERGENCY_PARSER:1");
+#else
 	SERIAL_PROTOCOLLNPGM("Cap:EMERGENCY_PARSER:0");
+#endif
+}
+
+/**
+ * M117: Set LCD Status Message
+ */
+inline void gcode_M117() { lcd::set_status(parser.string_arg); }
+
+/**
+ * M118: Display a message in the host console.
+ *
+ *  A  Append '// ' for an action command, as in OctoPrint
+ *  E  Have the host 'echo:' the text
+ */
+inline void gcode_M118() {
+	if (parser.boolval('E')) SERIAL_ECHO_START();
+	if (parser.boolval('A')) SERIAL_ECHOPGM("// ");
+	SERIAL_ECHOLN(parser.string_arg);
+}
+
+/**
+ * M119: Output endstop states to serial output
+ */
+inline void gcode_M119() { endstops.M119(); }
+
+/**
+ * M120: Enable endstops and set non-homing endstop state to "enabled"
+ */
+inline void gcode_M120() { endstops.enable_globally(true); }
+
+/**
+ * M121: Disable endstops and set non-homing endstop state to "disabled"
+ */
+inline void gcode_M121() { endstops.enable_globally(false); }
+
+/**
+ * M200: Set filament diameter and set E axis units to cubic units
+ *
+ *    T<extruder> - Optional extruder number. Current extruder if omitted.
+ *    D<linear> - Diameter of the filament. Use "D0" to switch back to linear units on the E axis.
+ *    L<mm³/s>  - The most filament the hotend melts per second, 0 for no limit. (Requires VOLUMETRIC_EXTRUDER_LIMIT)
+ */
+inline void gcode_M200() {
+
+	if (get_target_extruder_from_command(200)) return;
+
+#if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+	if (parser.seenval('L')) {
+		const float limit = parser.value_float();
+		planner.volumetric_extruder_limit[target_extruder] = max(limit, 0.0f);
+	}
+#endif
+
+	if (parser.seen('D')) {
+		// setting any extruder filament size disables volumetric on the assumption that
+		// slicers either generate in extruder values as cubic mm or as as filament feeds
+		// for all extruders
+		volumetric_enabled = (parser.value_linear_units() != 0.0);
+		if (volumetric_enabled) {
+			filament_size[target_extruder] = parser.value_linear_units();
+			// make sure all extruders have some sane value for the filament size
+			for (uint8_t i = 0; i < COUNT(filament_size); i++)
+				if (!filament_size[i]) filament_size[i] = DEFAULT_NOMINAL_FILAMENT_DIA;
+		}
+	}
+	calculate_volumetric_multipliers();
+}
+
+/**
+ * M201: Set max acceleration in units/s^2 for print moves (M201 X1000 Y1000)
+ *
+ *       With multiple extruders use T to specify which one.
+ */
+inline void gcode_M201() {
+
+	GET_TARGET_EXTRUDER(201);
+
+	LOOP_XYZE(i) {
+		if (parser.seen(axis_codes[i])) {
+			const uint8_t a = i + (i == E_AXIS ? TARGET_EXTRUDER : 0);
+			const float result = parser.value_axis_units(AxisEnum(a));
+			if (result > 0) planner.max_acceleration_mm_per_s2[a] = result;
+		}
+	}
+	// steps per sq second need to be updated to agree with the units per sq second (as they are what is used in the planner)
+	planner.reset_acceleration_rates();
+}
+
+#if ENABLED(STEP_TRACE)
+/**
+ * M295: Print the step trace
+ *
+ *   S<count> = Record every <count>th stepper ISR instead, or stop recording with S0
+ */
+inline void gcode_M295() {
+	if (parser.seen('S'))
+		stepper.set_step_trace_interval(parser.value_byte());
+	else
+		stepper.report_step_trace();
 }
+#endif
 
+#if ENABLED(THERMAL_TELEMETRY)
 /**
- * M117: Set LCD Status Message
+ * M294: Send the thermal telemetry
+ *
+ *   S<ms> = Record a sample every <ms> milliseconds instead, 0 to stop
  */
-inline void gcode_M117() { lcd::set_status(parser.string_arg); }
+inline void gcode_M294() {
+	if (parser.seen('S'))
+		Temperature::set_telemetry_interval(parser.value_ushort());
+	else
+		Temperature::report_telemetry();
+}
+#endif
 
+#if ENABLED(PLANNER_PROFILING)
 /**
- * M118: Display a message in the host console.
+ * M296: Report planner profiling
  *
- *  A  Append '// ' for an action command, as in OctoPrint
- *  E  Have the host 'echo:' the text
+ *   R = Reset the counters instead
  */
-inline void gcode_M118() {
-	if (parser.boolval('E')) SERIAL_ECHO_START();
-	if (parser.boolval('A')) SERIAL_ECHOPGM("// ");
-	SERIAL_ECHOLN(parser.string_arg);
+inline void gcode_M296() {
+	if (parser.seen('R'))
+		planner.reset_profile();
+	else
+		planner.report_profile();
 }
+#endif
 
+#if ENABLED(ISR_PROFILING)
 /**
- * M119: Output endstop states to serial output
+ * M297: Report interrupt handler timing
+ *
+ *   R = Reset the counters instead
  */
-inline void gcode_M119() { endstops.M119(); }
+inline void gcode_M297() {
+	if (parser.seen('R'))
+		interrupts::reset_isr_timing();
+	else
+		interrupts::report_isr_timing();
+}
+#endif
 
+#if ENABLED(LOOP_LATENCY_HISTOGRAM)
 /**
- * M120: Enable endstops and set non-homing endstop state to "enabled"
+ * M283: Report how long loop() passes take
+ *
+ *   R = Reset the histogram instead
+ *
+ *   Gives the passes in each power-of-two bin of microseconds, the longest with its
+ *   command, and how many left the planner to run dry with commands still waiting.
  */
-inline void gcode_M120() { endstops.enable_globally(true); }
+inline void gcode_M283() {
+	if (parser.seen('R'))
+		profiling::reset_latency();
+	else
+		profiling::report_latency();
+}
+#endif
 
+#if ENABLED(STACK_PAINTING)
 /**
- * M121: Disable endstops and set non-homing endstop state to "disabled"
+ * M284: Report the stack's high-water mark
+ *
+ *   R = Paint the stack again afterwards, to measure from here on
+ *
+ *   Reports the most the stack has held since it was painted, the bytes between it
+ *   and the heap it never reached, and the free memory now.
  */
-inline void gcode_M121() { endstops.enable_globally(false); }
+inline void gcode_M284() {
+	SERIAL_ECHO_START();
+	SERIAL_ECHOPAIR("Stack peak:", sram::stack_peak());
+	SERIAL_ECHOPAIR(" unused:", sram::stack_unused());
+#if ENABLED(SCRATCH_ARENA)
+	SERIAL_ECHOPAIR(" scratch peak:", scratch_arena.peak());
+#endif
+	SERIAL_ECHOLNPAIR(" free:", freeMemory());
+	if (parser.seen('R'))
+		sram::repaint_stack();
+}
+#endif
+
+#if ENABLED(MATH_BENCHMARK)
+namespace math_benchmark {
+	// Read through volatiles, so the calls can't be folded or hoisted out of the loops
+	volatile float float_inputs[8] = { 0.0004f, 0.73f, 1.0f, 2.5f, 17.3f, 240.0f, 9801.0f, 1.6e6f };
+	volatile uint32 int_inputs[8] = { 0, 3, 255, 4096, 77777, 1000000, 1UL << 24, 0xFFFFFFFFUL };
+	volatile float float_sink;
+	volatile uint32 int_sink;
+
+	// CPU cycles of one call of 'function', less those of 'baseline'
+	template <typename F>
+	uint32 cycles(const uint16 count, const uint32 baseline, F && function) {
+		const uint32 start_us = micros();
+		for (uint16 i = 0; i < count; ++i)
+			function(i & 7);
+		const uint32 total = (micros() - start_us) * uint32(F_CPU / 1000000UL) / count;
+		return total > baseline ? total - baseline : 0;
+	}
+
+	void report(const char * __restrict name_P, const uint32 cycles) {
+		SERIAL_ECHO_START();
+		serialprintPGM(name_P);
+		SERIAL_ECHOLNPAIR(":", cycles);
+	}
+}
 
 /**
- * M200: Set filament diameter and set E axis units to cubic units
+ * M285: Time the square roots
  *
- *    T<extruder> - Optional extruder number. Current extruder if omitted.
- *    D<linear> - Diameter of the filament. Use "D0" to switch back to linear units on the E axis.
+ *   S<count> = Calls of each to time (default 1000)
+ *
+ *   Reports CPU cycles per call, less the loop's own.
  */
-inline void gcode_M200() {
+inline void gcode_M285() {
+	using namespace math_benchmark;
 
-	if (get_target_extruder_from_command(200)) return;
+	const uint16 count = max(parser.ushortval('S', 1000), uint16(1));
+	stepper.synchronize();
 
-	if (parser.seen('D')) {
-		// setting any extruder filament size disables volumetric on the assumption that
-		// slicers either generate in extruder values as cubic mm or as as filament feeds
-		// for all extruders
-		volumetric_enabled = (parser.value_linear_units() != 0.0);
-		if (volumetric_enabled) {
-			filament_size[target_extruder] = parser.value_linear_units();
-			// make sure all extruders have some sane value for the filament size
-			for (uint8_t i = 0; i < COUNT(filament_size); i++)
-				if (!filament_size[i]) filament_size[i] = DEFAULT_NOMINAL_FILAMENT_DIA;
+	const uint32 float_loop = cycles(count, 0, [](uint8 i) { float_sink = float_inputs[i]; });
+	const uint32 int_loop = cycles(count, 0, [](uint8 i) { int_sink = int_inputs[i]; });
+
+	SERIAL_ECHOLNPGM("Square root cycles:");
+	report(PSTR("sqrt"), cycles(count, float_loop, [](uint8 i) { float_sink = sqrt(float_inputs[i]); }));
+	report(PSTR("1/sqrt"), cycles(count, float_loop, [](uint8 i) { float_sink = 1.0f / sqrt(float_inputs[i]); }));
+	report(PSTR("rsqrt<1>"), cycles(count, float_loop, [](uint8 i) { float_sink = Tuna::rsqrt<1>(float_inputs[i]); }));
+	report(PSTR("rsqrt<2>"), cycles(count, float_loop, [](uint8 i) { float_sink = Tuna::rsqrt<2>(float_inputs[i]); }));
+	report(PSTR("rsqrt<3>"), cycles(count, float_loop, [](uint8 i) { float_sink = Tuna::rsqrt<3>(float_inputs[i]); }));
+	report(PSTR("fast_sqrt<2>"), cycles(count, float_loop, [](uint8 i) { float_sink = Tuna::fast_sqrt<2>(float_inputs[i]); }));
+	report(PSTR("isqrt"), cycles(count, int_loop, [](uint8 i) { int_sink = fixed_math::isqrt(int_inputs[i]); }));
+	report(PSTR("isqrt24"), cycles(count, int_loop, [](uint8 i) { int_sink = fixed_math::isqrt24(uint24(int_inputs[i])); }));
+}
+#endif
+
+#if ENABLED(TRAVEL_JERK)
+/**
+ * M286: Set the travel jerk
+ *
+ *   X<units/s> = X jerk of moves that don't extrude
+ *   Y<units/s> = Y jerk
+ *   Z<units/s> = Z jerk
+ *   J<units>   = Junction deviation between two travels (Requires JUNCTION_DEVIATION)
+ *
+ *   Reports the settings.
+ */
+inline void gcode_M286() {
+	LOOP_XYZ(i) {
+		if (parser.seen(axis_codes[i])) {
+			const float jerk = parser.value_linear_units();
+			if (jerk >= 0)
+				planner.travel_jerk[i] = jerk;
+			else {
+				SERIAL_ERROR_START();
+				SERIAL_ERRORLNPGM("?Jerk can't be negative");
+			}
 		}
 	}
-	calculate_volumetric_multipliers();
+#if ENABLED(JUNCTION_DEVIATION)
+	if (parser.seen('J')) {
+		const float junc_dev_mm = parser.value_linear_units();
+		if (WITHIN(junc_dev_mm, 0.01f, 0.3f))
+			planner.travel_junction_deviation_mm = junc_dev_mm;
+		else {
+			SERIAL_ERROR_START();
+			SERIAL_ERRORLNPGM("?J out of range (0.01 to 0.3)");
+		}
+	}
+#endif
+	SERIAL_ECHO_START();
+	SERIAL_ECHOPAIR("Travel jerk: X", planner.travel_jerk[X_AXIS]);
+	SERIAL_ECHOPAIR(" Y", planner.travel_jerk[Y_AXIS]);
+#if ENABLED(JUNCTION_DEVIATION)
+	SERIAL_ECHOPAIR(" Z", planner.travel_jerk[Z_AXIS]);
+	SERIAL_ECHOLNPAIR(" J", planner.travel_junction_deviation_mm);
+#else
+	SERIAL_ECHOLNPAIR(" Z", planner.travel_jerk[Z_AXIS]);
+#endif
 }
+#endif
 
+#if ENABLED(ARC_SUPPORT)
 /**
- * M201: Set max acceleration in units/s^2 for print moves (M201 X1000 Y1000)
+ * M287: Set the arc segmentation
  *
- *       With multiple extruders use T to specify which one.
+ *   S<mm> = Most a segment may cut inside its arc. 0 for segments of MM_PER_ARC_SEGMENT.
+ *   P<mm> = Shortest segment
+ *   Q<mm> = Longest segment
+ *
+ *   Reports the settings, which are kept unless all of them hold together.
  */
-inline void gcode_M201() {
+inline void gcode_M287() {
+	const float tolerance = parser.seen('S') ? parser.value_linear_units() : arc_chord_tolerance,
+		min_mm = parser.seen('P') ? parser.value_linear_units() : arc_segment_min_mm,
+		max_mm = parser.seen('Q') ? parser.value_linear_units() : arc_segment_max_mm;
+	if (tolerance >= 0 && min_mm > 0 && max_mm >= min_mm) {
+		arc_chord_tolerance = tolerance;
+		arc_segment_min_mm = min_mm;
+		arc_segment_max_mm = max_mm;
+	}
+	else {
+		SERIAL_ERROR_START();
+		SERIAL_ERRORLNPGM("?S must be 0 or more, and P above 0 and no more than Q");
+	}
+	SERIAL_ECHO_START();
+	SERIAL_ECHOPAIR("Arc segments: S", arc_chord_tolerance);
+	SERIAL_ECHOPAIR(" P", arc_segment_min_mm);
+	SERIAL_ECHOLNPAIR(" Q", arc_segment_max_mm);
+}
+#endif
 
-	GET_TARGET_EXTRUDER(201);
+#if ENABLED(SD_BENCHMARK)
+/**
+ * M288: Benchmark the SD card
+ *
+ *   S<blocks> = Blocks to read raw from the start of the card, and bytes / 512
+ *               of the selected file to read with SdBaseFile::read() and get().
+ *               Default 1024.
+ *
+ *   Reports the raw kB/s and the block read latencies, then the file kB/s and
+ *   get() bytes/s, if a file was selected with M23.
+ */
+inline void gcode_M288() {
+	if (!card.cardOK || card.sdprinting || card.saving) {
+		SERIAL_ERROR_START();
+		SERIAL_ERRORLNPGM(MSG_SD_BENCHMARK_BUSY);
+		return;
+	}
+	card.benchmark(parser.ushortval('S', 1024));
+}
+#endif
 
-	LOOP_XYZE(i) {
-		if (parser.seen(axis_codes[i])) {
-			const uint8_t a = i + (i == E_AXIS ? TARGET_EXTRUDER : 0);
-      float result = parser.value_axis_units(AxisEnum(a));
-			planner.max_acceleration_mm_per_s2[a] = parser.value_axis_units(AxisEnum(a));
+#if ENABLED(SERIAL_BENCHMARK)
+/**
+ * M289: Start, stop, or report a serial benchmark
+ *
+ *   S1 = Start a dry run: lines are taken and acknowledged, not carried out
+ *   S0 = End the dry run
+ *
+ *   The lines, line errors, and lines per second since the last start are
+ *   reported in every case.
+ */
+inline void gcode_M289() {
+	if (parser.seenval('S')) {
+		if (parser.value_bool()) {
+			stepper.synchronize();
+			benchmark.lines = benchmark.errors = 0;
+			benchmark.start_ms = millis();
 		}
+		benchmark.active = parser.value_bool();
 	}
-	// steps per sq second need to be updated to agree with the units per sq second (as they are what is used in the planner)
-	planner.reset_acceleration_rates();
+
+	const millis_t elapsed_ms = millis() - benchmark.start_ms;
+	SERIAL_ECHO_START();
+	SERIAL_ECHOPAIR("Benchmark lines:", benchmark.lines);
+	SERIAL_ECHOPAIR(" errors:", benchmark.errors);
+	SERIAL_ECHOPAIR(" ms:", elapsed_ms);
+	SERIAL_ECHOLNPAIR(" lines/s:", elapsed_ms ? float(benchmark.lines) * 1000.0f / float(elapsed_ms) : 0.0f);
+}
+#endif
+
+#if ENABLED(PIPELINE_PROFILING)
+/**
+ * M291: Report G-code pipeline timing
+ *
+ *   R = Reset the counters instead
+ */
+inline void gcode_M291() {
+	if (parser.seen('R'))
+		profiling::reset();
+	else
+		profiling::report();
 }
+#endif
 
 inline void gcode_M298() {
   advanced_units_per_second = true;
 }
 
+#if ENABLED(BINARY_STREAMING)
+/**
+ * M293: Switch the host serial port to binary packets after the "ok"
+ *
+ *   See get_binary_commands() for the format
+ */
+inline void gcode_M293() {
+	binary_stream = {};
+	binary_stream.active = true;
+#if ENABLED(EMERGENCY_PARSER)
+	emergency_parser_enabled = false; // Packets are acted on as they're queued instead
+#endif
+#if ENABLED(RX_LINE_FRAMING)
+	MYSERIAL.set_line_framing(false);
+#endif
+}
+#endif
+
+#if ENABLED(SHARED_QUEUE_POOL)
+/**
+ * M292: Report how the queue pool is split between planner blocks and commands
+ *
+ *   B<blocks>  Planner blocks from the next boot, the rest going to commands. Save with M500.
+ */
+inline void gcode_M292() {
+	if (parser.seenval('B')) {
+		const uint16_t blocks = parser.value_ushort();
+		if (WITHIN(blocks, MIN_PLANNER_BLOCKS, queue_pool_max_blocks))
+			queue_pool_blocks = uint8_t(blocks);
+		else {
+			SERIAL_ERROR_START();
+			SERIAL_ERRORPGM("?B out of range (" STRINGIFY(MIN_PLANNER_BLOCKS) " to ");
+			SERIAL_ERROR(int(queue_pool_max_blocks));
+			SERIAL_ERRORLNPGM(")");
+		}
+	}
+	SERIAL_ECHO_START();
+	SERIAL_ECHOPAIR("Queue pool: ", int(planner.block_buffer_size()));
+	SERIAL_ECHOPAIR(" blocks, ", int(command_queue_size));
+	SERIAL_ECHOPGM(" commands");
+	if (queue_pool_blocks != planner.block_buffer_size()) {
+		SERIAL_ECHOPAIR(" (next boot: ", int(queue_pool_blocks));
+		SERIAL_ECHOPAIR(" blocks, ", int(queue_pool_commands(queue_pool_blocks)));
+		SERIAL_ECHOPGM(" commands)");
+	}
+	SERIAL_EOL();
+}
+#endif
+
 inline void gcode_M299() {
   advanced_units_per_second = false;
 }
@@ -2456,8 +4964,10 @@ inline void gcode_M203() {
       {
         result /= 60;
       }
-      planner.max_feedrate_mm_s[a] = result;
+      if (result > 0) planner.max_feedrate_mm_s[a] = result; // The planner keeps its reciprocal
 		}
+	// the cached reciprocals of the feedrate limits need to be updated as well
+	planner.reset_acceleration_rates();
 }
 
 /**
@@ -2498,6 +5008,7 @@ inline void gcode_M204() {
  *    Y = Max Y Jerk (units/sec^2)
  *    Z = Max Z Jerk (units/sec^2)
  *    E = Max E Jerk (units/sec^2)
+ *    J = Junction Deviation (units) (Requires JUNCTION_DEVIATION)
  */
 inline void gcode_M205() {
 	if (parser.seen('S')) planner.min_feedrate_mm_s = parser.value_linear_units();
@@ -2507,6 +5018,17 @@ inline void gcode_M205() {
 	if (parser.seen('Y')) planner.max_jerk[Y_AXIS] = parser.value_linear_units();
 	if (parser.seen('Z')) planner.max_jerk[Z_AXIS] = parser.value_linear_units();
 	if (parser.seen('E')) planner.max_jerk[E_AXIS] = parser.value_linear_units();
+#if ENABLED(JUNCTION_DEVIATION)
+	if (parser.seen('J')) {
+		const float junc_dev_mm = parser.value_linear_units();
+		if (WITHIN(junc_dev_mm, 0.01f, 0.3f))
+			planner.junction_deviation_mm = junc_dev_mm;
+		else {
+			SERIAL_ERROR_START();
+			SERIAL_ERRORLNPGM("?J out of range (0.01 to 0.3)");
+		}
+	}
+#endif
 }
 
 /**
@@ -2545,11 +5067,23 @@ inline void gcode_M211() {
 	SERIAL_ECHOLNPAIR(" " MSG_Z, soft_endstop_max[Z_AXIS]);
 }
 
+/**
+ * Set feedrate_percentage. With LIVE_SPEED_OVERRIDE the change also applies to
+ * the moves already in the planner, not just to the ones queued after it.
+ */
+void set_feedrate_percentage(const int16_t percentage) {
+#if ENABLED(LIVE_SPEED_OVERRIDE)
+	if (percentage > 0 && feedrate_percentage > 0 && percentage != feedrate_percentage)
+		planner.rescale_queued_speeds(float(percentage) / float(feedrate_percentage));
+#endif
+	feedrate_percentage = percentage;
+}
+
 /**
  * M220: Set speed percentage factor, aka "Feed Rate" (M220 S95)
  */
 inline void gcode_M220() {
-	if (parser.seenval('S')) feedrate_percentage = parser.value_int();
+	if (parser.seenval('S')) set_feedrate_percentage(parser.value_int());
 }
 
 /**
@@ -2557,8 +5091,10 @@ inline void gcode_M220() {
  */
 inline void gcode_M221() {
 	if (get_target_extruder_from_command(221)) return;
-	if (parser.seenval('S'))
+	if (parser.seenval('S')) {
 		flow_percentage[target_extruder] = parser.value_int();
+		planner.refresh_e_factor(target_extruder);
+	}
 }
 
 /**
@@ -2633,6 +5169,33 @@ inline void gcode_M301() {
 #endif
 }
 
+#if ENABLED(PIDTEMPBED)
+
+/**
+ * M304: Set bed PID parameters P I and D
+ *
+ *   P[float] Kp term
+ *   I[float] Ki term, per second
+ *   D[float] Kd term, in seconds
+ *
+ *  Without parameters, reports the current values.
+ */
+inline void gcode_M304() {
+	auto calib = Tuna::Thermal::BedManager::GetCalibration();
+	if (parser.seen('P')) calib.Kp = parser.value_float();
+	if (parser.seen('I')) calib.Ki = parser.value_float();
+	if (parser.seen('D')) calib.Kd = parser.value_float();
+	Tuna::Thermal::BedManager::SetCalibration(calib);
+
+	SERIAL_ECHO_START();
+	SERIAL_ECHOPAIR(" p:", calib.Kp);
+	SERIAL_ECHOPAIR(" i:", calib.Ki);
+	SERIAL_ECHOPAIR(" d:", calib.Kd);
+	SERIAL_EOL();
+}
+
+#endif // PIDTEMPBED
+
 /**
  * M302: Allow cold extrudes, or set the minimum extrude temperature
  *
@@ -2673,6 +5236,10 @@ inline void gcode_M302() {
  *       E<extruder> (-1 for the bed) (default 0)
  *       C<cycles>
  *       U<bool> with a non-zero value will apply the result to current settings
+ *       F       measures the part fan feed-forward at S instead (hotend only)
+ *
+ *  Returns once the calibration has started. It runs in the background from then on,
+ *  and setting another target for the heater being tuned cancels it.
  */
 inline void gcode_M303() {
 	const int e = parser.intval('E'), c = parser.intval('C', 5);
@@ -2685,7 +5252,10 @@ inline void gcode_M303() {
 
 	KEEPALIVE_STATE(NOT_BUSY); // don't send "busy: processing" messages during autotune output
 
-  Temperature::PID_autotune(temp, c, u);
+	if (parser.seen('F'))
+		Tuna::Thermal::FanCompensation::calibrate(temp);
+	else
+		Temperature::PID_autotune(temp, int8(constrain(e, -1, HOTENDS - 1)), c, u);
 
 	KEEPALIVE_STATE(IN_HANDLER);
 }
@@ -2742,6 +5312,63 @@ inline void gcode_M428() {
 	}
 }
 
+#if ENABLED(MESH_COMPENSATION)
+
+/**
+ * M420: Turn mesh compensation on or off
+ *
+ *   S<bool> Turn it on (S1) or off (S0)
+ *   V       Print the mesh, a row per line from the front
+ */
+inline void gcode_M420() {
+	if (parser.seen('S')) set_bed_leveling_enabled(parser.value_bool());
+
+	if (parser.seen('V')) {
+		for (uint8_t row = 0; row < mesh::points_y; ++row) {
+			for (uint8_t column = 0; column < mesh::points_x; ++column) {
+				SERIAL_PROTOCOLCHAR(' ');
+				SERIAL_PROTOCOL_F(mesh::z_um[row][column] * 0.001f, 3);
+			}
+			SERIAL_EOL();
+		}
+	}
+
+	SERIAL_ECHO_START();
+	if (mesh::active) SERIAL_ECHOLNPGM("Bed Leveling On");
+	else SERIAL_ECHOLNPGM("Bed Leveling Off");
+}
+
+/**
+ * M421: Set one point of the mesh
+ *
+ *   I<column> J<row> The point, from the front left
+ *   Z<linear>        Its height
+ *   Q<linear>        Or an amount to add to it
+ */
+inline void gcode_M421() {
+	const int8_t column = parser.seenval('I') ? parser.value_int() : -1,
+	             row = parser.seenval('J') ? parser.value_int() : -1;
+	const bool has_z = parser.seenval('Z'), has_q = !has_z && parser.seenval('Q');
+
+	if (!WITHIN(column, 0, mesh::points_x - 1) || !WITHIN(row, 0, mesh::points_y - 1) || !(has_z || has_q)) {
+		SERIAL_ERROR_START();
+		SERIAL_ERRORLNPGM(MSG_ERR_MESH_XY);
+		return;
+	}
+
+	const float z = parser.value_linear_units() + (has_q ? mesh::z_um[row][column] * 0.001f : 0.0f);
+	const int16_t z_um = int16_t(constrain(LROUND(z * 1000.0f), -mesh::limit_um, mesh::limit_um));
+
+	// A point under the planner's queue would shift the moves already planned
+	const bool was_active = mesh::active;
+	set_bed_leveling_enabled(false);
+	mesh::z_um[row][column] = z_um;
+	mesh::changed();
+	set_bed_leveling_enabled(was_active);
+}
+
+#endif // MESH_COMPENSATION
+
 /**
  * M500: Store settings in EEPROM
  */
@@ -2756,19 +5383,148 @@ inline void gcode_M501() {
 	(void)settings.load();
 }
 
-/**
- * M502: Revert to default settings
- */
-inline void gcode_M502() {
-	(void)settings.reset();
-}
+/**
+ * M502: Revert to default settings
+ */
+inline void gcode_M502() {
+	(void)settings.reset();
+}
+
+/**
+ * M503: print settings currently in memory
+ */
+inline void gcode_M503() {
+	(void)settings.report(!parser.boolval('S', true));
+}
+
+#if ENABLED(SETTINGS_PROFILES)
+/**
+ * M506: Switch settings profiles
+ *
+ *   P<profile> = The profile to load, which M500 and M501 then use, and which the printer boots with
+ *   S          = Save the current settings to the profile instead, e.g. to start a new one
+ *
+ * With no P, report the active profile. A profile never saved loads the defaults.
+ */
+inline void gcode_M506() {
+	if (!parser.seenval('P')) {
+		SERIAL_ECHO_START();
+		SERIAL_ECHOLNPAIR(MSG_SETTINGS_PROFILE, settings.profile());
+		return;
+	}
+
+	const uint8_t profile = parser.value_byte();
+	if (profile >= SETTINGS_PROFILE_COUNT) {
+		SERIAL_ERROR_START();
+		SERIAL_ERRORLNPGM(MSG_ERR_SETTINGS_PROFILE);
+		return;
+	}
+
+	settings.select_profile(profile);
+	if (parser.seen('S'))
+		(void)settings.save();
+	else {
+		stepper.synchronize(); // Steps per mm and the like can't change under planned moves
+		(void)settings.load();
+	}
+}
+#endif
+
+#if ENABLED(BAUD_RATE_GCODE)
+/**
+ * M575: Change the host baud rate
+ *
+ *   B<baud>  A rate F_CPU makes to within 2.5%, such as 115200, 250000, 500000 or 1000000
+ *
+ * The "ok" goes out at the old rate, then the port switches. If no good line or
+ * packet arrives at the new rate within BAUD_RATE_FALLBACK seconds, it goes back.
+ * Prints its own "ok".
+ */
+inline void gcode_M575() {
+	const uint32_t baud = parser.ulongval('B');
+	if (!uart::usable(baud)) {
+		SERIAL_ERROR_START();
+		SERIAL_ERRORLNPGM("?B is not a usable baud rate");
+		ok_to_send();
+		return;
+	}
+
+	SERIAL_ECHO_START();
+	SERIAL_ECHOLNPAIR("Baud rate: ", baud);
+	ok_to_send();
+
+	if (baud == host_baud) return;
+	fallback_baud = host_baud;
+	set_host_baud(baud);
+	baud_fallback_ms = millis() + (BAUD_RATE_FALLBACK) * 1000UL;
+}
+#endif
+
+#if ENABLED(INPUT_SHAPING)
+/**
+ * M593: Set the input shaping
+ *
+ *   X or Y    = The axis to set. Without either, both.
+ *   F<hz>     = The ringing frequency, 10 to 200, or 0 to turn the shaper off
+ *   D<zeta>   = The damping ratio, 0 to 0.9
+ *   T<type>   = 0 for ZV, 1 for MZV
+ *
+ *   Waits for the moves before it, then reports the settings.
+ */
+inline void gcode_M593() {
+	const bool seen_x = parser.seen('X'), seen_y = parser.seen('Y');
+	const bool axes[2] = { seen_x || !seen_y, seen_y || !seen_x };
+
+	bool changed = false;
+	const auto set = [&](float (&setting)[2], const float value) {
+		for (uint8 a = X_AXIS; a <= Y_AXIS; ++a) if (axes[a]) setting[a] = value;
+		changed = true;
+	};
+
+	if (parser.seen('F')) {
+		const float frequency = parser.value_float();
+		if (frequency == 0 || WITHIN(frequency, 10, 200))
+			set(stepper.shaping_frequency, frequency);
+		else {
+			SERIAL_ERROR_START();
+			SERIAL_ERRORLNPGM("?F must be 0 or 10 to 200");
+		}
+	}
+	if (parser.seen('D')) {
+		const float zeta = parser.value_float();
+		if (WITHIN(zeta, 0, 0.9f))
+			set(stepper.shaping_zeta, zeta);
+		else {
+			SERIAL_ERROR_START();
+			SERIAL_ERRORLNPGM("?D must be 0 to 0.9");
+		}
+	}
+	if (parser.seen('T')) {
+		const uint8 type = parser.value_byte();
+		if (type <= 1) {
+			for (uint8 a = X_AXIS; a <= Y_AXIS; ++a) if (axes[a]) stepper.shaping_type[a] = type;
+			changed = true;
+		}
+		else {
+			SERIAL_ERROR_START();
+			SERIAL_ERRORLNPGM("?T must be 0 (ZV) or 1 (MZV)");
+		}
+	}
+
+	if (changed) stepper.refresh_shaping();
 
-/**
- * M503: print settings currently in memory
- */
-inline void gcode_M503() {
-	(void)settings.report(!parser.boolval('S', true));
+	for (uint8 a = X_AXIS; a <= Y_AXIS; ++a) {
+		if (!axes[a]) continue;
+		SERIAL_ECHO_START();
+		SERIAL_ECHOPGM("Input shaping ");
+		SERIAL_CHAR(axis_codes[a]);
+		SERIAL_ECHOPAIR(": F", stepper.shaping_frequency[a]);
+		SERIAL_ECHOPAIR(" D", stepper.shaping_zeta[a]);
+		serialprintPGM(stepper.shaping_type[a] ? PSTR(" MZV") : PSTR(" ZV"));
+		SERIAL_EOL();
+	}
 }
+#endif
 
 /**
  * M907: Set digital trimpot motor current using axis codes X, Y, Z, E, B, S
@@ -2854,8 +5610,14 @@ inline void gcode_T(uint8_t tmp_extruder) {
  * This is called from the main loop()
  */
 void __forceinline __flatten process_next_command() {
-	char * const current_command = command_queue[cmd_queue_index_r];
+#if ENABLED(PIPELINE_PROFILING)
+	const profiling::command_timer command_timer;
+#endif
+	char * const current_command = queued_command_text();
 
+#if ENABLED(PARSED_COMMAND_QUEUE)
+	if (current_command)
+#endif
 	if (__unlikely(DEBUGGING(ECHO))) {
 		SERIAL_ECHO_START();
 		SERIAL_ECHOLN(current_command);
@@ -2863,20 +5625,99 @@ void __forceinline __flatten process_next_command() {
 
 	KEEPALIVE_STATE(IN_HANDLER);
 
+#if ENABLED(PIPELINE_PROFILING)
+	const uint32 parse_start_us = micros();
+#endif
+
 	// Parse the next command in the queue
+#if ENABLED(FAST_LINEAR_MOVES)
+	// A plain G0/G1 line has its words read straight off; only the code goes to the parser
+#if ENABLED(PREFETCH_LINEAR_MOVES)
+	int8_t fast_move;
+	if (prefetched_line == current_command) {
+		fast_move = prefetched_move.code;
+		linear_move_words = prefetched_move.words;
+	}
+	else
+		fast_move = scan_linear_move(current_command);
+	prefetched_line = nullptr;
+#else
+	const int8_t fast_move = current_command ? scan_linear_move(current_command) : -1;
+#endif
+	if (fast_move >= 0) {
+		parser.reset();
+		parser.command_letter = 'G';
+		parser.codenum = fast_move;
+		parser.command_ptr = current_command;
+	}
+	else
+#endif
+#if ENABLED(PARSED_COMMAND_QUEUE)
+	if (!current_command) {
+		// Already parsed when it was queued
+		parser.parse(command_queue[cmd_queue_index_r]);
+		if (__unlikely(DEBUGGING(ECHO))) {
+			SERIAL_ECHO_START();
+			parser.print_command();
+			SERIAL_EOL();
+		}
+	}
+	else
+#endif
 	parser.parse(current_command);
 
+#if ENABLED(PIPELINE_PROFILING)
+	profiling::add(profiling::section::parse, parse_start_us);
+#endif
+
+#if ENABLED(SERIAL_BENCHMARK)
+	// A dry run reads, checks and parses every line, but only carries out M289
+	if (__unlikely(benchmark.active) && !(parser.command_letter == 'M' && parser.codenum == 289)) {
+		++benchmark.lines;
+		KEEPALIVE_STATE(NOT_BUSY);
+		ok_to_send();
+		return;
+	}
+#endif
+
+#if ENABLED(STEP_QUEUE_MODE)
+	// The step queues have the motors. A move would sit in the planner until M278 S0.
+	if (__unlikely(stepper.step_queue_active) && parser.command_letter == 'G') {
+		SERIAL_ERROR_START();
+		SERIAL_ERRORLNPGM("Step queues have the motors");
+		ok_to_send();
+		return;
+	}
+#endif
+
+#if ENABLED(MOVE_COALESCING)
+	// Any other command expects every earlier move to be in the planner
+	if (!is_linear_move_command()) flush_coalesced_move();
+#endif
+
+	// G0 and G1 are nearly every line of a print. Take them first, at a fixed cost, rather than
+	// after the letter switch and the G jump table. The M codes are too sparse for a table, so
+	// the compiler builds them a compare tree that the hot path shouldn't have to share.
+#if ENABLED(FAST_LINEAR_MOVES)
+	if (__likely(fast_move >= 0)) {
+		if (fast_move == 0)
+			linear_move<MovementType::Rapid, MovementMode::Modal, MovementMode::Modal, fast_words>();
+		else
+			linear_move<MovementType::Linear, MovementMode::Modal, MovementMode::Modal, fast_words>();
+	}
+	else
+#endif
+	if (__likely(parser.command_letter == 'G') && __likely(uint16_t(parser.codenum) <= 1)) {
+		if (parser.codenum == 0)
+			linear_move<MovementType::Rapid>();
+		else
+			linear_move<MovementType::Linear>();
+	}
 	// Handle a known G, M, or T
-	switch (parser.command_letter) {
+	else switch (parser.command_letter) {
 	case 'G': switch (parser.codenum) {
 
-		// G0, G1
-	case 0:
-    linear_move<MovementType::Rapid>();
-    break;
-	case 1:
-		linear_move<MovementType::Linear>();
-		break;
+		// G0, G1 are handled above
 
 #if ENABLED(FWRETRACT)
   case 10: // G10: retract
@@ -2888,11 +5729,13 @@ void __forceinline __flatten process_next_command() {
 #endif // FWRETRACT
 
 
+#if ENABLED(ARC_SUPPORT)
 		// G2, G3
-	//case 2: // G2  - CW ARC
-	//case 3: // G3  - CCW ARC
-	//	gcode_G2_G3(parser.codenum == 2);
-	//	break;
+	case 2: // G2  - CW ARC
+	case 3: // G3  - CCW ARC
+		gcode_G2_G3(parser.codenum == 2);
+		break;
+#endif
 
 		// G4 Dwell
 	case 4:
@@ -3000,6 +5843,10 @@ void __forceinline __flatten process_next_command() {
 	case 42: // M42: Change pin state
 		gcode_M42(); break;
 
+#if ENABLED(PRINT_TIME_ESTIMATE)
+	case 73: // M73: Set the print progress
+		gcode_M73(); break;
+#endif
 	case 75: // M75: Start print timer
 		gcode_M75(); break;
 	case 76: // M76: Pause print timer
@@ -3133,6 +5980,114 @@ void __forceinline __flatten process_next_command() {
 		gcode_M206();
 		break;
 
+#if ENABLED(JOB_QUEUE)
+  case 276: // M276: Start, end or report a job queue
+    gcode_M276();
+    break;
+#endif
+
+#if ENABLED(BINARY_STATUS_REPORT)
+  case 277: // M277: Send a binary status frame or set its rate
+    gcode_M277();
+    break;
+#endif
+
+#if ENABLED(STEP_QUEUE_MODE)
+  case 278: // M278: Start, stop or report the step queues
+    gcode_M278();
+    break;
+#endif
+
+#if ENABLED(MOTION_SYNC_EVENTS)
+  case 279: // M279: Report a marker where the motion reaches it
+    gcode_M279();
+    break;
+#endif
+
+#if ENABLED(LOOP_LATENCY_HISTOGRAM)
+  case 283: // M283: Report or reset the loop() latency histogram
+    gcode_M283();
+    break;
+#endif
+
+#if ENABLED(STACK_PAINTING)
+  case 284: // M284: Report the stack's high-water mark
+    gcode_M284();
+    break;
+#endif
+
+#if ENABLED(MATH_BENCHMARK)
+  case 285: // M285: Time the square roots
+    gcode_M285();
+    break;
+#endif
+
+#if ENABLED(TRAVEL_JERK)
+  case 286: // M286: Set the travel jerk
+    gcode_M286();
+    break;
+#endif
+
+#if ENABLED(ARC_SUPPORT)
+  case 287: // M287: Set the arc segmentation
+    gcode_M287();
+    break;
+#endif
+
+#if ENABLED(SD_BENCHMARK)
+  case 288: // M288: Benchmark the SD card
+    gcode_M288();
+    break;
+#endif
+
+#if ENABLED(SERIAL_BENCHMARK)
+  case 289: // M289: Start, stop, or report a serial benchmark
+    gcode_M289();
+    break;
+#endif
+
+#if ENABLED(PIPELINE_PROFILING)
+  case 291: // M291: Report or reset G-code pipeline timing
+    gcode_M291();
+    break;
+#endif
+
+#if ENABLED(SHARED_QUEUE_POOL)
+  case 292: // M292: Report or set the queue pool split
+    gcode_M292();
+    break;
+#endif
+
+#if ENABLED(BINARY_STREAMING)
+  case 293: // M293: Switch to binary streaming
+    gcode_M293();
+    break;
+#endif
+
+#if ENABLED(THERMAL_TELEMETRY)
+  case 294: // M294: Send the thermal telemetry or set its rate
+    gcode_M294();
+    break;
+#endif
+
+#if ENABLED(STEP_TRACE)
+  case 295: // M295: Print the step trace or set its sampling
+    gcode_M295();
+    break;
+#endif
+
+#if ENABLED(PLANNER_PROFILING)
+  case 296: // M296: Report or reset planner profiling
+    gcode_M296();
+    break;
+#endif
+
+#if ENABLED(ISR_PROFILING)
+  case 297: // M297: Report or reset interrupt handler timing
+    gcode_M297();
+    break;
+#endif
+
   case 298:
     gcode_M298();
     break;
@@ -3160,6 +6115,11 @@ void __forceinline __flatten process_next_command() {
 	case 301: // M301: Set hotend PID parameters
 		gcode_M301();
 		break;
+#if ENABLED(PIDTEMPBED)
+	case 304: // M304: Set bed PID parameters
+		gcode_M304();
+		break;
+#endif
 
 	case 302: // M302: Allow cold extrudes (set the minimum extrude temperature)
 		gcode_M302();
@@ -3173,6 +6133,15 @@ void __forceinline __flatten process_next_command() {
 		gcode_M400();
 		break;
 
+#if ENABLED(MESH_COMPENSATION)
+	case 420: // M420: Turn mesh compensation on or off
+		gcode_M420();
+		break;
+	case 421: // M421: Set one point of the mesh
+		gcode_M421();
+		break;
+#endif
+
 	case 428: // M428: Apply current_position to home_offset
 		gcode_M428();
 		break;
@@ -3191,6 +6160,25 @@ void __forceinline __flatten process_next_command() {
 		gcode_M503();
 		break;
 
+#if ENABLED(SETTINGS_PROFILES)
+	case 506: // M506: Switch settings profiles
+		gcode_M506();
+		break;
+#endif
+
+#if ENABLED(BAUD_RATE_GCODE)
+	case 575: // M575: Change the host baud rate
+		gcode_M575();
+		KEEPALIVE_STATE(NOT_BUSY);
+		return; // "ok" already printed
+#endif
+
+#if ENABLED(INPUT_SHAPING)
+	case 593: // M593: Set the input shaping
+		gcode_M593();
+		break;
+#endif
+
   case 900: // M900: Set advance K factor.
     gcode_M900();
     break;
@@ -3206,6 +6194,12 @@ void __forceinline __flatten process_next_command() {
 	case 999: // M999: Restart after being Stopped
 		gcode_M999();
 		break;
+
+#if ENABLED(POWER_LOSS_RECOVERY)
+	case 1000: // M1000: Resume an SD print after a power loss
+		gcode_M1000();
+		break;
+#endif
 	}
 			  break;
 
@@ -3228,36 +6222,28 @@ void __forceinline __flatten process_next_command() {
 void FlushSerialRequestResend() {
 	//char command_queue[cmd_queue_index_r][100]="Resend:";
 	MYSERIAL.flush();
-	SERIAL_PROTOCOLPGM(MSG_RESEND);
-	SERIAL_PROTOCOLLN(uint32(gcode_LastN + 1));
-	ok_to_send();
+	request_resend();
 }
 
 /**
  * Send an "ok" message to the host, indicating
  * that a command was successfully processed.
- *
- * If ADVANCED_OK is enabled also include:
- *   N<int>  Line number of the command, if any
- *   P<int>  Planner space remaining
- *   B<int>  Block queue space remaining
  */
 void ok_to_send() {
 	refresh_cmd_timeout();
 	if (!send_ok[cmd_queue_index_r]) return;
-	SERIAL_PROTOCOLPGM(MSG_OK);
+#if ENABLED(PARSED_COMMAND_QUEUE)
+	const ParsedCommand &command = command_queue[cmd_queue_index_r];
+	if (command.letter) {
+		print_ok(nullptr
 #if ENABLED(ADVANCED_OK)
-	char* p = command_queue[cmd_queue_index_r];
-	if (__unlikely(*p == 'N')) {
-		SERIAL_PROTOCOL(' ');
-		SERIAL_ECHO(*p++);
-		while (NUMERIC_SIGNED(*p))
-			SERIAL_ECHO(*p++);
+			, command.line
+#endif
+		);
+		return;
 	}
-	SERIAL_PROTOCOLPGM(" P"); SERIAL_PROTOCOL(int(BLOCK_BUFFER_SIZE - planner.movesplanned() - 1));
-	SERIAL_PROTOCOLPGM(" B"); SERIAL_PROTOCOL(BUFSIZE - commands_in_queue);
 #endif
-	SERIAL_EOL();
+	print_ok(queued_command_text());
 }
 
 /**
@@ -3292,9 +6278,11 @@ void clamp_to_software_endstops(float target[XYZ]) {
  * suitable for current_position, etc.
  */
 void __forceinline __flatten get_cartesian_from_steppers() {
-	cartes[X_AXIS] = stepper.get_axis_position_mm(X_AXIS);
-	cartes[Y_AXIS] = stepper.get_axis_position_mm(Y_AXIS);
-	cartes[Z_AXIS] = stepper.get_axis_position_mm(Z_AXIS);
+	float mm[XYZE];
+	stepper.get_positions_mm(mm);
+	cartes[X_AXIS] = mm[X_AXIS];
+	cartes[Y_AXIS] = mm[Y_AXIS];
+	cartes[Z_AXIS] = mm[Z_AXIS];
 }
 
 /**
@@ -3305,6 +6293,9 @@ void __forceinline __flatten get_cartesian_from_steppers() {
 void __forceinline __flatten set_current_from_steppers_for_axis(const AxisEnum axis)
 {
 	get_cartesian_from_steppers();
+#if PLANNER_LEVELING
+	planner.unapply_leveling(cartes);
+#endif
 	current_position[axis] = cartes[axis];
 }
 
@@ -3316,6 +6307,9 @@ void __forceinline __flatten set_current_from_steppers_for_axis(const AxisEnum a
 void __forceinline __flatten set_current_from_steppers()
 {
   get_cartesian_from_steppers();
+#if PLANNER_LEVELING
+  planner.unapply_leveling(cartes);
+#endif
   COPY(current_position, cartes);
 }
 
@@ -3328,11 +6322,22 @@ void __forceinline __flatten set_current_from_steppers()
 bool prepare_move_to_destination_cartesian()
 {
 	// Do not use feedrate_percentage for E or Z only moves
-	if (__unlikely(current_position[X_AXIS] == destination[X_AXIS] && current_position[Y_AXIS] == destination[Y_AXIS]))
+	if (__unlikely(current_position[X_AXIS] == destination[X_AXIS] && current_position[Y_AXIS] == destination[Y_AXIS])) {
+#if ENABLED(COALESCE_LAYER_CHANGE)
+		if (current_position[Z_AXIS] != destination[Z_AXIS] && current_position[E_AXIS] == destination[E_AXIS]) {
+			coalesce_z_move_to_destination(feedrate_mm_s);
+			return false;
+		}
+#endif
 		line_to_destination();
+	}
 	else {
 		const float fr_scaled = MMS_SCALED(feedrate_mm_s);
+#if ENABLED(MOVE_COALESCING)
+		coalesce_line_to_destination(fr_scaled);
+#else
 		line_to_destination(fr_scaled);
+#endif
 	}
 	return false;
 }
@@ -3391,11 +6396,54 @@ void retract(const bool retracting
   const bool has_zhop = retract_zlift > 0.01;     // Is there a hop set?
   const float old_feedrate_mm_s = feedrate_mm_s;
 
+  const float renormalize = 1.0;// / planner.e_factor[active_extruder];
+
+#if ENABLED(FWRETRACT_LOOKAHEAD)
+  // The queued moves keep running. The faux positions are set in the planner alone, so
+  // these moves are planned after them, and the steppers get there by making them.
+#if ENABLED(MOVE_COALESCING)
+  flush_coalesced_move();
+#endif
+
   // The current position will be the destination for E and Z moves
   set_destination_from_current();
-  stepper.synchronize();  // Wait for buffered moves to complete
 
-  const float renormalize = 1.0;// / planner.e_factor[active_extruder];
+  if (retracting) {
+    // Retract by moving from a faux E position back to the current E position
+    feedrate_mm_s = retract_feedrate_mm_s;
+    const float length = (swapping ? swap_retract_length : retract_length) * renormalize;
+    current_position[E_AXIS] += length;
+    planner.shift_position_mm(E_AXIS, length);
+    prepare_move_to_destination();
+
+    // Is a Z hop set, and has the hop not yet been done?
+    if (has_zhop && !hop_amount) {
+      hop_amount += retract_zlift;                        // Carriage is raised for retraction hop
+      planner.shift_position_mm(Z_AXIS, -retract_zlift);  // Pretend the planner is lower. The next move raises Z on its way.
+    }
+  }
+  else {
+    // If a hop was done, undo it. If no move has made it yet, the planner is back
+    // where it was and there's nothing to move.
+    if (hop_amount) {
+      planner.shift_position_mm(Z_AXIS, hop_amount);      // Pretend the planner is higher. This move lowers Z to the current pos.
+      feedrate_mm_s = planner.max_feedrate_mm_s[Z_AXIS];  // Z feedrate to max
+      prepare_move_to_destination();
+      hop_amount = 0.0;                                   // Clear hop
+    }
+
+    // A retract multiplier has been added here to get faster swap recovery
+    feedrate_mm_s = swapping ? swap_retract_recover_feedrate_mm_s : retract_recover_feedrate_mm_s;
+
+    const float move_e = (swapping ? swap_retract_length + swap_retract_recover_length : retract_length + retract_recover_length) * renormalize;
+    current_position[E_AXIS] -= move_e;
+    planner.shift_position_mm(E_AXIS, -move_e);
+    prepare_move_to_destination();                        // Recover E
+  }
+#else
+  // The current position will be the destination for E and Z moves
+  set_destination_from_current();
+  stepper.synchronize();  // Wait for buffered moves to complete
 
   if (retracting) {
     // Retract by moving from a faux E position back to the current E position
@@ -3432,6 +6480,7 @@ void retract(const bool retracting
     sync_plan_position_e();
     prepare_move_to_destination();                        // Recover E
   }
+#endif // !FWRETRACT_LOOKAHEAD
 
   feedrate_mm_s = old_feedrate_mm_s;                      // Restore original feedrate
 
@@ -3502,76 +6551,111 @@ void __forceinline __flatten prepare_move_to_destination() {
  * Arcs should only be made relatively large (over 5mm), as larger arcs with
  * larger segments will tend to be more efficient. Your slicer should have
  * options for G2/G3 arc generation. In future these options may be GCode tunable.
+ *
+ * With ARC_BLOCKS the arc goes to the planner as one block instead, when it can.
  */
-#if 0
+#if ENABLED(ARC_SUPPORT)
 void plan_arc(
-	float logical[XYZE], // Destination position
+	const float (&logical)[XYZE], // Destination position
 	float *offset,       // Center of rotation relative to current_position
 	uint8_t clockwise    // Clockwise?
 ) {
 	constexpr AxisEnum p_axis = X_AXIS, q_axis = Y_AXIS, l_axis = Z_AXIS;
 
-	// Radius vector from center to current location
-	float r_P = -offset[0], r_Q = -offset[1];
+	namespace cordic = Tuna::fixed_math::cordic;
 
-	const float radius = HYPOT(r_P, r_Q),
-		center_P = current_position[p_axis] - r_P,
-		center_Q = current_position[q_axis] - r_Q,
+	const float center_P = current_position[p_axis] + offset[0],
+		center_Q = current_position[q_axis] + offset[1],
 		rt_X = logical[p_axis] - center_P,
 		rt_Y = logical[q_axis] - center_Q,
 		linear_travel = logical[l_axis] - current_position[l_axis],
 		extruder_travel = logical[E_AXIS] - current_position[E_AXIS];
 
-	// CCW angle of rotation between position and target from the circle center. Only one atan2() trig computation required.
-	float angular_travel = ATAN2(r_P * rt_Y - r_Q * rt_X, r_P * rt_X + r_Q * rt_Y);
-	if (angular_travel < 0) angular_travel += RADIANS(360);
-	if (clockwise) angular_travel -= RADIANS(360);
+	// The radius vectors of the start and the target from the center go to the CORDIC in 1/2^k mm,
+	// k being up to 18 (about 4 nm) and small enough to keep them under 2^29
+	const float extent = max(max(FABS(offset[0]), FABS(offset[1])), max(FABS(rt_X), FABS(rt_Y)));
+	uint8_t fraction_bits = 18;
+	while (fraction_bits && extent * float(1_u32 << fraction_bits) >= float(1_u32 << 29)) --fraction_bits;
+	const float to_fixed = float(1_u32 << fraction_bits), to_mm = 1.0f / to_fixed;
+
+	int32 start_P = LROUND(-offset[0] * to_fixed), start_Q = LROUND(-offset[1] * to_fixed),
+		target_P = LROUND(rt_X * to_fixed), target_Q = LROUND(rt_Y * to_fixed);
+
+	// Vectoring leaves each vector's length, times the CORDIC gain, in its P
+	const cordic::angle_t start_angle = cordic::vector(start_P, start_Q),
+		target_angle = cordic::vector(target_P, target_Q);
+	const float radius = float(start_P) * (cordic::inverse_gain * to_mm);
+
+	// CCW angle of rotation between position and target from the circle center. The difference of the
+	// binary angles wraps into [0, 360) by itself.
+	int64 travel = cordic::angle_t(target_angle - start_angle);
+	if (clockwise) travel -= int64(1) << 32;
 
 	// Make a circle if the angular rotation is 0 and the target is current position
-	if (angular_travel == 0 && current_position[p_axis] == logical[p_axis] && current_position[q_axis] == logical[q_axis])
-		angular_travel = RADIANS(360);
+	if (travel == 0 && current_position[p_axis] == logical[p_axis] && current_position[q_axis] == logical[q_axis])
+		travel = int64(1) << 32;
+
+	const float angular_travel = float(travel) * cordic::angle_to_radians;
 
 	const float mm_of_travel = HYPOT(angular_travel * radius, FABS(linear_travel));
 	if (mm_of_travel < 0.001) return;
 
-	uint16_t segments = FLOOR(mm_of_travel / (MM_PER_ARC_SEGMENT));
+#if ENABLED(ARC_BLOCKS)
+	// The block isn't clamped along the way, so the whole circle has to be within the soft endstops
+	if (
+		!soft_endstops_enabled || (
+			center_P - radius >= soft_endstop_min[p_axis] && center_P + radius <= soft_endstop_max[p_axis] &&
+			center_Q - radius >= soft_endstop_min[q_axis] && center_Q + radius <= soft_endstop_max[q_axis] &&
+			logical[l_axis] >= soft_endstop_min[l_axis] && logical[l_axis] <= soft_endstop_max[l_axis]
+		)
+	) {
+		const float center[2] = { center_P, center_Q };
+		if (planner.buffer_arc(logical, center, angular_travel, MMS_SCALED(feedrate_mm_s), active_extruder)) {
+			set_current_to_destination();
+			return;
+		}
+	}
+	// Otherwise the arc is cut into segments as usual
+#endif
+
+	uint16_t segments;
+	if (arc_chord_tolerance > 0) {
+		// A chord of length L is r - sqrt(r^2 - L^2 / 4) inside the arc at most, so for that
+		// to be the tolerance t, L = 2 sqrt(t (2r - t)). Z and E follow the XY segments.
+		float segment_mm = arc_chord_tolerance < radius ? 2 * SQRT(arc_chord_tolerance * (2 * radius - arc_chord_tolerance)) : arc_segment_max_mm;
+		segment_mm = constrain(segment_mm, arc_segment_min_mm, arc_segment_max_mm);
+		const float count = CEIL(FABS(angular_travel) * radius / segment_mm);
+		segments = count < 65535 ? uint16_t(count) : 65535;
+	}
+	else
+		segments = FLOOR(mm_of_travel / (MM_PER_ARC_SEGMENT));
 	if (segments == 0) segments = 1;
 
 	/**
-	 * Vector rotation by transformation matrix: r is the original vector, r_T is the rotated vector,
-	 * and phi is the angle of rotation. Based on the solution approach by Jens Geisler.
+	 * The radius vector goes around in integers: each segment turns it by the rotation matrix
 	 *     r_T = [cos(phi) -sin(phi);
-	 *            sin(phi)  cos(phi)] * r ;
-	 *
-	 * For arc generation, the center of the circle is the axis of rotation and the radius vector is
-	 * defined from the circle center to the initial position. Each line segment is formed by successive
-	 * vector rotations. This requires only two cos() and sin() computations to form the rotation
-	 * matrix for the duration of the entire arc. Error may accumulate from numerical round-off, since
-	 * all double numbers are single precision on the Arduino. (True double precision will not have
-	 * round off issues for CNC applications.) Single precision error can accumulate to be greater than
-	 * tool precision in some cases. Therefore, arc path correction is implemented.
-	 *
-	 * Small angle approximation may be used to reduce computation overhead further. This approximation
-	 * holds for everything, but very small circles and large MM_PER_ARC_SEGMENT values. In other words,
-	 * theta_per_segment would need to be greater than 0.1 rad and N_ARC_CORRECTION would need to be large
-	 * to cause an appreciable drift error. N_ARC_CORRECTION~=25 is more than small enough to correct for
-	 * numerical drift error. N_ARC_CORRECTION may be on the order a hundred(s) before error becomes an
-	 * issue for CNC machines with the single precision Arduino calculations.
-	 *
-	 * This approximation also allows plan_arc to immediately insert a line segment into the planner
-	 * without the initial overhead of computing cos() or sin(). By the time the arc needs to be applied
-	 * a correction, the planner should have caught up to the lag caused by the initial plan_arc overhead.
-	 * This is important when there are successive arc motions.
+	 *            sin(phi)  cos(phi)] * r
+	 * with cos(phi) and sin(phi) from the CORDIC as 2.30 fixed point, and the products taken in 64 bits.
+	 * Each turn rounds the vector by a few of its lowest bits, so every N_ARC_CORRECTION segments it's set
+	 * exactly instead, by turning the start vector through the whole angle so far with the CORDIC.
+	 * The angles are exact multiples of the segment's angle in binary turns, so nothing else drifts.
 	 */
-	 // Vector rotation matrix values
+	const cordic::angle_t angle_per_segment = cordic::angle_t(travel / segments);
+	const int32 radius_scaled = LROUND(radius * cordic::inverse_gain * to_fixed);
+
+	int32 cos_T = LROUND(cordic::inverse_gain * float(1_u32 << 30)), sin_T = 0;
+	cordic::rotate(cos_T, sin_T, angle_per_segment);
+
+	// r * (cos or sin) / 4: the high half of the product drops 32 bits, and the callers' shift restores 2
+	const auto turn = [](const int32 r, const int32 t) { return int32((int64(r) * t) >> 32); };
+
+	int32 r_P = LROUND(-offset[0] * to_fixed), r_Q = LROUND(-offset[1] * to_fixed);
+
 	float arc_target[XYZE];
-	const float theta_per_segment = angular_travel / segments,
-		linear_per_segment = linear_travel / segments,
-		extruder_per_segment = extruder_travel / segments,
-		sin_T = theta_per_segment,
-		cos_T = 1 - 0.5 * sq(theta_per_segment); // Small angle approximation
+	const float linear_per_segment = linear_travel / segments,
+		extruder_per_segment = extruder_travel / segments;
 
-// Initialize the linear axis
+	// Initialize the linear axis
 	arc_target[l_axis] = current_position[l_axis];
 
 	// Initialize the extruder axis
@@ -3592,27 +6676,24 @@ void plan_arc(
 		}
 
 		if (--count) {
-			// Apply vector rotation matrix to previous r_P / 1
-			const float r_new_Y = r_P * sin_T + r_Q * cos_T;
-			r_P = r_P * cos_T - r_Q * sin_T;
-			r_Q = r_new_Y;
+			// Apply the rotation matrix to the previous vector
+			const int32 r_new_Q = (turn(r_P, sin_T) + turn(r_Q, cos_T)) << 2;
+			r_P = (turn(r_P, cos_T) - turn(r_Q, sin_T)) << 2;
+			r_Q = r_new_Q;
 		}
 		else
 		{
 			count = N_ARC_CORRECTION;
 
-			// Arc correction to radius vector. Computed only every N_ARC_CORRECTION increments.
-			// Compute exact location by applying transformation matrix from initial radius vector(=-offset).
-			// To reduce stuttering, the sin and cos could be computed at different times.
-			// For now, compute both at the same time.
-			const float cos_Ti = cos(i * theta_per_segment), sin_Ti = sin(i * theta_per_segment);
-			r_P = -offset[0] * cos_Ti + offset[1] * sin_Ti;
-			r_Q = -offset[0] * sin_Ti - offset[1] * cos_Ti;
+			// The exact vector: the radius along the start's angle, turned through i segments
+			r_P = radius_scaled;
+			r_Q = 0;
+			cordic::rotate(r_P, r_Q, start_angle + angle_per_segment * i);
 		}
 
 		// Update arc_target location
-		arc_target[p_axis] = center_P + r_P;
-		arc_target[q_axis] = center_Q + r_Q;
+		arc_target[p_axis] = center_P + float(r_P) * to_mm;
+		arc_target[q_axis] = center_Q + float(r_Q) * to_mm;
 		arc_target[l_axis] += linear_per_segment;
 		arc_target[E_AXIS] += extruder_per_segment;
 
@@ -3629,7 +6710,7 @@ void plan_arc(
 	// in any intermediate location.
 	set_current_to_destination();
 }
-#endif
+#endif // ARC_SUPPORT
 
 void __forceinline __flatten plan_cubic_move(const float offset[4]) {
 	cubic_b_spline(current_position, destination, offset, MMS_SCALED(feedrate_mm_s), active_extruder);
@@ -3646,11 +6727,26 @@ float calculate_volumetric_multiplier(float diameter) {
 }
 
 void calculate_volumetric_multipliers() {
-	for (uint8_t i = 0; i < COUNT(filament_size); i++)
+	for (uint8_t i = 0; i < COUNT(filament_size); i++) {
 		volumetric_multiplier[i] = calculate_volumetric_multiplier(filament_size[i]);
+		planner.refresh_e_factor(i);
+	}
 }
 
+// All four drivers of a single-extruder printer on their own enable pins, switched together: a
+// write per port (PORTF for X and E0, PORTK for Y and Z on the Bi3 Plus) instead of one per pin.
+#define STEPPER_ENABLE_GROUP (E_STEPPERS == 1 && DISABLED(MIXING_EXTRUDER) && HAS_X_ENABLE && HAS_Y_ENABLE && HAS_Z_ENABLE && HAS_E0_ENABLE \
+	&& !HAS_X2_ENABLE && !HAS_Y2_ENABLE && !HAS_Z2_ENABLE && DISABLED(HAVE_L6470DRIVER) && DISABLED(HAVE_TMCDRIVER) \
+	&& X_ENABLE_ON == Y_ENABLE_ON && X_ENABLE_ON == Z_ENABLE_ON && X_ENABLE_ON == E_ENABLE_ON)
+
+#if STEPPER_ENABLE_GROUP
+using stepper_enables = Tuna::io::pins<X_ENABLE_PIN, Y_ENABLE_PIN, Z_ENABLE_PIN, E0_ENABLE_PIN>;
+#endif
+
 void enable_all_steppers() {
+#if STEPPER_ENABLE_GROUP
+	stepper_enables::write(X_ENABLE_ON);
+#else
 	enable_X();
 	enable_Y();
 	enable_Z();
@@ -3659,6 +6755,7 @@ void enable_all_steppers() {
 	enable_E2();
 	enable_E3();
 	enable_E4();
+#endif
 }
 
 void disable_e_steppers() {
@@ -3670,10 +6767,15 @@ void disable_e_steppers() {
 }
 
 void disable_all_steppers() {
+#if STEPPER_ENABLE_GROUP
+	stepper_enables::write(!X_ENABLE_ON);
+	axis_known_position[X_AXIS] = axis_known_position[Y_AXIS] = axis_known_position[Z_AXIS] = false;
+#else
 	disable_X();
 	disable_Y();
 	disable_Z();
 	disable_e_steppers();
+#endif
 }
 
 /**
@@ -3690,13 +6792,15 @@ void disable_all_steppers() {
  */
 void manage_inactivity(bool ignore_stepper_queue/*=false*/) {
 
-	if (commands_in_queue < BUFSIZE) get_available_commands();
+	if (command_queue_has_room()) get_available_commands();
 
-	const millis_t ms = millis();
+	const millis_t ms = chrono::time_ms32::now().raw();
 
 	if (max_inactive_time && ELAPSED(ms, previous_cmd_ms + max_inactive_time)) {
 		SERIAL_ERROR_START();
-		SERIAL_ECHOLNPAIR(MSG_KILL_INACTIVE_TIME, parser.command_ptr);
+		SERIAL_ECHOPGM(MSG_KILL_INACTIVE_TIME);
+		parser.print_command();
+		SERIAL_EOL();
 		kill(PSTR(MSG_KILLED));
 	}
 
@@ -3704,7 +6808,11 @@ void manage_inactivity(bool ignore_stepper_queue/*=false*/) {
 #define MOVE_AWAY_TEST true
 
 	if (MOVE_AWAY_TEST && stepper_inactive_time && ELAPSED(ms, previous_cmd_ms + stepper_inactive_time)
-		&& !ignore_stepper_queue && !planner.blocks_queued()) {
+		&& !ignore_stepper_queue && !planner.blocks_queued()
+#if ENABLED(QUICK_PAUSE)
+		&& !planner.motion_held() // The paused print goes on from where the steppers are
+#endif
+	) {
 		disable_X();
 		disable_Y();
 		disable_Z();
@@ -3712,6 +6820,10 @@ void manage_inactivity(bool ignore_stepper_queue/*=false*/) {
 	}
 
 	planner.check_axes_activity();
+
+#if ENABLED(MOTION_SYNC_EVENTS)
+	run_sync_events();
+#endif
 }
 
 /**
@@ -3719,17 +6831,32 @@ void manage_inactivity(bool ignore_stepper_queue/*=false*/) {
  */
 void idle(
 ) {
-	lcd::update();
+	chrono::update_now();
 
-	host_keepalive();
+	// Every pass: it only works when a new sample is in, so it keeps the ADC's cadence
+  Temperature::manage_heater();
 
-	auto_report_temperatures();
+	// The heater checks, the print timer, the LCD, the keepalive and the auto-report, when due and by priority
+	periodic.poll(IDLE_PASS_BUDGET);
 
+	// Reading commands, with whatever time is left
 	manage_inactivity();
 
-  Temperature::manage_heater();
+#if ENABLED(QUICK_PAUSE_PARK)
+	Planner::manage_park();
+#endif
+
+#if ENABLED(RAMP_TABLES)
+	stepper.prepare_ramp_table();
+#endif
 
-	print_job_timer.tick();
+#if ENABLED(SD_READ_AHEAD)
+	if (card.sdprinting) card.readAhead();
+#endif
+
+#if ENABLED(POWER_LOSS_RECOVERY)
+	if (card.checkpoint_pending) card.save_checkpoint();
+#endif
 }
 
 /**
@@ -3797,6 +6924,9 @@ void setup() {
 
 	setup_powerhold();
 
+	chrono::time_ticks::start();
+
+	c_static_assert(host_port == usb_port || uart::usable(BAUDRATE), "BAUDRATE is more than 2.5% off at F_CPU. Try 250000, 500000 or 1000000.");
 	MYSERIAL.begin(BAUDRATE);
 	SERIAL_PROTOCOLLNPGM("start");
 	SERIAL_ECHO_START();
@@ -3809,6 +6939,9 @@ void setup() {
 	if (mcu & 8) SERIAL_ECHOLNPGM(MSG_WATCHDOG_RESET);
 	if (mcu & 32) SERIAL_ECHOLNPGM(MSG_SOFTWARE_RESET);
 	MCUSR = 0;
+#if ENABLED(WATCHDOG_STALL_REPORT)
+	watchdog_report_stall(mcu);
+#endif
 
 	SERIAL_ECHOPGM(MSG_TUNA);
 	SERIAL_CHAR(' ');
@@ -3821,17 +6954,29 @@ void setup() {
 	SERIAL_ECHOLNPGM(MSG_AUTHOR STRING_CONFIG_H_AUTHOR);
 	SERIAL_ECHOLNPGM("Compiled: " __DATE__);
 
-	SERIAL_ECHO_START();
-	SERIAL_ECHOPAIR(MSG_FREE_MEMORY, freeMemory());
-	SERIAL_ECHOLNPAIR(MSG_PLANNER_BUFFER_BYTES, (int)sizeof(block_t)*BLOCK_BUFFER_SIZE);
-
-	// Send "ok" after commands by default
-	for (int8_t i = 0; i < BUFSIZE; i++) send_ok[i] = true;
+#if ENABLED(FIRMWARE_UPDATE)
+	// May not come back: an update resets into the bootloader
+	card.checkFirmwareUpdate();
+#endif
 
 	// Load data from EEPROM if available (or use defaults)
 	// This also updates variables in the planner, elsewhere
 	(void)settings.load();
 
+#if ENABLED(SHARED_QUEUE_POOL)
+	allocate_queue_pool();
+#endif
+
+	SERIAL_ECHO_START();
+	SERIAL_ECHOPAIR(MSG_FREE_MEMORY, freeMemory());
+	SERIAL_ECHOLNPAIR(MSG_PLANNER_BUFFER_BYTES, (int)sizeof(block_t)*planner.block_buffer_size());
+#if ENABLED(SRAM_BUDGET)
+	report_sram_budget();
+#endif
+
+	// Send "ok" after commands by default
+	for (uint8_t i = 0; i < COMMAND_QUEUE_SIZE; i++) send_ok[i] = true;
+
 	// Initialize current position based on home_offset
 	COPY(current_position, home_offset);
 
@@ -3840,6 +6985,16 @@ void setup() {
 
   Temperature::init();    // Initialize temperature loop
 
+	// Budgets in us, each below IDLE_PASS_BUDGET so they get their turn; the checks and the timer have none and are never put off
+	periodic.set(periodic_task::heater_checks, Temperature::check_heaters, HEATER_CHECK_INTERVAL);
+	periodic.set(periodic_task::print_timer, [] { print_job_timer.tick(); }, 1000);
+	periodic.set(periodic_task::lcd_update, lcd::update, 1, 1000);
+	periodic.set(periodic_task::host_keepalive, host_keepalive, host_keepalive_interval * 1000UL, 500);
+	periodic.set(periodic_task::auto_report, auto_report_temperatures, 0, 1000);
+#if ENABLED(BINARY_STATUS_REPORT)
+	periodic.set(periodic_task::status_report, report_status, 0, 1000);
+#endif
+
 	watchdog_init();
 
 	stepper.init();    // Initialize stepper, this enables interrupts!
@@ -3861,13 +7016,24 @@ void setup() {
  *  - Call LCD update
  */
 void loop() {
-	if (commands_in_queue < BUFSIZE) get_available_commands();
+#if ENABLED(LOOP_LATENCY_HISTOGRAM)
+	const profiling::loop_timer loop_timer(commands_in_queue, planner.blocks_queued());
+#endif
+	if (command_queue_has_room()) get_available_commands();
 
 	card.checkautostart(false);
+#if ENABLED(JOB_QUEUE)
+	card.checkJobQueue();
+#endif
 
+#if ENABLED(QUICK_PAUSE)
+	// The commands after the held moves wait with them, so they still run in order
+	if (__likely(commands_in_queue) && __likely(!planner.motion_held())) {
+#else
 	if (__likely(commands_in_queue)) {
-		if (__unlikely(card.saving)) {
-			char* command = command_queue[cmd_queue_index_r];
+#endif
+		if (__unlikely(card.saving) && queued_command_text()) {
+			char* command = queued_command_text();
 			if (strstr_P(command, PSTR("M29"))) {
 				// M29 closes the file
 				card.closefile();
@@ -3888,10 +7054,24 @@ void loop() {
 
 		// The queue may be reset by a command handler or by code invoked by idle() within a handler
 		if (__likely(commands_in_queue)) {
+#if ENABLED(PARSED_COMMAND_QUEUE)
+			if (!command_queue[cmd_queue_index_r].letter) {
+				--text_in_queue;
+				if (++text_queue_index_r >= TEXT_BUFSIZE) text_queue_index_r = 0;
+			}
+#endif
+#if ENABLED(PREFETCH_LINEAR_MOVES)
+			// A line written to SD wasn't processed, so its prefetch wasn't taken
+			if (prefetched_line == command_queue[cmd_queue_index_r]) prefetched_line = nullptr;
+#endif
 			--commands_in_queue;
-			if (++cmd_queue_index_r >= BUFSIZE) cmd_queue_index_r = 0;
+			if (++cmd_queue_index_r >= COMMAND_QUEUE_SIZE) cmd_queue_index_r = 0;
 		}
 }
+#if ENABLED(MOVE_COALESCING)
+	// Nothing more to merge with for now, so don't hold the move back
+	if (!commands_in_queue) flush_coalesced_move();
+#endif
 	endstops.report_state();
 	idle();
 }
@@ -240,6 +240,13 @@
   #error "Z_DUAL_STEPPER_DRIVERS requires Z2 pins (and an extra E plug)."
 #endif
 
+/**
+ * Planner ring buffer indices are 8 bits
+ */
+#if BLOCK_BUFFER_SIZE < 2 || BLOCK_BUFFER_SIZE > 255
+  #error "BLOCK_BUFFER_SIZE must be between 2 and 255."
+#endif
+
 /**
  * Progress Bar
  */
@@ -281,6 +288,388 @@
   #endif
 #endif
 
+#if ENABLED(STEPPER_FREE_RUNNING_TIMER) && DISABLED(LIN_ADVANCE)
+  #error "STEPPER_FREE_RUNNING_TIMER requires LIN_ADVANCE."
+#endif
+
+#ifdef SLOWDOWN_BUFFER_MS
+  #if DISABLED(SLOWDOWN)
+    #error "SLOWDOWN_BUFFER_MS requires SLOWDOWN."
+  #elif DISABLED(PRINT_TIME_ESTIMATE)
+    #error "SLOWDOWN_BUFFER_MS requires PRINT_TIME_ESTIMATE, which keeps the buffered move time."
+  #elif !WITHIN(SLOWDOWN_BUFFER_MS, 1, 10000)
+    #error "SLOWDOWN_BUFFER_MS must be between 1 and 10000."
+  #endif
+#endif
+
+#if ENABLED(MOTION_SYNC_EVENTS) && !WITHIN(MOTION_SYNC_EVENT_SLOTS, 2, 256)
+  #error "MOTION_SYNC_EVENT_SLOTS must be between 2 and 256."
+#endif
+
+#if ENABLED(DIR_PORT_GROUPING) && (ENABLED(HAVE_L6470DRIVER) || ENABLED(HAVE_TMCDRIVER) || ENABLED(DUAL_X_CARRIAGE) || ENABLED(X_DUAL_STEPPER_DRIVERS) || ENABLED(Y_DUAL_STEPPER_DRIVERS) || ENABLED(Z_DUAL_STEPPER_DRIVERS))
+  #error "DIR_PORT_GROUPING requires the X, Y and Z direction pins to be single, plain pins."
+#endif
+
+#if ENABLED(WATCHDOG_STALL_REPORT)
+  #if DISABLED(USE_WATCHDOG)
+    #error "WATCHDOG_STALL_REPORT requires USE_WATCHDOG."
+  #elif ENABLED(WATCHDOG_RESET_MANUAL)
+    #error "WATCHDOG_STALL_REPORT and WATCHDOG_RESET_MANUAL both need the watchdog interrupt. Enable only one."
+  #endif
+#endif
+
+#if ENABLED(SRAM_BUDGET) && !WITHIN(SRAM_STACK_RESERVE, 256, 4096)
+  #error "SRAM_STACK_RESERVE must be between 256 and 4096."
+#endif
+
+#if ENABLED(FAST_SQRT) && !WITHIN(FAST_SQRT_ITERATIONS, 1, 3)
+  #error "FAST_SQRT_ITERATIONS must be between 1 and 3."
+#endif
+
+#if ENABLED(STEP_TRACE) && !WITHIN(STEP_TRACE_LENGTH, 2, 256)
+  #error "STEP_TRACE_LENGTH must be between 2 and 256."
+#endif
+
+#if ENABLED(THERMAL_TELEMETRY) && !WITHIN(THERMAL_TELEMETRY_LENGTH, 2, 256)
+  #error "THERMAL_TELEMETRY_LENGTH must be between 2 and 256."
+#endif
+
+#if ENABLED(HEATER_POWER_BUDGET)
+  #if !WITHIN(HEATER_POWER_HOTEND_WATTS, 1, 1000) || !WITHIN(HEATER_POWER_BED_WATTS, 1, 1000)
+    #error "HEATER_POWER_HOTEND_WATTS and HEATER_POWER_BED_WATTS must be between 1 and 1000."
+  #elif HEATER_POWER_BUDGET_WATTS < HEATER_POWER_HOTEND_WATTS || HEATER_POWER_BUDGET_WATTS < HEATER_POWER_BED_WATTS
+    #error "HEATER_POWER_BUDGET_WATTS must be enough for either heater at full power."
+  #elif HEATER_POWER_BUDGET_WATTS >= HEATER_POWER_HOTEND_WATTS + HEATER_POWER_BED_WATTS
+    #error "HEATER_POWER_BUDGET_WATTS is enough for both heaters, so HEATER_POWER_BUDGET does nothing."
+  #endif
+#endif
+
+#if ENABLED(STEP_RATE_CALIBRATION) && !WITHIN(STEP_RATE_ISR_LOAD, 1, 100)
+  #error "STEP_RATE_ISR_LOAD must be between 1 and 100."
+#endif
+
+/**
+ * Heater checks
+ */
+#if !defined(HEATER_CHECK_INTERVAL) || !WITHIN(HEATER_CHECK_INTERVAL, 10, 1000)
+  #error "HEATER_CHECK_INTERVAL must be between 10 and 1000."
+#endif
+#if !defined(LOG_LEVEL) || !WITHIN(LOG_LEVEL, 0, 2)
+  #error "LOG_LEVEL must be 0, 1 or 2."
+#endif
+#if !defined(IDLE_PASS_BUDGET) || !WITHIN(IDLE_PASS_BUDGET, 1000, 30000)
+  #error "IDLE_PASS_BUDGET must be between 1000 and 30000."
+#endif
+
+#if ENABLED(COALESCE_LAYER_CHANGE) && DISABLED(MOVE_COALESCING)
+  #error "COALESCE_LAYER_CHANGE requires MOVE_COALESCING."
+#endif
+
+/**
+ * G-code value cache
+ */
+#if ENABLED(GCODE_VALUE_CACHE)
+  #if DISABLED(FASTER_GCODE_PARSER)
+    #error "GCODE_VALUE_CACHE requires FASTER_GCODE_PARSER."
+  #elif !WITHIN(GCODE_VALUE_CACHE_SIZE, 1, 26)
+    #error "GCODE_VALUE_CACHE_SIZE must be between 1 and 26."
+  #endif
+#endif
+
+/**
+ * Parsed command queue
+ */
+#if ENABLED(PARSED_COMMAND_QUEUE)
+  #if DISABLED(FASTER_GCODE_PARSER)
+    #error "PARSED_COMMAND_QUEUE requires FASTER_GCODE_PARSER."
+  #elif !defined(PARSED_COMMAND_VALUES) || !WITHIN(PARSED_COMMAND_VALUES, 1, 26)
+    #error "PARSED_COMMAND_VALUES must be between 1 and 26."
+  #elif !defined(TEXT_BUFSIZE) || !WITHIN(TEXT_BUFSIZE, 1, BUFSIZE)
+    #error "TEXT_BUFSIZE must be between 1 and BUFSIZE."
+  #endif
+#endif
+
+/**
+ * Serial port buffers
+ */
+#if (SERIAL_PORT == 0 && !SERIAL0_RX_BUFFER_SIZE) || (SERIAL_PORT == 1 && !SERIAL1_RX_BUFFER_SIZE) \
+ || (SERIAL_PORT == 2 && !SERIAL2_RX_BUFFER_SIZE) || (SERIAL_PORT == 3 && !SERIAL3_RX_BUFFER_SIZE)
+  #error "The SERIAL_PORT used for the host needs a SERIALn_RX_BUFFER_SIZE."
+#endif
+
+/**
+ * SD card on a USART
+ */
+#ifdef SD_SPI_USART
+  #if SD_SPI_USART < 0 || SD_SPI_USART > 3
+    #error "SD_SPI_USART must be 0, 1, 2 or 3."
+  #elif SD_SPI_USART == SERIAL_PORT
+    #error "SD_SPI_USART can't be the host SERIAL_PORT."
+  #elif (SD_SPI_USART == 0 && (SERIAL0_RX_BUFFER_SIZE || SERIAL0_TX_BUFFER_SIZE)) \
+     || (SD_SPI_USART == 1 && (SERIAL1_RX_BUFFER_SIZE || SERIAL1_TX_BUFFER_SIZE)) \
+     || (SD_SPI_USART == 2 && (SERIAL2_RX_BUFFER_SIZE || SERIAL2_TX_BUFFER_SIZE)) \
+     || (SD_SPI_USART == 3 && (SERIAL3_RX_BUFFER_SIZE || SERIAL3_TX_BUFFER_SIZE))
+    #error "The SD_SPI_USART needs its SERIALn_RX_BUFFER_SIZE and SERIALn_TX_BUFFER_SIZE set to 0."
+  #elif !defined(SD_SPI_USART_XCK_PIN) || SD_SPI_USART_XCK_PIN < 0
+    #error "SD_SPI_USART requires SD_SPI_USART_XCK_PIN."
+  #elif DISABLED(SDSUPPORT)
+    #error "SD_SPI_USART requires SDSUPPORT."
+  #endif
+#endif
+
+#if ENABLED(SD_WRITE_BUFFER) && (!defined(SD_WRITE_ALLOC_CLUSTERS) || !WITHIN(SD_WRITE_ALLOC_CLUSTERS, 1, 255))
+  #error "SD_WRITE_ALLOC_CLUSTERS must be between 1 and 255."
+#endif
+
+#if ENABLED(POWER_LOSS_RECOVERY) && DISABLED(SDSUPPORT)
+  #error "POWER_LOSS_RECOVERY requires SDSUPPORT."
+#endif
+
+#if ENABLED(FIRMWARE_UPDATE) && DISABLED(SDSUPPORT)
+  #error "FIRMWARE_UPDATE requires SDSUPPORT."
+#endif
+
+#if ENABLED(LCD_CONTINUOUS_JOG)
+  #if !WITHIN(LCD_JOG_SEGMENT_MS, 10, 500)
+    #error "LCD_JOG_SEGMENT_MS must be between 10 and 500."
+  #elif !WITHIN(LCD_JOG_RELEASE_MS, 50, 1000)
+    #error "LCD_JOG_RELEASE_MS must be between 50 and 1000."
+  #endif
+#endif
+
+#if ENABLED(LCD_YIELD_TO_PLANNER)
+  #if !WITHIN(LCD_YIELD_MOVES, 1, BLOCK_BUFFER_SIZE)
+    #error "LCD_YIELD_MOVES must be between 1 and BLOCK_BUFFER_SIZE."
+  #elif !WITHIN(LCD_YIELD_MAX_MS, 100, 60000)
+    #error "LCD_YIELD_MAX_MS must be between 100 and 60000."
+  #endif
+#endif
+
+#if ENABLED(EEPROM_BACKGROUND_WRITE)
+  #if DISABLED(EEPROM_SETTINGS)
+    #error "EEPROM_BACKGROUND_WRITE requires EEPROM_SETTINGS."
+  #elif !WITHIN(EEPROM_WRITE_QUEUE, 2, 256)
+    #error "EEPROM_WRITE_QUEUE must be between 2 and 256."
+  #endif
+#endif
+
+#if ENABLED(SETTINGS_PROFILES)
+  #if DISABLED(EEPROM_SETTINGS)
+    #error "SETTINGS_PROFILES requires EEPROM_SETTINGS."
+  #elif ENABLED(AUTO_BED_LEVELING_UBL)
+    #error "SETTINGS_PROFILES can't be used with AUTO_BED_LEVELING_UBL, which keeps its meshes after the settings."
+  #elif !WITHIN(SETTINGS_PROFILE_COUNT, 1, 8)
+    #error "SETTINGS_PROFILE_COUNT must be between 1 and 8."
+  #elif 100 + SETTINGS_PROFILE_COUNT * SETTINGS_PROFILE_SIZE > (ENABLED(PRINTCOUNTER_JOURNAL) ? 0x800 : E2END + 1)
+    #error "SETTINGS_PROFILE_COUNT profiles of SETTINGS_PROFILE_SIZE bytes don't fit in the EEPROM."
+  #endif
+#endif
+
+#if ENABLED(PRINTCOUNTER_JOURNAL)
+  #if DISABLED(PRINTCOUNTER)
+    #error "PRINTCOUNTER_JOURNAL requires PRINTCOUNTER."
+  #elif ENABLED(AUTO_BED_LEVELING_UBL)
+    #error "PRINTCOUNTER_JOURNAL can't be used with AUTO_BED_LEVELING_UBL, which keeps its meshes in the same EEPROM."
+  #elif !WITHIN(PRINTCOUNTER_JOURNAL_SLOTS, 2, 100)
+    #error "PRINTCOUNTER_JOURNAL_SLOTS must be between 2 and 100."
+  #endif
+#endif
+
+#if ENABLED(BEZIER_FORWARD_DIFFERENCING)
+  #if DISABLED(BEZIER_CURVE_SUPPORT)
+    #error "BEZIER_FORWARD_DIFFERENCING requires BEZIER_CURVE_SUPPORT."
+  #endif
+  static_assert(BEZIER_TOLERANCE > 0, "BEZIER_TOLERANCE must be above 0.");
+#endif
+
+#if ENABLED(ARC_SUPPORT)
+  static_assert(ARC_CHORD_TOLERANCE >= 0, "ARC_CHORD_TOLERANCE can't be negative.");
+  static_assert(MIN_ARC_SEGMENT_MM > 0 && MAX_ARC_SEGMENT_MM >= MIN_ARC_SEGMENT_MM, "MIN_ARC_SEGMENT_MM must be above 0 and no more than MAX_ARC_SEGMENT_MM.");
+#endif
+
+#if ENABLED(ARC_BLOCKS)
+  #if DISABLED(ARC_SUPPORT)
+    #error "ARC_BLOCKS requires ARC_SUPPORT."
+  #elif IS_KINEMATIC || IS_CORE
+    #error "ARC_BLOCKS requires a Cartesian machine."
+  #elif PLANNER_LEVELING
+    #error "ARC_BLOCKS can't be used with planner leveling, which would have to tilt the arc."
+  #elif ENABLED(MIXING_EXTRUDER) || EXTRUDERS > 1
+    #error "ARC_BLOCKS requires a single extruder."
+  #endif
+#endif
+
+#if ENABLED(INPUT_SHAPING)
+  #if IS_KINEMATIC || IS_CORE
+    #error "INPUT_SHAPING only supports Cartesian X and Y axes."
+  #elif !(WITHIN(SHAPING_TYPE_X, 0, 1) && WITHIN(SHAPING_TYPE_Y, 0, 1))
+    #error "SHAPING_TYPE_X and SHAPING_TYPE_Y must be 0 (ZV) or 1 (MZV)."
+  #elif !WITHIN(SHAPING_MERGE_TIME, 4, 1000)
+    #error "SHAPING_MERGE_TIME must be between 4 and 1000, which keeps it below the shortest delay."
+  #endif
+  static_assert((SHAPING_FREQ_X == 0 || WITHIN(SHAPING_FREQ_X, 10, 200)) && (SHAPING_FREQ_Y == 0 || WITHIN(SHAPING_FREQ_Y, 10, 200)),
+    "SHAPING_FREQ_X and SHAPING_FREQ_Y must be 0 or between 10 and 200.");
+  static_assert(WITHIN(SHAPING_ZETA_X, 0, 0.9) && WITHIN(SHAPING_ZETA_Y, 0, 0.9), "SHAPING_ZETA_X and SHAPING_ZETA_Y must be between 0 and 0.9.");
+#endif
+
+#if ENABLED(TRAVEL_JERK)
+  static_assert(DEFAULT_TRAVEL_XJERK >= 0 && DEFAULT_TRAVEL_YJERK >= 0 && DEFAULT_TRAVEL_ZJERK >= 0 && TRAVEL_JUNCTION_DEVIATION_MM > 0,
+    "The TRAVEL_JERK defaults can't be negative, and TRAVEL_JUNCTION_DEVIATION_MM must be above 0.");
+#endif
+
+#if ENABLED(FWRETRACT_LOOKAHEAD) && (IS_KINEMATIC || IS_CORE || PLANNER_LEVELING)
+  #error "FWRETRACT_LOOKAHEAD offsets the planner's Z alone, so it requires a Cartesian machine without planner leveling."
+#endif
+
+#if ENABLED(PARALLEL_HOMING) && (IS_KINEMATIC || IS_CORE)
+  #error "PARALLEL_HOMING requires a Cartesian machine."
+#endif
+
+#if ENABLED(ENDSTOP_PORT_SAMPLING)
+  #if IS_KINEMATIC || IS_CORE || ENABLED(DUAL_X_CARRIAGE)
+    #error "ENDSTOP_PORT_SAMPLING requires a Cartesian machine without DUAL_X_CARRIAGE."
+  #elif !defined(__AVR_ATmega1280__) && !defined(__AVR_ATmega2560__)
+    #error "ENDSTOP_PORT_SAMPLING requires an ATmega1280 or ATmega2560."
+  #endif
+#endif
+
+#if ENABLED(MESH_COMPENSATION)
+  #if IS_KINEMATIC || IS_CORE
+    #error "MESH_COMPENSATION requires a Cartesian machine."
+  #elif ENABLED(MESH_BED_LEVELING) || ENABLED(AUTO_BED_LEVELING_LINEAR) || ENABLED(AUTO_BED_LEVELING_3POINT) || ENABLED(AUTO_BED_LEVELING_BILINEAR) || ENABLED(AUTO_BED_LEVELING_UBL)
+    #error "MESH_COMPENSATION replaces the other bed leveling options."
+  #elif !WITHIN(MESH_GRID_X, 2, 7) || !WITHIN(MESH_GRID_Y, 2, 7)
+    #error "MESH_GRID_X and MESH_GRID_Y must be from 2 to 7."
+  #endif
+  static_assert(MESH_MIN_X < MESH_MAX_X && MESH_MIN_Y < MESH_MAX_Y, "MESH_MIN_X and MESH_MIN_Y must be below MESH_MAX_X and MESH_MAX_Y.");
+#endif
+
+#if defined(DRIVER_WAKE_LEAD) && !WITHIN(DRIVER_WAKE_LEAD, 1, 50)
+  #error "DRIVER_WAKE_LEAD must be from 1 to 50 ms."
+#endif
+
+#if defined(E_TRAVEL_IDLE_MS) && E_TRAVEL_IDLE_MS < 100
+  #error "E_TRAVEL_IDLE_MS must be at least 100 ms."
+#endif
+
+#if ENABLED(ENDSTOP_EDGE_LATCH) && IS_CORE
+  #error "ENDSTOP_EDGE_LATCH requires a Cartesian machine."
+#endif
+
+#if defined(ENDSTOP_DEBOUNCE) && !WITHIN(ENDSTOP_DEBOUNCE, 2, 8)
+  #error "ENDSTOP_DEBOUNCE must be from 2 to 8."
+#endif
+
+#ifdef HOMING_BUMP_SLOW_MM
+  static_assert(HOMING_BUMP_SLOW_MM > 0, "HOMING_BUMP_SLOW_MM must be above 0.");
+#endif
+
+#if defined(LCD_BOOT_ANIMATION_MS) && !WITHIN(LCD_BOOT_ANIMATION_MS, 0, 60000)
+  #error "LCD_BOOT_ANIMATION_MS must be between 0 and 60000."
+#endif
+
+/**
+ * Prefetched linear moves
+ */
+#if ENABLED(PREFETCH_LINEAR_MOVES)
+  #if DISABLED(FAST_LINEAR_MOVES)
+    #error "PREFETCH_LINEAR_MOVES requires FAST_LINEAR_MOVES."
+  #elif ENABLED(PARSED_COMMAND_QUEUE)
+    #error "PREFETCH_LINEAR_MOVES can't be used with PARSED_COMMAND_QUEUE, which parses lines as they're queued."
+  #endif
+#endif
+
+/**
+ * Shared queue pool
+ */
+#if ENABLED(SHARED_QUEUE_POOL)
+  #if !defined(MIN_PLANNER_BLOCKS) || !WITHIN(MIN_PLANNER_BLOCKS, 2, BLOCK_BUFFER_SIZE)
+    #error "MIN_PLANNER_BLOCKS must be between 2 and BLOCK_BUFFER_SIZE."
+  #elif !defined(MIN_COMMAND_SLOTS) || !WITHIN(MIN_COMMAND_SLOTS, 2, BUFSIZE)
+    #error "MIN_COMMAND_SLOTS must be between 2 and BUFSIZE."
+  #endif
+#endif
+
+#if ENABLED(BINARY_STREAMING)
+  #if DISABLED(PARSED_COMMAND_QUEUE)
+    #error "BINARY_STREAMING requires PARSED_COMMAND_QUEUE."
+  #elif !defined(BINARY_STREAMING_TIMEOUT) || BINARY_STREAMING_TIMEOUT < 10
+    #error "BINARY_STREAMING_TIMEOUT must be at least 10."
+  #endif
+#endif
+
+#if ENABLED(HOST_PLANNED_BLOCKS)
+  #if DISABLED(BINARY_STREAMING)
+    #error "HOST_PLANNED_BLOCKS requires BINARY_STREAMING."
+  #elif ENABLED(MIXING_EXTRUDER) || IS_KINEMATIC || IS_CORE
+    #error "HOST_PLANNED_BLOCKS requires a Cartesian machine without MIXING_EXTRUDER."
+  #endif
+#endif
+
+#if ENABLED(STEP_QUEUE_MODE)
+  #if DISABLED(BINARY_STREAMING)
+    #error "STEP_QUEUE_MODE requires BINARY_STREAMING."
+  #elif !defined(STEP_QUEUE_MOVES)
+    #error "STEP_QUEUE_MOVES is required for STEP_QUEUE_MODE."
+  #elif E_STEPPERS > 1 || ENABLED(MIXING_EXTRUDER)
+    #error "STEP_QUEUE_MODE supports a single extruder stepper."
+  #elif ENABLED(INPUT_SHAPING)
+    #error "STEP_QUEUE_MODE can't be used with INPUT_SHAPING. The host shapes the steps it sends."
+  #endif
+#endif
+
+#if ENABLED(COMPILED_MACROS) && DISABLED(PARSED_COMMAND_QUEUE)
+  #error "COMPILED_MACROS requires PARSED_COMMAND_QUEUE."
+#endif
+
+#if ENABLED(SD_BINARY_FILES)
+  #if DISABLED(PARSED_COMMAND_QUEUE)
+    #error "SD_BINARY_FILES requires PARSED_COMMAND_QUEUE."
+  #elif DISABLED(SDSUPPORT)
+    #error "SD_BINARY_FILES requires SDSUPPORT."
+  #endif
+#endif
+
+#if ENABLED(RX_LINE_FRAMING) && !defined(ARDUINO_SERIAL) && !defined(USBCON)
+  #error "RX_LINE_FRAMING requires the Arduino serial driver (ARDUINO_SERIAL)."
+#endif
+
+#if ENABLED(RESEND_WINDOW) && !WITHIN(RESEND_WINDOW_LINES, 1, 8)
+  #error "RESEND_WINDOW_LINES must be from 1 to 8."
+#endif
+
+/**
+ * Interrupt handler budgets, in the ticks they're measured in
+ */
+#if ENABLED(ISR_PROFILING)
+  #if !WITHIN(ISR_STEPPER_BUDGET, 8, 524280) || !WITHIN(ISR_ADVANCE_BUDGET, 8, 524280)
+    #error "ISR_STEPPER_BUDGET and ISR_ADVANCE_BUDGET must be from 8 to 524280 cycles."
+  #elif !WITHIN(ISR_TEMPERATURE_BUDGET, 64, 16320)
+    #error "ISR_TEMPERATURE_BUDGET must be from 64 to 16320 cycles, within a wrap of Timer 0."
+  #endif
+#endif
+
+/**
+ * Native USB host port
+ */
+#if SERIAL_PORT == -1
+  #if !defined(USBCON)
+    #error "SERIAL_PORT -1 requires an MCU with native USB (USBCON)."
+  #elif ENABLED(BLUETOOTH)
+    #error "SERIAL_PORT -1 can't be used with BLUETOOTH."
+  #elif ENABLED(RX_LINE_FRAMING) || ENABLED(TX_DROP_ECHO) || ENABLED(BAUD_RATE_GCODE)
+    #error "RX_LINE_FRAMING, TX_DROP_ECHO and BAUD_RATE_GCODE work on a UART, not SERIAL_PORT -1."
+  #endif
+#endif
+
+/**
+ * Model Heater Manager
+ */
+#if ENABLED(MODEL_HEATER_MANAGER)
+  static_assert(MODEL_HEATER_POWER > 0 && MODEL_RESPONSE_TIME > 0 && MODEL_HEAT_CAPACITY > 0, "MODEL_HEATER_POWER, MODEL_RESPONSE_TIME and MODEL_HEAT_CAPACITY must be greater than 0.");
+  static_assert(MODEL_FILAMENT_HEAT_CAPACITY >= 0 && MODEL_AMBIENT_LOSS >= 0 && MODEL_FAN_LOSS >= 0, "MODEL_FILAMENT_HEAT_CAPACITY, MODEL_AMBIENT_LOSS and MODEL_FAN_LOSS must not be negative.");
+#endif
+
 /**
  * Babystepping
  */
@@ -326,6 +715,14 @@
   #endif
 #endif
 
+#if ENABLED(QUICK_PAUSE) && ENABLED(PARK_HEAD_ON_PAUSE)
+  #error "QUICK_PAUSE can't be used with PARK_HEAD_ON_PAUSE, which parks after the queued moves."
+#endif
+
+#if ENABLED(QUICK_PAUSE_PARK) && DISABLED(QUICK_PAUSE)
+  #error "QUICK_PAUSE_PARK requires QUICK_PAUSE."
+#endif
+
 /**
  * Individual axis homing is useless for DELTAS
  */
@@ -850,6 +1247,32 @@ static_assert(1 >= 0
   #endif
 #endif
 
+#if ENABLED(ADC_FREE_RUNNING) && !WITHIN(ADC_FREE_RUNNING_SAMPLES, 1, 64)
+  #error "ADC_FREE_RUNNING_SAMPLES must be between 1 and 64."
+#endif
+
+/**
+ * Fan Hardware PWM needs the fan on OC3A, with timer 3 as the Arduino core sets it up
+ */
+#if ENABLED(FAN_HARDWARE_PWM)
+  #if FAN_PIN != 5
+    #error "FAN_HARDWARE_PWM requires FAN_PIN on OC3A (pin 5)."
+  #elif ENABLED(FAN_SOFT_PWM)
+    #error "FAN_HARDWARE_PWM can't be used with FAN_SOFT_PWM."
+  #elif ENABLED(FAST_PWM_FAN)
+    #error "FAN_HARDWARE_PWM can't be used with FAST_PWM_FAN, which changes timer 3's period."
+  #elif !WITHIN(FAN_HARDWARE_PWM_RAMP, 0, 255)
+    #error "FAN_HARDWARE_PWM_RAMP must be between 0 and 255."
+  #endif
+#endif
+
+/**
+ * Hotend Hardware PWM needs the heater on OC0B
+ */
+#if ENABLED(HOTEND_HARDWARE_PWM) && HEATER_0_PIN != 4
+  #error "HOTEND_HARDWARE_PWM requires HEATER_0_PIN on OC0B (pin 4)."
+#endif
+
 /**
  * Test Heater, Temp Sensor, and Extruder Pins; Sensor Type must also be set.
  */
@@ -973,6 +1396,24 @@ static_assert(1 >= 0
   #endif
 #endif
 
+/**
+ * S-curve acceleration changes the ramps that RAMP_TABLES replays
+ */
+#if ENABLED(S_CURVE_ACCELERATION) && ENABLED(RAMP_TABLES)
+  #error "S_CURVE_ACCELERATION and RAMP_TABLES are not compatible."
+#endif
+
+/**
+ * Endstop interrupts
+ *
+ * The Bi3 Plus endstops are wired to PF0 (X), PA2 (Y), PA1 (Z) and PA3 (probe).
+ * None of those pins has an external or a pin-change interrupt on the ATmega2560,
+ * so the stepper ISR has to keep polling them.
+ */
+#if ENABLED(ENDSTOP_INTERRUPTS_FEATURE)
+  #error "ENDSTOP_INTERRUPTS_FEATURE needs interrupt-capable endstop pins, and the Bi3 Plus endstop pins have none."
+#endif
+
 /**
  * Endstops
  */
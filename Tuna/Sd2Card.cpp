@@ -36,7 +36,82 @@
 #endif
 
 //------------------------------------------------------------------------------
-#if DISABLED(SOFTWARE_SPI)
+#ifdef SD_SPI_USART
+  // functions for a USART in Master SPI mode
+  //------------------------------------------------------------------------------
+  #define _SPI_USART_REG(A, N, B) A##N##B
+  #define SPI_USART_REG(A, N, B) _SPI_USART_REG(A, N, B)
+  #define SPI_UDR    SPI_USART_REG(UDR, SD_SPI_USART, )
+  #define SPI_UCSRA  SPI_USART_REG(UCSR, SD_SPI_USART, A)
+  #define SPI_UCSRB  SPI_USART_REG(UCSR, SD_SPI_USART, B)
+  #define SPI_UCSRC  SPI_USART_REG(UCSR, SD_SPI_USART, C)
+  #define SPI_UBRR   SPI_USART_REG(UBRR, SD_SPI_USART, )
+  #define SPI_RXC    SPI_USART_REG(RXC, SD_SPI_USART, )
+  #define SPI_UDRE   SPI_USART_REG(UDRE, SD_SPI_USART, )
+  #define SPI_RXEN   SPI_USART_REG(RXEN, SD_SPI_USART, )
+  #define SPI_TXEN   SPI_USART_REG(TXEN, SD_SPI_USART, )
+  #define SPI_UMSEL0 SPI_USART_REG(UMSEL, SD_SPI_USART, 0)
+  #define SPI_UMSEL1 SPI_USART_REG(UMSEL, SD_SPI_USART, 1)
+  /**
+   * Initialize the USART as an SPI master, mode 0, MSB first
+   * Set SCK rate to F_CPU/pow(2, 1 + spiRate) for spiRate [0,6]
+   */
+  static void spiInit(uint8_t spiRate) {
+    // XCK is an output (set in init()) before the USART is enabled, and the
+    // baud rate, F_CPU/(2 * (UBRR + 1)), is set last
+    SPI_UBRR = 0;
+    SPI_UCSRC = _BV(SPI_UMSEL1) | _BV(SPI_UMSEL0);
+    SPI_UCSRB = _BV(SPI_RXEN) | _BV(SPI_TXEN);
+    SPI_UBRR = (1 << spiRate) - 1;
+  }
+  //------------------------------------------------------------------------------
+  /** SPI receive a byte */
+  static uint8_t spiRec() {
+    SPI_UDR = 0XFF;
+    while (!TEST(SPI_UCSRA, SPI_RXC)) { /* Intentionally left empty */ }
+    return SPI_UDR;
+  }
+  //------------------------------------------------------------------------------
+  /**
+   * SPI read data. The transmitter is double buffered, so the next byte is
+   * queued while the last is shifted and the clock runs without gaps.
+   */
+  static inline __forceinline
+  void spiRead(uint8_t* buf, uint16_t nbyte) {
+    if (nbyte == 0) return;
+    SPI_UDR = 0XFF;
+    for (uint16_t i = 0; i < nbyte; i++) {
+      if (i + 1 < nbyte) {
+        while (!TEST(SPI_UCSRA, SPI_UDRE)) { /* Intentionally left empty */ }
+        SPI_UDR = 0XFF;
+      }
+      while (!TEST(SPI_UCSRA, SPI_RXC)) { /* Intentionally left empty */ }
+      buf[i] = SPI_UDR;
+    }
+  }
+  //------------------------------------------------------------------------------
+  /** SPI send a byte, dropping the byte received with it */
+  static void spiSend(uint8_t b) {
+    SPI_UDR = b;
+    while (!TEST(SPI_UCSRA, SPI_RXC)) { /* Intentionally left empty */ }
+    (void)SPI_UDR;
+  }
+  //------------------------------------------------------------------------------
+  /** SPI send block - only one call so force inline */
+  static inline __forceinline
+  void spiSendBlock(uint8_t token, const uint8_t* buf) {
+    SPI_UDR = token;
+    for (uint16_t i = 0; i < 512; i++) {
+      while (!TEST(SPI_UCSRA, SPI_UDRE)) { /* Intentionally left empty */ }
+      SPI_UDR = buf[i];
+      while (!TEST(SPI_UCSRA, SPI_RXC)) { /* Intentionally left empty */ }
+      (void)SPI_UDR;
+    }
+    while (!TEST(SPI_UCSRA, SPI_RXC)) { /* Intentionally left empty */ }
+    (void)SPI_UDR;
+  }
+  //------------------------------------------------------------------------------
+#elif DISABLED(SOFTWARE_SPI)
   // functions for hardware SPI
   //------------------------------------------------------------------------------
   // make sure SPCR rate is in expected bits
@@ -60,10 +135,49 @@
     return SPDR;
   }
   //------------------------------------------------------------------------------
-  /** SPI read data - only one call so force inline */
+  /**
+   * SPI read data. At F_CPU/2 a byte is shifted in 16 cycles, so rather than
+   * polling SPIF the loop is timed to 19 cycles a byte: SPDR is read 18 cycles
+   * after it was written, and the next byte is started on the cycle after.
+   * Interrupts only make the gap longer, which is harmless for a master.
+   */
   static inline __forceinline
   void spiRead(uint8_t* buf, uint16_t nbyte) {
     if (nbyte-- == 0) return;
+    if (nbyte && !(SPCR & (_BV(SPR1) | _BV(SPR0))) && TEST(SPSR, SPI2X)) {
+      __asm__ __volatile__
+      (
+        "out %[spdr], %[ff]"        "\n\t"  // first byte
+        "rjmp .+0"                  "\n\t"  // the 6 cycles of st, sbiw and brne
+        "rjmp .+0"                  "\n\t"
+        "rjmp .+0"                  "\n\t"
+        "1:"                        "\n\t"
+        "rjmp .+0"                  "\n\t"  // 11 cycles
+        "rjmp .+0"                  "\n\t"
+        "rjmp .+0"                  "\n\t"
+        "rjmp .+0"                  "\n\t"
+        "rjmp .+0"                  "\n\t"
+        "nop"                       "\n\t"
+        "in __tmp_reg__, %[spdr]"   "\n\t"
+        "out %[spdr], %[ff]"        "\n\t"  // next byte
+        "st %a[buf]+, __tmp_reg__"  "\n\t"
+        "sbiw %[n], 1"              "\n\t"
+        "brne 1b"                   "\n\t"
+        "rjmp .+0"                  "\n\t"  // the last byte: 11 cycles
+        "rjmp .+0"                  "\n\t"
+        "rjmp .+0"                  "\n\t"
+        "rjmp .+0"                  "\n\t"
+        "rjmp .+0"                  "\n\t"
+        "nop"                       "\n\t"
+        "in __tmp_reg__, %[spsr]"   "\n\t"  // reading SPSR, then SPDR, clears SPIF
+        "in __tmp_reg__, %[spdr]"   "\n\t"
+        "st %a[buf], __tmp_reg__"   "\n\t"
+        : [buf] "+e" (buf), [n] "+w" (nbyte)
+        : [spdr] "I" (_SFR_IO_ADDR(SPDR)), [spsr] "I" (_SFR_IO_ADDR(SPSR)), [ff] "r" (uint8_t(0XFF))
+        : "memory"
+      );
+      return;
+    }
     SPDR = 0XFF;
     for (uint16_t i = 0; i < nbyte; i++) {
       while (!TEST(SPSR, SPIF)) { /* Intentionally left empty */ }
@@ -164,6 +278,11 @@
 //------------------------------------------------------------------------------
 // send command and return error code.  Return zero for OK
 uint8_t Sd2Card::cardCommand(uint8_t cmd, uint32 arg) {
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    // any other command ends a multiple block read
+    if (streamBlock_ != 0XFFFFFFFF) readStop();
+  #endif
+
   // select card
   chipSelectLow();
 
@@ -223,6 +342,10 @@ void Sd2Card::chipSelectHigh() {
 }
 //------------------------------------------------------------------------------
 void Sd2Card::chipSelectLow() {
+  #if ENABLED(SD_READ_AHEAD)
+    // An asynchronous read holds the card selected until it's done
+    if (__unlikely(asyncLeft_)) readAsyncWait();
+  #endif
   #if DISABLED(SOFTWARE_SPI)
     spiInit(spiRate_);
   #endif  // SOFTWARE_SPI
@@ -243,6 +366,9 @@ void Sd2Card::chipSelectLow() {
  * the value zero, false, is returned for failure.
  */
 bool Sd2Card::erase(uint32 firstBlock, uint32 lastBlock) {
+  #if ENABLED(SD_READ_AHEAD)
+    asyncBlock_ = 0XFFFFFFFF;
+  #endif
   csd_t csd;
   if (!readCSD(&csd)) goto fail;
   // check for single block erase
@@ -299,6 +425,14 @@ bool Sd2Card::eraseSingleBlockEnable() {
 bool Sd2Card::init(uint8_t sckRateID, uint8_t chipSelectPin) {
   errorCode_ = type_ = 0;
   chipSelectPin_ = chipSelectPin;
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    streamBlock_ = 0XFFFFFFFF;
+    streamEnabled_ = false;
+  #endif
+  #if ENABLED(SD_READ_AHEAD)
+    asyncLeft_ = 0;
+    asyncBlock_ = 0XFFFFFFFF;
+  #endif
   // 16-bit init start time allows over a minute
   uint16_t t0 = (uint16_t)millis();
   uint32 arg;
@@ -392,6 +526,16 @@ fail:
  * the value zero, false, is returned for failure.
  */
 bool Sd2Card::readBlock(uint32 blockNumber, uint8_t* dst) {
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    if (streamEnabled_) {
+      // finish an asynchronous read first, as it can end the stream
+      chipSelectLow();
+      if ((blockNumber == streamBlock_ || readStart(blockNumber)) && readData(dst)) return true;
+      // end the stream and fall back to a single block read
+      readStop();
+    }
+  #endif
+
   // use address if not SDHC card
   if (type() != SD_CARD_TYPE_SDHC) blockNumber <<= 9;
 
@@ -430,7 +574,13 @@ bool Sd2Card::readBlock(uint32 blockNumber, uint8_t* dst) {
  */
 bool Sd2Card::readData(uint8_t* dst) {
   chipSelectLow();
-  return readData(dst, 512);
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    if (!readData(dst, 512)) return false;
+    ++streamBlock_;
+    return true;
+  #else
+    return readData(dst, 512);
+  #endif
 }
 
 #if ENABLED(SD_CHECK_AND_RETRY)
@@ -468,8 +618,7 @@ static const uint16_t crctab[] __flashmem = {
   0xEF1F, 0xFF3E, 0xCF5D, 0xDF7C, 0xAF9B, 0xBFBA, 0x8FD9, 0x9FF8,
   0x6E17, 0x7E36, 0x4E55, 0x5E74, 0x2E93, 0x3EB2, 0x0ED1, 0x1EF0
 };
-static uint16_t CRC_CCITT(const uint8_t* data, size_t n) {
-  uint16_t crc = 0;
+static uint16_t CRC_CCITT(const uint8_t* data, size_t n, uint16_t crc = 0) {
   for (size_t i = 0; i < n; i++) {
     crc = pgm_read_word(&crctab[(crc >> 8 ^ data[i]) & 0XFF]) ^ (crc << 8);
   }
@@ -544,11 +693,17 @@ fail:
  * the value zero, false, is returned for failure.
  */
 bool Sd2Card::readStart(uint32 blockNumber) {
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    const uint32 firstBlock = blockNumber;
+  #endif
   if (type() != SD_CARD_TYPE_SDHC) blockNumber <<= 9;
   if (__unlikely(cardCommand(CMD18, blockNumber))) {
     error(SD_CARD_ERROR_CMD18);
     goto fail;
   }
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    streamBlock_ = firstBlock;
+  #endif
   chipSelectHigh();
   return true;
 fail:
@@ -562,6 +717,10 @@ fail:
  * the value zero, false, is returned for failure.
  */
 bool Sd2Card::readStop() {
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    if (streamBlock_ == 0XFFFFFFFF) return true;
+    streamBlock_ = 0XFFFFFFFF;
+  #endif
   chipSelectLow();
   if (__unlikely(cardCommand(CMD12, 0))) {
     error(SD_CARD_ERROR_CMD12);
@@ -574,6 +733,137 @@ fail:
   return false;
 }
 //------------------------------------------------------------------------------
+#if ENABLED(SD_MULTIBLOCK_READ)
+/** Read blocks through a multiple block read (CMD18) while it's enabled.
+ *
+ * \param[in] enable true to read with CMD18, false to end the open read and go
+ * back to single block reads.
+ *
+ * \note readBlock() starts the read at the first block it's asked for and
+ * keeps it open while the following blocks are asked for in order. Reading any
+ * other block starts a new one, and any other command ends it.
+ */
+void Sd2Card::readStreamEnable(bool enable) {
+  streamEnabled_ = enable;
+  if (!enable) readStop();
+}
+#endif
+//------------------------------------------------------------------------------
+#if ENABLED(SD_READ_AHEAD)
+// Bytes an asynchronous read takes in one readAsyncStep(), about 70 us at full speed
+static constexpr uint16_t SD_ASYNC_CHUNK = 64;
+/** Start reading a block without waiting for it.
+ *
+ * \param[in] blockNumber Logical block to be read.
+ * \param[out] dst Pointer to the location that will receive the data. It has
+ * to stay valid until the read is finished.
+ *
+ * \note The data is read by readAsyncStep(), a piece at a time. The card stays
+ * selected until then, so any other access to the card finishes the read first.
+ *
+ * \return The value one, true, is returned for success and
+ * the value zero, false, is returned for failure.
+ */
+bool Sd2Card::readAsyncStart(uint32 blockNumber, uint8_t* dst) {
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    if (streamEnabled_) {
+      if (blockNumber != streamBlock_ && !readStart(blockNumber)) return false;
+      chipSelectLow();
+      ++streamBlock_;
+    }
+    else
+  #endif
+  {
+    const uint32 address = type() != SD_CARD_TYPE_SDHC ? blockNumber << 9 : blockNumber;
+    if (__unlikely(cardCommand(CMD17, address))) {
+      error(SD_CARD_ERROR_CMD17);
+      chipSelectHigh();
+      return false;
+    }
+  }
+  asyncBlock_ = blockNumber;
+  asyncDst_ = dst;
+  asyncLeft_ = 512;
+  asyncTime_ = millis();
+  asyncData_ = false;
+  #if ENABLED(SD_CHECK_AND_RETRY)
+    asyncCrc_ = 0;
+  #endif
+  return true;
+}
+//------------------------------------------------------------------------------
+/** Continue an asynchronous read: look for the start block token, or read the
+ * next SD_ASYNC_CHUNK bytes of the block.
+ *
+ * \return true once there is nothing left to do: the block is read, or the read
+ * failed and readAsyncBlock() is 0XFFFFFFFF.
+ */
+bool Sd2Card::readAsyncStep() {
+  if (!asyncLeft_) return true;
+  if (!asyncData_) {
+    if ((status_ = spiRec()) == 0XFF) {
+      if (((uint16_t)millis() - asyncTime_) <= SD_READ_TIMEOUT) return false;
+      error(SD_CARD_ERROR_READ_TIMEOUT);
+      goto fail;
+    }
+    if (__unlikely(status_ != DATA_START_BLOCK)) {
+      error(SD_CARD_ERROR_READ);
+      goto fail;
+    }
+    asyncData_ = true;
+    return false;
+  }
+  {
+    const uint16_t n = min(asyncLeft_, SD_ASYNC_CHUNK);
+    spiRead(asyncDst_, n);
+    #if ENABLED(SD_CHECK_AND_RETRY)
+      asyncCrc_ = CRC_CCITT(asyncDst_, n, asyncCrc_);
+    #endif
+    asyncDst_ += n;
+    asyncLeft_ -= n;
+    if (asyncLeft_) return false;
+  }
+  #if ENABLED(SD_CHECK_AND_RETRY)
+  {
+    uint16_t recvCrc = spiRec() << 8;
+    recvCrc |= spiRec();
+    if (asyncCrc_ != recvCrc) {
+      error(SD_CARD_ERROR_CRC);
+      goto fail;
+    }
+  }
+  #else
+    // discard CRC
+    spiRec();
+    spiRec();
+  #endif
+  chipSelectHigh();
+  // Send an additional dummy byte, required by Toshiba Flash Air SD Card
+  spiSend(0XFF);
+  return true;
+fail:
+  asyncLeft_ = 0;
+  asyncBlock_ = 0XFFFFFFFF;
+  chipSelectHigh();
+  spiSend(0XFF);
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    readStop();
+  #endif
+  return true;
+}
+//------------------------------------------------------------------------------
+/** Finish an asynchronous read.
+ *
+ * \return The value one, true, is returned if the buffer holds
+ * readAsyncBlock(), and the value zero, false, if there's no block or the
+ * read failed.
+ */
+bool Sd2Card::readAsyncWait() {
+  while (!readAsyncStep()) { /* Intentionally left empty */ }
+  return asyncBlock_ != 0XFFFFFFFF;
+}
+#endif // SD_READ_AHEAD
+//------------------------------------------------------------------------------
 /**
  * Set the SPI clock rate.
  *
@@ -615,6 +905,9 @@ fail:
  * the value zero, false, is returned for failure.
  */
 bool Sd2Card::writeBlock(uint32 blockNumber, const uint8_t* src) {
+  #if ENABLED(SD_READ_AHEAD)
+    if (blockNumber == asyncBlock_) asyncBlock_ = 0XFFFFFFFF;
+  #endif
   // use address if not SDHC card
   if (type() != SD_CARD_TYPE_SDHC) blockNumber <<= 9;
   if (__unlikely(cardCommand(CMD24, blockNumber))) {
@@ -640,6 +933,46 @@ fail:
   return false;
 }
 //------------------------------------------------------------------------------
+#if ENABLED(POWER_LOSS_RECOVERY)
+/**
+ * Write \a length bytes to a block, the rest of it zeroes, and return as soon
+ * as the card has taken them, without waiting for it to program the block.
+ * The next command waits for that, as every command does.
+ *
+ * \param[in] blockNumber Logical block to be written.
+ * \param[in] src Pointer to the location of the data to be written.
+ * \param[in] length Bytes of \a src, at most 512.
+ * \return The value one, true, is returned for success and
+ * the value zero, false, is returned for failure.
+ */
+bool Sd2Card::writeBlockNoWait(uint32 blockNumber, const uint8_t* src, uint16_t length) {
+  #if ENABLED(SD_READ_AHEAD)
+    if (blockNumber == asyncBlock_) asyncBlock_ = 0XFFFFFFFF;
+  #endif
+  // use address if not SDHC card
+  if (type() != SD_CARD_TYPE_SDHC) blockNumber <<= 9;
+  if (__unlikely(cardCommand(CMD24, blockNumber))) {
+    error(SD_CARD_ERROR_CMD24);
+    goto fail;
+  }
+  spiSend(DATA_START_BLOCK);
+  for (uint16_t i = 0; i < 512; i++) spiSend(i < length ? src[i] : 0);
+  spiSend(0xFF);  // dummy crc
+  spiSend(0xFF);  // dummy crc
+
+  status_ = spiRec();
+  if (__unlikely((status_ & DATA_RES_MASK) != DATA_RES_ACCEPTED)) {
+    error(SD_CARD_ERROR_WRITE);
+    goto fail;
+  }
+  chipSelectHigh();
+  return true;
+fail:
+  chipSelectHigh();
+  return false;
+}
+#endif
+//------------------------------------------------------------------------------
 /** Write one data block in a multiple block write sequence
  * \param[in] src Pointer to the location of the data to be written.
  * \return The value one, true, is returned for success and
@@ -688,6 +1021,9 @@ fail:
  * the value zero, false, is returned for failure.
  */
 bool Sd2Card::writeStart(uint32 blockNumber, uint32 eraseCount) {
+  #if ENABLED(SD_READ_AHEAD)
+    asyncBlock_ = 0XFFFFFFFF;
+  #endif
   // send pre-erase count
   if (__unlikely(cardAcmd(ACMD23, eraseCount))) {
     error(SD_CARD_ERROR_ACMD23);
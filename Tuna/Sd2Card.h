@@ -132,7 +132,30 @@ uint8_t const SD_CARD_TYPE_SDHC = 3;
 //------------------------------------------------------------------------------
 // SPI pin definitions - do not edit here - change in SdFatConfig.h
 //
-#if DISABLED(SOFTWARE_SPI)
+#ifdef SD_SPI_USART
+  #if ENABLED(SOFTWARE_SPI)
+    #error "SD_SPI_USART can't be used with software SPI."
+  #endif
+  // USART in Master SPI mode: TXD is MOSI, RXD is MISO and XCK is SCK
+  /** The default chip select pin for the SD card is SS. */
+  #define SD_CHIP_SELECT_PIN SS_PIN
+  #if SD_SPI_USART == 0
+    #define SPI_MOSI_PIN 1
+    #define SPI_MISO_PIN 0
+  #elif SD_SPI_USART == 1
+    #define SPI_MOSI_PIN 18
+    #define SPI_MISO_PIN 19
+  #elif SD_SPI_USART == 2
+    #define SPI_MOSI_PIN 16
+    #define SPI_MISO_PIN 17
+  #elif SD_SPI_USART == 3
+    #define SPI_MOSI_PIN 14
+    #define SPI_MISO_PIN 15
+  #endif
+  /** SPI Clock pin */
+  #define SPI_SCK_PIN SD_SPI_USART_XCK_PIN
+
+#elif DISABLED(SOFTWARE_SPI)
   // hardware pin defs
   /** The default chip select pin for the SD card is SS. */
   #define SD_CHIP_SELECT_PIN SS_PIN
@@ -213,12 +236,31 @@ class Sd2Card final {
   bool readData(uint8_t* dst);
   bool readStart(uint32 blockNumber);
   bool readStop();
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    void readStreamEnable(bool enable);
+  #endif
+  #if ENABLED(SD_READ_AHEAD)
+    bool readAsyncStart(uint32 blockNumber, uint8_t* dst);
+    bool readAsyncStep();
+    bool readAsyncWait();
+    /** \return true while a block read by readAsyncStart() isn't finished. */
+    bool readAsyncBusy() const {return asyncLeft_ != 0;}
+    /**
+     * \return The block being read into, or last read into, the readAsyncStart()
+     * buffer, or 0XFFFFFFFF if there is none or the read failed. Writing the
+     * block forgets it.
+     */
+    uint32 readAsyncBlock() const {return asyncBlock_;}
+  #endif
   bool setSckRate(uint8_t sckRateID);
   /** Return the card type: SD V1, SD V2 or SDHC
    * \return 0 - SD V1, 1 - SD V2, or 3 - SDHC.
    */
   int type() const {return type_;}
   bool writeBlock(uint32 blockNumber, const uint8_t* src);
+  #if ENABLED(POWER_LOSS_RECOVERY)
+    bool writeBlockNoWait(uint32 blockNumber, const uint8_t* src, uint16_t length);
+  #endif
   bool writeData(const uint8_t* src);
   bool writeStart(uint32 blockNumber, uint32 eraseCount);
   bool writeStop();
@@ -229,6 +271,20 @@ class Sd2Card final {
   uint8_t spiRate_;
   uint8_t status_;
   uint8_t type_;
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    uint32 streamBlock_ = 0XFFFFFFFF;  // next block of the open CMD18 read, or none
+    bool streamEnabled_ = false;       // read blocks through CMD18
+  #endif
+  #if ENABLED(SD_READ_AHEAD)
+    uint32 asyncBlock_ = 0XFFFFFFFF;  // block of the asynchronous read
+    uint8_t* asyncDst_;                // where its next bytes go
+    uint16_t asyncLeft_ = 0;           // bytes still to read, 0 if none
+    uint16_t asyncTime_;               // millis() when it started, for SD_READ_TIMEOUT
+    bool asyncData_;                   // past the start block token
+    #if ENABLED(SD_CHECK_AND_RETRY)
+      uint16_t asyncCrc_;
+    #endif
+  #endif
   // private functions
   uint8_t cardAcmd(uint8_t cmd, uint32 arg) {
     cardCommand(CMD55, 0);
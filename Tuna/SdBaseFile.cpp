@@ -38,9 +38,15 @@ SdBaseFile* SdBaseFile::cwd_ = 0;
 // callback function for date/time
 void (*SdBaseFile::dateTime_)(uint16_t* date, uint16_t* time) = 0;
 //------------------------------------------------------------------------------
-// add a cluster to a file
-bool SdBaseFile::addCluster() {
-  if (__unlikely(!vol_->allocContiguous(1, &curCluster_))) goto fail;
+// add a cluster to a file, or a run of count clusters if one is free
+bool SdBaseFile::addCluster(uint8_t count) {
+  #if ENABLED(SD_CLUSTER_MAP)
+    clusterMap_ = nullptr;
+  #endif
+  if (__unlikely(!vol_->allocContiguous(count, &curCluster_))) {
+    // no run that long, take what's left one at a time
+    if (count == 1 || !vol_->allocContiguous(1, &curCluster_)) goto fail;
+  }
 
   // if first cluster of file link to directory entry
   if (firstCluster_ == 0) {
@@ -101,6 +107,9 @@ fail:
 bool SdBaseFile::close() {
   bool rtn = sync();
   type_ = FAT_FILE_TYPE_CLOSED;
+  #if ENABLED(SD_CLUSTER_MAP)
+    clusterMap_ = nullptr;
+  #endif
   return rtn;
 }
 //------------------------------------------------------------------------------
@@ -1036,6 +1045,86 @@ int16_t __forceinline SdBaseFile::read() {
   return read(&b, 1) == 1 ? b : -1;
 }
 //------------------------------------------------------------------------------
+// read(read_cursor_t&) outside the cached block: read() leaves the byte's block
+// in the volume cache, so the cursor can point at it for the bytes that follow.
+int16_t SdBaseFile::readCursorMiss(read_cursor_t &cursor) {
+  const int16_t c = read();
+  if (c >= 0) {
+    cursor.block = vol_->cacheBlockNumber();
+    cursor.index = (curPosition_ - 1) >> 9;
+  }
+  return c;
+}
+//------------------------------------------------------------------------------
+#if ENABLED(SD_CLUSTER_MAP)
+/**
+ * Map the file's cluster chain into \a map, walking the FAT once, and use it
+ * for reads and seeks until the file is closed or grows. \a map has to stay
+ * valid until then.
+ *
+ * \return The value one, true, is returned for success and
+ * the value zero, false, is returned for failure: the file isn't a normal
+ * file or the FAT couldn't be read, and the FAT is used as before.
+ */
+bool SdBaseFile::mapClusters(cluster_map_t* map) {
+  clusterMap_ = nullptr;
+  if (!isFile()) return false;
+  map->firstCluster = firstCluster_;
+  map->runs = 0;
+  if (firstCluster_ && fileSize_) {
+    // clusters the file uses; the chain can be longer
+    uint32 remaining = ((fileSize_ - 1) >> (vol_->clusterSizeShift_ + 9)) + 1;
+    uint32 cluster = firstCluster_;
+    cluster_run_t* run = nullptr;
+    for (;;) {
+      if (run && cluster == run->cluster + run->count && run->count != 0XFFFF) {
+        ++run->count;
+      }
+      else {
+        if (map->runs == SD_CLUSTER_MAP_RUNS) break;
+        run = &map->run[map->runs++];
+        run->cluster = cluster;
+        run->count = 1;
+      }
+      if (!--remaining) break;
+      if (!vol_->fatGet(cluster, &cluster) || vol_->isEOC(cluster)) return false;
+    }
+  }
+  clusterMap_ = map;
+  return true;
+}
+//------------------------------------------------------------------------------
+// The file's cluster number 'index', counting firstCluster_ as 0, from the
+// cluster map, or 0 if it isn't mapped.
+uint32 SdBaseFile::mappedCluster(uint32 index) const {
+  if (!clusterMap_ || clusterMap_->firstCluster != firstCluster_) return 0;
+  for (uint8_t i = 0; i < clusterMap_->runs; ++i) {
+    const cluster_run_t &run = clusterMap_->run[i];
+    if (index < run.count) return run.cluster + index;
+    index -= run.count;
+  }
+  return 0;
+}
+#endif
+//------------------------------------------------------------------------------
+#if ENABLED(SD_READ_AHEAD)
+/**
+ * Read the file's next unread block ahead into the volume's read-ahead buffer,
+ * a piece per call, so it is ready when read() reaches it. Only blocks in the
+ * current cluster are read ahead: finding the next cluster takes a FAT read,
+ * which would throw the block being read out of the cache.
+ */
+void SdBaseFile::readAhead() {
+  if (!isFile() || !(flags_ & O_READ) || !curCluster_) return;
+  // start of the first block not read yet
+  const uint32 position = (curPosition_ + 0X1FF) & ~uint32(0X1FF);
+  if (position >= fileSize_) return;
+  const uint8_t blockOfCluster = vol_->blockOfCluster(position);
+  if (!blockOfCluster) return;
+  vol_->readAhead(vol_->clusterStartBlock(curCluster_) + blockOfCluster);
+}
+#endif
+//------------------------------------------------------------------------------
 /** Read data from a file starting at the current position.
  *
  * \param[out] buf Pointer to the location that will receive the data.
@@ -1077,6 +1166,12 @@ int16_t __forceinline __flatten SdBaseFile::read(void* buf, uint16_t nbyte) {
           curCluster_ = firstCluster_;
         }
         else {
+          #if ENABLED(SD_CLUSTER_MAP)
+            const uint32 next = mappedCluster(curPosition_ >> (vol_->clusterSizeShift_ + 9));
+            if (next)
+              curCluster_ = next;
+            else
+          #endif
           // get next cluster from FAT
           if (__unlikely(!vol_->fatGet(curCluster_, &curCluster_))) goto fail;
         }
@@ -1468,6 +1563,17 @@ bool SdBaseFile::seekSet(uint32 pos) {
   nCur = (curPosition_ - 1) >> (vol_->clusterSizeShift_ + 9);
   nNew = (pos - 1) >> (vol_->clusterSizeShift_ + 9);
 
+  #if ENABLED(SD_CLUSTER_MAP)
+  {
+    const uint32 mapped = mappedCluster(nNew);
+    if (mapped) {
+      curCluster_ = mapped;
+      curPosition_ = pos;
+      goto done;
+    }
+  }
+  #endif
+
   if (nNew < nCur || curPosition_ == 0) {
     // must follow chain from first cluster
     curCluster_ = firstCluster_;
@@ -1525,6 +1631,7 @@ bool SdBaseFile::sync() {
     // clear directory dirty
     flags_ &= ~F_FILE_DIR_DIRTY;
   }
+  if (!vol_->fsInfoSync()) goto fail;
   return vol_->cacheFlush();
 
 fail:
@@ -1661,6 +1768,9 @@ fail:
  */
 bool SdBaseFile::truncate(uint32 length) {
   uint32 newPos;
+  #if ENABLED(SD_CLUSTER_MAP)
+    clusterMap_ = nullptr;
+  #endif
   // error if not a normal file or read-only
   if (!isFile() || !(flags_ & O_WRITE)) goto fail;
 
@@ -1745,7 +1855,7 @@ int16_t SdBaseFile::write(const void* buf, uint16_t nbyte) {
       if (curCluster_ == 0) {
         if (firstCluster_ == 0) {
           // allocate first cluster of file
-          if (!addCluster()) goto fail;
+          if (!addCluster(writeAllocCount())) goto fail;
         }
         else {
           curCluster_ = firstCluster_;
@@ -1756,7 +1866,7 @@ int16_t SdBaseFile::write(const void* buf, uint16_t nbyte) {
         if (!vol_->fatGet(curCluster_, &next)) goto fail;
         if (vol_->isEOC(next)) {
           // add cluster if at end of chain
-          if (!addCluster()) goto fail;
+          if (!addCluster(writeAllocCount())) goto fail;
         }
         else {
           curCluster_ = next;
@@ -290,6 +290,62 @@ class SdBaseFile {
   static void printFatTime(uint16_t fatTime);
   bool printName();
   int16_t __forceinline read();
+  /**
+   * Where a byte-at-a-time reader is in the volume cache: the device block of the
+   * last byte read, and which block of the file that is. Reset it to {} when the
+   * file is opened.
+   */
+  struct read_cursor_t {
+    uint32 block = 0xFFFFFFFF;
+    uint32 index = 0xFFFFFFFF;
+  };
+  /**
+   * Read the next byte, as read() does. While the position is in the block the
+   * cursor last read from, and that block is still in the volume cache, the byte
+   * is taken straight from the cache, without read()'s checks and cluster walk.
+   */
+  int16_t __forceinline read(read_cursor_t &cursor) {
+    if (__likely((curPosition_ >> 9) == cursor.index && curPosition_ < fileSize_ && vol_->cacheBlockNumber() == cursor.block))
+      return vol_->cache()->data[curPosition_++ & 0X1FF];
+    return readCursorMiss(cursor);
+  }
+  #if ENABLED(SD_BLOCK_SCAN)
+    /**
+     * The bytes read(cursor) would take straight from the cache, from the
+     * position to the end of the block or the file, without reading them.
+     * Returns 0 if the next byte needs read(cursor) to get its block.
+     */
+    uint16_t __forceinline peek(const read_cursor_t &cursor, const uint8_t *&data) {
+      if (!((curPosition_ >> 9) == cursor.index && curPosition_ < fileSize_ && vol_->cacheBlockNumber() == cursor.block))
+        return 0;
+      const uint16_t offset = curPosition_ & 0X1FF;
+      data = vol_->cache()->data + offset;
+      return uint16_t(min(uint32(512 - offset), fileSize_ - curPosition_));
+    }
+    /** Move past \a n of the bytes peek() gave, which stays within the cached block. */
+    void __forceinline skipPeeked(const uint16_t n) { curPosition_ += n; }
+  #endif
+  #if ENABLED(SD_READ_AHEAD)
+    void readAhead();
+  #endif
+  #if ENABLED(SD_CLUSTER_MAP)
+    /** A run of consecutive clusters of a file. */
+    struct cluster_run_t {
+      uint32 cluster;  // first cluster of the run
+      uint16_t count;  // clusters in the run
+    };
+    /**
+     * A file's cluster chain as runs of consecutive clusters, in file order,
+     * so reads and seeks don't need the FAT. A chain with more runs than fit
+     * is mapped as far as it goes, and the FAT is used past that.
+     */
+    struct cluster_map_t {
+      uint32 firstCluster;  // the file it belongs to
+      uint8_t runs;
+      cluster_run_t run[SD_CLUSTER_MAP_RUNS];
+    };
+    bool mapClusters(cluster_map_t* map);
+  #endif
   int16_t __forceinline __flatten read(void* buf, uint16_t nbyte);
   int8_t readDir(dir_t* dir, char* longFilename);
   static bool remove(SdBaseFile* dirFile, const char* path);
@@ -328,6 +384,14 @@ class SdBaseFile {
   /** \return SdVolume that contains this file. */
   SdVolume* volume() const {return vol_;}
   int16_t write(const void* buf, uint16_t nbyte);
+  #if ENABLED(SD_WRITE_BUFFER)
+    /**
+     * Have write() add \a count clusters at a time as the file grows, as one
+     * run when the card has one free, so the FAT is updated once a run. Those
+     * past the end of the file stay in its chain until truncate() frees them.
+     */
+    void setAllocCount(uint8_t count) {allocCount_ = count;}
+  #endif
   //------------------------------------------------------------------------------
  private:
   // allow SdFat to set cwd_
@@ -353,11 +417,28 @@ class SdBaseFile {
   uint32  fileSize_;      // file size in bytes
   uint32  firstCluster_;  // first cluster of file
   SdVolume* vol_;           // volume where file is located
+  #if ENABLED(SD_CLUSTER_MAP)
+    cluster_map_t* clusterMap_ = nullptr;  // chain map from mapClusters()
+  #endif
+  #if ENABLED(SD_WRITE_BUFFER)
+    uint8_t allocCount_ = 1;  // clusters write() adds at a time
+  #endif
 
   /** experimental don't use */
   bool openParent(SdBaseFile* dir);
   // private functions
-  bool addCluster();
+  bool addCluster(uint8_t count = 1);
+  uint8_t writeAllocCount() const {
+    #if ENABLED(SD_WRITE_BUFFER)
+      return allocCount_;
+    #else
+      return 1;
+    #endif
+  }
+  int16_t readCursorMiss(read_cursor_t &cursor);
+  #if ENABLED(SD_CLUSTER_MAP)
+    uint32 mappedCluster(uint32 index) const;
+  #endif
   bool addDirCluster();
   dir_t* cacheDirEntry(uint8_t action);
   int8_t lsPrintNext(uint8_t flags, uint8_t indent);
@@ -38,6 +38,9 @@
   Sd2Card* SdVolume::sdCard_;            // pointer to SD card object
   bool     SdVolume::cacheDirty_;        // cacheFlush() will write block if true
   uint32 SdVolume::cacheMirrorBlock_;  // mirror  block for second FAT
+  #if ENABLED(SD_READ_AHEAD)
+    cache_t  SdVolume::readAheadBuffer_; // block being read ahead of the cache
+  #endif
 #endif  // USE_MULTIPLE_CARDS
 //------------------------------------------------------------------------------
 // find a contiguous group of clusters
@@ -59,6 +62,15 @@ bool SdVolume::allocContiguous(uint32 count, uint32* curCluster) {
 
     // don't save new start location
     setStart = false;
+
+    // The cluster after the file is taken: look from the likely place for a free cluster, not
+    // through the clusters in use after the file.
+    uint32 f = 0;
+    if (bgnCluster <= fatEnd && !fatGet(bgnCluster, &f)) goto fail;
+    if (bgnCluster > fatEnd || f != 0) {
+      bgnCluster = allocSearchStart_;
+      setStart = count == 1;
+    }
   }
   else {
     // start at likely place for free cluster
@@ -107,7 +119,7 @@ bool SdVolume::allocContiguous(uint32 count, uint32* curCluster) {
   *curCluster = bgnCluster;
 
   // remember possible next free cluster
-  if (setStart) allocSearchStart_ = bgnCluster + 1;
+  if (setStart) setAllocSearchStart(bgnCluster + 1);
 
   return true;
 fail:
@@ -136,6 +148,11 @@ fail:
 bool SdVolume::cacheRawBlock(uint32 blockNumber, bool dirty) {
   if (cacheBlockNumber_ != blockNumber) {
     if (!cacheFlush()) goto fail;
+    #if ENABLED(SD_READ_AHEAD)
+      if (blockNumber == sdCard_->readAsyncBlock() && sdCard_->readAsyncWait())
+        memcpy(cacheBuffer_.data, readAheadBuffer_.data, 512);
+      else
+    #endif
     if (!sdCard_->readBlock(blockNumber, cacheBuffer_.data)) goto fail;
     cacheBlockNumber_ = blockNumber;
   }
@@ -145,6 +162,19 @@ fail:
   return false;
 }
 //------------------------------------------------------------------------------
+#if ENABLED(SD_READ_AHEAD)
+// Move the read of a block into the read-ahead buffer along, or start it.
+// cacheRawBlock() takes the block from there once it's wanted.
+void SdVolume::readAhead(uint32 blockNumber) {
+  if (sdCard_->readAsyncBusy()) {
+    sdCard_->readAsyncStep();
+    return;
+  }
+  if (blockNumber == cacheBlockNumber_ || blockNumber == sdCard_->readAsyncBlock()) return;
+  sdCard_->readAsyncStart(blockNumber, readAheadBuffer_.data);
+}
+#endif
+//------------------------------------------------------------------------------
 // return the size in bytes of a cluster chain
 bool SdVolume::chainSize(uint32 cluster, uint32* size) {
   uint32 s = 0;
@@ -266,15 +296,15 @@ fail:
 bool SdVolume::freeChain(uint32 cluster) {
   uint32 next;
 
-  // clear free cluster location
-  allocSearchStart_ = 2;
-
   do {
     if (!fatGet(cluster, &next)) goto fail;
 
     // free cluster
     if (!fatPut(cluster, 0)) goto fail;
 
+    // the search starts no later than a free cluster
+    if (cluster < allocSearchStart_) setAllocSearchStart(cluster);
+
     cluster = next;
   } while (!isEOC(cluster));
 
@@ -342,6 +372,8 @@ bool SdVolume::init(Sd2Card* dev, uint8_t part) {
   sdCard_ = dev;
   fatType_ = 0;
   allocSearchStart_ = 2;
+  fsInfoBlock_ = 0;
+  fsInfoDirty_ = false;
   cacheDirty_ = 0;  // cacheFlush() will write block if true
   cacheMirrorBlock_ = 0;
   cacheBlockNumber_ = 0XFFFFFFFF;
@@ -412,9 +444,32 @@ bool SdVolume::init(Sd2Card* dev, uint8_t part) {
   else {
     rootDirStart_ = fbs->fat32RootCluster;
     fatType_ = 32;
+
+    // Start the search at the next free cluster hint the last writer of the volume left in
+    // FSINFO, rather than at the start of a full card. A volume with no valid FSINFO is used
+    // without one.
+    if (fbs->fat32FSInfo && cacheRawBlock(volumeStartBlock + fbs->fat32FSInfo, CACHE_FOR_READ)) {
+      const fat32_fsinfo_t* fsi = &cacheBuffer_.fsinfo;
+      if (fsi->leadSignature == FSINFO_LEAD_SIG && fsi->structSignature == FSINFO_STRUCT_SIG) {
+        fsInfoBlock_ = cacheBlockNumber_;
+        if (fsi->nextFree >= 2 && fsi->nextFree <= clusterCount_ + 1)
+          allocSearchStart_ = fsi->nextFree;
+      }
+    }
   }
   return true;
 fail:
   return false;
 }
+//------------------------------------------------------------------------------
+// Put allocSearchStart_ back in FSINFO as the next free cluster hint, for the next
+// mount. The free count isn't kept, so it's left as unknown.
+bool SdVolume::fsInfoSync() {
+  if (!fsInfoDirty_) return true;
+  if (!cacheRawBlock(fsInfoBlock_, CACHE_FOR_WRITE)) return false;
+  cacheBuffer_.fsinfo.nextFree = allocSearchStart_;
+  cacheBuffer_.fsinfo.freeCount = 0XFFFFFFFF;
+  fsInfoDirty_ = false;
+  return true;
+}
 #endif
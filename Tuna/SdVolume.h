@@ -141,14 +141,22 @@ class SdVolume final {
   Sd2Card* sdCard_;            // Sd2Card object for cache
   bool cacheDirty_;            // cacheFlush() will write block if true
   uint32 cacheMirrorBlock_;  // block number for mirror FAT
+  #if ENABLED(SD_READ_AHEAD)
+    cache_t readAheadBuffer_;  // block being read ahead of the cache
+  #endif
 #else  // USE_MULTIPLE_CARDS
   static cache_t cacheBuffer_;        // 512 byte cache for device blocks
   static uint32 cacheBlockNumber_;  // Logical number of block in the cache
   static Sd2Card* sdCard_;            // Sd2Card object for cache
   static bool cacheDirty_;            // cacheFlush() will write block if true
   static uint32 cacheMirrorBlock_;  // block number for mirror FAT
+  #if ENABLED(SD_READ_AHEAD)
+    static cache_t readAheadBuffer_;  // block being read ahead of the cache
+  #endif
 #endif  // USE_MULTIPLE_CARDS
   uint32 allocSearchStart_;   // start cluster for alloc search
+  uint32 fsInfoBlock_;        // FSINFO sector of a FAT32 volume, 0 for none
+  bool fsInfoDirty_;            // allocSearchStart_ moved since FSINFO was written
   uint8_t blocksPerCluster_;    // cluster size in blocks
   uint32 blocksPerFat_;       // FAT size in blocks
   uint32 clusterCount_;       // clusters in one FAT
@@ -161,6 +169,11 @@ class SdVolume final {
   uint32 rootDirStart_;       // root start block for FAT16, cluster for FAT32
   //----------------------------------------------------------------------------
   bool allocContiguous(uint32 count, uint32* curCluster);
+  void setAllocSearchStart(uint32 cluster) {
+    allocSearchStart_ = cluster;
+    fsInfoDirty_ = fsInfoBlock_ != 0;
+  }
+  bool fsInfoSync();
   uint8_t blockOfCluster(uint32 position) const {
     return (position >> 9) & (blocksPerCluster_ - 1);
   }
@@ -179,6 +192,9 @@ class SdVolume final {
   static bool cacheFlush();
   static bool cacheRawBlock(uint32 blockNumber, bool dirty);
 #endif  // USE_MULTIPLE_CARDS
+#if ENABLED(SD_READ_AHEAD)
+  void readAhead(uint32 blockNumber);
+#endif
   // used by SdBaseFile write to assign cache to SD location
   void cacheSetBlockNumber(uint32 blockNumber, bool dirty) {
     cacheDirty_ = dirty;
@@ -1,212 +1,129 @@
 #pragma once
 
+// Moves for the firmware itself, such as the LCD's, which go straight to the planner instead of
+// being written out as G-code for the parser to read back. Values are always in millimeters and
+// mm/min, whatever G20/G21 set, and the modal G-code feedrate is left as it was.
 namespace Tuna::VM
 {
   template <typename T> constexpr const T NONE;
   template<> constexpr const float NONE<float> = type_trait<float>::max;
   template<> constexpr const int32 NONE<int32> = type_trait<int32>::max;
 
+  // Waits for every move queued so far to finish. It runs idle() while it waits, so it can't be
+  // called from anything idle() calls, such as the LCD handlers.
   extern void await_queue();
 
+  // Whether 'moves' moves can be queued now without waiting. The LCD handlers run in idle(),
+  // which is also called from within commands and from a planner waiting for room, so they
+  // may only move when no command is queued or running and the planner has room.
+  extern bool can_queue(arg_type<uint8> moves = 1);
+
   template <MovementType speed, MovementMode move_mode>
   void linear_move(arg_type<float> X, arg_type<float> Y, arg_type<float> Z, arg_type<float> E = NONE<float>, arg_type<float> FeedRate = NONE<float>);
 
   template <MovementType speed, MovementMode move_mode>
   void extrude(arg_type<float> E, arg_type<float> FeedRate = NONE<float>);
-}
-
-inline void Tuna::VM::await_queue()
-{
-}
-
-template <MovementType speed, MovementMode move_mode>
-inline void Tuna::VM::linear_move(arg_type<float> X, arg_type<float> Y, arg_type<float> Z, arg_type<float> E, arg_type<float> FeedRate)
-{
-  if (__unlikely(!is_running()))
-  {
-    return;
-  }
-
-  constexpr const auto none = NONE<float>;
-  constexpr const bool feed_param = (speed != MovementType::Rapid);
-
-  float max_feedrate = 0.0f;
-
-  // TODO Fix for this:
-#if ENABLED(INCH_MODE_SUPPORT)
-  static_assert(false, "Need to add inch mode support.");
-#endif
 
-  const auto axial_move = [&](AxisEnum axis, arg_type<float> value)
+  namespace _internal
   {
-    if (value != none)
+    template <MovementMode move_mode>
+    inline void set_destination(AxisEnum axis, arg_type<float> value)
     {
-      MovementMode move_mode_local = move_mode;
-      if (move_mode == MovementMode::Modal)
-      {
-        move_mode_local = (axis_relative_modes[axis] || relative_mode) ? MovementMode::Relative : MovementMode::Absolute;
-      }
-
-      if (move_mode_local == MovementMode::Relative)
+      if (value == NONE<float>)
       {
-        destination[axis] = value + current_position[axis];
-      }
-      else // Absolute
-      {
-        destination[axis] = value;
+        destination[axis] = current_position[axis];
+        return;
       }
 
-      if constexpr (!feed_param)
+      MovementMode move_mode_local = move_mode;
+      if (move_mode == MovementMode::Modal)
       {
-        max_feedrate = max(max_feedrate, planner.max_feedrate_mm_s[axis]);
+        move_mode_local = (axis_relative_modes[axis] || relative_mode) ? MovementMode::Relative : MovementMode::Absolute;
       }
-    }
-    else
-    {
-      destination[uint8(axis)] = current_position[uint8(axis)];
-    }
-  };
-
-  axial_move(X_AXIS, X);
-  axial_move(Y_AXIS, Y);
-  axial_move(Z_AXIS, Z);
-  axial_move(E_AXIS, E);
 
-  if constexpr (feed_param)
-  {
-    if (FeedRate != none)
-    {
-      feedrate_mm_s = MMM_TO_MMS(FeedRate);
+      destination[axis] = (move_mode_local == MovementMode::Relative) ? (value + current_position[axis]) : value;
     }
-  }
-  else
-  {
-    feedrate_mm_s = max_feedrate;
-  }
 
-  if (E != none)
-  {
-    if (!DEBUGGING(DRYRUN))
+    // Sets feedrate_mm_s as G0/G1 would, and plans the move to 'destination'.
+    template <MovementType speed>
+    inline void move_to_destination(arg_type<float> FeedRate)
     {
-      if constexpr (move_mode == MovementMode::Relative)
+      if constexpr (speed == MovementType::Rapid)
       {
-        print_job_timer.incFilamentUsed(E);
+        // As G0, the slowest maximum of the axes that move
+        float max_feedrate = type_trait<float>::max;
+        LOOP_XYZE(i)
+        {
+          if (destination[i] != current_position[i])
+          {
+            max_feedrate = min(max_feedrate, planner.max_feedrate_mm_s[i]);
+          }
+        }
+        if (max_feedrate == type_trait<float>::max)
+        {
+          return;
+        }
+        feedrate_mm_s = max_feedrate;
       }
       else
       {
-        print_job_timer.incFilamentUsed(destination[E_AXIS] - current_position[E_AXIS]);
+        feedrate_mm_s = (FeedRate != NONE<float>) ? MMM_TO_MMS(FeedRate) : last_param_feedrate_mm_s;
       }
-    }
-  }
 
-  // perform move.
-  clamp_to_software_endstops(destination);
-  refresh_cmd_timeout();
+      clamp_to_software_endstops(destination);
+      refresh_cmd_timeout();
 
-  if (E != none && !DEBUGGING(DRYRUN)) {
-    if (Temperature::is_coldextrude()) {
-      current_position[E_AXIS] = destination[E_AXIS]; // Behave as if the move really took place, but ignore E part
-      SERIAL_ECHO_START();
-      SERIAL_ECHOLNPGM(MSG_ERR_COLD_EXTRUDE_STOP);
-    }
+      if (destination[E_AXIS] != current_position[E_AXIS] && !DEBUGGING(DRYRUN)) {
+        if (Temperature::is_coldextrude()) {
+          current_position[E_AXIS] = destination[E_AXIS]; // Behave as if the move really took place, but ignore E part
+          SERIAL_ECHO_START();
+          SERIAL_ECHOLNPGM(MSG_ERR_COLD_EXTRUDE_STOP);
+        }
 #if ENABLED(PREVENT_LENGTHY_EXTRUDE)
-    if (destination[E_AXIS] - current_position[E_AXIS] > EXTRUDE_MAXLENGTH) {
-      current_position[E_AXIS] = destination[E_AXIS]; // Behave as if the move really took place, but ignore E part
-      SERIAL_ECHO_START();
-      SERIAL_ECHOLNPGM(MSG_ERR_LONG_EXTRUDE_STOP);
-    }
+        if (destination[E_AXIS] - current_position[E_AXIS] > EXTRUDE_MAXLENGTH) {
+          current_position[E_AXIS] = destination[E_AXIS]; // Behave as if the move really took place, but ignore E part
+          SERIAL_ECHO_START();
+          SERIAL_ECHOLNPGM(MSG_ERR_LONG_EXTRUDE_STOP);
+        }
 #endif
+      }
+
+      if (prepare_move_to_destination_cartesian())
+        return;
+
+      set_current_to_destination();
+    }
   }
+}
 
-  if (prepare_move_to_destination_cartesian())
-    return;
+inline void Tuna::VM::await_queue()
+{
+  stepper.synchronize();
+}
 
-  set_current_to_destination();
+inline bool Tuna::VM::can_queue(arg_type<uint8> moves)
+{
+  return is_running() && commands_in_queue == 0 && (planner.movesplanned() + moves) < BLOCK_BUFFER_SIZE;
 }
 
 template <MovementType speed, MovementMode move_mode>
-inline void Tuna::VM::extrude(arg_type<float> E, arg_type<float> FeedRate)
+inline void Tuna::VM::linear_move(arg_type<float> X, arg_type<float> Y, arg_type<float> Z, arg_type<float> E, arg_type<float> FeedRate)
 {
   if (__unlikely(!is_running()))
   {
     return;
   }
 
-  constexpr const auto none = NONE<float>;
-  constexpr const bool feed_param = (speed != MovementType::Rapid);
-
-  float max_feedrate;
-
-  // TODO Fix for this:
-#if ENABLED(INCH_MODE_SUPPORT)
-  static_assert(false, "Need to add inch mode support.");
-#endif
-
-  MovementMode move_mode_local = move_mode;
-  if (move_mode == MovementMode::Modal)
-  {
-    move_mode_local = (axis_relative_modes[E_AXIS] || relative_mode) ? MovementMode::Relative : MovementMode::Absolute;
-  }
-
-  if (move_mode_local == MovementMode::Relative)
-  {
-    destination[E_AXIS] = E + current_position[E_AXIS];
-  }
-  else // Absolute
-  {
-    destination[E_AXIS] = E;
-  }
-
-  if constexpr (!feed_param)
-  {
-    max_feedrate = planner.max_feedrate_mm_s[E_AXIS];
-  }
+  _internal::set_destination<move_mode>(X_AXIS, X);
+  _internal::set_destination<move_mode>(Y_AXIS, Y);
+  _internal::set_destination<move_mode>(Z_AXIS, Z);
+  _internal::set_destination<move_mode>(E_AXIS, E);
 
-  if constexpr (feed_param)
-  {
-    if (FeedRate != none)
-    {
-      feedrate_mm_s = MMM_TO_MMS(FeedRate);
-    }
-  }
-  else
-  {
-    feedrate_mm_s = max_feedrate;
-  }
-
-  if (!DEBUGGING(DRYRUN))
-  {
-    if constexpr (move_mode == MovementMode::Relative)
-    {
-      print_job_timer.incFilamentUsed(E);
-    }
-    else
-    {
-      print_job_timer.incFilamentUsed(destination[E_AXIS] - current_position[E_AXIS]);
-    }
-  }
-
-  // perform move.
-  clamp_to_software_endstops(destination);
-  refresh_cmd_timeout();
-
-  if (!DEBUGGING(DRYRUN)) {
-    if (Temperature::is_coldextrude()) {
-      current_position[E_AXIS] = destination[E_AXIS]; // Behave as if the move really took place, but ignore E part
-      SERIAL_ECHO_START();
-      SERIAL_ECHOLNPGM(MSG_ERR_COLD_EXTRUDE_STOP);
-    }
-#if ENABLED(PREVENT_LENGTHY_EXTRUDE)
-    if (destination[E_AXIS] - current_position[E_AXIS] > EXTRUDE_MAXLENGTH) {
-      current_position[E_AXIS] = destination[E_AXIS]; // Behave as if the move really took place, but ignore E part
-      SERIAL_ECHO_START();
-      SERIAL_ECHOLNPGM(MSG_ERR_LONG_EXTRUDE_STOP);
-    }
-#endif
-  }
-
-  if (prepare_move_to_destination_cartesian())
-    return;
+  _internal::move_to_destination<speed>(FeedRate);
+}
 
-  set_current_to_destination();
+template <MovementType speed, MovementMode move_mode>
+inline void Tuna::VM::extrude(arg_type<float> E, arg_type<float> FeedRate)
+{
+  linear_move<speed, move_mode>(NONE<float>, NONE<float>, NONE<float>, E, FeedRate);
 }
@@ -114,6 +114,7 @@ void analogReference(uint8_t mode);
 void analogWrite(uint8_t, int);
 
 unsigned long millis(void);
+unsigned long micros(void);
 void delay(unsigned long);
 void delay(uint8_t);
 void delay(uint16_t);
@@ -206,6 +207,9 @@ extern const uint8_t PROGMEM digital_pin_to_timer_PGM[];
 
 #ifdef __cplusplus
 #include "HardwareSerial.h"
+#if defined(USBCON)
+#include "USBAPI.h" // From the board's core: the native USB (CDC) port, as Serial
+#endif
 #if defined(HAVE_HWSERIAL0) && defined(HAVE_CDCSERIAL)
 #error "Targets with both UART0 and CDC serial not supported"
 #endif
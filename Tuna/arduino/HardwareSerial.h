@@ -28,41 +28,22 @@
 
 #include "Stream.h"
 
+// SERIALn_RX_BUFFER_SIZE and SERIALn_TX_BUFFER_SIZE. This is included ahead of
+// MarlinConfig.h, so it takes Configuration.h on its own.
+#include "macros.h"
+#include "Configuration.h"
+
 // Define constants and variables for buffering incoming serial data.  We're
 // using a ring buffer (I think), in which head is the index of the location
 // to which to write the next incoming character and tail is the index of the
 // location from which to read.
+// Each port has its own buffer sizes, as template parameters, so a port only
+// costs the SRAM it's given, and a port given none isn't built at all.
 // NOTE: a "power of 2" buffer size is reccomended to dramatically
 //       optimize all the modulo operations for ring buffers.
-// WARNING: When buffer sizes are increased to > 256, the buffer index
-// variables are automatically increased in size, but the extra
-// atomicity guards needed for that are not implemented. This will
-// often work, but occasionally a race condition can occur that makes
-// Serial behave erratically. See https://github.com/arduino/Arduino/issues/2405
-#if !defined(SERIAL_TX_BUFFER_SIZE)
-#if ((RAMEND - RAMSTART) < 1023)
-#define SERIAL_TX_BUFFER_SIZE 16
-#else
-#define SERIAL_TX_BUFFER_SIZE 64
-#endif
-#endif
-#if !defined(SERIAL_RX_BUFFER_SIZE)
-#if ((RAMEND - RAMSTART) < 1023)
-#define SERIAL_RX_BUFFER_SIZE 16
-#else
-#define SERIAL_RX_BUFFER_SIZE 64
-#endif
-#endif
-#if (SERIAL_TX_BUFFER_SIZE>256)
-typedef uint16_t tx_buffer_index_t;
-#else
-typedef uint8_t tx_buffer_index_t;
-#endif
-#if  (SERIAL_RX_BUFFER_SIZE>256)
-typedef uint16_t rx_buffer_index_t;
-#else
-typedef uint8_t rx_buffer_index_t;
-#endif
+// Sizes are limited to 256, so the indices are single bytes that both the
+// interrupt handlers and the main loop can use without atomicity guards.
+// See https://github.com/arduino/Arduino/issues/2405
 
 // Define config for Serial.begin(baud, config);
 #define SERIAL_5N1 0x00
@@ -90,8 +71,15 @@ typedef uint8_t rx_buffer_index_t;
 #define SERIAL_7O2 0x3C
 #define SERIAL_8O2 0x3E
 
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
 class HardwareSerial final : public Stream
 {
+    static_assert(RxBufferSize >= 2 && RxBufferSize <= 256, "Serial receive buffers must hold 2 to 256 bytes");
+    static_assert(TxBufferSize >= 2 && TxBufferSize <= 256, "Serial transmit buffers must hold 2 to 256 bytes");
+
+    typedef uint8_t rx_buffer_index_t;
+    typedef uint8_t tx_buffer_index_t;
+
   protected:
     volatile uint8_t * __restrict const _ubrrh;
     volatile uint8_t * __restrict const _ubrrl;
@@ -101,6 +89,22 @@ class HardwareSerial final : public Stream
     volatile uint8_t * __restrict const _udr;
     // Has any byte been written to the UART since begin()
     bool _written;
+    // The line being written may be dropped rather than wait for room
+    bool _tx_droppable = false;
+    // The rest of the line is being dropped, up to its '\n'
+    bool _tx_dropping = false;
+    // Lines cut short since dropped_lines() was last taken
+    uint8_t _tx_dropped_lines = 0;
+
+#if ENABLED(RX_LINE_FRAMING)
+    // The receive interrupt frames the host's lines; see read_line()
+    bool _rx_framing = (Port == SERIAL_PORT);
+    bool _rx_comment = false;       // after a ';', up to the end of the line
+    bool _rx_escape = false;        // after a '\\', the next byte is taken as is
+    bool _rx_line_started = false;  // a byte of this line has been stored
+    volatile uint8_t _rx_lines_in = 0;  // line ends stored, counted by the interrupt
+    uint8_t _rx_lines_out = 0;          // lines taken by read_line()
+#endif
 
     volatile rx_buffer_index_t _rx_buffer_head;
     volatile rx_buffer_index_t _rx_buffer_tail;
@@ -110,8 +114,8 @@ class HardwareSerial final : public Stream
     // Don't put any members after these buffers, since only the first
     // 32 bytes of this struct can be accessed quickly using the ldd
     // instruction.
-    unsigned char _rx_buffer[SERIAL_RX_BUFFER_SIZE];
-    unsigned char _tx_buffer[SERIAL_TX_BUFFER_SIZE];
+    unsigned char _rx_buffer[RxBufferSize];
+    unsigned char _tx_buffer[TxBufferSize];
 
   public:
     inline HardwareSerial(
@@ -127,11 +131,29 @@ class HardwareSerial final : public Stream
     virtual unsigned int availableForWrite(void) __restrict override final;
     virtual void flush(void) __restrict override final;
     virtual uint8_t write(uint8_t) __restrict override final;
+    // Queues the bytes and enables the data register empty interrupt once, rather than per byte.
+    virtual size_t write(const uint8_t * __restrict buffer, size_t size) __restrict override final;
     inline uint8_t write(unsigned long n) __restrict { return write((uint8_t)n); }
     inline uint8_t write(long n) __restrict { return write((uint8_t)n); }
     inline uint8_t write(unsigned int n) __restrict { return write((uint8_t)n); }
     inline uint8_t write(int n) __restrict { return write((uint8_t)n); }
     using Print::write; // pull in write(str) and write(buf, size) from Print
+
+    // Until the next '\n', a byte that would have to wait for room in the transmit
+    // buffer is dropped, and so is the rest of the line. The '\n' always goes out.
+    inline void droppable_line() __restrict { _tx_droppable = true; }
+    // Returns the number of lines cut short since the last call.
+    inline uint8_t dropped_lines() __restrict { const uint8_t count = _tx_dropped_lines; _tx_dropped_lines = 0; return count; }
+
+#if ENABLED(RX_LINE_FRAMING)
+    // While framing, the receive interrupt drops comments and blank lines, ends lines with '\n'
+    // alone, and counts them, so the main loop takes only whole lines. Turned off for binary data.
+    void set_line_framing(bool framing) __restrict;
+    // Copies the next whole line, without its '\n' and escapes, into 'buffer' and terminates it.
+    // Bytes past size - 1 are dropped. 'checksum' is the XOR of the bytes before the first '*',
+    // and 'star' its index, or 0xFF with no '*'. Returns the length, or -1 if no line is complete yet.
+    int16_t read_line(char * __restrict buffer, uint8_t size, uint8_t & __restrict checksum, uint8_t & __restrict star) __restrict;
+#endif
     operator __const bool() const __restrict { return true; }
 
     // Interrupt handlers - Not intended to be called externally
@@ -139,23 +161,31 @@ class HardwareSerial final : public Stream
     void _tx_udr_empty_irq(void) __restrict;
 };
 
-#if defined(UBRRH) || defined(UBRR0H)
-  extern HardwareSerial Serial;
+#if (defined(UBRRH) || defined(UBRR0H)) && SERIAL0_RX_BUFFER_SIZE
+  typedef HardwareSerial<0, SERIAL0_RX_BUFFER_SIZE, SERIAL0_TX_BUFFER_SIZE> HardwareSerial0;
+  extern HardwareSerial0 Serial;
   #define HAVE_HWSERIAL0
 #endif
-#if defined(UBRR1H)
-  extern HardwareSerial Serial1;
+#if defined(UBRR1H) && SERIAL1_RX_BUFFER_SIZE
+  typedef HardwareSerial<1, SERIAL1_RX_BUFFER_SIZE, SERIAL1_TX_BUFFER_SIZE> HardwareSerial1;
+  extern HardwareSerial1 Serial1;
   #define HAVE_HWSERIAL1
 #endif
-#if defined(UBRR2H)
-  extern HardwareSerial Serial2;
+#if defined(UBRR2H) && SERIAL2_RX_BUFFER_SIZE
+  typedef HardwareSerial<2, SERIAL2_RX_BUFFER_SIZE, SERIAL2_TX_BUFFER_SIZE> HardwareSerial2;
+  extern HardwareSerial2 Serial2;
   #define HAVE_HWSERIAL2
 #endif
-#if defined(UBRR3H)
-  extern HardwareSerial Serial3;
+#if defined(UBRR3H) && SERIAL3_RX_BUFFER_SIZE
+  typedef HardwareSerial<3, SERIAL3_RX_BUFFER_SIZE, SERIAL3_TX_BUFFER_SIZE> HardwareSerial3;
+  extern HardwareSerial3 Serial3;
   #define HAVE_HWSERIAL3
 #endif
 
+// Bit n is set by port n's receive interrupt as it stores a byte, and cleared
+// once the port is found empty, so an idle port costs one bit test to poll.
+extern volatile uint8_t serial_rx_pending;
+
 extern void serialEventRun(void) __attribute__((weak));
 
 #endif
@@ -66,10 +66,12 @@ __signal(USART_UDRE)
   Serial._tx_udr_empty_irq();
 }
 
+template class HardwareSerial<0, SERIAL0_RX_BUFFER_SIZE, SERIAL0_TX_BUFFER_SIZE>;
+
 #if defined(UBRRH) && defined(UBRRL)
-  HardwareSerial Serial(&UBRRH, &UBRRL, &UCSRA, &UCSRB, &UCSRC, &UDR);
+  HardwareSerial0 Serial(&UBRRH, &UBRRL, &UCSRA, &UCSRB, &UCSRC, &UDR);
 #else
-  HardwareSerial Serial(&UBRR0H, &UBRR0L, &UCSR0A, &UCSR0B, &UCSR0C, &UDR0);
+  HardwareSerial0 Serial(&UBRR0H, &UBRR0L, &UCSR0A, &UCSR0B, &UCSR0C, &UDR0);
 #endif
 
 // Function that can be weakly referenced by serialEventRun to prevent
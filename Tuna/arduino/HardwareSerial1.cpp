@@ -62,7 +62,9 @@ __signal(USART1_UDRE)
   Serial1._tx_udr_empty_irq();
 }
 
-HardwareSerial Serial1(&UBRR1H, &UBRR1L, &UCSR1A, &UCSR1B, &UCSR1C, &UDR1);
+template class HardwareSerial<1, SERIAL1_RX_BUFFER_SIZE, SERIAL1_TX_BUFFER_SIZE>;
+
+HardwareSerial1 Serial1(&UBRR1H, &UBRR1L, &UCSR1A, &UCSR1B, &UCSR1C, &UDR1);
 
 // Function that can be weakly referenced by serialEventRun to prevent
 // pulling in this file if it's not otherwise used.
@@ -48,7 +48,9 @@ __signal(USART2_UDRE)
   Serial2._tx_udr_empty_irq();
 }
 
-HardwareSerial Serial2(&UBRR2H, &UBRR2L, &UCSR2A, &UCSR2B, &UCSR2C, &UDR2);
+template class HardwareSerial<2, SERIAL2_RX_BUFFER_SIZE, SERIAL2_TX_BUFFER_SIZE>;
+
+HardwareSerial2 Serial2(&UBRR2H, &UBRR2L, &UCSR2A, &UCSR2B, &UCSR2C, &UDR2);
 
 // Function that can be weakly referenced by serialEventRun to prevent
 // pulling in this file if it's not otherwise used.
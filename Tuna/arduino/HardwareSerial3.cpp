@@ -50,7 +50,9 @@ __signal(USART3_UDRE)
   Serial3._tx_udr_empty_irq();
 }
 
-HardwareSerial Serial3(&UBRR3H, &UBRR3L, &UCSR3A, &UCSR3B, &UCSR3C, &UDR3);
+template class HardwareSerial<3, SERIAL3_RX_BUFFER_SIZE, SERIAL3_TX_BUFFER_SIZE>;
+
+HardwareSerial3 Serial3(&UBRR3H, &UBRR3L, &UCSR3A, &UCSR3B, &UCSR3C, &UDR3);
 
 // Function that can be weakly referenced by serialEventRun to prevent
 // pulling in this file if it's not otherwise used.
@@ -84,7 +84,8 @@
 
 // Constructors ////////////////////////////////////////////////////////////////
 
-HardwareSerial::HardwareSerial(
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+HardwareSerial<Port, RxBufferSize, TxBufferSize>::HardwareSerial(
   volatile uint8_t *ubrrh, volatile uint8_t *ubrrl,
   volatile uint8_t *ucsra, volatile uint8_t *ucsrb,
   volatile uint8_t *ucsrc, volatile uint8_t *udr) :
@@ -98,13 +99,63 @@ HardwareSerial::HardwareSerial(
 
 // Actual interrupt handlers //////////////////////////////////////////////////////////////
 
-void HardwareSerial::_rx_complete_irq(void) __restrict
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+void HardwareSerial<Port, RxBufferSize, TxBufferSize>::_rx_complete_irq(void) __restrict
 {
   if (__likely(bit_is_clear(*_ucsra, UPE0))) {
     // No Parity error, read byte and store it in the buffer if there is
     // room
     unsigned char c = *_udr;
-    rx_buffer_index_t i = Tuna::uintsz<SERIAL_RX_BUFFER_SIZE>(_rx_buffer_head + 1_u8) % SERIAL_RX_BUFFER_SIZE;
+
+    #if ENABLED(EMERGENCY_PARSER)
+      if constexpr (Port == SERIAL_PORT) emergency_parser(c);
+    #endif
+
+    #if ENABLED(RX_LINE_FRAMING)
+      if constexpr (Port == SERIAL_PORT) {
+        if (__likely(_rx_framing)) {
+          bool line_end = false;
+          if (__unlikely(_rx_escape)) {
+            _rx_escape = false;
+            if (_rx_comment) return;
+          }
+          else if (__unlikely(c == '\n' || c == '\r')) {
+            _rx_comment = false;
+            if (!_rx_line_started) return; // blank line, or the '\n' of "\r\n"
+            c = '\n';
+            line_end = true;
+          }
+          else if (__unlikely(_rx_comment)) {
+            if (c == '\\') _rx_escape = true;
+            return;
+          }
+          else if (__unlikely(c == ';')) {
+            _rx_comment = true;
+            return;
+          }
+          else if (__unlikely(c == '\\')) {
+            _rx_escape = true;
+          }
+
+          const rx_buffer_index_t i = rx_buffer_index_t((_rx_buffer_head + 1_u16) % RxBufferSize);
+          if (__likely(i != _rx_buffer_tail)) {
+            _rx_buffer[_rx_buffer_head] = c;
+            _rx_buffer_head = i;
+            serial_rx_pending |= (1 << Port);
+            if (line_end) {
+              _rx_line_started = false;
+              _rx_lines_in = _rx_lines_in + 1;
+            }
+            else {
+              _rx_line_started = true;
+            }
+          }
+          return;
+        }
+      }
+    #endif
+
+    rx_buffer_index_t i = rx_buffer_index_t((_rx_buffer_head + 1_u16) % RxBufferSize);
 
     // if we should be storing the received character into the location
     // just before the tail (meaning that the head would advance to the
@@ -113,6 +164,7 @@ void HardwareSerial::_rx_complete_irq(void) __restrict
     if (i != _rx_buffer_tail) {
       _rx_buffer[_rx_buffer_head] = c;
       _rx_buffer_head = i;
+      serial_rx_pending |= (1 << Port);
     }
   } else {
     // Parity error, read byte but discard it
@@ -120,4 +172,280 @@ void HardwareSerial::_rx_complete_irq(void) __restrict
   };
 }
 
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+void HardwareSerial<Port, RxBufferSize, TxBufferSize>::_tx_udr_empty_irq(void) __restrict
+{
+  // If interrupts are enabled, there must be more data in the output
+  // buffer. Send the next byte
+  unsigned char c = _tx_buffer[_tx_buffer_tail];
+  _tx_buffer_tail = (_tx_buffer_tail + 1) % TxBufferSize;
+
+  *_udr = c;
+
+  // clear the TXC bit -- "can be cleared by writing a one to its bit
+  // location". This makes sure flush() won't return until the bytes
+  // actually got written
+  sbi(*_ucsra, TXC0);
+
+  if (_tx_buffer_head == _tx_buffer_tail) {
+    // Buffer empty, so disable interrupts
+    cbi(*_ucsrb, UDRIE0);
+  }
+}
+
+// Public Methods //////////////////////////////////////////////////////////////
+
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+void HardwareSerial<Port, RxBufferSize, TxBufferSize>::begin(__uint24 baud, byte config) __restrict
+{
+  // Try u2x mode first
+  uint16_t baud_setting = (F_CPU / 4 / baud - 1) / 2;
+  *_ucsra = 1 << U2X0;
+
+  // hardcoded exception for 57600 for compatibility with the bootloader
+  // shipped with the Duemilanove and previous boards and the firmware
+  // on the 8U2 on the Uno and Mega 2560. Also, The baud_setting cannot
+  // be > 4095, so switch back to non-u2x mode if the baud rate is too
+  // low.
+  if constexpr (F_CPU == 16000000UL)
+  {
+    if (__unlikely(baud == 57600) || (baud_setting > 4095))
+    {
+      *_ucsra = 0;
+      baud_setting = (F_CPU / 8 / baud - 1) / 2;
+    }
+  }
+
+  // assign the baud_setting, a.k.a. ubrr (USART Baud Rate Register)
+  *_ubrrh = baud_setting >> 8;
+  *_ubrrl = baud_setting;
+
+  _written = false;
+
+  //set the data bits, parity, and stop bits
+#if defined(__AVR_ATmega8__)
+  config |= 0x80; // select UCSRC register (shared with UBRRH)
+#endif
+  *_ucsrc = config;
+  
+  sbi(*_ucsrb, RXEN0);
+  sbi(*_ucsrb, TXEN0);
+  sbi(*_ucsrb, RXCIE0);
+  cbi(*_ucsrb, UDRIE0);
+}
+
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+void HardwareSerial<Port, RxBufferSize, TxBufferSize>::end() __restrict
+{
+  // wait for transmission of outgoing data
+  flush();
+
+  cbi(*_ucsrb, RXEN0);
+  cbi(*_ucsrb, TXEN0);
+  cbi(*_ucsrb, RXCIE0);
+  cbi(*_ucsrb, UDRIE0);
+  
+  // clear any received data
+  _rx_buffer_head = _rx_buffer_tail;
+
+  #if ENABLED(RX_LINE_FRAMING)
+    set_line_framing(_rx_framing);
+  #endif
+}
+
+#if ENABLED(RX_LINE_FRAMING)
+
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+void HardwareSerial<Port, RxBufferSize, TxBufferSize>::set_line_framing(bool framing) __restrict
+{
+  const Tuna::interrupt_mask rx_mask(*_ucsrb, _BV(RXCIE0));
+  _rx_framing = framing;
+  _rx_comment = false;
+  _rx_escape = false;
+  _rx_line_started = false;
+  _rx_lines_out = _rx_lines_in;
+}
+
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+int16_t HardwareSerial<Port, RxBufferSize, TxBufferSize>::read_line(char * __restrict buffer, uint8_t size, uint8_t & __restrict checksum, uint8_t & __restrict star) __restrict
+{
+  if (_rx_lines_in == _rx_lines_out) return -1;
+
+  // The interrupt only moves the head, and the head is past this line's '\n'
+  rx_buffer_index_t tail = _rx_buffer_tail;
+  uint8_t length = 0;
+  checksum = 0;
+  star = 0xFF;
+  for (;;) {
+    char c = _rx_buffer[tail];
+    tail = rx_buffer_index_t((tail + 1_u16) % RxBufferSize);
+    if (c == '\n') break;
+    if (c == '\\') {
+      c = _rx_buffer[tail];
+      tail = rx_buffer_index_t((tail + 1_u16) % RxBufferSize);
+    }
+    if (length < size - 1) {
+      if (star == 0xFF) {
+        if (__unlikely(c == '*')) star = length;
+        else checksum ^= c;
+      }
+      buffer[length++] = c;
+    }
+  }
+  buffer[length] = '\0';
+
+  _rx_buffer_tail = tail;
+  ++_rx_lines_out;
+  return length;
+}
+
+#endif
+
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+int HardwareSerial<Port, RxBufferSize, TxBufferSize>::available(void) __restrict
+{
+  return ((unsigned int)(RxBufferSize + _rx_buffer_head - _rx_buffer_tail)) % RxBufferSize;
+}
+
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+int HardwareSerial<Port, RxBufferSize, TxBufferSize>::peek(void) const __restrict
+{
+  if (_rx_buffer_head == _rx_buffer_tail) {
+    return -1;
+  } else {
+    return _rx_buffer[_rx_buffer_tail];
+  }
+}
+
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+int HardwareSerial<Port, RxBufferSize, TxBufferSize>::read(void) __restrict
+{
+  // if the head isn't ahead of the tail, we don't have any characters
+  if (_rx_buffer_head == _rx_buffer_tail) {
+    return -1;
+  } else {
+    unsigned char c = _rx_buffer[_rx_buffer_tail];
+    _rx_buffer_tail = (rx_buffer_index_t)(_rx_buffer_tail + 1) % RxBufferSize;
+    return c;
+  }
+}
+
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+unsigned int HardwareSerial<Port, RxBufferSize, TxBufferSize>::availableForWrite(void) __restrict
+{
+  tx_buffer_index_t head = _tx_buffer_head;
+  tx_buffer_index_t tail = _tx_buffer_tail;
+  if (head >= tail) return TxBufferSize - 1 - head + tail;
+  return tail - head - 1;
+}
+
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+void HardwareSerial<Port, RxBufferSize, TxBufferSize>::flush() __restrict
+{
+  // If we have never written a byte, no need to flush. This special
+  // case is needed since there is no way to force the TXC (transmit
+  // complete) bit to 1 during initialization
+  if (__likely(!_written))
+    return;
+
+  while (bit_is_set(*_ucsrb, UDRIE0) || bit_is_clear(*_ucsra, TXC0)) {
+    if (bit_is_clear(SREG, SREG_I) && bit_is_set(*_ucsrb, UDRIE0))
+	// Interrupts are globally disabled, but the DR empty
+	// interrupt should be enabled, so poll the DR empty flag to
+	// prevent deadlock
+	if (bit_is_set(*_ucsra, UDRE0))
+	  _tx_udr_empty_irq();
+  }
+  // If we get here, nothing is queued anymore (DRIE is disabled) and
+  // the hardware finished tranmission (TXC is set).
+}
+
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+uint8_t HardwareSerial<Port, RxBufferSize, TxBufferSize>::write(uint8_t c) __restrict
+{
+  if (__unlikely(c == '\n')) {
+    // Ends the line, dropped or not, and is always sent
+    _tx_droppable = false;
+    _tx_dropping = false;
+  }
+  else if (__unlikely(_tx_dropping)) {
+    return 0;
+  }
+
+  _written = true;
+  // If the buffer and the data register is empty, just write the byte
+  // to the data register and be done. This shortcut helps
+  // significantly improve the effective datarate at high (>
+  // 500kbit/s) bitrates, where interrupt overhead becomes a slowdown.
+  if (_tx_buffer_head == _tx_buffer_tail && bit_is_set(*_ucsra, UDRE0)) {
+    *_udr = c;
+    sbi(*_ucsra, TXC0);
+    return 1;
+  }
+  tx_buffer_index_t i = (_tx_buffer_head + 1) % TxBufferSize;
+
+  // A line that may be dropped doesn't wait
+  if (__unlikely(i == _tx_buffer_tail) && _tx_droppable) {
+    _tx_dropping = true;
+    if (_tx_dropped_lines != 0xFF) ++_tx_dropped_lines;
+    return 0;
+  }
+	
+  // If the output buffer is full, there's nothing for it other than to 
+  // wait for the interrupt handler to empty it a bit
+  while (i == _tx_buffer_tail) {
+    if (bit_is_clear(SREG, SREG_I)) {
+      // Interrupts are disabled, so we'll have to poll the data
+      // register empty flag ourselves. If it is set, pretend an
+      // interrupt has happened and call the handler to free up
+      // space for us.
+      if (bit_is_set(*_ucsra, UDRE0))
+      {
+        _tx_udr_empty_irq();
+      }
+    } else {
+      // nop, the interrupt handler will free up space for us
+    }
+  }
+
+  _tx_buffer[_tx_buffer_head] = c;
+  _tx_buffer_head = i;
+	
+  sbi(*_ucsrb, UDRIE0);
+  
+  return 1;
+}
+
+template <uint8_t Port, uint16_t RxBufferSize, uint16_t TxBufferSize>
+size_t HardwareSerial<Port, RxBufferSize, TxBufferSize>::write(const uint8_t * __restrict buffer, size_t size) __restrict
+{
+  size_t n = 0;
+  bool queued = false;
+  while (n < size) {
+    const uint8_t c = buffer[n];
+    const tx_buffer_index_t i = (_tx_buffer_head + 1) % TxBufferSize;
+    // Line ends, dropping, and a full buffer take the single byte path
+    if (__unlikely(c == '\n' || _tx_dropping || i == _tx_buffer_tail)) {
+      if (queued) {
+        sbi(*_ucsrb, UDRIE0);
+        queued = false;
+      }
+      // Returns 0 only for a dropped byte; the rest of the line, and its '\n', still go through it
+      write(c);
+    }
+    else {
+      _tx_buffer[_tx_buffer_head] = c;
+      _tx_buffer_head = i;
+      queued = true;
+    }
+    ++n;
+  }
+
+  if (queued) {
+    _written = true;
+    sbi(*_ucsrb, UDRIE0);
+  }
+  return n;
+}
+
 #endif // whole file
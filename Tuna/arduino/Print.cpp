@@ -28,6 +28,8 @@
 
 #include "Print.h"
 
+#include "tuna.h"
+
 // Public Methods //////////////////////////////////////////////////////////////
 
 /* default implementation: may be overridden */
@@ -212,7 +214,13 @@ uint8_t Print::println(const int64_t & __restrict num, uint8_t base) __restrict
 template <typename T>
 uint8_t Print::printNumber(T n, uint8_t base) __restrict
 {
-  char buf[8 * sizeof(long) + 1]; // Assumes 8-bit chars plus zero byte.
+  char buf[8 * sizeof(T) + 2]; // Assumes 8-bit chars plus sign and zero byte.
+
+  if (base == 10) {
+    Tuna::debug::_internal::int_to_string<false, T>(buf, n);
+    return write(buf);
+  }
+
   char *str = &buf[sizeof(buf) - 1];
 
   *str = '\0';
@@ -233,6 +241,10 @@ uint8_t Print::printNumber(T n, uint8_t base) __restrict
 uint8_t Print::printFloat(double number, uint8_t digits) __restrict
 { 
   uint8_t n = 0;
+
+  // One scale and round, then integer digits
+  char buf[16];
+  if (__likely(Tuna::debug::float_to_string(buf, number, digits) != nullptr)) return write(buf);
   
   if (isnan(number)) return print("nan");
   if (isinf(number)) return print("inf");
@@ -34,6 +34,7 @@ namespace Tuna::lcd
 		};
 
 		inline void read_data();
+		void key_event(arg_type<uint8> lcdCommand, arg_type<uint8> lcdData);
 		void write_statistics();
 
     chrono::time_ms<uint16> opTime = 0;
@@ -45,6 +46,130 @@ namespace Tuna::lcd
 		uint16 fileIndex = 0;
 		OpMode opMode = OpMode::None;
 		uint8 tempGraphUpdate = 0;
+
+		// The menus' moves go straight to the planner. One asked for while a command runs, or while
+		// the planner has no room, is dropped, as idle() and so this code run within both.
+		void jog(arg_type<AxisEnum> axis, arg_type<float> distance, arg_type<float> feedrate = VM::NONE<float>)
+		{
+			if (!VM::can_queue()) return;
+
+			float move[XYZE] = { VM::NONE<float>, VM::NONE<float>, VM::NONE<float>, VM::NONE<float> };
+			move[axis] = distance;
+			if (axis == E_AXIS)
+				VM::linear_move<MovementType::Linear, MovementMode::Relative>(move[X_AXIS], move[Y_AXIS], move[Z_AXIS], move[E_AXIS], feedrate);
+			else
+				VM::linear_move<MovementType::Rapid, MovementMode::Relative>(move[X_AXIS], move[Y_AXIS], move[Z_AXIS]);
+		}
+
+#if ENABLED(LCD_CONTINUOUS_JOG)
+		// While a Move page button is held, the LCD repeats its key. Each repeat keeps the jog going,
+		// and execute_looped_operation() keeps the planner two short blocks ahead of the nozzle. Once
+		// the repeats stop, nothing more is queued, and the last block brakes the move to a stop.
+		AxisEnum jogAxis = X_AXIS;
+		bool jogForward = true;
+		chrono::time_ms<uint16> jogTime = 0; // when the key last came
+		constexpr const chrono::duration_ms<uint16> jogRelease = LCD_JOG_RELEASE_MS;
+		constexpr const uint8 jogBlocks = 2;
+
+		void jog_held(arg_type<AxisEnum> axis, arg_type<bool> forward)
+		{
+			jogAxis = axis;
+			jogForward = forward;
+			jogTime = chrono::time_ms<uint16>::now();
+			if (opMode != OpMode::Move)
+			{
+				opMode = OpMode::Move;
+				opTime = jogTime;
+				opDuration = 0;
+			}
+		}
+
+		void jog_segment()
+		{
+			const float feedrate = (jogAxis == Z_AXIS) ? float(LCD_JOG_Z_FEEDRATE) : float(LCD_JOG_XY_FEEDRATE); // mm/min
+			const float distance = feedrate * (float(LCD_JOG_SEGMENT_MS) / 60000.0f);
+
+			float move[XYZE] = { VM::NONE<float>, VM::NONE<float>, VM::NONE<float>, VM::NONE<float> };
+			move[jogAxis] = jogForward ? distance : -distance;
+			VM::linear_move<MovementType::Linear, MovementMode::Relative>(move[X_AXIS], move[Y_AXIS], move[Z_AXIS], VM::NONE<float>, feedrate);
+		}
+#endif
+
+		// Lift, go over a leveling point, and lower the nozzle onto it.
+		void level_point(arg_type<float> x, arg_type<float> y)
+		{
+			if (!VM::can_queue(3)) return;
+
+			VM::linear_move<MovementType::Rapid, MovementMode::Absolute>(VM::NONE<float>, VM::NONE<float>, 10.0f);
+			VM::linear_move<MovementType::Rapid, MovementMode::Absolute>(x, y, VM::NONE<float>);
+			VM::linear_move<MovementType::Rapid, MovementMode::Absolute>(VM::NONE<float>, VM::NONE<float>, 0.0f);
+		}
+
+		// show_page() only notes the page; update() writes it once the transmit buffer has room,
+		// ahead of anything else. A page that is replaced before then is never written.
+		constexpr const Page noPage = Page(0);
+		Page pendingPage = noPage;
+
+		// Graph points are taken at each status update and sent graphBatch at a time,
+		// in one 0x84 write of alternating hotend and bed values.
+		constexpr const uint8 graphBatch = 4;
+		uint16 graphHotend[graphBatch];
+		uint16 graphBed[graphBatch];
+		uint8 graphSamples = 0;
+
+		// The status VPs from 0x0000 as last written, so that status_update() only writes what changed.
+		// They're all written again now and then, in case the LCD restarted and lost them.
+#if ENABLED(PRINT_TIME_ESTIMATE)
+		constexpr const uint8 statusVpCount = 7;
+#else
+		constexpr const uint8 statusVpCount = 6;
+#endif
+		constexpr const uint8 statusRefreshPeriod = 50; // status updates, 5 s
+		uint16 statusSent[statusVpCount];
+		uint8 statusRefresh = 0; // status updates until everything is written again
+
+#if defined(LCD_BOOT_ANIMATION_MS) && LCD_BOOT_ANIMATION_MS > 0
+		// The main menu is shown over the boot animation once it has played this long.
+		chrono::time_ms<uint16> bootTime = 0;
+		constexpr const chrono::duration_ms<uint16> bootAnimationLength = LCD_BOOT_ANIMATION_MS;
+		bool bootAnimation = false;
+#endif
+
+#if ENABLED(LCD_YIELD_TO_PLANNER)
+		chrono::time_ms<uint16> yieldTime = 0; // when the updates were last let through
+		bool yielding = false;
+		bool statisticsPending = false; // the statistics page waits for the planner too
+		constexpr const chrono::duration_ms<uint16> yieldLimit = LCD_YIELD_MAX_MS;
+
+		// True while the planner, or an SD print's command queue, is about to run dry, except
+		// that an update is let through every LCD_YIELD_MAX_MS.
+		bool should_yield(arg_type<chrono::time_ms<uint16>> ms)
+		{
+			const uint8 moves = Planner::movesplanned();
+			const bool starving = (moves && moves < LCD_YIELD_MOVES) || (card.sdprinting && !commands_in_queue);
+
+			if (__likely(!starving))
+			{
+				yielding = false;
+				return false;
+			}
+
+			if (!yielding)
+			{
+				yielding = true;
+				yieldTime = ms;
+				return true;
+			}
+
+			if (yieldTime.elapsed(ms, yieldLimit))
+			{
+				yieldTime = ms;
+				return false;
+			}
+
+			return true;
+		}
+#endif
 		Page currentPage = Page::Main_Menu;
 		Page lastPage = Page::Main_Menu; // main menu
 
@@ -72,22 +197,37 @@ namespace Tuna::lcd
 			} break;
 			case OpMode::Unload_Filament:
 			{
-				if (Temperature::current_temperature >= (Temperature::target_temperature - 10_u16))
+				if (Temperature::current_temperature >= (Temperature::target_temperature - 10_u16) && VM::can_queue())
 				{
-					enqueue_and_echo_commands("G1 E-1 F120"_p);
+					VM::extrude<MovementType::Linear, MovementMode::Relative>(-1.0f, 120.0f);
 				}
         opTime = ms;
         opDuration = 500_ms16;
 			} break;
 			case OpMode::Load_Filament:
 			{
-				if (Temperature::current_temperature >= (Temperature::target_temperature - 10_u16))
+				if (Temperature::current_temperature >= (Temperature::target_temperature - 10_u16) && VM::can_queue())
 				{
-					enqueue_and_echo_commands("G1 E1 F120"_p);
+					VM::extrude<MovementType::Linear, MovementMode::Relative>(1.0f, 120.0f);
 				}
         opTime = ms;
         opDuration = 500_ms16;
 			} break;
+#if ENABLED(LCD_CONTINUOUS_JOG)
+			case OpMode::Move:
+			{
+				if (jogTime.elapsed(ms, jogRelease))
+				{
+					opMode = OpMode::None; // Released; the queued blocks already end at rest
+					break;
+				}
+				// A move clamped at the software endstops queues nothing, so this never loops for long.
+				for (uint8 queued = Planner::movesplanned(); queued < jogBlocks && VM::can_queue(); ++queued)
+				{
+					jog_segment();
+				}
+			} break;
+#endif
 			}
 		}
 
@@ -110,42 +250,82 @@ namespace Tuna::lcd
 
 			const uint8 fan_speed = uint16(fanSpeeds[0] * 100_u16) / 255_u8;
 
-			const auto card_progress = card.percentDone();
-
-			const uint8 buffer[18] = {
-				0x5A,
-				0xA5,
-				0x0F, //data length
-				0x82, //write data to sram
-				0x00, //starting at 0 vp
-				0x00,
-				hi(target_hotend_temperature), //0x00 target extruder temp
-				lo(target_hotend_temperature),
-				hi(hotend_temperature), //0x01 extruder temp
-				lo(hotend_temperature),
-				hi(target_bed_temperature), //0x02 target bed temp
-				lo(target_bed_temperature),
-				hi(bed_temperature), //0x03 target bed temp
-				lo(bed_temperature),
-				0, //0x04 fan speed
-				fan_speed,
-				0x00, //0x05 card progress
-				card.percentDone()
+			// The progress field shows a running heater calibration instead of the print.
+			const uint8 progress = Temperature::is_calibrating() ? Temperature::calibration_progress() : card.percentDone();
+
+			const uint16 status[statusVpCount] = {
+				target_hotend_temperature, //0x00 target extruder temp
+				hotend_temperature, //0x01 extruder temp
+				target_bed_temperature, //0x02 target bed temp
+				bed_temperature, //0x03 bed temp
+				fan_speed, //0x04 fan speed
+				progress, //0x05 card progress
+#if ENABLED(PRINT_TIME_ESTIMATE)
+				print_remaining_minutes(), //0x06 minutes left
+#endif
 			};
 
-			serial<2>::write(buffer);
+			if (__unlikely(statusRefresh == 0))
+			{
+				statusRefresh = statusRefreshPeriod;
+				for (uint8 i = 0; i < statusVpCount; ++i)
+				{
+					statusSent[i] = ~status[i];
+				}
+			}
+			--statusRefresh;
+
+			// One write per run of changed VPs. Up to two unchanged VPs between changed ones are written
+			// along with them, which costs no more than the 6 byte header of another write.
+			for (uint8 first = 0; first < statusVpCount; ++first)
+			{
+				if (status[first] == statusSent[first])
+				{
+					continue;
+				}
+
+				uint8 last = first;
+				for (uint8 i = first + 1; i < statusVpCount && i <= last + 3; ++i)
+				{
+					if (status[i] != statusSent[i])
+					{
+						last = i;
+					}
+				}
+
+				const uint8 length = 6 + ((last - first + 1) * 2);
+				if (!serial<2>::writable(length))
+				{
+					break; // The rest stay changed, for the next update
+				}
+
+				uint8 buffer[6 + (statusVpCount * 2)] = {
+					0x5A,
+					0xA5,
+					uint8(length - 3), //data length
+					0x82, //write data to sram
+					0x00, //starting at vp 'first'
+					first
+				};
+				uint8 *data = buffer + 6;
+				for (uint8 i = first; i <= last; ++i)
+				{
+					*data++ = hi(status[i]);
+					*data++ = lo(status[i]);
+					statusSent[i] = status[i];
+				}
 
-			switch (tempGraphUpdate)
+				serial<2>::write(buffer, length);
+				first = last;
+			}
+
+			if (tempGraphUpdate)
 			{
-			case 2:
-				tempGraphUpdate = 1;
 				update_graph();
-				break;
-			default:
-				tempGraphUpdate = 2;
-				break;
-			case 0:
-				break;
+			}
+			else
+			{
+				graphSamples = 0; // none left over for the next time a graph is shown
 			}
 		}
 
@@ -155,43 +335,75 @@ namespace Tuna::lcd
 			return currentPage;
 		}
 
-		//receive data from lcd OK
-		void read_data()
+		// A DWIN frame is 0x5A 0xA5, the payload length, then the payload: the command and its data.
+		enum class FrameState : uint8
 		{
-			if (!serial<2>::available(1))
-			{
-				return;
-			}
-
-			if (serial<2>::read() != 0x5A)
-			{
-				return;
-			}
+			Header_5A = 0,
+			Header_A5,
+			Length,
+			Payload
+		};
 
-			while (!serial<2>::available(1)) {}
+		struct final
+		{
+			FrameState state = FrameState::Header_5A;
+			uint8 length = 0; // of the payload
+			uint8 count = 0; // payload bytes read so far
+			uint8 payload[16]; // its first bytes; the rest of a longer frame are read and dropped
+		} frame;
 
-			if (serial<2>::read() != 0xA5)
+		//receive data from lcd OK
+		// Takes what has arrived so far and never waits for the rest of a frame; the next call goes on
+		// where this one stopped. Handles at most one complete frame per call.
+		void read_data()
+		{
+			while (serial<2>::available(1))
 			{
-				return;
-			}
+				const uint8 c = serial<2>::read();
 
-			while (!serial<2>::available(3)) {}
+				switch (frame.state)
+				{
+				case FrameState::Header_5A:
+					if (c == 0x5A)
+					{
+						frame.state = FrameState::Header_A5;
+					}
+					continue;
+				case FrameState::Header_A5:
+					frame.state = (c == 0xA5) ? FrameState::Length : ((c == 0x5A) ? FrameState::Header_A5 : FrameState::Header_5A);
+					continue;
+				case FrameState::Length:
+					frame.length = c;
+					frame.count = 0;
+					frame.state = c ? FrameState::Payload : FrameState::Header_5A;
+					continue;
+				case FrameState::Payload:
+					if (frame.count < sizeof(frame.payload))
+					{
+						frame.payload[frame.count] = c;
+					}
+					if (++frame.count < frame.length)
+					{
+						continue;
+					}
+					frame.state = FrameState::Header_5A;
+					break;
+				}
 
-			serial<2>::read(); // data length
-			serial<2>::read(); // command
+				// A key press is read SRAM (0x83) of VP 0x04xx: VP LSB, word count, key value MSB and LSB.
+				const uint8 * __restrict const payload = frame.payload;
+				if (frame.length >= 6 && payload[0] == 0x83 && payload[1] == 0x04)
+				{
+					key_event(payload[2], payload[5]);
+				}
 
-			if (serial<2>::read() != 4) // VP MSB
-			{
+				// The handler may have waited for an answer from the LCD, so leave the rest for the next call.
 				return;
 			}
+		}
 
-			while (!serial<2>::available(4)) {}
-
-			const uint8 lcdCommand = serial<2>::read(); // VP LSB
-			serial<2>::read();// LEN ?
-			serial<2>::read(); //KEY VALUE MSB
-			const uint8 lcdData = serial<2>::read(); //KEY VALUE LSB
-
+		void key_event(arg_type<uint8> lcdCommand, arg_type<uint8> lcdData)
+		{
 			switch (lcdCommand)
 			{
 			case 0x32: {//SD list navigation up/down OK
@@ -204,7 +416,7 @@ namespace Tuna::lcd
 					uint16 fileCnt = 0;
 					if (lcdData == 0)
 					{
-						card.initsd();
+						card.refresh();
 						if (__likely(card.cardOK))
 						{
 							fileCnt = card.getnrfilenames();
@@ -235,25 +447,36 @@ namespace Tuna::lcd
 							}
 						}
 
-						{
-							constexpr const uint8 buffer[6] = {
-								0x5A,
-								0xA5,
-								0x9F,
-								0x82,
-								0x01,
-								0x00
-							};
-							serial<2>::write(buffer);
-						}
+						// The six names of the page, 26 bytes each from VP 0x0100, in one write. A name is
+						// padded with zeros, and a row past the end of the list is left blank.
+						constexpr const uint8 rows = 6;
+						constexpr const uint8 nameWidth = 26;
+						uint8 buffer[6 + (rows * nameWidth)] = {
+							0x5A,
+							0xA5,
+							3 + (rows * nameWidth), //data length
+							0x82, //write data to sram
+							0x01, //vp 0100
+							0x00
+						};
 
-						for (uint8 i = 0; i < 6; ++i)
+						uint8 *row = buffer + 6;
+						for (uint8 i = 0; i < rows; ++i, row += nameWidth)
 						{
-							uint8 buffer[26];
+							if (i > fileIndex || (fileIndex - i) >= fileCnt)
+							{
+								continue;
+							}
 							card.getfilename(fileIndex - i);
-							serial<2>::write(card.longFilename, 26); // TODO why 26? No '\0'?
+							const char *name = card.longFilename[0] ? card.longFilename : card.filename;
+							for (uint8 c = 0; c < nameWidth && name[c]; ++c)
+							{
+								row[c] = name[c];
+							}
 						}
 
+						serial<2>::write(buffer);
+
 						show_page(Page::SD_Card); //show sd card menu
 					}
 				}
@@ -276,9 +499,18 @@ namespace Tuna::lcd
 						serial<2>::write(buffer);
 						serial<2>::write(card.longFilename, 26);
 
-						card.openFile(card.filename, true);
-						card.startFileprint();
-						print_job_timer.start();
+#if ENABLED(JOB_QUEUE)
+						if (CardReader::isJobQueue(card.filename))
+						{
+							card.startJobQueue(card.filename); // Its prints start from loop()
+						}
+						else
+#endif
+						{
+							card.openFile(card.filename, true);
+							card.startFileprint();
+							print_job_timer.start();
+						}
 
 						tempGraphUpdate = 2;
 
@@ -288,6 +520,9 @@ namespace Tuna::lcd
 				break;
 			}
 			case 0x35: {//print stop OK
+#if ENABLED(JOB_QUEUE)
+				card.stopJobQueue();
+#endif
 				card.stopSDPrint();
 				clear_command_queue();
 				quickstop_stepper();
@@ -307,14 +542,23 @@ namespace Tuna::lcd
 				card.pauseSDPrint();
 				print_job_timer.pause();
 #if ENABLED(PARK_HEAD_ON_PAUSE)
-				enqueue_and_echo_commands("M125"_p);
+				ENQUEUE_COMMANDS("M125");
+#elif ENABLED(QUICK_PAUSE_PARK)
+				Planner::park();
+#elif ENABLED(QUICK_PAUSE)
+				Planner::hold_motion();
 #endif
 				break;
 			}
 			case 0x37: {//print start OK
 #if ENABLED(PARK_HEAD_ON_PAUSE)
-				enqueue_and_echo_commands("M24"_p);
+				ENQUEUE_COMMANDS("M24");
 #else
+#if ENABLED(QUICK_PAUSE_PARK)
+				Planner::unpark(); // The held moves go on once the nozzle is back
+#elif ENABLED(QUICK_PAUSE)
+				Planner::release_motion();
+#endif
 				card.startFileprint();
 				print_job_timer.start();
 #endif
@@ -393,7 +637,7 @@ namespace Tuna::lcd
 					Planner::preheat_presets[1].bed = uint8{ buffer[14] };
 					Planner::preheat_presets[2].hotend = uint16{ buffer[15] } * 256_i16 + buffer[16];
 					Planner::preheat_presets[2].bed = uint8{ buffer[18] };
-					enqueue_and_echo_commands("M500"_p);
+					ENQUEUE_COMMANDS("M500");
 
 					char command[20];
 					const uint8 idx = lcdData - 1;
@@ -476,18 +720,18 @@ namespace Tuna::lcd
 				planner.axis_steps_per_mm[Y_AXIS] = float( (uint16((uint16)buffer[9] * 256) + buffer[10]) ) * 0.1f;
 				planner.axis_steps_per_mm[Z_AXIS] = float( (uint16((uint16)buffer[11] * 256) + buffer[12]) ) * 0.1f;
 				planner.axis_steps_per_mm[E_AXIS] = float( (uint16((uint16)buffer[13] * 256) + buffer[14]) ) * 0.1f;
+				planner.refresh_positioning(); // steps_to_mm and the steps/s^2 limits follow from these
 
 				//PID_PARAM(Kp) = float{ ((uint16)buffer[15] * 256 + buffer[16]) } * 0.1f;
 				//PID_PARAM(Ki) = scalePID_i(float{ ((uint16)buffer[17] * 256 + buffer[18]) } * 0.1f);
 				//PID_PARAM(Kd) = scalePID_d(float{ ((uint16)buffer[19] * 256 + buffer[20]) } * 0.1f);
 
-				enqueue_and_echo_commands("M500"_p);
+				ENQUEUE_COMMANDS("M500");
 				show_page(Page::System_Menu);//show system menu
 				break;
 			}
 			case 0x42: {//factory reset OK
-				enqueue_and_echo_commands("M502"_p);
-				enqueue_and_echo_commands("M500"_p);
+				ENQUEUE_COMMANDS("M502\nM500");
 				break;
 			}
 			case 0x47: {//print config open OK
@@ -537,7 +781,7 @@ namespace Tuna::lcd
 				if ((bytesRead != 15) | (buffer[0] != 0x5A) | (buffer[1] != 0xA5)) {
 					break;
 				}
-				feedrate_percentage = (uint16)buffer[7] * 256 + buffer[8];
+				set_feedrate_percentage((uint16)buffer[7] * 256 + buffer[8]);
 				Temperature::setTargetHotend((uint16)buffer[9] * 256 + buffer[10]);
 
 				Temperature::setTargetBed(buffer[12]);
@@ -548,7 +792,6 @@ namespace Tuna::lcd
 			case 0x4A: {//load/unload filament back OK
 				opMode = OpMode::None;
 				clear_command_queue();
-				enqueue_and_echo_commands("G90"_p); // absolute mode
 				Temperature::setTargetHotend(0);
 				show_page(Page::Filament);//filament menu
 				break;
@@ -560,38 +803,30 @@ namespace Tuna::lcd
 					show_page(Page::Level1); //level 1
 					axis_homed[X_AXIS] = axis_homed[Y_AXIS] = axis_homed[Z_AXIS] = false;
 					//enqueue_and_echo_commands("G90"_p); //absolute mode
-					enqueue_and_echo_commands("G28"_p);//homeing
+					ENQUEUE_COMMANDS("G28");//homeing
           opTime = chrono::time_ms<uint16>::get();
           opDuration = 200_ms16;
 					opMode = OpMode::Level_Init;
 				} break;
 				case 1: { //fl
-					enqueue_and_echo_commands("G6 Z10"_p);
-					enqueue_and_echo_commands("G6 X35 Y35"_p);
-					enqueue_and_echo_commands("G6 Z0"_p);
+					level_point(35, 35);
 				} break;
 				case 2: { //rr
-					enqueue_and_echo_commands("G6 Z10"_p);
-					enqueue_and_echo_commands("G6 X165 Y170"_p);
-					enqueue_and_echo_commands("G6 Z0"_p);
+					level_point(165, 170);
 				} break;
 				case 3: { //fr
-					enqueue_and_echo_commands("G6 Z10"_p);
-					enqueue_and_echo_commands("G6 X165 Y35"_p);
-					enqueue_and_echo_commands("G6 Z0"_p);
+					level_point(165, 35);
 				} break;
 				case 4: { //rl
-					enqueue_and_echo_commands("G6 Z10"_p);
-					enqueue_and_echo_commands("G6 X35 Y165"_p);
-					enqueue_and_echo_commands("G6 Z0"_p);
+					level_point(35, 165);
 				} break;
 				case 5: { //c
-					enqueue_and_echo_commands("G6 Z10"_p);
-					enqueue_and_echo_commands("G6 X100 Y100"_p);
-					enqueue_and_echo_commands("G6 Z0"_p);
+					level_point(100, 100);
 				} break;
 				case 6: { //back
-					enqueue_and_echo_commands("G6 Z30"_p);
+					if (VM::can_queue()) {
+						VM::linear_move<MovementType::Rapid, MovementMode::Absolute>(VM::NONE<float>, VM::NONE<float>, 30.0f);
+					}
 					show_page(Page::Tool_Menu); //tool menu
 				} break;
 				}
@@ -642,7 +877,6 @@ namespace Tuna::lcd
 					}
 					int16 hotendTemp = (int16)buffer[7] * 256 + buffer[8];
 					Temperature::setTargetHotend(hotendTemp);
-					enqueue_and_echo_commands("G91"_p); // relative mode
           opTime = chrono::time_ms<uint16>::get();
           opDuration = 500_ms16;
 					if (lcdData == 1) {
@@ -655,81 +889,104 @@ namespace Tuna::lcd
 				}
 				break;
 			}
+#if ENABLED(LCD_CONTINUOUS_JOG)
 			case 0x00: {
-				clear_command_queue();
-				enqueue_and_echo_commands("G8 X5"_p);
+				jog_held(X_AXIS, true);
 				break;
 			}
 			case 0x01: {
-				clear_command_queue();
-				enqueue_and_echo_commands("G8 X-5"_p);
+				jog_held(X_AXIS, false);
+				break;
+			}
+			case 0x02: {
+				jog_held(Y_AXIS, true);
+				break;
+			}
+			case 0x03: {
+				jog_held(Y_AXIS, false);
+				break;
+			}
+			case 0x04: {
+				jog_held(Z_AXIS, true);
+				break;
+			}
+			case 0x05: {
+				jog_held(Z_AXIS, false);
+				break;
+			}
+#else
+			case 0x00: {
+				jog(X_AXIS, 5.0f);
+				break;
+			}
+			case 0x01: {
+				jog(X_AXIS, -5.0f);
 
 				break;
 			}
 			case 0x02: {
-				clear_command_queue();
-				enqueue_and_echo_commands("G8 Y5"_p);
+				jog(Y_AXIS, 5.0f);
 
 				break;
 			}
 			case 0x03: {
-				clear_command_queue();
-				enqueue_and_echo_commands("G8 Y-5"_p);
+				jog(Y_AXIS, -5.0f);
 
 				break;
 			}
 			case 0x04: {
-				clear_command_queue();
-				enqueue_and_echo_commands("G8 Z2"_p);
+				jog(Z_AXIS, 2.0f);
 
 				break;
 			}
 			case 0x05: {
-				clear_command_queue();
-				enqueue_and_echo_commands("G8 Z-2"_p);
+				jog(Z_AXIS, -2.0f);
 
 				break;
 			}
+#endif
 			case 0x06: {
 				if (!Temperature::is_coldextrude()) {
-					clear_command_queue();
-					enqueue_and_echo_commands("G14 E1 F120"_p);
+					jog(E_AXIS, 1.0f, 120.0f);
 				}
 				break;
 			}
 			case 0x07: {
 				if (!Temperature::is_coldextrude()) {
-					clear_command_queue();
-					enqueue_and_echo_commands("G14 E-1 F120"_p);
+					jog(E_AXIS, -1.0f, 120.0f);
 				}
 				break;
 			}
 			case 0x54: {//disable motors OK!!!
-				enqueue_and_echo_commands("M84"_p);
+				ENQUEUE_COMMANDS("M84");
 				axis_homed[X_AXIS] = axis_homed[Y_AXIS] = axis_homed[Z_AXIS] = false;
 				break;
 			}
 			case 0x43: {//home x OK!!!
-				enqueue_and_echo_commands("G28 X0"_p);
+				ENQUEUE_COMMANDS("G28 X0");
 				break;
 			}
 			case 0x44: {//home y OK!!!
-				enqueue_and_echo_commands("G28 Y0"_p);
+				ENQUEUE_COMMANDS("G28 Y0");
 				break;
 			}
 			case 0x45: {//home z OK!!!
-				enqueue_and_echo_commands("G28 Z0"_p);
+				ENQUEUE_COMMANDS("G28 Z0");
 				break;
 			}
 			case 0x1C: {//home xyz OK!!!
-				enqueue_and_echo_commands("G28"_p);
+				ENQUEUE_COMMANDS("G28");
 				break;
 			}
 			case 0x5B: { //stats menu
 						 //sending stats to lcd
+#if ENABLED(LCD_YIELD_TO_PLANNER)
+				statisticsPending = true; // update() opens it
+#else
 				write_statistics();
 
 				show_page(Page::Statistics);//open stats screen on lcd
+#endif
 				break;
 			}
 			case 0x5C: { //auto pid menu
@@ -776,7 +1033,7 @@ namespace Tuna::lcd
 					//Serial.println(hotendTemp);
 					char command[30];
 					sprintf_P(command, "M303 S%d E0 C8 U1"_p.c_str(), hotendTemp); //build auto pid command (extruder)
-					enqueue_and_echo_commands("M106"_p); //Turn on fan
+					ENQUEUE_COMMANDS("M106"); //Turn on fan
 					enqueue_and_echo_command(command); //enque pid command
 					tempGraphUpdate = 2;
 				}
@@ -932,22 +1189,206 @@ namespace Tuna::lcd
 		}
 	}
 
+	namespace
+	{
+		// The version, then the boot animation or the main menu, once the link is up.
+		void start_pages()
+		{
+			lcdSendMarlinVersion();
+#if !defined(LCD_BOOT_ANIMATION_MS)
+			show_page(Page::Boot_Animation);
+#elif LCD_BOOT_ANIMATION_MS == 0
+			show_page(Page::Main_Menu);
+#else
+			show_page(Page::Boot_Animation);
+			bootTime = chrono::time_ms<uint16>::get();
+			bootAnimation = true;
+#endif
+		}
+
+#if LCD_BAUDRATE != 115200
+		// Drops what the panel sent, and asks it for the page register (0x03).
+		void send_probe()
+		{
+			while (serial<2>::available(1))
+			{
+				serial<2>::read();
+			}
+
+			constexpr const uint8 buffer[6] = {
+				0x5A,
+				0xA5,
+				0x03, //data length
+				0x81, //read register
+				0x03, //page
+				0x01 //length
+			};
+			serial<2>::write(buffer);
+		}
+
+		// Whether the answer to send_probe() came at the rate serial<2> is at. Once 7 bytes are in.
+		bool probe_answered()
+		{
+			const bool answered = (serial<2>::read() == 0x5A) & (serial<2>::read() == 0xA5);
+			while (serial<2>::available(1))
+			{
+				serial<2>::read();
+			}
+			return answered;
+		}
+
+#if ENABLED(FAST_BOOT)
+		// The probes initialize() leaves to update(): how many have gone out, 0 once the link is up,
+		// and when the last one did. They alternate between LCD_BAUDRATE and 115200.
+		uint8 linkProbes = 0;
+		chrono::time_ms<uint16> linkProbeTime = 0;
+		constexpr const uint8 maxLinkProbes = 10;
+
+		// Goes on with the probes. False while they're still waiting for the panel.
+		bool link_ready(arg_type<chrono::time_ms<uint16>> ms)
+		{
+			if (serial<2>::available(7))
+			{
+				if (probe_answered())
+				{
+					linkProbes = 0;
+					start_pages();
+					return true;
+				}
+			}
+			else if (!linkProbeTime.elapsed(ms, 100_ms16))
+			{
+				return false;
+			}
+
+			if (linkProbes >= maxLinkProbes)
+			{
+				// Nothing answered; stay at LCD_BAUDRATE
+				serial<2>::begin<LCD_BAUDRATE>();
+				linkProbes = 0;
+				start_pages();
+				return true;
+			}
+
+			if (linkProbes & 1)
+			{
+				serial<2>::begin<115'200_u32>();
+			}
+			else
+			{
+				serial<2>::begin<LCD_BAUDRATE>();
+			}
+			send_probe();
+			linkProbeTime = ms;
+			++linkProbes;
+			return false;
+		}
+#else
+		// Asks for the page register, and whether an answer comes back at the rate serial<2> is at.
+		bool probe_link()
+		{
+			send_probe();
+
+			const auto start = chrono::time_ms<uint16>::get();
+			while (!serial<2>::available(7))
+			{
+				if (start.elapsed(100_ms16))
+				{
+					return false;
+				}
+			}
+			return probe_answered();
+		}
+#endif
+#endif
+	}
+
 	//init OK
 	void initialize()
 	{
+#if LCD_BAUDRATE != 115200
+#if ENABLED(FAST_BOOT)
+		// update() carries the probes on, so setup() doesn't wait for the panel to answer.
+		serial<2>::begin<LCD_BAUDRATE>();
+		send_probe();
+		linkProbeTime = chrono::time_ms<uint16>::get();
+		linkProbes = 1;
+		return;
+#else
+		// A panel still on the stock DWIN_SET CONFIG.txt talks at 115200. Try both rates for a while, as
+		// the panel may still be starting up; if neither answers, stay at LCD_BAUDRATE.
+		for (uint8 tries = 0; tries < 5; ++tries)
+		{
+			serial<2>::begin<LCD_BAUDRATE>();
+			if (probe_link())
+			{
+				break;
+			}
+			serial<2>::begin<115'200_u32>();
+			if (probe_link())
+			{
+				break;
+			}
+			serial<2>::begin<LCD_BAUDRATE>();
+		}
+#endif
+#else
 		serial<2>::begin<115'200_u32>();
+#endif
 
-		lcdSendMarlinVersion();
-		show_page(Page::Boot_Animation);
+		start_pages();
 	}
 
 	//lcd status update OK
 	void update()
 	{
-		read_data();
+#if LCD_BAUDRATE != 115200 && ENABLED(FAST_BOOT)
+		if (__unlikely(linkProbes) && !link_ready(chrono::time_ms<uint16>::now()))
+		{
+			return;
+		}
+#endif
+		if (serial<2>::rx_pending()) read_data();
 
-    const auto ms = chrono::time_ms<uint16>::get();
+    const auto ms = chrono::time_ms<uint16>::now();
 		execute_looped_operation(ms);
+
+#if defined(LCD_BOOT_ANIMATION_MS) && LCD_BOOT_ANIMATION_MS > 0
+		if (__unlikely(bootAnimation) && bootTime.elapsed(ms, bootAnimationLength))
+		{
+			bootAnimation = false;
+			// Unless something else, such as a heater error, was shown in the meantime.
+			if (currentPage == Page::Main_Menu && pendingPage == noPage)
+			{
+				show_page(Page::Main_Menu);
+			}
+		}
+#endif
+
+		if (pendingPage != noPage)
+		{
+			if (!serial<2>::writable(7))
+			{
+				return;
+			}
+			show_page_now(pendingPage);
+			pendingPage = noPage;
+		}
+
+#if ENABLED(LCD_YIELD_TO_PLANNER)
+		if (should_yield(ms))
+		{
+			return;
+		}
+
+		if (statisticsPending)
+		{
+			statisticsPending = false;
+			write_statistics();
+			show_page(Page::Statistics);
+		}
+#endif
+
 		status_update(ms);
 	}
 
@@ -965,6 +1406,12 @@ namespace Tuna::lcd
 			currentPage = Page::Main_Menu;
 		}
 
+		pendingPage = pageNumber;
+	}
+
+	// Writes the page register at once, waiting for room if need be: for when update() won't run again.
+	void show_page_now(Page pageNumber)
+	{
 		const uint8 buffer[7] = {
 			0x5A,//frame header
 			0xA5,
@@ -979,22 +1426,34 @@ namespace Tuna::lcd
 	}
 
 	void update_graph() {
-		const uint16 hotend = Temperature::degHotend().rounded_to<uint16>();
-		const uint16 bed = Temperature::degBed().rounded_to<uint16>();
-
-		auto foo = type_trait<int16>::unsigned_type{ 0 };
+		// A full batch that found no room last time waits, and this point is dropped.
+		if (graphSamples < graphBatch)
+		{
+			graphHotend[graphSamples] = Temperature::degHotend().rounded_to<uint16>();
+			graphBed[graphSamples] = Temperature::degBed().rounded_to<uint16>();
+			++graphSamples;
+		}
+		if (graphSamples < graphBatch || !serial<2>::writable(5 + (graphBatch * 4)))
+		{
+			return;
+		}
+		graphSamples = 0;
 
-		const uint8 buffer[9] = {
+		uint8 buffer[5 + (graphBatch * 4)] = {
 			0x5A,
 			0xA5,
-			0x06, //data length
+			2 + (graphBatch * 4), //data length
 			0x84, //update curve
-			0x03, //channels 0,1
-			hi(hotend), //TODOME
-			lo(hotend), //TODOME
-			hi(bed),
-			lo(bed)
+			0x03 //channels 0,1, a value for each in turn
 		};
+		uint8 length = 5;
+		for (uint8 i = 0; i < graphBatch; ++i)
+		{
+			buffer[length++] = hi(graphHotend[i]);
+			buffer[length++] = lo(graphHotend[i]);
+			buffer[length++] = hi(graphBed[i]);
+			buffer[length++] = lo(graphBed[i]);
+		}
 
 		serial<2>::write(buffer);
 	}
@@ -52,6 +52,7 @@ namespace Tuna::lcd
 	void initialize();
 	void update();
 	void show_page(Page pageNumber);
+	void show_page_now(Page pageNumber);
 	void update_graph();
 	constexpr inline bool has_status() { return false; }
 	constexpr inline void set_status(const char* const, const bool = false) { }
@@ -23,6 +23,12 @@
 #include <tuna.h>
 
 #include <ctype.h>
+#if ENABLED(POWER_LOSS_RECOVERY)
+  #include <util/crc16.h>
+#endif
+#if ENABLED(FIRMWARE_UPDATE)
+  #include <avr/wdt.h>
+#endif
 
 #include "cardreader.h"
 
@@ -44,14 +50,27 @@ CardReader::CardReader() {
     #endif
   #endif
   sdprinting = cardOK = saving = logging = false;
+  #if ENABLED(SD_BINARY_FILES)
+    binary_file = false;
+  #endif
+  #if ENABLED(POWER_LOSS_RECOVERY)
+    checkpoint_found = checkpoint_pending = false;
+    checkpoint_block = checkpoint_last = 0;
+  #endif
   filesize = 0;
   sdpos = 0;
+  card_serial = 0;
   workDirDepth = 0;
   file_subcall_ctr = 0;
   ZERO(workDirParents);
+  dir_changed();
 
   autostart_stilltocheck = true; //the SD start is delayed, because otherwise the serial cannot answer fast enough to make contact with the host software.
   autostart_index = 0;
+  #if ENABLED(JOB_QUEUE)
+    job_queue_name[0] = '\0';
+    job_queue_waiting = false;
+  #endif
 
   //power to SD reader
   #if SDPOWER > -1
@@ -72,6 +91,20 @@ char *createFilename(char *buffer, const dir_t &p) { //buffer > 12characters
   return buffer;
 }
 
+#if ENABLED(SD_DIR_INDEX)
+  // A case-insensitive hash of a short name, to skip the index entries that can't match
+  static uint8_t name_hash(const char *name) {
+    uint8_t h = 0;
+    while (*name) h = ((h << 1) | (h >> 7)) ^ toupper(*name++);
+    return h;
+  }
+#endif
+
+#if ENABLED(SD_BINARY_FILES)
+  // The first bytes of a file made by gcode_to_binary.py; the last is the format version
+  static constexpr const char binary_magic[] = { 'T', 'G', 'C', 1 };
+#endif
+
 /**
  * Dive into a folder and recurse depth-first to perform a pre-set operation lsAction:
  *   LS_Count       - Add +1 to nrFiles for every file within the parent
@@ -80,10 +113,12 @@ char *createFilename(char *buffer, const dir_t &p) { //buffer > 12characters
  */
 void CardReader::lsDive(const char *prepend, SdFile parent, const char * const match/*=nullptr*/) {
   dir_t p;
-  uint8_t cnt = 0;
+  uint16_t cnt = 0;
 
   // Read the next entry from a directory
-  while (parent.readDir(p, longFilename) > 0) {
+  for (;;) {
+    const uint32 entry_pos = parent.curPosition(); // where readDir() starts for this entry
+    if (parent.readDir(p, longFilename) <= 0) break;
 
     // If the entry is a directory and the action is LS_SerialPrint
     if (DIR_IS_SUBDIR(&p) && lsAction != LS_Count && lsAction != LS_GetFilename) {
@@ -133,6 +168,14 @@ void CardReader::lsDive(const char *prepend, SdFile parent, const char * const m
 
       switch (lsAction) {
         case LS_Count:
+          #if ENABLED(SD_DIR_INDEX)
+            if (nrFiles < SD_DIR_INDEX_LIMIT) {
+              char sfn[FILENAME_LENGTH];
+              dir_entry[nrFiles] = entry_pos >> 5;
+              dir_hash[nrFiles] = name_hash(createFilename(sfn, p));
+            }
+          #endif
+          remember_entry(nrFiles, entry_pos);
           nrFiles++;
           break;
 
@@ -149,7 +192,10 @@ void CardReader::lsDive(const char *prepend, SdFile parent, const char * const m
           if (match != nullptr) {
             if (strcasecmp(match, filename) == 0) return;
           }
-          else if (cnt == nrFiles) return;
+          else {
+            remember_entry(lsIndex + cnt, entry_pos);
+            if (cnt == nrFiles) return;
+          }
           cnt++;
           break;
       }
@@ -254,11 +300,18 @@ void CardReader::initsd() {
   }
   else {
     cardOK = true;
+    cid_t cid;
+    card_serial = card.readCID(&cid) ? cid.psn : 0;
     SERIAL_ECHO_START();
     SERIAL_ECHOLNPGM(MSG_SD_CARD_OK);
   }
   workDir = root;
   curDir = &root;
+  dir_changed();
+  #if ENABLED(POWER_LOSS_RECOVERY)
+    checkpoint_block = checkpoint_last = 0;
+    if (cardOK) find_checkpoint();
+  #endif
   #if ENABLED(SDCARD_SORT_ALPHA)
     presort();
   #endif
@@ -269,12 +322,33 @@ void CardReader::initsd() {
   */
 }
 
+// initsd() only if the card isn't the one that's mounted, so the volume, the working directory
+// and its index stay as they are while it is. The card that was mounted answers CMD10 with the
+// same serial number; a card that was pulled doesn't answer, and one put in since hasn't been
+// initialised, so it doesn't either.
+void CardReader::refresh() {
+  #if PIN_EXISTS(SD_DETECT)
+    if (!IS_SD_INSERTED) {
+      if (cardOK) release();
+      return;
+    }
+  #endif
+  if (cardOK) {
+    // An open file is in use, and a read of the card could break up its read-ahead.
+    if (isFileOpen()) return;
+    cid_t cid;
+    if (card.readCID(&cid) && cid.psn == card_serial) return;
+  }
+  initsd();
+}
+
 void CardReader::setroot() {
   /*if (!workDir.openRoot(&volume)) {
     SERIAL_ECHOLNPGM(MSG_SD_WORKDIR_FAIL);
   }*/
   workDir = root;
   curDir = &workDir;
+  dir_changed();
   #if ENABLED(SDCARD_SORT_ALPHA)
     presort();
   #endif
@@ -283,6 +357,7 @@ void CardReader::setroot() {
 void CardReader::release() {
   sdprinting = false;
   cardOK = false;
+  dir_changed();
 }
 
 void CardReader::openAndPrintFile(const char *name) {
@@ -295,7 +370,18 @@ void CardReader::openAndPrintFile(const char *name) {
 
 void CardReader::startFileprint() {
   if (__likely(cardOK)) {
+    #if ENABLED(PARALLEL_PRINT_START)
+      if (sdpos == 0) begin_parallel_start(); // Not a resume
+    #endif
+    #if ENABLED(POWER_LOSS_RECOVERY)
+      if (sdpos == 0) clear_checkpoint();             // A new print
+      else if (!checkpoint_block) open_checkpoint();  // Going on after M1000
+      checkpoint_found = false;
+    #endif
     sdprinting = true;
+    #if ENABLED(SD_MULTIBLOCK_READ)
+      card.readStreamEnable(true);
+    #endif
     #if ENABLED(SDCARD_SORT_ALPHA)
       flush_presort();
     #endif
@@ -303,7 +389,13 @@ void CardReader::startFileprint() {
 }
 
 void CardReader::stopSDPrint() {
+  #if ENABLED(POWER_LOSS_RECOVERY)
+    if (sdprinting) clear_checkpoint();               // Cancelled, so nothing to resume
+  #endif
   sdprinting = false;
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    card.readStreamEnable(false);
+  #endif
   if (isFileOpen()) file.close();
 }
 
@@ -411,10 +503,25 @@ void CardReader::openFile(char* name, bool read, bool push_current/*=false*/) {
 
   if (read) {
     if (file.open(curDir, fname, O_READ)) {
+      file_cursor = {};
+      #if ENABLED(SD_CLUSTER_MAP)
+        file.mapClusters(&file_clusters);
+      #endif
       filesize = file.fileSize();
       SERIAL_PROTOCOLPAIR(MSG_SD_FILE_OPENED, fname);
       SERIAL_PROTOCOLLNPAIR(MSG_SD_SIZE, filesize);
       sdpos = 0;
+      #if ENABLED(POWER_LOSS_RECOVERY)
+        if (!file_subcall_ctr) absolute_path(checkpoint.path, name);
+      #endif
+
+      #if ENABLED(SD_BINARY_FILES)
+        // A pre-parsed file starts with its magic; anything else is read again from the top
+        binary_file = true;
+        for (const char c : binary_magic) if (get() != uint8(c)) { binary_file = false; break; }
+        if (!binary_file) setIndex(0);
+        else sdpos = 0; // Still at the start, for startFileprint()
+      #endif
 
       SERIAL_PROTOCOLLNPGM(MSG_SD_FILE_SELECTED);
       getfilename(0, fname);
@@ -427,6 +534,7 @@ void CardReader::openFile(char* name, bool read, bool push_current/*=false*/) {
     }
   }
   else { //write
+    dir_changed();
     if (!file.open(curDir, fname, O_CREAT | O_APPEND | O_WRITE | O_TRUNC)) {
       SERIAL_PROTOCOLPAIR(MSG_SD_OPEN_FILE_FAIL, fname);
       SERIAL_PROTOCOLCHAR('.');
@@ -434,6 +542,10 @@ void CardReader::openFile(char* name, bool read, bool push_current/*=false*/) {
     }
     else {
       saving = true;
+      #if ENABLED(SD_WRITE_BUFFER)
+        write_count = 0;
+        file.setAllocCount(SD_WRITE_ALLOC_CLUSTERS);
+      #endif
       SERIAL_PROTOCOLLNPAIR(MSG_SD_WRITE_TO_FILE, name);
 	  lcd::set_status(fname);
     }
@@ -490,6 +602,7 @@ void CardReader::removeFile(char* name) {
     SERIAL_PROTOCOLPGM("File deleted:");
     SERIAL_PROTOCOLLN(fname);
     sdpos = 0;
+    dir_changed();
     #if ENABLED(SDCARD_SORT_ALPHA)
       presort();
     #endif
@@ -526,13 +639,42 @@ void CardReader::write_command(char *buf) {
   end[1] = '\r';
   end[2] = '\n';
   end[3] = '\0';
-  file.write(begin);
-  if (__unlikely(file.writeError)) {
-    SERIAL_ERROR_START();
-    SERIAL_ERRORLNPGM(MSG_SD_ERR_WRITE_TO_FILE);
-  }
+  #if ENABLED(SD_WRITE_BUFFER)
+    write_buffered(begin, end + 3 - begin);
+  #else
+    file.write(begin);
+    if (__unlikely(file.writeError)) {
+      SERIAL_ERROR_START();
+      SERIAL_ERRORLNPGM(MSG_SD_ERR_WRITE_TO_FILE);
+    }
+  #endif
 }
 
+#if ENABLED(SD_WRITE_BUFFER)
+
+  void CardReader::write_buffered(const char *data, uint16_t length) {
+    while (length) {
+      const uint16_t n = min(length, uint16_t(sizeof(write_buffer) - write_count));
+      memcpy(write_buffer + write_count, data, n);
+      write_count += n;
+      data += n;
+      length -= n;
+      if (write_count == sizeof(write_buffer)) flush_write_buffer();
+    }
+  }
+
+  // The file only ever gets whole blocks until it's closed, so each is block-aligned
+  void CardReader::flush_write_buffer() {
+    if (!write_count) return;
+    if (__unlikely(file.write(write_buffer, write_count) != int16_t(write_count))) {
+      SERIAL_ERROR_START();
+      SERIAL_ERRORLNPGM(MSG_SD_ERR_WRITE_TO_FILE);
+    }
+    write_count = 0;
+  }
+
+#endif // SD_WRITE_BUFFER
+
 void CardReader::checkautostart(bool force) {
   if (!force && (!autostart_stilltocheck || ELAPSED(millis(), next_autostart_ms)))
     return;
@@ -566,7 +708,110 @@ void CardReader::checkautostart(bool force) {
     autostart_index++;
 }
 
+#if ENABLED(JOB_QUEUE)
+
+  // Whether 'name' ends in ".gq"
+  bool CardReader::isJobQueue(const char *name) {
+    const char * const dot = strrchr(name, '.');
+    return dot && !strcasecmp_P(dot, PSTR(".gq"));
+  }
+
+  // Whether a line of a queue is a print: a name ending in .g, .gco or .gcode
+  static bool is_job_line(const char *line) {
+    const char * const dot = strrchr(line, '.');
+    return dot && !strchr(line, ' ')
+      && (!strcasecmp_P(dot, PSTR(".g")) || !strcasecmp_P(dot, PSTR(".gco")) || !strcasecmp_P(dot, PSTR(".gcode")));
+  }
+
+  void CardReader::startJobQueue(const char *name) {
+    if (*name == '/') ++name;
+    if (!cardOK || sdprinting || !isJobQueue(name) || strlen(name) >= FILENAME_LENGTH) {
+      SERIAL_ERROR_START();
+      SERIAL_ERRORPGM("Can't start job queue ");
+      SERIAL_ERRORLN(name);
+      return;
+    }
+    strcpy(job_queue_name, name);
+    job_queue_pos = 0;
+    job_queue_jobs = 0;
+    job_queue_waiting = true;
+    reportJobQueue();
+  }
+
+  /**
+   * Between the prints of a queue, run its lines one at a time as the command queue empties,
+   * up to the next print, which is started with M23 and M24. Called from loop(). The file is
+   * opened for each line, so nothing is held open while printing.
+   */
+  void CardReader::checkJobQueue() {
+    if (!jobQueueActive() || !job_queue_waiting || commands_in_queue || sdprinting || isFileOpen()) return;
+
+    SdFile queue;
+    char line[MAX_CMD_SIZE];
+    int16_t length = -1;
+    if (cardOK && queue.open(&root, job_queue_name, O_READ) && queue.seekSet(job_queue_pos)) {
+      length = queue.fgets(line, sizeof(line));
+      job_queue_pos = queue.curPosition();
+      queue.close();
+    }
+    if (length <= 0) {
+      if (length < 0) {
+        SERIAL_ERROR_START();
+        SERIAL_ERRORPGM("Can't read job queue ");
+        SERIAL_ERRORLN(job_queue_name);
+      }
+      else {
+        SERIAL_ECHO_START();
+        SERIAL_ECHOLNPAIR("Job queue done, prints:", uint16_t(job_queue_jobs));
+      }
+      stopJobQueue();
+      return;
+    }
+
+    // Drop the comment, the newline and the blanks around what's left
+    char *end = strchr(line, ';');
+    if (!end) end = line + length;
+    while (end > line && isspace(end[-1])) --end;
+    *end = '\0';
+    char *start = line;
+    while (isspace(*start)) ++start;
+    if (!*start) return;
+
+    if (is_job_line(start)) {
+      job_queue_waiting = false;
+      ++job_queue_jobs;
+      char path[1 + MAX_CMD_SIZE] = "/"; // From the root
+      strcpy(path + 1, start);
+      openAndPrintFile(path);
+    }
+    else
+      enqueue_and_echo_command(start);
+  }
+
+  void CardReader::reportJobQueue() {
+    SERIAL_ECHO_START();
+    if (jobQueueActive()) {
+      SERIAL_ECHOPAIR("Job queue ", job_queue_name);
+      SERIAL_ECHOPAIR(" byte ", job_queue_pos);
+      SERIAL_ECHOLNPAIR(" prints:", uint16_t(job_queue_jobs));
+    }
+    else
+      SERIAL_ECHOLNPGM("No job queue");
+  }
+
+#endif // JOB_QUEUE
+
 void CardReader::closefile(bool store_location) {
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    card.readStreamEnable(false);
+  #endif
+  #if ENABLED(SD_WRITE_BUFFER)
+    if (saving) {
+      flush_write_buffer();
+      file.truncate(file.fileSize()); // Free the clusters allocated ahead
+      file.setAllocCount(1);
+    }
+  #endif
   file.sync();
   file.close();
   saving = logging = false;
@@ -595,20 +840,62 @@ void CardReader::getfilename(uint16_t nr, const char * const match/*=nullptr*/)
       return;
     }
   #endif // SDSORT_CACHE_NAMES
+  #if ENABLED(SD_DIR_INDEX)
+    if (dir_count != 0xFFFF) {
+      const uint16_t indexed = min(dir_count, uint16_t(SD_DIR_INDEX_LIMIT));
+      if (match != nullptr) {
+        const uint8_t h = name_hash(match);
+        for (uint16_t i = 0; i < indexed; i++)
+          if (dir_hash[i] == h && read_indexed(i) && strcasecmp(match, filename) == 0) return;
+      }
+      else if (nr < indexed && read_indexed(nr)) return;
+    }
+  #endif
   curDir = &workDir;
   lsAction = LS_GetFilename;
-  nrFiles = nr;
+  lsIndex = 0;
   curDir->rewind();
+  if (match == nullptr) {
+    // Resume from the nearest remembered entry at or before nr
+    const dir_slot_t *from = nullptr;
+    for (const dir_slot_t &slot : dir_slots)
+      if (slot.index <= nr && slot.index != 0xFFFF && (from == nullptr || slot.index > from->index))
+        from = &slot;
+    if (from != nullptr && curDir->seekSet(uint32(from->entry) << 5)) lsIndex = from->index;
+  }
+  nrFiles = nr - lsIndex;
   lsDive("", *curDir, match);
 }
 
+#if ENABLED(SD_DIR_INDEX)
+  /**
+   * Read the indexed entry i of the current directory into filename,
+   * longFilename and filenameIsDir, as getfilename() does
+   */
+  bool CardReader::read_indexed(const uint16_t i) {
+    dir_t p;
+    curDir = &workDir;
+    if (!workDir.seekSet(uint32(dir_entry[i]) << 5) || workDir.readDir(p, longFilename) <= 0) return false;
+    createFilename(filename, p);
+    filenameIsDir = DIR_IS_SUBDIR(&p);
+    return true;
+  }
+#endif
+
 uint16_t CardReader::getnrfilenames() {
+  #if ENABLED(SD_DIR_INDEX)
+    if (dir_count != 0xFFFF) return dir_count;
+  #endif
   curDir = &workDir;
   lsAction = LS_Count;
+  lsIndex = 0;
   nrFiles = 0;
   curDir->rewind();
   lsDive("", *curDir);
   //SERIAL_ECHOLN(nrFiles);
+  #if ENABLED(SD_DIR_INDEX)
+    dir_count = nrFiles;
+  #endif
   return nrFiles;
 }
 
@@ -627,6 +914,7 @@ void CardReader::chdir(const char * relpath) {
     if (workDirDepth < MAX_DIR_DEPTH)
       workDirParents[workDirDepth++] = *parent;
     workDir = newfile;
+    dir_changed();
     #if ENABLED(SDCARD_SORT_ALPHA)
       presort();
     #endif
@@ -636,6 +924,7 @@ void CardReader::chdir(const char * relpath) {
 void CardReader::updir() {
   if (workDirDepth > 0) {
     workDir = workDirParents[--workDirDepth];
+    dir_changed();
     #if ENABLED(SDCARD_SORT_ALPHA)
       presort();
     #endif
@@ -864,6 +1153,9 @@ void CardReader::updir() {
 
 void CardReader::printingHasFinished() {
   stepper.synchronize();
+  #if ENABLED(SD_MULTIBLOCK_READ)
+    card.readStreamEnable(false);
+  #endif
   file.close();
   if (file_subcall_ctr > 0) { // Heading up to a parent file that called current as a procedure.
     file_subcall_ctr--;
@@ -873,15 +1165,383 @@ void CardReader::printingHasFinished() {
   }
   else {
     sdprinting = false;
+    #if ENABLED(POWER_LOSS_RECOVERY)
+      clear_checkpoint();
+    #endif
     if (SD_FINISHED_STEPPERRELEASE)
       enqueue_and_echo_commands(SD_FINISHED_RELEASECOMMAND);
     print_job_timer.stop();
     if (print_job_timer.duration() > 60)
       enqueue_and_echo_commands("M31"_p);
+    #if ENABLED(JOB_QUEUE)
+      if (jobQueueActive()) job_queue_waiting = true; // checkJobQueue() goes on to the next print
+    #endif
     #if ENABLED(SDCARD_SORT_ALPHA)
       presort();
     #endif
   }
 }
 
+#if ENABLED(POWER_LOSS_RECOVERY)
+
+  /**
+   * PLR.BIN, in the root of the card, is two blocks, made once. Each checkpoint
+   * goes to the other block from the last one, in one raw block write, so no
+   * FAT or directory entry is touched while printing, and a power loss during
+   * a write still leaves the checkpoint before it.
+   */
+  static constexpr const uint16_t checkpoint_magic = 0x504C;
+
+  static uint16_t checkpoint_crc(const CardReader::checkpoint_t &c) {
+    const uint8_t *p = (const uint8_t *)&c;
+    uint16_t crc = 0;
+    for (uint16_t i = 0; i < offsetof(CardReader::checkpoint_t, crc); ++i) crc = _crc_xmodem_update(crc, p[i]);
+    return crc;
+  }
+
+  // Make PLR.BIN if there isn't one, and find its blocks
+  void CardReader::open_checkpoint() {
+    checkpoint_block = checkpoint_last = 0;
+    SdFile plr;
+    if (!plr.open(&root, "PLR.BIN", O_CREAT | O_RDWR)) return;
+    if (plr.fileSize() < 1024) {
+      const uint8_t zero[32] = { 0 };
+      plr.seekEnd();
+      while (plr.fileSize() < 1024)
+        if (plr.write(zero, sizeof(zero)) != sizeof(zero)) break;
+      dir_changed();
+    }
+    uint32 first, last;
+    if (plr.sync() && plr.fileSize() >= 1024 && plr.contiguousRange(&first, &last)) {
+      checkpoint_block = first;
+      checkpoint_last = min(last, first + 1);
+    }
+    plr.close();
+  }
+
+  // Take the later of the two checkpoints in PLR.BIN, if there are any
+  void CardReader::find_checkpoint() {
+    checkpoint_found = false;
+    SdFile plr;
+    if (!plr.open(&root, "PLR.BIN", O_READ)) return;
+    checkpoint_t c;
+    for (uint8_t i = 0; i < 2; ++i) {
+      if (!plr.seekSet(i * 512UL) || plr.read(&c, sizeof(c)) != int16_t(sizeof(c))) break;
+      if (c.magic != checkpoint_magic || c.crc != checkpoint_crc(c)) continue;
+      if (checkpoint_found && int16_t(c.sequence - checkpoint.sequence) < 0) continue;
+      checkpoint = c;
+      checkpoint_found = true;
+    }
+    plr.close();
+    if (checkpoint_found) {
+      SERIAL_ECHO_START();
+      SERIAL_ECHOPGM(MSG_CHECKPOINT_FOUND);
+      SERIAL_ECHOLN(checkpoint.path);
+    }
+  }
+
+  // Write the checkpoint, without waiting for the card to store it
+  void CardReader::save_checkpoint() {
+    checkpoint_pending = false;
+    if (!checkpoint_block || file_subcall_ctr) return; // No resuming inside a procedure
+    checkpoint.magic = checkpoint_magic;
+    ++checkpoint.sequence;
+    checkpoint.crc = checkpoint_crc(checkpoint);
+    const uint32 block = (checkpoint.sequence & 1) ? checkpoint_last : checkpoint_block;
+    card.writeBlockNoWait(block, (const uint8_t *)&checkpoint, sizeof(checkpoint));
+  }
+
+  // Nothing to resume: invalidate both blocks, and have the next layer saved
+  void CardReader::clear_checkpoint() {
+    checkpoint_found = checkpoint_pending = false;
+    checkpoint.magic = 0;
+    checkpoint.sequence = 0;
+    checkpoint.position[Z_AXIS] = NAN;
+    if (!checkpoint_block) open_checkpoint();
+    if (!checkpoint_block) return;
+    card.writeBlockNoWait(checkpoint_block, nullptr, 0);
+    if (checkpoint_last != checkpoint_block) card.writeBlockNoWait(checkpoint_last, nullptr, 0);
+  }
+
+  // The path from the root to 'name', which is in workDir unless it starts with '/'
+  void CardReader::absolute_path(char *dst, const char *name) {
+    char * const end = dst + MAXPATHNAMELENGTH - 1;
+    *dst++ = '/';
+    if (*name == '/') {
+      ++name;
+    }
+    else {
+      // workDirParents[0] is the root, then each directory down to workDir
+      for (uint8_t i = 1; i <= workDirDepth; ++i) {
+        char part[FILENAME_LENGTH];
+        (i < workDirDepth ? workDirParents[i] : workDir).getFilename(part);
+        for (const char *s = part; *s && dst < end;) *dst++ = *s++;
+        if (dst < end) *dst++ = '/';
+      }
+    }
+    while (*name && dst < end) *dst++ = *name++;
+    *dst = '\0';
+  }
+
+#endif // POWER_LOSS_RECOVERY
+
+#if ENABLED(SD_BENCHMARK)
+
+  // "<label> <bytes> bytes in <us> us: <rate>", the rate in kB/s, or bytes/s for get()
+  static void report_rate(const char *label, const uint32 bytes, const uint32 us, const bool per_byte=false) {
+    SERIAL_ECHO_START();
+    serialprintPGM(label);
+    SERIAL_ECHOPAIR(" ", bytes);
+    SERIAL_ECHOPAIR(" bytes in ", us);
+    if (per_byte)
+      SERIAL_ECHOLNPAIR(" us, bytes/s:", us ? uint32(float(bytes) * 1000000.0f / float(us)) : 0);
+    else
+      SERIAL_ECHOLNPAIR(" us, kB/s:", us ? float(bytes) * 1000.0f / float(us) : 0.0f);
+  }
+
+  /**
+   * Time 'blocks' raw block reads from the start of the card, then, with a file
+   * open, SdBaseFile::read() and get() over up to as many bytes of it. Only the
+   * reads are timed: idle() runs between batches of them, to keep the heaters
+   * and the display going.
+   */
+  void CardReader::benchmark(const uint16_t blocks) {
+    static const uint16_t latency_limit_us[] __flashmem = { 1000, 2000, 4000, 8000, 16000 };
+    uint16_t latency_count[COUNT(latency_limit_us) + 1] = { 0 };
+    uint32 total_us = 0, slowest_us = 0, fastest_us = 0xFFFFFFFF;
+
+    // The raw reads land in the volume cache, which is flushed and then left empty
+    cache_t * const cache = volume.cacheClear();
+    if (!cache) {
+      SERIAL_ERROR_START();
+      SERIAL_ERRORLNPGM(MSG_SD_ERR_READ);
+      return;
+    }
+    uint8_t * const buffer = cache->data;
+
+    uint16_t done = 0;
+    for (; done < blocks; ++done) {
+      if (!(done & 15)) idle();
+      const uint32 start_us = micros();
+      if (!card.readBlock(done, buffer)) break;
+      const uint32 us = micros() - start_us;
+      total_us += us;
+      NOLESS(slowest_us, us);
+      NOMORE(fastest_us, us);
+      uint8_t i = 0;
+      while (i < COUNT(latency_limit_us) && us >= pgm_read_word(&latency_limit_us[i])) ++i;
+      ++latency_count[i];
+    }
+    volume.cacheClear();
+    if (done < blocks) {
+      SERIAL_ERROR_START();
+      SERIAL_ECHOLNPAIR(MSG_SD_ERR_READ " block ", done);
+    }
+    if (!done) return;
+
+    report_rate(PSTR("SD raw read"), uint32(done) * 512, total_us);
+    SERIAL_ECHO_START();
+    SERIAL_ECHOPAIR("SD block read us min:", fastest_us);
+    SERIAL_ECHOPAIR(" avg:", total_us / done);
+    SERIAL_ECHOPAIR(" max:", slowest_us);
+    for (uint8_t i = 0; i < COUNT(latency_limit_us); ++i) {
+      SERIAL_ECHOPAIR(" <", pgm_read_word(&latency_limit_us[i]) / 1000);
+      SERIAL_ECHOPAIR("ms:", latency_count[i]);
+    }
+    SERIAL_ECHOLNPAIR(" more:", latency_count[COUNT(latency_limit_us)]);
+
+    if (!isFileOpen()) {
+      SERIAL_ECHO_START();
+      SERIAL_ECHOLNPGM(MSG_SD_BENCHMARK_NO_FILE);
+      return;
+    }
+
+    // Both file passes start from the beginning; the print position is put back after
+    const uint32 saved_sdpos = sdpos, saved_position = file.curPosition();
+    const uint32 bytes = min(filesize, uint32(blocks) * 512);
+
+    uint8_t chunk[64];
+    file.seekSet(0);
+    total_us = 0;
+    for (uint32 n = 0; n < bytes;) {
+      if (!(n & 0x1FFF)) idle();
+      const uint32 start_us = micros();
+      const int16_t got = file.read(chunk, uint16_t(min(uint32(sizeof(chunk)), bytes - n)));
+      total_us += micros() - start_us;
+      if (got <= 0) break;
+      n += got;
+    }
+    report_rate(PSTR("SD file read"), bytes, total_us);
+
+    file.seekSet(0);
+    total_us = 0;
+    for (uint32 n = 0; n < bytes;) {
+      idle();
+      const uint16_t batch = uint16_t(min(uint32(0x2000), bytes - n));
+      const uint32 start_us = micros();
+      for (uint16_t i = batch; i--;) get();
+      total_us += micros() - start_us;
+      n += batch;
+    }
+    report_rate(PSTR("SD get()"), bytes, total_us, true);
+
+    #if ENABLED(SD_MULTIBLOCK_READ)
+      card.readStop();
+    #endif
+    file.seekSet(saved_position);
+    sdpos = saved_sdpos;
+  }
+
+#endif // SD_BENCHMARK
+
+#if ENABLED(FIRMWARE_UPDATE)
+
+  /**
+   * FIRMWARE_UPDATE_FILE is a 24-byte header, the raw image, and an 8-byte tag.
+   * The tag is the XTEA CBC-MAC, under FIRMWARE_UPDATE_KEY, of the header and
+   * the image padded with 0xFF to 8 bytes. The header's first block has the
+   * size in it, so the MAC can't be stretched. make_update_image.py makes them.
+   */
+  struct firmware_header_t {
+    char magic[4];      // "TUNA"
+    uint32 size;        // of the image after the header
+    char version[16];   // SHORT_BUILD_VERSION of the image, '\0'-padded
+  };
+  static_assert(sizeof(firmware_header_t) % 8 == 0, "The firmware header must be whole XTEA blocks.");
+
+  // Encipher one block, little-endian words, in place
+  static void xtea_encipher(uint32 v[2], const uint32 key[4]) {
+    uint32 v0 = v[0], v1 = v[1], sum = 0;
+    for (uint8_t i = 0; i < 32; ++i) {
+      v0 += (((v1 << 4) ^ (v1 >> 5)) + v1) ^ (sum + key[sum & 3]);
+      sum += 0x9E3779B9;
+      v1 += (((v0 << 4) ^ (v0 >> 5)) + v0) ^ (sum + key[(sum >> 11) & 3]);
+    }
+    v[0] = v0;
+    v[1] = v1;
+  }
+
+  // Add 'length' bytes, a multiple of 8, to a CBC-MAC
+  static void xtea_mac(uint32 mac[2], const uint32 key[4], const uint8_t *data, uint16_t length) {
+    for (; length; length -= 8, data += 8) {
+      uint32 block[2];
+      memcpy(block, data, sizeof(block));
+      mac[0] ^= block[0];
+      mac[1] ^= block[1];
+      xtea_encipher(mac, key);
+    }
+  }
+
+  // Rename the update so it isn't looked at again, replacing an old one of that name
+  static void retire_update(SdFile &image, SdFile &root, const char * const name) {
+    SdBaseFile::remove(&root, name);
+    image.rename(&root, name);
+  }
+
+  /**
+   * Called from setup(), before the heaters start. An update that is signed
+   * and isn't the running version is copied, without its header and tag, to
+   * FIRMWARE_UPDATE_STAGED_FILE, and the board resets into the bootloader to
+   * flash it. The build that comes up finds its own version in the header,
+   * removes the staged copy and renames the update to FIRMWARE_UPDATE_DONE_FILE.
+   * If the version still doesn't match once it's staged, the bootloader didn't
+   * take it, and it's renamed to FIRMWARE_UPDATE_FAILED_FILE instead.
+   */
+  void CardReader::checkFirmwareUpdate() {
+    if (!cardOK) initsd();
+    if (!cardOK) return;
+
+    SdFile image;
+    if (!image.open(&root, FIRMWARE_UPDATE_FILE, O_READ)) return;
+
+    firmware_header_t header;
+    if (image.read(&header, sizeof(header)) != int16_t(sizeof(header))
+      || memcmp_P(header.magic, PSTR("TUNA"), sizeof(header.magic))
+      || header.size > uint32(FLASHEND) + 1
+      || image.fileSize() != sizeof(header) + header.size + 8
+    ) {
+      SERIAL_ERROR_START();
+      SERIAL_ERRORLNPGM("Firmware update isn't an update image");
+      retire_update(image, root, FIRMWARE_UPDATE_FAILED_FILE);
+      image.close();
+      return;
+    }
+    header.version[sizeof(header.version) - 1] = '\0';
+
+    SdFile staged;
+    const bool was_staged = staged.open(&root, FIRMWARE_UPDATE_STAGED_FILE, O_READ);
+    if (was_staged) staged.close();
+
+    // The update is running: that's the end of it
+    if (!strcmp_P(header.version, PSTR(SHORT_BUILD_VERSION))) {
+      if (was_staged) {
+        SdBaseFile::remove(&root, FIRMWARE_UPDATE_STAGED_FILE);
+        SERIAL_ECHO_START();
+        SERIAL_ECHOPGM("Firmware updated to ");
+        SERIAL_ECHOLN(header.version);
+      }
+      retire_update(image, root, FIRMWARE_UPDATE_DONE_FILE);
+      image.close();
+      dir_changed();
+      return;
+    }
+
+    if (was_staged) {
+      SdBaseFile::remove(&root, FIRMWARE_UPDATE_STAGED_FILE);
+      SERIAL_ERROR_START();
+      SERIAL_ERRORPGM("Bootloader didn't flash firmware ");
+      SERIAL_ERRORLN(header.version);
+      retire_update(image, root, FIRMWARE_UPDATE_FAILED_FILE);
+      image.close();
+      dir_changed();
+      return;
+    }
+
+    SERIAL_ECHO_START();
+    SERIAL_ECHOPGM("Checking firmware ");
+    SERIAL_ECHOLN(header.version);
+
+    // Copy while checking the tag, one pass over the image
+    const uint32 key[4] = FIRMWARE_UPDATE_KEY;
+    uint32 mac[2] = { 0, 0 };
+    xtea_mac(mac, key, (const uint8_t *)&header, sizeof(header));
+
+    bool good = staged.open(&root, FIRMWARE_UPDATE_STAGED_FILE, O_CREAT | O_WRITE | O_TRUNC);
+    uint8_t buffer[512]; // A block at a time, or the two files take turns in the volume cache
+    for (uint32 left = header.size; good && left;) {
+      Tuna::intrinsic::wdr(); // in case the bootloader left the watchdog on
+      const uint16_t n = min(left, uint32(sizeof(buffer)));
+      good = image.read(buffer, n) == int16_t(n) && staged.write(buffer, n) == int16_t(n);
+      const uint16_t padded = (n + 7) & ~7;
+      memset(buffer + n, 0xFF, padded - n);
+      xtea_mac(mac, key, buffer, padded);
+      left -= n;
+    }
+    uint32 tag[2];
+    good = good && image.read(tag, sizeof(tag)) == int16_t(sizeof(tag)) && tag[0] == mac[0] && tag[1] == mac[1];
+    good = staged.close() && good;
+
+    if (!good) {
+      SdBaseFile::remove(&root, FIRMWARE_UPDATE_STAGED_FILE);
+      SERIAL_ERROR_START();
+      SERIAL_ERRORPGM("Firmware update failed its check: ");
+      SERIAL_ERRORLN(header.version);
+      retire_update(image, root, FIRMWARE_UPDATE_FAILED_FILE);
+      image.close();
+      dir_changed();
+      return;
+    }
+    image.close();
+
+    SERIAL_ECHO_START();
+    SERIAL_ECHOLNPGM("Resetting to flash the firmware update");
+    _delay_ms(100); // Let the message out
+
+    // The bootloader takes the staged image on the reset
+    wdt_enable(WDTO_15MS);
+    for (;;) {}
+  }
+
+#endif // FIRMWARE_UPDATE
+
 #endif // SDSUPPORT
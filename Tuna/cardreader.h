@@ -39,6 +39,7 @@ public:
   CardReader();
 
   void initsd();
+  void refresh();
   void write_command(char *buf);
   //files auto[0-9].g on the sd card are performed in a row
   //this is to delay autostart and hence the initialisaiton of the sd card to some seconds after the normal init, so the device is available quick after a reset
@@ -55,10 +56,23 @@ public:
   void getStatus();
   void printingHasFinished();
 
+  #if ENABLED(JOB_QUEUE)
+    static bool isJobQueue(const char *name);
+    void startJobQueue(const char *name);
+    void __forceinline stopJobQueue() { job_queue_name[0] = '\0'; }
+    bool __forceinline jobQueueActive() const { return job_queue_name[0]; }
+    void checkJobQueue();
+    void reportJobQueue();
+  #endif
+
   #if ENABLED(LONG_FILENAME_HOST_SUPPORT)
     void printLongPath(char *path);
   #endif
 
+  #if ENABLED(FIRMWARE_UPDATE)
+    void checkFirmwareUpdate();
+  #endif
+
   void getfilename(uint16_t nr, const char* const match=nullptr);
   uint16_t getnrfilenames();
 
@@ -79,16 +93,44 @@ public:
     #endif
   #endif
 
-  void __forceinline pauseSDPrint() { sdprinting = false; }
+  void __forceinline pauseSDPrint() {
+    sdprinting = false;
+    #if ENABLED(SD_MULTIBLOCK_READ)
+      card.readStreamEnable(false);
+    #endif
+  }
   bool __forceinline isFileOpen() { return file.isOpen(); }
   bool __forceinline eof() { return sdpos >= filesize; }
-  int16 __forceinline get() { sdpos = file.curPosition(); return (int16)file.read(); }
-  void __forceinline setIndex(long index) { sdpos = index; file.seekSet(index); }
+  uint32 __forceinline getIndex() const { return sdpos; }             // of the byte get() last returned
+  uint32 __forceinline getSize() const { return filesize; }           // of the open file
+  uint32 __forceinline readPosition() { return file.curPosition(); }  // of the next byte
+  int16 __forceinline get() { sdpos = file.curPosition(); return (int16)file.read(file_cursor); }
+  #if ENABLED(SD_BLOCK_SCAN)
+    // The bytes get() would return next that are already in the cache, or 0. consume() takes 'n' of them.
+    uint16_t __forceinline span(const uint8_t *&data) { return file.peek(file_cursor, data); }
+    void __forceinline consume(const uint16_t n) { file.skipPeeked(n); sdpos = file.curPosition() - 1; }
+  #endif
+  #if ENABLED(SD_READ_AHEAD)
+    void __forceinline readAhead() { file.readAhead(); }
+  #endif
+  #if ENABLED(SD_BENCHMARK)
+    void benchmark(const uint16_t blocks);
+  #endif
+  void __forceinline setIndex(long index) {
+    sdpos = index;
+    #if ENABLED(SD_MULTIBLOCK_READ)
+      card.readStop();
+    #endif
+    file.seekSet(index);
+  }
   uint8 __forceinline percentDone() { return (isFileOpen() && filesize) ? sdpos / ((filesize + 99) / 100) : 0; }
   char* __forceinline getWorkDirName() { workDir.getFilename(filename); return filename; }
 
 public:
   bool saving, logging, sdprinting, cardOK, filenameIsDir;
+  #if ENABLED(SD_BINARY_FILES)
+    bool binary_file;                     // Records of parsed commands, see get_sdcard_records()
+  #endif
   char filename[FILENAME_LENGTH], longFilename[LONG_FILENAME_LENGTH];
   int autostart_index;
 private:
@@ -140,8 +182,35 @@ private:
   #endif // SDCARD_SORT_ALPHA
 
   Sd2Card card;
+  uint32 card_serial;                     // CID serial number of the card initsd() mounted
   SdVolume volume;
   SdFile file;
+  SdBaseFile::read_cursor_t file_cursor;  // get()'s place in the volume cache
+  #if ENABLED(SD_CLUSTER_MAP)
+    SdBaseFile::cluster_map_t file_clusters;
+  #endif
+
+  // Where the listed entries of workDir are, so they can be read without
+  // walking the directory. Built by getnrfilenames(), dropped by dir_changed().
+  #if ENABLED(SD_DIR_INDEX)
+    uint16_t dir_count;                     // listed entries, or 0xFFFF if not indexed
+    uint16_t dir_entry[SD_DIR_INDEX_LIMIT]; // directory entry to start readDir() from
+    uint8_t dir_hash[SD_DIR_INDEX_LIMIT];   // of the short name, see name_hash()
+    bool read_indexed(const uint16_t i);
+  #endif
+  // Where readDir() starts for the entries of workDir last passed by
+  // lsDive(), in slot index & 7, so getfilename() can resume near them
+  struct dir_slot_t { uint16_t index, entry; };
+  dir_slot_t dir_slots[8];
+  void __forceinline remember_entry(const uint16_t index, const uint32 pos) {
+    dir_slots[index & 7] = { index, uint16_t(pos >> 5) };
+  }
+  void __forceinline dir_changed() {
+    #if ENABLED(SD_DIR_INDEX)
+      dir_count = 0xFFFF;
+    #endif
+    for (dir_slot_t &slot : dir_slots) slot.index = 0xFFFF;
+  }
 
   #define SD_PROCEDURE_DEPTH 1
   #define MAXPATHNAMELENGTH (FILENAME_LENGTH*MAX_DIR_DEPTH + MAX_DIR_DEPTH + 1)
@@ -151,10 +220,18 @@ private:
   uint32 filesize;
   uint32 sdpos;
 
+  #if ENABLED(JOB_QUEUE)
+    char job_queue_name[FILENAME_LENGTH]; // the .gq file, in the root, or "" without a queue
+    uint32 job_queue_pos;                 // of its next line
+    uint8_t job_queue_jobs;               // prints it has started
+    bool job_queue_waiting;               // between prints, running its lines up to the next
+  #endif
+
   millis_t next_autostart_ms;
   bool autostart_stilltocheck; //the sd start is delayed, because otherwise the serial cannot answer fast enought to make contact with the hostsoftware.
 
   LsAction lsAction; //stored for recursion.
+  uint16_t lsIndex;  // index of the first entry lsDive() reads
   uint16_t nrFiles; //counter for the files in the current directory and recycled as position counter for getting the nrFiles'th name in the directory.
   char* diveDirName;
   void lsDive(const char *prepend, SdFile parent, const char * const match=nullptr);
@@ -162,6 +239,42 @@ private:
   #if ENABLED(SDCARD_SORT_ALPHA)
     void flush_presort();
   #endif
+
+  // Lines written by M28 and M928 are gathered into whole blocks, which go to
+  // the card without passing through the volume cache, so it keeps the FAT.
+  #if ENABLED(SD_WRITE_BUFFER)
+    uint8_t write_buffer[512];
+    uint16_t write_count;
+    void write_buffered(const char *data, uint16_t length);
+    void flush_write_buffer();
+  #endif
+
+  #if ENABLED(POWER_LOSS_RECOVERY)
+  public:
+    // Where an SD print was at the start of a layer, kept in PLR.BIN for M1000
+    struct checkpoint_t {
+      uint16_t magic;               // checkpoint_magic if the record is valid
+      uint16_t sequence;            // of the two blocks, the higher is the later
+      uint32 sdpos;                 // the command to go on from
+      float position[XYZE];         // before that command
+      float feedrate_mm_s;
+      uint16_t target_hotend, target_bed;
+      uint8_t fan_speed;
+      bool relative_mode, relative_e;
+      char path[MAXPATHNAMELENGTH]; // of the printed file, as openFile() takes it
+      uint16_t crc;                 // CRC-16/XMODEM of the bytes before it
+    };
+    checkpoint_t checkpoint;        // to be saved, or found by initsd()
+    bool checkpoint_found;          // initsd() found a checkpoint to resume from
+    bool checkpoint_pending;        // checkpoint is waiting for save_checkpoint()
+    void save_checkpoint();
+    void clear_checkpoint();
+  private:
+    uint32 checkpoint_block, checkpoint_last; // PLR.BIN's blocks, or 0 if it isn't open
+    void open_checkpoint();
+    void find_checkpoint();
+    void absolute_path(char *dst, const char *name);
+  #endif
 };
 
 extern CardReader card;
@@ -36,128 +36,130 @@
  *
  */
 
-#define EEPROM_VERSION "V39"
+#define EEPROM_VERSION "V47"
 
 // Change EEPROM version if these are changed:
 #define EEPROM_OFFSET 100
 
 /**
- * V39 EEPROM Layout:
+ * V46 EEPROM Layout:
  *
  *  100  Version                                    (char x4)
  *  104  EEPROM CRC16                               (uint16_t)
+ *  106  Size of the data from 108 on               (uint16_t)
  *
- *  106            E_STEPPERS                       (uint8_t)
- *  107  M92 XYZE  planner.axis_steps_per_mm        (float x4 ... x8)
- *  123  M203 XYZE planner.max_feedrate_mm_s        (float x4 ... x8)
- *  139  M201 XYZE planner.max_acceleration_mm_per_s2 (uint32 x4 ... x8)
- *  155  M204 P    planner.acceleration             (float)
- *  159  M204 R    planner.retract_acceleration     (float)
- *  163  M204 T    planner.travel_acceleration      (float)
- *  167  M205 S    planner.min_feedrate_mm_s        (float)
- *  171  M205 T    planner.min_travel_feedrate_mm_s (float)
- *  175  M205 B    planner.min_segment_time         (ulong)
- *  179  M205 X    planner.max_jerk[X_AXIS]         (float)
- *  183  M205 Y    planner.max_jerk[Y_AXIS]         (float)
- *  187  M205 Z    planner.max_jerk[Z_AXIS]         (float)
- *  191  M205 E    planner.max_jerk[E_AXIS]         (float)
- *  195  M206 XYZ  home_offset                      (float x3)
- *  207  M218 XYZ  hotend_offset                    (float x3 per additional hotend)
+ *  108            E_STEPPERS                       (uint8_t)
+ *  109  M92 XYZE  planner.axis_steps_per_mm        (float x4 ... x8)
+ *  125  M203 XYZE planner.max_feedrate_mm_s        (float x4 ... x8)
+ *  141  M201 XYZE planner.max_acceleration_mm_per_s2 (uint32 x4 ... x8)
+ *  157  M204 P    planner.acceleration             (float)
+ *  161  M204 R    planner.retract_acceleration     (float)
+ *  165  M204 T    planner.travel_acceleration      (float)
+ *  169  M205 S    planner.min_feedrate_mm_s        (float)
+ *  173  M205 T    planner.min_travel_feedrate_mm_s (float)
+ *  177  M205 B    planner.min_segment_time         (ulong)
+ *  181  M205 X    planner.max_jerk[X_AXIS]         (float)
+ *  185  M205 Y    planner.max_jerk[Y_AXIS]         (float)
+ *  189  M205 Z    planner.max_jerk[Z_AXIS]         (float)
+ *  193  M205 E    planner.max_jerk[E_AXIS]         (float)
+ *  197  M205 J    planner.junction_deviation_mm    (float)
+ *  201  M206 XYZ  home_offset                      (float x3)
+ *  213  M218 XYZ  hotend_offset                    (float x3 per additional hotend)
  *
  * Global Leveling:
- *  219            z_fade_height                    (float)
+ *  225            z_fade_height                    (float)
  *
- * MESH_BED_LEVELING:                               43 bytes
- *  223  M420 S    from mbl.status                  (bool)
- *  224            mbl.z_offset                     (float)
- *  228            GRID_MAX_POINTS_X                (uint8_t)
- *  229            GRID_MAX_POINTS_Y                (uint8_t)
- *  230 G29 S3 XYZ z_values[][]                     (float x9, up to float x81) +288
+ * MESH_BED_LEVELING or MESH_COMPENSATION:         43 bytes
+ *  229  M420 S    from mbl.status                  (bool)
+ *  230            mbl.z_offset                     (float)
+ *  234            GRID_MAX_POINTS_X                (uint8_t)
+ *  235            GRID_MAX_POINTS_Y                (uint8_t)
+ *  236 G29 S3 XYZ z_values[][]                     (float x9, up to float x81) +288
  *
  * HAS_BED_PROBE:                                   4 bytes
- *  266  M851      zprobe_zoffset                   (float)
+ *  272  M851      zprobe_zoffset                   (float)
  *
  * ABL_PLANAR:                                      36 bytes
- *  270            planner.bed_level_matrix         (matrix_3x3 = float x9)
+ *  276            planner.bed_level_matrix         (matrix_3x3 = float x9)
  *
  * AUTO_BED_LEVELING_BILINEAR:                      47 bytes
- *  306            GRID_MAX_POINTS_X                (uint8_t)
- *  307            GRID_MAX_POINTS_Y                (uint8_t)
- *  308            bilinear_grid_spacing            (int x2)
- *  312  G29 L F   bilinear_start                   (int x2)
- *  316            z_values[][]                     (float x9, up to float x256) +988
+ *  312            GRID_MAX_POINTS_X                (uint8_t)
+ *  313            GRID_MAX_POINTS_Y                (uint8_t)
+ *  314            bilinear_grid_spacing            (int x2)
+ *  318  G29 L F   bilinear_start                   (int x2)
+ *  322            z_values[][]                     (float x9, up to float x256) +988
  *
  * AUTO_BED_LEVELING_UBL:                           6 bytes
- *  324  G29 A     ubl.state.active                 (bool)
- *  325  G29 Z     ubl.state.z_offset               (float)
- *  329  G29 S     ubl.state.storage_slot           (int8_t)
+ *  330  G29 A     ubl.state.active                 (bool)
+ *  331  G29 Z     ubl.state.z_offset               (float)
+ *  335  G29 S     ubl.state.storage_slot           (int8_t)
  *
  * DELTA:                                           48 bytes
- *  348  M666 XYZ  endstop_adj                      (float x3)
- *  360  M665 R    delta_radius                     (float)
- *  364  M665 L    delta_diagonal_rod               (float)
- *  368  M665 S    delta_segments_per_second        (float)
- *  372  M665 B    delta_calibration_radius         (float)
- *  376  M665 X    delta_tower_angle_trim[A]        (float)
- *  380  M665 Y    delta_tower_angle_trim[B]        (float)
+ *  354  M666 XYZ  endstop_adj                      (float x3)
+ *  366  M665 R    delta_radius                     (float)
+ *  370  M665 L    delta_diagonal_rod               (float)
+ *  374  M665 S    delta_segments_per_second        (float)
+ *  378  M665 B    delta_calibration_radius         (float)
+ *  382  M665 X    delta_tower_angle_trim[A]        (float)
+ *  386  M665 Y    delta_tower_angle_trim[B]        (float)
  *  ---  M665 Z    delta_tower_angle_trim[C]        (float) is always 0.0
  *
  * Z_DUAL_ENDSTOPS:                                 48 bytes
- *  348  M666 Z    z_endstop_adj                    (float)
+ *  354  M666 Z    z_endstop_adj                    (float)
  *  ---            dummy data                       (float x11)
  *
  * ULTIPANEL:                                       6 bytes
- *  396  M145 S0 H lcd_preheat_hotend_temp          (int x2)
- *  400  M145 S0 B lcd_preheat_bed_temp             (int x2)
- *  404  M145 S0 F lcd_preheat_fan_speed            (int x2)
+ *  402  M145 S0 H lcd_preheat_hotend_temp          (int x2)
+ *  406  M145 S0 B lcd_preheat_bed_temp             (int x2)
+ *  410  M145 S0 F lcd_preheat_fan_speed            (int x2)
  *
  * PIDTEMP:                                         66 bytes
- *  408  M301 E0 PIDC  Kp[0], Ki[0], Kd[0], Kc[0]   (float x4)
- *  424  M301 E1 PIDC  Kp[1], Ki[1], Kd[1], Kc[1]   (float x4)
- *  440  M301 E2 PIDC  Kp[2], Ki[2], Kd[2], Kc[2]   (float x4)
- *  456  M301 E3 PIDC  Kp[3], Ki[3], Kd[3], Kc[3]   (float x4)
- *  472  M301 E4 PIDC  Kp[3], Ki[3], Kd[3], Kc[3]   (float x4)
- *  488  M301 L        lpq_len                      (int)
+ *  414  M301 E0 PIDC  Kp[0], Ki[0], Kd[0], Kc[0]   (float x4)
+ *  430  M301 E1 PIDC  Kp[1], Ki[1], Kd[1], Kc[1]   (float x4)
+ *  446  M301 E2 PIDC  Kp[2], Ki[2], Kd[2], Kc[2]   (float x4)
+ *  462  M301 E3 PIDC  Kp[3], Ki[3], Kd[3], Kc[3]   (float x4)
+ *  478  M301 E4 PIDC  Kp[3], Ki[3], Kd[3], Kc[3]   (float x4)
+ *  494  M301 L        lpq_len                      (int)
  *
  * PIDTEMPBED:                                      12 bytes
- *  490  M304 PID  thermalManager.bedKp, .bedKi, .bedKd (float x3)
+ *  496  M304 PID  BedManager Kp, Ki, Kd (float x3)
  *
  * DOGLCD:                                          2 bytes
- *  502  M250 C    lcd_contrast                     (uint16_t)
+ *  508  M250 C    lcd_contrast                     (uint16_t)
  *
  * FWRETRACT:                                       29 bytes
- *  504  M209 S    autoretract_enabled              (bool)
- *  505  M207 S    retract_length                   (float)
- *  509  M207 W    retract_length_swap              (float)
- *  513  M207 F    retract_feedrate_mm_s            (float)
- *  517  M207 Z    retract_zlift                    (float)
- *  521  M208 S    retract_recover_length           (float)
- *  525  M208 W    retract_recover_length_swap      (float)
- *  529  M208 F    retract_recover_feedrate_mm_s    (float)
+ *  510  M209 S    autoretract_enabled              (bool)
+ *  511  M207 S    retract_length                   (float)
+ *  515  M207 W    retract_length_swap              (float)
+ *  519  M207 F    retract_feedrate_mm_s            (float)
+ *  523  M207 Z    retract_zlift                    (float)
+ *  527  M208 S    retract_recover_length           (float)
+ *  531  M208 W    retract_recover_length_swap      (float)
+ *  535  M208 F    retract_recover_feedrate_mm_s    (float)
  *
  * Volumetric Extrusion:                            21 bytes
- *  533  M200 D    volumetric_enabled               (bool)
- *  534  M200 T D  filament_size                    (float x5) (T0..3)
+ *  539  M200 D    volumetric_enabled               (bool)
+ *  540  M200 T D  filament_size                    (float x5) (T0..3)
  *
  * HAVE_TMC2130:                                    20 bytes
- *  554  M906 X    Stepper X current                (uint16_t)
- *  556  M906 Y    Stepper Y current                (uint16_t)
- *  558  M906 Z    Stepper Z current                (uint16_t)
- *  560  M906 X2   Stepper X2 current               (uint16_t)
- *  562  M906 Y2   Stepper Y2 current               (uint16_t)
- *  564  M906 Z2   Stepper Z2 current               (uint16_t)
- *  566  M906 E0   Stepper E0 current               (uint16_t)
- *  568  M906 E1   Stepper E1 current               (uint16_t)
- *  570  M906 E2   Stepper E2 current               (uint16_t)
- *  572  M906 E3   Stepper E3 current               (uint16_t)
- *  576  M906 E4   Stepper E4 current               (uint16_t)
+ *  560  M906 X    Stepper X current                (uint16_t)
+ *  562  M906 Y    Stepper Y current                (uint16_t)
+ *  564  M906 Z    Stepper Z current                (uint16_t)
+ *  566  M906 X2   Stepper X2 current               (uint16_t)
+ *  568  M906 Y2   Stepper Y2 current               (uint16_t)
+ *  570  M906 Z2   Stepper Z2 current               (uint16_t)
+ *  572  M906 E0   Stepper E0 current               (uint16_t)
+ *  574  M906 E1   Stepper E1 current               (uint16_t)
+ *  576  M906 E2   Stepper E2 current               (uint16_t)
+ *  578  M906 E3   Stepper E3 current               (uint16_t)
+ *  582  M906 E4   Stepper E4 current               (uint16_t)
  *
  * LIN_ADVANCE:                                     8 bytes
- *  580  M900 K    extruder_advance_k               (float)
- *  584  M900 WHD  advance_ed_ratio                 (float)
+ *  586  M900 K    extruder_advance_k               (float)
+ *  590  M900 WHD  advance_ed_ratio                 (float)
  *
- *  600                                Minimum end-point
- * 1921 (600 + 36 + 9 + 288 + 988)     Maximum end-point
+ *  606                                Minimum end-point
+ * 1927 (606 + 36 + 9 + 288 + 988)     Maximum end-point
  *
  * ========================================================================
  * meshes_begin (between max and min end-point, directly above)
@@ -172,6 +174,25 @@
 
 #include "configuration_store.h"
 
+// The header at EEPROM_OFFSET. The CRC covers the 'size' bytes of data after it, which load()
+// checks as a whole before using any of them.
+struct settings_header_t {
+  char version[4];
+  uint16_t crc;
+  uint16_t size;
+} __attribute__((packed));
+
+#if ENABLED(SETTINGS_PROFILES)
+  // Each profile is a full set of settings, header and all. The active one is kept just below them.
+  #define EEPROM_PROFILE_ADDRESS (EEPROM_OFFSET - 1)
+  #define EEPROM_BASE (EEPROM_OFFSET + active_profile * uint16_t(SETTINGS_PROFILE_SIZE))
+  #define EEPROM_LIMIT (EEPROM_BASE + uint16_t(SETTINGS_PROFILE_SIZE))
+#else
+  #define EEPROM_BASE EEPROM_OFFSET
+  #define EEPROM_LIMIT (E2END + 1)
+#endif
+#define EEPROM_DATA (EEPROM_BASE + sizeof(settings_header_t))
+
 // FIXME TODO TEMPORARY HACK
 static const float z_float = 0.0f;
 #define PID_PARAM(x) z_float
@@ -184,7 +205,8 @@ MarlinSettings settings;
 #include "thermal/thermal.hpp"
 #include "bi3_plus_lcd.h"
 #include "stepper.h"
-#include "thermal/managers/simple.hpp"
+#include "thermal/managers/managers.hpp"
+#include "mesh.hpp"
 
 #if ENABLED(INCH_MODE_SUPPORT) || (ENABLED(ULTIPANEL) && ENABLED(TEMPERATURE_UNITS_SUPPORT))
   #include "gcode.h"
@@ -202,12 +224,97 @@ MarlinSettings settings;
   extern void refresh_bed_level();
 #endif
 
+/**
+ * The planner keeps the reciprocals of the steps per mm and max feedrates, and the acceleration
+ * limits in steps. A zero, negative or NaN setting would make those infinite, so it falls back
+ * to its default before they are derived.
+ */
+static void validate_planner_settings() {
+  const float def_steps[] = DEFAULT_AXIS_STEPS_PER_UNIT, def_feedrate[] = DEFAULT_MAX_FEEDRATE;
+  const uint32 def_accel[] = DEFAULT_MAX_ACCELERATION;
+  bool replaced = false;
+  LOOP_XYZE_N(i) {
+    if (!(planner.axis_steps_per_mm[i] > 0)) {
+      planner.axis_steps_per_mm[i] = def_steps[i < COUNT(def_steps) ? i : COUNT(def_steps) - 1];
+      replaced = true;
+    }
+    if (!(planner.max_feedrate_mm_s[i] > 0)) {
+      planner.max_feedrate_mm_s[i] = def_feedrate[i < COUNT(def_feedrate) ? i : COUNT(def_feedrate) - 1];
+      replaced = true;
+    }
+    if (!planner.max_acceleration_mm_per_s2[i]) {
+      planner.max_acceleration_mm_per_s2[i] = def_accel[i < COUNT(def_accel) ? i : COUNT(def_accel) - 1];
+      replaced = true;
+    }
+  }
+  if (replaced) {
+    SERIAL_ECHO_START();
+    SERIAL_ECHOLNPGM(MSG_SETTINGS_REPLACED);
+  }
+}
+
 /**
  * Post-process after Retrieve or Reset
  */
 void MarlinSettings::postprocess() {
-  // steps per s2 needs to be updated to agree with units per s2
-  planner.reset_acceleration_rates();
+  validate_planner_settings();
+
+  #if ENABLED(ARC_SUPPORT)
+    // plan_arc() divides by the segment lengths, so they're only taken together
+    if (!(arc_chord_tolerance >= 0 && arc_segment_min_mm > 0 && arc_segment_max_mm >= arc_segment_min_mm)) {
+      arc_chord_tolerance = ARC_CHORD_TOLERANCE;
+      arc_segment_min_mm = MIN_ARC_SEGMENT_MM;
+      arc_segment_max_mm = MAX_ARC_SEGMENT_MM;
+      SERIAL_ECHO_START();
+      SERIAL_ECHOLNPGM(MSG_SETTINGS_REPLACED);
+    }
+  #endif
+
+  #if ENABLED(TRAVEL_JERK)
+    if (!(planner.travel_jerk[X_AXIS] >= 0 && planner.travel_jerk[Y_AXIS] >= 0 && planner.travel_jerk[Z_AXIS] >= 0
+      #if ENABLED(JUNCTION_DEVIATION)
+        && planner.travel_junction_deviation_mm > 0
+      #endif
+    )) {
+      planner.travel_jerk[X_AXIS] = DEFAULT_TRAVEL_XJERK;
+      planner.travel_jerk[Y_AXIS] = DEFAULT_TRAVEL_YJERK;
+      planner.travel_jerk[Z_AXIS] = DEFAULT_TRAVEL_ZJERK;
+      #if ENABLED(JUNCTION_DEVIATION)
+        planner.travel_junction_deviation_mm = TRAVEL_JUNCTION_DEVIATION_MM;
+      #endif
+      SERIAL_ECHO_START();
+      SERIAL_ECHOLNPGM(MSG_SETTINGS_REPLACED);
+    }
+  #endif
+
+  #if ENABLED(INPUT_SHAPING)
+    {
+      constexpr const float default_frequency[2] = { SHAPING_FREQ_X, SHAPING_FREQ_Y },
+                            default_zeta[2] = { SHAPING_ZETA_X, SHAPING_ZETA_Y };
+      constexpr const uint8 default_type[2] = { SHAPING_TYPE_X, SHAPING_TYPE_Y };
+      for (uint8 a = X_AXIS; a <= Y_AXIS; ++a) {
+        const float frequency = stepper.shaping_frequency[a], zeta = stepper.shaping_zeta[a];
+        if (!((frequency == 0 || WITHIN(frequency, 10, 200)) && WITHIN(zeta, 0, 0.9f) && stepper.shaping_type[a] <= 1)) {
+          stepper.shaping_frequency[a] = default_frequency[a];
+          stepper.shaping_zeta[a] = default_zeta[a];
+          stepper.shaping_type[a] = default_type[a];
+          SERIAL_ECHO_START();
+          SERIAL_ECHOLNPGM(MSG_SETTINGS_REPLACED);
+        }
+      }
+    }
+    stepper.refresh_shaping();
+  #endif
+
+  #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+    for (uint8_t e = 0; e < EXTRUDERS; e++) {
+      if (!(planner.volumetric_extruder_limit[e] >= 0)) {
+        planner.volumetric_extruder_limit[e] = DEFAULT_VOLUMETRIC_EXTRUDER_LIMIT;
+        SERIAL_ECHO_START();
+        SERIAL_ECHOLNPGM(MSG_SETTINGS_REPLACED);
+      }
+    }
+  #endif
 
   // Make sure delta kinematics are updated before refreshing the
   // planner position so the stepper counts will be set correctly.
@@ -215,8 +322,9 @@ void MarlinSettings::postprocess() {
     recalc_delta_settings(delta_radius, delta_diagonal_rod);
   #endif
 
-  // Refresh steps_to_mm with the reciprocal of axis_steps_per_mm
-  // and init stepper.count[], planner.position[] with current_position
+  // Refresh steps_to_mm with the reciprocal of axis_steps_per_mm, the acceleration
+  // rates and feedrate reciprocals, and init stepper.count[], planner.position[]
+  // with current_position
   planner.refresh_positioning();
 
   #if ENABLED(PIDTEMP)
@@ -247,22 +355,121 @@ void MarlinSettings::postprocess() {
 #if ENABLED(EEPROM_SETTINGS)
 
   #define DUMMY_PID_VALUE 3000.0f
-  #define EEPROM_START() int eeprom_index = EEPROM_OFFSET
+  #define EEPROM_START() int eeprom_index = EEPROM_BASE
   #define EEPROM_SKIP(VAR) eeprom_index += sizeof(VAR)
-  #define EEPROM_WRITE(VAR) write_data(eeprom_index, (uint8_t*)&VAR, sizeof(VAR), &working_crc)
-  #define EEPROM_READ(VAR) read_data(eeprom_index, (uint8_t*)&VAR, sizeof(VAR), &working_crc)
+  #if ENABLED(SETTINGS_PROFILES)
+    // Nothing goes past the end of the profile, into the next one
+    #define EEPROM_WRITE(VAR) do{ if (eeprom_index + sizeof(VAR) <= EEPROM_LIMIT) write_data(eeprom_index, (uint8_t*)&VAR, sizeof(VAR), &working_crc); else { eeprom_index = EEPROM_LIMIT + 1; eeprom_error = true; } }while(0)
+  #else
+    #define EEPROM_WRITE(VAR) write_data(eeprom_index, (uint8_t*)&VAR, sizeof(VAR), &working_crc)
+  #endif
+  #define EEPROM_READ(VAR) read_data(eeprom_index, (uint8_t*)&VAR, sizeof(VAR), nullptr) // load() checks the CRC up front
   #define EEPROM_ASSERT(TST,ERR) if (!(TST)) do{ SERIAL_ERROR_START(); SERIAL_ERRORLNPGM(ERR); eeprom_read_error = true; }while(0)
 
   const char version[4] = EEPROM_VERSION;
 
   bool MarlinSettings::eeprom_error;
 
+  #if ENABLED(SETTINGS_PROFILES)
+    uint8_t MarlinSettings::active_profile = 0xFF; // Read from the EEPROM on the first load()
+
+    void MarlinSettings::select_profile(const uint8_t profile) {
+      active_profile = profile;
+      #if ENABLED(EEPROM_BACKGROUND_WRITE)
+        queue_write(EEPROM_PROFILE_ADDRESS, &profile, 1);
+      #else
+        eeprom_update_byte((uint8_t*)EEPROM_PROFILE_ADDRESS, profile);
+      #endif
+    }
+  #endif
+
   #if ENABLED(AUTO_BED_LEVELING_UBL)
     int MarlinSettings::meshes_begin;
   #endif
 
+  #if ENABLED(EEPROM_BACKGROUND_WRITE)
+
+    // The bytes of a save on their way to the EEPROM, written by the EE_READY interrupt. Every byte
+    // goes through the queue, in order, and the interrupt skips those that haven't changed, so a byte
+    // stored twice in one save (the version) ends up with the later value. Only a changed byte takes
+    // the ~3.3 ms of an EEPROM write, and write_data() only waits while the queue is full.
+    struct eeprom_write_t {
+      uint16_t address;
+      uint8_t value;
+    };
+    static eeprom_write_t eeprom_writes[EEPROM_WRITE_QUEUE];
+    static spsc_ring<EEPROM_WRITE_QUEUE> eeprom_write_queue;
+    static eeprom_write_t eeprom_written;           // The byte being written, read back once it's done
+    static volatile bool eeprom_checking = false;
+    static volatile bool eeprom_write_failed = false;
+
+    static __forceinline uint8_t eeprom_read_ready(const uint16_t address) {
+      EEAR = address;
+      EECR |= _BV(EERE);
+      return EEDR;
+    }
+
+    __signal(EE_READY) {
+      if (eeprom_checking) {
+        eeprom_checking = false;
+        if (__unlikely(eeprom_read_ready(eeprom_written.address) != eeprom_written.value))
+          eeprom_write_failed = true;
+      }
+
+      if (eeprom_write_queue.empty()) {
+        EECR &= ~_BV(EERIE);
+        return;
+      }
+
+      // A byte that hasn't changed is just dropped, and the interrupt comes back at once for the next.
+      const eeprom_write_t write = eeprom_writes[eeprom_write_queue.tail()];
+      eeprom_write_queue.pop();
+      if (eeprom_read_ready(write.address) != write.value) {
+        EEDR = write.value;
+        EECR |= _BV(EEMPE); // EEPE has to follow within 4 cycles; interrupts are off in here
+        EECR |= _BV(EEPE);
+        eeprom_written = write;
+        eeprom_checking = true;
+      }
+    }
+
+    bool MarlinSettings::writing() {
+      return !eeprom_write_queue.empty() || eeprom_checking;
+    }
+
+    bool MarlinSettings::finish_writes() {
+      while (writing()) idle();
+
+      if (__unlikely(eeprom_write_failed)) {
+        eeprom_write_failed = false;
+        SERIAL_ECHO_START();
+        SERIAL_ECHOLNPGM(MSG_ERR_EEPROM_WRITE);
+        return false;
+      }
+      return true;
+    }
+
+    void MarlinSettings::queue_write(uint16_t address, const void *data, uint16_t size) {
+      const uint8_t *value = (const uint8_t *)data;
+      while (size--) {
+        while (eeprom_write_queue.full()) { /* room comes with the next EE_READY */ }
+        eeprom_writes[eeprom_write_queue.head()] = { address++, *value++ };
+        eeprom_write_queue.push();
+        EECR |= _BV(EERIE);
+      }
+    }
+
+    void MarlinSettings::write_data(int &pos, const uint8_t *value, uint16_t size, uint16_t *crc) {
+      crc16(crc, value, size);
+      queue_write(pos, value, size);
+      pos += size;
+    }
+
+  #else
+
   void MarlinSettings::write_data(int &pos, const uint8_t *value, uint16_t size, uint16_t *crc) {
     if (__unlikely(eeprom_error)) return;
+    crc16(crc, value, size); // A failed write ends the save, so the CRC can be taken up front
     while (size--) {
       uint8_t * const p = (uint8_t * const)pos;
       uint8_t v = *value;
@@ -277,21 +484,35 @@ void MarlinSettings::postprocess() {
           return;
         }
       }
-      crc16(crc, &v, 1);
       pos++;
       value++;
     };
   }
 
+  #endif // !EEPROM_BACKGROUND_WRITE
+
   void MarlinSettings::read_data(int &pos, uint8_t* value, uint16_t size, uint16_t *crc) {
     if (__unlikely(eeprom_error)) return;
-    do {
-      uint8_t c = eeprom_read_byte((unsigned char*)pos);
-      *value = c;
-      crc16(crc, &c, 1);
-      pos++;
-      value++;
-    } while (--size);
+    #if ENABLED(EEPROM_BACKGROUND_WRITE)
+      if (__unlikely(writing()) && !finish_writes()) eeprom_error = true;
+    #endif
+    eeprom_read_block(value, (const void*)pos, size);
+    if (crc) crc16(crc, value, size);
+    pos += size;
+  }
+
+  // The CRC of 'size' bytes from 'pos', read a chunk at a time
+  static uint16_t eeprom_crc(int pos, uint16_t size) {
+    uint16_t crc = 0;
+    uint8_t chunk[32];
+    while (size) {
+      const uint8_t count = min(size, uint16_t(sizeof(chunk)));
+      eeprom_read_block(chunk, (const void*)pos, count);
+      crc16(&crc, chunk, count);
+      pos += count;
+      size -= count;
+    }
+    return crc;
   }
 
   /**
@@ -303,12 +524,16 @@ void MarlinSettings::postprocess() {
 
     uint16_t working_crc = 0;
 
+    #if ENABLED(EEPROM_BACKGROUND_WRITE)
+      (void)finish_writes(); // Report if the last save failed
+    #endif
+
     EEPROM_START();
 
     eeprom_error = false;
 
     EEPROM_WRITE(ver);     // invalidate data first
-    EEPROM_SKIP(working_crc); // Skip the checksum slot
+    eeprom_index = EEPROM_DATA; // Skip the checksum and size, written last
 
     working_crc = 0; // clear before first "real data"
 
@@ -326,6 +551,12 @@ void MarlinSettings::postprocess() {
     EEPROM_WRITE(planner.min_travel_feedrate_mm_s);
     EEPROM_WRITE(planner.min_segment_time);
     EEPROM_WRITE(planner.max_jerk);
+    #if ENABLED(JUNCTION_DEVIATION)
+      EEPROM_WRITE(planner.junction_deviation_mm);
+    #else
+      dummy = 0.02f;
+      EEPROM_WRITE(dummy);
+    #endif
     #if !HAS_HOME_OFFSET
       const float home_offset[XYZ] = { 0 };
     #endif
@@ -373,6 +604,20 @@ void MarlinSettings::postprocess() {
       EEPROM_WRITE(mesh_num_x);
       EEPROM_WRITE(mesh_num_y);
       EEPROM_WRITE(mbl.z_values);
+    #elif ENABLED(MESH_COMPENSATION)
+      // The points go in the same slot, as floats in mm
+      const bool leveling_is_on = mesh::active;
+      const uint8_t mesh_num_x = mesh::points_x, mesh_num_y = mesh::points_y;
+      dummy = 0.0f;
+      EEPROM_WRITE(leveling_is_on);
+      EEPROM_WRITE(dummy); // z_offset
+      EEPROM_WRITE(mesh_num_x);
+      EEPROM_WRITE(mesh_num_y);
+      for (uint8_t py = 0; py < mesh_num_y; ++py)
+        for (uint8_t px = 0; px < mesh_num_x; ++px) {
+          dummy = mesh::z_um[py][px] * 0.001f;
+          EEPROM_WRITE(dummy);
+        }
     #else // For disabled MBL write a default mesh
       const bool leveling_is_on = false;
       dummy = 0.0f;
@@ -489,9 +734,12 @@ void MarlinSettings::postprocess() {
       dummy = DUMMY_PID_VALUE;
       for (uint8_t q = 3; q--;) EEPROM_WRITE(dummy);
     #else
-      EEPROM_WRITE(Temperature::bedKp);
-      EEPROM_WRITE(Temperature::bedKi);
-      EEPROM_WRITE(Temperature::bedKd);
+      {
+        const auto &bed_calib = Tuna::Thermal::BedManager::GetCalibration();
+        EEPROM_WRITE(bed_calib.Kp);
+        EEPROM_WRITE(bed_calib.Ki);
+        EEPROM_WRITE(bed_calib.Kd);
+      }
     #endif
 
     #if !HAS_LCD_CONTRAST
@@ -629,31 +877,88 @@ void MarlinSettings::postprocess() {
       for (uint8_t q = 3; q--;) EEPROM_WRITE(dummyui32);
 
       // TUNA
-      const auto &calib = Tuna::Thermal::Manager::Simple::GetCalibration();
-      EEPROM_WRITE(calib.Exponent_);
-      const uint32 scalar = uint32(calib.Scalar_);
-      EEPROM_WRITE(scalar);
+      const auto &calib = Tuna::Thermal::HeaterManager::GetCalibration();
+      #if ENABLED(MODEL_HEATER_MANAGER)
+        EEPROM_WRITE(calib.HeatCapacity_);
+        EEPROM_WRITE(calib.AmbientLoss_);
+        EEPROM_WRITE(calib.FanLoss_);
+      #else
+        EEPROM_WRITE(calib.Exponent_);
+        const uint32 scalar = uint32(calib.Scalar_);
+        EEPROM_WRITE(scalar);
+      #endif
+      EEPROM_WRITE(Tuna::Thermal::FanCompensation::GetCalibration().Power_);
+      #if ENABLED(SHARED_QUEUE_POOL)
+        EEPROM_WRITE(queue_pool_blocks);
+      #else
+        const uint8_t pool_blocks = BLOCK_BUFFER_SIZE;
+        EEPROM_WRITE(pool_blocks);
+      #endif
+      #if ENABLED(ARC_SUPPORT)
+        EEPROM_WRITE(arc_chord_tolerance);
+        EEPROM_WRITE(arc_segment_min_mm);
+        EEPROM_WRITE(arc_segment_max_mm);
+      #else
+        dummy = 0.0f;
+        for (uint8_t q = 3; q--;) EEPROM_WRITE(dummy);
+      #endif
+      #if ENABLED(TRAVEL_JERK)
+        EEPROM_WRITE(planner.travel_jerk);
+        #if ENABLED(JUNCTION_DEVIATION)
+          EEPROM_WRITE(planner.travel_junction_deviation_mm);
+        #else
+          dummy = TRAVEL_JUNCTION_DEVIATION_MM;
+          EEPROM_WRITE(dummy);
+        #endif
+      #else
+        dummy = 0.0f;
+        for (uint8_t q = 4; q--;) EEPROM_WRITE(dummy);
+      #endif
+      #if ENABLED(INPUT_SHAPING)
+        EEPROM_WRITE(stepper.shaping_frequency);
+        EEPROM_WRITE(stepper.shaping_zeta);
+        EEPROM_WRITE(stepper.shaping_type);
+      #else
+        dummy = 0.0f;
+        for (uint8_t q = 4; q--;) EEPROM_WRITE(dummy);
+        const uint8 shaping_type[2] = { 0, 0 };
+        EEPROM_WRITE(shaping_type);
+      #endif
+      #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+        EEPROM_WRITE(planner.volumetric_extruder_limit);
+      #else
+        dummy = 0.0f;
+        for (uint8_t q = EXTRUDERS; q--;) EEPROM_WRITE(dummy);
+      #endif
       // ~TUNA
 
     if (__likely(!eeprom_error)) {
       const int eeprom_size = eeprom_index;
 
-      const uint16_t final_crc = working_crc;
+      const uint16_t final_crc = working_crc,
+                     data_size = eeprom_size - (EEPROM_DATA);
 
       // Write the EEPROM header
-      eeprom_index = EEPROM_OFFSET;
+      eeprom_index = EEPROM_BASE;
 
       EEPROM_WRITE(version);
       EEPROM_WRITE(final_crc);
+      EEPROM_WRITE(data_size);
 
       // Report storage size
       #if ENABLED(EEPROM_CHITCHAT)
         SERIAL_ECHO_START();
-        SERIAL_ECHOPAIR("Settings Stored (", eeprom_size - (EEPROM_OFFSET));
+        SERIAL_ECHOPAIR("Settings Stored (", eeprom_size - (EEPROM_BASE));
         SERIAL_ECHOPAIR(" bytes; crc ", final_crc);
         SERIAL_ECHOLNPGM(")");
       #endif
     }
+    #if ENABLED(SETTINGS_PROFILES)
+      else if (eeprom_index > EEPROM_LIMIT) {
+        SERIAL_ERROR_START();
+        SERIAL_ERRORLNPGM(MSG_ERR_SETTINGS_PROFILE_FULL);
+      }
+    #endif
 
     #if ENABLED(UBL_SAVE_ACTIVE_ON_M500)
       if (ubl.state.storage_slot >= 0)
@@ -667,35 +972,58 @@ void MarlinSettings::postprocess() {
    * M501 - Retrieve Configuration
    */
   bool MarlinSettings::load() {
-    uint16_t working_crc = 0;
+    #if ENABLED(SETTINGS_PROFILES)
+      if (__unlikely(active_profile >= SETTINGS_PROFILE_COUNT)) {
+        #if ENABLED(EEPROM_BACKGROUND_WRITE)
+          (void)finish_writes();
+        #endif
+        const uint8_t stored = eeprom_read_byte((const uint8_t*)EEPROM_PROFILE_ADDRESS);
+        active_profile = (stored < SETTINGS_PROFILE_COUNT) ? stored : 0;
+      }
+      #if ENABLED(EEPROM_CHITCHAT)
+        SERIAL_ECHO_START();
+        SERIAL_ECHOLNPAIR(MSG_SETTINGS_PROFILE, active_profile);
+      #endif
+    #endif
 
     EEPROM_START();
 
-    char stored_ver[4];
-    EEPROM_READ(stored_ver);
+    settings_header_t header;
+    EEPROM_READ(header);
 
-    uint16_t stored_crc;
-    EEPROM_READ(stored_crc);
+    // The data is checked as a whole, before any of it is set
+    const uint16_t working_crc = (header.size <= EEPROM_LIMIT - (EEPROM_DATA))
+      ? eeprom_crc(EEPROM_DATA, header.size)
+      : uint16_t(~header.crc);
 
     // Version has to match or defaults are used
-    if (__unlikely(strncmp(version, stored_ver, 3) != 0)) {
-      if (stored_ver[0] != 'V') {
-        stored_ver[0] = '?';
-        stored_ver[1] = '\0';
+    if (__unlikely(strncmp(version, header.version, 3) != 0)) {
+      if (header.version[0] != 'V') {
+        header.version[0] = '?';
+        header.version[1] = '\0';
       }
       #if ENABLED(EEPROM_CHITCHAT)
         SERIAL_ECHO_START();
         SERIAL_ECHOPGM("EEPROM version mismatch ");
-        SERIAL_ECHOPAIR("(EEPROM=", stored_ver);
+        SERIAL_ECHOPAIR("(EEPROM=", header.version);
         SERIAL_ECHOLNPGM(" Marlin=" EEPROM_VERSION ")");
       #endif
       reset();
     }
+    else if (__unlikely(working_crc != header.crc)) {
+      #if ENABLED(EEPROM_CHITCHAT)
+        SERIAL_ERROR_START();
+        SERIAL_ERRORPGM("EEPROM CRC mismatch - (stored) ");
+        SERIAL_ERROR(header.crc);
+        SERIAL_ERRORPGM(" != ");
+        SERIAL_ERROR(working_crc);
+        SERIAL_ERRORLNPGM(" (calculated)!");
+      #endif
+      reset();
+    }
     else {
       float dummy = 0;
 
-      working_crc = 0; //clear before reading first "real data"
-
       // Number of esteppers may change
       uint8_t esteppers;
       EEPROM_READ(esteppers);
@@ -722,6 +1050,11 @@ void MarlinSettings::postprocess() {
       EEPROM_READ(planner.min_travel_feedrate_mm_s);
       EEPROM_READ(planner.min_segment_time);
       EEPROM_READ(planner.max_jerk);
+      #if ENABLED(JUNCTION_DEVIATION)
+        EEPROM_READ(planner.junction_deviation_mm);
+      #else
+        EEPROM_READ(dummy);
+      #endif
 
       #if !HAS_HOME_OFFSET
         float home_offset[XYZ];
@@ -773,6 +1106,22 @@ void MarlinSettings::postprocess() {
           mbl.reset();
           for (uint16_t q = mesh_num_x * mesh_num_y; q--;) EEPROM_READ(dummy);
         }
+      #elif ENABLED(MESH_COMPENSATION)
+        if (mesh_num_x == mesh::points_x && mesh_num_y == mesh::points_y) {
+          for (uint8_t py = 0; py < mesh_num_y; ++py)
+            for (uint8_t px = 0; px < mesh_num_x; ++px) {
+              EEPROM_READ(dummy);
+              mesh::z_um[py][px] = int16_t(constrain(LROUND(dummy * 1000.0f), -mesh::limit_um, mesh::limit_um));
+            }
+          mesh::changed();
+          set_bed_leveling_enabled(leveling_is_on);
+        }
+        else {
+          // The stored mesh doesn't fit the grid
+          set_bed_leveling_enabled(false);
+          mesh::reset();
+          for (uint16_t q = mesh_num_x * mesh_num_y; q--;) EEPROM_READ(dummy);
+        }
       #else
         // MBL is disabled - skip the stored data
         for (uint16_t q = mesh_num_x * mesh_num_y; q--;) EEPROM_READ(dummy);
@@ -877,9 +1226,14 @@ void MarlinSettings::postprocess() {
       #if ENABLED(PIDTEMPBED)
         EEPROM_READ(dummy); // bedKp
         if (dummy != DUMMY_PID_VALUE) {
-          Temperature::bedKp = dummy;
-          EEPROM_READ(Temperature::bedKi);
-          EEPROM_READ(Temperature::bedKd);
+          Thermal::BedManager::calibration bed_calib;
+          bed_calib.Kp = dummy;
+          EEPROM_READ(bed_calib.Ki);
+          EEPROM_READ(bed_calib.Kd);
+          Tuna::Thermal::BedManager::SetCalibration(bed_calib);
+        }
+        else {
+          for (uint8_t q=2; q--;) EEPROM_READ(dummy); // bedKi, bedKd
         }
       #else
         for (uint8_t q=3; q--;) EEPROM_READ(dummy); // bedKp, bedKi, bedKd
@@ -993,32 +1347,80 @@ void MarlinSettings::postprocess() {
         for (uint8_t q = 3; q--;) EEPROM_READ(dummyui32);
 
         // TUNA
-        Thermal::Manager::Simple::calibration calib;
-        EEPROM_READ(calib.Exponent_);
-        uint32 scalar;
-        EEPROM_READ(scalar);
-        calib.Scalar_ = uint8(scalar);
-        Tuna::Thermal::Manager::Simple::SetCalibration(calib);
+        Thermal::HeaterManager::calibration calib;
+        #if ENABLED(MODEL_HEATER_MANAGER)
+          EEPROM_READ(calib.HeatCapacity_);
+          EEPROM_READ(calib.AmbientLoss_);
+          EEPROM_READ(calib.FanLoss_);
+        #else
+          EEPROM_READ(calib.Exponent_);
+          uint32 scalar;
+          EEPROM_READ(scalar);
+          calib.Scalar_ = uint8(scalar);
+        #endif
+        Tuna::Thermal::HeaterManager::SetCalibration(calib);
+        Thermal::FanCompensation::calibration fan_calib;
+        EEPROM_READ(fan_calib.Power_);
+        Tuna::Thermal::FanCompensation::SetCalibration(fan_calib);
+        #if ENABLED(SHARED_QUEUE_POOL)
+          EEPROM_READ(queue_pool_blocks); // Checked when the pool is laid out
+        #else
+          uint8_t pool_blocks;
+          EEPROM_READ(pool_blocks);
+        #endif
+        #if ENABLED(ARC_SUPPORT)
+          EEPROM_READ(arc_chord_tolerance); // Checked by postprocess()
+          EEPROM_READ(arc_segment_min_mm);
+          EEPROM_READ(arc_segment_max_mm);
+        #else
+          for (uint8_t q = 3; q--;) EEPROM_READ(dummy);
+        #endif
+        #if ENABLED(TRAVEL_JERK)
+          EEPROM_READ(planner.travel_jerk); // Checked by postprocess()
+          #if ENABLED(JUNCTION_DEVIATION)
+            EEPROM_READ(planner.travel_junction_deviation_mm);
+          #else
+            EEPROM_READ(dummy);
+          #endif
+        #else
+          for (uint8_t q = 4; q--;) EEPROM_READ(dummy);
+        #endif
+        #if ENABLED(INPUT_SHAPING)
+          EEPROM_READ(stepper.shaping_frequency); // Checked by postprocess()
+          EEPROM_READ(stepper.shaping_zeta);
+          EEPROM_READ(stepper.shaping_type);
+        #else
+          for (uint8_t q = 4; q--;) EEPROM_READ(dummy);
+          uint8 shaping_type[2];
+          EEPROM_READ(shaping_type);
+        #endif
+        #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+          EEPROM_READ(planner.volumetric_extruder_limit); // Checked by postprocess()
+        #else
+          for (uint8_t q = EXTRUDERS; q--;) EEPROM_READ(dummy);
+        #endif
         // ~TUNA
 
-      if (working_crc == stored_crc) {
+      // A build that reads more or less than was saved has a different layout under the same version
+      const uint16_t read_size = eeprom_index - (EEPROM_DATA);
+      if (__likely(read_size == header.size)) {
         postprocess();
         #if ENABLED(EEPROM_CHITCHAT)
           SERIAL_ECHO_START();
           SERIAL_ECHO(version);
-          SERIAL_ECHOPAIR(" stored settings retrieved (", eeprom_index - (EEPROM_OFFSET));
-          SERIAL_ECHOPAIR(" bytes; crc ", working_crc);
+          SERIAL_ECHOPAIR(" stored settings retrieved (", eeprom_index - (EEPROM_BASE));
+          SERIAL_ECHOPAIR(" bytes; crc ", header.crc);
           SERIAL_ECHOLNPGM(")");
         #endif
       }
       else {
         #if ENABLED(EEPROM_CHITCHAT)
           SERIAL_ERROR_START();
-          SERIAL_ERRORPGM("EEPROM CRC mismatch - (stored) ");
-          SERIAL_ERROR(stored_crc);
+          SERIAL_ERRORPGM("EEPROM size mismatch - (stored) ");
+          SERIAL_ERROR(header.size);
           SERIAL_ERRORPGM(" != ");
-          SERIAL_ERROR(working_crc);
-          SERIAL_ERRORLNPGM(" (calculated)!");
+          SERIAL_ERROR(read_size);
+          SERIAL_ERRORLNPGM(" (read)!");
         #endif
         reset();
       }
@@ -1187,6 +1589,17 @@ void MarlinSettings::reset() {
   planner.max_jerk[Y_AXIS] = DEFAULT_YJERK;
   planner.max_jerk[Z_AXIS] = DEFAULT_ZJERK;
   planner.max_jerk[E_AXIS] = DEFAULT_EJERK;
+  #if ENABLED(JUNCTION_DEVIATION)
+    planner.junction_deviation_mm = JUNCTION_DEVIATION_MM;
+  #endif
+  #if ENABLED(TRAVEL_JERK)
+    planner.travel_jerk[X_AXIS] = DEFAULT_TRAVEL_XJERK;
+    planner.travel_jerk[Y_AXIS] = DEFAULT_TRAVEL_YJERK;
+    planner.travel_jerk[Z_AXIS] = DEFAULT_TRAVEL_ZJERK;
+    #if ENABLED(JUNCTION_DEVIATION)
+      planner.travel_junction_deviation_mm = TRAVEL_JUNCTION_DEVIATION_MM;
+    #endif
+  #endif
 
   //
   // i3++
@@ -1226,6 +1639,9 @@ void MarlinSettings::reset() {
   // Applies to all MBL and ABL
   #if HAS_LEVELING
     reset_bed_level();
+  #elif ENABLED(MESH_COMPENSATION)
+    set_bed_leveling_enabled(false);
+    mesh::reset();
   #endif
 
   #if HAS_BED_PROBE
@@ -1264,9 +1680,7 @@ void MarlinSettings::reset() {
   #endif // PIDTEMP
 
   #if ENABLED(PIDTEMPBED)
-    Temperature::bedKp = DEFAULT_bedKp;
-    Temperature::bedKi = scalePID_i(DEFAULT_bedKi);
-    Temperature::bedKd = scalePID_d(DEFAULT_bedKd);
+    Tuna::Thermal::BedManager::SetCalibration({ DEFAULT_bedKp, DEFAULT_bedKi, DEFAULT_bedKd });
   #endif
 
   #if ENABLED(FWRETRACT)
@@ -1340,6 +1754,30 @@ void MarlinSettings::reset() {
     planner.advance_ed_ratio = LIN_ADVANCE_E_D_RATIO;
   #endif
 
+  #if ENABLED(SHARED_QUEUE_POOL)
+    queue_pool_blocks = BLOCK_BUFFER_SIZE;
+  #endif
+
+  #if ENABLED(ARC_SUPPORT)
+    arc_chord_tolerance = ARC_CHORD_TOLERANCE;
+    arc_segment_min_mm = MIN_ARC_SEGMENT_MM;
+    arc_segment_max_mm = MAX_ARC_SEGMENT_MM;
+  #endif
+
+  #if ENABLED(INPUT_SHAPING)
+    stepper.shaping_frequency[X_AXIS] = SHAPING_FREQ_X;
+    stepper.shaping_frequency[Y_AXIS] = SHAPING_FREQ_Y;
+    stepper.shaping_zeta[X_AXIS] = SHAPING_ZETA_X;
+    stepper.shaping_zeta[Y_AXIS] = SHAPING_ZETA_Y;
+    stepper.shaping_type[X_AXIS] = SHAPING_TYPE_X;
+    stepper.shaping_type[Y_AXIS] = SHAPING_TYPE_Y;
+  #endif
+
+  #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+    for (uint8_t e = 0; e < EXTRUDERS; e++)
+      planner.volumetric_extruder_limit[e] = DEFAULT_VOLUMETRIC_EXTRUDER_LIMIT;
+  #endif
+
   #if ENABLED(AUTO_BED_LEVELING_UBL)
     ubl.reset();
   #endif
@@ -1414,22 +1852,37 @@ void MarlinSettings::reset() {
 
     CONFIG_ECHO_START;
     SERIAL_ECHOPAIR("  M200 D", filament_size[0]);
+    #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+      SERIAL_ECHOPAIR(" L", planner.volumetric_extruder_limit[0]);
+    #endif
     SERIAL_EOL();
     #if EXTRUDERS > 1
       CONFIG_ECHO_START;
       SERIAL_ECHOPAIR("  M200 T1 D", filament_size[1]);
+      #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+        SERIAL_ECHOPAIR(" L", planner.volumetric_extruder_limit[1]);
+      #endif
       SERIAL_EOL();
       #if EXTRUDERS > 2
         CONFIG_ECHO_START;
         SERIAL_ECHOPAIR("  M200 T2 D", filament_size[2]);
+        #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+          SERIAL_ECHOPAIR(" L", planner.volumetric_extruder_limit[2]);
+        #endif
         SERIAL_EOL();
         #if EXTRUDERS > 3
           CONFIG_ECHO_START;
           SERIAL_ECHOPAIR("  M200 T3 D", filament_size[3]);
+          #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+            SERIAL_ECHOPAIR(" L", planner.volumetric_extruder_limit[3]);
+          #endif
           SERIAL_EOL();
           #if EXTRUDERS > 4
             CONFIG_ECHO_START;
             SERIAL_ECHOPAIR("  M200 T4 D", filament_size[4]);
+            #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+              SERIAL_ECHOPAIR(" L", planner.volumetric_extruder_limit[4]);
+            #endif
             SERIAL_EOL();
           #endif // EXTRUDERS > 4
         #endif // EXTRUDERS > 3
@@ -1512,7 +1965,11 @@ void MarlinSettings::reset() {
 
     if (!forReplay) {
       CONFIG_ECHO_START;
-      SERIAL_ECHOLNPGM("Advanced: S<min_feedrate> T<min_travel_feedrate> B<min_segment_time_ms> X<max_xy_jerk> Z<max_z_jerk> E<max_e_jerk>");
+      #if ENABLED(JUNCTION_DEVIATION)
+        SERIAL_ECHOLNPGM("Advanced: S<min_feedrate> T<min_travel_feedrate> B<min_segment_time_ms> X<max_xy_jerk> Z<max_z_jerk> E<max_e_jerk> J<junction_deviation>");
+      #else
+        SERIAL_ECHOLNPGM("Advanced: S<min_feedrate> T<min_travel_feedrate> B<min_segment_time_ms> X<max_xy_jerk> Z<max_z_jerk> E<max_e_jerk>");
+      #endif
     }
     CONFIG_ECHO_START;
     SERIAL_ECHOPAIR("  M205 S", LINEAR_UNIT(planner.min_feedrate_mm_s));
@@ -1521,7 +1978,12 @@ void MarlinSettings::reset() {
     SERIAL_ECHOPAIR(" X", LINEAR_UNIT(planner.max_jerk[X_AXIS]));
     SERIAL_ECHOPAIR(" Y", LINEAR_UNIT(planner.max_jerk[Y_AXIS]));
     SERIAL_ECHOPAIR(" Z", LINEAR_UNIT(planner.max_jerk[Z_AXIS]));
-    SERIAL_ECHOLNPAIR(" E", LINEAR_UNIT(planner.max_jerk[E_AXIS]));
+    #if ENABLED(JUNCTION_DEVIATION)
+      SERIAL_ECHOPAIR(" E", LINEAR_UNIT(planner.max_jerk[E_AXIS]));
+      SERIAL_ECHOLNPAIR(" J", LINEAR_UNIT(planner.junction_deviation_mm));
+    #else
+      SERIAL_ECHOLNPAIR(" E", LINEAR_UNIT(planner.max_jerk[E_AXIS]));
+    #endif
 
     #if HAS_M206_COMMAND
       if (!forReplay) {
@@ -1574,6 +2036,25 @@ void MarlinSettings::reset() {
         }
       }
 
+    #elif ENABLED(MESH_COMPENSATION)
+
+      if (!forReplay) {
+        CONFIG_ECHO_START;
+        SERIAL_ECHOLNPGM("Mesh Compensation:");
+      }
+      for (uint8_t py = 0; py < mesh::points_y; py++) {
+        for (uint8_t px = 0; px < mesh::points_x; px++) {
+          CONFIG_ECHO_START;
+          SERIAL_ECHOPAIR("  M421 I", (int)px);
+          SERIAL_ECHOPAIR(" J", (int)py);
+          SERIAL_ECHOPGM(" Z");
+          SERIAL_PROTOCOL_F(LINEAR_UNIT(mesh::z_um[py][px] * 0.001f), 3);
+          SERIAL_EOL();
+        }
+      }
+      CONFIG_ECHO_START;
+      SERIAL_ECHOLNPAIR("  M420 S", mesh::active ? 1 : 0);
+
     #elif ENABLED(AUTO_BED_LEVELING_UBL)
 
       if (!forReplay) {
@@ -1672,9 +2153,10 @@ void MarlinSettings::reset() {
 
       #if ENABLED(PIDTEMPBED)
         CONFIG_ECHO_START;
-        SERIAL_ECHOPAIR("  M304 P", thermalManager.bedKp);
-        SERIAL_ECHOPAIR(" I", unscalePID_i(thermalManager.bedKi));
-        SERIAL_ECHOPAIR(" D", unscalePID_d(thermalManager.bedKd));
+        const auto &bed_calib = Tuna::Thermal::BedManager::GetCalibration();
+        SERIAL_ECHOPAIR("  M304 P", bed_calib.Kp);
+        SERIAL_ECHOPAIR(" I", bed_calib.Ki);
+        SERIAL_ECHOPAIR(" D", bed_calib.Kd);
         SERIAL_EOL();
       #endif
 
@@ -1790,6 +2272,69 @@ void MarlinSettings::reset() {
       SERIAL_ECHOPAIR("  M900 K", planner.extruder_advance_k);
       SERIAL_ECHOLNPAIR(" R", planner.advance_ed_ratio);
     #endif
+
+    /**
+     * Queue pool
+     */
+    #if ENABLED(SHARED_QUEUE_POOL)
+      if (!forReplay) {
+        CONFIG_ECHO_START;
+        SERIAL_ECHOLNPGM("Queue pool planner blocks:");
+      }
+      CONFIG_ECHO_START;
+      SERIAL_ECHOLNPAIR("  M292 B", int(queue_pool_blocks));
+    #endif
+
+    /**
+     * Arc segmentation
+     */
+    #if ENABLED(ARC_SUPPORT)
+      if (!forReplay) {
+        CONFIG_ECHO_START;
+        SERIAL_ECHOLNPGM("Arc segments: S<chord tolerance> P<min length> Q<max length>");
+      }
+      CONFIG_ECHO_START;
+      SERIAL_ECHOPAIR("  M287 S", LINEAR_UNIT(arc_chord_tolerance));
+      SERIAL_ECHOPAIR(" P", LINEAR_UNIT(arc_segment_min_mm));
+      SERIAL_ECHOLNPAIR(" Q", LINEAR_UNIT(arc_segment_max_mm));
+    #endif
+
+    /**
+     * Travel jerk
+     */
+    #if ENABLED(TRAVEL_JERK)
+      if (!forReplay) {
+        CONFIG_ECHO_START;
+        SERIAL_ECHOLNPGM("Travel jerk (units/s):");
+      }
+      CONFIG_ECHO_START;
+      SERIAL_ECHOPAIR("  M286 X", LINEAR_UNIT(planner.travel_jerk[X_AXIS]));
+      SERIAL_ECHOPAIR(" Y", LINEAR_UNIT(planner.travel_jerk[Y_AXIS]));
+      #if ENABLED(JUNCTION_DEVIATION)
+        SERIAL_ECHOPAIR(" Z", LINEAR_UNIT(planner.travel_jerk[Z_AXIS]));
+        SERIAL_ECHOLNPAIR(" J", LINEAR_UNIT(planner.travel_junction_deviation_mm));
+      #else
+        SERIAL_ECHOLNPAIR(" Z", LINEAR_UNIT(planner.travel_jerk[Z_AXIS]));
+      #endif
+    #endif
+
+    /**
+     * Input shaping
+     */
+    #if ENABLED(INPUT_SHAPING)
+      if (!forReplay) {
+        CONFIG_ECHO_START;
+        SERIAL_ECHOLNPGM("Input shaping:");
+      }
+      for (uint8 a = X_AXIS; a <= Y_AXIS; ++a) {
+        CONFIG_ECHO_START;
+        SERIAL_ECHOPGM("  M593 ");
+        SERIAL_CHAR('X' + a);
+        SERIAL_ECHOPAIR(" F", stepper.shaping_frequency[a]);
+        SERIAL_ECHOPAIR(" D", stepper.shaping_zeta[a]);
+        SERIAL_ECHOLNPAIR(" T", int(stepper.shaping_type[a]));
+      }
+    #endif
   }
 
 #endif // !DISABLE_M503
@@ -35,6 +35,19 @@ class MarlinSettings final {
     #if ENABLED(EEPROM_SETTINGS)
       static bool load();
 
+      #if ENABLED(SETTINGS_PROFILES)
+        // The profile that load() and save() use. select_profile() makes it the one to boot with,
+        // without loading or saving anything itself.
+        static uint8_t __forceinline profile() { return active_profile; }
+        static void select_profile(const uint8_t profile);
+      #endif
+
+      #if ENABLED(EEPROM_BACKGROUND_WRITE)
+        static bool writing();        // A save's bytes are still being written
+        static bool finish_writes();  // Wait for them, calling idle(). False if one didn't take.
+        static void queue_write(uint16_t address, const void *data, uint16_t size); // For other EEPROM users
+      #endif
+
       #if ENABLED(AUTO_BED_LEVELING_UBL) // Eventually make these available if any leveling system
                                          // That can store is enabled
         static int __forceinline get_start_of_meshes() { return meshes_begin; }
@@ -62,6 +75,10 @@ class MarlinSettings final {
     #if ENABLED(EEPROM_SETTINGS)
       static bool eeprom_error;
 
+      #if ENABLED(SETTINGS_PROFILES)
+        static uint8_t active_profile;
+      #endif
+
       #if ENABLED(AUTO_BED_LEVELING_UBL) // Eventually make these available if any leveling system
                                          // That can store is enabled
         static int meshes_begin;
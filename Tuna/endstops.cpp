@@ -32,8 +32,32 @@
 #include "stepper.h"
 #include "bi3_plus_lcd.h"
 
-// TEST_ENDSTOP: test the old and the current status of an endstop
-#define TEST_ENDSTOP(ENDSTOP) (TEST(current_endstop_bits & old_endstop_bits, ENDSTOP))
+#ifndef ENDSTOP_DEBOUNCE
+  #define ENDSTOP_DEBOUNCE 2
+#endif
+
+#if ENDSTOP_DEBOUNCE > 2
+  // HELD_ENDSTOP_BITS: the endstops that read as triggered in each of the last ENDSTOP_DEBOUNCE - 1 updates
+  static inline byte __forceinline __flatten held_endstop_bits() {
+    byte held = Endstops::old_endstop_bits;
+    for (uint8_t i = 0; i < ENDSTOP_DEBOUNCE - 2; ++i) held &= Endstops::older_endstop_bits[i];
+    return held;
+  }
+  #define HELD_ENDSTOP_BITS held_endstop_bits()
+
+  // END_ENDSTOP_UPDATE: move the update just done into the history
+  #define END_ENDSTOP_UPDATE() do { \
+      for (uint8_t i = ENDSTOP_DEBOUNCE - 2; --i;) older_endstop_bits[i] = older_endstop_bits[i - 1]; \
+      older_endstop_bits[0] = old_endstop_bits; \
+      old_endstop_bits = current_endstop_bits; \
+    } while(0)
+#else
+  #define HELD_ENDSTOP_BITS old_endstop_bits
+  #define END_ENDSTOP_UPDATE() (old_endstop_bits = current_endstop_bits)
+#endif
+
+// TEST_ENDSTOP: test the held and the current status of an endstop
+#define TEST_ENDSTOP(ENDSTOP) (TEST(current_endstop_bits & HELD_ENDSTOP_BITS, ENDSTOP))
 
 Endstops endstops;
 
@@ -58,10 +82,18 @@ volatile char Endstops::endstop_hit_bits; // use X_MIN, Y_MIN, Z_MIN and Z_MIN_P
     Endstops::current_endstop_bits = 0,
     Endstops::old_endstop_bits = 0;
 
+#if ENDSTOP_DEBOUNCE > 2
+  byte Endstops::older_endstop_bits[ENDSTOP_DEBOUNCE - 2] = { 0 };
+#endif
+
 #if HAS_BED_PROBE
   volatile bool Endstops::z_probe_enabled = false;
 #endif
 
+#if ENABLED(PARALLEL_HOMING)
+  volatile bool Endstops::stop_per_axis = false;
+#endif
+
 /**
  * Class and Instance Methods
  */
@@ -151,8 +183,17 @@ void Endstops::report_state() {
       #define _SET_STOP_CHAR(A,C) ;
     #endif
 
+    #if ENABLED(ENDSTOP_EDGE_LATCH)
+      #define _ENDSTOP_HIT_LAG(A) do{ \
+        SERIAL_ECHOPAIR(" (+", stepper.triggered_lag_us(A ##_AXIS)); \
+        SERIAL_ECHOPGM("us)"); }while(0)
+    #else
+      #define _ENDSTOP_HIT_LAG(A) NOOP
+    #endif
+
     #define _ENDSTOP_HIT_ECHO(A,C) do{ \
       SERIAL_ECHOPAIR(" " STRINGIFY(A) ":", stepper.triggered_position_mm(A ##_AXIS)); \
+      _ENDSTOP_HIT_LAG(A); \
       _SET_STOP_CHAR(A,C); }while(0)
 
     #define _ENDSTOP_HIT_TEST(A,C) \
@@ -240,11 +281,30 @@ void Endstops::update() {
   // COPY_BIT: copy the value of SRC_BIT to DST_BIT in DST
   #define COPY_BIT(DST, SRC_BIT, DST_BIT) SET_BIT(DST, DST_BIT, TEST(DST, SRC_BIT))
 
+  #if ENABLED(PARALLEL_HOMING)
+    #define _ENDSTOP_TRIGGERED(AXIS) do { \
+        if (stop_per_axis) stepper.endstop_axis_triggered(_AXIS(AXIS)); \
+        else stepper.endstop_triggered(_AXIS(AXIS)); \
+      } while(0)
+  #else
+    #define _ENDSTOP_TRIGGERED(AXIS) stepper.endstop_triggered(_AXIS(AXIS))
+  #endif
+
+  // _ENDSTOP_EDGE: latch the position of an axis as its endstop goes from open to triggered
+  #if ENABLED(ENDSTOP_EDGE_LATCH)
+    #define _ENDSTOP_EDGE(AXIS, MINMAX) do { \
+        if (TEST(current_endstop_bits & ~old_endstop_bits, _ENDSTOP(AXIS, MINMAX))) stepper.endstop_edge(_AXIS(AXIS)); \
+      } while(0)
+  #else
+    #define _ENDSTOP_EDGE(AXIS, MINMAX) NOOP
+  #endif
+
   #define UPDATE_ENDSTOP(AXIS,MINMAX) do { \
       UPDATE_ENDSTOP_BIT(AXIS, MINMAX); \
+      _ENDSTOP_EDGE(AXIS, MINMAX); \
       if (__unlikely(TEST_ENDSTOP(_ENDSTOP(AXIS, MINMAX)) && stepper.current_block->steps[_AXIS(AXIS)] > 0)) { \
         _ENDSTOP_HIT(AXIS); \
-        stepper.endstop_triggered(_AXIS(AXIS)); \
+        _ENDSTOP_TRIGGERED(AXIS); \
       } \
     } while(0)
 
@@ -340,6 +400,128 @@ void Endstops::update() {
     #define X_MAX_TEST true
   #endif
 
+  #if ENABLED(ENDSTOP_PORT_SAMPLING)
+
+    /**
+     * Sample all the endstops at once. Each input register with an endstop on it is read a single
+     * time, and every endstop takes its bit from its register's read. The registers are constant
+     * addresses, so choosing one folds away at compile time, as it does in _WRITE.
+     */
+    #define __ENDSTOP_RPORT(IO) DIO ## IO ## _RPORT
+    #define _ENDSTOP_RPORT(IO) __ENDSTOP_RPORT(IO)
+    #define __ENDSTOP_PINBIT(IO) _bv<DIO ## IO ## _PIN>
+    #define _ENDSTOP_PINBIT(IO) __ENDSTOP_PINBIT(IO)
+
+    // Runs F(AXIS, MINMAX, ARG) for each endstop that update() checks
+    #if HAS_X_MIN
+      #define _EACH_X_MIN(F, ARG) F(X, MIN, ARG)
+    #else
+      #define _EACH_X_MIN(F, ARG)
+    #endif
+    #if HAS_X_MAX
+      #define _EACH_X_MAX(F, ARG) F(X, MAX, ARG)
+    #else
+      #define _EACH_X_MAX(F, ARG)
+    #endif
+    #if HAS_Y_MIN
+      #define _EACH_Y_MIN(F, ARG) F(Y, MIN, ARG)
+    #else
+      #define _EACH_Y_MIN(F, ARG)
+    #endif
+    #if HAS_Y_MAX
+      #define _EACH_Y_MAX(F, ARG) F(Y, MAX, ARG)
+    #else
+      #define _EACH_Y_MAX(F, ARG)
+    #endif
+    #if HAS_Z_MIN
+      #define _EACH_Z_MIN(F, ARG) F(Z, MIN, ARG)
+    #else
+      #define _EACH_Z_MIN(F, ARG)
+    #endif
+    #if HAS_Z_MAX && (DISABLED(Z_MIN_PROBE_ENDSTOP) || Z_MAX_PIN != Z_MIN_PROBE_PIN)
+      #define _EACH_Z_MAX(F, ARG) F(Z, MAX, ARG)
+    #else
+      #define _EACH_Z_MAX(F, ARG)
+    #endif
+    #if ENABLED(Z_MIN_PROBE_ENDSTOP)
+      #define _EACH_Z_MIN_PROBE(F, ARG) F(Z, MIN_PROBE, ARG)
+    #else
+      #define _EACH_Z_MIN_PROBE(F, ARG)
+    #endif
+    #define SAMPLED_ENDSTOPS(F, ARG) _EACH_X_MIN(F, ARG) _EACH_X_MAX(F, ARG) _EACH_Y_MIN(F, ARG) _EACH_Y_MAX(F, ARG) \
+                                     _EACH_Z_MIN(F, ARG) _EACH_Z_MAX(F, ARG) _EACH_Z_MIN_PROBE(F, ARG)
+
+    // The ATmega1280/2560 input registers
+    #define ENDSTOP_PORTS(M, ARG) M(A, ARG) M(B, ARG) M(C, ARG) M(D, ARG) M(E, ARG) M(F, ARG) \
+                                  M(G, ARG) M(H, ARG) M(J, ARG) M(K, ARG) M(L, ARG)
+
+    #define _IS_ON_PORT(AXIS, MINMAX, REG) || &_ENDSTOP_RPORT(_ENDSTOP_PIN(AXIS, MINMAX)) == &REG
+    #define _READ_PORT(P, _) const uint8_t sample_##P = (false SAMPLED_ENDSTOPS(_IS_ON_PORT, PIN##P)) ? PIN##P : 0;
+    #define _PICK_PORT(P, REG) &REG == &PIN##P ? sample_##P :
+    #define _ENDSTOP_SAMPLE(IO) ((ENDSTOP_PORTS(_PICK_PORT, _ENDSTOP_RPORT(IO)) 0) & _ENDSTOP_PINBIT(IO))
+    #define _SAMPLE_BIT(AXIS, MINMAX, _) if (_ENDSTOP_SAMPLE(_ENDSTOP_PIN(AXIS, MINMAX))) SBI(bits, _ENDSTOP(AXIS, MINMAX));
+    #define _ENDSTOP_BIT(AXIS, MINMAX, _) | _BV(_ENDSTOP(AXIS, MINMAX))
+    #define _INVERT_BIT(AXIS, MINMAX, _) | (_ENDSTOP_INVERTING(AXIS, MINMAX) ? _BV(_ENDSTOP(AXIS, MINMAX)) : 0)
+
+    constexpr uint8_t
+      x_min = 0 _EACH_X_MIN(_ENDSTOP_BIT, _), x_max = 0 _EACH_X_MAX(_ENDSTOP_BIT, _),
+      y_min = 0 _EACH_Y_MIN(_ENDSTOP_BIT, _), y_max = 0 _EACH_Y_MAX(_ENDSTOP_BIT, _),
+      z_min = 0 _EACH_Z_MIN(_ENDSTOP_BIT, _), z_max = 0 _EACH_Z_MAX(_ENDSTOP_BIT, _),
+      z_probe = 0 _EACH_Z_MIN_PROBE(_ENDSTOP_BIT, _),
+      inverting = 0 SAMPLED_ENDSTOPS(_INVERT_BIT, _);
+
+    ENDSTOP_PORTS(_READ_PORT, _)
+
+    uint8_t bits = 0;
+    SAMPLED_ENDSTOPS(_SAMPLE_BIT, _)
+    bits ^= inverting;
+
+    // The endstops this block moves toward
+    uint8_t active = 0;
+    if (X_MOVE_TEST) active |= stepper.motor_direction(X_AXIS_HEAD) ? x_min : x_max;
+    if (Y_MOVE_TEST) active |= stepper.motor_direction(Y_AXIS_HEAD) ? y_min : y_max;
+    if (Z_MOVE_TEST) {
+      if (stepper.motor_direction(Z_AXIS_HEAD)) {
+        #if ENABLED(Z_MIN_PROBE_USES_Z_MIN_ENDSTOP_PIN)
+          if (z_probe_enabled) active |= z_min;
+        #else
+          active |= z_min;
+        #endif
+        #if ENABLED(Z_MIN_PROBE_ENDSTOP)
+          if (z_probe_enabled) active |= z_probe;
+        #endif
+      }
+      else
+        active |= z_max;
+    }
+
+    // Hit once it reads as triggered ENDSTOP_DEBOUNCE times in a row
+    const uint8_t hit = bits & HELD_ENDSTOP_BITS & active;
+    #if ENABLED(ENDSTOP_EDGE_LATCH)
+      const uint8_t edge = bits & ~old_endstop_bits & active;
+    #endif
+    current_endstop_bits = bits;
+    END_ENDSTOP_UPDATE();
+
+    #if ENABLED(ENDSTOP_EDGE_LATCH)
+      if (__unlikely(edge)) {
+        if (edge & (x_min | x_max)) stepper.endstop_edge(X_AXIS);
+        if (edge & (y_min | y_max)) stepper.endstop_edge(Y_AXIS);
+        if (edge & (z_min | z_max | z_probe)) stepper.endstop_edge(Z_AXIS);
+      }
+    #endif
+
+    if (__likely(!hit)) return;
+
+    if (hit & (x_min | x_max)) { _ENDSTOP_HIT(X); _ENDSTOP_TRIGGERED(X); }
+    if (hit & (y_min | y_max)) { _ENDSTOP_HIT(Y); _ENDSTOP_TRIGGERED(Y); }
+    if (hit & (z_min | z_max | z_probe)) { _ENDSTOP_HIT(Z); _ENDSTOP_TRIGGERED(Z); }
+    #if ENABLED(Z_MIN_PROBE_ENDSTOP)
+      if (hit & z_probe) SBI(endstop_hit_bits, Z_MIN_PROBE);
+    #endif
+
+  #else // !ENDSTOP_PORT_SAMPLING
+
   /**
    * Check and update endstops according to conditions
    */
@@ -404,6 +586,8 @@ void Endstops::update() {
     }
   }
 
-  old_endstop_bits = current_endstop_bits;
+  END_ENDSTOP_UPDATE();
+
+  #endif // !ENDSTOP_PORT_SAMPLING
 
 } // Endstops::update()
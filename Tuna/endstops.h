@@ -39,6 +39,14 @@ class Endstops final {
     static byte
       current_endstop_bits, old_endstop_bits;
 
+    #if ENDSTOP_DEBOUNCE > 2
+      static byte older_endstop_bits[ENDSTOP_DEBOUNCE - 2]; // the updates before old_endstop_bits, latest first
+    #endif
+
+    #if ENABLED(PARALLEL_HOMING)
+      static volatile bool stop_per_axis; // an endstop stops only its own axis instead of the whole block
+    #endif
+
     Endstops() {};
 
     /**
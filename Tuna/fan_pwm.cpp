@@ -0,0 +1,112 @@
+#include "fan_pwm.hpp"
+
+#if ENABLED(FAN_HARDWARE_PWM)
+
+namespace Tuna::fan_pwm
+{
+  volatile uint8 target = 0;
+
+  namespace
+  {
+    // Timer 3 counts up and back down through 8 bits at F_CPU / 64, as the Arduino core set it up.
+    constexpr const uint32 period_us = (510UL * 64UL) / (F_CPU / 1000000UL);
+
+#ifdef FAN_KICKSTART_TIME
+    constexpr const uint16 kick_periods = uint16((uint32(FAN_KICKSTART_TIME) * 1000UL + period_us - 1) / period_us);
+    uint16 kick = 0; // Periods of full power left
+#endif
+
+    uint8 duty = 0;
+
+    // For any speed but 0, FAN_MIN_PWM and up.
+    constexpr uint8 duty_for(arg_type<uint8> speed)
+    {
+#ifdef FAN_MIN_PWM
+      return speed ? uint8(FAN_MIN_PWM + (uint16(speed) * (255 - FAN_MIN_PWM)) / 255) : 0_u8;
+#else
+      return speed;
+#endif
+    }
+
+    // Duty 0 disconnects the output, so the fan is fully off rather than pulsed at BOTTOM.
+    inline void __forceinline __flatten write(arg_type<uint8> value)
+    {
+      duty = value;
+      if (value == 0)
+      {
+        CBI(TCCR3A, COM3A1);
+        WRITE(FAN_PIN, LOW);
+      }
+      else
+      {
+        OCR3A = value;
+        SBI(TCCR3A, COM3A1);
+      }
+    }
+  }
+
+  void init()
+  {
+    SET_OUTPUT(FAN_PIN);
+    write(0);
+  }
+}
+
+__signal(TIMER3_OVF)
+{
+  using namespace Tuna::fan_pwm;
+
+  const uint8 speed = target;
+  if (speed == 0)
+  {
+#ifdef FAN_KICKSTART_TIME
+    kick = 0;
+#endif
+    write(0);
+    TIMSK3 &= ~_BV(TOIE3);
+    return;
+  }
+
+#ifdef FAN_KICKSTART_TIME
+  // From a stop, full power first, then down the ramp to the speed
+  if (duty == 0)
+  {
+    kick = kick_periods;
+  }
+  if (kick)
+  {
+    --kick;
+    if (duty != 255)
+    {
+      write(255);
+    }
+    return;
+  }
+#endif
+
+  const uint8 wanted = duty_for(speed);
+#if FAN_HARDWARE_PWM_RAMP > 0
+  uint8 next;
+  if (duty < wanted)
+  {
+    next = uint8(min(uint16(wanted), uint16(duty + FAN_HARDWARE_PWM_RAMP)));
+  }
+  else
+  {
+    next = uint8(max(int16(wanted), int16(duty - FAN_HARDWARE_PWM_RAMP)));
+  }
+#else
+  const uint8 next = wanted;
+#endif
+
+  if (next != duty)
+  {
+    write(next);
+  }
+  if (next == wanted)
+  {
+    TIMSK3 &= ~_BV(TOIE3); // At speed, until the next change
+  }
+}
+
+#endif
@@ -0,0 +1,32 @@
+#pragma once
+
+#include <tuna.h>
+
+#if ENABLED(FAN_HARDWARE_PWM)
+
+// The part fan on timer 3's OC3A output (D5 on the i3 Plus), at the 490Hz of its phase correct PWM.
+// Kickstart, FAN_MIN_PWM and the ramp between speeds are run by timer 3's overflow interrupt, once
+// per PWM period while a change is under way, and it turns itself off once the fan is at speed. A
+// new speed only has to be written: the stepper ISR writes each block's as the block starts, and
+// check_axes_activity() writes fanSpeeds[] while nothing is queued.
+namespace Tuna::fan_pwm
+{
+  extern volatile uint8 target;
+
+  void init();
+
+  // From the main loop or the stepper ISR, and the overflow interrupt picks it up at the end of the
+  // period. TIMSK3 is out of reach of SBI, so it's changed with interrupts off.
+  inline void __forceinline __flatten set(arg_type<uint8> speed)
+  {
+    if (target == speed)
+    {
+      return;
+    }
+    critical_section _critsec;
+    target = speed;
+    TIMSK3 |= _BV(TOIE3);
+  }
+}
+
+#endif
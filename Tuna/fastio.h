@@ -310,4 +310,7 @@ typedef enum : uint8_t {
 // finally - the macro that tells us if a pin is an available hardware PWM
 #define USEABLE_HARDWARE_PWM(p) (PWM_PINS(p) && !PWM_CHK(p))
 
+// Groups of pins, written a port at a time
+#include "tunalib/io.hpp"
+
 #endif // _FASTIO_ARDUINO_H
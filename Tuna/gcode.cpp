@@ -58,6 +58,30 @@ int GCodeParser::codenum;
   char *GCodeParser::command_args; // start of parameters
 #endif
 
+#if ENABLED(GCODE_VALUE_CACHE)
+  uint8_t GCodeParser::value_ind,
+          GCodeParser::cached_count,
+          GCodeParser::cached_ind[GCODE_VALUE_CACHE_SIZE];
+  float GCodeParser::cached_value[GCODE_VALUE_CACHE_SIZE];
+
+  float GCodeParser::cached_float() {
+    for (uint8_t i = 0; i < cached_count; ++i)
+      if (cached_ind[i] == value_ind) return cached_value[i];
+
+    const float value = Tuna::parse::decimal(value_ptr);
+    // Once they're all taken, the rest are converted each time, as without the cache
+    if (cached_count < COUNT(cached_ind)) {
+      cached_ind[cached_count] = value_ind;
+      cached_value[cached_count++] = value;
+    }
+    return value;
+  }
+#endif
+
+#if ENABLED(PARSED_COMMAND_QUEUE)
+  bool GCodeParser::parsed;
+#endif
+
 // Create a global instance of the GCode parser singleton
 GCodeParser parser;
 
@@ -78,6 +102,12 @@ void __forceinline __flatten GCodeParser::reset() {
     ZERO(codebits);                     // No codes yet
     //ZERO(param);                      // No parameters (should be safe to comment out this line)
   #endif
+  #if ENABLED(GCODE_VALUE_CACHE)
+    cached_count = 0;                   // Nothing converted yet
+  #endif
+  #if ENABLED(PARSED_COMMAND_QUEUE)
+    parsed = false;                     // Values are text
+  #endif
 }
 
 // Populate all fields by parsing a single line of GCode
@@ -151,7 +181,7 @@ void __forceinline __flatten GCodeParser::parse(char *p) {
   #endif
 
   // Only use string_arg for these M codes
-  if (__unlikely(letter == 'M')) switch (codenum) { case 23: case 28: case 30: case 117: case 118: case 928: string_arg = p; return; default: break; }
+  if (__unlikely(letter == 'M')) switch (codenum) { case 23: case 28: case 30: case 117: case 118: case 276: case 928: string_arg = p; return; default: break; }
 
   #if ENABLED(DEBUG_GCODE_PARSER)
     const bool debug = codenum == 800;
@@ -229,9 +259,189 @@ void __forceinline __flatten GCodeParser::parse(char *p) {
   }
 }
 
+#if ENABLED(PARSED_COMMAND_QUEUE)
+
+  // The same scan as parse(), storing values instead of offsets into the line
+  bool GCodeParser::compile(const char *p, ParsedCommand &command) {
+    command.letter = '?';
+    command.count = 0;
+    ZERO(command.codebits);
+    #if ENABLED(ADVANCED_OK)
+      command.line = -1;
+    #endif
+
+    while (*p == ' ') ++p;
+
+    if (__unlikely(*p == 'N') && NUMERIC_SIGNED(p[1])) {
+      #if ENABLED(ADVANCED_OK)
+        command.line = Tuna::parse::integer(p + 1);
+      #endif
+      p += 2;
+      while (NUMERIC(*p)) ++p;
+      while (*p == ' ')   ++p;
+    }
+
+    const char letter = *p++;
+    switch (letter) { case 'G': case 'M': case 'T': break; default: return false; }
+
+    while (*p == ' ') p++;
+    if (__unlikely(!NUMERIC(*p))) return false;
+
+    int16_t codenum = 0;
+    do {
+      codenum *= 10, codenum += *p++ - '0';
+    } while (NUMERIC(*p));
+
+    command.letter = letter;
+    command.codenum = codenum;
+
+    #if USE_GCODE_SUBCODES
+      command.subcode = 0;
+      if (*p == '.') {
+        p++;
+        while (NUMERIC(*p))
+          command.subcode *= 10, command.subcode += *p++ - '0';
+      }
+    #endif
+
+    // These take the rest of the line as a string
+    if (__unlikely(letter == 'M') && takes_string(codenum)) return false;
+
+    while (*p == ' ') p++;
+
+    while (char code = *p++) {
+      if (code == '*') break;                   // Checksum
+      if (!WITHIN(code, 'A', 'Z')) return false; // parse() would make this the string_arg
+
+      const uint8_t ind = LETTER_OFF(code);
+      SBI(command.codebits[PARAM_IND(ind)], PARAM_BIT(ind));
+
+      while (*p == ' ') p++;
+      if (DECIMAL_SIGNED(*p)) {
+        if (__unlikely(command.count >= COUNT(command.values))) return false;
+        ParsedCommand::Value &value = command.values[command.count++];
+
+        bool is_float = false;
+        for (const char *v = p; DECIMAL_SIGNED(*v); ++v) if (*v == '.') is_float = true;
+
+        if (is_float) {
+          value.code = code | ParsedCommand::Value::is_float;
+          value.f = Tuna::parse::decimal(p);
+        }
+        else {
+          value.code = code;
+          value.l = Tuna::parse::integer(p);
+        }
+
+        while (DECIMAL_SIGNED(*p)) p++;         // The whole value, sign and point included
+      }
+
+      while (*p == ' ') p++;
+    }
+
+    return true;
+  }
+
+  void __forceinline __flatten GCodeParser::parse(const ParsedCommand &command) {
+    reset();
+    parsed = true;
+
+    command_letter = command.letter;
+    codenum = command.codenum;
+    #if USE_GCODE_SUBCODES
+      subcode = command.subcode;
+    #endif
+    COPY(codebits, command.codebits);
+
+    // seen() finds a value at command_ptr + param[], as it does in a line. 0 is no value.
+    command_ptr = (char *)&command;
+    ZERO(param);
+    for (uint8_t i = 0; i < command.count; ++i) {
+      const ParsedCommand::Value &value = command.values[i];
+      param[LETTER_OFF(value.code & ~ParsedCommand::Value::is_float)] = (const char *)&value - (const char *)&command;
+    }
+  }
+
+#endif // PARSED_COMMAND_QUEUE
+
+#if ENABLED(BINARY_STREAMING) || ENABLED(SD_BINARY_FILES)
+
+  bool GCodeParser::decode(const uint8_t *data, const uint8_t length, ParsedCommand &command) {
+    if (length < 3) return false;
+
+    command.letter = data[0];
+    switch (command.letter) { case 'G': case 'M': case 'T': break; default: return false; }
+    command.codenum = int16_t(data[1] | (data[2] << 8));
+    if (command.letter == 'M' && takes_string(command.codenum)) return false;
+
+    #if USE_GCODE_SUBCODES
+      command.subcode = 0;
+    #endif
+    #if ENABLED(ADVANCED_OK)
+      command.line = -1;
+    #endif
+    command.count = 0;
+    ZERO(command.codebits);
+
+    for (uint8_t i = 3; i < length;) {
+      const char code = data[i++];
+
+      if (WITHIN(code, 'a', 'z')) {             // No value
+        const uint8_t ind = code - 'a';
+        SBI(command.codebits[PARAM_IND(ind)], PARAM_BIT(ind));
+        continue;
+      }
+
+      if (command.count >= COUNT(command.values)) return false;
+      ParsedCommand::Value &value = command.values[command.count++];
+
+      char letter = code & ~ParsedCommand::Value::is_float;
+      if (WITHIN(letter, 'a', 'z')) {           // Fixed point: an int24 of thousandths
+        if (i + 3 > length) return false;
+        int32 l = int32(data[i] | (uint16_t(data[i + 1]) << 8) | (uint32(data[i + 2]) << 16));
+        if (l & 0x800000L) l -= 0x1000000L;     // Sign extend
+        i += 3;
+        letter -= 'a' - 'A';
+        value.code = letter | ParsedCommand::Value::is_float;
+        value.f = float(l) / 1000.0f;           // As the text "l / 1000" would parse
+      }
+      else {
+        if (!WITHIN(letter, 'A', 'Z') || i + 4 > length) return false;
+        value.code = code;
+        memcpy(&value.l, &data[i], 4);          // Little-endian, as the AVR
+        i += 4;
+      }
+
+      const uint8_t ind = LETTER_OFF(letter);
+      SBI(command.codebits[PARAM_IND(ind)], PARAM_BIT(ind));
+    }
+
+    return true;
+  }
+
+#endif // BINARY_STREAMING || SD_BINARY_FILES
+
+void GCodeParser::print_command() {
+  #if ENABLED(PARSED_COMMAND_QUEUE)
+    if (parsed) {
+      SERIAL_CHAR(command_letter);
+      SERIAL_ECHO(codenum);
+      #if USE_GCODE_SUBCODES
+        if (subcode) {
+          SERIAL_CHAR('.');
+          SERIAL_ECHO(subcode);
+        }
+      #endif
+      return;
+    }
+  #endif
+  SERIAL_ECHO(command_ptr);
+}
+
 void GCodeParser::unknown_command_error() {
   SERIAL_ECHO_START();
-  SERIAL_ECHOPAIR(MSG_UNKNOWN_COMMAND, command_ptr);
+  SERIAL_ECHOPGM(MSG_UNKNOWN_COMMAND);
+  print_command();
   SERIAL_CHAR('"');
   SERIAL_EOL();
 }
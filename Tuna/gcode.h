@@ -48,6 +48,48 @@
   extern bool volumetric_enabled;
 #endif
 
+#if ENABLED(PARSED_COMMAND_QUEUE)
+
+  /**
+   * A command parsed when it's queued, so it needn't be scanned again when it runs.
+   * Parameter values are kept as they were written: an int32, or a float if they had a '.'.
+   */
+  struct ParsedCommand {
+    struct Value {
+      static constexpr char is_float = char(0x80);
+
+      char code;                        // A-Z, | is_float
+      union {
+        int32 l;
+        float f;
+      };
+
+      Value() = default;
+      constexpr Value(const char c, const int32 v) : code(c), l(v) {}
+      constexpr Value(const char c, const float v) : code(char(c | is_float)), f(v) {}
+
+      inline float __forceinline __flatten as_float() const { return (code & is_float) ? f : float(l); }
+      inline int32 __forceinline __flatten as_long() const { return (code & is_float) ? int32(f) : l; }
+    };
+
+    char letter;                        // G, M, or T. 0 if the line is kept as text
+    uint8_t count;                      // Values used
+    int16_t codenum;
+    #if USE_GCODE_SUBCODES
+      uint8_t subcode;
+    #endif
+    #if ENABLED(ADVANCED_OK)
+      int32 line;                       // The N the line started with, or -1
+    #endif
+    byte codebits[4];                   // As GCodeParser::codebits
+    Value values[PARSED_COMMAND_VALUES];
+  };
+
+  // The longest binary payload: the code, every value as a float, and every other letter without one
+  #define PARSED_PAYLOAD_SIZE (3 + 5 * PARSED_COMMAND_VALUES + 26)
+
+#endif
+
 /**
  * GCode parser
  *
@@ -72,6 +114,24 @@ private:
     static char *command_args;      // Args start here, for slow scan
   #endif
 
+  #if ENABLED(GCODE_VALUE_CACHE)
+    static uint8_t value_ind;                               // The letter seen() last found, as LETTER_OFF
+    static uint8_t cached_count;                            // Values converted so far in this command
+    static uint8_t cached_ind[GCODE_VALUE_CACHE_SIZE];      // Their letters, as LETTER_OFF
+    static float cached_value[GCODE_VALUE_CACHE_SIZE];
+
+    // The value at value_ptr, converted once per command
+    static float cached_float();
+  #endif
+
+  #if ENABLED(PARSED_COMMAND_QUEUE)
+    static bool parsed;             // Loaded from a ParsedCommand. value_ptr points at a Value
+
+    static inline const ParsedCommand::Value * __forceinline __flatten parsed_value() {
+      return reinterpret_cast<const ParsedCommand::Value *>(value_ptr);
+    }
+  #endif
+
 public:
 
   // Global states for GCode-level units features
@@ -136,7 +196,12 @@ public:
       const uint8_t ind = LETTER_OFF(c);
       if (ind >= COUNT(param)) return false; // Only A-Z
       const bool b = TEST(codebits[PARAM_IND(ind)], PARAM_BIT(ind));
-      if (b) value_ptr = param[ind] ? command_ptr + param[ind] : (char*)nullptr;
+      if (b) {
+        value_ptr = param[ind] ? command_ptr + param[ind] : (char*)nullptr;
+        #if ENABLED(GCODE_VALUE_CACHE)
+          value_ind = ind;
+        #endif
+      }
       return b;
     }
 
@@ -171,38 +236,64 @@ public:
   // This uses 54 bytes of SRAM to speed up seen/value
   static void __forceinline __flatten parse(char * p);
 
+  #if ENABLED(PARSED_COMMAND_QUEUE)
+    // Parse a line into a record for the command queue, without touching the parser state.
+    // Return false if the line must be kept as text: string arguments, parameters other than
+    // A-Z, too many values, or no G, M, or T code. 'letter' and 'codenum' are set if there was a code.
+    static bool compile(const char * p, ParsedCommand &command);
+
+    // Take the command from a record made by compile(). command_ptr then points at the record.
+    static void __forceinline __flatten parse(const ParsedCommand &command);
+
+    // The M codes that take the rest of the line as a string, so can't be a record
+    static constexpr bool __forceinline __flatten takes_string(const int16_t codenum) {
+      switch (codenum) { case 23: case 28: case 30: case 32: case 117: case 118: case 276: case 928: return true; default: return false; }
+    }
+  #endif
+
+  #if ENABLED(BINARY_STREAMING) || ENABLED(SD_BINARY_FILES)
+    // Fill a record from a binary payload, described at get_binary_commands().
+    // Return false if the payload is malformed or the command can't be a record.
+    static bool decode(const uint8_t *data, const uint8_t length, ParsedCommand &command);
+  #endif
+
+  // Echo the command, or just its code if it was loaded from a record
+  static void print_command();
+
   // The code value pointer was set
   static bool __forceinline __flatten has_value() { return value_ptr != nullptr; }
 
   // Seen a parameter with a value
   inline static bool __forceinline __flatten seenval(const char c) { return seen(c) && has_value(); }
 
-  // Float removes 'E' to prevent scientific notation interpretation
+  // Float, with no scientific notation, so a following 'E' parameter isn't taken as an exponent
   inline static float __forceinline __flatten value_float() {
-    if (value_ptr) {
-      char *e = value_ptr;
-      for (;;) {
-        const char c = *e;
-        if (c == '\0' || c == ' ') break;
-        if (c == 'E' || c == 'e') {
-          *e = '\0';
-          const float ret = strtod(value_ptr, nullptr);
-          *e = c;
-          return ret;
-        }
-        ++e;
-      }
-      return strtod(value_ptr, nullptr);
-    }
-    return 0.0;
+    #if ENABLED(PARSED_COMMAND_QUEUE)
+      if (parsed) return value_ptr ? parsed_value()->as_float() : 0.0f;
+    #endif
+    #if ENABLED(GCODE_VALUE_CACHE)
+      return value_ptr ? cached_float() : 0.0f;
+    #else
+      return value_ptr ? Tuna::parse::decimal(value_ptr) : 0.0f;
+    #endif
   }
 
   // Code value as a long or ulong
-  inline static int32 value_long() { return value_ptr ? strtol(value_ptr, nullptr, 10) : 0L; }
-  inline static uint32 value_ulong() { return value_ptr ? strtoul(value_ptr, nullptr, 10) : 0UL; }
+  inline static int32 value_long() {
+    #if ENABLED(PARSED_COMMAND_QUEUE)
+      if (parsed) return value_ptr ? parsed_value()->as_long() : 0L;
+    #endif
+    return value_ptr ? Tuna::parse::integer(value_ptr) : 0L;
+  }
+  inline static uint32 value_ulong() {
+    #if ENABLED(PARSED_COMMAND_QUEUE)
+      if (parsed) return value_ptr ? uint32(parsed_value()->as_long()) : 0UL;
+    #endif
+    return value_ptr ? Tuna::parse::unsigned_integer(value_ptr) : 0UL;
+  }
 
-  inline static int24 value_i24() { return value_ptr ? int24(strtol(value_ptr, nullptr, 10)) : 0_i24; }
-  inline static uint24 value_u24() { return value_ptr ? uint24(strtoul(value_ptr, nullptr, 10)) : 0_u24; }
+  inline static int24 value_i24() { return int24(value_long()); }
+  inline static uint24 value_u24() { return uint24(value_ulong()); }
 
   // Code value for use as time
   static millis_t __forceinline value_millis() { return value_ulong(); }
@@ -308,7 +399,7 @@ public:
 
   static float __forceinline value_feedrate() { return value_linear_units(); }
 
-  void unknown_command_error();
+  void __cold __no_inline unknown_command_error();
 
   // Provide simple value accessors with default option
   static float    __forceinline __flatten floatval(const char c, const float dval=0.0)   { return seenval(c) ? value_float()        : dval; }
@@ -327,4 +418,104 @@ public:
 
 extern GCodeParser parser;
 
+#if ENABLED(COMPILED_MACROS)
+
+  /**
+   * G-code compiled into records as the firmware is built, for the firmware's own command
+   * sequences: GCODE_MACRO("M502\nM500") holds one ParsedCommand per line, ready to be copied
+   * into the command queue. A line compile() would keep as text doesn't build, nor does a line
+   * number or a checksum. ';' starts a comment.
+   */
+  namespace macro_compiler {
+    // Not constexpr, so reaching it stops the build
+    void line_kept_as_text();
+
+    constexpr bool is_digit(const char c) { return c >= '0' && c <= '9'; }
+
+    constexpr const char *skip_blanks(const char *p) {
+      while (*p == ' ') ++p;
+      return p;
+    }
+
+    constexpr bool ends_line(const char c) { return !c || c == '\n' || c == ';'; }
+
+    // Past the rest of the line, comment and all
+    constexpr const char *skip_line(const char *p) {
+      while (*p && *p != '\n') ++p;
+      return p;
+    }
+
+    // The first line at or after 'p' with a command on it
+    constexpr const char *next_command(const char *p) {
+      for (p = skip_blanks(p); *p; p = skip_blanks(p)) {
+        if (!ends_line(*p)) break;
+        p = skip_line(p);
+        if (*p) ++p;
+      }
+      return p;
+    }
+
+    constexpr uint8_t count_lines(const char *p) {
+      uint8_t lines = 0;
+      for (p = next_command(p); *p; p = next_command(skip_line(p))) ++lines;
+      return lines;
+    }
+
+    constexpr ParsedCommand compile_line(const char *p) {
+      ParsedCommand command{};
+      #if ENABLED(ADVANCED_OK)
+        command.line = -1;
+      #endif
+      command.letter = *p++;
+      if (!(command.letter == 'G' || command.letter == 'M' || command.letter == 'T') || !is_digit(*p)) line_kept_as_text();
+      while (is_digit(*p)) command.codenum = int16_t(command.codenum * 10 + (*p++ - '0'));
+      #if USE_GCODE_SUBCODES
+        if (*p == '.') for (++p; is_digit(*p); ++p) command.subcode = uint8_t(command.subcode * 10 + (*p - '0'));
+      #endif
+      if (command.letter == 'M' && GCodeParser::takes_string(command.codenum)) line_kept_as_text();
+
+      for (p = skip_blanks(p); !ends_line(*p); p = skip_blanks(p)) {
+        const char code = *p++;
+        if (code < 'A' || code > 'Z') line_kept_as_text();
+        const uint8_t ind = uint8_t(code - 'A');
+        command.codebits[ind >> 3] |= uint8_t(1 << (ind & 0x7));
+
+        p = skip_blanks(p);
+        if (!(is_digit(*p) || *p == '-' || *p == '.')) continue;
+        if (command.count >= PARSED_COMMAND_VALUES) line_kept_as_text();
+        const bool negative = (*p == '-');
+        if (negative) ++p;
+        int32 whole = 0;
+        while (is_digit(*p)) whole = whole * 10 + (*p++ - '0');
+        if (*p == '.') {
+          float value = float(whole), scale = 0.1f;
+          for (++p; is_digit(*p); ++p, scale *= 0.1f) value += float(*p - '0') * scale;
+          command.values[command.count++] = ParsedCommand::Value(code, negative ? -value : value);
+        }
+        else
+          command.values[command.count++] = ParsedCommand::Value(code, negative ? -whole : whole);
+      }
+      return command;
+    }
+  }
+
+  template <uint8_t N>
+  struct gcode_macro {
+    static_assert(N != 0, "a macro needs a command");
+    ParsedCommand steps[N];
+  };
+
+  template <uint8_t N>
+  constexpr gcode_macro<N> compile_macro(const char *text) {
+    gcode_macro<N> macro{};
+    const char *p = macro_compiler::next_command(text);
+    for (uint8_t i = 0; i < N; ++i, p = macro_compiler::next_command(macro_compiler::skip_line(p)))
+      macro.steps[i] = macro_compiler::compile_line(p);
+    return macro;
+  }
+
+  #define GCODE_MACRO(TEXT) compile_macro<macro_compiler::count_lines(TEXT)>(TEXT)
+
+#endif // COMPILED_MACROS
+
 #endif // GCODE_H
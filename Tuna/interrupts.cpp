@@ -1,3 +1,54 @@
 #include "interrupts.hpp"
 
 using namespace Tuna;
+
+#if ENABLED(ISR_PROFILING)
+
+namespace Tuna::interrupts
+{
+  isr_timing stepper_timing { ISR_STEPPER_BUDGET / 8 };
+  isr_timing advance_timing { ISR_ADVANCE_BUDGET / 8 };
+  isr_timing temperature_timing { ISR_TEMPERATURE_BUDGET / 64 };
+
+  namespace
+  {
+    void report(const char * __restrict name_P, const isr_timing & __restrict timing, uint8 cycles_per_tick)
+    {
+      isr_timing copy;
+      {
+        Tuna::critical_section_not_isr crit_sec;
+        copy = timing;
+      }
+
+      SERIAL_ECHO_START();
+      serialprintPGM(name_P);
+      SERIAL_ECHOPAIR(" calls:", copy.calls);
+      if (copy.calls)
+      {
+        SERIAL_ECHOPAIR(" min:", uint32(copy.min_ticks) * cycles_per_tick);
+        SERIAL_ECHOPAIR(" max:", uint32(copy.max_ticks) * cycles_per_tick);
+        SERIAL_ECHOPAIR(" avg:", uint32(copy.total_ticks / copy.calls) * cycles_per_tick);
+      }
+      SERIAL_ECHOPAIR(" overruns:", copy.overruns);
+      SERIAL_ECHOLNPAIR(" over budget:", copy.over_budget);
+    }
+  }
+
+  void reset_isr_timing()
+  {
+    Tuna::critical_section_not_isr crit_sec;
+    stepper_timing = { stepper_timing.budget_ticks };
+    advance_timing = { advance_timing.budget_ticks };
+    temperature_timing = { temperature_timing.budget_ticks };
+  }
+
+  void report_isr_timing()
+  {
+    SERIAL_ECHOLNPGM("ISR cycles:");
+    report(PSTR("Stepper"), stepper_timing, 8);
+    report(PSTR("Advance"), advance_timing, 8);
+    report(PSTR("Temperature"), temperature_timing, 64);
+  }
+}
+
+#endif
@@ -4,4 +4,145 @@
 
 namespace Tuna::interrupts
 {
+#if ENABLED(ISR_PROFILING)
+  // Duration statistics of one interrupt handler, in ticks of the timer used to measure it.
+  // Only ever updated from within the handler itself, so no locking is needed there.
+  struct isr_timing final
+  {
+    uint16 budget_ticks = type_trait<uint16>::max;  // Calls longer than this count as over budget
+    uint16 min_ticks = type_trait<uint16>::max;
+    uint16 max_ticks = 0;
+    uint32 total_ticks = 0;   // Wraps after about an hour of a busy stepper ISR; reset before measuring
+    uint32 calls = 0;
+    uint16 overruns = 0;      // Calls that ran past their next deadline
+    uint16 over_budget = 0;
+
+    inline void __forceinline __flatten add(arg_type<uint16> ticks, bool overrun)
+    {
+      if (ticks < min_ticks) min_ticks = ticks;
+      if (ticks > max_ticks) max_ticks = ticks;
+      total_ticks += ticks;
+      ++calls;
+      if (__unlikely(overrun) && overruns != type_trait<uint16>::max) ++overruns;
+      if (__unlikely(ticks > budget_ticks) && over_budget != type_trait<uint16>::max) ++over_budget;
+    }
+  };
+
+  // Stepper::isr and Stepper::advance_isr are timed with TCNT1 (8 cycles per tick),
+  // Temperature::isr with TCNT0 (64 cycles per tick), as Timer 1 restarts whenever the stepper ISR fires.
+  // Their budgets are ISR_*_BUDGET in the same ticks.
+  extern isr_timing stepper_timing, advance_timing, temperature_timing;
+
+  void reset_isr_timing();
+  void report_isr_timing();
+#endif
+
+#if ENABLED(NESTED_INTERRUPTS)
+  // AVR has no interrupt priorities of its own: a handler runs with interrupts off, and when
+  // several are pending the lowest vector goes first. A handler declared nested_isr<level> clears
+  // the enable bits of every source at or below 'level', its own included, and turns interrupts
+  // back on, so everything above it can preempt it. The bits are put back, with interrupts off
+  // again, as it returns.
+  //
+  // The stepper is the top and never nests: its steps are timed from when it starts. The serial
+  // handlers, the EEPROM writer and the watchdog are not in the table and don't nest either. They
+  // get in while a lower handler runs, but are a few dozen cycles, the EEPROM's EEMPE to EEPE write
+  // must be 4 cycles, and UDRE has to return with its enable bit as it left it.
+  enum class priority : uint8
+  {
+    temperature,  // Temperature::isr, and the ADC with ADC_FREE_RUNNING
+    stepper       // Timer 1: Stepper::isr and Stepper::advance_isr
+  };
+
+  namespace _internal
+  {
+    struct source final
+    {
+      uint16 address; // The register with its enable bits, as a data address
+      uint8 mask;     // The enable bits
+      uint8 flags;    // Flags in the same register that writing a 1 clears, so they're written as 0
+      priority level;
+    };
+
+#pragma push_macro("_MMIO_BYTE")
+#undef _MMIO_BYTE
+#define _MMIO_BYTE(mem_addr) (mem_addr)
+
+    constexpr const source sources[] = {
+#if ENABLED(HOTEND_HARDWARE_PWM)
+      { TIMSK0, _BV(OCIE0A), 0, priority::temperature },
+#else
+      { TIMSK0, _BV(OCIE0B), 0, priority::temperature },
+#endif
+#if ENABLED(ADC_FREE_RUNNING)
+      { ADCSRA, _BV(ADIE), _BV(ADIF), priority::temperature },
+#endif
+      { TIMSK1, _BV(OCIE1A), 0, priority::stepper }
+    };
+
+#pragma pop_macro("_MMIO_BYTE")
+
+    constexpr const uint8 source_count = uint8(sizeof(sources) / sizeof(sources[0]));
+  }
+
+  // Declared first in a handler at 'level'. Only sources at or below it are touched, each a load,
+  // an AND and a store on the way in and out.
+  template <priority level>
+  class nested_isr final
+  {
+    static_assert(level < priority::stepper, "The stepper ISR runs with interrupts off");
+
+    uint8 m_Masked[_internal::source_count];
+
+    template <uint8 i = 0>
+    inline __forceinline __flatten void mask()
+    {
+      if constexpr (i < _internal::source_count)
+      {
+        constexpr const _internal::source source = _internal::sources[i];
+        if constexpr (source.level <= level)
+        {
+          volatile uint8 & __restrict reg = io::_internal::reg<source.address>();
+          const uint8 value = reg;
+          m_Masked[i] = value & source.mask;
+          reg = value & uint8(~(source.mask | source.flags));
+        }
+        mask<i + 1>();
+      }
+    }
+
+    template <uint8 i = 0>
+    inline __forceinline __flatten void restore()
+    {
+      if constexpr (i < _internal::source_count)
+      {
+        constexpr const _internal::source source = _internal::sources[i];
+        if constexpr (source.level <= level)
+        {
+          volatile uint8 & __restrict reg = io::_internal::reg<source.address>();
+          reg = (reg & uint8(~source.flags)) | m_Masked[i];
+        }
+        restore<i + 1>();
+      }
+    }
+
+  public:
+    nested_isr(const nested_isr &) = delete;
+    nested_isr(nested_isr &&) = delete;
+    nested_isr & operator = (const nested_isr &) = delete;
+    nested_isr & operator = (nested_isr &&) = delete;
+
+    inline __forceinline __flatten nested_isr()
+    {
+      mask();
+      intrinsic::sei();
+    }
+
+    inline __forceinline __flatten ~nested_isr()
+    {
+      intrinsic::cli();
+      restore();
+    }
+  };
+#endif
 }
@@ -188,6 +188,10 @@
 #define MSG_SD_ERR_WRITE_TO_FILE            "error writing to file"
 #define MSG_SD_ERR_READ                     "SD read error"
 #define MSG_SD_CANT_ENTER_SUBDIR            "Cannot enter subdir: "
+#define MSG_CHECKPOINT_FOUND                "Power-loss checkpoint, M1000 resumes: "
+#define MSG_CHECKPOINT_NONE                 "No power-loss checkpoint"
+#define MSG_SD_BENCHMARK_NO_FILE            "No file selected for the file read benchmark"
+#define MSG_SD_BENCHMARK_BUSY               "SD benchmark needs the card idle"
 
 #define MSG_STEPPER_TOO_HIGH                "Steprate too high: "
 #define MSG_ENDSTOPS_HIT                    "endstops hit: "
@@ -200,6 +204,10 @@
 #define MSG_SERIAL_ERROR_MENU_STRUCTURE     "Error in menu structure"
 
 #define MSG_ERR_EEPROM_WRITE                "Error writing to EEPROM!"
+#define MSG_ERR_SETTINGS_PROFILE            "No such settings profile"
+#define MSG_ERR_SETTINGS_PROFILE_FULL       "Settings don't fit in SETTINGS_PROFILE_SIZE"
+#define MSG_SETTINGS_PROFILE                "Settings profile "
+#define MSG_SETTINGS_REPLACED               "Steps, feedrate or acceleration limits out of range, defaults used"
 
 #define MSG_STOP_BLTOUCH                    "STOP called because of BLTouch error - restart with M999"
 #define MSG_STOP_UNHOMED                    "STOP called because of unhomed error - restart with M999"
@@ -191,6 +191,7 @@
 #define FABS(x)     fabs(x)
 #define POW(x, y)   pow(x, y)
 #define SQRT(x)     sqrt(x)
+#define RSQRT(x)    RECIPROCAL(SQRT(x))
 #define CEIL(x)     ceil(x)
 #define FLOOR(x)    floor(x)
 #define LROUND(x)   lround(x)
@@ -0,0 +1,106 @@
+#include "mesh.hpp"
+
+using namespace Tuna;
+
+#if ENABLED(MESH_COMPENSATION)
+
+namespace Tuna::mesh
+{
+  int16 z_um[points_y][points_x];
+  bool active = false;
+
+  namespace
+  {
+    constexpr const float inverse_spacing_x = 1.0f / spacing_x;
+    constexpr const float inverse_spacing_y = 1.0f / spacing_y;
+
+    // Fractions across a cell are in 1/32768ths.
+    constexpr const uint8 fraction_bits = 15;
+    constexpr const int32 fraction_one = 1_i32 << fraction_bits;
+
+    // The bilinear surface over one cell, z = a + b*fx + c*fy + d*fx*fy in microns. It is
+    // worked out again only when a position is over another cell than the last one, which,
+    // with moves split at the cell edges, is once per piece of a move at most.
+    struct cell final
+    {
+      uint8 x = 0xFF;
+      uint8 y = 0xFF;
+      int32 a, b, c, d;
+    };
+    cell cached;
+
+    inline uint8 cell_of(arg_type<float> cells, arg_type<uint8> points)
+    {
+      if (cells <= 0.0f) return 0;
+      if (cells >= points - 2) return points - 2;
+      return uint8(cells);
+    }
+
+    inline int32 fraction_of(arg_type<float> cells, arg_type<uint8> cell)
+    {
+      const float fraction = cells - cell;
+      if (fraction <= 0.0f) return 0;
+      if (fraction >= 1.0f) return fraction_one;
+      return int32(fraction * fraction_one);
+    }
+  }
+
+  uint8 cell_x(arg_type<float> x)
+  {
+    return cell_of((x - MESH_MIN_X) * inverse_spacing_x, points_x);
+  }
+
+  uint8 cell_y(arg_type<float> y)
+  {
+    return cell_of((y - MESH_MIN_Y) * inverse_spacing_y, points_y);
+  }
+
+  float z_offset(arg_type<float> x, arg_type<float> y)
+  {
+    const float cells_x = (x - MESH_MIN_X) * inverse_spacing_x;
+    const float cells_y = (y - MESH_MIN_Y) * inverse_spacing_y;
+    const uint8 cx = cell_of(cells_x, points_x);
+    const uint8 cy = cell_of(cells_y, points_y);
+
+    if (__unlikely(cx != cached.x || cy != cached.y))
+    {
+      const int32 z00 = z_um[cy][cx], z10 = z_um[cy][cx + 1];
+      const int32 z01 = z_um[cy + 1][cx], z11 = z_um[cy + 1][cx + 1];
+      cached.a = z00;
+      cached.b = z10 - z00;
+      cached.c = z01 - z00;
+      cached.d = z11 - z10 - z01 + z00;
+      cached.x = cx;
+      cached.y = cy;
+    }
+
+    const int32 fx = fraction_of(cells_x, cx);
+    const int32 fy = fraction_of(cells_y, cy);
+
+    // b + d*fy is the slope along X at this row, (1 - fy)(z10 - z00) + fy(z11 - z01), so like c it
+    // is within 2 * limit_um, and neither product can leave an int32.
+    const int32 slope_x = cached.b + ((cached.d * fy) >> fraction_bits);
+    const int32 z = cached.a + ((slope_x * fx + cached.c * fy) >> fraction_bits);
+    return z * 0.001f;
+  }
+
+  void changed()
+  {
+    cached.x = 0xFF;
+  }
+
+  void reset()
+  {
+    active = false;
+    for (auto &row : z_um)
+    {
+      for (int16 &z : row)
+      {
+        z = 0;
+      }
+    }
+    changed();
+  }
+}
+
+#endif
@@ -0,0 +1,47 @@
+#pragma once
+
+#include <tuna.h>
+
+namespace Tuna::mesh
+{
+#if ENABLED(MESH_COMPENSATION)
+  // The bed's height at a MESH_GRID_X by MESH_GRID_Y grid of points, spread evenly from MESH_MIN_X
+  // to MESH_MAX_X and MESH_MIN_Y to MESH_MAX_Y, in raw (not logical) coordinates.
+  constexpr const uint8 points_x = MESH_GRID_X;
+  constexpr const uint8 points_y = MESH_GRID_Y;
+  constexpr const float spacing_x = float(MESH_MAX_X - MESH_MIN_X) / (points_x - 1);
+  constexpr const float spacing_y = float(MESH_MAX_Y - MESH_MIN_Y) / (points_y - 1);
+
+  // Heights are in microns, [row][column], and no further than this from 0. Call changed() after
+  // setting any of them.
+  constexpr const int16 limit_um = 10000;
+  extern int16 z_um[points_y][points_x];
+
+  // Whether the planner is shifting Z by the mesh. Only changed through set_mesh_active().
+  extern bool active;
+
+  constexpr inline float point_x(arg_type<uint8> column)
+  {
+    return MESH_MIN_X + column * spacing_x;
+  }
+
+  constexpr inline float point_y(arg_type<uint8> row)
+  {
+    return MESH_MIN_Y + row * spacing_y;
+  }
+
+  // The cell a raw position is over, from 0 to points - 2. Positions past the edge of the grid are
+  // over the cell at that edge.
+  extern uint8 cell_x(arg_type<float> x);
+  extern uint8 cell_y(arg_type<float> y);
+
+  // The height of the bed at a raw position, in mm. Past the edges of the grid, that of the
+  // nearest edge.
+  extern float z_offset(arg_type<float> x, arg_type<float> y);
+
+  extern void changed();
+
+  // A flat mesh, turned off.
+  extern void reset();
+#endif
+}
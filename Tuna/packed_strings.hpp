@@ -0,0 +1,163 @@
+#pragma once
+
+#include "string_dictionary.h"
+
+// Serial messages in flash with their common words as one byte each. "text"_packed packs a literal
+// as it's compiled: each word of PACKED_STRING_WORDS, longest first, becomes 0x80 | its index, and
+// the rest stays ASCII. Each distinct text is one template instance, so it's stored once however
+// many files print it. serialprint_packed() puts the words back as it sends them.
+namespace Tuna::packed
+{
+  namespace _internal
+  {
+    constexpr const char * const words[] = { PACKED_STRING_WORDS };
+    constexpr const uint8 word_count = uint8(sizeof(words) / sizeof(words[0]));
+    static_assert(sizeof(words) / sizeof(words[0]) <= 0x80, "PACKED_STRING_WORDS has room for 128 words");
+
+    constexpr usize length_of(const char *str)
+    {
+      usize length = 0;
+      while (str[length])
+      {
+        ++length;
+      }
+      return length;
+    }
+
+    // The longest word that 'text' has at 'at', or word_count for none.
+    constexpr uint8 word_at(const char *text, arg_type<usize> length, arg_type<usize> at)
+    {
+      uint8 best = word_count;
+      usize best_length = 1;
+      for (uint8 w = 0; w < word_count; ++w)
+      {
+        const usize n = length_of(words[w]);
+        if (n <= best_length || at + n > length)
+        {
+          continue;
+        }
+        usize i = 0;
+        while (i < n && text[at + i] == words[w][i])
+        {
+          ++i;
+        }
+        if (i == n)
+        {
+          best = w;
+          best_length = n;
+        }
+      }
+      return best;
+    }
+
+    // The packed bytes of 'text', with its '\0'.
+    constexpr usize packed_length(const char *text, arg_type<usize> length)
+    {
+      usize size = 1;
+      for (usize at = 0; at < length; ++size)
+      {
+        const uint8 w = word_at(text, length, at);
+        at += (w < word_count) ? length_of(words[w]) : 1;
+      }
+      return size;
+    }
+
+    template <usize N>
+    struct bytes final
+    {
+      uint8 data[N];
+    };
+
+    template <usize N>
+    constexpr bytes<N> pack(const char *text, arg_type<usize> length)
+    {
+      bytes<N> out {};
+      usize size = 0;
+      for (usize at = 0; at < length;)
+      {
+        const uint8 w = word_at(text, length, at);
+        if (w < word_count)
+        {
+          out.data[size++] = uint8(0x80 | w);
+          at += length_of(words[w]);
+        }
+        else
+        {
+          out.data[size++] = uint8(text[at++]);
+        }
+      }
+      out.data[size] = 0;
+      return out;
+    }
+
+    template <char... Chars>
+    struct text final : trait::ce_only
+    {
+      static constexpr const char chars[] = { Chars..., '\0' };
+      static constexpr const usize length = sizeof...(Chars);
+    };
+
+    template <char... Chars>
+    struct store final : trait::ce_only
+    {
+      static_assert(((uint8(Chars) < 0x80) && ...), "Packed strings are ASCII; bytes from 0x80 are words");
+      using source = text<Chars...>;
+      static constexpr const bytes<packed_length(source::chars, source::length)> data __flashmem =
+        pack<packed_length(source::chars, source::length)>(source::chars, source::length);
+    };
+
+    // All the words back to back, each ending in '\0', and where each starts, for the output.
+    constexpr usize words_size()
+    {
+      usize size = 0;
+      for (const char *word : words)
+      {
+        size += length_of(word) + 1;
+      }
+      return size;
+    }
+
+    struct dictionary final
+    {
+      uint16 offset[word_count];
+      char text[words_size()];
+    };
+
+    constexpr dictionary make_dictionary()
+    {
+      dictionary out {};
+      usize size = 0;
+      for (uint8 w = 0; w < word_count; ++w)
+      {
+        out.offset[w] = uint16(size);
+        for (const char *c = words[w]; *c; ++c)
+        {
+          out.text[size++] = *c;
+        }
+        out.text[size++] = '\0';
+      }
+      return out;
+    }
+  }
+
+  // A packed message in flash.
+  class packed_string final
+  {
+    const uint8 *m_Data;
+
+  public:
+    constexpr __forceinline __flatten packed_string(const uint8 *data) : m_Data(data) {}
+
+    constexpr __forceinline __flatten const uint8 *data() const
+    {
+      return m_Data;
+    }
+  };
+
+  template <typename T, T... Chars>
+  constexpr packed_string operator "" _packed()
+  {
+    static_assert(is_same<T, char>, "_packed must be used with 'char'");
+    return { _internal::store<Chars...>::data.data };
+  }
+}
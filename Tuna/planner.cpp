@@ -64,8 +64,12 @@
 #include "bi3_plus_lcd.h"
 #include "stepper.h"
 #include "thermal/thermal.hpp"
+#include "thermal/managers/fan.hpp"
 #include "language.h"
 #include "gcode.h"
+#include "profiling.hpp"
+#include "mesh.hpp"
+#include "fan_pwm.hpp"
 
 #if ENABLED(MESH_BED_LEVELING)
   #include "mesh_bed_leveling.h"
@@ -78,14 +82,42 @@ Planner planner;
 /**
  * A ring buffer of moves described in steps
  */
-block_t Planner::block_buffer[BLOCK_BUFFER_SIZE];
-volatile uint8_t Planner::block_buffer_head = 0,           // Index of the next block to be pushed
-                 Planner::block_buffer_tail = 0;
+#if ENABLED(SHARED_QUEUE_POOL)
+  block_t *Planner::block_buffer = nullptr;
+  uint8_t Planner::block_count = 0;
+#else
+  block_t Planner::block_buffer[BLOCK_BUFFER_SIZE];
+#endif
+spsc_ring_of<Planner::block_ring> Planner::block_queue;
+
+#if ENABLED(MOTION_SYNC_EVENTS)
+  uint8 Planner::sync_events_unplanned = 0;
+  volatile uint8 Planner::sync_events_due = 0;
+#endif
 
 float Planner::max_feedrate_mm_s[XYZE_N], // Max speeds in mm per second
       Planner::axis_steps_per_mm[XYZE_N],
       Planner::steps_to_mm[XYZE_N];
 
+float Planner::e_factor[EXTRUDERS] = { 1.0f };
+
+#if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+  float Planner::volumetric_extruder_limit[EXTRUDERS],
+        Planner::volumetric_extruder_inverse_limit[EXTRUDERS];
+#endif
+
+void Planner::refresh_e_factor(const uint8_t e) {
+  e_factor[e] = volumetric_multiplier[e] * flow_percentage[e] * 0.01f;
+
+  #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+    // E is in mm of filament here, whether or not volumetric extrusion is on
+    const float diameter = filament_size[e] ? filament_size[e] : DEFAULT_NOMINAL_FILAMENT_DIA;
+    volumetric_extruder_inverse_limit[e] = (volumetric_extruder_limit[e] > 0)
+      ? (M_PI * sq(diameter * 0.5f)) / volumetric_extruder_limit[e]
+      : 0;
+  #endif
+}
+
 //
 // i3++
 //
@@ -107,6 +139,21 @@ float Planner::min_feedrate_mm_s,
       Planner::max_jerk[XYZE],       // The largest speed change requiring no acceleration
       Planner::min_travel_feedrate_mm_s;
 
+#if ENABLED(JUNCTION_DEVIATION)
+  float Planner::junction_deviation_mm = JUNCTION_DEVIATION_MM;
+#endif
+
+#if ENABLED(TRAVEL_JERK)
+  float Planner::travel_jerk[XYZ];
+  #if ENABLED(JUNCTION_DEVIATION)
+    float Planner::travel_junction_deviation_mm = TRAVEL_JUNCTION_DEVIATION_MM;
+  #endif
+#endif
+
+#if ENABLED(STEP_RATE_CALIBRATION)
+  float Planner::inverse_max_step_rate = 0.0; // No limit until the stepper ISR has been timed
+#endif
+
 #if HAS_ABL
   bool Planner::abl_enabled = false; // Flag that auto bed leveling is enabled
 #endif
@@ -129,13 +176,26 @@ float Planner::min_feedrate_mm_s,
 
 // private:
 
+uint8_t Planner::block_buffer_planned = 0;
+
+#if ENABLED(PRINT_TIME_ESTIMATE)
+  uint32 Planner::planned_move_ms = 0;
+  volatile uint32 Planner::done_move_ms = 0;
+#endif
+
 uint24 Planner::position[NUM_AXIS] = { 0 };
 
+float Planner::inverse_max_feedrate_mm_s[XYZE_N];
+
 uint32 Planner::cutoff_long;
 
 float Planner::previous_speed[NUM_AXIS],
       Planner::previous_nominal_speed;
 
+#if ENABLED(JUNCTION_DEVIATION)
+  float Planner::previous_unit_vec[XYZE];
+#endif
+
 #if ENABLED(DISABLE_INACTIVE_EXTRUDER)
   uint8_t Planner::g_uc_extruder_last_move[EXTRUDERS] = { 0 };
 #endif
@@ -157,6 +217,10 @@ float Planner::previous_speed[NUM_AXIS],
   volatile uint32 Planner::block_buffer_runtime_us = 0;
 #endif
 
+#if ENABLED(PLANNER_PROFILING)
+  Planner::profile_t Planner::profile;
+#endif
+
 /**
  * Class and Instance Methods
  */
@@ -164,7 +228,14 @@ float Planner::previous_speed[NUM_AXIS],
 Planner::Planner() { init(); }
 
 void Planner::init() {
-  block_buffer_head = block_buffer_tail = 0;
+  block_queue.clear();
+  block_buffer_planned = 0;
+  #if ENABLED(PRINT_TIME_ESTIMATE)
+    planned_move_ms = done_move_ms = 0;
+  #endif
+  #if ENABLED(PLANNER_PROFILING)
+    reset_profile();
+  #endif
   ZERO(position);
   #if ENABLED(LIN_ADVANCE)
     ZERO(position_float);
@@ -178,60 +249,271 @@ void Planner::init() {
 
 #define MINIMAL_STEP_RATE 120
 
+#if ENABLED(INTEGER_TRAPEZOID_GENERATOR)
+
+  namespace
+  {
+    struct trapezoid_t final
+    {
+      uint24 accelerate_steps, plateau_steps;
+    };
+
+    /**
+     * Integer version of the trapezoid math below. Rates are in steps/s, accel in steps/s^2.
+     *
+     *   accelerate = ceil((nominal^2 - initial^2) / 2a)
+     *   decelerate = floor((nominal^2 - final^2) / 2a)
+     *
+     * If the two overlap, the intersection (2ad - initial^2 + final^2) / 4a is rebuilt from
+     * both quotients and their remainders instead of dividing a third time:
+     *
+     *   ceil((d + q_accel - q_decel + (r_accel - r_decel) / 2a) / 2)
+     */
+    constexpr trapezoid_t integer_trapezoid(uint16 initial_rate, const uint16 nominal_rate, uint16 final_rate, const uint24 accel, const uint24 step_event_count) {
+      if (!accel) return { 0, step_event_count };
+
+      NOMORE(initial_rate, nominal_rate);
+      NOMORE(final_rate, nominal_rate);
+
+      const uint32 accel2 = uint32(accel) << 1;
+      const uint32 nominal_sq = uint32(nominal_rate) * nominal_rate;
+      const uint32 accel_num = nominal_sq - uint32(initial_rate) * initial_rate,
+                   decel_num = nominal_sq - uint32(final_rate) * final_rate;
+      const uint32 accel_q = accel_num / accel2, accel_r = accel_num % accel2,
+                   decel_q = decel_num / accel2, decel_r = decel_num % accel2;
+
+      const uint32 accelerate_steps = accel_q + (accel_r != 0);
+      if (accelerate_steps + decel_q <= step_event_count)
+        return { accelerate_steps, step_event_count - accelerate_steps - decel_q };
+
+      // No plateau. Clamp first so the doubled intersection below can't underflow.
+      if (accel_q >= decel_q + step_event_count) return { step_event_count, 0 };
+      if (decel_q >= accel_q + step_event_count) return { 0, 0 };
+
+      const uint32 twice = step_event_count + accel_q - decel_q;
+      return { (twice >> 1) + ((twice & 1) || accel_r > decel_r), 0 };
+    }
+
+    // The float path, evaluated by the compiler, to keep the integer one honest.
+    constexpr int32 ce_ceil(const float x) { const int32 t = int32(x); return (float(t) < x) ? t + 1 : t; }
+    constexpr int32 ce_floor(const float x) { const int32 t = int32(x); return (float(t) > x) ? t - 1 : t; }
+
+    constexpr trapezoid_t float_trapezoid(const float initial_rate, const float nominal_rate, const float final_rate, const float accel, const uint24 step_event_count) {
+      int32 accelerate_steps = ce_ceil((sq(nominal_rate) - sq(initial_rate)) / (accel * 2));
+      int32 plateau_steps = int32(step_event_count) - accelerate_steps - ce_floor((sq(nominal_rate) - sq(final_rate)) / (accel * 2));
+      if (plateau_steps < 0) {
+        accelerate_steps = ce_ceil((accel * 2 * step_event_count - sq(initial_rate) + sq(final_rate)) / (accel * 4));
+        accelerate_steps = clamp(accelerate_steps, int32(0), int32(step_event_count));
+        plateau_steps = 0;
+      }
+      return { uint24(accelerate_steps), uint24(plateau_steps) };
+    }
+
+    constexpr bool trapezoids_match(const uint16 initial_rate, const uint16 nominal_rate, const uint16 final_rate, const uint24 accel, const uint24 step_event_count) {
+      const trapezoid_t a = integer_trapezoid(initial_rate, nominal_rate, final_rate, accel, step_event_count),
+                        b = float_trapezoid(initial_rate, nominal_rate, final_rate, accel, step_event_count);
+      const int32 accel_delta = int32(a.accelerate_steps) - int32(b.accelerate_steps),
+                  decel_delta = int32(a.accelerate_steps + a.plateau_steps) - int32(b.accelerate_steps + b.plateau_steps);
+      return WITHIN(accel_delta, -1, 1) && WITHIN(decel_delta, -1, 1);
+    }
+
+    c_static_assert(trapezoids_match(120, 4000, 120, 80000, 2000));      // Long print move with a plateau
+    c_static_assert(trapezoids_match(120, 4000, 120, 80000, 100));       // Short move, symmetric triangle
+    c_static_assert(trapezoids_match(1000, 4000, 3000, 80000, 120));     // Short move between junctions
+    c_static_assert(trapezoids_match(120, 30000, 120, 2500000, 3000));   // Retract
+    c_static_assert(trapezoids_match(120, 40000, 120, 800000, 5000));    // Travel at MAX_STEP_FREQUENCY
+    c_static_assert(trapezoids_match(2000, 2000, 2000, 80000, 10));      // Cruising
+  }
+
+#endif
+
+namespace
+{
+  // The rate above which a ramp goes from step shift 'shift' to 'shift' + 1, and the lower
+  // rate it has to fall back under before returning.
+  constexpr uint32 step_shift_up_rate(const uint8 shift) { return uint32(MULTISTEP_RATE) << shift; }
+  constexpr uint32 step_shift_down_rate(const uint8 shift) { return step_shift_up_rate(shift) - (step_shift_up_rate(shift) >> 3); }
+
+  // The fewest steps per ISR that keep 'rate' under the up rate. Used for the cruise.
+  constexpr uint8 cruise_step_shift(const uint32 rate) {
+    uint8 shift = 0;
+    while (shift < MAX_STEP_SHIFT && rate > step_shift_up_rate(shift)) ++shift;
+    return shift;
+  }
+
+  // Junction rates are shared by two blocks. They use the down rate, so a run of blocks around
+  // a threshold settles on the higher shift instead of switching at every junction.
+  constexpr uint8 junction_step_shift(const uint32 rate) {
+    uint8 shift = 0;
+    while (shift < MAX_STEP_SHIFT && rate > step_shift_down_rate(shift)) ++shift;
+    return shift;
+  }
+
+  c_static_assert(cruise_step_shift(10000) == 0 && cruise_step_shift(10001) == 1 && cruise_step_shift(65535) == 3);
+  c_static_assert(junction_step_shift(8750) == 0 && junction_step_shift(8751) == 1 && junction_step_shift(30000) == 2);
+
+  #if ENABLED(S_CURVE_ACCELERATION)
+    // An S-curve ramp runs up to 1.3x the constant acceleration rate at the same step event,
+    // so the step shift crossings are planned for that much lower a rate
+    constexpr const float ramp_crossing_scale = 1.0f / 1.3f;
+
+    s_curve_t make_s_curve(const float duration) {
+      const uint24 ticks = uint24(min(duration, float(type_trait<uint24>::max)));
+      uint8 shift = 0;
+      while ((ticks >> shift) > type_trait<uint16>::max) ++shift;
+      return { ticks, ticks ? uint32(type_trait<uint32>::max / (ticks >> shift)) : 0, shift };
+    }
+  #else
+    constexpr const float ramp_crossing_scale = 1.0f;
+  #endif
+}
+
 /**
- * Calculate trapezoid parameters, multiplying the entry- and exit-speeds
- * by the provided factors.
+ * Calculate trapezoid parameters from the entry and exit speeds (mm/s) of the block.
  */
 void __forceinline __flatten Planner::calculate_trapezoid_for_block(block_t * __restrict const block, const float & __restrict entry_speed, const float & __restrict next_entry_speed) {
-  //float nominal_recip = 1.0f / nominal_speed;
-  uint32 initial_rate = CEIL(entry_speed),
-           final_rate = CEIL(next_entry_speed); // (steps per second)
+  // Junction speeds are along the path, the trapezoid is in step events of the block.
+  uint32 initial_rate = CEIL(entry_speed * block->steps_per_mm),
+           final_rate = CEIL(next_entry_speed * block->steps_per_mm); // (steps per second)
 
   // Limit minimal step rate (Otherwise the timer will overflow.)
   NOLESS(initial_rate, MINIMAL_STEP_RATE);
   NOLESS(final_rate, MINIMAL_STEP_RATE);
 
-  int32 accel = block->acceleration_steps_per_s2;
-  int32 accelerate_steps = CEIL(estimate_acceleration_distance(initial_rate, block->nominal_rate, accel));
-  int32 decelerate_steps = FLOOR(estimate_acceleration_distance(block->nominal_rate, final_rate, -accel));
-  int32 plateau_steps = block->step_event_count - accelerate_steps - decelerate_steps;
-
-  // Is the Plateau of Nominal Rate smaller than nothing? That means no cruising, and we will
-  // have to use intersection_distance() to calculate when to abort accel and start braking
-  // in order to reach the final_rate exactly at the end of this block.
-  if (plateau_steps < 0) {
-    accelerate_steps = CEIL(intersection_distance(initial_rate, final_rate, accel, block->step_event_count));
-    NOLESS(accelerate_steps, 0); // Check limits due to numerical round-off
-    accelerate_steps = min(uint32(accelerate_steps), uint32(block->step_event_count));//(We can cast here to unsigned, because the above line ensures that we are above zero)
-    plateau_steps = 0;
+  #if ENABLED(INTEGER_TRAPEZOID_GENERATOR)
+
+    constexpr const uint32 max_rate = type_trait<uint16>::max;
+    const trapezoid_t trapezoid = integer_trapezoid(
+      min(initial_rate, max_rate),
+      min(uint32(block->nominal_rate), max_rate),
+      min(final_rate, max_rate),
+      block->acceleration_steps_per_s2,
+      block->step_event_count
+    );
+    const uint24 accelerate_steps = trapezoid.accelerate_steps,
+                 plateau_steps = trapezoid.plateau_steps;
+
+  #else
+
+    int32 accel = block->acceleration_steps_per_s2;
+    int32 accelerate_steps = CEIL(estimate_acceleration_distance(initial_rate, block->nominal_rate, accel));
+    int32 decelerate_steps = FLOOR(estimate_acceleration_distance(block->nominal_rate, final_rate, -accel));
+    int32 plateau_steps = block->step_event_count - accelerate_steps - decelerate_steps;
+
+    // Is the Plateau of Nominal Rate smaller than nothing? That means no cruising, and we will
+    // have to use intersection_distance() to calculate when to abort accel and start braking
+    // in order to reach the final_rate exactly at the end of this block.
+    if (plateau_steps < 0) {
+      accelerate_steps = CEIL(intersection_distance(initial_rate, final_rate, accel, block->step_event_count));
+      NOLESS(accelerate_steps, 0); // Check limits due to numerical round-off
+      accelerate_steps = min(uint32(accelerate_steps), uint32(block->step_event_count));//(We can cast here to unsigned, because the above line ensures that we are above zero)
+      plateau_steps = 0;
+    }
+
+  #endif
+
+  set_trapezoid(block, initial_rate, final_rate, accelerate_steps, plateau_steps);
+}
+
+/**
+ * Set the stepper's side of a trapezoid: its end rates and ramps, and the multi-stepping
+ * schedule and move time that follow from them. The block's nominal rate and acceleration
+ * must already be set.
+ */
+void __forceinline __flatten Planner::set_trapezoid(block_t * __restrict const block, const uint32 initial_rate, const uint32 final_rate, const uint24 accelerate_steps, const uint24 plateau_steps) {
+  // Multi-stepping schedule. Crossings that never happen are left at the largest step event,
+  // and the costly part is skipped entirely for the usual block that stays at one step per ISR.
+  const uint8 initial_shift = junction_step_shift(initial_rate),
+              final_shift = junction_step_shift(final_rate),
+              nominal_shift = max(cruise_step_shift(block->nominal_rate), max(initial_shift, final_shift));
+  uint24 shift_up_at[MAX_STEP_SHIFT], shift_down_after[MAX_STEP_SHIFT];
+  for (uint8 shift = 0; shift < MAX_STEP_SHIFT; ++shift)
+    shift_up_at[shift] = shift_down_after[shift] = type_trait<uint24>::max;
+
+  if (nominal_shift != min(initial_shift, final_shift) && block->acceleration_steps_per_s2) {
+    const float accel2 = float(block->acceleration_steps_per_s2) * 2,
+                inverse_accel2 = 1.0f / accel2,
+                initial_sq = sq(float(initial_rate)),
+                plateau_sq = plateau_steps ? sq(float(block->nominal_rate)) : initial_sq + float(accelerate_steps) * accel2;
+    const uint24 decelerate_after = accelerate_steps + plateau_steps;
+
+    // Accelerating: up once the rate passes the up rate, if that happens before the plateau
+    for (uint8 shift = initial_shift; shift < nominal_shift; ++shift) {
+      const float up_at = CEIL((sq(float(step_shift_up_rate(shift)) * ramp_crossing_scale) - initial_sq) * inverse_accel2);
+      if (up_at <= accelerate_steps) shift_up_at[shift] = uint24(up_at);
+    }
+
+    // Decelerating: down once the rate falls under the down rate, right away if it never got there
+    for (uint8 shift = final_shift; shift < nominal_shift; ++shift) {
+      const float down_sq = sq(float(step_shift_down_rate(shift)) * ramp_crossing_scale);
+      shift_down_after[shift] = (plateau_sq > down_sq)
+        ? min(uint32(decelerate_after + uint32((plateau_sq - down_sq) * inverse_accel2)), uint32(block->step_event_count))
+        : decelerate_after;
+    }
   }
 
-  // Fill variables used by the stepper in a critical section
-  {
-    Tuna::critical_section _critsec;
-    if (!TEST(block->flag, BLOCK_BIT_BUSY)) { // Don't update variables if block is busy.
-      block_t * __restrict out = as<block_t * __restrict>(block);
-      out->accelerate_until = accelerate_steps;
-      out->decelerate_after = accelerate_steps + plateau_steps;
-      out->initial_rate = initial_rate;
-      out->final_rate = final_rate;
-      out->acceleration_rate = int24(accel * 16777216.0 / ((F_CPU) * 0.125)); // * 8.388608
-
-      /*
-      float initial_component = float(out->accelerate_until) / float(out->step_event_count);
-      float final_component = float(out->step_event_count - out->decelerate_after) / float(out->step_event_count);
-
-      if (initial_component + final_component >= 0.99)
-      {
-        out->plateau_rate = out->nominal_rate;
-      }
-      else
-      {
-        out->plateau_rate = uint24((out->nominal_rate - (float(out->final_rate * final_component)) - (float(out->initial_rate) * initial_component)) + 0.5);
-      }
-      */
+  #if ENABLED(S_CURVE_ACCELERATION)
+    // Each S-curve ramp takes as long as the constant acceleration would, so it covers the same steps
+    const float plateau_rate = plateau_steps
+      ? float(block->nominal_rate)
+      : min(SQRT(sq(float(initial_rate)) + float(accelerate_steps) * 2 * block->acceleration_steps_per_s2), float(block->nominal_rate));
+    const uint24 decelerate_steps = block->step_event_count - (accelerate_steps + plateau_steps);
+    const s_curve_t accel_curve = make_s_curve(float(accelerate_steps) * (2.0f * STEPPER_TIMER_RATE) / (initial_rate + plateau_rate)),
+                    decel_curve = make_s_curve(float(decelerate_steps) * (2.0f * STEPPER_TIMER_RATE) / (plateau_rate + final_rate));
+  #endif
+
+  #if ENABLED(PRINT_TIME_ESTIMATE)
+    // The ramps at their average rate, and the plateau at the nominal rate
+    const float peak_rate = plateau_steps
+      ? float(block->nominal_rate)
+      : min(SQRT(sq(float(initial_rate)) + float(accelerate_steps) * 2 * block->acceleration_steps_per_s2), float(block->nominal_rate));
+    const uint24 ramp_down_steps = block->step_event_count - (accelerate_steps + plateau_steps);
+    const float move_s = (2.0f * accelerate_steps) / (initial_rate + peak_rate)
+                       + float(plateau_steps) / float(block->nominal_rate)
+                       + (2.0f * ramp_down_steps) / (peak_rate + final_rate);
+    const uint16 move_ms = uint16(min(move_s * 1000.0f, 65535.0f));
+  #endif
+
+  // Fill variables used by the stepper under the block lock. Once 'updating' is set the stepper
+  // won't take the block, and if it already has, 'busy' is set and the block is left alone.
+  block->updating = true;
+  __memorybarrier;
+  if (!block->busy) { // Don't update variables if block is busy.
+    block_t * __restrict out = as<block_t * __restrict>(block);
+    #if ENABLED(PRINT_TIME_ESTIMATE)
+      planned_move_ms += move_ms - out->move_ms;
+      out->move_ms = move_ms;
+    #endif
+    out->accelerate_until = accelerate_steps;
+    out->decelerate_after = accelerate_steps + plateau_steps;
+    out->initial_rate = initial_rate;
+    out->final_rate = final_rate;
+    out->initial_step_shift = initial_shift;
+    out->nominal_step_shift = nominal_shift;
+    COPY(out->step_shift_up_at, shift_up_at);
+    COPY(out->step_shift_down_after, shift_down_after);
+    #if ENABLED(S_CURVE_ACCELERATION)
+      out->plateau_rate = uint24(plateau_rate);
+      out->accel_curve = accel_curve;
+      out->decel_curve = decel_curve;
+    #endif
+
+    /*
+    float initial_component = float(out->accelerate_until) / float(out->step_event_count);
+    float final_component = float(out->step_event_count - out->decelerate_after) / float(out->step_event_count);
+
+    if (initial_component + final_component >= 0.99)
+    {
+      out->plateau_rate = out->nominal_rate;
     }
+    else
+    {
+      out->plateau_rate = uint24((out->nominal_rate - (float(out->final_rate * final_component)) - (float(out->initial_rate) * initial_component)) + 0.5);
+    }
+    */
   }
+  __memorybarrier;
+  block->updating = false;
 }
 
 // "Junction jerk" in this context is the immediate change in speed at the junction of two blocks.
@@ -263,30 +545,28 @@ void __forceinline __flatten Planner::reverse_pass_kernel(block_t * __restrict c
 /**
  * recalculate() needs to go over the current plan twice.
  * Once in reverse and once forward. This implements the reverse pass.
+ *
+ * The newest block is already planned against a full stop, and the entry speed
+ * of the planned block is final, so only the blocks in between are revisited.
  */
-void __forceinline __flatten Planner::reverse_pass() {
-
-  if (movesplanned() > 3) {
-    const uint8_t endnr = BLOCK_MOD(block_buffer_tail + 2); // tail is running. tail+1 shouldn't be altered because it's connected to the running block.
-                                                            // tail+2 because the index is not yet advanced when checked
-    uint8_t blocknr = prev_block_index(block_buffer_head);
-    block_t* __restrict current = &block_buffer[blocknr];
-
-    do {
-      const block_t * __restrict const next = current;
-      blocknr = prev_block_index(blocknr);
-      current = &block_buffer[blocknr];
-      if (TEST(current->flag, BLOCK_BIT_START_FROM_FULL_HALT)) // Up to this every block is already optimized.
-        break;
-      reverse_pass_kernel(current, next);
-    } while (blocknr != endnr);
+void __forceinline __flatten Planner::reverse_pass(const uint8_t planned) {
+  uint8_t blocknr = prev_block_index(block_queue.head());
+
+  while (blocknr != planned) {
+    const block_t * __restrict const next = &block_buffer[blocknr];
+    blocknr = prev_block_index(blocknr);
+    if (blocknr == planned)
+      break;
+    block_t * __restrict const current = &block_buffer[blocknr];
+    if (TEST(current->flag, BLOCK_BIT_START_FROM_FULL_HALT)) // Up to this every block is already optimized.
+      break;
+    reverse_pass_kernel(current, next);
   }
 }
 
 // The kernel called by recalculate() when scanning the plan from first to last entry.
-void __forceinline __flatten Planner::forward_pass_kernel(const block_t * __restrict previous, block_t * __restrict const current) {
-  if (!previous) return;
-
+// Returns true if the entry speed of 'current' can no longer be raised by blocks queued after it.
+bool __forceinline __flatten Planner::forward_pass_kernel(const block_t * __restrict previous, block_t * __restrict const current) {
   // If the previous block is an acceleration block, but it is not long enough to complete the
   // full speed change within the block, we need to adjust the entry speed accordingly. Entry
   // speeds have already been reset, maximized, and reverse planned by reverse planner.
@@ -299,25 +579,31 @@ void __forceinline __flatten Planner::forward_pass_kernel(const block_t * __rest
       if (current->entry_speed != entry_speed) {
         current->entry_speed = entry_speed;
         SBI(current->flag, BLOCK_BIT_RECALCULATE);
+        // Accelerating as hard as possible out of an already planned block.
+        return true;
       }
     }
   }
+
+  return current->entry_speed == current->max_entry_speed || TEST(current->flag, BLOCK_BIT_START_FROM_FULL_HALT);
 }
 
 /**
  * recalculate() needs to go over the current plan twice.
  * Once in reverse and once forward. This implements the forward pass.
+ *
+ * Starts at the planned block and moves the planned pointer up to the newest
+ * block whose entry speed turned out to be final.
  */
-void __forceinline __flatten Planner::forward_pass() {
-  block_t * __restrict block[3] = { nullptr, nullptr, nullptr };
-
-  for (uint8_t b = block_buffer_tail; b != block_buffer_head; b = next_block_index(b)) {
-    block[0] = block[1];
-    block[1] = block[2];
-    block[2] = as<block_t * __restrict>(&block_buffer[b]);
-    forward_pass_kernel(block[0], block[1]);
+void __forceinline __flatten Planner::forward_pass(const uint8_t planned) {
+  const block_t * __restrict previous = &block_buffer[planned];
+
+  for (uint8_t b = next_block_index(planned); b != block_queue.head(); b = next_block_index(b)) {
+    block_t * __restrict const current = &block_buffer[b];
+    if (forward_pass_kernel(previous, current))
+      block_buffer_planned = b;
+    previous = current;
   }
-  forward_pass_kernel(block[1], block[2]);
 }
 
 /**
@@ -325,14 +611,16 @@ void __forceinline __flatten Planner::forward_pass() {
  * according to the entry_factor for each junction. Must be called by
  * recalculate() after updating the blocks.
  */
-void __forceinline __flatten Planner::recalculate_trapezoids() {
-  uint8 block_index = block_buffer_tail;
+void __forceinline __flatten Planner::recalculate_trapezoids(const uint8_t planned) {
+  // Nothing before the planned block can have changed, but its own exit speed may have.
+  uint8 block_index = planned;
   block_t * __restrict next = nullptr;
 
-  while (block_index != block_buffer_head) {
+  while (block_index != block_queue.head()) {
     block_t * __restrict current = next;
     next = as<block_t * __restrict>(&block_buffer[block_index]);
-    if (current) {
+    // Host-planned blocks keep the trapezoid they came with
+    if (current && !TEST(current->flag, BLOCK_BIT_HOST_PLANNED)) {
       // Recalculate if current block entry or exit junction speed has changed.
       if (TEST(current->flag, BLOCK_BIT_RECALCULATE) || TEST(next->flag, BLOCK_BIT_RECALCULATE)) {
         const float old_entry_speed = next->entry_speed;
@@ -355,12 +643,7 @@ void __forceinline __flatten Planner::recalculate_trapezoids() {
             };
             // Treat them as a vector, and normalize them. We then use the components as multipliers to break down
             // the velocity.
-            const float current_vector_length = sqrt(square(current_adjusted_steps[0]) + square(current_adjusted_steps[1]) + square(current_adjusted_steps[2]));
-            float current_vector_length_recip = 0.0f;
-            if (current_vector_length)
-            {
-              current_vector_length_recip = 1.0f / current_vector_length;
-            }
+            const float current_vector_length_recip = RSQRT(square(current_adjusted_steps[0]) + square(current_adjusted_steps[1]) + square(current_adjusted_steps[2]));
             const float current_frac[3] = {
               current_adjusted_steps[0] * current_vector_length_recip,
               current_adjusted_steps[1] * current_vector_length_recip,
@@ -389,12 +672,7 @@ void __forceinline __flatten Planner::recalculate_trapezoids() {
             };
             // Treat them as a vector, and normalize them. We then use the components as multipliers to break down
             // the velocity.
-            const float next_vector_length = sqrt(square(next_adjusted_steps[0]) + square(next_adjusted_steps[1]) + square(next_adjusted_steps[2]));
-            float next_vector_length_recip = 0.0f;
-            if (next_vector_length)
-            {
-              next_vector_length_recip = 1.0f / next_vector_length;
-            }
+            const float next_vector_length_recip = RSQRT(square(next_adjusted_steps[0]) + square(next_adjusted_steps[1]) + square(next_adjusted_steps[2]));
             const float next_frac[3] = {
               next_adjusted_steps[0] * next_vector_length_recip,
               next_adjusted_steps[1] * next_vector_length_recip,
@@ -407,7 +685,7 @@ void __forceinline __flatten Planner::recalculate_trapezoids() {
               TEST(direction_bits_delta, Z_AXIS) ? 0 : (next->nominal_speed * next_frac[2])
             };
 
-            const float new_velocity = sqrt(square(next_axis_velocity[0]) + square(next_axis_velocity[1]) + square(next_axis_velocity[2]));
+            const float new_velocity = SQRT(square(next_axis_velocity[0]) + square(next_axis_velocity[1]) + square(next_axis_velocity[2]));
             next->entry_speed = max(0.0f, new_velocity);
           }
           else
@@ -423,7 +701,7 @@ void __forceinline __flatten Planner::recalculate_trapezoids() {
     block_index = next_block_index(block_index);
   }
   // Last/newest block in buffer. Exit speed is set with MINIMUM_PLANNER_SPEED. Always recalculated.
-  if (next) {
+  if (next && !TEST(next->flag, BLOCK_BIT_HOST_PLANNED)) {
     calculate_trapezoid_for_block(next, next->entry_speed, 0.0f);
     CBI(next->flag, BLOCK_BIT_RECALCULATE);
   }
@@ -452,13 +730,317 @@ void __forceinline __flatten Planner::recalculate_trapezoids() {
  * jerk is jerkier than the set limit, Jerky. Finally it will:
  *
  *   3. Recalculate "trapezoids" for all blocks.
+ *
+ * As in grbl, block_buffer_planned marks the newest block whose entry speed is final.
+ * Both passes start from it, so appending a segment usually costs a handful of blocks
+ * instead of the whole buffer.
  */
 void __forceinline __flatten Planner::recalculate() {
-  reverse_pass();
-  forward_pass();
-  recalculate_trapezoids();
+  // Once there is more than a single junction, neither the running block nor the one after it
+  // are replanned. The stepper may also have consumed the planned block since the last call;
+  // if so, restart right after the tail.
+  const uint8_t tail = block_queue.tail();
+  const uint8_t queued = block_ring::distance(tail, block_queue.head());
+
+  uint8_t planned = tail;
+  if (queued > 2) {
+    planned = block_buffer_planned;
+    if (!WITHIN(block_ring::distance(tail, planned), 1, queued - 1))
+      block_buffer_planned = planned = next_block_index(tail);
+
+    reverse_pass(planned);
+  }
+
+  forward_pass(planned);
+  recalculate_trapezoids(planned);
 }
 
+#if ENABLED(LIVE_SPEED_OVERRIDE)
+
+  /**
+   * Scale the nominal speed of the queued moves by 'ratio', as a feedrate_percentage
+   * change would have given them, and replan. Like feedrate_percentage, it leaves
+   * moves without X or Y alone. The running block and the one after it keep their
+   * speeds, as recalculate() doesn't replan them, and no axis goes past its
+   * max_feedrate_mm_s.
+   */
+  void Planner::rescale_queued_speeds(const float ratio) {
+    const uint8_t tail = block_queue.tail();
+    if (ratio == 1.0f || block_ring::distance(tail, block_queue.head()) <= 2) return;
+
+    const uint8_t first = next_block_index(next_block_index(tail));
+    float previous_speed_new = block_buffer[prev_block_index(first)].nominal_speed;
+    float last_factor = 1.0f;
+
+    for (uint8_t b = first; b != block_queue.head(); b = next_block_index(b)) {
+      block_t & __restrict block = as<block_t & __restrict>(block_buffer[b]);
+      last_factor = 1.0f;
+
+      // Under the block lock, as in calculate_trapezoid_for_block(): a block the stepper took meanwhile is left as it is,
+      // as is one the host planned
+      block.updating = true;
+      if (block.busy || TEST(block.flag, BLOCK_BIT_HOST_PLANNED)) {
+        block.updating = false;
+        previous_speed_new = block.nominal_speed;
+        continue;
+      }
+
+      if (block.steps[X_AXIS] || block.steps[Y_AXIS]) {
+        float speed = block.nominal_speed * ratio;
+        LOOP_XYZE(i) {
+          if (!block.steps[i]) continue;
+          #if ENABLED(DISTINCT_E_FACTORS)
+            const uint8_t n = (i == E_AXIS) ? E_AXIS + block.active_extruder : i;
+          #else
+            const uint8_t n = i;
+          #endif
+          NOMORE(speed, max_feedrate_mm_s[n] * block.millimeters / (block.steps[i] * steps_to_mm[n]));
+        }
+        #if ENABLED(STEP_RATE_CALIBRATION)
+          NOMORE(speed, 1.0f / (inverse_max_step_rate * block.steps_per_mm));
+        #endif
+
+        last_factor = speed / block.nominal_speed;
+        block.nominal_speed = speed;
+        block.nominal_rate = max(CEIL(speed * block.steps_per_mm), float(MINIMAL_STEP_RATE));
+        CBI(block.flag, BLOCK_BIT_NOMINAL_LENGTH);
+      }
+
+      // A junction is no faster than the slower of the two moves it joins
+      NOMORE(block.max_entry_speed, min(block.nominal_speed, previous_speed_new));
+      NOMORE(block.entry_speed, block.max_entry_speed);
+      SBI(block.flag, BLOCK_BIT_RECALCULATE);
+      block.updating = false;
+      previous_speed_new = block.nominal_speed;
+    }
+
+    // The next move joins the last one at its new speed
+    previous_nominal_speed = previous_speed_new;
+    LOOP_XYZE(i) previous_speed[i] *= last_factor;
+
+    block_buffer_planned = next_block_index(tail);
+    recalculate();
+  }
+
+#endif // LIVE_SPEED_OVERRIDE
+
+#if ENABLED(QUICK_PAUSE)
+
+  volatile bool Planner::holding = false;
+  uint8_t Planner::hold_block;
+
+  /**
+   * Brake from the entry of the block after the next one, each block decelerating over its
+   * whole length, and no junction faster than it was planned. The block after the one that
+   * reaches a stop becomes the hold block, planned from rest. Without room to stop earlier,
+   * the moves stop at the end of the buffer, as they were planned to.
+   */
+  void Planner::hold_motion() {
+    const uint8_t tail = block_queue.tail();
+    uint8_t hold = block_queue.head();
+
+    if (block_ring::distance(tail, hold) > 2) {
+      uint8_t b = next_block_index(next_block_index(tail));
+      float speed = block_buffer[b].entry_speed;
+
+      for (; b != block_queue.head(); b = next_block_index(b)) {
+        block_t & __restrict block = as<block_t & __restrict>(block_buffer[b]);
+        const uint8_t n = next_block_index(b);
+        const bool last = n == block_queue.head();
+        float exit_speed = last ? 0.0f : block_buffer[n].entry_speed;
+
+        // Under the block lock, as in calculate_trapezoid_for_block(): a block the stepper took
+        // meanwhile, or one the host planned, keeps its speeds, and braking goes on after it
+        block.updating = true;
+        if (!block.busy && !TEST(block.flag, BLOCK_BIT_HOST_PLANNED)) {
+          block.entry_speed = block.max_entry_speed = speed;
+          SBI(block.flag, BLOCK_BIT_RECALCULATE);
+          const float braked = sq(speed) - 2 * block.acceleration * block.millimeters;
+          if (braked <= 0.0f) {
+            block.updating = false;
+            hold = n;
+            break;
+          }
+          NOMORE(exit_speed, SQRT(braked));
+        }
+        block.updating = false;
+        speed = exit_speed;
+      }
+
+      if (hold != block_queue.head()) {
+        block_t & __restrict block = as<block_t & __restrict>(block_buffer[hold]);
+        block.updating = true;
+        if (!block.busy) {
+          block.entry_speed = block.max_entry_speed = 0.0f;
+          SBI(block.flag, BLOCK_BIT_RECALCULATE);
+        }
+        block.updating = false;
+      }
+
+      block_buffer_planned = next_block_index(tail);
+      recalculate();
+    }
+
+    // Should the stepper have taken the hold block already, the moves stop where the plan ends
+    CRITICAL_SECTION_START
+      hold_block = (hold != block_queue.head() && block_buffer[hold].busy) ? block_queue.head() : hold;
+      holding = true;
+    CRITICAL_SECTION_END
+  }
+
+#endif // QUICK_PAUSE
+
+#if ENABLED(QUICK_PAUSE_PARK)
+
+  Planner::park_state Planner::park_status = Planner::park_state::none;
+  uint8_t Planner::park_move;
+  bool Planner::park_queuing = false;
+  Planner::stash_t Planner::stash;
+
+  void Planner::park() {
+    if (park_status != park_state::none) return;
+    hold_motion();
+    park_status = park_state::waiting;
+  }
+
+  void Planner::unpark() {
+    switch (park_status) {
+      case park_state::waiting:
+        // Nothing set aside yet, so the held moves just go on
+        release_motion();
+        break;
+      case park_state::parking:
+      case park_state::parked:
+        // From wherever the park got to: the return moves that aren't needed are empty
+        park_status = park_state::returning;
+        park_move = 0;
+        break;
+      default:
+        break;
+    }
+  }
+
+  void Planner::release_motion() {
+    #if ENABLED(PRINT_TIME_ESTIMATE)
+      // Held moves that were set aside are let go with the rest, so their time isn't queued any more
+      if (park_status > park_state::waiting)
+        for (uint8_t b = stash.tail; b != stash.head; b = next_block_index(b))
+          planned_move_ms -= block_buffer[b].move_ms;
+    #endif
+    park_status = park_state::none;
+    holding = false;
+  }
+
+  // Once the stepper is waiting at the hold block, everything before it is done: the ring from
+  // the hold block to the head is set aside, and the park starts from rest in the rest of it.
+  void Planner::stash_held_moves() {
+    stash.tail = hold_block;
+    stash.head = block_queue.head();
+    stash.planned = block_buffer_planned;
+    COPY(stash.position, position);
+    COPY(stash.previous_speed, previous_speed);
+    stash.previous_nominal_speed = previous_nominal_speed;
+    #if ENABLED(JUNCTION_DEVIATION)
+      COPY(stash.previous_unit_vec, previous_unit_vec);
+    #endif
+    #if ENABLED(LIN_ADVANCE)
+      COPY(stash.position_float, position_float);
+    #endif
+
+    stepper.get_positions_mm(stash.stopped_at);
+    // Positions don't go below 0, so no more filament is drawn back than that
+    stash.retract = min(float(QUICK_PAUSE_PARK_RETRACT_LENGTH), stash.stopped_at[E_AXIS]);
+
+    CRITICAL_SECTION_START
+      block_queue.reset(stash.head, stash.head);
+    CRITICAL_SECTION_END
+    block_buffer_planned = stash.head;
+    sync_from_steppers();
+    previous_nominal_speed = 0.0f;
+    ZERO(previous_speed);
+  }
+
+  // The return has ended where the nozzle stopped. The hold is still on at the stash's tail,
+  // so the stepper waits there as the held moves come back.
+  void Planner::restore_held_moves() {
+    CRITICAL_SECTION_START
+      block_queue.reset(stash.tail, stash.head);
+    CRITICAL_SECTION_END
+    block_buffer_planned = stash.planned;
+    COPY(position, stash.position);
+    COPY(previous_speed, stash.previous_speed);
+    previous_nominal_speed = stash.previous_nominal_speed;
+    #if ENABLED(JUNCTION_DEVIATION)
+      COPY(previous_unit_vec, stash.previous_unit_vec);
+    #endif
+    #if ENABLED(LIN_ADVANCE)
+      COPY(position_float, stash.position_float);
+    #endif
+  }
+
+  // Queues park_move of the park or the return, if there's room. false once there are no more.
+  bool Planner::queue_park_move() {
+    if (park_move >= 3) return false;
+
+    // The park can only use the slots up to the stash: once it reaches them and has run, it
+    // starts again after the stash
+    if (stash.tail != stash.head && block_queue.empty() && block_queue.head() == stash.tail) {
+      CRITICAL_SECTION_START
+        block_queue.reset(stash.head, stash.head);
+      CRITICAL_SECTION_END
+      block_buffer_planned = stash.head;
+    }
+
+    park_queuing = true;
+    if (!has_room()) {
+      park_queuing = false;
+      return true;
+    }
+
+    const float (&at)[XYZE] = stash.stopped_at;
+    const float raised = min(at[Z_AXIS] + float(QUICK_PAUSE_PARK_Z_RAISE), float(Z_MAX_POS)),
+                drawn = at[E_AXIS] - stash.retract;
+    const bool returning = park_status == park_state::returning;
+    switch (returning ? 3 + park_move : park_move) {
+      case 0: _buffer_line(at[X_AXIS], at[Y_AXIS], at[Z_AXIS], drawn, QUICK_PAUSE_PARK_RETRACT_FEEDRATE, active_extruder); break;
+      case 1: _buffer_line(at[X_AXIS], at[Y_AXIS], raised, drawn, QUICK_PAUSE_PARK_Z_FEEDRATE, active_extruder); break;
+      case 2: _buffer_line(QUICK_PAUSE_PARK_X_POS, QUICK_PAUSE_PARK_Y_POS, raised, drawn, QUICK_PAUSE_PARK_XY_FEEDRATE, active_extruder); break;
+      case 3: _buffer_line(at[X_AXIS], at[Y_AXIS], raised, drawn, QUICK_PAUSE_PARK_XY_FEEDRATE, active_extruder); break;
+      case 4: _buffer_line(at[X_AXIS], at[Y_AXIS], at[Z_AXIS], drawn, QUICK_PAUSE_PARK_Z_FEEDRATE, active_extruder); break;
+      case 5: _buffer_line(at[X_AXIS], at[Y_AXIS], at[Z_AXIS], at[E_AXIS], QUICK_PAUSE_PARK_RETRACT_FEEDRATE, active_extruder); break;
+    }
+    park_queuing = false;
+    ++park_move;
+    return true;
+  }
+
+  void Planner::manage_park() {
+    switch (park_status) {
+      case park_state::waiting:
+        if (block_queue.tail() != hold_block) return; // Still braking
+        stash_held_moves();
+        park_status = park_state::parking;
+        park_move = 0;
+        break;
+
+      case park_state::parking:
+        if (!queue_park_move()) park_status = park_state::parked;
+        break;
+
+      case park_state::returning:
+        if (queue_park_move() || blocks_queued()) return;
+        restore_held_moves();
+        park_status = park_state::none;
+        holding = false;
+        break;
+
+      default:
+        break;
+    }
+  }
+
+#endif // QUICK_PAUSE_PARK
+
 
 #if ENABLED(AUTOTEMP)
 
@@ -469,7 +1051,7 @@ void __forceinline __flatten Planner::recalculate() {
     if (float(Temperature::degTargetHotend() + 2) < autotemp_min) return; // probably temperature set to zero.
 
     float high = 0.0;
-    for (uint8_t b = block_buffer_tail; b != block_buffer_head; b = next_block_index(b)) {
+    for (uint8_t b = block_queue.tail(); b != block_queue.head(); b = next_block_index(b)) {
       const block_t & __restrict block = as<const block_t & __restrict>(block_buffer[b]);
       if (block.steps[X_AXIS] || block.steps[Y_AXIS] || block.steps[Z_AXIS]) {
         float se = (float)block.steps[E_AXIS] / block.step_event_count * block.nominal_speed; // mm/sec;
@@ -486,6 +1068,42 @@ void __forceinline __flatten Planner::recalculate() {
 
 #endif // AUTOTEMP
 
+#if ENABLED(DRIVER_WAKE_LEAD)
+
+  volatile bool Planner::waking = false;
+  uint8_t Planner::wake_block;
+  millis_t Planner::wake_ms;
+
+  void Planner::hold_for_drivers(const block_t & __restrict block) {
+    #define _DRIVER_ASLEEP(A) (block.steps[A##_AXIS] && A##_ENABLE_READ != bool(A##_ENABLE_ON))
+    const bool asleep = false
+      #if HAS_X_ENABLE
+        || _DRIVER_ASLEEP(X)
+      #endif
+      #if HAS_Y_ENABLE
+        || _DRIVER_ASLEEP(Y)
+      #endif
+      #if HAS_Z_ENABLE && DISABLED(Z_LATE_ENABLE)
+        || _DRIVER_ASLEEP(Z)
+      #endif
+      #if HAS_E0_ENABLE
+        || (block.steps[E_AXIS] && E0_ENABLE_READ != bool(E_ENABLE_ON))
+      #endif
+    ;
+    if (__likely(!asleep)) return;
+
+    // A block already waiting keeps its place, and waits as long as this one would
+    CRITICAL_SECTION_START
+      wake_ms = millis() + (DRIVER_WAKE_LEAD);
+      if (!waking) {
+        wake_block = block_queue.head();
+        waking = true;
+      }
+    CRITICAL_SECTION_END
+  }
+
+#endif // DRIVER_WAKE_LEAD
+
 /**
  * Maintain fans, paste extruder pressure,
  */
@@ -509,11 +1127,11 @@ void __forceinline __flatten Planner::check_axes_activity() {
   if (blocks_queued()) {
 
     #if FAN_COUNT > 0
-      for (uint8_t i = 0; i < FAN_COUNT; i++) tail_fan_speed[i] = as<const block_t & __restrict>(block_buffer[block_buffer_tail]).fan_speed[i];
+      for (uint8_t i = 0; i < FAN_COUNT; i++) tail_fan_speed[i] = as<const block_t & __restrict>(block_buffer[block_queue.tail()]).fan_speed[i];
     #endif
 
     #if ENABLED(BARICUDA)
-      block = &block_buffer[block_buffer_tail];
+      block = &block_buffer[block_queue.tail()];
       #if HAS_HEATER_1
         tail_valve_pressure = block->valve_pressure;
       #endif
@@ -522,7 +1140,7 @@ void __forceinline __flatten Planner::check_axes_activity() {
       #endif
     #endif
 
-    for (uint8_t b = block_buffer_tail; b != block_buffer_head; b = next_block_index(b)) {
+    for (uint8_t b = block_queue.tail(); b != block_queue.head(); b = next_block_index(b)) {
       const block_t & __restrict block = as<const block_t & __restrict>(block_buffer[b]);
       LOOP_XYZE(i) if (block.steps[i]) axis_active[i]++;
     }
@@ -540,6 +1158,16 @@ void __forceinline __flatten Planner::check_axes_activity() {
     if (!axis_active[E_AXIS]) disable_e_steppers();
   #endif
 
+  #ifdef E_TRAVEL_IDLE_MS
+    // Let the extruder driver rest through travel, once nothing queued has extruded in a while
+    static millis_t last_e_ms = 0;
+    const millis_t ms = millis();
+    if (axis_active[E_AXIS])
+      last_e_ms = ms;
+    else if (blocks_queued() && ELAPSED(ms, last_e_ms + (E_TRAVEL_IDLE_MS)))
+      disable_e_steppers();
+  #endif
+
   #if FAN_COUNT > 0
 
     #ifdef FAN_MIN_PWM
@@ -562,7 +1190,7 @@ void __forceinline __flatten Planner::check_axes_activity() {
             tail_fan_speed[f] = 255; \
         } else fan_kick_end[f] = 0
 
-      #if HAS_FAN0
+      #if HAS_FAN0 && DISABLED(FAN_HARDWARE_PWM)
         KICKSTART_FAN(0);
       #endif
       #if HAS_FAN1
@@ -574,6 +1202,9 @@ void __forceinline __flatten Planner::check_axes_activity() {
 
     #endif // FAN_KICKSTART_TIME
 
+    // The heater manager adds the power this fan speed takes before the hotend cools.
+    Tuna::Thermal::FanCompensation::set_fan_speed(CALC_FAN_SPEED(0));
+
     #if ENABLED(FAN_SOFT_PWM)
       #if HAS_FAN0
         thermalManager.soft_pwm_amount_fan[0] = CALC_FAN_SPEED(0);
@@ -585,7 +1216,10 @@ void __forceinline __flatten Planner::check_axes_activity() {
         thermalManager.soft_pwm_amount_fan[2] = CALC_FAN_SPEED(2);
       #endif
     #else
-      #if HAS_FAN0
+      #if ENABLED(FAN_HARDWARE_PWM)
+        // The stepper sets each block's speed as it starts; with none running, this is the speed
+        if (!blocks_queued()) Tuna::fan_pwm::set(tail_fan_speed[0]);
+      #elif HAS_FAN0
         analogWrite(FAN_PIN, CALC_FAN_SPEED(0));
       #endif
       #if HAS_FAN1
@@ -668,6 +1302,11 @@ void __forceinline __flatten Planner::check_axes_activity() {
         #endif
       ;
 
+    #elif ENABLED(MESH_COMPENSATION)
+
+      if (mesh::active)
+        lz += mesh::z_offset(RAW_X_POSITION(lx), RAW_Y_POSITION(ly));
+
     #endif
   }
 
@@ -750,62 +1389,253 @@ void __forceinline __flatten Planner::check_axes_activity() {
         logical[Z_AXIS] -= bilinear_z_offset(logical);
       #endif
 
+    #elif ENABLED(MESH_COMPENSATION)
+
+      if (mesh::active)
+        logical[Z_AXIS] -= mesh::z_offset(RAW_X_POSITION(logical[X_AXIS]), RAW_Y_POSITION(logical[Y_AXIS]));
+
     #endif
   }
 
 #endif // PLANNER_LEVELING
 
+// Exit speed limited by a jerk to full halt of the previous block
+static float previous_safe_speed;
+
+// The previous block didn't extrude, so a junction with another travel takes the travel limits
+static bool previous_travel;
+
+// The one axis the previous block moved, or several_axes
+static uint8_t previous_single_axis = Planner::several_axes;
+
 /**
-* Add an arc movement to the buffer.
-*/
-void __forceinline Planner::_buffer_arc(
-  const float(&target)[4],
-  const float(&start_velocity)[4],
-  const float(&end_velocity)[4]
-)
-{
+ * Adapted from Průša MKS firmware
+ * https://github.com/prusa3d/Prusa-Firmware
+ *
+ * The safe speed of one end of a block: the speed from which the machine may halt
+ * immediately, or start from a halt, given the axis speeds at that end.
+ */
+float __forceinline __flatten Planner::halt_speed(const float (&speed)[NUM_AXIS], const float &nominal_speed, const bool travel) {
+  float safe_speed = nominal_speed;
+  uint8_t limited = 0;
+  LOOP_XYZE(i) {
+    const float jerk = FABS(speed[i]), maxj = jerk_limit(i, travel);
+    if (jerk > maxj) {
+      if (limited) {
+        const float mjerk = maxj * nominal_speed;
+        if (jerk * safe_speed > mjerk) safe_speed = mjerk / jerk;
+      }
+      else {
+        ++limited;
+        safe_speed = maxj;
+      }
+    }
+  }
+  return safe_speed;
 }
 
 /**
- * Planner::_buffer_line
+ * Planner::plan_junction
  *
- * Add a new linear movement to the buffer.
+ * Set the entry speed limits and flags of a new block from its junction with the previous one.
  *
- * Leveling and kinematics should be applied ahead of calling this.
+ *  current_speed - axis speeds of the block where it starts
+ *  unit_vec      - its direction there (JUNCTION_DEVIATION)
+ *  single_axis   - the one axis the block moves, or several_axes
  *
- *  a,b,c,e     - target positions in mm or degrees
- *  fr_mm_s     - (target) speed of the move
- *  extruder    - target extruder
+ * Returns the safe speed of the block's start.
  */
-void __forceinline Planner::_buffer_line(const float & __restrict a, const float & __restrict b, const float & __restrict c, const float & __restrict e, float fr_mm_s, const uint8_t extruder) {
+float __forceinline __flatten Planner::plan_junction(block_t * __restrict const block, const float (&current_speed)[NUM_AXIS],
+  #if ENABLED(JUNCTION_DEVIATION)
+    const float (&unit_vec)[XYZE],
+  #endif
+  const uint8_t moves_queued,
+  const uint8_t single_axis
+) {
+  // Initial limit on the segment entry velocity
+  float vmax_junction;
 
-  // The target position of the tool in absolute steps
-  // Calculate target position in absolute steps
-  //this should be done after the wait, because otherwise a M92 code within the gcode disrupts this calculation somehow
+  // A move that doesn't extrude starts and stops with the travel jerk, and takes the
+  // travel limits at a junction with another one. A junction with a printing move
+  // is part of the print, so it keeps the print limits.
+  const bool travel = !block->steps[E_AXIS], travel_junction = travel && previous_travel;
 
-  // TODO FIXME their code always presumes LROUND, which doesn't make sense
-  // if you can have negative positions.
-  // That being said, I'm just going to rework it somewhat as the target in our firmware is always > 0 anyways.
+  // Start with a safe speed (from which the machine may halt to stop immediately).
+  // One axis moves at the nominal speed, so only its own jerk can limit it.
+  const float safe_speed = (single_axis != several_axes)
+    ? min(block->nominal_speed, jerk_limit(single_axis, travel))
+    : halt_speed(current_speed, block->nominal_speed, travel);
 
-  __assume(a >= 0.0f);
-  __assume(b >= 0.0f);
-  __assume(c >= 0.0f);
-  __assume(e >= 0.0f);
+  if (moves_queued > 1 && previous_nominal_speed > 0.0001) {
+    // Estimate a maximum velocity allowed at a joint of two successive segments.
+    // If this maximum velocity allowed is lower than the minimum of the entry / exit safe velocities,
+    // then the machine is not coasting anymore and the safe entry / exit velocities shall be used.
 
-  const uint24 target[XYZE] = {
-    round<uint24>(a * axis_steps_per_mm[X_AXIS]),
-    round<uint24>(b * axis_steps_per_mm[Y_AXIS]),
-    round<uint24>(c * axis_steps_per_mm[Z_AXIS]),
-    round<uint24>(e * axis_steps_per_mm[E_AXIS_N])
-  };
+    // The junction velocity will be shared between successive segments. Limit the junction velocity to their minimum.
+    bool prev_speed_larger = previous_nominal_speed > block->nominal_speed;
+    // Pick the smaller of the nominal speeds. Higher speed shall not be achieved at the junction during coasting.
+    vmax_junction = prev_speed_larger ? block->nominal_speed : previous_nominal_speed;
 
-  // When changing extruders recalculate steps corresponding to the E position
-  #if ENABLED(DISTINCT_E_FACTORS)
-    if (last_extruder != extruder && axis_steps_per_mm[E_AXIS_N] != axis_steps_per_mm[E_AXIS + last_extruder]) {
-      position[E_AXIS] = LROUND(position[E_AXIS] * axis_steps_per_mm[E_AXIS_N] * steps_to_mm[E_AXIS + last_extruder]);
-      last_extruder = extruder;
-    }
-  #endif
+    #if ENABLED(JUNCTION_DEVIATION)
+
+      /**
+       * Junction deviation, as in grbl. Treat the corner as a circular arc that stays
+       * 'junction_deviation_mm' from the sharp junction and tangent to both segments,
+       * then take the speed whose centripetal acceleration on that arc equals the block
+       * acceleration: v^2 = a * d * sin(theta/2) / (1 - sin(theta/2)).
+       * Shallow angles (such as arcs broken into short segments) get close to full speed.
+       */
+
+      // cos(theta) of the angle between the previous exit and this entry direction.
+      // Negated so that a straight continuation is -1 and a full reversal is 1.
+      const float junction_cos_theta = -(
+        previous_unit_vec[X_AXIS] * unit_vec[X_AXIS] +
+        previous_unit_vec[Y_AXIS] * unit_vec[Y_AXIS] +
+        previous_unit_vec[Z_AXIS] * unit_vec[Z_AXIS] +
+        previous_unit_vec[E_AXIS] * unit_vec[E_AXIS]
+      );
+
+      if (junction_cos_theta > 0.999999f) {
+        // Reversal. Come to a stop at the junction.
+        vmax_junction = 0.0f;
+      }
+      else if (junction_cos_theta > -0.999999f) {
+        // sin(theta/2) by the half-angle identity, which is always positive.
+        const float sin_theta_d2 = SQRT(0.5f * (1.0f - junction_cos_theta));
+        #if ENABLED(TRAVEL_JERK)
+          const float deviation_mm = travel_junction ? travel_junction_deviation_mm : junction_deviation_mm;
+        #else
+          const float deviation_mm = junction_deviation_mm;
+        #endif
+        const float vmax_junction_sqr = (block->acceleration * deviation_mm * sin_theta_d2) / (1.0f - sin_theta_d2);
+        NOMORE(vmax_junction, SQRT(vmax_junction_sqr));
+      }
+      // Else straight line, limited only by the nominal speeds.
+
+    #else // !JUNCTION_DEVIATION
+
+      float smaller_speed_factor = prev_speed_larger ? (block->nominal_speed / previous_nominal_speed) : (previous_nominal_speed / block->nominal_speed);
+
+      // Calculate jerk depending on whether the axis is coasting in the same direction or reversing.
+      const auto axis_jerk = [](const float v_exit, const float v_entry) -> float {
+        return (v_exit > v_entry)
+            ? //                                  coasting             axis reversal
+              ( (v_entry > 0.f || v_exit < 0.f) ? (v_exit - v_entry) : max(v_exit, -v_entry) )
+            : // v_exit <= v_entry                coasting             axis reversal
+              ( (v_entry < 0.f || v_exit > 0.f) ? (v_entry - v_exit) : max(-v_exit, v_entry) );
+      };
+
+      if (single_axis != several_axes && single_axis == previous_single_axis) {
+        // Both blocks move the same one axis (a retract after a retract, a Z move after
+        // one), so every other axis is still on both sides and only this one can jerk.
+        float v_exit = previous_speed[single_axis];
+        if (prev_speed_larger) v_exit *= smaller_speed_factor;
+        const float jerk = axis_jerk(v_exit, current_speed[single_axis]),
+                    maxj = jerk_limit(single_axis, travel_junction);
+        if (jerk > maxj) vmax_junction *= maxj / jerk;
+      }
+      else {
+        // Factor to multiply the previous / current nominal velocities to get componentwise limited velocities.
+        float v_factor = 1.f;
+        uint8_t limited = 0;
+        // Now limit the jerk in all axes.
+        LOOP_XYZE(axis) {
+          // Limit an axis. We have to differentiate: coasting, reversal of an axis, full stop.
+          float v_exit = previous_speed[axis], v_entry = current_speed[axis];
+          if (prev_speed_larger) v_exit *= smaller_speed_factor;
+          if (limited) {
+            v_exit *= v_factor;
+            v_entry *= v_factor;
+          }
+
+          const float jerk = axis_jerk(v_exit, v_entry), maxj = jerk_limit(axis, travel_junction);
+          if (jerk > maxj) {
+            v_factor *= maxj / jerk;
+            ++limited;
+          }
+        }
+        if (limited) vmax_junction *= v_factor;
+      }
+
+    #endif // !JUNCTION_DEVIATION
+
+    // Now the transition velocity is known, which maximizes the shared exit / entry velocity while
+    // respecting the jerk factors, it may be possible, that applying separate safe exit / entry velocities will achieve faster prints.
+    const float vmax_junction_threshold = vmax_junction * 0.99f;
+    if (previous_safe_speed > vmax_junction_threshold && safe_speed > vmax_junction_threshold) {
+      // Not coasting. The machine will stop and start the movements anyway,
+      // better to start the segment from start.
+      SBI(block->flag, BLOCK_BIT_START_FROM_FULL_HALT);
+      vmax_junction = safe_speed;
+    }
+  }
+  else {
+    SBI(block->flag, BLOCK_BIT_START_FROM_FULL_HALT);
+    vmax_junction = safe_speed;
+  }
+
+  // Max entry speed of this block equals the max exit speed of the previous block.
+  block->max_entry_speed = vmax_junction;
+
+  // Initialize block entry speed. Compute based on deceleration to user-defined MINIMUM_PLANNER_SPEED.
+  const float v_allowable = max_allowable_speed(-block->acceleration, 0.0f, block->millimeters);
+  // If stepper ISR is disabled, this indicates buffer_segment wants to add a split block.
+  // In this case start with the max. allowed speed to avoid an interrupted first move.
+  block->entry_speed = TEST(TIMSK1, OCIE1A) ? 0.0f : min(vmax_junction, v_allowable);
+
+  // Initialize planner efficiency flags
+  // Set flag if block will always reach maximum junction speed regardless of entry/exit speeds.
+  // If a block can de/ac-celerate from nominal speed to zero within the length of the block, then
+  // the current block and next block junction speeds are guaranteed to always be at their maximum
+  // junction speeds in deceleration and acceleration, respectively. This is due to how the current
+  // block nominal speed limits both the current and next maximum junction speeds. Hence, in both
+  // the reverse and forward planners, the corresponding block junction speed will always be at the
+  // the maximum junction speed and may always be ignored for any speed reduction checks.
+  block->flag |= block->nominal_speed <= v_allowable ? BLOCK_FLAG_RECALCULATE | BLOCK_FLAG_NOMINAL_LENGTH : BLOCK_FLAG_RECALCULATE;
+
+  return safe_speed;
+}
+
+/**
+ * Planner::_buffer_line
+ *
+ * Add a new linear movement to the buffer.
+ *
+ * Leveling and kinematics should be applied ahead of calling this.
+ *
+ *  a,b,c,e     - target positions in mm or degrees
+ *  fr_mm_s     - (target) speed of the move
+ *  extruder    - target extruder
+ */
+void __forceinline Planner::_buffer_line(const float & __restrict a, const float & __restrict b, const float & __restrict c, const float & __restrict e, float fr_mm_s, const uint8_t extruder) {
+
+  // The target position of the tool in absolute steps
+  // Calculate target position in absolute steps
+  //this should be done after the wait, because otherwise a M92 code within the gcode disrupts this calculation somehow
+
+  // TODO FIXME their code always presumes LROUND, which doesn't make sense
+  // if you can have negative positions.
+  // That being said, I'm just going to rework it somewhat as the target in our firmware is always > 0 anyways.
+
+  __assume(a >= 0.0f);
+  __assume(b >= 0.0f);
+  __assume(c >= 0.0f);
+  __assume(e >= 0.0f);
+
+  const uint24 target[XYZE] = {
+    round<uint24>(a * axis_steps_per_mm[X_AXIS]),
+    round<uint24>(b * axis_steps_per_mm[Y_AXIS]),
+    round<uint24>(c * axis_steps_per_mm[Z_AXIS]),
+    round<uint24>(e * axis_steps_per_mm[E_AXIS_N])
+  };
+
+  // When changing extruders recalculate steps corresponding to the E position
+  #if ENABLED(DISTINCT_E_FACTORS)
+    if (last_extruder != extruder && axis_steps_per_mm[E_AXIS_N] != axis_steps_per_mm[E_AXIS + last_extruder]) {
+      position[E_AXIS] = LROUND(position[E_AXIS] * axis_steps_per_mm[E_AXIS_N] * steps_to_mm[E_AXIS + last_extruder]);
+      last_extruder = extruder;
+    }
+  #endif
 
   #if ENABLED(LIN_ADVANCE)
     const float mm_D_float = SQRT(sq(a - position_float[X_AXIS]) + sq(b - position_float[Y_AXIS]));
@@ -879,6 +1709,11 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
     }
   #endif
 
+  #if ENABLED(PRINTCOUNTER)
+    // Only the steps are added here; the print counter converts them to mm once a second
+    print_job_timer.incFilamentSteps(de);
+  #endif
+
   // Compute direction bit-mask for this block
   uint8_t dm = 0;
   #if CORE_IS_XY
@@ -906,24 +1741,62 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
   #endif
   if (de < 0) SBI(dm, E_AXIS);
 
-  const float esteps_float = de * volumetric_multiplier[extruder] * flow_percentage[extruder] * 0.01;
+  const float esteps_float = de * e_factor[extruder];
   const uint24 esteps = uint24(abs(esteps_float) + 0.5);
 
-  // Calculate the buffer head after we push this byte
-  const uint8_t next_buffer_head = next_block_index(block_buffer_head);
-
   // If the buffer is full: good! That means we are well ahead of the robot.
   // Rest here until there is room in the buffer.
-  while (block_buffer_tail == next_buffer_head) idle();
+  #if ENABLED(PIPELINE_PROFILING)
+    if (!has_room()) {
+      const uint32 wait_start_us = micros();
+      while (!has_room()) {
+        idle();
+        #if ENABLED(PREFETCH_LINEAR_MOVES)
+          prefetch_linear_move();
+        #endif
+      }
+      profiling::add(profiling::section::planner_wait, wait_start_us);
+    }
+    const uint32 buffer_line_start_us = micros();
+  #else
+    while (!has_room()) {
+      idle();
+      #if ENABLED(PREFETCH_LINEAR_MOVES)
+        prefetch_linear_move();
+      #endif
+    }
+  #endif
+
+  #if ENABLED(PLANNER_PROFILING)
+    const uint32 profile_start_us = micros();
+
+    const millis_t profile_ms = millis();
+    if (ELAPSED(profile_ms, profile.next_timeline_ms)) {
+      profile.next_timeline_ms = profile_ms + 1000UL;
+      if (++profile.timeline_index >= profile_t::timeline_length) profile.timeline_index = 0;
+      profile.depth_timeline[profile.timeline_index] = 0xFF;
+    }
+    const uint8_t profile_depth = movesplanned();
+    NOMORE(profile.lowest_depth, profile_depth);
+    NOMORE(profile.depth_timeline[profile.timeline_index], profile_depth);
+  #endif
 
   // Prepare to set up new block
-  block_t * __restrict block = as<block_t * __restrict>(&block_buffer[block_buffer_head]);
+  block_t * __restrict block = as<block_t * __restrict>(&block_buffer[block_queue.head()]);
 
-  // Clear all flags, including the "busy" bit
+  // Clear all flags and the block lock
   block->flag = 0;
+  block->busy = false;
+  block->updating = false;
+  #if ENABLED(PRINT_TIME_ESTIMATE)
+    block->move_ms = 0; // Not counted until its trapezoid is calculated
+  #endif
 
   // Set direction bits
   block->direction_bits = dm;
+  #if ENABLED(DIR_PORT_GROUPING)
+    block->dir_port_bits = Stepper::dir_port_bits(dm);
+  #endif
 
   // Number of steps for each axis
   // See http://www.corexy.com/theory.html
@@ -949,6 +1822,19 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
   block->steps[E_AXIS] = esteps;
   block->step_event_count = max(block->steps[X_AXIS], block->steps[Y_AXIS], block->steps[Z_AXIS], esteps);
 
+  // The one axis that moves, if only one does. Retracts, primes and Z moves between layers
+  // take the closed forms of the length, acceleration limit and junction below.
+  #if IS_CORE
+    constexpr const uint8_t single_axis = several_axes;
+  #else
+    uint8_t single_axis = several_axes;
+    {
+      uint8_t moving = 0;
+      LOOP_XYZE(i) if (block->steps[i]) { single_axis = i; ++moving; }
+      if (moving != 1) single_axis = several_axes;
+    }
+  #endif
+
   // Bail if this is a zero-length block
   if (__unlikely(block->step_event_count < MIN_STEPS_PER_SEGMENT)) return;
 
@@ -973,6 +1859,10 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
   block->active_extruder = extruder;
 #endif
 
+  #if ENABLED(DRIVER_WAKE_LEAD)
+    hold_for_drivers(*block);
+  #endif
+
   //enable active axes
   #if CORE_IS_XY
     if (block->steps[A_AXIS] || block->steps[B_AXIS]) {
@@ -1143,7 +2033,10 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
   #endif
   delta_mm[E_AXIS] = esteps_float * steps_to_mm[E_AXIS_N];
 
-  if (block->steps[X_AXIS] < MIN_STEPS_PER_SEGMENT && block->steps[Y_AXIS] < MIN_STEPS_PER_SEGMENT && block->steps[Z_AXIS] < MIN_STEPS_PER_SEGMENT) {
+  if (single_axis != several_axes) {
+    block->millimeters = FABS(delta_mm[single_axis]);
+  }
+  else if (block->steps[X_AXIS] < MIN_STEPS_PER_SEGMENT && block->steps[Y_AXIS] < MIN_STEPS_PER_SEGMENT && block->steps[Z_AXIS] < MIN_STEPS_PER_SEGMENT) {
     block->millimeters = FABS(delta_mm[E_AXIS]);
   }
   else {
@@ -1160,7 +2053,10 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
     );
   }
   __assume(block->millimeters > 0);
-  float inverse_millimeters = 1.0 / block->millimeters;  // Inverse millimeters to remove multiple divides
+  // One divide serves both inverse millimeters and the step length: 1 / (mm * steps)
+  const float inverse_mm_steps = 1.0 / (block->millimeters * block->step_event_count);
+  const float inverse_millimeters = inverse_mm_steps * block->step_event_count;  // Inverse millimeters to remove multiple divides
+  const float mm_per_step = inverse_mm_steps * sq(block->millimeters);
 
   // Calculate moves/second for this move. No divide by zero due to previous checks.
   float inverse_mm_s = fr_mm_s * inverse_millimeters;
@@ -1173,8 +2069,19 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
     // Segment time im micro seconds
     unsigned long segment_time = LROUND(1000000.0 / inverse_mm_s);
   #endif
-  #if ENABLED(SLOWDOWN)
-    if (WITHIN(moves_queued, 2, (BLOCK_BUFFER_SIZE) / 2 - 1)) {
+  #if ENABLED(SLOWDOWN) && defined(SLOWDOWN_BUFFER_MS)
+    // The emptier the buffer is of motion time, the closer the move is stretched to min_segment_time
+    if (moves_queued >= 2 && segment_time < min_segment_time) {
+      const uint32 buffered_ms = queued_move_ms();
+      if (buffered_ms < (SLOWDOWN_BUFFER_MS)) {
+        inverse_mm_s = 1000000.0 / (segment_time + LROUND(float(min_segment_time - segment_time) * float((SLOWDOWN_BUFFER_MS) - buffered_ms) * (1.0f / (SLOWDOWN_BUFFER_MS))));
+        #if defined(XY_FREQUENCY_LIMIT) || ENABLED(ULTRA_LCD)
+          segment_time = LROUND(1000000.0 / inverse_mm_s);
+        #endif
+      }
+    }
+  #elif ENABLED(SLOWDOWN)
+    if (WITHIN(moves_queued, 2, block_buffer_size() / 2 - 1)) {
       if (segment_time < min_segment_time) {
         // buffer is draining, add extra time.  The amount of time added increases if the buffer is still emptied more.
         inverse_mm_s = 1000000.0 / (segment_time + LROUND(2 * (min_segment_time - segment_time) / moves_queued));
@@ -1186,6 +2093,7 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
   #endif
 
   #if ENABLED(ULTRA_LCD)
+    block->segment_time = segment_time;
     CRITICAL_SECTION_START
       block_buffer_runtime_us += segment_time;
     CRITICAL_SECTION_END
@@ -1232,14 +2140,27 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
   #endif
 
   // Calculate and limit speed in mm/sec for each axis
-  float current_speed[NUM_AXIS], speed_factor = 1.0; // factor <1 decreases speed
+  // The largest ratio of axis speed to its limit gives the factor, so at most one divide is needed.
+  float current_speed[NUM_AXIS], speed_factor = 1.0, speed_ratio = 1.0; // factor <1 decreases speed
   LOOP_XYZE(i) {
     const float cs = FABS(current_speed[i] = delta_mm[i] * inverse_mm_s);
     #if ENABLED(DISTINCT_E_FACTORS)
-      if (i == E_AXIS) i += extruder;
+      const float ratio = cs * inverse_max_feedrate_mm_s[i == E_AXIS ? E_AXIS + extruder : i];
+    #else
+      const float ratio = cs * inverse_max_feedrate_mm_s[i];
     #endif
-    if (cs > max_feedrate_mm_s[i]) NOMORE(speed_factor, max_feedrate_mm_s[i] / cs);
+    NOLESS(speed_ratio, ratio);
   }
+  #if ENABLED(STEP_RATE_CALIBRATION)
+    // Nor faster than the stepper ISR can step it
+    NOLESS(speed_ratio, block->nominal_rate * inverse_max_step_rate);
+  #endif
+  #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+    // Nor faster than the hotend melts, for a printing move
+    if (block->steps[X_AXIS] || block->steps[Y_AXIS] || block->steps[Z_AXIS])
+      NOLESS(speed_ratio, FABS(current_speed[E_AXIS]) * volumetric_extruder_inverse_limit[extruder]);
+  #endif
+  if (speed_ratio > 1.0) speed_factor = 1.0 / speed_ratio;
 
   // Max segment time in µs.
   #ifdef XY_FREQUENCY_LIMIT
@@ -1318,8 +2239,11 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
       #define ACCEL_IDX 0
     #endif
 
-    // Limit acceleration per axis
-    if (__likely(block->step_event_count <= cutoff_long)) {
+    // Limit acceleration per axis. An axis moving alone takes every step event, so its limit is direct.
+    if (single_axis != several_axes) {
+      NOMORE(accel, max_acceleration_steps_per_s2[single_axis]);
+    }
+    else if (__likely(block->step_event_count <= cutoff_long)) {
       LIMIT_ACCEL_LONG(X_AXIS, 0);
       LIMIT_ACCEL_LONG(Y_AXIS, 0);
       LIMIT_ACCEL_LONG(Z_AXIS, 0);
@@ -1333,111 +2257,61 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
     }
   }
   block->acceleration_steps_per_s2 = accel;
-  block->acceleration = accel / steps_per_mm;
-
-  // Initial limit on the segment entry velocity
-  float vmax_junction;
-
-  /**
-   * Adapted from Průša MKS firmware
-   * https://github.com/prusa3d/Prusa-Firmware
-   *
-   * Start with a safe speed (from which the machine may halt to stop immediately).
-   */
-
-  // Exit speed limited by a jerk to full halt of a previous last segment
-  static float previous_safe_speed;
-
-  float safe_speed = block->nominal_speed;
-  uint8_t limited = 0;
-  LOOP_XYZE(i) {
-    const float jerk = FABS(current_speed[i]), maxj = max_jerk[i];
-    if (jerk > maxj) {
-      if (limited) {
-        const float mjerk = maxj * block->nominal_speed;
-        if (jerk * safe_speed > mjerk) safe_speed = mjerk / jerk;
-      }
-      else {
-        ++limited;
-        safe_speed = maxj;
-      }
+  block->acceleration_rate = int24(accel * 16777216.0 / ((F_CPU) * 0.125)); // * 8.388608
+  block->acceleration = accel * mm_per_step;
+  block->steps_per_mm = steps_per_mm;
+
+  #if ENABLED(JUNCTION_DEVIATION)
+
+    /**
+     * Direction of this segment. Moves with any XYZ motion use the XYZ direction alone,
+     * as 'millimeters' excludes E for them. E-only moves point along E.
+     */
+    float unit_vec[XYZE];
+    if (block->steps[X_AXIS] < MIN_STEPS_PER_SEGMENT && block->steps[Y_AXIS] < MIN_STEPS_PER_SEGMENT && block->steps[Z_AXIS] < MIN_STEPS_PER_SEGMENT) {
+      unit_vec[X_AXIS] = unit_vec[Y_AXIS] = unit_vec[Z_AXIS] = 0.0f;
+      unit_vec[E_AXIS] = delta_mm[E_AXIS] < 0.0f ? -1.0f : 1.0f;
     }
-  }
-
-  if (moves_queued > 1 && previous_nominal_speed > 0.0001) {
-    // Estimate a maximum velocity allowed at a joint of two successive segments.
-    // If this maximum velocity allowed is lower than the minimum of the entry / exit safe velocities,
-    // then the machine is not coasting anymore and the safe entry / exit velocities shall be used.
-
-    // The junction velocity will be shared between successive segments. Limit the junction velocity to their minimum.
-    bool prev_speed_larger = previous_nominal_speed > block->nominal_speed;
-    float smaller_speed_factor = prev_speed_larger ? (block->nominal_speed / previous_nominal_speed) : (previous_nominal_speed / block->nominal_speed);
-    // Pick the smaller of the nominal speeds. Higher speed shall not be achieved at the junction during coasting.
-    vmax_junction = prev_speed_larger ? block->nominal_speed : previous_nominal_speed;
-    // Factor to multiply the previous / current nominal velocities to get componentwise limited velocities.
-    float v_factor = 1.f;
-    limited = 0;
-    // Now limit the jerk in all axes.
-    LOOP_XYZE(axis) {
-      // Limit an axis. We have to differentiate: coasting, reversal of an axis, full stop.
-      float v_exit = previous_speed[axis], v_entry = current_speed[axis];
-      if (prev_speed_larger) v_exit *= smaller_speed_factor;
-      if (limited) {
-        v_exit *= v_factor;
-        v_entry *= v_factor;
-      }
-
-      // Calculate jerk depending on whether the axis is coasting in the same direction or reversing.
-      const float jerk = (v_exit > v_entry)
-          ? //                                  coasting             axis reversal
-            ( (v_entry > 0.f || v_exit < 0.f) ? (v_exit - v_entry) : max(v_exit, -v_entry) )
-          : // v_exit <= v_entry                coasting             axis reversal
-            ( (v_entry < 0.f || v_exit > 0.f) ? (v_entry - v_exit) : max(-v_exit, v_entry) );
-
-      if (jerk > max_jerk[axis]) {
-        v_factor *= max_jerk[axis] / jerk;
-        ++limited;
-      }
-    }
-    if (limited) vmax_junction *= v_factor;
-    // Now the transition velocity is known, which maximizes the shared exit / entry velocity while
-    // respecting the jerk factors, it may be possible, that applying separate safe exit / entry velocities will achieve faster prints.
-    const float vmax_junction_threshold = vmax_junction * 0.99f;
-    if (previous_safe_speed > vmax_junction_threshold && safe_speed > vmax_junction_threshold) {
-      // Not coasting. The machine will stop and start the movements anyway,
-      // better to start the segment from start.
-      SBI(block->flag, BLOCK_BIT_START_FROM_FULL_HALT);
-      vmax_junction = safe_speed;
+    else {
+      #if CORE_IS_XY
+        unit_vec[X_AXIS] = delta_mm[X_HEAD] * inverse_millimeters;
+        unit_vec[Y_AXIS] = delta_mm[Y_HEAD] * inverse_millimeters;
+        unit_vec[Z_AXIS] = delta_mm[Z_AXIS] * inverse_millimeters;
+      #elif CORE_IS_XZ
+        unit_vec[X_AXIS] = delta_mm[X_HEAD] * inverse_millimeters;
+        unit_vec[Y_AXIS] = delta_mm[Y_AXIS] * inverse_millimeters;
+        unit_vec[Z_AXIS] = delta_mm[Z_HEAD] * inverse_millimeters;
+      #elif CORE_IS_YZ
+        unit_vec[X_AXIS] = delta_mm[X_AXIS] * inverse_millimeters;
+        unit_vec[Y_AXIS] = delta_mm[Y_HEAD] * inverse_millimeters;
+        unit_vec[Z_AXIS] = delta_mm[Z_HEAD] * inverse_millimeters;
+      #else
+        unit_vec[X_AXIS] = delta_mm[X_AXIS] * inverse_millimeters;
+        unit_vec[Y_AXIS] = delta_mm[Y_AXIS] * inverse_millimeters;
+        unit_vec[Z_AXIS] = delta_mm[Z_AXIS] * inverse_millimeters;
+      #endif
+      unit_vec[E_AXIS] = 0.0f;
     }
-  }
-  else {
-    SBI(block->flag, BLOCK_BIT_START_FROM_FULL_HALT);
-    vmax_junction = safe_speed;
-  }
-
-  // Max entry speed of this block equals the max exit speed of the previous block.
-  block->max_entry_speed = vmax_junction;
 
-  // Initialize block entry speed. Compute based on deceleration to user-defined MINIMUM_PLANNER_SPEED.
-  const float v_allowable = max_allowable_speed(-block->acceleration, 0.0f, block->millimeters);
-  // If stepper ISR is disabled, this indicates buffer_segment wants to add a split block.
-  // In this case start with the max. allowed speed to avoid an interrupted first move.
-  block->entry_speed = TEST(TIMSK1, OCIE1A) ? 0.0f : min(vmax_junction, v_allowable);
+  #endif
 
-  // Initialize planner efficiency flags
-  // Set flag if block will always reach maximum junction speed regardless of entry/exit speeds.
-  // If a block can de/ac-celerate from nominal speed to zero within the length of the block, then
-  // the current block and next block junction speeds are guaranteed to always be at their maximum
-  // junction speeds in deceleration and acceleration, respectively. This is due to how the current
-  // block nominal speed limits both the current and next maximum junction speeds. Hence, in both
-  // the reverse and forward planners, the corresponding block junction speed will always be at the
-  // the maximum junction speed and may always be ignored for any speed reduction checks.
-  block->flag |= block->nominal_speed <= v_allowable ? BLOCK_FLAG_RECALCULATE | BLOCK_FLAG_NOMINAL_LENGTH : BLOCK_FLAG_RECALCULATE;
+  const float safe_speed = plan_junction(block, current_speed,
+    #if ENABLED(JUNCTION_DEVIATION)
+      unit_vec,
+    #endif
+    moves_queued,
+    single_axis
+  );
 
   // Update previous path unit_vector and nominal speed
   COPY(previous_speed, current_speed);
   previous_nominal_speed = block->nominal_speed;
   previous_safe_speed = safe_speed;
+  previous_travel = !block->steps[E_AXIS];
+  previous_single_axis = single_axis;
+  #if ENABLED(JUNCTION_DEVIATION)
+    COPY(previous_unit_vec, unit_vec);
+  #endif
 
   #if ENABLED(LIN_ADVANCE)
 
@@ -1456,22 +2330,28 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
     //                                                   The math is good, but we must avoid retract moves with advance!
     // de_float > 0.0                                  : Extruder is running forward (e.g., for "Wipe while retracting" (Slic3r) or "Combing" (Cura) moves)
     //
-    block->use_advance_lead =  esteps
-                            && (block->steps[X_AXIS] || block->steps[Y_AXIS])
-                            && extruder_advance_k
-                            && (uint32)esteps != block->step_event_count
-                            && de_float > 0.0;
-    if (block->use_advance_lead)
+    if (  esteps
+       && (block->steps[X_AXIS] || block->steps[Y_AXIS])
+       && extruder_advance_k
+       && (uint32)esteps != block->step_event_count
+       && de_float > 0.0) {
+      SBI(block->flag, BLOCK_BIT_USE_ADVANCE_LEAD);
       block->abs_adv_steps_multiplier8 = LROUND(
         extruder_advance_k
         * (UNEAR_ZERO(advance_ed_ratio) ? de_float / mm_D_float : advance_ed_ratio) // Use the fixed ratio, if set
         * (block->nominal_speed / (float)block->nominal_rate)
         * axis_steps_per_mm[E_AXIS_N] * 256.0
       );
+    }
   #endif // LIN_ADVANCE
 
+  #if ENABLED(MOTION_SYNC_EVENTS)
+    block->sync_events = sync_events_unplanned;
+    sync_events_unplanned = 0;
+  #endif
+
   // Move buffer head
-  block_buffer_head = next_buffer_head;
+  block_queue.push();
 
   // Update the position (only when a move was queued)
   COPY(position, target);
@@ -1482,12 +2362,470 @@ void __forceinline Planner::_buffer_line(const float & __restrict a, const float
     position_float[E_AXIS] = e;
   #endif
 
+  #if ENABLED(PLANNER_PROFILING)
+    const uint32 recalculate_start_us = micros();
+  #endif
+
   recalculate();
 
+  #if ENABLED(PLANNER_PROFILING)
+    const uint32 profile_end_us = micros();
+    const uint32 recalculate_us = profile_end_us - recalculate_start_us;
+    uint8 bin = 0;
+    for (uint32 t = recalculate_us >> 6; t && bin < profile_t::recalculate_bins - 1; t >>= 1) ++bin;
+    if (profile.recalculate_bin[bin] != type_trait<uint16>::max) ++profile.recalculate_bin[bin];
+    NOLESS(profile.recalculate_max_us, recalculate_us);
+    profile.buffer_line_us += profile_end_us - profile_start_us;
+    ++profile.segments;
+  #endif
+
+  #if ENABLED(PIPELINE_PROFILING)
+    profiling::add(profiling::section::buffer_line, buffer_line_start_us);
+  #endif
+
   stepper.wake_up();
 
 } // buffer_line()
 
+#if ENABLED(ARC_BLOCKS)
+
+/**
+ * Planner::_buffer_arc
+ *
+ * Add an arc to the buffer as a single block. The stepper ISR turns a point around
+ * the center for X and Y (see arc_t), while Z and E step along it as in a line.
+ * Everything that can turn the arc down is checked before anything changes.
+ *
+ *  target   - x,y,z,e target position in mm
+ *  center   - x,y of the center of the arc in mm
+ *  angle    - radians turned about the center, positive counterclockwise
+ *  fr_mm_s  - (target) speed of the move
+ *  extruder - target extruder
+ */
+bool Planner::_buffer_arc(const float (&target_mm)[XYZE], const float (&center)[2], const float &angle, float fr_mm_s, const uint8_t extruder) {
+
+  // The circle is traced in steps, which makes it round only with the same steps per mm on X and Y
+  if (axis_steps_per_mm[X_AXIS] != axis_steps_per_mm[Y_AXIS]) return false;
+
+  const uint24 target[XYZE] = {
+    round<uint24>(target_mm[X_AXIS] * axis_steps_per_mm[X_AXIS]),
+    round<uint24>(target_mm[Y_AXIS] * axis_steps_per_mm[Y_AXIS]),
+    round<uint24>(target_mm[Z_AXIS] * axis_steps_per_mm[Z_AXIS]),
+    round<uint24>(target_mm[E_AXIS] * axis_steps_per_mm[E_AXIS_N])
+  };
+
+  // The start and the end from the center, in steps
+  const float center_x = center[X_AXIS] * axis_steps_per_mm[X_AXIS],
+              center_y = center[Y_AXIS] * axis_steps_per_mm[Y_AXIS],
+              start_x = float(position[X_AXIS]) - center_x,
+              start_y = float(position[Y_AXIS]) - center_y,
+              end_x = float(target[X_AXIS]) - center_x,
+              end_y = float(target[Y_AXIS]) - center_y,
+              radius = HYPOT(start_x, start_y);
+
+  // The ISR steps to the target after the last step event, so it has to be on the circle
+  if (radius < 2.0f || FABS(HYPOT(end_x, end_y) - radius) > 1.0f) return false;
+
+  // The least shift that keeps the point, radius plus its quarter step of ellipse, under 2^shift steps
+  uint8 shift = 1;
+  while (float(1_u32 << shift) < radius + 1.0f) ++shift;
+  if (shift > 22) return false;
+
+  const float events_float = FABS(angle) * float(1_u32 << shift);
+  if (events_float > 16777215.0f) return false;
+  const uint24 events = uint24(LROUND(events_float));
+  if (events < MIN_STEPS_PER_SEGMENT) return false;
+
+  const int24 dc = target[Z_AXIS] - position[Z_AXIS];
+  int24 de = target[E_AXIS] - position[E_AXIS];
+
+  // Z and E are stepped by Bresenham against the step events, so they can't have more steps
+  const float flow = e_factor[extruder];
+  if (uint24(uabs(dc)) > events || uint24(uabs(de) * flow + 0.5) > events) return false;
+
+  // DRYRUN, and an extrusion refused as cold or too long, move without E as in _buffer_line()
+  if (DEBUGGING(DRYRUN)) de = 0;
+  #if ENABLED(PREVENT_COLD_EXTRUSION)
+    if (de) {
+      if (Temperature::is_coldextrude()) {
+        de = 0;
+        SERIAL_ECHO_START();
+        SERIAL_ECHOLNPGM(MSG_ERR_COLD_EXTRUDE_STOP);
+      }
+      #if ENABLED(PREVENT_LENGTHY_EXTRUDE)
+        else if (abs(de) > (int32)axis_steps_per_mm[E_AXIS_N] * (EXTRUDE_MAXLENGTH)) {
+          de = 0;
+          SERIAL_ECHO_START();
+          SERIAL_ECHOLNPGM(MSG_ERR_LONG_EXTRUDE_STOP);
+        }
+      #endif
+    }
+  #endif
+
+  #if ENABLED(PRINTCOUNTER)
+    print_job_timer.incFilamentSteps(de);
+  #endif
+
+  const bool clockwise = angle < 0.0f;
+
+  // X and Y start out along the tangent; the stepper turns them around as the arc goes on
+  uint8_t dm = 0;
+  if (clockwise ? start_y < 0.0f : start_y > 0.0f) SBI(dm, X_AXIS);
+  if (clockwise ? start_x > 0.0f : start_x < 0.0f) SBI(dm, Y_AXIS);
+  if (dc < 0) SBI(dm, Z_AXIS);
+  if (de < 0) SBI(dm, E_AXIS);
+
+  const float esteps_float = de * flow;
+  const uint24 esteps = uint24(abs(esteps_float) + 0.5);
+
+  // If the buffer is full: good! That means we are well ahead of the robot.
+  // Rest here until there is room in the buffer.
+  while (!has_room()) {
+    idle();
+    #if ENABLED(PREFETCH_LINEAR_MOVES)
+      prefetch_linear_move();
+    #endif
+  }
+
+  // Prepare to set up new block
+  block_t * __restrict block = as<block_t * __restrict>(&block_buffer[block_queue.head()]);
+
+  // Clear all flags and the block lock
+  block->flag = BLOCK_FLAG_ARC;
+  block->busy = false;
+  block->updating = false;
+  #if ENABLED(PRINT_TIME_ESTIMATE)
+    block->move_ms = 0; // Not counted until its trapezoid is calculated
+  #endif
+
+  block->direction_bits = dm;
+  #if ENABLED(DIR_PORT_GROUPING)
+    block->dir_port_bits = Stepper::dir_port_bits(dm);
+  #endif
+
+  // The arc traces X and Y, so their counts only mark them as moving
+  block->steps[X_AXIS] = block->steps[Y_AXIS] = events;
+  block->steps[Z_AXIS] = uabs(dc);
+  block->steps[E_AXIS] = esteps;
+  block->step_event_count = events;
+
+  const float one = float(1_u32 << (30 - shift));
+  block->arc.x = LROUND(start_x * one);
+  block->arc.y = LROUND(start_y * one);
+  block->arc.end_x = target[X_AXIS];
+  block->arc.end_y = target[Y_AXIS];
+  block->arc.shift = shift;
+  block->arc.clockwise = clockwise;
+
+  #if FAN_COUNT > 0
+    for (uint8_t i = 0; i < FAN_COUNT; i++) block->fan_speed[i] = fanSpeeds[i];
+  #endif
+
+  #if ENABLED(BARICUDA)
+    block->valve_pressure = baricuda_valve_pressure;
+    block->e_to_p_pressure = baricuda_e_to_p_pressure;
+  #endif
+
+  #if ENABLED(DRIVER_WAKE_LEAD)
+    hold_for_drivers(*block);
+  #endif
+
+  enable_X();
+  enable_Y();
+  #if DISABLED(Z_LATE_ENABLE)
+    if (dc) enable_Z();
+  #endif
+  if (esteps) enable_E0();
+
+  if (esteps && fr_mm_s < min_feedrate_mm_s)
+  {
+    fr_mm_s = min_feedrate_mm_s;
+  }
+  else if (!esteps && fr_mm_s < min_travel_feedrate_mm_s)
+  {
+    fr_mm_s = min_travel_feedrate_mm_s;
+  }
+
+  // The length along the arc, and the share of it each axis moves
+  const float radius_mm = radius * steps_to_mm[X_AXIS],
+              arc_mm = FABS(angle) * radius_mm,
+              delta_z = dc * steps_to_mm[Z_AXIS],
+              delta_e = esteps_float * steps_to_mm[E_AXIS_N];
+  block->millimeters = HYPOT(arc_mm, delta_z);
+  const float inverse_millimeters = 1.0f / block->millimeters,
+              xy_ratio = arc_mm * inverse_millimeters,
+              z_ratio = delta_z * inverse_millimeters,
+              e_ratio = delta_e * inverse_millimeters;
+
+  const float inverse_mm_s = fr_mm_s * inverse_millimeters;
+
+  const uint8_t moves_queued = movesplanned();
+
+  #if ENABLED(ULTRA_LCD)
+    block->segment_time = LROUND(1000000.0 / inverse_mm_s);
+    CRITICAL_SECTION_START
+      block_buffer_runtime_us += block->segment_time;
+    CRITICAL_SECTION_END
+  #endif
+
+  block->nominal_speed = block->millimeters * inverse_mm_s; // (mm/sec) Always > 0
+  block->nominal_rate = CEIL(events * inverse_mm_s); // (step/sec) Always > 0
+
+  // The acceleration along the arc, within each axis' share of it. X and Y take turns
+  // carrying the XY part, so it's held to the lower of their limits.
+  float accel_mm = esteps ? acceleration : travel_acceleration;
+  NOMORE(accel_mm, float(min(max_acceleration_mm_per_s2[X_AXIS], max_acceleration_mm_per_s2[Y_AXIS])) / xy_ratio);
+  if (dc) NOMORE(accel_mm, float(max_acceleration_mm_per_s2[Z_AXIS]) / FABS(z_ratio));
+  if (esteps) NOMORE(accel_mm, float(max_acceleration_mm_per_s2[E_AXIS_N]) / FABS(e_ratio));
+
+  // Limit the speed by each axis' share of it, as the acceleration, and keep the
+  // centripetal acceleration v^2 / r within the acceleration too
+  float speed_ratio = 1.0f;
+  NOLESS(speed_ratio, block->nominal_speed * xy_ratio * max(inverse_max_feedrate_mm_s[X_AXIS], inverse_max_feedrate_mm_s[Y_AXIS]));
+  NOLESS(speed_ratio, block->nominal_speed * FABS(z_ratio) * inverse_max_feedrate_mm_s[Z_AXIS]);
+  NOLESS(speed_ratio, block->nominal_speed * FABS(e_ratio) * inverse_max_feedrate_mm_s[E_AXIS_N]);
+  NOLESS(speed_ratio, block->nominal_speed * xy_ratio / SQRT(accel_mm * radius_mm));
+  #if ENABLED(STEP_RATE_CALIBRATION)
+    NOLESS(speed_ratio, block->nominal_rate * inverse_max_step_rate);
+  #endif
+  if (speed_ratio > 1.0f) {
+    const float speed_factor = 1.0f / speed_ratio;
+    block->nominal_speed *= speed_factor;
+    block->nominal_rate *= speed_factor;
+  }
+
+  const float steps_per_mm = events * inverse_millimeters;
+  const uint32 accel = CEIL(accel_mm * steps_per_mm);
+  block->acceleration_steps_per_s2 = accel;
+  block->acceleration_rate = int24(accel * 16777216.0 / ((F_CPU) * 0.125)); // * 8.388608
+  block->acceleration = accel / steps_per_mm;
+  block->steps_per_mm = steps_per_mm;
+
+  // The axis speeds where the arc starts and where it ends, along the tangents there
+  const float xy_speed = block->nominal_speed * xy_ratio,
+              turn = (clockwise ? -xy_speed : xy_speed) / radius;
+  const float entry_speed[NUM_AXIS] = { -start_y * turn, start_x * turn, block->nominal_speed * z_ratio, block->nominal_speed * e_ratio },
+              exit_speed[NUM_AXIS] = { -end_y * turn, end_x * turn, entry_speed[Z_AXIS], entry_speed[E_AXIS] };
+
+  #if ENABLED(JUNCTION_DEVIATION)
+    // As for a line, the direction is that of XYZ alone
+    const float inverse_speed = 1.0f / block->nominal_speed;
+    float entry_unit_vec[XYZE], exit_unit_vec[XYZE];
+    LOOP_XYZ(i) {
+      entry_unit_vec[i] = entry_speed[i] * inverse_speed;
+      exit_unit_vec[i] = exit_speed[i] * inverse_speed;
+    }
+    entry_unit_vec[E_AXIS] = exit_unit_vec[E_AXIS] = 0.0f;
+  #endif
+
+  plan_junction(block, entry_speed,
+    #if ENABLED(JUNCTION_DEVIATION)
+      entry_unit_vec,
+    #endif
+    moves_queued,
+    several_axes
+  );
+
+  // The next block joins the end of the arc
+  COPY(previous_speed, exit_speed);
+  previous_nominal_speed = block->nominal_speed;
+  previous_travel = !block->steps[E_AXIS];
+  previous_single_axis = several_axes;
+  previous_safe_speed = halt_speed(exit_speed, block->nominal_speed, previous_travel);
+  #if ENABLED(JUNCTION_DEVIATION)
+    COPY(previous_unit_vec, exit_unit_vec);
+  #endif
+
+  #if ENABLED(LIN_ADVANCE)
+    // As for a line, with the extrusion taken over the length of the arc
+    const float de_float = de ? target_mm[E_AXIS] - position_float[E_AXIS] : 0.0f;
+    if (esteps && extruder_advance_k && (uint32)esteps != block->step_event_count && de_float > 0.0) {
+      SBI(block->flag, BLOCK_BIT_USE_ADVANCE_LEAD);
+      block->abs_adv_steps_multiplier8 = LROUND(
+        extruder_advance_k
+        * (UNEAR_ZERO(advance_ed_ratio) ? de_float / arc_mm : advance_ed_ratio) // Use the fixed ratio, if set
+        * (block->nominal_speed / (float)block->nominal_rate)
+        * axis_steps_per_mm[E_AXIS_N] * 256.0
+      );
+    }
+  #endif
+
+  #if ENABLED(MOTION_SYNC_EVENTS)
+    block->sync_events = sync_events_unplanned;
+    sync_events_unplanned = 0;
+  #endif
+
+  // Move buffer head
+  block_queue.push();
+
+  COPY(position, target);
+  #if ENABLED(LIN_ADVANCE)
+    COPY(position_float, target_mm);
+  #endif
+
+  recalculate();
+
+  stepper.wake_up();
+
+  return true;
+}
+
+#endif // ARC_BLOCKS
+
+#if ENABLED(HOST_PLANNED_BLOCKS)
+
+/**
+ * Planner::buffer_host_block
+ *
+ * Add a block planned by the host. The steps and the trapezoid go into the buffer as sent,
+ * and the planner fills in only what the stepper derives from them. The block is flagged so
+ * recalculate() never replans it: it starts from a full halt with its nominal length, which
+ * stops both passes, and its trapezoid is skipped. The next line is planned from a stop.
+ *
+ *  host     - the block as sent
+ *  extruder - target extruder
+ */
+bool Planner::buffer_host_block(const host_block_t & __restrict host, const uint8_t extruder) {
+  uint24 steps[NUM_AXIS];
+  COPY(steps, host.steps);
+
+  const uint24 step_event_count = max(steps[X_AXIS], steps[Y_AXIS], steps[Z_AXIS], steps[E_AXIS]);
+
+  // The trapezoid has to fit the steps, and the stepper can't take rates under its minimum
+  if (step_event_count < MIN_STEPS_PER_SEGMENT
+    || host.accelerate_until > host.decelerate_after || host.decelerate_after > step_event_count
+    || host.initial_rate < MINIMAL_STEP_RATE || host.final_rate < MINIMAL_STEP_RATE
+    || host.nominal_rate < host.initial_rate || host.nominal_rate < host.final_rate
+    || (!host.acceleration_steps_per_s2 && (host.accelerate_until || host.decelerate_after != step_event_count))
+  ) return false;
+
+  // The move lengths before DRYRUN or a cold hotend take E out, which the positions follow anyway
+  const float delta_mm[NUM_AXIS] = {
+    steps[X_AXIS] * steps_to_mm[X_AXIS],
+    steps[Y_AXIS] * steps_to_mm[Y_AXIS],
+    steps[Z_AXIS] * steps_to_mm[Z_AXIS],
+    steps[E_AXIS] * steps_to_mm[E_AXIS_N]
+  };
+
+  if (steps[E_AXIS]) {
+    if (DEBUGGING(DRYRUN)) steps[E_AXIS] = 0;
+    #if ENABLED(PREVENT_COLD_EXTRUSION)
+      else if (Temperature::is_coldextrude()) {
+        steps[E_AXIS] = 0;
+        SERIAL_ECHO_START();
+        SERIAL_ECHOLNPGM(MSG_ERR_COLD_EXTRUDE_STOP);
+      }
+    #endif
+  }
+
+  #if ENABLED(PRINTCOUNTER)
+    print_job_timer.incFilamentSteps(TEST(host.direction_bits, E_AXIS) ? -int32(steps[E_AXIS]) : int32(steps[E_AXIS]));
+  #endif
+
+  // Prepare to set up new block
+  const uint8_t index = block_queue.head();
+  block_t * __restrict block = as<block_t * __restrict>(&block_buffer[index]);
+
+  block->flag = BLOCK_FLAG_HOST_PLANNED | BLOCK_FLAG_START_FROM_FULL_HALT | BLOCK_FLAG_NOMINAL_LENGTH;
+  block->busy = false;
+  block->updating = false;
+  #if ENABLED(PRINT_TIME_ESTIMATE)
+    block->move_ms = 0; // Counted by set_trapezoid()
+  #endif
+
+  block->direction_bits = host.direction_bits;
+  #if ENABLED(DIR_PORT_GROUPING)
+    block->dir_port_bits = Stepper::dir_port_bits(host.direction_bits);
+  #endif
+
+  COPY(block->steps, steps);
+  block->step_event_count = step_event_count;
+
+  #if FAN_COUNT > 0
+    for (uint8_t i = 0; i < FAN_COUNT; i++) block->fan_speed[i] = fanSpeeds[i];
+  #endif
+
+  #if ENABLED(BARICUDA)
+    block->valve_pressure = baricuda_valve_pressure;
+    block->e_to_p_pressure = baricuda_e_to_p_pressure;
+  #endif
+
+  #if EXTRUDERS > 1
+    block->active_extruder = extruder;
+  #else
+    UNUSED(extruder);
+  #endif
+
+  #if ENABLED(DRIVER_WAKE_LEAD)
+    hold_for_drivers(*block);
+  #endif
+
+  if (steps[X_AXIS]) enable_X();
+  if (steps[Y_AXIS]) enable_Y();
+  #if DISABLED(Z_LATE_ENABLE)
+    if (steps[Z_AXIS]) enable_Z();
+  #endif
+  if (steps[E_AXIS]) enable_E0();
+
+  // The planner's own fields, in mm, for the code that reads them without replanning
+  const float xyz_mm = SQRT(sq(delta_mm[X_AXIS]) + sq(delta_mm[Y_AXIS]) + sq(delta_mm[Z_AXIS]));
+  block->millimeters = (xyz_mm > 0.0f) ? xyz_mm : delta_mm[E_AXIS];
+  const float steps_per_mm = step_event_count / block->millimeters,
+              mm_per_step = 1.0f / steps_per_mm;
+  block->steps_per_mm = steps_per_mm;
+  block->nominal_speed = host.nominal_rate * mm_per_step;
+  block->entry_speed = block->max_entry_speed = host.initial_rate * mm_per_step;
+  block->acceleration = host.acceleration_steps_per_s2 * mm_per_step;
+
+  #if ENABLED(ULTRA_LCD)
+    block->segment_time = LROUND(1000000.0f * step_event_count / host.nominal_rate);
+    CRITICAL_SECTION_START
+      block_buffer_runtime_us += block->segment_time;
+    CRITICAL_SECTION_END
+  #endif
+
+  const uint32 accel = host.acceleration_steps_per_s2;
+  block->nominal_rate = host.nominal_rate;
+  block->acceleration_steps_per_s2 = accel;
+  block->acceleration_rate = int24(accel * 16777216.0 / ((F_CPU) * 0.125)); // * 8.388608
+  set_trapezoid(block, host.initial_rate, host.final_rate, host.accelerate_until, host.decelerate_after - host.accelerate_until);
+
+  #if ENABLED(LIN_ADVANCE)
+    if (steps[E_AXIS] && host.abs_adv_steps_multiplier8) {
+      SBI(block->flag, BLOCK_BIT_USE_ADVANCE_LEAD);
+      block->abs_adv_steps_multiplier8 = host.abs_adv_steps_multiplier8;
+    }
+  #endif
+
+  #if ENABLED(MOTION_SYNC_EVENTS)
+    block->sync_events = sync_events_unplanned;
+    sync_events_unplanned = 0;
+  #endif
+
+  // Move buffer head. Nothing before the block is replanned from here on.
+  block_queue.push();
+  block_buffer_planned = index;
+
+  LOOP_XYZE(i) {
+    const bool backwards = TEST(host.direction_bits, i);
+    position[i] += backwards ? -int24(host.steps[i]) : int24(host.steps[i]);
+    #if ENABLED(LIN_ADVANCE)
+      position_float[i] += backwards ? -delta_mm[i] : delta_mm[i];
+    #endif
+  }
+
+  // The host planned this block's exit, so the next line starts from a stop
+  previous_nominal_speed = 0.0;
+  ZERO(previous_speed);
+  previous_single_axis = several_axes;
+
+  stepper.wake_up();
+
+  return true;
+}
+
+#endif // HOST_PLANNED_BLOCKS
+
 /**
  * Directly set the planner XYZ position (and stepper positions)
  * converting mm (or angles for SCARA) into steps.
@@ -1536,8 +2874,10 @@ void __forceinline __flatten Planner::set_position_mm_kinematic(const float posi
  * Sync from the stepper positions. (e.g., after an interrupted move)
  */
 void __forceinline __flatten Planner::sync_from_steppers() {
+  int24 steps[NUM_AXIS];
+  stepper.positions(steps);
   LOOP_XYZE(i) {
-    position[i] = stepper.position((AxisEnum)i);
+    position[i] = steps[i];
     #if ENABLED(LIN_ADVANCE)
       position_float[i] = position[i] * steps_to_mm[i
         #if ENABLED(DISTINCT_E_FACTORS)
@@ -1566,7 +2906,24 @@ void __forceinline __flatten Planner::set_position_mm(const AxisEnum axis, const
   previous_speed[axis] = 0.0;
 }
 
-// Recalculate the steps/s^2 acceleration rates, based on the mm/s^2
+#if ENABLED(FWRETRACT_LOOKAHEAD)
+
+  void __forceinline __flatten Planner::shift_position_mm(const AxisEnum axis, const float & __restrict distance) {
+    #if ENABLED(DISTINCT_E_FACTORS)
+      const uint8_t axis_index = axis + (axis == E_AXIS ? active_extruder : 0);
+    #else
+      const uint8_t axis_index = axis;
+    #endif
+    position[axis] += LROUND(distance * axis_steps_per_mm[axis_index]);
+    #if ENABLED(LIN_ADVANCE)
+      position_float[axis] += distance;
+    #endif
+  }
+
+#endif
+
+// Recalculate the steps/s^2 acceleration rates, based on the mm/s^2,
+// and the cached reciprocals of the feedrate limits
 void __forceinline __flatten Planner::reset_acceleration_rates() {
   #if ENABLED(DISTINCT_E_FACTORS)
     #define HIGHEST_CONDITION (i < E_AXIS || i == E_AXIS + active_extruder)
@@ -1576,6 +2933,7 @@ void __forceinline __flatten Planner::reset_acceleration_rates() {
   uint32 highest_rate = 1;
   LOOP_XYZE_N(i) {
     max_acceleration_steps_per_s2[i] = max_acceleration_mm_per_s2[i] * axis_steps_per_mm[i];
+    inverse_max_feedrate_mm_s[i] = 1.0 / max_feedrate_mm_s[i];
     if (HIGHEST_CONDITION) NOLESS(highest_rate, max_acceleration_steps_per_s2[i]);
   }
   cutoff_long = 4294967295UL / highest_rate;
@@ -1598,3 +2956,51 @@ void __forceinline Planner::refresh_positioning() {
   }
 
 #endif
+
+#if ENABLED(PLANNER_PROFILING)
+
+  void Planner::reset_profile() {
+    memset(&profile, 0, sizeof(profile));
+    profile.lowest_depth = 0xFF;
+    memset(profile.depth_timeline, 0xFF, sizeof(profile.depth_timeline));
+    profile.start_ms = millis();
+    profile.next_timeline_ms = profile.start_ms + 1000UL;
+  }
+
+  void Planner::report_profile() {
+    const millis_t elapsed_ms = millis() - profile.start_ms;
+
+    SERIAL_ECHO_START();
+    SERIAL_ECHOPAIR("Planner segments:", profile.segments);
+    SERIAL_ECHOPAIR(" per_s:", elapsed_ms ? profile.segments * 1000.0f / elapsed_ms : 0.0f);
+    SERIAL_ECHOPAIR(" avg_us:", profile.segments ? profile.buffer_line_us / profile.segments : 0UL);
+    SERIAL_ECHOLNPAIR(" lowest_depth:", profile.lowest_depth == 0xFF ? 0 : profile.lowest_depth);
+
+    SERIAL_ECHO_START();
+    SERIAL_ECHOPGM("Recalculate us");
+    for (uint8 i = 0; i < profile_t::recalculate_bins; ++i) {
+      if (i < profile_t::recalculate_bins - 1)
+        SERIAL_ECHOPAIR(" <", 64UL << i);
+      else
+        SERIAL_ECHOPAIR(" >=", 64UL << (i - 1));
+      SERIAL_ECHOPAIR(":", profile.recalculate_bin[i]);
+    }
+    SERIAL_ECHOLNPAIR(" max:", profile.recalculate_max_us);
+
+    // Oldest second first. Seconds without any new block are shown as '-'.
+    SERIAL_ECHO_START();
+    SERIAL_ECHOPGM("Depth per second");
+    for (uint8 i = 1; i <= profile_t::timeline_length; ++i) {
+      uint8 index = profile.timeline_index + i;
+      if (index >= profile_t::timeline_length) index -= profile_t::timeline_length;
+      const uint8 depth = profile.depth_timeline[index];
+      SERIAL_CHAR(' ');
+      if (depth == 0xFF)
+        SERIAL_CHAR('-');
+      else
+        SERIAL_ECHO(int(depth));
+    }
+    SERIAL_EOL();
+  }
+
+#endif
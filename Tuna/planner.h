@@ -51,21 +51,87 @@ enum BlockFlagBit : uint8_t {
   // Start from a halt at the start of this block, respecting the maximum allowed jerk.
   BLOCK_BIT_START_FROM_FULL_HALT,
 
-  // The block is busy
-  BLOCK_BIT_BUSY,
-
-  // The Block is an arc block
+  // The block is an arc, traced by the stepper ISR (ARC_BLOCKS)
   BLOCK_BIT_ARC,
+
+  // The block uses LIN_ADVANCE extruder lead
+  BLOCK_BIT_USE_ADVANCE_LEAD,
+
+  // The trapezoid came from the host (HOST_PLANNED_BLOCKS); recalculate() leaves it alone
+  BLOCK_BIT_HOST_PLANNED,
 };
 
 enum BlockFlag : uint8_t {
   BLOCK_FLAG_RECALCULATE          = _BV(BLOCK_BIT_RECALCULATE),
   BLOCK_FLAG_NOMINAL_LENGTH       = _BV(BLOCK_BIT_NOMINAL_LENGTH),
   BLOCK_FLAG_START_FROM_FULL_HALT = _BV(BLOCK_BIT_START_FROM_FULL_HALT),
-  BLOCK_FLAG_BUSY                 = _BV(BLOCK_BIT_BUSY),
-  BLOCK_FLAG_ARC                  = _BV(BLOCK_BIT_ARC)
+  BLOCK_FLAG_ARC                  = _BV(BLOCK_BIT_ARC),
+  BLOCK_FLAG_USE_ADVANCE_LEAD     = _BV(BLOCK_BIT_USE_ADVANCE_LEAD),
+  BLOCK_FLAG_HOST_PLANNED         = _BV(BLOCK_BIT_HOST_PLANNED)
 };
 
+/**
+ * Multi-stepping
+ *
+ * Above MULTISTEP_RATE steps/s the stepper ISR takes 2, then 4, then 8 steps per interrupt
+ * (a step shift of 1 to MAX_STEP_SHIFT). The planner works out where each ramp of a block
+ * crosses those rates, so the ISR only compares its step counter against the next crossing.
+ * A ramp drops back to fewer steps per interrupt 1/8 below the rate it went up at, so moves
+ * that hover around a threshold don't keep switching.
+ */
+#define MULTISTEP_RATE 10000
+#define MAX_STEP_SHIFT 3
+
+#if ENABLED(S_CURVE_ACCELERATION)
+  // A ramp of the S-curve profile
+  struct s_curve_t final
+  {
+    uint24 ticks;                         // The length of the ramp in stepper timer ticks
+    uint32 inverse;                       // 0xFFFFFFFF / (ticks >> shift), to turn the time into a ramp position without a divide
+    uint8 shift;                          // Brings ticks within 16 bits
+  };
+#endif
+
+#if ENABLED(ARC_BLOCKS)
+  /**
+   * The XY path of an arc block
+   *
+   * The stepper keeps a point on the arc, from its center, in 1/2^(30 - shift) steps. Each step
+   * event turns the point by 2^-shift radians, shift being the least for which the radius is
+   * under 2^shift steps, so X and Y each move by at most a step. The turn takes only shifts and
+   * adds (Minsky's circle algorithm), which traces an ellipse within half a step of the circle.
+   * An axis steps whenever the point crosses half a step from the motor's position.
+   */
+  struct arc_t final
+  {
+    int32 x, y;                           // The start, from the center
+    int24 end_x, end_y;                   // The motor positions the block ends at
+    uint8 shift;                          // Each step event turns the point by 2^-shift radians
+    bool clockwise;
+  };
+#endif
+
+#if ENABLED(HOST_PLANNED_BLOCKS)
+  /**
+   * A move planned by the host, as it arrives over serial (HOST_PLANNED_BLOCKS)
+   *
+   * Steps are per motor, with a direction bit set for each that runs backwards. The step events
+   * are those of the axis with the most steps, and the rates are in step events per second.
+   */
+  struct host_block_t final
+  {
+    uint8 direction_bits;
+    uint24 steps[NUM_AXIS];
+    uint24 accelerate_until,              // The step event acceleration ends on
+           decelerate_after,              // The step event deceleration starts after
+           initial_rate,
+           nominal_rate,
+           final_rate,
+           acceleration_steps_per_s2,
+           abs_adv_steps_multiplier8;     // The LIN_ADVANCE lead, as in block_t. 0 for none.
+  };
+#endif
+
 /**
  * struct block_t
  *
@@ -74,13 +140,27 @@ enum BlockFlag : uint8_t {
  *
  * The "nominal" values are as-specified by gcode, and
  * may never actually be reached due to acceleration limits.
+ *
+ * Everything the stepper ISR reads comes first, so it sits within the 0-63 byte
+ * ldd/std displacement of the block pointer. The planner-only fields follow.
  */
 struct block_t final
 {
+  //
+  // Stepper ISR
+  //
 
   uint8 flag;                             // Block flags (See BlockFlag enum above)
 
-  uint8 active_extruder;            // The extruder to move (if E move)
+  // The block lock. Each side writes only its own byte, so neither needs a critical section
+  volatile bool busy,                     // Set by the stepper ISR when it takes the block
+                updating;                 // Set by the planner while it rewrites the trapezoid
+
+  #if EXTRUDERS > 1
+    uint8 active_extruder;                // The extruder to move (if E move)
+  #else
+    static constexpr const uint8 active_extruder = 0;
+  #endif
 
   // Fields used by the Bresenham algorithm for tracing the line
   uint24 steps[NUM_AXIS];                 // Step count along each axis
@@ -90,32 +170,62 @@ struct block_t final
     uint32 mix_event_count[MIXING_STEPPERS]; // Scaled step_event_count for the mixing steppers
   #endif
 
-  uint24 accelerate_until,                 // The index of the step event on which to stop acceleration
-          decelerate_after,                 // The index of the step event on which to start decelerating
-          acceleration_rate;                // The acceleration rate used for acceleration calculation
+  uint24 accelerate_until,                // The index of the step event on which to stop acceleration
+         decelerate_after,                // The index of the step event on which to start decelerating
+         acceleration_rate;               // The acceleration rate used for acceleration calculation
 
   uint8 direction_bits;                   // The direction bit set for this block (refers to *_DIRECTION_BIT in config.h)
+  #if ENABLED(DIR_PORT_GROUPING)
+    uint8 dir_port_bits;                  // The XYZ direction pins' bits on their port for direction_bits
+  #endif
+
+  #if ENABLED(MOTION_SYNC_EVENTS)
+    uint8 sync_events;                    // Sync events queued just ahead of this block, due when it starts
+  #endif
+
+  // Settings for the trapezoid generator
+  uint24 nominal_rate,                    // The nominal step rate for this block in step_events/sec
+         initial_rate,                    // The jerk-adjusted step rate at start of block
+         final_rate;                      // The minimal rate at exit
+
+  // Multi-stepping schedule, as a step shift (1 << shift steps per ISR)
+  uint8 initial_step_shift,               // The step shift at the start of the block
+        nominal_step_shift;               // The step shift while cruising
+  uint24 step_shift_up_at[MAX_STEP_SHIFT],        // The step event on which acceleration goes from shift N to N + 1
+         step_shift_down_after[MAX_STEP_SHIFT];   // The step event after which deceleration goes from shift N + 1 to N
 
   // Advance extrusion
   #if ENABLED(LIN_ADVANCE)
-    bool use_advance_lead;
-    uint32 abs_adv_steps_multiplier8; // Factorised by 2^8 to avoid float
+    uint24 abs_adv_steps_multiplier8;     // Factorised by 2^8 to avoid float. Only valid with BLOCK_FLAG_USE_ADVANCE_LEAD.
   #endif
 
+  //
+  // Planner only
+  //
+
   // Fields used by the motion planner to manage acceleration
   float nominal_speed,                      // The nominal speed for this block in mm/sec
         entry_speed,                        // Entry speed at previous-current junction in mm/sec
         max_entry_speed,                    // Maximum allowable junction entry speed in mm/sec
         millimeters,                        // The total travel of this block in mm
-        acceleration;                       // acceleration mm/sec^2
+        acceleration,                       // acceleration mm/sec^2
+        steps_per_mm;                       // Step events per mm of travel, converts speeds into step rates
 
-  // Settings for the trapezoid generator
-  uint24 nominal_rate,                    // The nominal step rate for this block in step_events/sec
-           initial_rate,                    // The jerk-adjusted step rate at start of block
-           final_rate,                      // The minimal rate at exit
-           acceleration_steps_per_s2;       // acceleration steps/sec^2
+  uint24 acceleration_steps_per_s2;       // acceleration steps/sec^2
 
-  //uint24 plateau_rate;
+  #if ENABLED(PRINT_TIME_ESTIMATE)
+    uint16 move_ms;                       // How long the trapezoid takes, as counted in Planner::planned_move_ms
+  #endif
+
+  #if ENABLED(S_CURVE_ACCELERATION)
+    // Read by the stepper once, when the block starts
+    uint24 plateau_rate;                  // The step rate the acceleration ends at
+    s_curve_t accel_curve, decel_curve;   // The acceleration and deceleration ramps
+  #endif
+
+  #if ENABLED(ARC_BLOCKS)
+    arc_t arc;                            // Read by the stepper once, when the block starts
+  #endif
 
   #if FAN_COUNT > 0
     uint8 fan_speed[FAN_COUNT];
@@ -125,22 +235,39 @@ struct block_t final
     uint32 valve_pressure, e_to_p_pressure;
   #endif
 
-  uint32 segment_time;
+  #if ENABLED(ULTRA_LCD)
+    uint32 segment_time;
+  #endif
 
 };
 
-#define BLOCK_MOD(n) ((n)&(BLOCK_BUFFER_SIZE-1))
+c_static_assert(offsetof(block_t, nominal_speed) <= 64, "The stepper ISR fields of block_t must stay within ldd/std displacement range.");
 
 class Planner final {
 
   public:
 
+    #if ENABLED(SHARED_QUEUE_POOL)
+      static uint8_t block_count;               // Set by set_block_buffer() at boot
+      using block_ring = runtime_ring_index<block_count>;
+    #else
+      using block_ring = ring_index<BLOCK_BUFFER_SIZE>;
+    #endif
+
     /**
      * A ring buffer of moves described in steps
      */
-    static block_t block_buffer[BLOCK_BUFFER_SIZE];
-    static volatile uint8_t block_buffer_head,  // Index of the next block to be pushed
-                            block_buffer_tail;
+    #if ENABLED(SHARED_QUEUE_POOL)
+      static block_t *block_buffer;
+    #else
+      static block_t block_buffer[BLOCK_BUFFER_SIZE];
+    #endif
+    static spsc_ring_of<block_ring> block_queue; // Head: the next block to be pushed. Tail: the block being executed
+
+    #if ENABLED(MOTION_SYNC_EVENTS)
+      static uint8 sync_events_unplanned;        // Sync events queued since the last block, for the next one
+      static volatile uint8 sync_events_due;     // Sync events of blocks the stepper has started, not yet run
+    #endif
 
     #if ENABLED(DISTINCT_E_FACTORS)
       static uint8_t last_extruder;             // Respond to extruder change
@@ -150,6 +277,16 @@ class Planner final {
                  axis_steps_per_mm[XYZE_N],
                  steps_to_mm[XYZE_N];
 
+    static float e_factor[EXTRUDERS];           // Each extruder's volumetric multiplier and flow percentage in one factor
+
+    #if ENABLED(VOLUMETRIC_EXTRUDER_LIMIT)
+      static float volumetric_extruder_limit[EXTRUDERS],          // The most each hotend melts, in mm³/s. 0 for no limit.
+                   volumetric_extruder_inverse_limit[EXTRUDERS];  // Its filament area over the limit, in s/mm of filament. 0 for none.
+    #endif
+
+    // Recalculates e_factor[e] once its flow percentage, volumetric multiplier or limit has changed
+    static void refresh_e_factor(const uint8_t e);
+
     //
     // i3++
     //
@@ -170,6 +307,21 @@ class Planner final {
                  max_jerk[XYZE],       // The largest speed change requiring no acceleration
                  min_travel_feedrate_mm_s;
 
+    #if ENABLED(JUNCTION_DEVIATION)
+      static float junction_deviation_mm;  // Distance from the sharp corner to the rounded path used to size junction speeds. M205 J
+    #endif
+
+    #if ENABLED(TRAVEL_JERK)
+      static float travel_jerk[XYZ];                // As max_jerk, for moves that don't extrude. M286
+      #if ENABLED(JUNCTION_DEVIATION)
+        static float travel_junction_deviation_mm;  // As junction_deviation_mm, between two travels. M286 J
+      #endif
+    #endif
+
+    #if ENABLED(STEP_RATE_CALIBRATION)
+      static float inverse_max_step_rate;  // 1 / the fastest step rate the stepper ISR sustains. Measured by Stepper::init()
+    #endif
+
     #if HAS_ABL
       static bool abl_enabled;              // Flag that bed leveling is enabled
       #if ABL_PLANAR
@@ -187,6 +339,13 @@ class Planner final {
 
   private:
 
+    /**
+     * Index of the newest block whose entry speed can no longer improve.
+     * Everything from the tail up to this block is optimally planned, so
+     * recalculate() only has to revisit the blocks after it.
+     */
+    static uint8_t block_buffer_planned;
+
     /**
      * The current position of the tool in absolute steps
      * Recalculated if any axis_steps_per_mm are changed by gcode
@@ -203,6 +362,19 @@ class Planner final {
      */
     static float previous_nominal_speed;
 
+    #if ENABLED(JUNCTION_DEVIATION)
+      /**
+       * Direction of previous path line segment, as a unit vector
+       */
+      static float previous_unit_vec[XYZE];
+    #endif
+
+    /**
+     * Reciprocal of max_feedrate_mm_s, so _buffer_line() can compare axis speeds
+     * against their limits without dividing. Refreshed by reset_acceleration_rates().
+     */
+    static float inverse_max_feedrate_mm_s[XYZE_N];
+
     /**
      * Limit where 64bit math is necessary for acceleration calculation
      */
@@ -252,12 +424,125 @@ class Planner final {
     // Manage fans, paste pressure, etc.
     static __forceinline __flatten void check_axes_activity();
 
+    #if ENABLED(DRIVER_WAKE_LEAD)
+      // The first block to need a driver that was just enabled, and when that driver is ready.
+      // get_current_block() holds that block back until then.
+      static volatile bool waking;
+      static uint8_t wake_block;
+      static millis_t wake_ms;
+
+      // For the block at the head, before its drivers are enabled.
+      static void hold_for_drivers(const block_t & __restrict block);
+    #endif
+
+    #if ENABLED(QUICK_PAUSE)
+      // While holding, get_current_block() stops at hold_block, which starts from rest.
+      static volatile bool holding;
+      static uint8_t hold_block;
+    #endif
+
+    #if ENABLED(QUICK_PAUSE_PARK)
+      enum class park_state : uint8 { none, waiting, parking, parked, returning };
+      static park_state park_status;
+      static uint8_t park_move;                // The next of the three park or return moves to queue
+      static bool park_queuing;                // A park move is being queued, so has_room() lets it in
+
+      // The held moves stay in their slots, from tail to head, while the park runs in the rest of
+      // the ring. The planner's state after them is put back with them.
+      struct stash_t final {
+        uint8_t tail, head, planned;
+        uint24 position[NUM_AXIS];
+        float previous_speed[NUM_AXIS],
+              previous_nominal_speed;
+        #if ENABLED(JUNCTION_DEVIATION)
+          float previous_unit_vec[XYZE];
+        #endif
+        #if ENABLED(LIN_ADVANCE)
+          float position_float[NUM_AXIS];
+        #endif
+        float stopped_at[XYZE];                // Where the nozzle stopped, in mm, to return to
+        float retract;                         // The filament drawn back for the park
+      };
+      static stash_t stash;
+
+      static void stash_held_moves();
+      static void restore_held_moves();
+      static bool queue_park_move();
+    #endif
+
     /**
      * Number of moves currently in the planner
      */
-    static __forceinline __flatten uint8_t movesplanned() { return BLOCK_MOD(block_buffer_head - block_buffer_tail + BLOCK_BUFFER_SIZE); }
+    static __forceinline __flatten uint8_t movesplanned() { return block_queue.count(); }
+
+    static __forceinline __flatten bool is_full() { return block_queue.full(); }
+
+    #if ENABLED(LIVE_SPEED_OVERRIDE)
+      static void rescale_queued_speeds(const float ratio);
+    #endif
+
+    #if ENABLED(QUICK_PAUSE)
+      /**
+       * Bring the queued moves to a stop as soon as their acceleration allows, and hold the
+       * moves after the stop in the buffer until release_motion(). The running block and the
+       * one after it keep their speeds, as recalculate() doesn't replan them.
+       */
+      static void hold_motion();
+      static __forceinline __flatten bool motion_held() { return holding; }
+      #if ENABLED(QUICK_PAUSE_PARK)
+        static void release_motion();
+      #else
+        static __forceinline __flatten void release_motion() { holding = false; }
+      #endif
+    #endif
+
+    #if ENABLED(QUICK_PAUSE_PARK)
+      /**
+       * Hold the moves as hold_motion() does, and once the nozzle has stopped, set the held moves
+       * aside and park: draw the filament back, raise Z and go to the park position. unpark()
+       * returns by the same way, puts the held moves back with the planner's state after them,
+       * and releases them, so they go on with all their lookahead. manage_park() queues the moves
+       * from idle(), as there is room.
+       */
+      static void park();
+      static void unpark();
+      static void manage_park();
+    #endif
+
+    /**
+     * Room for a block at the head. While the held moves are set aside for a park, only the park's
+     * own moves go in, clear of them.
+     */
+    static __forceinline __flatten bool has_room() {
+      #if ENABLED(QUICK_PAUSE_PARK)
+        if (__unlikely(park_status > park_state::waiting))
+          return park_queuing && !block_queue.full() && (stash.tail == stash.head || block_queue.head() != stash.tail);
+      #endif
+      return !block_queue.full();
+    }
 
-    static __forceinline __flatten bool is_full() { return (block_buffer_tail == BLOCK_MOD(block_buffer_head + 1)); }
+    /**
+     * Number of blocks in the ring buffer
+     */
+    static __forceinline __flatten uint8_t block_buffer_size() {
+      #if ENABLED(SHARED_QUEUE_POOL)
+        return block_count;
+      #else
+        return BLOCK_BUFFER_SIZE;
+      #endif
+    }
+
+    #if ENABLED(SHARED_QUEUE_POOL)
+      /**
+       * Use 'count' blocks at 'buffer' for the ring buffer. Only before the stepper runs.
+       */
+      static void set_block_buffer(block_t * const buffer, const uint8_t count) {
+        block_buffer = buffer;
+        block_count = count;
+        block_queue.clear();
+        block_buffer_planned = 0;
+      }
+    #endif
 
     #if PLANNER_LEVELING
 
@@ -295,11 +580,32 @@ class Planner final {
     // TODO validate I actually want this to be forceinline. This makes the binary waaaaay bigger.
     static void __forceinline _buffer_line(const float & __restrict a, const float & __restrict b, const float & __restrict c, const float & __restrict e, float fr_mm_s, const uint8_t extruder);
 
-    static void __forceinline _buffer_arc(
-      const float(&target)[4],
-      const float(&start_velocity)[4],
-      const float(&end_velocity)[4]
-    );
+    #if ENABLED(ARC_BLOCKS)
+      /**
+       * Planner::_buffer_arc
+       *
+       * Add an arc in the XY plane, with Z and E moving linearly, as a single block.
+       * Returns false, queuing nothing, if the stepper can't trace it.
+       *
+       *  target   - x,y,z,e target position in mm
+       *  center   - x,y of the center of the arc in mm
+       *  angle    - radians turned about the center, positive counterclockwise
+       *  fr_mm_s  - (target) speed of the move (mm/s)
+       *  extruder - target extruder
+       */
+      static bool _buffer_arc(const float (&target)[XYZE], const float (&center)[2], const float &angle, float fr_mm_s, const uint8_t extruder);
+    #endif
+
+    #if ENABLED(HOST_PLANNED_BLOCKS)
+      /**
+       * Planner::buffer_host_block
+       *
+       * Add a block planned by the host, exactly as sent. There must be room in the buffer.
+       * Returns false, queuing nothing, if the trapezoid doesn't fit the steps. Under DRYRUN
+       * or with a cold hotend the block runs without E, as a line would.
+       */
+      static bool buffer_host_block(const host_block_t & __restrict host, const uint8_t extruder);
+    #endif
 
     static void __forceinline _set_position_mm(const float & __restrict a, const float & __restrict b, const float & __restrict c, const float & __restrict e);
 
@@ -322,14 +628,12 @@ class Planner final {
       _buffer_line(lx, ly, lz, e, fr_mm_s, extruder);
     }
 
-    static void __forceinline buffer_arc(
-      const float(&target)[4],
-      const float(&start_velocity)[4],
-      const float(&end_velocity)[4]
-    )
-    {
-      _buffer_arc(target, start_velocity, end_velocity);
-    }
+    #if ENABLED(ARC_BLOCKS)
+      // Arcs aren't leveled, so there's no arc variant of that (see SanityCheck.h)
+      static bool __forceinline __flatten buffer_arc(const float (&target)[XYZE], const float (&center)[2], const float &angle, const float &fr_mm_s, const uint8_t extruder) {
+        return _buffer_arc(target, center, angle, fr_mm_s, extruder);
+      }
+    #endif
 
     /**
      * Add a new linear movement to the buffer.
@@ -375,6 +679,14 @@ class Planner final {
     static void __forceinline __flatten set_z_position_mm(const float & __restrict z) { set_position_mm(AxisEnum::Z_AXIS, z); }
     static void __forceinline __flatten set_e_position_mm(const float & __restrict e) { set_position_mm(AxisEnum::E_AXIS, e); }
 
+    #if ENABLED(FWRETRACT_LOOKAHEAD)
+      /**
+       * Offset the planner position of one axis, leaving the steppers and the previous
+       * speeds alone, so the next move is planned from there while queued moves still run.
+       */
+      static void __forceinline __flatten shift_position_mm(const AxisEnum axis, const float & __restrict distance);
+    #endif
+
     /**
      * Sync from the stepper positions. (e.g., after an interrupted move)
      */
@@ -383,38 +695,70 @@ class Planner final {
     /**
      * Does the buffer have any blocks queued?
      */
-    static inline bool __forceinline __flatten blocks_queued() { return (block_buffer_head != block_buffer_tail); }
+    static inline bool __forceinline __flatten blocks_queued() { return !block_queue.empty(); }
 
     /**
      * "Discards" the block and "releases" the memory.
      * Called when the current block is no longer needed.
      */
     static __forceinline __flatten void discard_current_block() {
-      if (blocks_queued())
-        block_buffer_tail = BLOCK_MOD(block_buffer_tail + 1);
+      if (blocks_queued()) {
+        #if ENABLED(PRINT_TIME_ESTIMATE)
+          done_move_ms += block_buffer[block_queue.tail()].move_ms;
+        #endif
+        block_queue.pop();
+      }
     }
 
+    #if ENABLED(PRINT_TIME_ESTIMATE)
+      /**
+       * The move time of the blocks in the buffer, in ms. The planner adds each block's time
+       * to planned_move_ms as its trapezoid is calculated, and discard_current_block() adds
+       * it to done_move_ms; each side only writes its own total.
+       */
+      static uint32 planned_move_ms;
+      static volatile uint32 done_move_ms;
+      static uint32 queued_move_ms() {
+        const interrupt_mask stepper_mask(TIMSK1, _BV(OCIE1A));
+        return planned_move_ms - done_move_ms;
+      }
+    #endif
+
     /**
      * The current block. nullptr if the buffer is empty.
-     * This also marks the block as busy.
+     * This also marks the block as busy. A block the planner is
+     * updating is left alone, and is taken on a later call.
      */
     static __forceinline __flatten block_t * __restrict get_current_block() {
       if (blocks_queued()) {
-        block_t * __restrict block = &block_buffer[block_buffer_tail];
+        block_t * __restrict block = &block_buffer[block_queue.tail()];
 
         // If the trapezoid of this block has to be recalculated, it's not save to execute it.
         if (movesplanned() > 1) {
-          block_t * next = &block_buffer[next_block_index(block_buffer_tail)];
+          block_t * next = &block_buffer[next_block_index(block_queue.tail())];
           if (TEST(block->flag, BLOCK_BIT_RECALCULATE) || TEST(next->flag, BLOCK_BIT_RECALCULATE))
             return nullptr;
         }
         else if (TEST(block->flag, BLOCK_BIT_RECALCULATE))
           return nullptr;
 
+        if (block->updating) return nullptr;
+
+        #if ENABLED(DRIVER_WAKE_LEAD)
+          if (__unlikely(waking) && block_queue.tail() == wake_block) {
+            if (PENDING(millis(), wake_ms)) return nullptr;
+            waking = false;
+          }
+        #endif
+
+        #if ENABLED(QUICK_PAUSE)
+          if (__unlikely(holding) && block_queue.tail() == hold_block) return nullptr;
+        #endif
+
         #if ENABLED(ULTRA_LCD)
           block_buffer_runtime_us -= block->segment_time; //We can't be sure how long an active block will take, so don't count it.
         #endif
-        SBI(block->flag, BLOCK_BIT_BUSY);
+        block->busy = true;
         return block;
       }
       else {
@@ -432,13 +776,38 @@ class Planner final {
       static void autotemp_M104_M109();
     #endif
 
+    #if ENABLED(PLANNER_PROFILING)
+      /**
+       * Planner throughput and buffer depth, gathered by _buffer_line() and reported by M296.
+       * Times are in microseconds and exclude waiting for a free block.
+       */
+      struct profile_t final
+      {
+        static constexpr const uint8 recalculate_bins = 8;  // <64us, <128us, ... <4096us, >=4096us
+        static constexpr const uint8 timeline_length = 16;  // Seconds of buffer depth history
+
+        uint32 segments;                                // Blocks added
+        uint32 buffer_line_us;                          // Time spent in _buffer_line()
+        uint32 recalculate_max_us;                      // Slowest recalculate()
+        uint16 recalculate_bin[recalculate_bins];       // recalculate() durations, by power of two
+        uint8 lowest_depth;                             // Fewest blocks queued when a block was added
+        uint8 depth_timeline[timeline_length];          // The same per second, the newest at timeline_index
+        uint8 timeline_index;
+        millis_t start_ms, next_timeline_ms;
+      };
+      static profile_t profile;
+
+      static void reset_profile();
+      static void report_profile();
+    #endif
+
   private:
 
     /**
      * Get the index of the next / previous block in the ring buffer
      */
-    static __forceinline __flatten int8_t next_block_index(int8_t block_index) { return BLOCK_MOD(block_index + 1); }
-    static __forceinline __flatten int8_t prev_block_index(int8_t block_index) { return BLOCK_MOD(block_index - 1); }
+    static __forceinline __flatten uint8_t next_block_index(uint8_t block_index) { return block_ring::next(block_index); }
+    static __forceinline __flatten uint8_t prev_block_index(uint8_t block_index) { return block_ring::prev(block_index); }
 
     /**
      * Calculate the distance (not time) it takes to accelerate
@@ -471,15 +840,39 @@ class Planner final {
       return SQRT(sq(target_velocity) - 2 * accel * distance);
     }
 
+    // The jerk limit of an axis, for a travel or a printing move
+    static inline float __forceinline __flatten jerk_limit(const uint8_t axis, const bool travel) {
+      #if ENABLED(TRAVEL_JERK)
+        if (travel && axis != E_AXIS) return travel_jerk[axis];
+      #else
+        UNUSED(travel);
+      #endif
+      return max_jerk[axis];
+    }
+
+    static float __forceinline __flatten halt_speed(const float (&speed)[NUM_AXIS], const float &nominal_speed, const bool travel);
+
+    // The single_axis of a block that moves more than one axis
+    static constexpr const uint8_t several_axes = 0xFF;
+
+    static float __forceinline __flatten plan_junction(block_t * __restrict const block, const float (&current_speed)[NUM_AXIS],
+      #if ENABLED(JUNCTION_DEVIATION)
+        const float (&unit_vec)[XYZE],
+      #endif
+      const uint8_t moves_queued,
+      const uint8_t single_axis
+    );
+
     static void __forceinline __flatten calculate_trapezoid_for_block(block_t * __restrict const block, const float & __restrict entry_speed, const float & __restrict next_entry_speed);
+    static void __forceinline __flatten set_trapezoid(block_t * __restrict const block, const uint32 initial_rate, const uint32 final_rate, const uint24 accelerate_steps, const uint24 plateau_steps);
 
     static void __forceinline __flatten reverse_pass_kernel(block_t * __restrict const current, const block_t * __restrict next);
-    static void __forceinline __flatten forward_pass_kernel(const block_t * __restrict previous, block_t * __restrict const current);
+    static bool __forceinline __flatten forward_pass_kernel(const block_t * __restrict previous, block_t * __restrict const current);
 
-    static void __forceinline __flatten reverse_pass();
-    static void __forceinline __flatten forward_pass();
+    static void __forceinline __flatten reverse_pass(const uint8_t planned);
+    static void __forceinline __flatten forward_pass(const uint8_t planned);
 
-    static void __forceinline __flatten recalculate_trapezoids();
+    static void __forceinline __flatten recalculate_trapezoids(const uint8_t planned);
 
     static void __forceinline __flatten recalculate();
 
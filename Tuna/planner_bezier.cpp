@@ -44,6 +44,101 @@
 */
 inline static float interp(float a, float b, float t) { return (1.0 - t) * a + t * b; }
 
+#if ENABLED(BEZIER_FORWARD_DIFFERENCING)
+
+/**
+ * A coordinate of the curve, stepped along it by forward differences: with n equal steps
+ * h = 1/n of the parameter, B(t) = a t^3 + b t^2 + c t + d moves by d1, which grows by d2,
+ * which grows by the constant d3. They are kept as 32.32 fixed point, so each step is three
+ * additions with no rounding. The differences' own rounding adds up to 5 microns at most,
+ * over the most steps allowed, and the last step is put on the target anyway.
+ */
+class forward_difference final {
+  static constexpr float one = 4294967296.0f; // 2^32
+
+  int64 value, d1, d2, d3;
+
+public:
+  forward_difference(const float p0, const float p1, const float p2, const float p3, const float h) {
+    const float a = p3 - p0 + 3 * (p1 - p2),
+                b = 3 * (p0 - 2 * p1 + p2),
+                c = 3 * (p1 - p0),
+                h2 = h * h, h3 = h2 * h;
+    value = int64(p0 * one);
+    d1 = int64((a * h3 + b * h2 + c * h) * one);
+    d2 = int64((6 * a * h3 + 2 * b * h2) * one);
+    d3 = int64(6 * a * h3 * one);
+  }
+
+  inline float step() {
+    value += d1;
+    d1 += d2;
+    d2 += d3;
+    // Whole and 16 fraction bits are plenty for a float, and the shift is just byte moves
+    return float(int32(value >> 16)) * (1.0f / 65536.0f);
+  }
+};
+
+/**
+ * Cut the curve into n equal steps of t. A chord of a step strays from the curve by at most
+ * |B''| / (8 n^2), and |B''| <= 6 max(|P0 - 2 P1 + P2|, |P1 - 2 P2 + P3|), so n is the least
+ * that keeps 3 max(...) / (4 n^2) within BEZIER_TOLERANCE. As with the adaptive steps, there
+ * are no fewer than 1 / MAX_STEP and no more than 1 / MIN_STEP of them.
+ */
+void cubic_b_spline(const float position[NUM_AXIS], const float target[NUM_AXIS], const float offset[4], float fr_mm_s, uint8_t extruder) {
+  // Absolute first and second control points are recovered.
+  const float first0 = position[X_AXIS] + offset[0],
+              first1 = position[Y_AXIS] + offset[1],
+              second0 = target[X_AXIS] + offset[2],
+              second1 = target[Y_AXIS] + offset[3];
+
+  const float bend = max(
+    HYPOT(position[X_AXIS] - 2 * first0 + second0, position[Y_AXIS] - 2 * first1 + second1),
+    HYPOT(first0 - 2 * second0 + target[X_AXIS], first1 - 2 * second1 + target[Y_AXIS])
+  );
+  const float steps = CEIL(SQRT(bend * (0.75f / (BEZIER_TOLERANCE))));
+  const uint16_t n = uint16_t(constrain(steps, 1.0f / (MAX_STEP), 1.0f / (MIN_STEP)));
+  const float h = 1.0f / n;
+
+  forward_difference x(position[X_AXIS], first0, second0, target[X_AXIS], h),
+                     y(position[Y_AXIS], first1, second1, target[Y_AXIS], h);
+
+  float bez_target[4];
+
+  millis_t next_idle_ms = millis() + 200UL;
+
+  for (uint16_t i = 1; i <= n; ++i) {
+
+    Temperature::manage_heater();
+    millis_t now = millis();
+    if (ELAPSED(now, next_idle_ms)) {
+      next_idle_ms = now + 200UL;
+      idle();
+    }
+
+    float t;
+    if (i < n) {
+      t = i * h;
+      bez_target[X_AXIS] = x.step();
+      bez_target[Y_AXIS] = y.step();
+    }
+    else {
+      // The last step lands on the target itself
+      t = 1.0;
+      bez_target[X_AXIS] = target[X_AXIS];
+      bez_target[Y_AXIS] = target[Y_AXIS];
+    }
+    // FIXME. The following two are wrong, since the parameter t is
+    // not linear in the distance.
+    bez_target[Z_AXIS] = interp(position[Z_AXIS], target[Z_AXIS], t);
+    bez_target[E_AXIS] = interp(position[E_AXIS], target[E_AXIS], t);
+    clamp_to_software_endstops(bez_target);
+    planner.buffer_line_kinematic(bez_target, fr_mm_s, extruder);
+  }
+}
+
+#else // !BEZIER_FORWARD_DIFFERENCING
+
 /**
  * Compute a Bézier curve using the De Casteljau's algorithm (see
  * https://en.wikipedia.org/wiki/De_Casteljau%27s_algorithm), which is
@@ -191,4 +286,6 @@ void cubic_b_spline(const float position[NUM_AXIS], const float target[NUM_AXIS]
   }
 }
 
+#endif // !BEZIER_FORWARD_DIFFERENCING
+
 #endif // BEZIER_CURVE_SUPPORT
@@ -23,8 +23,24 @@
 #include <tuna.h>
 
 #include "printcounter.h"
+#include "configuration_store.h"
+#include "planner.h"
 #include "duration_t.h"
 
+#if ENABLED(PRINTCOUNTER_JOURNAL)
+  #include <util/crc16.h>
+#endif
+
+// With EEPROM_BACKGROUND_WRITE the bytes go through the settings' write queue, so a save doesn't
+// wait for the EEPROM, and the EE_READY interrupt skips those that haven't changed.
+static void write_block(const void *data, const uint16_t address, const uint16_t size) {
+  #if ENABLED(EEPROM_BACKGROUND_WRITE)
+    settings.queue_write(address, data, size);
+  #else
+    eeprom_update_block(data, (void *)address, size);
+  #endif
+}
+
 PrintCounter::PrintCounter(): super() {
   this->loadStats();
 }
@@ -43,15 +59,16 @@ bool PrintCounter::isLoaded() {
   return this->loaded;
 }
 
-void PrintCounter::incFilamentUsed(double const &amount) {
+void PrintCounter::addFilamentSteps() {
   #if ENABLED(DEBUG_PRINTCOUNTER)
-    PrintCounter::debug(PSTR("incFilamentUsed"));
+    PrintCounter::debug(PSTR("addFilamentSteps"));
   #endif
 
   // Refuses to update data if object is not loaded
-  if (!this->isLoaded()) return;
+  if (!this->isLoaded() || !this->filamentSteps) return;
 
-  this->data.filamentUsed += amount; // mm
+  this->data.filamentUsed += this->filamentSteps * planner.steps_to_mm[E_AXIS]; // mm
+  this->filamentSteps = 0;
 }
 
 
@@ -62,16 +79,56 @@ void PrintCounter::initStats() {
 
   this->loaded = true;
   this->data = { 0, 0, 0, 0, 0.0 };
+  this->filamentSteps = 0;
 
   this->saveStats();
-  eeprom_write_byte((uint8_t *) this->address, 0x16);
+  const uint8_t magic = 0x16;
+  write_block(&magic, this->address, sizeof(magic));
 }
 
+#if ENABLED(PRINTCOUNTER_JOURNAL)
+
+  uint8_t PrintCounter::journal_crc(const journal_record &record) {
+    const uint8_t *p = (const uint8_t *)&record;
+    uint8_t crc = 0;
+    for (uint8_t i = 0; i < offsetof(journal_record, crc); ++i) crc = _crc8_ccitt_update(crc, p[i]);
+    return crc;
+  }
+
+#endif
+
 void PrintCounter::loadStats() {
   #if ENABLED(DEBUG_PRINTCOUNTER)
     PrintCounter::debug(PSTR("loadStats"));
   #endif
 
+  #if ENABLED(EEPROM_BACKGROUND_WRITE)
+    while (settings.writing()) { /* the EEPROM is the interrupt's until a save is written */ }
+  #endif
+
+  #if ENABLED(PRINTCOUNTER_JOURNAL)
+    // The newest intact record, by sequence number with wrap-around
+    this->journal_slot = PRINTCOUNTER_JOURNAL_SLOTS - 1;
+    this->journal_sequence = 0;
+    bool found = false;
+    for (uint8_t slot = 0; slot < PRINTCOUNTER_JOURNAL_SLOTS; ++slot) {
+      journal_record record;
+      eeprom_read_block(&record, (const void *)(journal_address + slot * sizeof(journal_record)), sizeof(journal_record));
+      if (record.sequence == 0xFFFF || record.crc != journal_crc(record)) continue;
+      if (!found || int16_t(record.sequence - this->journal_sequence) > 0) {
+        found = true;
+        this->journal_slot = slot;
+        this->journal_sequence = record.sequence;
+        this->data = record.data;
+      }
+    }
+    if (found) {
+      this->loaded = true;
+      return;
+    }
+    // Nothing in the journal yet: take the statistics from the fixed block, if there are any
+  #endif
+
   // Checks if the EEPROM block is initialized
   if (eeprom_read_byte((uint8_t *) this->address) != 0x16) this->initStats();
   else eeprom_read_block(&this->data,
@@ -88,15 +145,28 @@ void PrintCounter::saveStats() {
   // Refuses to save data if object is not loaded
   if (!this->isLoaded()) return;
 
-  // Saves the struct to EEPROM
-  eeprom_update_block(&this->data,
-    (void *)(this->address + sizeof(uint8_t)), sizeof(printStatistics));
+  this->addFilamentSteps();
+
+  #if ENABLED(PRINTCOUNTER_JOURNAL)
+    journal_record record;
+    this->journal_slot = (this->journal_slot + 1) % PRINTCOUNTER_JOURNAL_SLOTS;
+    if (++this->journal_sequence == 0xFFFF) this->journal_sequence = 0;
+    record.sequence = this->journal_sequence;
+    record.data = this->data;
+    record.crc = journal_crc(record);
+    write_block(&record, journal_address + this->journal_slot * sizeof(journal_record), sizeof(journal_record));
+  #else
+    // Saves the struct to EEPROM
+    write_block(&this->data, this->address + sizeof(uint8_t), sizeof(printStatistics));
+  #endif
 }
 
 void PrintCounter::showStats() {
   char buffer[21];
   duration_t elapsed;
 
+  this->addFilamentSteps();
+
   SERIAL_PROTOCOLPGM(MSG_STATS);
 
   SERIAL_ECHOPGM("Prints: ");
@@ -149,27 +219,23 @@ void PrintCounter::showStats() {
 void __forceinline __flatten PrintCounter::tick() {
   if (!this->isRunning()) return;
 
-  static uint32 update_last = millis(),
-                  eeprom_last = millis();
-
-  millis_t now = millis();
+  // Called once a second by the periodic scheduler, so seconds are counted rather than millis()
+  // compared. deltaDuration() still takes the time from the stopwatch, so a late call loses nothing.
+  static uint16_t update_seconds = 0, save_seconds = 0;
 
-  // Trying to get the amount of calculations down to the bare min
-  const static uint16_t i = this->updateInterval * 1000;
-
-  if (now - update_last >= i) {
+  if (++update_seconds >= this->updateInterval) {
     #if ENABLED(DEBUG_PRINTCOUNTER)
       PrintCounter::debug(PSTR("tick"));
     #endif
 
     this->data.printTime += this->deltaDuration();
-    update_last = now;
+    update_seconds = 0;
   }
 
-  // Trying to get the amount of calculations down to the bare min
-  const static millis_t j = this->saveInterval * 1000;
-  if (now - eeprom_last >= j) {
-    eeprom_last = now;
+  this->addFilamentSteps();
+
+  if (++save_seconds >= this->saveInterval) {
+    save_seconds = 0;
     this->saveStats();
   }
 }
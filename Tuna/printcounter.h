@@ -47,12 +47,41 @@ class PrintCounter final : public Stopwatch {
 
     printStatistics data;
 
+    /**
+     * @brief E steps moved since the last conversion
+     * @details The planner adds the E steps of each move it queues, and they
+     * are only converted to mm in data.filamentUsed once a second and before
+     * the statistics are read or saved.
+     */
+    int32 filamentSteps = 0;
+
     /**
      * @brief EEPROM address
      * @details Defines the start offset address where the data is stored.
      */
     static constexpr const uint16_t address = 0x32;
 
+    #if ENABLED(PRINTCOUNTER_JOURNAL)
+      /**
+       * @brief Journal of saves
+       * @details Each save goes to the record after the newest one, so the
+       * records are written in turn. The newest intact record, by sequence
+       * number, is the one loaded. A record cut short by a reset fails its CRC
+       * and the one before it is used.
+       */
+      struct journal_record {
+        uint16_t sequence;      // Never 0xFFFF, which is erased EEPROM
+        printStatistics data;
+        uint8_t crc;            // CRC-8 of the above
+      };
+      static constexpr const uint16_t journal_address = 0x800;
+
+      uint8_t journal_slot;     // The newest record's slot
+      uint16_t journal_sequence;
+
+      static uint8_t journal_crc(const journal_record &record);
+    #endif
+
     /**
      * @brief Interval in seconds between counter updates
      * @details This const value defines what will be the time between each
@@ -94,6 +123,12 @@ class PrintCounter final : public Stopwatch {
      */
     millis_t deltaDuration();
 
+    /**
+     * @brief Converts the pending E steps
+     * @details Adds filamentSteps to data.filamentUsed, in mm, and clears it.
+     */
+    void addFilamentSteps();
+
   public:
     /**
      * @brief Class constructor
@@ -109,11 +144,12 @@ class PrintCounter final : public Stopwatch {
 
     /**
      * @brief Increments the total filament used
-     * @details The total filament used counter will be incremented by "amount".
+     * @details The total filament used counter will be incremented by "steps".
+     * It's called by the planner for every move, so it only adds the steps.
      *
-     * @param amount The amount of filament used in mm
+     * @param steps The E steps of the move, negative for a retraction
      */
-    void incFilamentUsed(double const &amount);
+    inline void __forceinline __flatten incFilamentSteps(const int32 steps) { this->filamentSteps += steps; }
 
     /**
      * @brief Resets the Print Statistics
@@ -145,12 +181,12 @@ class PrintCounter final : public Stopwatch {
      * @brief Return the currently loaded statistics
      * @details Return the raw data, in the same structure used internally
      */
-    printStatistics getStats() { return this->data; }
+    printStatistics getStats() { this->addFilamentSteps(); return this->data; }
 
     /**
      * @brief Loop function
-     * @details This function should be called at loop, it will take care of
-     * periodically save the statistical data to EEPROM and do time keeping.
+     * @details This function should be called once a second, it will take care
+     * of periodically save the statistical data to EEPROM and do time keeping.
      */
     void __forceinline __flatten tick();
 
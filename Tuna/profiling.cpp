@@ -0,0 +1,130 @@
+#include "profiling.hpp"
+
+#include "gcode.h"
+#include "planner.h"
+
+using namespace Tuna;
+
+#if ENABLED(PIPELINE_PROFILING)
+
+namespace Tuna::profiling
+{
+  section_timing timings[uint8(section::count)];
+
+  namespace
+  {
+    const char section_names[][8] __flashmem = {
+      "SD", "Parse", "G0/G1", "G", "M", "Other", "Plan", "Full"
+    };
+    c_static_assert(array_size(section_names) == uint8(section::count));
+
+    section command_section()
+    {
+      switch (parser.command_letter)
+      {
+      case 'G': return (uint16(parser.codenum) <= 1) ? section::command_move : section::command_g;
+      case 'M': return section::command_m;
+      default: return section::command_other;
+      }
+    }
+  }
+
+  command_timer::~command_timer()
+  {
+    add(command_section(), m_StartUs);
+  }
+
+  void reset()
+  {
+    for (section_timing & __restrict timing : timings)
+    {
+      timing = {};
+    }
+  }
+
+  void report()
+  {
+    SERIAL_ECHOLNPGM("Pipeline us:");
+    for (uint8 i = 0; i < uint8(section::count); ++i)
+    {
+      const section_timing & __restrict timing = timings[i];
+
+      SERIAL_ECHO_START();
+      serialprintPGM(section_names[i]);
+      SERIAL_ECHOPAIR(" calls:", timing.calls);
+      SERIAL_ECHOPAIR(" total:", timing.total_us);
+      if (timing.calls)
+      {
+        SERIAL_ECHOPAIR(" avg:", timing.total_us / timing.calls);
+      }
+      SERIAL_ECHOLNPAIR(" max:", timing.max_us);
+    }
+  }
+}
+
+#endif
+
+#if ENABLED(LOOP_LATENCY_HISTOGRAM)
+
+namespace Tuna::profiling
+{
+  loop_latency latency;
+
+  loop_timer::~loop_timer()
+  {
+    const uint32 us = micros() - m_StartUs;
+    const uint8 bin = us ? uint8(32 - __builtin_clzl(us)) : 0_u8;
+    ++latency.bins[min(bin, uint8(latency_bins - 1))];
+
+    if (us > latency.max_us)
+    {
+      latency.max_us = us;
+      latency.max_letter = m_Command ? parser.command_letter : 0;
+      latency.max_code = m_Command ? uint16(parser.codenum) : 0_u16;
+    }
+
+    if (m_Moving && !planner.blocks_queued() && commands_in_queue)
+    {
+      ++latency.starved;
+    }
+  }
+
+  void reset_latency()
+  {
+    latency = {};
+  }
+
+  void report_latency()
+  {
+    SERIAL_ECHOLNPGM("Loop us:");
+    for (uint8 i = 0; i < latency_bins; ++i)
+    {
+      if (!latency.bins[i])
+      {
+        continue;
+      }
+      SERIAL_ECHO_START();
+      if (i == latency_bins - 1)
+      {
+        SERIAL_ECHOPAIR(">=", 1_u32 << (i - 1));
+      }
+      else
+      {
+        SERIAL_ECHOPAIR("<", 1_u32 << i);
+      }
+      SERIAL_ECHOLNPAIR(": ", latency.bins[i]);
+    }
+
+    SERIAL_ECHO_START();
+    SERIAL_ECHOPAIR("max:", latency.max_us);
+    if (latency.max_letter)
+    {
+      SERIAL_ECHOPGM(" in ");
+      SERIAL_CHAR(latency.max_letter);
+      SERIAL_ECHO(latency.max_code);
+    }
+    SERIAL_ECHOLNPAIR(" starved:", latency.starved);
+  }
+}
+
+#endif
@@ -0,0 +1,90 @@
+#pragma once
+
+#include <tuna.h>
+
+namespace Tuna::profiling
+{
+#if ENABLED(PIPELINE_PROFILING)
+  // The stages of the G-code pipeline that are timed. Commands are split by class, and their time
+  // includes parsing and anything they wait on, such as a full planner.
+  enum class section : uint8
+  {
+    sd_read,          // get_sdcard_commands() while printing from SD
+    parse,            // parser.parse() or scan_linear_move()
+    command_move,     // G0/G1
+    command_g,        // Any other G code
+    command_m,        // M codes
+    command_other,    // T codes and unknown commands
+    buffer_line,      // Planner::_buffer_line(), less waiting for a block
+    planner_wait,     // idle() while the planner is full
+    count
+  };
+
+  // Duration statistics of one section, in microseconds. Main loop only.
+  struct section_timing final
+  {
+    uint32 calls = 0;
+    uint32 total_us = 0;          // Wraps after about 70 minutes in one section; reset before measuring
+    uint32 max_us = 0;
+
+    inline void __forceinline __flatten add(arg_type<uint32> us)
+    {
+      ++calls;
+      total_us += us;
+      if (us > max_us) max_us = us;
+    }
+  };
+
+  extern section_timing timings[uint8(section::count)];
+
+  inline void __forceinline __flatten add(arg_type<section> s, arg_type<uint32> start_us)
+  {
+    timings[uint8(s)].add(micros() - start_us);
+  }
+
+  // Times the command being processed for as long as it's in scope, by the class the parser gives it.
+  class command_timer final
+  {
+    const uint32 m_StartUs = micros();
+
+  public:
+    ~command_timer();
+  };
+
+  void reset();
+  void report();
+#endif
+
+#if ENABLED(LOOP_LATENCY_HISTOGRAM)
+  // loop() passes by duration, in powers of two: bin 0 holds the passes under 1us, bin i those
+  // from 2^(i-1) up to 2^i us, and the last everything longer. Main loop only.
+  constexpr const uint8 latency_bins = 24;
+
+  struct loop_latency final
+  {
+    uint32 bins[latency_bins] = {};
+    uint32 max_us = 0;
+    char max_letter = 0;          // The command of the longest pass, 0 if it ran none
+    uint16 max_code = 0;
+    uint32 starved = 0;           // Passes that began with moves queued and left the planner empty with commands waiting
+  };
+
+  extern loop_latency latency;
+
+  // Times a loop() pass for as long as it's in scope. 'command' is whether it runs one, and
+  // 'moving' whether the planner has blocks as it starts.
+  class loop_timer final
+  {
+    const uint32 m_StartUs = micros();
+    const bool m_Command;
+    const bool m_Moving;
+
+  public:
+    inline __forceinline loop_timer(arg_type<bool> command, arg_type<bool> moving) : m_Command(command), m_Moving(moving) {}
+    ~loop_timer();
+  };
+
+  void reset_latency();
+  void report_latency();
+#endif
+}
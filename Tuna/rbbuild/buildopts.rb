@@ -19,6 +19,7 @@ $BuildOptions = Class.new do
 		attr_accessor :src_dirs
 		attr_accessor :threads
 		attr_accessor :verbose
+		attr_accessor :size_report
 	end
 	@name = nil
 	@target = nil
@@ -29,6 +30,7 @@ $BuildOptions = Class.new do
 	@src_dirs = []
 	@threads = nil
 	@verbose = false
+	@size_report = nil
 	
 	def self.validate
 		errors = []
@@ -120,6 +122,7 @@ $BuildOptions = Class.new do
 		to_print["Output"] = @output;
 		to_print["Output Dependencies"] = @output_deps;
 		to_print["Source Paths"] = @src_dirs;
+		to_print["Size Report"] = @size_report if @size_report != nil;
 		
 		max_length = 0
 		
@@ -184,6 +187,7 @@ OptionParser.new do |opts|
 	opts.on("-w", "--workers NUM", "Number of Worker Threads") { |v| $BuildOptions.threads = v.to_i }
 	opts.on("-s", "--source PATH", "Source Path [required]") { |v| $BuildOptions.src_dirs << File.expand_path(normalize_path(v)) }
 	opts.on("-v", "--verbose", "Show Diagnostic Data") { $BuildOptions.verbose = true }
+	opts.on(nil, "--size-report PATH", "Write the flash size of each function, and compare to the last report") { |v| $BuildOptions.size_report = File.expand_path(normalize_path(v)) }
 	opts.on(nil, "--env ENV", "Specify the environment.") { |v| $environment << v }
 end.parse!
 
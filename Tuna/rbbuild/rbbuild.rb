@@ -10,6 +10,7 @@ require_relative 'buildopts.rb'
 require_relative 'gcc_buildhandler.rb'
 require_relative 'clang_buildhandler.rb'
 require_relative 'thread_exec.rb'
+require_relative 'strings.rb'
 
 $USE_CLANG = false
 $C_BUILD_HANDLER = $USE_CLANG ? $clang_buildhandler : $gpp_buildhandler
@@ -233,6 +234,13 @@ $directory_hashes.each { |path, hash|
 parse_time = Time.now - parse_time
 puts("Directories Parsed. (#{duration(parse_time)})");
 
+# The PACKED_STRINGS dictionary lives with the messages, in the source directory that has language.h
+$BuildOptions.src_dirs.each { |dir|
+	next if !(File.file? dir + "/language.h")
+	generate_string_dictionary(dir + "/string_dictionary.h", $BuildOptions.src_dirs, dir, force_all_build)
+	break
+}
+
 # Now we iterate over our source files, and generate header dependency lists for them.
 # TODO we can optimize this so it doesn't have to happen every time by cacheing results.
 # TODO also we can thread this
@@ -458,6 +466,44 @@ end
 
 puts `avr-size #{quote_wrap($BuildOptions.output)}`
 
+# Report the SRAM left over once .data and .bss are placed. Whatever remains is shared by the stack
+# and heap, so this is the headroom available for growing buffers such as BLOCK_BUFFER_SIZE.
+$SRAM_SIZE = 8192 # ATmega2560
+sram_used = 0
+`avr-size -A #{quote_wrap($BuildOptions.output)}`.each_line { |line|
+	section, size = line.split
+	sram_used += size.to_i if [".data", ".bss", ".noinit"].include?(section)
+}
+puts "SRAM: #{sram_used} bytes static, #{$SRAM_SIZE - sram_used} bytes free for stack and heap."
+
+# With --size-report, write the flash each function takes, largest first, and list the biggest
+# changes since the report already there, to see what inlining and cold attributes really cost.
+if ($BuildOptions.size_report != nil)
+	previous = Hash.new(0)
+	if (File.file? $BuildOptions.size_report)
+		File.readlines($BuildOptions.size_report).each { |line|
+			size, name = line.chomp.split(" ", 2)
+			previous[name] = size.to_i
+		}
+	end
+	current = Hash.new(0)
+	`avr-nm --size-sort -C -S --radix=d #{quote_wrap($BuildOptions.output)}`.each_line { |line|
+		fields = line.chomp.split(" ", 4)
+		next if (fields.size < 4 || !["t", "T", "w", "W"].include?(fields[2]))
+		current[fields[3]] += fields[1].to_i
+	}
+	File.open($BuildOptions.size_report, "w") { |f|
+		current.sort_by { |name, size| -size }.each { |name, size| f.puts("#{size} #{name}") }
+	}
+	if (previous.size != 0)
+		changes = (current.keys | previous.keys).map { |name| [name, current[name] - previous[name]] }.reject { |name, change| change == 0 }
+		puts "Function flash change since the last report: #{changes.sum { |name, change| change }} bytes in #{changes.size} functions"
+		changes.sort_by { |name, change| -change.abs }.first(20).each { |name, change|
+			puttabs("#{(change > 0) ? "+" : ""}#{change} #{name}")
+		}
+	end
+end
+
 eep_path = File.dirname($BuildOptions.output) + "/" + File.basename($BuildOptions.output) + ".eep"
 eep_ood = out_of_date(eep_path, $BuildOptions.output);
 if (!eep_ood)
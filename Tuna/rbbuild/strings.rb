@@ -0,0 +1,108 @@
+$script_mtime = [$script_mtime, File.mtime(__FILE__).to_f].max
+
+# Builds string_dictionary.h for PACKED_STRINGS: the words of the serial messages that save the most
+# flash as one-byte tokens. The messages are the literals given to SERIAL_*PGM() and SERIAL_*PAIR(),
+# with the MSG_ macros of language.h and language_en.h expanded.
+
+$STRING_DICTIONARY_WORDS = 128
+
+def string_literals(text)
+	return text.scan(/"((?:[^"\\]|\\.)*)"/).map { |m| m[0].gsub(/\\n/, "\n").gsub(/\\(.)/, '\1') }
+end
+
+# MSG_ name => its text, with the macros it names expanded
+def message_macros(root)
+	raw = Hash.new nil
+	["language.h", "language_en.h"].each { |file|
+		path = root + "/" + file
+		next if !(File.file? path)
+		File.foreach(path, encoding: "binary") { |line|
+			match = line.match(/^\s*#define\s+(MSG_\w+)\s+(.*)$/)
+			next if match == nil
+			raw[match[1]] ||= match[2].sub(/\s*\/\/.*$/, "")
+		}
+	}
+	expand = -> (value, depth) {
+		out = ""
+		value.scan(/"(?:[^"\\]|\\.)*"|MSG_\w+/) { |token|
+			if (token.start_with? '"')
+				out += string_literals(token)[0]
+			elsif (raw[token] != nil && depth < 8)
+				out += expand.(raw[token], depth + 1)
+			end
+		}
+		out
+	}
+	messages = Hash.new nil
+	raw.each { |name, value| messages[name] = expand.(value, 0) }
+	return messages
+end
+
+# The text of each SERIAL_*PGM() or SERIAL_*PAIR() string in the sources, once per use
+def serial_messages(src_dirs, root)
+	macros = message_macros(root)
+	messages = []
+	src_dirs.each { |dir|
+		Dir.glob(dir + "/**/*.{cpp,h,hpp}").each { |path|
+			text = File.read(path, encoding: "binary")
+			text.scan(/SERIAL_\w*(?:PGM|PAIR|PAIR_F)\(((?:"(?:[^"\\]|\\.)*"|[^,()"])*)/) { |m|
+				message = ""
+				m[0].scan(/"(?:[^"\\]|\\.)*"|MSG_\w+/) { |token|
+					message += (token.start_with? '"') ? string_literals(token)[0] : (macros[token] || "")
+				}
+				messages << message if message.length > 0
+			}
+		}
+	}
+	return messages
+end
+
+# Words, with a space before or after, or punctuation after, that could stand for themselves
+def word_candidates(text)
+	out = []
+	text.to_enum(:scan, /[A-Za-z][A-Za-z0-9]*/).each {
+		match = Regexp.last_match
+		first, last = match.begin(0), match.end(0)
+		starts = [first]
+		starts << first - 1 if first > 0 && text[first - 1] == " "
+		ends = [last]
+		ends << last + 1 if last < text.length && " :.,".include?(text[last])
+		starts.each { |s| ends.each { |e| out << text[s...e] if e - s >= 3 } }
+	}
+	return out
+end
+
+# Picks the words that save the most, one at a time, each taken out of the text before the next
+def pick_words(messages)
+	texts = messages.dup
+	words = []
+	while (words.length < $STRING_DICTIONARY_WORDS)
+		counts = Hash.new 0
+		texts.each { |text| word_candidates(text).each { |word| counts[word] += 1 } }
+		# Each use saves all but a byte; the word costs itself, its '\0' and its offset
+		best, saving = nil, 0
+		counts.each { |word, count|
+			s = count * (word.length - 1) - (word.length + 3)
+			best, saving = word, s if s > saving || (s == saving && best != nil && word < best)
+		}
+		break if best == nil
+		words << best
+		texts = texts.map { |text| text.gsub(best, "\x01") }
+	end
+	return words
+end
+
+# Writes the dictionary to 'path', if it isn't there, or on a rebuild. Left alone otherwise, so a
+# changed message doesn't rebuild everything that prints.
+def generate_string_dictionary(path, src_dirs, root, force)
+	return if (File.file? path) && !force
+	words = pick_words(serial_messages(src_dirs, root))
+	out = "#pragma once\n\n"
+	out += "// Generated by rbbuild/strings.rb from the serial messages: the words that save the most as\n"
+	out += "// PACKED_STRINGS tokens. A rebuild makes it again.\n"
+	out += "#define PACKED_STRING_WORDS \\\n"
+	out += words.map { |word| "  \"" + word + "\"" }.join(", \\\n") + "\n"
+	return if (File.file? path) && File.read(path) == out
+	File.write(path, out)
+	puts "String dictionary generated (#{words.length} words)"
+end
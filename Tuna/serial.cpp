@@ -34,4 +34,142 @@ void serial_echopair_P(const char* s_P, float v)         { serialprintPGM(s_P);
 void serial_echopair_P(const char* s_P, double v)        { serialprintPGM(s_P); SERIAL_ECHO(v); }
 void serial_echopair_P(const char* s_P, unsigned long v) { serialprintPGM(s_P); SERIAL_ECHO(v); }
 
+#if ENABLED(PACKED_STRINGS)
+
+  using Tuna::packed::packed_string;
+
+  // The words of PACKED_STRING_WORDS, as serialprint_packed() prints them
+  static constexpr const auto packed_words __flashmem = Tuna::packed::_internal::make_dictionary();
+
+  void serialprint_packed(const packed_string str) {
+    const uint8_t *data = str.data();
+    while (const uint8_t b = pgm_read_byte(data++)) {
+      if (b & 0x80)
+        serialprintPGM(packed_words.text + pgm_read_word(&packed_words.offset[b & 0x7F]));
+      else
+        MYSERIAL.write(b);
+    }
+  }
+
+  void serial_echopair_P(const packed_string s, const char *v)   { serialprint_packed(s); SERIAL_ECHO(v); }
+  void serial_echopair_P(const packed_string s, char v)          { serialprint_packed(s); SERIAL_CHAR(v); }
+  void serial_echopair_P(const packed_string s, int v)           { serialprint_packed(s); SERIAL_ECHO(v); }
+  void serial_echopair_P(const packed_string s, long v)          { serialprint_packed(s); SERIAL_ECHO(v); }
+  void serial_echopair_P(const packed_string s, float v)         { serialprint_packed(s); SERIAL_ECHO(v); }
+  void serial_echopair_P(const packed_string s, double v)        { serialprint_packed(s); SERIAL_ECHO(v); }
+  void serial_echopair_P(const packed_string s, unsigned long v) { serialprint_packed(s); SERIAL_ECHO(v); }
+
+#endif
+
+#if ENABLED(TX_DROP_ECHO)
+
+  #include "planner.h"
+
+  /**
+   * While moves are queued, an "echo:" line is dropped rather than wait for the host
+   * to take it, so it can't hold up the planner. Dropped lines are counted, and the
+   * count goes out once there's room for it. "ok", errors and replies without
+   * "echo:" always wait.
+   */
+  void serial_echo_start() {
+    static uint8_t dropped = 0;
+    const uint16_t total = uint16_t(dropped) + MYSERIAL.dropped_lines();
+    dropped = total > 0xFF ? 0xFF : uint8_t(total);
+    if (__unlikely(dropped) && MYSERIAL.availableForWrite() >= 24) {
+      serialprintPGM(echomagic);
+      SERIAL_ECHOPAIR("Lines dropped: ", int(dropped));
+      SERIAL_EOL();
+      dropped = 0;
+    }
+    if (planner.blocks_queued()) MYSERIAL.droppable_line();
+    serialprintPGM(echomagic);
+  }
+
+#endif
+
+#if ENABLED(EMERGENCY_PARSER)
+
+  #include "language.h"
+
+  volatile bool emergency_parser_enabled = true;
+
+  /**
+   * Follow each line as it arrives: [N<line> ]M108, M112, or M410, then a space, checksum or end
+   * of line. Anything else is ignored to the end of the line. The command acts at the end of the
+   * line, so a longer code such as M1080 doesn't trigger it. The main loop still queues it as usual.
+   */
+  void emergency_parser(const uint8_t c) {
+    static e_parser_state state = state_RESET;
+
+    if (__unlikely(!emergency_parser_enabled)) {
+      state = state_RESET;
+      return;
+    }
+
+    const bool eol = (c == '\n' || c == '\r');
+
+    switch (state) {
+      case state_RESET:
+        switch (c) {
+          case ' ': case '\n': case '\r': break;
+          case 'N': state = state_N; break;
+          case 'M': state = state_M; break;
+          default: state = state_IGNORE;
+        }
+        break;
+
+      case state_N:
+        if (NUMERIC_SIGNED(c) || c == ' ') break;
+        state = (c == 'M') ? state_M : state_IGNORE;
+        break;
+
+      case state_M:
+        switch (c) {
+          case ' ': break;
+          case '1': state = state_M1; break;
+          case '4': state = state_M4; break;
+          default: state = state_IGNORE;
+        }
+        break;
+
+      case state_M1:
+        switch (c) {
+          case '0': state = state_M10; break;
+          case '1': state = state_M11; break;
+          default: state = state_IGNORE;
+        }
+        break;
+
+      case state_M10: state = (c == '8') ? state_M108 : state_IGNORE; break;
+      case state_M11: state = (c == '2') ? state_M112 : state_IGNORE; break;
+      case state_M4:  state = (c == '1') ? state_M41 : state_IGNORE; break;
+      case state_M41: state = (c == '0') ? state_M410 : state_IGNORE; break;
+
+      case state_IGNORE:
+        if (eol) state = state_RESET;
+        break;
+
+      default: // state_M108, state_M112, state_M410
+        if (eol || c == '*') {
+          switch (state) {
+            case state_M108:
+              wait_for_heatup = false;
+              #if ENABLED(ULTIPANEL)
+                wait_for_user = false;
+              #endif
+              break;
+            case state_M112: kill(PSTR(MSG_KILLED)); break;
+            case state_M410: quickstop_stepper(); break;
+            default: break;
+          }
+          state = eol ? state_RESET : state_IGNORE;
+        }
+        else if (c != ' ') {
+          state = state_IGNORE;
+        }
+    }
+  }
+
+#endif // EMERGENCY_PARSER
+
 void serial_spaces(uint8_t count) { count *= (PROPORTIONAL_FONT_RATIO); while (count--) MYSERIAL.write(' '); }
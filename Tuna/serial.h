@@ -29,6 +29,18 @@
   #include "HardwareSerial.h"
   #if ENABLED(BLUETOOTH)
     #define MYSERIAL bluetoothSerial
+  #elif SERIAL_PORT == -1
+    #ifdef SerialUSB
+      #define MYSERIAL SerialUSB
+    #else
+      #define MYSERIAL Serial // the core's CDC port
+    #endif
+  #elif SERIAL_PORT == 1
+    #define MYSERIAL Serial1
+  #elif SERIAL_PORT == 2
+    #define MYSERIAL Serial2
+  #elif SERIAL_PORT == 3
+    #define MYSERIAL Serial3
   #else
     #define MYSERIAL Serial
   #endif // BLUETOOTH
@@ -46,13 +58,26 @@ extern const char errormagic[] __flashmem;
 #define SERIAL_PROTOCOLCHAR(x)              SERIAL_CHAR(x)
 #define SERIAL_PROTOCOL(x)                  (MYSERIAL.print(x))
 #define SERIAL_PROTOCOL_F(x,y)              (MYSERIAL.print(x,y))
-#define SERIAL_PROTOCOLPGM(x)               (serialprintPGM(PSTR(x)))
 #define SERIAL_PROTOCOLLN(x)                do{ MYSERIAL.print(x); SERIAL_EOL(); }while(0)
-#define SERIAL_PROTOCOLLNPGM(x)             (serialprintPGM(PSTR(x "\n")))
-#define SERIAL_PROTOCOLPAIR(name, value)    (serial_echopair_P(PSTR(name),(value)))
+#if ENABLED(PACKED_STRINGS)
+  #include "packed_strings.hpp"
+  using Tuna::packed::operator "" _packed;
+  #define SERIAL_PROTOCOLPGM(x)             (serialprint_packed(x ""_packed))
+  #define SERIAL_PROTOCOLLNPGM(x)           (serialprint_packed(x "\n"_packed))
+  #define SERIAL_PROTOCOLPAIR(name, value)  (serial_echopair_P(name ""_packed,(value)))
+#else
+  #define SERIAL_PROTOCOLPGM(x)             (serialprintPGM(PSTR(x)))
+  #define SERIAL_PROTOCOLLNPGM(x)           (serialprintPGM(PSTR(x "\n")))
+  #define SERIAL_PROTOCOLPAIR(name, value)  (serial_echopair_P(PSTR(name),(value)))
+#endif
 #define SERIAL_PROTOCOLLNPAIR(name, value)  do{ SERIAL_PROTOCOLPAIR(name, value); SERIAL_EOL(); }while(0)
 
-#define SERIAL_ECHO_START()            (serialprintPGM(echomagic))
+#if ENABLED(TX_DROP_ECHO)
+  void serial_echo_start();
+  #define SERIAL_ECHO_START()          serial_echo_start()
+#else
+  #define SERIAL_ECHO_START()          (serialprintPGM(echomagic))
+#endif
 #define SERIAL_ECHO(x)                 SERIAL_PROTOCOL(x)
 #define SERIAL_ECHOPGM(x)              SERIAL_PROTOCOLPGM(x)
 #define SERIAL_ECHOLN(x)               SERIAL_PROTOCOLLN(x)
@@ -86,6 +111,30 @@ inline void __forceinline serial_echopair_P(const char* s_P, uint16_t v) { seria
 inline void __forceinline serial_echopair_P(const char* s_P, bool v) { serial_echopair_P(s_P, (int)v); }
 inline void __forceinline serial_echopair_P(const char* s_P, void *v) { serial_echopair_P(s_P, (unsigned long)v); }
 
+#if ENABLED(PACKED_STRINGS)
+  void serialprint_packed(Tuna::packed::packed_string str);
+
+  void serial_echopair_P(Tuna::packed::packed_string s, const char *v);
+  void serial_echopair_P(Tuna::packed::packed_string s, char v);
+  void serial_echopair_P(Tuna::packed::packed_string s, int v);
+  void serial_echopair_P(Tuna::packed::packed_string s, long v);
+  void serial_echopair_P(Tuna::packed::packed_string s, float v);
+  void serial_echopair_P(Tuna::packed::packed_string s, double v);
+  void serial_echopair_P(Tuna::packed::packed_string s, unsigned int v);
+  void serial_echopair_P(Tuna::packed::packed_string s, unsigned long v);
+  inline void __forceinline serial_echopair_P(Tuna::packed::packed_string s, uint8_t v) { serial_echopair_P(s, (int)v); }
+  inline void __forceinline serial_echopair_P(Tuna::packed::packed_string s, uint16_t v) { serial_echopair_P(s, (int)v); }
+  inline void __forceinline serial_echopair_P(Tuna::packed::packed_string s, bool v) { serial_echopair_P(s, (int)v); }
+  inline void __forceinline serial_echopair_P(Tuna::packed::packed_string s, void *v) { serial_echopair_P(s, (unsigned long)v); }
+#endif
+
+#if ENABLED(EMERGENCY_PARSER)
+  // Called from the receive interrupt with each byte, to act on M108, M112, and M410 at once
+  void emergency_parser(const uint8_t c);
+  // Cleared while the host sends binary packets, which could look like those lines
+  extern volatile bool emergency_parser_enabled;
+#endif
+
 void serial_spaces(uint8_t count);
 #define SERIAL_ECHO_SP(C)     serial_spaces(C)
 #define SERIAL_ERROR_SP(C)    serial_spaces(C)
@@ -53,7 +53,8 @@
 #include "bi3_plus_lcd.h"
 #include "language.h"
 #include "cardreader.h"
-#include "speed_lookuptable.h"
+#include "interrupts.hpp"
+#include "fan_pwm.hpp"
 
 #if HAS_DIGIPOTSS
   #include <SPI.h>
@@ -69,11 +70,18 @@ block_t * __restrict Stepper::current_block = nullptr;  // A pointer to the bloc
 
 uint8_t Stepper::last_direction_bits = 0;        // The next stepping-bits to be output
 uint16_t Stepper::cleaning_buffer_counter = 0;
+bool Stepper::split_for_endstops = true;
 
 int24 Stepper::counter[4] = { 0,0,0,0 };
 
 uint24 Stepper::step_events_completed = 0; // The number of step events executed in the current block
 
+#if ENABLED(ARC_BLOCKS)
+  int32 Stepper::arc_x, Stepper::arc_y, Stepper::arc_x_low, Stepper::arc_y_low, Stepper::arc_one, Stepper::arc_rounding;
+  uint8 Stepper::arc_shift;
+  bool Stepper::arc_clockwise;
+#endif
+
 #if ENABLED(LIN_ADVANCE)
 
   constexpr uint16_t ADV_NEVER = 65535;
@@ -87,15 +95,44 @@ uint24 Stepper::step_events_completed = 0; // The number of step events executed
         Stepper::current_estep_rate[E_STEPPERS],
         Stepper::current_adv_steps[E_STEPPERS];
 
+  // 65536 / n, rounded up, so adv_rate() can multiply by it instead of dividing by the pending
+  // E steps. Only the upper 16 bits of the product are used. 0 and 1 are never read.
+  constexpr const uint8_t adv_reciprocal_count = 64;
+
+  constexpr flash_array<uint16_t, adv_reciprocal_count> make_adv_reciprocals() {
+    flash_array<uint16_t, adv_reciprocal_count> table {};
+    for (uint8_t n = 2; n < adv_reciprocal_count; ++n)
+      table.m_Data[n] = uint16_t((65536UL + n - 1) / n);
+    return table;
+  }
+
+  constexpr const flash_array<uint16_t, adv_reciprocal_count> adv_reciprocals __flashmem = make_adv_reciprocals();
+
   /**
    * See https://github.com/MarlinFirmware/Marlin/issues/5699#issuecomment-309264382
    *
    * This fix isn't perfect and may lose steps - but better than locking up completely
    * in future the planner should slow down if advance stepping rate would be too high
+   *
+   * The pending E steps are nearly always a few, so the division is a flash read and a
+   * 16x16 multiply, which may come out one tick long. A backlog of 64 or more still divides.
    */
   uint16_t __forceinline adv_rate(const int steps, const uint16_t timer, const uint8_t loops) {
+    #if ENABLED(LIN_ADVANCE_SHARED_TIMELINE)
+      // The E steps go out with the main ISR. There is no advance ISR to schedule.
+      UNUSED(steps); UNUSED(timer); UNUSED(loops);
+      return ADV_NEVER;
+    #endif
     if (__likely(steps != 0)) {
-      const uint16_t rate = (timer * loops) / uabs(steps);
+      const uint16_t interval = timer * loops;
+      const uint16_t pending = uabs(steps);
+      uint16_t rate;
+      if (pending == 1)
+        rate = interval;
+      else if (__likely(pending < adv_reciprocal_count))
+        rate = uint16_t((uint32_t(interval) * adv_reciprocals[pending]) >> 16);
+      else
+        rate = interval / pending;
       //return constrain(rate, 1, ADV_NEVER - 1)
       return rate ? rate : 1;
     }
@@ -107,14 +144,70 @@ uint24 Stepper::step_events_completed = 0; // The number of step events executed
 int24 Stepper::acceleration_time, Stepper::deceleration_time;
 
 volatile int24 Stepper::count_position[NUM_AXIS] = { 0 };
+Tuna::sequence_count Stepper::position_sequence;
 volatile signed char Stepper::count_direction[NUM_AXIS] = { 1, 1, 1, 1 };
 
 unsigned short Stepper::acc_step_rate; // needed for deceleration start point
-uint8_t Stepper::step_loops, Stepper::step_loops_nominal;
+uint8_t Stepper::step_loops, Stepper::step_shift;
 unsigned short Stepper::OCR1A_nominal;
 
+#if ENABLED(STEPPER_FREE_RUNNING_TIMER)
+  uint16 Stepper::last_compare = 0;
+#endif
+
+#if ENABLED(S_CURVE_ACCELERATION)
+  s_curve_t Stepper::accel_curve, Stepper::decel_curve;
+  uint16 Stepper::plateau_rate;
+#endif
+
+#if ENABLED(RAMP_TABLES)
+  Stepper::ramp_table_t Stepper::ramp_tables[2];
+  const Stepper::ramp_table_t * Stepper::ramp_table;
+  uint8 Stepper::ramp_accel_index, Stepper::ramp_decel_index;
+#endif
+
+#if ENABLED(STEP_TRACE)
+  Stepper::step_trace_t Stepper::step_trace[STEP_TRACE_LENGTH];
+  spsc_ring<STEP_TRACE_LENGTH> Stepper::step_trace_queue;
+  uint8 Stepper::step_trace_interval, Stepper::step_trace_countdown, Stepper::step_trace_block;
+#endif
+
+#if ENABLED(BABYSTEPPING)
+  volatile int8 Stepper::babysteps_queued[XYZ], Stepper::babysteps_done[XYZ];
+  uint8 Stepper::babystep_ms;
+#endif
+
+#if ENABLED(INPUT_SHAPING)
+  Stepper::shaper_t Stepper::shapers[2];
+  Stepper::shaping_event_t Stepper::shaping_queue[SHAPING_BUFFER_SIZE];
+  uint8 Stepper::shaping_head, Stepper::shaping_tail, Stepper::shaping_remainder;
+  int8 Stepper::shaping_input[2];
+  uint16 Stepper::shaping_now, Stepper::shaping_interval;
+  float Stepper::shaping_frequency[2] = { SHAPING_FREQ_X, SHAPING_FREQ_Y },
+        Stepper::shaping_zeta[2] = { SHAPING_ZETA_X, SHAPING_ZETA_Y };
+  uint8 Stepper::shaping_type[2] = { SHAPING_TYPE_X, SHAPING_TYPE_Y };
+#endif
+
+#if ENABLED(STEP_QUEUE_MODE)
+  step_run_t Stepper::step_runs[NUM_AXIS][STEP_QUEUE_MOVES];
+  spsc_ring<STEP_QUEUE_MOVES> Stepper::step_run_queue[NUM_AXIS];
+  Stepper::step_axis_t Stepper::step_axes[NUM_AXIS];
+  uint32 Stepper::step_queue_now;
+  uint16 Stepper::step_queue_interval;
+  volatile bool Stepper::step_queue_active = false;
+  volatile uint8 Stepper::step_queue_halted;
+  volatile uint16 Stepper::step_queue_late;
+#endif
+
 volatile int24 Stepper::endstops_trigsteps[XYZ];
 
+#if ENABLED(ENDSTOP_EDGE_LATCH)
+  int24 Stepper::endstops_edgesteps[XYZ];
+  chrono::time_ticks Stepper::endstops_edgetime[XYZ];
+  uint8_t Stepper::endstops_latched = 0;
+  volatile uint16_t Stepper::endstops_triglag[XYZ];
+#endif
+
 #define X_APPLY_DIR(v,Q) X_DIR_WRITE(v)
 #define X_APPLY_STEP(v,Q) X_STEP_WRITE(v)
 
@@ -126,28 +219,6 @@ volatile int24 Stepper::endstops_trigsteps[XYZ];
 
 #define E_APPLY_STEP(v,Q) E_STEP_WRITE(v)
 
-// intRes = longIn1 * longIn2 >> 24
-// uses:
-// r26 to store 0
-// r27 to store bits 16-23 of the 48bit result. The top bit is used to round the two byte result.
-// note that the lower two bytes and the upper byte of the 48bit result are not calculated.
-// this can cause the result to be out by one as the lower bytes may cause carries into the upper ones.
-// B0 A0 are bits 24-39 and are the returned value
-// C1 B1 A1 is longIn1
-// D2 C2 B2 A2 is longIn2
-//
-inline uint16 __forceinline __flatten MultiU24X24toH16(arg_type<uint24> a, arg_type<uint24> b)
-{
-  const uint64 oper1 = uint64(a);
-  __assume(oper1 <= type_trait<uint24>::max);
-  const uint24 oper2 = uint24(b);
-  __assume(oper2 <= type_trait<uint24>::max);
-  const uint64 mul_result = oper1 * oper2;
-  __assume(mul_result <= (uint64(type_trait<uint24>::max) * type_trait<uint24>::max));
-  const uint16 result = uint16(mul_result >> 24_u8);
-  return result;
-}
-
 // Some useful constants
 
 #define ENABLE_STEPPER_DRIVER_INTERRUPT()  SBI(TIMSK1, OCIE1A)
@@ -182,15 +253,56 @@ void __forceinline __flatten Stepper::wake_up() {
  *   COREXZ: X_AXIS=A_AXIS and Z_AXIS=C_AXIS
  *   COREYZ: Y_AXIS=B_AXIS and Z_AXIS=C_AXIS
  */
+#if ENABLED(DIR_PORT_GROUPING)
+
+  static_assert(
+    Tuna::io::pin<X_DIR_PIN>::output == Tuna::io::pin<Y_DIR_PIN>::output &&
+    Tuna::io::pin<X_DIR_PIN>::output == Tuna::io::pin<Z_DIR_PIN>::output,
+    "DIR_PORT_GROUPING needs the X, Y and Z direction pins on one port"
+  );
+
+  void __forceinline __flatten Stepper::set_directions(const uint8 port_bits) {
+    constexpr const uint8 dir_mask = _BV(X_DIR_BIT) | _BV(Y_DIR_BIT) | _BV(Z_DIR_BIT);
+
+    // The direction pin of a shaped axis follows the steps the shaper puts out, not the block
+    #if ENABLED(INPUT_SHAPING)
+      const uint8 mask = dir_mask & ~((is_shaped(X_AXIS) ? _BV(X_DIR_BIT) : 0) | (is_shaped(Y_AXIS) ? _BV(Y_DIR_BIT) : 0));
+    #else
+      constexpr const uint8 mask = dir_mask;
+    #endif
+
+    {
+      Tuna::critical_section _critsec;
+      X_DIR_PORT = (X_DIR_PORT & ~mask) | (port_bits & mask);
+    }
+
+    count_direction[X_AXIS] = motor_direction(X_AXIS) ? -1 : 1;
+    count_direction[Y_AXIS] = motor_direction(Y_AXIS) ? -1 : 1;
+    count_direction[Z_AXIS] = motor_direction(Z_AXIS) ? -1 : 1;
+  }
+
+  void __forceinline __flatten Stepper::set_directions() {
+    set_directions(dir_port_bits(last_direction_bits));
+  }
+
+#else
+
 void __forceinline __flatten Stepper::set_directions() {
 
+  // The direction pin of a shaped axis follows the steps the shaper puts out, not the block
+  #if ENABLED(INPUT_SHAPING)
+    #define SHAPED_APPLY_DIR(AXIS, v) if (!is_shaped(AXIS ##_AXIS)) { AXIS ##_APPLY_DIR(v, false); }
+  #else
+    #define SHAPED_APPLY_DIR(AXIS, v) AXIS ##_APPLY_DIR(v, false)
+  #endif
+
   #define SET_STEP_DIR(AXIS) \
     if (motor_direction(AXIS ##_AXIS)) { \
-      AXIS ##_APPLY_DIR(INVERT_## AXIS ##_DIR, false); \
+      SHAPED_APPLY_DIR(AXIS, INVERT_## AXIS ##_DIR); \
       count_direction[AXIS ##_AXIS] = -1; \
     } \
     else { \
-      AXIS ##_APPLY_DIR(!INVERT_## AXIS ##_DIR, false); \
+      SHAPED_APPLY_DIR(AXIS, !INVERT_## AXIS ##_DIR); \
       count_direction[AXIS ##_AXIS] = 1; \
     }
 
@@ -199,6 +311,8 @@ void __forceinline __flatten Stepper::set_directions() {
   SET_STEP_DIR(Z); // C
 }
 
+#endif // DIR_PORT_GROUPING
+
 #if ENABLED(ENDSTOP_INTERRUPTS_FEATURE)
   extern volatile uint8_t e_hit;
 #endif
@@ -219,6 +333,17 @@ void __forceinline __flatten Stepper::set_directions() {
  */
 __signal(TIMER1_COMPA)
 {
+  // Every change to count_position and what live_position() reads is made in here
+  const Tuna::sequence_count::writer _written(Stepper::position_sequence);
+
+  #if ENABLED(STEP_QUEUE_MODE)
+    if (__unlikely(Stepper::step_queue_active))
+    {
+      Stepper::step_queue_isr();
+      return;
+    }
+  #endif
+
   if (__unlikely(ENDSTOPS_ENABLED))
   {
     Stepper::advance_isr_scheduler<true>();
@@ -245,7 +370,7 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
     ocr_val = value16;
     if constexpr(endstops_enabled)
     {
-      if (value > ENDSTOP_NOMINAL_OCR_VAL)
+      if (value > ENDSTOP_NOMINAL_OCR_VAL && split_for_endstops)
       {
         const uint16_t remainder = value16 % (ENDSTOP_NOMINAL_OCR_VAL);
         ocr_val = (remainder < OCR_VAL_TOLERANCE) ? ENDSTOP_NOMINAL_OCR_VAL + remainder : ENDSTOP_NOMINAL_OCR_VAL;
@@ -270,12 +395,23 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
 
       _NEXT_ISR(ocr_val);
 
-      NOLESS(OCR1A, TCNT1 + 16);
+      #if DISABLED(STEPPER_FREE_RUNNING_TIMER)
+        NOLESS(OCR1A, TCNT1 + 16);
+      #endif
 
       return;
     }
   }
 
+  #if ENABLED(INPUT_SHAPING)
+    {
+      // The time passed since the last ISR that stepped, however it was split
+      const uint24 ticks = uint24(shaping_interval) + shaping_remainder;
+      shaping_now += uint16(ticks >> 3);
+      shaping_remainder = uint8(ticks & 7);
+    }
+  #endif
+
   if (__unlikely(cleaning_buffer_counter != 0)) {
     --cleaning_buffer_counter;
     current_block = nullptr;
@@ -283,10 +419,19 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
     #ifdef SD_FINISHED_RELEASECOMMAND
       if (!cleaning_buffer_counter && (SD_FINISHED_STEPPERRELEASE)) enqueue_and_echo_commands(SD_FINISHED_RELEASECOMMAND);
     #endif
+    // The delayed steps are let out, so the motors end up where count_position says
+    #if ENABLED(INPUT_SHAPING)
+      shaping_isr();
+    #endif
     _NEXT_ISR(200); // Run at max speed - 10 KHz
+    _SHAPING_INTERVAL(200);
     return;
   }
 
+  #if ENABLED(BABYSTEPPING)
+    babystep_isr();
+  #endif
+
   // If there is no current block, attempt to pop one from the buffer
   if (__unlikely(current_block == nullptr)) {
     // Anything in the buffer?
@@ -294,11 +439,35 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
     if (__likely(current_block != nullptr)) {
       trapezoid_generator_reset();
 
+      #if ENABLED(MOTION_SYNC_EVENTS)
+        Planner::sync_events_due += current_block->sync_events;
+      #endif
+
+      #if ENABLED(FAN_HARDWARE_PWM)
+        Tuna::fan_pwm::set(current_block->fan_speed[0]); // The fan changes as the block starts
+      #endif
+
+      #if ENABLED(STEP_TRACE)
+        ++step_trace_block;
+      #endif
+
       __assume(current_block->step_event_count > 0);
 
       // Initialize Bresenham counters to 1/2 the ceiling
       counter[3] = counter[2] = counter[1] = counter[0] = -(current_block->step_event_count >> 1);
 
+      // Long intervals are only split to sample the endstops in between. A block that takes no
+      // axis toward one, such as a homing bump backing off, steps once per interval.
+      #if IS_CORE || ENABLED(DUAL_X_CARRIAGE) || ENABLED(G38_PROBE_TARGET)
+        split_for_endstops = true;
+      #else
+        #define _TOWARD_ENDSTOP(A, MIN, MAX) (current_block->steps[_AXIS(A)] && (TEST(current_block->direction_bits, _AXIS(A)) ? (MIN) : (MAX)))
+        split_for_endstops = _TOWARD_ENDSTOP(X, HAS_X_MIN, HAS_X_MAX)
+                          || _TOWARD_ENDSTOP(Y, HAS_Y_MIN, HAS_Y_MAX)
+                          || _TOWARD_ENDSTOP(Z, HAS_Z_MIN || ENABLED(Z_MIN_PROBE_ENDSTOP), HAS_Z_MAX);
+        #undef _TOWARD_ENDSTOP
+      #endif
+
       #if ENABLED(MIXING_EXTRUDER)
         MIXING_STEPPERS_LOOP(i)
           counter_m[i] = -(current_block->mix_event_count[i] >> 1);
@@ -306,6 +475,25 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
 
       step_events_completed = 0;
 
+      #if ENABLED(ARC_BLOCKS)
+        if (TEST(current_block->flag, BLOCK_BIT_ARC)) {
+          const arc_t & __restrict arc = current_block->arc;
+          arc_x = arc.x;
+          arc_y = arc.y;
+          arc_shift = arc.shift;
+          arc_clockwise = arc.clockwise;
+          arc_one = 1_i32 << (30 - arc.shift);
+          arc_rounding = 1_i32 << (arc.shift - 1);
+          // The motors are on the step nearest the point, so it starts in the middle of it
+          arc_x_low = arc_x - (arc_one >> 1);
+          arc_y_low = arc_y - (arc_one >> 1);
+        }
+      #endif
+
+      #if ENABLED(ENDSTOP_EDGE_LATCH)
+        endstops_latched = 0; // An endstop already closed has no edge in this block
+      #endif
+
       #if ENABLED(ENDSTOP_INTERRUPTS_FEATURE)
         e_hit = 2; // Needed for the case an endstop is already triggered before the new move begins.
                    // No 'change' can be detected.
@@ -315,13 +503,21 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
         if (current_block->steps[Z_AXIS] > 0) {
           enable_Z();
           _NEXT_ISR(2000); // Run at slow speed - 1 KHz
-          _ENABLE_ISRs(); // re-enable ISRs
+          _SHAPING_INTERVAL(2000);
           return;
         }
       #endif
     }
     else {
-      _NEXT_ISR(2000); // Run at slow speed - 1 KHz
+      #if ENABLED(INPUT_SHAPING)
+        // Wake up for the next delayed step, rather than a millisecond later
+        shaping_isr();
+        const uint16 wait = shaping_wait(2000);
+        _NEXT_ISR(wait);
+        _SHAPING_INTERVAL(wait);
+      #else
+        _NEXT_ISR(2000); // Run at slow speed - 1 KHz
+      #endif
       return;
     }
   }
@@ -341,14 +537,29 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
 
   // Take multiple steps per interrupt (For high speed moves)
   bool all_steps_done = false;
+  #if ENABLED(ARC_BLOCKS)
+    if (__unlikely(TEST(current_block->flag, BLOCK_BIT_ARC)))
+      all_steps_done = arc_steps();
+    else
+  #endif
   for (uint8_t i = step_loops; __likely(i--);) {
+
+    // With LAZY_STEP_POSITION the Bresenham counters keep the block's steps, so the position
+    // isn't touched until the block ends
+    #if ENABLED(LAZY_STEP_POSITION)
+      #define _COUNT_STEP(AXIS) NOOP
+    #else
+      #define _COUNT_STEP(AXIS) \
+        __assume(count_direction[_AXIS(AXIS)] == -1 || count_direction[_AXIS(AXIS)] == 1); \
+        count_position[_AXIS(AXIS)] += count_direction[_AXIS(AXIS)]
+    #endif
+
     #if ENABLED(LIN_ADVANCE)
       counter[E_AXIS] += current_block->steps[E_AXIS];
       if (counter[E_AXIS] > 0) {
         counter[E_AXIS] -= current_block->step_event_count;
         // Don't step E here for mixing extruder
-        __assume(count_direction[E_AXIS] == -1 || count_direction[E_AXIS] == 1);
-        count_position[E_AXIS] += count_direction[E_AXIS];
+        _COUNT_STEP(E);
         __unlikely(motor_direction(E_AXIS)) ? --e_steps[TOOL_E_INDEX] : ++e_steps[TOOL_E_INDEX];
       }
     #endif // LIN_ADVANCE
@@ -366,11 +577,27 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
     #define PULSE_STOP(AXIS) \
       if (_COUNTER(AXIS) > 0) { \
         _COUNTER(AXIS) -= current_block->step_event_count; \
-        __assume(count_direction[_AXIS(AXIS)] == -1 || count_direction[_AXIS(AXIS)] == 1); \
-        count_position[_AXIS(AXIS)] += count_direction[_AXIS(AXIS)]; \
+        _COUNT_STEP(AXIS); \
         _APPLY_STEP(AXIS)(_INVERT_STEP_PIN(AXIS),0); \
       }
 
+    // A shaped axis only counts its step here, for shaping_isr() to put out. The counter is
+    // left at or below 0, so PULSE_STOP leaves it alone.
+    #if ENABLED(INPUT_SHAPING)
+      #define SHAPED_PULSE_START(AXIS) \
+        if (is_shaped(_AXIS(AXIS))) { \
+          _COUNTER(AXIS) += current_block->steps[_AXIS(AXIS)]; \
+          if (_COUNTER(AXIS) > 0) { \
+            _COUNTER(AXIS) -= current_block->step_event_count; \
+            _COUNT_STEP(AXIS); \
+            shaping_input[_AXIS(AXIS)] += count_direction[_AXIS(AXIS)]; \
+          } \
+        } \
+        else { PULSE_START(AXIS); }
+    #else
+      #define SHAPED_PULSE_START(AXIS) PULSE_START(AXIS)
+    #endif
+
     /**
      * Estimate the number of cycles that the stepper logic already takes
      * up between the start and stop of the X stepper pulse.
@@ -402,13 +629,59 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
      * 20 counts of TCNT0 -by itself- is a good pulse delay.
      * 10µs = 160 or 200 cycles.
      */
-    #if EXTRA_CYCLES_XYZE > 20
-      uint32 pulse_start = TCNT0;
-    #endif
+    #if ENABLED(STEP_PORT_GROUPING)
+
+      // Collect the step bits of each axis, then fold an axis into an axis before it
+      // that shares its port and inversion. The port comparisons are folded by the compiler.
+      uint8 step_bits[XYZ] = { 0, 0, 0 };
+
+      #undef PULSE_START
+      #define PULSE_START(AXIS) \
+        _COUNTER(AXIS) += current_block->steps[_AXIS(AXIS)]; \
+        if (_COUNTER(AXIS) > 0) { step_bits[_AXIS(AXIS)] = _bv<AXIS ##_STEP_BIT>; }
+
+      #undef PULSE_STOP
+      #define PULSE_STOP(AXIS) \
+        if (_COUNTER(AXIS) > 0) { \
+          _COUNTER(AXIS) -= current_block->step_event_count; \
+          _COUNT_STEP(AXIS); \
+        }
+
+      #define _SAME_STEP_PORT(A,B) (&A ##_STEP_PORT == &B ##_STEP_PORT && _INVERT_STEP_PIN(A) == _INVERT_STEP_PIN(B))
+      #define _FOLD_STEP_BITS(A,B) step_bits[_AXIS(B)] |= step_bits[_AXIS(A)]; step_bits[_AXIS(A)] = 0
+
+      // Interrupts are off in here, so a read-modify-write of the ports is safe
+      #define STEP_PORT_WRITE(AXIS, ON) \
+        if ((ON) != _INVERT_STEP_PIN(AXIS)) { AXIS ##_STEP_PORT |= step_bits[_AXIS(AXIS)]; } \
+        else { AXIS ##_STEP_PORT &= ~step_bits[_AXIS(AXIS)]; }
+
+      SHAPED_PULSE_START(X);
+      SHAPED_PULSE_START(Y);
+      PULSE_START(Z);
+
+      if (_SAME_STEP_PORT(Y, X)) { _FOLD_STEP_BITS(Y, X); }
+      if (_SAME_STEP_PORT(Z, X)) { _FOLD_STEP_BITS(Z, X); }
+      else if (_SAME_STEP_PORT(Z, Y)) { _FOLD_STEP_BITS(Z, Y); }
+
+      #if EXTRA_CYCLES_XYZE > 20
+        uint32 pulse_start = TCNT0;
+      #endif
+
+      STEP_PORT_WRITE(X, true);
+      STEP_PORT_WRITE(Y, true);
+      STEP_PORT_WRITE(Z, true);
+
+    #else
+
+      #if EXTRA_CYCLES_XYZE > 20
+        uint32 pulse_start = TCNT0;
+      #endif
 
-    PULSE_START(X);
-    PULSE_START(Y);
-    PULSE_START(Z);
+      SHAPED_PULSE_START(X);
+      SHAPED_PULSE_START(Y);
+      PULSE_START(Z);
+
+    #endif
 
     // For minimum pulse time wait before stopping pulses
     #if EXTRA_CYCLES_XYZE > 20
@@ -418,6 +691,12 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
       DELAY_NOPS(EXTRA_CYCLES_XYZE);
     #endif
 
+    #if ENABLED(STEP_PORT_GROUPING)
+      STEP_PORT_WRITE(X, false);
+      STEP_PORT_WRITE(Y, false);
+      STEP_PORT_WRITE(Z, false);
+    #endif
+
     PULSE_STOP(X);
     PULSE_STOP(Y);
     PULSE_STOP(Z);
@@ -437,8 +716,12 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
 
   } // steps_loop
 
+  #if ENABLED(INPUT_SHAPING)
+    shaping_isr();
+  #endif
+
   #if ENABLED(LIN_ADVANCE)
-    if (current_block->use_advance_lead) {
+    if (TEST(current_block->flag, BLOCK_BIT_USE_ADVANCE_LEAD)) {
       const int delta_adv_steps = current_estep_rate[TOOL_E_INDEX] - current_adv_steps[TOOL_E_INDEX];
       current_adv_steps[TOOL_E_INDEX] += delta_adv_steps;
       // For most extruders, advance the single E stepper
@@ -455,17 +738,40 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
   // Calculate new timer value
   if (step_events_completed <= current_block->accelerate_until) {
 
-    acc_step_rate = MultiU24X24toH16(acceleration_time, current_block->acceleration_rate);
-    acc_step_rate += current_block->initial_rate;
-
-    // upper limit
-    if (__unlikely(acc_step_rate > current_block->nominal_rate))
+    // Take more steps per ISR once the ramp passes the next planned crossing
+    if (step_shift < MAX_STEP_SHIFT && step_events_completed >= current_block->step_shift_up_at[step_shift])
     {
-      acc_step_rate = current_block->nominal_rate;
+      set_step_shift(step_shift + 1);
     }
 
-    // step_rate to timer interval
-    const uint16_t timer = calc_timer(acc_step_rate);
+    uint16_t timer;
+
+    #if ENABLED(RAMP_TABLES)
+      if (ramp_table && ramp_accel_index < ramp_table->accel_length)
+      {
+        const ramp_table_t::interval_t &interval = ramp_table->accel[ramp_accel_index++];
+        acc_step_rate = interval.rate;
+        timer = interval.timer;
+      }
+      else
+    #endif
+    {
+      #if ENABLED(S_CURVE_ACCELERATION)
+        acc_step_rate = s_curve_rate(acceleration_time, accel_curve, current_block->initial_rate, plateau_rate);
+      #else
+        acc_step_rate = uint16(Tuna::intrinsic::mul_shift<24>(uint24(acceleration_time), current_block->acceleration_rate));
+        acc_step_rate += current_block->initial_rate;
+
+        // upper limit
+        if (__unlikely(acc_step_rate > current_block->nominal_rate))
+        {
+          acc_step_rate = current_block->nominal_rate;
+        }
+      #endif
+
+      // step_rate to timer interval
+      timer = calc_timer(acc_step_rate, step_shift);
+    }
 
     split(timer);  // split step into multiple ISRs if larger than  ENDSTOP_NOMINAL_OCR_VAL
     _NEXT_ISR(ocr_val);
@@ -474,27 +780,52 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
 
     #if ENABLED(LIN_ADVANCE)
 
-      if (current_block->use_advance_lead) {
+      if (TEST(current_block->flag, BLOCK_BIT_USE_ADVANCE_LEAD)) {
         current_estep_rate[TOOL_E_INDEX] = ((uint32)acc_step_rate * current_block->abs_adv_steps_multiplier8) >> 17;
       }
     #endif // LIN_ADVANCE
 
-    eISR_Rate = adv_rate(e_steps[TOOL_E_INDEX], timer, step_loops);
+    #if ENABLED(LIN_ADVANCE)
+      eISR_Rate = adv_rate(e_steps[TOOL_E_INDEX], timer, step_loops);
+    #endif
   }
   else if (step_events_completed > current_block->decelerate_after) {
-    uint16_t step_rate = MultiU24X24toH16(deceleration_time, current_block->acceleration_rate);
-
-    if (step_rate < acc_step_rate) { // Still decelerating?
-      step_rate = acc_step_rate - step_rate;
-      NOLESS(step_rate, current_block->final_rate);
-    }
-    else
+    // Take fewer steps per ISR once the ramp falls past the next planned crossing
+    if (step_shift && step_events_completed > current_block->step_shift_down_after[step_shift - 1])
     {
-      step_rate = current_block->final_rate;
+      set_step_shift(step_shift - 1);
     }
 
-    // step_rate to timer interval
-    const uint16_t timer = calc_timer(step_rate);
+    uint16_t step_rate, timer;
+
+    #if ENABLED(RAMP_TABLES)
+      if (ramp_table && ramp_decel_index < ramp_table->decel_length)
+      {
+        const ramp_table_t::interval_t &interval = ramp_table->decel[ramp_decel_index++];
+        step_rate = interval.rate;
+        timer = interval.timer;
+      }
+      else
+    #endif
+    {
+      #if ENABLED(S_CURVE_ACCELERATION)
+        step_rate = s_curve_rate(deceleration_time, decel_curve, plateau_rate, current_block->final_rate);
+      #else
+        step_rate = uint16(Tuna::intrinsic::mul_shift<24>(uint24(deceleration_time), current_block->acceleration_rate));
+
+        if (step_rate < acc_step_rate) { // Still decelerating?
+          step_rate = acc_step_rate - step_rate;
+          NOLESS(step_rate, current_block->final_rate);
+        }
+        else
+        {
+          step_rate = current_block->final_rate;
+        }
+      #endif
+
+      // step_rate to timer interval
+      timer = calc_timer(step_rate, step_shift);
+    }
 
     split(timer);  // split step into multiple ISRs if larger than  ENDSTOP_NOMINAL_OCR_VAL
     _NEXT_ISR(ocr_val);
@@ -503,7 +834,7 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
 
     #if ENABLED(LIN_ADVANCE)
 
-      if (current_block->use_advance_lead) {
+      if (TEST(current_block->flag, BLOCK_BIT_USE_ADVANCE_LEAD)) {
         current_estep_rate[TOOL_E_INDEX] = ((uint32)step_rate * current_block->abs_adv_steps_multiplier8) >> 17;
       }
     #endif // LIN_ADVANCE
@@ -515,29 +846,545 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
   else {
     acc_step_rate = current_block->nominal_rate;
 
+    // ensure we're running at the correct step rate, even if we just came off an acceleration
+    set_step_shift(current_block->nominal_step_shift);
+
     #if ENABLED(LIN_ADVANCE)
 
-      if (current_block->use_advance_lead)
+      if (TEST(current_block->flag, BLOCK_BIT_USE_ADVANCE_LEAD))
         current_estep_rate[TOOL_E_INDEX] = final_estep_rate;
 
-      eISR_Rate = adv_rate(e_steps[TOOL_E_INDEX], OCR1A_nominal, step_loops_nominal);
+      eISR_Rate = adv_rate(e_steps[TOOL_E_INDEX], OCR1A_nominal, step_loops);
 
     #endif
 
     split(OCR1A_nominal);  // split step into multiple ISRs if larger than  ENDSTOP_NOMINAL_OCR_VAL
     _NEXT_ISR(ocr_val);
-
-    // ensure we're running at the correct step rate, even if we just came off an acceleration
-    step_loops = step_loops_nominal;
   }
 
+  #if ENABLED(STEP_TRACE)
+    if (step_trace_interval && !--step_trace_countdown) {
+      step_trace_countdown = step_trace_interval;
+      if (!step_trace_queue.full()) {
+        step_trace_t & __restrict entry = step_trace[step_trace_queue.head()];
+        entry.block = step_trace_block;
+        entry.step_loops = step_loops;
+        entry.direction_bits = current_block->direction_bits;
+        entry.step_events_completed = step_events_completed;
+        entry.interval = endstops_enabled ? uint16(ocr_val + step_remaining) : ocr_val; // The whole interval, however it was split
+        step_trace_queue.push();
+      }
+    }
+  #endif
+
+  _SHAPING_INTERVAL(endstops_enabled ? uint16(ocr_val + step_remaining) : ocr_val);
+
   // If current block is finished, reset pointer
   if (__unlikely(all_steps_done)) {
+    #if ENABLED(LAZY_STEP_POSITION)
+      // Every step of the block is out. A killed block has its steps at 0 by now.
+      #if ENABLED(ARC_BLOCKS)
+        if (!TEST(current_block->flag, BLOCK_BIT_ARC))
+      #endif
+      LOOP_XYZE(i) {
+        const int24 steps = current_block->steps[i];
+        count_position[i] += motor_direction(AxisEnum(i)) ? -steps : steps;
+      }
+    #endif
     current_block = nullptr;
     planner.discard_current_block();
   }
 }
 
+#if ENABLED(ARC_BLOCKS)
+
+  // Point an arc axis for a step of STEP (1 or -1), keeping last_direction_bits as the pins are
+  #define ARC_STEP_DIR(AXIS, STEP) \
+    if ((STEP) && (STEP) != count_direction[_AXIS(AXIS)]) { \
+      count_direction[_AXIS(AXIS)] = (STEP); \
+      if ((STEP) < 0) { \
+        SBI(last_direction_bits, _AXIS(AXIS)); \
+        SHAPED_APPLY_DIR(AXIS, INVERT_## AXIS ##_DIR); \
+      } \
+      else { \
+        CBI(last_direction_bits, _AXIS(AXIS)); \
+        SHAPED_APPLY_DIR(AXIS, !INVERT_## AXIS ##_DIR); \
+      } \
+    }
+
+  // Step X or Y when the point has crossed into the next step, or back into the one before
+  #define ARC_STEP_EDGE(P, STEP) \
+    if (arc_##P - arc_##P##_low >= arc_one) { arc_##P##_low += arc_one; STEP = 1; } \
+    else if (arc_##P < arc_##P##_low) { arc_##P##_low -= arc_one; STEP = -1; }
+
+  // One pulse of X, Y and Z, with the pulse timing of the line steps
+  void __forceinline __flatten Stepper::arc_pulse(int8 step_x, int8 step_y, const bool step_z) {
+    ARC_STEP_DIR(X, step_x);
+    ARC_STEP_DIR(Y, step_y);
+
+    // The steps of a shaped axis are counted and left to shaping_isr()
+    #if ENABLED(INPUT_SHAPING)
+      #define ARC_SHAPED_STEP(AXIS, STEP) \
+        if ((STEP) && is_shaped(_AXIS(AXIS))) { \
+          count_position[_AXIS(AXIS)] += (STEP); \
+          shaping_input[_AXIS(AXIS)] += (STEP); \
+          STEP = 0; \
+        }
+      ARC_SHAPED_STEP(X, step_x);
+      ARC_SHAPED_STEP(Y, step_y);
+    #endif
+
+    #if EXTRA_CYCLES_XYZE > 20
+      uint32 pulse_start = TCNT0;
+    #endif
+
+    if (step_x) X_APPLY_STEP(!_INVERT_STEP_PIN(X), 0);
+    if (step_y) Y_APPLY_STEP(!_INVERT_STEP_PIN(Y), 0);
+    if (step_z) Z_APPLY_STEP(!_INVERT_STEP_PIN(Z), 0);
+
+    #if EXTRA_CYCLES_XYZE > 20
+      while (EXTRA_CYCLES_XYZE > (uint32)(TCNT0 - pulse_start) * (INT0_PRESCALER)) { /* nada */ }
+      pulse_start = TCNT0;
+    #elif EXTRA_CYCLES_XYZE > 0
+      DELAY_NOPS(EXTRA_CYCLES_XYZE);
+    #endif
+
+    if (step_x) {
+      count_position[X_AXIS] += step_x;
+      X_APPLY_STEP(_INVERT_STEP_PIN(X), 0);
+    }
+    if (step_y) {
+      count_position[Y_AXIS] += step_y;
+      Y_APPLY_STEP(_INVERT_STEP_PIN(Y), 0);
+    }
+    if (step_z) {
+      __assume(count_direction[Z_AXIS] == -1 || count_direction[Z_AXIS] == 1);
+      count_position[Z_AXIS] += count_direction[Z_AXIS];
+      Z_APPLY_STEP(_INVERT_STEP_PIN(Z), 0);
+    }
+
+    #if EXTRA_CYCLES_XYZE > 20
+      while (EXTRA_CYCLES_XYZE > (uint32)(TCNT0 - pulse_start) * (INT0_PRESCALER)) { /* nada */ }
+    #elif EXTRA_CYCLES_XYZE > 0
+      DELAY_NOPS(EXTRA_CYCLES_XYZE);
+    #endif
+  }
+
+  /**
+   * The step events of an arc block. Each one turns the point about the center (see arc_t)
+   * and steps X and Y to follow it. Z and E are stepped as in a line. Returns true when the
+   * block is done.
+   */
+  bool __forceinline __flatten Stepper::arc_steps() {
+    for (uint8_t i = step_loops; __likely(i--);) {
+      #if ENABLED(LIN_ADVANCE)
+        counter[E_AXIS] += current_block->steps[E_AXIS];
+        if (counter[E_AXIS] > 0) {
+          counter[E_AXIS] -= current_block->step_event_count;
+          __assume(count_direction[E_AXIS] == -1 || count_direction[E_AXIS] == 1);
+          count_position[E_AXIS] += count_direction[E_AXIS];
+          __unlikely(motor_direction(E_AXIS)) ? --e_steps[TOOL_E_INDEX] : ++e_steps[TOOL_E_INDEX];
+        }
+      #endif
+
+      // Minsky's turn: the second axis uses the first one's new value, which keeps it on an ellipse
+      if (arc_clockwise) {
+        arc_x += (arc_y + arc_rounding) >> arc_shift;
+        arc_y -= (arc_x + arc_rounding) >> arc_shift;
+      }
+      else {
+        arc_x -= (arc_y + arc_rounding) >> arc_shift;
+        arc_y += (arc_x + arc_rounding) >> arc_shift;
+      }
+
+      int8 step_x = 0, step_y = 0;
+      ARC_STEP_EDGE(x, step_x);
+      ARC_STEP_EDGE(y, step_y);
+
+      counter[Z_AXIS] += current_block->steps[Z_AXIS];
+      const bool step_z = counter[Z_AXIS] > 0;
+      if (step_z) counter[Z_AXIS] -= current_block->step_event_count;
+
+      arc_pulse(step_x, step_y, step_z);
+
+      if (__unlikely(++step_events_completed >= current_block->step_event_count)) {
+        // The ellipse and the rounded turn land within a step or two of the target, so step the
+        // rest of the way, so that the planner and the stepper agree on the position
+        for (uint8 n = 4; n--;) {
+          const int24 dx = current_block->arc.end_x - count_position[X_AXIS],
+                      dy = current_block->arc.end_y - count_position[Y_AXIS];
+          if (!dx && !dy) break;
+          arc_pulse(dx > 0 ? 1 : (dx < 0 ? -1 : 0), dy > 0 ? 1 : (dy < 0 ? -1 : 0), false);
+        }
+        return true;
+      }
+    }
+    return false;
+  }
+
+#endif // ARC_BLOCKS
+
+#if ENABLED(INPUT_SHAPING)
+
+  // Put out the whole steps of an axis's residue, pointing the direction pin first
+  #define SHAPED_STEPS(AXIS) { \
+    shaper_t & __restrict s = shapers[_AXIS(AXIS)]; \
+    while (s.residue >= 128 || s.residue < -128) { \
+      const bool reverse = s.residue < 0; \
+      if (reverse != s.reverse) { \
+        s.reverse = reverse; \
+        AXIS ##_APPLY_DIR(reverse ? INVERT_## AXIS ##_DIR : !INVERT_## AXIS ##_DIR, false); \
+      } \
+      s.residue += reverse ? 256 : -256; \
+      SHAPED_PULSE_WAIT_START(); \
+      AXIS ##_APPLY_STEP(!_INVERT_STEP_PIN(AXIS), 0); \
+      SHAPED_PULSE_WAIT(); \
+      AXIS ##_APPLY_STEP(_INVERT_STEP_PIN(AXIS), 0); \
+      SHAPED_PULSE_WAIT(); \
+    } \
+  }
+
+  #if EXTRA_CYCLES_XYZE > 20
+    #define SHAPED_PULSE_WAIT_START() uint32 pulse_start = TCNT0
+    #define SHAPED_PULSE_WAIT() while (EXTRA_CYCLES_XYZE > (uint32)(TCNT0 - pulse_start) * (INT0_PRESCALER)) { /* nada */ } pulse_start = TCNT0
+  #elif EXTRA_CYCLES_XYZE > 0
+    #define SHAPED_PULSE_WAIT_START() NOOP
+    #define SHAPED_PULSE_WAIT() DELAY_NOPS(EXTRA_CYCLES_XYZE)
+  #else
+    #define SHAPED_PULSE_WAIT_START() NOOP
+    #define SHAPED_PULSE_WAIT() NOOP
+  #endif
+
+  /**
+   * Put out the shaped steps due by shaping_now: the first part of the steps this ISR took,
+   * and the delayed parts of earlier ones that have come due. The steps are queued for the
+   * delayed parts, and go into the newest entry if it's less than SHAPING_MERGE_TIME old, so
+   * the queue holds a fixed span of time whatever the step rate. With the queue full, they go
+   * out whole, unshaped.
+   */
+  void __forceinline __flatten Stepper::shaping_isr() {
+    constexpr const uint8 mask = SHAPING_BUFFER_SIZE - 1;
+    constexpr const uint16 merge_time = SHAPING_MERGE_TIME / 4; // In 4 us units
+    const uint16 now = shaping_now;
+
+    if (shaping_input[X_AXIS] | shaping_input[Y_AXIS]) {
+      const uint8 next = uint8(shaping_head + 1) & mask;
+      shaping_event_t & __restrict newest = shaping_queue[uint8(shaping_head - 1) & mask];
+      const bool merge = shaping_head != shaping_tail && uint16(now - newest.time) < merge_time
+        && WITHIN(newest.steps[X_AXIS] + shaping_input[X_AXIS], -127, 127)
+        && WITHIN(newest.steps[Y_AXIS] + shaping_input[Y_AXIS], -127, 127);
+      const bool queued = merge || next != shaping_tail;
+      for (uint8 a = X_AXIS; a <= Y_AXIS; ++a) {
+        shaper_t & __restrict s = shapers[a];
+        const int8 steps = shaping_input[a];
+        s.residue += (queued ? s.weight[0] : 256) * steps;
+      }
+      if (merge) {
+        newest.steps[X_AXIS] += shaping_input[X_AXIS];
+        newest.steps[Y_AXIS] += shaping_input[Y_AXIS];
+      }
+      else if (queued) {
+        shaping_event_t & __restrict event = shaping_queue[shaping_head];
+        event.time = now;
+        event.steps[X_AXIS] = shaping_input[X_AXIS];
+        event.steps[Y_AXIS] = shaping_input[Y_AXIS];
+        shaping_head = next;
+      }
+      shaping_input[X_AXIS] = shaping_input[Y_AXIS] = 0;
+    }
+
+    if (shaping_head != shaping_tail) {
+      uint8 done = uint8(shaping_head - shaping_tail) & mask;
+      for (uint8 a = X_AXIS; a <= Y_AXIS; ++a) {
+        shaper_t & __restrict s = shapers[a];
+        for (uint8 k = 0; k < s.echoes; ++k) {
+          uint8 cursor = s.cursor[k];
+          while (cursor != shaping_head) {
+            const shaping_event_t & __restrict event = shaping_queue[cursor];
+            if (uint16(now - event.time) < s.delay[k]) break;
+            s.residue += s.weight[k + 1] * event.steps[a];
+            cursor = uint8(cursor + 1) & mask;
+          }
+          s.cursor[k] = cursor;
+        }
+        // The last part has the longest delay, so the entries before it are done with
+        if (s.echoes) NOMORE(done, uint8(s.cursor[s.echoes - 1] - shaping_tail) & mask);
+      }
+      shaping_tail = uint8(shaping_tail + done) & mask;
+    }
+
+    SHAPED_STEPS(X);
+    SHAPED_STEPS(Y);
+  }
+
+  // The timer ticks to wait for the next delayed part, at most 'ticks'
+  uint16 __forceinline __flatten Stepper::shaping_wait(const uint16 ticks) {
+    uint16 wait = ticks;
+    if (shaping_head == shaping_tail) return wait;
+    for (uint8 a = X_AXIS; a <= Y_AXIS; ++a) {
+      const shaper_t & __restrict s = shapers[a];
+      for (uint8 k = 0; k < s.echoes; ++k) {
+        if (s.cursor[k] == shaping_head) continue;
+        // Not due yet, or shaping_isr() would have taken it
+        const uint16 left = s.delay[k] - uint16(shaping_now - shaping_queue[s.cursor[k]].time);
+        if (left < wait / 8) wait = left * 8;
+      }
+    }
+    return max(wait, uint16(50));
+  }
+
+  /**
+   * The shapers that M593 sets. ZV puts out each step in two parts half a period of the
+   * ringing apart, MZV in three parts, each 3/8 of a period apart, which is less sensitive to
+   * a wrong frequency for a little more smoothing. The second part of a damped ringing is
+   * smaller than the first, so the parts are weighted by how much it dies down in between.
+   */
+  void Stepper::refresh_shaping(const bool suspended) {
+    synchronize(); // The queue and the residues are in use until the last delayed part is out
+
+    shaper_t shaper[2];
+    for (uint8 a = X_AXIS; a <= Y_AXIS; ++a) {
+      shaper_t & __restrict s = shaper[a];
+      s = shapers[a];
+      s.echoes = 0;
+      if (suspended || shaping_frequency[a] <= 0) continue;
+
+      const float df = SQRT(1.0f - sq(shaping_zeta[a])),
+                  period = 250000.0f / (shaping_frequency[a] * df); // Of the damped ringing, in 4 us units
+      float amplitude[3], spacing;
+      if (shaping_type[a]) {
+        const float K = exp(-0.75f * shaping_zeta[a] * M_PI / df);
+        amplitude[0] = 1.0f - 1.0f / M_SQRT2;
+        amplitude[1] = (M_SQRT2 - 1.0f) * K;
+        amplitude[2] = amplitude[0] * sq(K);
+        spacing = 0.375f;
+        s.echoes = 2;
+      }
+      else {
+        const float K = exp(-shaping_zeta[a] * M_PI / df);
+        amplitude[0] = 1.0f;
+        amplitude[1] = K;
+        spacing = 0.5f;
+        s.echoes = 1;
+      }
+
+      float total = 0;
+      for (uint8 k = 0; k <= s.echoes; ++k) total += amplitude[k];
+      int16 rest = 256;
+      for (uint8 k = s.echoes; k; --k) {
+        s.weight[k] = int16(LROUND(amplitude[k] * 256 / total));
+        rest -= s.weight[k];
+        s.delay[k - 1] = uint16(LROUND(period * spacing * k));
+      }
+      s.weight[0] = rest;
+    }
+
+    CRITICAL_SECTION_START;
+    bool released = false;
+    for (uint8 a = X_AXIS; a <= Y_AXIS; ++a) {
+      shaper_t & __restrict s = shaper[a];
+      if (s.echoes && !shapers[a].echoes) {
+        // Take the direction pin over, pointing it as the block does
+        s.reverse = motor_direction(AxisEnum(a));
+        if (a == X_AXIS) X_APPLY_DIR(s.reverse ? INVERT_X_DIR : !INVERT_X_DIR, false);
+        else Y_APPLY_DIR(s.reverse ? INVERT_Y_DIR : !INVERT_Y_DIR, false);
+      }
+      if (!s.echoes && shapers[a].echoes) released = true;
+      s.residue = 0;
+      s.cursor[0] = s.cursor[1] = shaping_head;
+      shapers[a] = s;
+    }
+    if (released) set_directions(); // Hands the pins back to the blocks
+    CRITICAL_SECTION_END;
+  }
+
+#endif // INPUT_SHAPING
+
+#if ENABLED(STEP_QUEUE_MODE)
+
+  // Whether an endstop stops an axis running toward it
+  #define _STEP_QUEUE_ENDSTOP(AXIS, MINMAX) (READ(AXIS ##_## MINMAX ##_PIN) != AXIS ##_## MINMAX ##_ENDSTOP_INVERTING)
+  #if HAS_X_MIN
+    #define X_MIN_STOPS _STEP_QUEUE_ENDSTOP(X, MIN)
+  #else
+    #define X_MIN_STOPS false
+  #endif
+  #if HAS_X_MAX
+    #define X_MAX_STOPS _STEP_QUEUE_ENDSTOP(X, MAX)
+  #else
+    #define X_MAX_STOPS false
+  #endif
+  #if HAS_Y_MIN
+    #define Y_MIN_STOPS _STEP_QUEUE_ENDSTOP(Y, MIN)
+  #else
+    #define Y_MIN_STOPS false
+  #endif
+  #if HAS_Y_MAX
+    #define Y_MAX_STOPS _STEP_QUEUE_ENDSTOP(Y, MAX)
+  #else
+    #define Y_MAX_STOPS false
+  #endif
+  #if HAS_Z_MIN
+    #define Z_MIN_STOPS _STEP_QUEUE_ENDSTOP(Z, MIN)
+  #else
+    #define Z_MIN_STOPS false
+  #endif
+  #if HAS_Z_MAX
+    #define Z_MAX_STOPS _STEP_QUEUE_ENDSTOP(Z, MAX)
+  #else
+    #define Z_MAX_STOPS false
+  #endif
+
+  // An axis stopped by its endstop drops what it has queued, and the stop is reported as a homing hit would be
+  #define STEP_QUEUE_HALT(AXIS, reverse) \
+    if (endstops_on && ((reverse) ? AXIS ##_MIN_STOPS : AXIS ##_MAX_STOPS)) { \
+      a.count = 0; \
+      while (!q.empty()) q.pop(); \
+      SBI(step_queue_halted, _AXIS(AXIS)); \
+      endstops_trigsteps[_AXIS(AXIS)] = count_position[_AXIS(AXIS)]; \
+      SBI(endstops.endstop_hit_bits, (reverse) ? AXIS ##_MIN : AXIS ##_MAX); \
+      break; \
+    }
+
+  // Put out the event of an axis that's due, then start its next run once the last one is done,
+  // so the next interrupt can be set for it. 'DIR' names the direction pin.
+  #define STEP_QUEUE_AXIS(AXIS, DIR, HALT) do { \
+    step_axis_t & __restrict a = step_axes[_AXIS(AXIS)]; \
+    spsc_ring<STEP_QUEUE_MOVES> & __restrict q = step_run_queue[_AXIS(AXIS)]; \
+    if (a.count && int32(a.time - now) <= 0) { \
+      const bool reverse = a.flags & step_run_t::reverse; \
+      HALT(AXIS, reverse) \
+      if (!(a.flags & step_run_t::silent)) { \
+        if (reverse != a.reverse) { \
+          a.reverse = reverse; \
+          DIR ##_DIR_WRITE(reverse ? INVERT_## DIR ##_DIR : !INVERT_## DIR ##_DIR); \
+        } \
+        AXIS ##_APPLY_STEP(!_INVERT_STEP_PIN(AXIS), 0); \
+        count_position[_AXIS(AXIS)] += reverse ? -1 : 1; \
+        SBI(stepped, _AXIS(AXIS)); \
+      } \
+      if (int32(now - a.time) > late_ticks && step_queue_late != type_trait<uint16>::max) ++step_queue_late; \
+      if (--a.count) { \
+        a.interval += a.add; \
+        a.time += a.interval; \
+      } \
+    } \
+    if (!a.count && !q.empty()) { \
+      const step_run_t & __restrict run = step_runs[_AXIS(AXIS)][q.tail()]; \
+      if (!TEST(step_queue_halted, _AXIS(AXIS))) { \
+        a.interval = run.interval; \
+        a.time += run.interval; \
+        a.count = run.count; \
+        a.add = run.add; \
+        a.flags = run.flags; \
+      } \
+      q.pop(); \
+    } \
+    if (a.count) NOMORE(wait, int32(a.time - now)); \
+  } while (0)
+
+  #define STEP_QUEUE_NO_HALT(AXIS, reverse)
+
+  /**
+   * The stepper ISR while the step queues have the motors. Each axis runs its own schedule of
+   * events on one timeline, counted in timer ticks from when the queues started, and the
+   * interrupt is set for the earliest. Every ISR's time is the last one's plus the interval it
+   * set, so however late an interrupt runs, the schedule doesn't drift. Without events due it
+   * comes back every millisecond for new runs.
+   */
+  void __forceinline __flatten Stepper::step_queue_isr() {
+    constexpr const int32 idle_ticks = STEPPER_TIMER_RATE / 1000,
+                          late_ticks = 32;
+
+    const uint32 now = (step_queue_now += step_queue_interval);
+    const bool endstops_on = ENDSTOPS_ENABLED;
+    int32 wait = idle_ticks;
+    uint8 stepped = 0;
+
+    #if EXTRA_CYCLES_XYZE > 20
+      uint32 pulse_start = TCNT0;
+    #endif
+
+    STEP_QUEUE_AXIS(X, X, STEP_QUEUE_HALT);
+    STEP_QUEUE_AXIS(Y, Y, STEP_QUEUE_HALT);
+    STEP_QUEUE_AXIS(Z, Z, STEP_QUEUE_HALT);
+    STEP_QUEUE_AXIS(E, E0, STEP_QUEUE_NO_HALT);
+
+    if (stepped) {
+      #if EXTRA_CYCLES_XYZE > 20
+        while (EXTRA_CYCLES_XYZE > (uint32)(TCNT0 - pulse_start) * (INT0_PRESCALER)) { /* nada */ }
+      #elif EXTRA_CYCLES_XYZE > 0
+        DELAY_NOPS(EXTRA_CYCLES_XYZE);
+      #endif
+      if (TEST(stepped, X_AXIS)) X_APPLY_STEP(_INVERT_STEP_PIN(X), 0);
+      if (TEST(stepped, Y_AXIS)) Y_APPLY_STEP(_INVERT_STEP_PIN(Y), 0);
+      if (TEST(stepped, Z_AXIS)) Z_APPLY_STEP(_INVERT_STEP_PIN(Z), 0);
+      if (TEST(stepped, E_AXIS)) E_APPLY_STEP(_INVERT_STEP_PIN(E), 0);
+    }
+
+    // Not sooner than the ISR can come back. What that costs is kept on the timeline.
+    uint16 interval = uint16(max(wait, int32(1)));
+    #if ENABLED(STEPPER_FREE_RUNNING_TIMER)
+      NOLESS(interval, uint16(uint16(TCNT1 - last_compare) + 16));
+      last_compare += interval;
+      OCR1A = last_compare;
+    #else
+      NOLESS(interval, uint16(TCNT1 + 16));
+      OCR1A = interval;
+    #endif
+    step_queue_interval = interval;
+  }
+
+  #undef STEP_QUEUE_NO_HALT
+  #undef STEP_QUEUE_AXIS
+  #undef STEP_QUEUE_HALT
+
+  void Stepper::start_step_queues() {
+    if (step_queue_active) return;
+    synchronize();
+    #if ENABLED(LIN_ADVANCE)
+      for (uint8 e = 0; e < E_STEPPERS; ++e) while (e_steps[e]) idle();
+    #endif
+
+    critical_section _critsec;
+    LOOP_XYZE(i) {
+      step_run_queue[i].clear();
+      step_axes[i] = { 0, 0, 0, 0, 0, motor_direction(AxisEnum(i)) };
+    }
+    step_queue_now = 0;
+    step_queue_interval = 0;
+    step_queue_halted = 0;
+    step_queue_late = 0;
+    step_queue_active = true;
+  }
+
+  void Stepper::stop_step_queues() {
+    if (!step_queue_active) return;
+    for (;;) {
+      bool running = false;
+      {
+        critical_section _critsec; // The counts are two bytes
+        LOOP_XYZE(i) if (step_axes[i].count || !step_run_queue[i].empty()) running = true;
+      }
+      if (!running) break;
+      idle();
+    }
+
+    critical_section _critsec;
+    step_queue_active = false;
+    set_directions(); // Points the pins as the blocks expect them again
+  }
+
+  bool Stepper::queue_step_run(const AxisEnum axis, const step_run_t & __restrict run) {
+    spsc_ring<STEP_QUEUE_MOVES> & __restrict q = step_run_queue[axis];
+    if (q.full()) return false;
+    step_runs[axis][q.head()] = run;
+    q.push();
+    return true;
+  }
+
+#endif // STEP_QUEUE_MODE
+
 #if ENABLED(LIN_ADVANCE)
 
   #define CYCLES_EATEN_E (E_STEPPERS * 5)
@@ -545,7 +1392,7 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
 
   // Timer interrupt for E. e_steps is set in the main routine;
 
-  template <bool endstops_enabled> void __forceinline __flatten Stepper::advance_isr() 
+  template <bool endstops_enabled> void __forceinline __flatten Stepper::advance_isr(const uint8 loops)
   {
 
     nextAdvanceISR = eISR_Rate;
@@ -565,7 +1412,7 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
     SET_E_STEP_DIR(0);
 
     // Step all E steppers that have steps
-    for (uint8_t i = step_loops; i--;) {
+    for (uint8_t i = loops; i--;) {
 
       #if EXTRA_CYCLES_E > 20
         uint32 pulse_start = TCNT0;
@@ -595,16 +1442,90 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
 
   template <bool endstops_enabled> void __forceinline __flatten Stepper::advance_isr_scheduler()
   {
+    #if ENABLED(STEPPER_FREE_RUNNING_TIMER)
+      // The interval to the next interrupt, from when this one was due
+      uint16 next_interval;
+      #define _SET_COMPARE(T) next_interval = (T)
+    #else
+      #define _SET_COMPARE(T) OCR1A = (T)
+    #endif
+
+    #if ENABLED(ISR_PROFILING)
+      #if ENABLED(STEPPER_FREE_RUNNING_TIMER)
+        // Timer 1 wraps on its own, so the ticks are just the difference. Overruns are counted
+        // as the next interrupt is set.
+        const auto profile = [](interrupts::isr_timing & __restrict timing, arg_type<uint16> start)
+        {
+          timing.add(uint16(TCNT1 - start), false);
+        };
+      #else
+        // Timer 1 restarts from 0 on reaching OCR1A. If it did so while a handler ran,
+        // the handler overran the interval it was given.
+        const uint16 profile_top = OCR1A;
+        const auto profile = [profile_top](interrupts::isr_timing & __restrict timing, arg_type<uint16> start)
+        {
+          const uint16 end = TCNT1;
+          const bool wrapped = end < start;
+          timing.add(wrapped ? uint16(profile_top - start + end + 1) : uint16(end - start), wrapped);
+        };
+      #endif
+    #endif
+
+    #if ENABLED(LIN_ADVANCE_SHARED_TIMELINE)
+
+    // Every interrupt is a main ISR, and the E steps it leaves follow right after
+    #if ENABLED(ISR_PROFILING)
+      const uint16 profile_start = TCNT1;
+      isr<endstops_enabled>();
+      profile(interrupts::stepper_timing, profile_start);
+    #else
+      isr<endstops_enabled>();
+    #endif
+
+    const int e_steps_left = e_steps[TOOL_E_INDEX];
+    const uint16 pending_e_steps = uabs(e_steps_left);
+    if (pending_e_steps) {
+      const uint8 e_loops = uint8(min(pending_e_steps, uint16(step_loops * (LIN_ADVANCE_E_STEPS_PER_ISR))));
+      #if ENABLED(ISR_PROFILING)
+        const uint16 profile_start = TCNT1;
+        advance_isr<endstops_enabled>(e_loops);
+        profile(interrupts::advance_timing, profile_start);
+      #else
+        advance_isr<endstops_enabled>(e_loops);
+      #endif
+    }
+
+    _SET_COMPARE(nextMainISR);
+    nextMainISR = 0;
+
+    #else
+
     // Run main stepping ISR if flagged
-    if (!nextMainISR) isr<endstops_enabled>();
+    if (!nextMainISR) {
+      #if ENABLED(ISR_PROFILING)
+        const uint16 profile_start = TCNT1;
+        isr<endstops_enabled>();
+        profile(interrupts::stepper_timing, profile_start);
+      #else
+        isr<endstops_enabled>();
+      #endif
+    }
 
     // Run Advance stepping ISR if flagged
-    if (!nextAdvanceISR) advance_isr<endstops_enabled>();
+    if (!nextAdvanceISR) {
+      #if ENABLED(ISR_PROFILING)
+        const uint16 profile_start = TCNT1;
+        advance_isr<endstops_enabled>(step_loops);
+        profile(interrupts::advance_timing, profile_start);
+      #else
+        advance_isr<endstops_enabled>(step_loops);
+      #endif
+    }
 
     // Is the next advance ISR scheduled before the next main ISR?
     if (nextAdvanceISR <= nextMainISR) {
       // Set up the next interrupt
-      OCR1A = nextAdvanceISR;
+      _SET_COMPARE(nextAdvanceISR);
       // New interval for the next main ISR
       if (nextMainISR) nextMainISR -= nextAdvanceISR;
       // Will call Stepper::advance_isr on the next interrupt
@@ -612,7 +1533,7 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
     }
     else {
       // The next main ISR comes first
-      OCR1A = nextMainISR;
+      _SET_COMPARE(nextMainISR);
       // New interval for the next advance ISR, if any
       if (nextAdvanceISR && nextAdvanceISR != ADV_NEVER)
         nextAdvanceISR -= nextMainISR;
@@ -620,8 +1541,46 @@ template <bool endstops_enabled> void __forceinline __flatten Stepper::isr() {
       nextMainISR = 0;
     }
 
+    #endif // LIN_ADVANCE_SHARED_TIMELINE
+
+    #undef _SET_COMPARE
+
+    #if ENABLED(STEPPER_FREE_RUNNING_TIMER)
+
+      // The next compare is this one's plus the interval, so the time the interrupt waited and
+      // ran doesn't add up in the steps. One due within 16 ticks, or already past, is set for 16
+      // ticks from now, and the one after still counts from when it was due, to catch up. More
+      // than an interval behind, the schedule starts over from now instead of bursting.
+      {
+        const uint16 now = TCNT1;
+        const uint24 ready = uint24(uint16(now - last_compare)) + 16;
+        if (__likely(ready <= next_interval)) {
+          last_compare += next_interval;
+          OCR1A = last_compare;
+        }
+        else {
+          OCR1A = now + 16;
+          if (ready - next_interval < next_interval)
+            last_compare += next_interval;
+          else
+            last_compare = now + 16;
+          #if ENABLED(ISR_PROFILING)
+            if (interrupts::stepper_timing.overruns != type_trait<uint16>::max) ++interrupts::stepper_timing.overruns;
+          #endif
+        }
+      }
+
     // Don't run the ISR faster than possible
-    NOLESS(OCR1A, TCNT1 + 16);
+    #elif ENABLED(ISR_PROFILING)
+      // Having to push the next interrupt back means its deadline has already passed
+      const uint16 earliest = TCNT1 + 16;
+      if (OCR1A < earliest) {
+        OCR1A = earliest;
+        if (interrupts::stepper_timing.overruns != type_trait<uint16>::max) ++interrupts::stepper_timing.overruns;
+      }
+    #else
+      NOLESS(OCR1A, TCNT1 + 16);
+    #endif
   }
 
 #endif // LIN_ADVANCE
@@ -789,8 +1748,13 @@ void Stepper::init() {
     E_AXIS_INIT(4);
   #endif
 
-  // waveform generation = 0100 = CTC
-  SET_WGM(1, CTC_OCRnA);
+  #if ENABLED(STEPPER_FREE_RUNNING_TIMER)
+    // waveform generation = 0000 = normal, counting up through every value and wrapping
+    SET_WGM(1, NORMAL);
+  #else
+    // waveform generation = 0100 = CTC
+    SET_WGM(1, CTC_OCRnA);
+  #endif
 
   // output mode = 00 (disconnected)
   SET_COMA(1, NORMAL);
@@ -798,13 +1762,19 @@ void Stepper::init() {
   // Set the timer pre-scaler
   // Generally we use a divider of 8, resulting in a 2MHz timer
   // frequency on a 16MHz MCU. If you are going to change this, be
-  // sure to regenerate speed_lookuptable.h with
-  // create_speed_lookuptable.py
+  // sure to update STEPPER_TIMER_RATE to match.
   SET_CS(1, PRESCALER_8);  //  CS 2 = 1/8 prescaler
 
+  #if ENABLED(STEP_RATE_CALIBRATION)
+    calibrate_step_rate();
+  #endif
+
   // Init Stepper ISR to 122 Hz for quick starting
   OCR1A = 0x4000;
   TCNT1 = 0;
+  #if ENABLED(STEPPER_FREE_RUNNING_TIMER)
+    last_compare = 0x4000; // The first interrupt's, which the next is counted from
+  #endif
   ENABLE_STEPPER_DRIVER_INTERRUPT();
 
   #if ENABLED(LIN_ADVANCE)
@@ -822,7 +1792,170 @@ void Stepper::init() {
 /**
  * Block until all buffered steps are executed
  */
-void __forceinline Stepper::synchronize() { while (planner.blocks_queued()) idle(); }
+#if ENABLED(STEP_RATE_CALIBRATION)
+
+  /**
+   * Time the stepper ISR on a made-up block that steps every axis on every step event, once per
+   * step shift, and give the planner the fastest step rate that keeps the ISR within
+   * STEP_RATE_ISR_LOAD percent of the time. Called from init() while the stepper drivers are
+   * still disabled, so the step pulses go nowhere.
+   *
+   * Each step shift is used up to MULTISTEP_RATE << shift steps/s before the next one takes
+   * over, so a shift only limits the rate if its own ceiling falls below that.
+   */
+  void Stepper::calibrate_step_rate() {
+    constexpr const uint8 calls = 8;
+    constexpr const uint24 step_count = 0xFFFF;
+
+    block_t block = {};
+    block.step_event_count = step_count;
+    LOOP_XYZE(i) block.steps[i] = step_count;
+    block.decelerate_after = step_count;
+    for (uint8 i = 0; i < MAX_STEP_SHIFT; ++i) block.step_shift_up_at[i] = block.step_shift_down_after[i] = step_count;
+
+    int24 position[NUM_AXIS];
+    LOOP_NA(i) position[i] = count_position[i];
+
+    uint32 max_rate = type_trait<uint32>::max;
+    {
+      Tuna::critical_section _critsec;
+
+      for (uint8 shift = 0; shift <= MAX_STEP_SHIFT; ++shift) {
+        // A 1ms interval, so Timer 1 never reaches OCR1A while the ISR is timed
+        block.initial_rate = block.nominal_rate = block.final_rate = uint24(1000) << shift;
+        block.initial_step_shift = block.nominal_step_shift = shift;
+
+        current_block = &block;
+        trapezoid_generator_reset();
+        LOOP_XYZE(i) counter[i] = -int24(step_count >> 1);
+        step_events_completed = 0;
+
+        uint16 ticks = 1;
+        for (uint8 i = 0; i < calls; ++i) {
+          TCNT1 = 0;
+          isr<false>();
+          #if ENABLED(LIN_ADVANCE)
+            advance_isr<false>(step_loops);
+          #endif
+          NOLESS(ticks, uint16(TCNT1));
+        }
+
+        const uint32 rate = (uint32(STEPPER_TIMER_RATE / 100 * (STEP_RATE_ISR_LOAD)) << shift) / ticks;
+        if (shift == MAX_STEP_SHIFT || rate < (uint32(MULTISTEP_RATE) << shift)) NOMORE(max_rate, rate);
+      }
+
+      current_block = nullptr;
+      step_events_completed = 0;
+      LOOP_NA(i) count_position[i] = position[i];
+    }
+
+    planner.inverse_max_step_rate = 1.0f / max_rate;
+
+    SERIAL_ECHO_START();
+    SERIAL_ECHOLNPAIR("Max step rate: ", max_rate);
+  }
+
+#endif // STEP_RATE_CALIBRATION
+
+void __forceinline Stepper::synchronize() {
+  while (planner.blocks_queued()
+    #if ENABLED(INPUT_SHAPING)
+      || shaping_head != shaping_tail
+    #endif
+  ) idle();
+}
+
+#if ENABLED(RAMP_TABLES)
+
+  /**
+   * Tabulate the ramps of the block the ISR starts next into the table it isn't using.
+   *
+   * This replays the timer calculations of isr() step for step, so it has to be kept in
+   * line with them. The cruise is skipped in one go. An acceleration that runs well past
+   * the table is left without a deceleration table, rather than replayed to the end.
+   */
+  void Stepper::prepare_ramp_table() {
+    const block_t *block;
+    ramp_table_t *table;
+
+    {
+      Tuna::critical_section_not_isr _critsec;
+
+      uint8 index = planner.block_queue.tail();
+      if (current_block == &planner.block_buffer[index]) index = Planner::block_ring::next(index);
+      if (index == planner.block_queue.head()) return;
+
+      block = &planner.block_buffer[index];
+      if (block->busy || ramp_tables[0].matches(block) || ramp_tables[1].matches(block)) return;
+
+      table = &ramp_tables[ramp_table == &ramp_tables[0]];
+      table->block = nullptr;
+    }
+
+    table->initial_rate = block->initial_rate;
+    table->nominal_rate = block->nominal_rate;
+    table->final_rate = block->final_rate;
+    table->acceleration_rate = block->acceleration_rate;
+    table->accelerate_until = block->accelerate_until;
+    table->decelerate_after = block->decelerate_after;
+    table->step_event_count = block->step_event_count;
+
+    uint8 shift = block->initial_step_shift, accel_length = 0, decel_length = 0;
+    uint16 acc_rate = table->initial_rate;
+    int24 accel_time = calc_timer(acc_rate, shift), decel_time = 0;
+    uint24 steps = 0;
+    uint16 untabled_accel = 0;
+
+    while (steps < table->step_event_count && decel_length < RAMP_TABLE_LENGTH) {
+      steps = min(uint24(steps + (1 << shift)), table->step_event_count);
+
+      if (steps <= table->accelerate_until) {
+        if (accel_length == RAMP_TABLE_LENGTH && ++untabled_accel > RAMP_TABLE_LENGTH * 8) break;
+
+        if (shift < MAX_STEP_SHIFT && steps >= block->step_shift_up_at[shift]) ++shift;
+
+        acc_rate = uint16(Tuna::intrinsic::mul_shift<24>(uint24(accel_time), table->acceleration_rate));
+        acc_rate += table->initial_rate;
+        if (acc_rate > table->nominal_rate) acc_rate = table->nominal_rate;
+
+        const uint16 timer = calc_timer(acc_rate, shift);
+        accel_time += timer;
+        if (accel_length < RAMP_TABLE_LENGTH) table->accel[accel_length++] = { acc_rate, timer };
+      }
+      else if (steps > table->decelerate_after) {
+        if (shift && steps > block->step_shift_down_after[shift - 1]) --shift;
+
+        uint16 step_rate = uint16(Tuna::intrinsic::mul_shift<24>(uint24(decel_time), table->acceleration_rate));
+        if (step_rate < acc_rate) {
+          step_rate = acc_rate - step_rate;
+          NOLESS(step_rate, table->final_rate);
+        }
+        else {
+          step_rate = table->final_rate;
+        }
+
+        const uint16 timer = calc_timer(step_rate, shift);
+        decel_time += timer;
+        table->decel[decel_length++] = { step_rate, timer };
+      }
+      else {
+        // Cruising: jump to the last ISR before the deceleration
+        acc_rate = table->nominal_rate;
+        shift = block->nominal_step_shift;
+        steps += ((table->decelerate_after - steps) >> shift) << shift;
+      }
+    }
+
+    table->accel_length = accel_length;
+    table->decel_length = decel_length;
+
+    {
+      Tuna::critical_section_not_isr _critsec;
+      if (!block->busy) table->block = block;
+    }
+  }
+
+#endif
 
 /**
  * Set the stepper positions directly in steps
@@ -868,23 +2001,108 @@ void __forceinline Stepper::set_position(const int24 &a, const int24 &b, const i
 
 void __forceinline __flatten Stepper::set_position(const AxisEnum &axis, const int24 &v) {
   CRITICAL_SECTION_START;
-  count_position[axis] = v;
+  count_position[axis] = v - (live_position(axis) - count_position[axis]);
   CRITICAL_SECTION_END;
 }
 
 void __forceinline __flatten Stepper::set_e_position(const int24 &e) {
   CRITICAL_SECTION_START;
-  count_position[E_AXIS] = e;
+  count_position[E_AXIS] = e - (live_position(E_AXIS) - count_position[E_AXIS]);
   CRITICAL_SECTION_END;
 }
 
+#if ENABLED(LAZY_STEP_POSITION)
+
+  /**
+   * The steps an axis has taken in the current block. Each event adds steps[axis] to its
+   * Bresenham counter and each step takes step_event_count off, from the half count the block
+   * started it at, so after 'events' events the counter holds
+   *
+   *   -(step_event_count / 2) + events * steps[axis] - taken * step_event_count
+   *
+   * The state is copied by the ISR between events, or by anything else with interrupts off or
+   * under position_sequence, and the division is done from the copy. It's 32 bits for blocks of
+   * up to 65535 events. Arcs count their steps as they go.
+   */
+  Stepper::pending_state_t __forceinline __flatten Stepper::pending_state(const AxisEnum axis) {
+    pending_state_t state {}; // No steps, so nothing pending
+    const block_t * const block = current_block;
+    if (!block) return state;
+    #if ENABLED(ARC_BLOCKS)
+      if (TEST(block->flag, BLOCK_BIT_ARC)) return state;
+    #endif
+    state.steps = block->steps[axis];
+    state.events = block->step_event_count;
+    state.completed = step_events_completed;
+    state.counter = counter[axis];
+    state.direction = count_direction[axis];
+    return state;
+  }
+
+  int24 Stepper::pending_steps(const pending_state_t &state) {
+    const uint24 steps = state.steps;
+    if (!steps) return 0;
+
+    const uint24 events = state.events;
+    const int24 offset = -int24(events >> 1) - state.counter;
+    int24 taken;
+    if (events <= 0xFFFF)
+      taken = int24((uint32(state.completed) * uint32(steps) + uint32(int32(offset))) / uint32(events));
+    else
+      taken = int24((uint64_t(state.completed) * steps + int64_t(offset)) / events);
+
+    return (state.direction < 0) ? -taken : taken;
+  }
+
+  int24 Stepper::pending_steps(const AxisEnum axis) {
+    return pending_steps(pending_state(axis));
+  }
+
+  void Stepper::commit_steps() {
+    LOOP_XYZE(i) {
+      count_position[i] += pending_steps(AxisEnum(i));
+      current_block->steps[i] = 0; // The counters are at or below 0, so nothing more steps
+    }
+  }
+
+#endif
+
+/**
+ * Get the steppers' positions in steps, copied between two stepper ISRs. Only the copy waits
+ * for the ISR; LAZY_STEP_POSITION's divisions are done after it, with interrupts on.
+ */
+void Stepper::positions(int24 (&steps)[NUM_AXIS]) {
+  #if ENABLED(LAZY_STEP_POSITION)
+    pending_state_t pending[NUM_AXIS];
+    position_sequence.read([&]() {
+      LOOP_NA(i) {
+        steps[i] = count_position[i];
+        pending[i] = pending_state(AxisEnum(i));
+      }
+    });
+    LOOP_NA(i) steps[i] += pending_steps(pending[i]);
+  #else
+    position_sequence.read([&]() {
+      LOOP_NA(i) steps[i] = count_position[i];
+    });
+  #endif
+}
+
 /**
- * Get a stepper's position in steps.
+ * Get a stepper's position in steps, as above.
  */
 int24 __forceinline __flatten Stepper::position(AxisEnum axis) {
-  CRITICAL_SECTION_START;
-  const int24 count_pos = count_position[axis];
-  CRITICAL_SECTION_END;
+  int24 count_pos;
+  #if ENABLED(LAZY_STEP_POSITION)
+    pending_state_t pending;
+    position_sequence.read([&]() {
+      count_pos = count_position[axis];
+      pending = pending_state(axis);
+    });
+    count_pos += pending_steps(pending);
+  #else
+    position_sequence.read([&]() { count_pos = count_position[axis]; });
+  #endif
   return count_pos;
 }
 
@@ -897,14 +2115,14 @@ float __forceinline __flatten Stepper::get_axis_position_mm(AxisEnum axis) {
   #if IS_CORE
     // Requesting one of the "core" axes?
     if (axis == CORE_AXIS_1 || axis == CORE_AXIS_2) {
-      CRITICAL_SECTION_START;
+      int24 steps[NUM_AXIS];
+      positions(steps);
       // ((a1+a2)+(a1-a2))/2 -> (a1+a2+a1-a2)/2 -> (a1+a1)/2 -> a1
       // ((a1+a2)-(a1-a2))/2 -> (a1+a2-a1+a2)/2 -> (a2+a2)/2 -> a2
       axis_steps = 0.5f * (
-        axis == CORE_AXIS_2 ? CORESIGN(count_position[CORE_AXIS_1] - count_position[CORE_AXIS_2])
-                            : count_position[CORE_AXIS_1] + count_position[CORE_AXIS_2]
+        axis == CORE_AXIS_2 ? CORESIGN(steps[CORE_AXIS_1] - steps[CORE_AXIS_2])
+                            : steps[CORE_AXIS_1] + steps[CORE_AXIS_2]
       );
-      CRITICAL_SECTION_END;
     }
     else
       axis_steps = position(axis);
@@ -914,6 +2132,20 @@ float __forceinline __flatten Stepper::get_axis_position_mm(AxisEnum axis) {
   return axis_steps * planner.steps_to_mm[axis];
 }
 
+/**
+ * Get the positions of all axes, as above, from one positions() reading: a multiply per axis.
+ */
+void Stepper::get_positions_mm(float (&mm)[XYZE]) {
+  int24 steps[NUM_AXIS];
+  positions(steps);
+  LOOP_XYZE(i) mm[i] = steps[i] * planner.steps_to_mm[i];
+  #if IS_CORE
+    // As get_axis_position_mm, from the same reading
+    mm[CORE_AXIS_1] = 0.5f * (steps[CORE_AXIS_1] + steps[CORE_AXIS_2]) * planner.steps_to_mm[CORE_AXIS_1];
+    mm[CORE_AXIS_2] = 0.5f * CORESIGN(steps[CORE_AXIS_1] - steps[CORE_AXIS_2]) * planner.steps_to_mm[CORE_AXIS_2];
+  #endif
+}
+
 void Stepper::finish_and_disable() {
   synchronize();
   disable_all_steppers();
@@ -922,38 +2154,122 @@ void Stepper::finish_and_disable() {
 void Stepper::quick_stop() {
   cleaning_buffer_counter = 5000;
   DISABLE_STEPPER_DRIVER_INTERRUPT();
+  #if ENABLED(LAZY_STEP_POSITION)
+    if (current_block) commit_steps(); // Where it stopped, before the block is let go
+  #endif
   while (planner.blocks_queued()) planner.discard_current_block();
   current_block = nullptr;
+  #if ENABLED(STEP_QUEUE_MODE)
+    // The queues stay in charge, with nothing left to run
+    LOOP_XYZE(i) {
+      step_axes[i].count = 0;
+      step_run_queue[i].clear();
+    }
+  #endif
   ENABLE_STEPPER_DRIVER_INTERRUPT();
+  #if ENABLED(QUICK_PAUSE)
+    planner.release_motion(); // The held moves are gone with the rest
+  #endif
   #if ENABLED(ULTRA_LCD)
     planner.clear_block_buffer_runtime();
   #endif
 }
 
+#if ENABLED(ENDSTOP_EDGE_LATCH)
+
+  // The position latched at the endstop's edge, and how long ago that was. Without an edge in
+  // this block, the endstop was closed as it began, so the stop is where it was hit.
+  void __forceinline __flatten Stepper::latch_trigsteps(AxisEnum axis) {
+    if (TEST(endstops_latched, axis)) {
+      endstops_trigsteps[axis] = endstops_edgesteps[axis];
+      endstops_triglag[axis] = endstops_edgetime[axis].since();
+    }
+    else {
+      endstops_trigsteps[axis] = live_position(axis);
+      endstops_triglag[axis] = 0;
+    }
+  }
+
+#endif
+
 void __forceinline __flatten Stepper::endstop_triggered(AxisEnum axis) {
 
   #if IS_CORE
 
     endstops_trigsteps[axis] = 0.5f * (
-      axis == CORE_AXIS_2 ? CORESIGN(count_position[CORE_AXIS_1] - count_position[CORE_AXIS_2])
-                          : count_position[CORE_AXIS_1] + count_position[CORE_AXIS_2]
+      axis == CORE_AXIS_2 ? CORESIGN(live_position(CORE_AXIS_1) - live_position(CORE_AXIS_2))
+                          : live_position(CORE_AXIS_1) + live_position(CORE_AXIS_2)
     );
 
+  #elif ENABLED(ENDSTOP_EDGE_LATCH)
+
+    latch_trigsteps(axis);
+
   #else // !COREXY && !COREXZ && !COREYZ
 
-    endstops_trigsteps[axis] = count_position[axis];
+    endstops_trigsteps[axis] = live_position(axis);
 
   #endif // !COREXY && !COREXZ && !COREYZ
 
   kill_current_block();
 }
 
+#if ENABLED(PARALLEL_HOMING)
+
+  void __forceinline __flatten Stepper::endstop_axis_triggered(AxisEnum axis) {
+    #if ENABLED(ENDSTOP_EDGE_LATCH)
+      latch_trigsteps(axis);
+    #else
+      endstops_trigsteps[axis] = live_position(axis);
+    #endif
+
+    #if ENABLED(LAZY_STEP_POSITION)
+      count_position[axis] += pending_steps(axis);
+    #endif
+
+    // The Bresenham counter is never above 0 between events, so the axis takes no further step
+    current_block->steps[axis] = 0;
+
+    if (!(current_block->steps[X_AXIS] | current_block->steps[Y_AXIS] | current_block->steps[Z_AXIS]))
+      kill_current_block();
+  }
+
+#endif
+
+#if ENABLED(STEP_TRACE)
+
+  void Stepper::set_step_trace_interval(const uint8 interval) {
+    Tuna::critical_section _critsec;
+    step_trace_interval = interval;
+    step_trace_countdown = 1;
+  }
+
+  /**
+   * Print the recorded entries, oldest first, as
+   *   trace:<block>,<step_events_completed>,<interval>,<step_loops>,<direction_bits>
+   * Each entry is released once printed, so the ISR can record more meanwhile.
+   */
+  void Stepper::report_step_trace() {
+    SERIAL_ECHOLNPAIR("trace_rate:", uint32(STEPPER_TIMER_RATE));
+    while (!step_trace_queue.empty()) {
+      const step_trace_t entry = step_trace[step_trace_queue.tail()];
+      step_trace_queue.pop();
+      SERIAL_ECHOPAIR("trace:", entry.block);
+      SERIAL_ECHOPAIR(",", uint32(entry.step_events_completed));
+      SERIAL_ECHOPAIR(",", entry.interval);
+      SERIAL_ECHOPAIR(",", entry.step_loops);
+      SERIAL_ECHOLNPAIR(",", entry.direction_bits);
+    }
+  }
+
+#endif // STEP_TRACE
+
 void Stepper::report_positions() {
-  CRITICAL_SECTION_START;
-  const long xpos = count_position[X_AXIS],
-             ypos = count_position[Y_AXIS],
-             zpos = count_position[Z_AXIS];
-  CRITICAL_SECTION_END;
+  int24 steps[NUM_AXIS];
+  positions(steps);
+  const long xpos = steps[X_AXIS],
+             ypos = steps[Y_AXIS],
+             zpos = steps[Z_AXIS];
 
   #if CORE_IS_XY || CORE_IS_XZ || IS_SCARA
     SERIAL_PROTOCOLPGM(MSG_COUNT_A);
@@ -1020,11 +2336,43 @@ void Stepper::report_positions() {
       _APPLY_DIR(AXIS, old_dir);                            \
     }
 
-  // MUST ONLY BE CALLED BY AN ISR,
-  // No other ISR should ever interrupt this!
+  #if ENABLED(BABYSTEP_XY)
+    #define BABYSTEP_FIRST_AXIS X_AXIS
+  #else
+    #define BABYSTEP_FIRST_AXIS Z_AXIS
+  #endif
+
+  // Queue a babystep for the stepper ISR. Main loop only.
+  // A step that would overflow the queue is dropped.
   void Stepper::babystep(const AxisEnum axis, const bool direction) {
-	  Tuna::cli();
+    if (axis < BABYSTEP_FIRST_AXIS || axis > Z_AXIS) return;
+
+    const int8 queued = babysteps_queued[axis],
+               pending = int8(queued - babysteps_done[axis]);
+    if (pending == (direction ? 127 : -128)) return;
+
+    babysteps_queued[axis] = int8(queued + (direction ? 1 : -1));
+  }
+
+  // Take at most one queued babystep per axis each millisecond, from the main stepper ISR.
+  // The block's direction bits are restored by babystep_pulse before the regular steps.
+  void __forceinline __flatten Stepper::babystep_isr() {
+    const uint8 ms = Tuna::millis8();
+    if (ms == babystep_ms) return;
+
+    for (uint8 axis = BABYSTEP_FIRST_AXIS; axis <= Z_AXIS; ++axis) {
+      const int8 done = babysteps_done[axis],
+                 pending = int8(babysteps_queued[axis] - done);
+      if (pending) {
+        babystep_pulse(AxisEnum(axis), pending > 0);
+        babysteps_done[axis] = int8(done + (pending > 0 ? 1 : -1));
+        babystep_ms = ms;
+      }
+    }
+  }
 
+  // Runs inside the stepper ISR, so nothing else steps or changes direction meanwhile
+  void __forceinline __flatten Stepper::babystep_pulse(const AxisEnum axis, const bool direction) {
     switch (axis) {
 
       #if ENABLED(BABYSTEP_XY)
@@ -1084,7 +2432,6 @@ void Stepper::report_positions() {
 
       default: break;
     }
-	Tuna::sei();
   }
 
 #endif // BABYSTEPPING
@@ -44,7 +44,6 @@
 #define STEPPER_H
 
 #include "planner.h"
-#include "speed_lookuptable.h"
 #include "stepper_indirection.h"
 #include "language.h"
 #include "types.h"
@@ -52,6 +51,24 @@
 class Stepper;
 extern Stepper stepper;
 
+#if ENABLED(STEP_QUEUE_MODE)
+  /**
+   * A run of steps from the host (STEP_QUEUE_MODE)
+   *
+   * 'count' events, the first 'interval' stepper timer ticks after the axis's last event, and
+   * each later interval 'add' ticks longer than the one before it.
+   */
+  struct step_run_t final {
+    static constexpr const uint8 reverse = _BV(7);  // The motor runs backwards
+    static constexpr const uint8 silent = _BV(6);   // The events only keep time, and nothing steps
+
+    uint24 interval;
+    uint16 count;
+    int16 add;
+    uint8 flags;
+  };
+#endif
+
 class Stepper final {
 
   public:
@@ -62,11 +79,19 @@ class Stepper final {
 
     static uint8_t last_direction_bits;        // The next stepping-bits to be output
     static uint16_t cleaning_buffer_counter;
+    static bool split_for_endstops;            // Whether the block moves toward an endstop, so long intervals are split to sample it
 
     // Counter variables for the Bresenham line tracer
     static int24 counter[XYZE];
     static uint24 step_events_completed; // The number of step events executed in the current block
 
+    #if ENABLED(ARC_BLOCKS)
+      // The point of an arc block (see arc_t) and the lower edges of the steps X and Y are on
+      static int32 arc_x, arc_y, arc_x_low, arc_y_low, arc_one, arc_rounding;
+      static uint8 arc_shift;
+      static bool arc_clockwise;
+    #endif
+
     #if ENABLED(LIN_ADVANCE)
       static uint16_t nextMainISR, nextAdvanceISR, eISR_Rate;
       #define _NEXT_ISR(T) nextMainISR = T
@@ -83,10 +108,132 @@ class Stepper final {
     static int24 acceleration_time, deceleration_time;
     //unsigned long accelerate_until, decelerate_after, acceleration_rate, initial_rate, final_rate, nominal_rate;
     static uint16/*24*/ acc_step_rate; // needed for deceleration start point
-    static uint8_t step_loops, step_loops_nominal;
+    static uint8_t step_loops, step_shift; // Steps per ISR, as a count and as its log2 (see MULTISTEP_RATE)
     static unsigned short OCR1A_nominal;
 
+    #if ENABLED(STEPPER_FREE_RUNNING_TIMER)
+      static uint16 last_compare; // When the interrupt now running was due, on the free-running Timer 1
+    #endif
+
+    #if ENABLED(S_CURVE_ACCELERATION)
+      static s_curve_t accel_curve, decel_curve;  // The ramps of current_block
+      static uint16 plateau_rate;                 // The step rate between them
+    #endif
+
+    #if ENABLED(RAMP_TABLES)
+      static_assert(WITHIN(RAMP_TABLE_LENGTH, 1, 255), "RAMP_TABLE_LENGTH must be between 1 and 255");
+
+      // The first ramp intervals of a block, as the ISR would compute them
+      struct ramp_table_t final {
+        struct interval_t final {
+          uint16 rate;                            // The step rate of the interval
+          uint16 timer;                           // The timer ticks of the interval
+        };
+
+        const block_t *block;                     // The block the table was made for, nullptr while it is written
+        uint24 initial_rate, nominal_rate,        // The trapezoid of that block when the table was made
+               final_rate, acceleration_rate,
+               accelerate_until, decelerate_after,
+               step_event_count;
+        uint8 accel_length, decel_length;         // The number of intervals of each ramp in the table
+        interval_t accel[RAMP_TABLE_LENGTH], decel[RAMP_TABLE_LENGTH];
+
+        // The planner may have changed the trapezoid since, or reused the block for another move
+        inline bool __forceinline __flatten matches(const block_t * __restrict const b) const {
+          return block == b
+            && initial_rate == b->initial_rate && nominal_rate == b->nominal_rate
+            && final_rate == b->final_rate && acceleration_rate == b->acceleration_rate
+            && accelerate_until == b->accelerate_until && decelerate_after == b->decelerate_after
+            && step_event_count == b->step_event_count;
+        }
+      };
+
+      static ramp_table_t ramp_tables[2];                 // One for the ISR, one for prepare_ramp_table()
+      static const ramp_table_t * ramp_table;             // The table for current_block, if there was one
+      static uint8 ramp_accel_index, ramp_decel_index;    // The next interval of each ramp
+    #endif
+
+    #if ENABLED(STEP_TRACE)
+      static uint8 step_trace_interval,                   // Record every Nth ISR, 0 when not recording
+                   step_trace_countdown,                  // ISRs left until the next entry
+                   step_trace_block;                      // Blocks started, wrapping
+    #endif
+
+    #if ENABLED(BABYSTEPPING)
+      // Babysteps queued by babystep() and taken by the stepper ISR. Each side writes only its own
+      // count, and the difference is the steps still to do, so neither needs a critical section.
+      static volatile int8 babysteps_queued[XYZ], babysteps_done[XYZ];
+      static uint8 babystep_ms;                           // millis8() of the last babystep taken
+    #endif
+
+    #if ENABLED(INPUT_SHAPING)
+      static_assert(SHAPING_BUFFER_SIZE >= 16 && SHAPING_BUFFER_SIZE <= 256 && !(SHAPING_BUFFER_SIZE & (SHAPING_BUFFER_SIZE - 1)),
+        "SHAPING_BUFFER_SIZE must be a power of 2 between 16 and 256");
+
+      // The shaper of X or Y, as the ISR runs it. Each step of the axis is put out in parts: the
+      // first right away, the others delayed, each part a share of a step. The parts add up to
+      // a whole step, and a step goes out once the shares add up to more than half of one.
+      struct shaper_t final {
+        uint8 echoes;                             // Delayed parts, 0 when the axis isn't shaped
+        int16 weight[3];                          // The share of each part, out of 256, the first not delayed
+        uint16 delay[2];                          // The delay of each delayed part, in 4 us units
+        uint8 cursor[2];                          // The next shaping_queue entry each delayed part reaches
+        int16 residue;                            // Shares not put out yet, out of 256 per step
+        bool reverse;                             // The direction pin points the motor backwards
+      };
+
+      // The steps X and Y took in an ISR, for the delayed parts
+      struct shaping_event_t final {
+        uint16 time;                              // shaping_now when they were taken
+        int8 steps[2];                            // The steps of X and Y
+      };
+
+      static shaper_t shapers[2];
+      static shaping_event_t shaping_queue[SHAPING_BUFFER_SIZE];
+      static uint8 shaping_head, shaping_tail;    // The queue runs from the tail, the oldest entry, to the head
+      static int8 shaping_input[2];               // Steps of the shaped axes taken by this ISR
+      static uint16 shaping_now;                  // The time of this ISR, in 4 us units
+      static uint8 shaping_remainder;             // Timer ticks left over from shaping_now, below 8
+      static uint16 shaping_interval;             // Timer ticks from this ISR to the next that steps
+
+      #define _SHAPING_INTERVAL(T) shaping_interval = (T)
+
+      static inline bool __forceinline __flatten is_shaped(const AxisEnum axis) {
+        return axis <= Y_AXIS && shapers[axis].echoes;
+      }
+    #else
+      #define _SHAPING_INTERVAL(T) NOOP
+    #endif
+
+    #if ENABLED(STEP_QUEUE_MODE)
+      static_assert(STEP_QUEUE_MOVES >= 4 && STEP_QUEUE_MOVES <= 64 && !(STEP_QUEUE_MOVES & (STEP_QUEUE_MOVES - 1)),
+        "STEP_QUEUE_MOVES must be a power of 2 between 4 and 64");
+
+      // An axis as step_queue_isr() runs it
+      struct step_axis_t final {
+        uint32 time;                              // The tick of the next event while 'count' is set, else of the last one
+        uint24 interval;                          // Ticks from the last event to the next
+        uint16 count;                             // Events left in the run
+        int16 add;                                // Ticks each interval is longer than the one before
+        uint8 flags;                              // The run's step_run_t flags
+        bool reverse;                             // The direction pin points the motor backwards
+      };
+
+      static step_run_t step_runs[NUM_AXIS][STEP_QUEUE_MOVES];
+      static spsc_ring<STEP_QUEUE_MOVES> step_run_queue[NUM_AXIS];
+      static step_axis_t step_axes[NUM_AXIS];
+      static uint32 step_queue_now;               // The tick of this ISR, from when the queues started
+      static uint16 step_queue_interval;          // Ticks from this ISR to the next
+    #endif
+
     static volatile int24 endstops_trigsteps[XYZ];
+
+    #if ENABLED(ENDSTOP_EDGE_LATCH)
+      static int24 endstops_edgesteps[XYZ];               // Where each axis was as its endstop first read as triggered
+      static chrono::time_ticks endstops_edgetime[XYZ];   // and when
+      static uint8_t endstops_latched;                    // The axes with an edge latched in this block
+      static volatile uint16_t endstops_triglag[XYZ];     // Ticks from the edge to the stop
+    #endif
     static volatile int24 endstops_stepsTotal, endstops_stepsDone;
 
     //
@@ -121,22 +268,65 @@ class Stepper final {
     //
     static void init();
 
+    //
+    // The bytes of the optional buffers, for the SRAM budget
+    //
+    static constexpr uint16 buffer_bytes() {
+      return 0
+        #if ENABLED(RAMP_TABLES)
+          + sizeof(ramp_tables)
+        #endif
+        #if ENABLED(STEP_TRACE)
+          + sizeof(step_trace) + sizeof(step_trace_queue)
+        #endif
+        #if ENABLED(INPUT_SHAPING)
+          + sizeof(shapers) + sizeof(shaping_queue)
+        #endif
+      ;
+    }
+
     //
     // Interrupt Service Routines
     //
 
     template <bool endstops_enabled> static void __forceinline __flatten isr();
 
+    #if ENABLED(ARC_BLOCKS)
+      static bool __forceinline __flatten arc_steps();
+      static void __forceinline __flatten arc_pulse(int8 step_x, int8 step_y, const bool step_z);
+    #endif
+
+    #if ENABLED(INPUT_SHAPING)
+      static void __forceinline __flatten shaping_isr();
+      static uint16 __forceinline __flatten shaping_wait(const uint16 ticks);
+    #endif
+
+    #if ENABLED(STEP_QUEUE_MODE)
+      static void __forceinline __flatten step_queue_isr();
+    #endif
+
     #if ENABLED(LIN_ADVANCE)
-    template <bool endstops_enabled> static void __forceinline __flatten advance_isr();
+    template <bool endstops_enabled> static void __forceinline __flatten advance_isr(const uint8 loops);
     template <bool endstops_enabled> static void __forceinline __flatten advance_isr_scheduler();
     #endif
 
+    //
+    // Counts the stepper ISR's runs, so positions can be read without holding it off
+    //
+    static Tuna::sequence_count position_sequence;
+
     //
     // Block until all buffered steps are executed
     //
     static void __forceinline synchronize();
 
+    #if ENABLED(RAMP_TABLES)
+      //
+      // Tabulate the ramps of the block that runs next. Called from idle().
+      //
+      static void prepare_ramp_table();
+    #endif
+
     //
     // Set the current position in steps
     //
@@ -149,11 +339,59 @@ class Stepper final {
     //
     static void __forceinline __flatten set_directions();
 
+    #if ENABLED(DIR_PORT_GROUPING)
+      //
+      // Set the XYZ direction pins to a block's dir_port_bits with one port write
+      //
+      static void __forceinline __flatten set_directions(const uint8 port_bits);
+
+      // The XYZ direction pins' bits on their shared port for a set of direction bits
+      static constexpr uint8 dir_port_bits(const uint8 direction_bits) {
+        return (((TEST(direction_bits, X_AXIS) ? INVERT_X_DIR : !INVERT_X_DIR) ? _BV(X_DIR_BIT) : 0)
+              | ((TEST(direction_bits, Y_AXIS) ? INVERT_Y_DIR : !INVERT_Y_DIR) ? _BV(Y_DIR_BIT) : 0)
+              | ((TEST(direction_bits, Z_AXIS) ? INVERT_Z_DIR : !INVERT_Z_DIR) ? _BV(Z_DIR_BIT) : 0));
+      }
+    #endif
+
     //
     // Get the position of a stepper, in steps
     //
     static int24 __forceinline __flatten position(AxisEnum axis);
 
+    //
+    // Get the positions of all steppers at one step, in steps
+    //
+    static void positions(int24 (&steps)[NUM_AXIS]);
+
+    #if ENABLED(LAZY_STEP_POSITION)
+      //
+      // What pending_steps() needs of the ISR's state, copied between two steps
+      //
+      struct pending_state_t {
+        uint24 steps, events, completed;
+        int24 counter;
+        int8 direction;
+      };
+      static pending_state_t __forceinline __flatten pending_state(const AxisEnum axis);
+      static int24 pending_steps(const pending_state_t &state);
+
+      //
+      // The steps an axis has taken in the current block, not yet in count_position
+      //
+      static int24 pending_steps(const AxisEnum axis);
+    #endif
+
+    //
+    // Where a stepper is this very step, for the ISR or with interrupts off. Others use position().
+    //
+    static inline int24 __forceinline __flatten live_position(const AxisEnum axis) {
+      #if ENABLED(LAZY_STEP_POSITION)
+        return count_position[axis] + pending_steps(axis);
+      #else
+        return count_position[axis];
+      #endif
+    }
+
     //
     // Report the positions of the steppers, in steps
     //
@@ -164,6 +402,11 @@ class Stepper final {
     //
     static float __forceinline __flatten get_axis_position_mm(AxisEnum axis);
 
+    //
+    // Get the positions (mm) of all axes from one reading of the steppers
+    //
+    static void get_positions_mm(float (&mm)[XYZE]);
+
     //
     // SCARA AB axes are in degrees, not mm
     //
@@ -203,11 +446,65 @@ class Stepper final {
       static void microstep_readings();
     #endif
 
+    #if ENABLED(STEP_TRACE)
+      // One sample of the stepper ISR, taken after it has worked out the next interval
+      struct step_trace_t final
+      {
+        uint8 block;                              // step_trace_block of the current block
+        uint8 step_loops;                         // The steps the next ISR takes
+        uint8 direction_bits;                     // The direction bits of the current block
+        uint24 step_events_completed;             // Step events done in the current block
+        uint16 interval;                          // Timer ticks to the next ISR
+      };
+
+      // Written by the stepper ISR, read and released by report_step_trace()
+      static step_trace_t step_trace[STEP_TRACE_LENGTH];
+      static spsc_ring<STEP_TRACE_LENGTH> step_trace_queue;
+
+      static void set_step_trace_interval(const uint8 interval);
+      static void report_step_trace();
+    #endif
+
+    #if ENABLED(INPUT_SHAPING)
+      // The shaper settings of X and Y, for M593 and the EEPROM. A frequency of 0 turns it off.
+      static float shaping_frequency[2], shaping_zeta[2];
+      static uint8 shaping_type[2];               // 0: ZV, 1: MZV
+
+      //
+      // Give the ISR the shapers of the settings, or turn them off while 'suspended'.
+      // Waits for the moves and the delayed steps before it.
+      //
+      static void refresh_shaping(const bool suspended = false);
+    #endif
+
+    #if ENABLED(STEP_QUEUE_MODE)
+      static volatile bool step_queue_active;     // The step queues have the motors, and the planner waits
+      static volatile uint8 step_queue_halted;    // Axes stopped by an endstop. They drop their runs until the next start.
+      static volatile uint16 step_queue_late;     // Events put out after their tick, saturating
+
+      //
+      // Hand the motors to the step queues once the planner is done, or back to the planner
+      // once the queues have run dry. The positions carry over both ways.
+      //
+      static void start_step_queues();
+      static void stop_step_queues();
+
+      //
+      // Queue a run for an axis. Returns false if its queue is full.
+      //
+      static bool queue_step_run(const AxisEnum axis, const step_run_t & __restrict run);
+
+      static inline bool __forceinline __flatten step_run_room(const AxisEnum axis) { return !step_run_queue[axis].full(); }
+    #endif
+
     #if ENABLED(BABYSTEPPING)
-      static void babystep(const AxisEnum axis, const bool direction); // perform a short step with a single stepper motor, outside of any convention
+      static void babystep(const AxisEnum axis, const bool direction); // queue a short step with a single stepper motor, outside of any convention
     #endif
 
     static inline void __forceinline __flatten kill_current_block() {
+      #if ENABLED(LAZY_STEP_POSITION)
+        commit_steps();
+      #endif
       step_events_completed = current_block->step_event_count;
     }
 
@@ -216,6 +513,31 @@ class Stepper final {
     //
     static void __forceinline __flatten endstop_triggered(AxisEnum axis);
 
+    #if ENABLED(ENDSTOP_EDGE_LATCH)
+      //
+      // Latch where an axis is as its endstop first reads as triggered, for endstop_triggered
+      //
+      static inline void __forceinline __flatten endstop_edge(AxisEnum axis) {
+        endstops_edgesteps[axis] = live_position(axis);
+        endstops_edgetime[axis] = chrono::time_ticks::get();
+        SBI(endstops_latched, axis);
+      }
+
+      //
+      // Microseconds from the edge to the stop the last time the endstop of an axis was hit
+      //
+      static inline uint16_t triggered_lag_us(AxisEnum axis) {
+        return chrono::time_ticks::to_us(endstops_triglag[axis]);
+      }
+    #endif
+
+    #if ENABLED(PARALLEL_HOMING)
+      //
+      // Stop only the axis of a triggered endstop, and the block once no axis is left
+      //
+      static void __forceinline __flatten endstop_axis_triggered(AxisEnum axis);
+    #endif
+
     //
     // Triggered position of an axis in mm (not core-savvy)
     //
@@ -225,43 +547,98 @@ class Stepper final {
 
   private:
 
-    static inline unsigned __forceinline __flatten short calc_timer(uint16/*24*/ step_rate) {
-      unsigned short timer;
+    #if ENABLED(ENDSTOP_EDGE_LATCH)
+      static void __forceinline __flatten latch_trigsteps(AxisEnum axis);
+    #endif
 
-      NOMORE(step_rate, MAX_STEP_FREQUENCY);
+    #if ENABLED(LAZY_STEP_POSITION)
+      //
+      // Add the steps taken so far to count_position, and take no more in this block
+      //
+      static void commit_steps();
+    #endif
 
-      //step_rate = min(step_rate, 159999_u24);
+    static inline void __forceinline __flatten set_step_shift(const uint8 shift) {
+      __assume(shift <= MAX_STEP_SHIFT);
+      step_shift = shift;
+      step_loops = 1 << shift;
+    }
 
-      if (step_rate > 40000) { // If steprate > 40kHz >> step 8 times
-        step_rate >>= 3;
-        step_loops = 8;
-      }
-      else if (step_rate > 20000) { // If steprate > 20kHz >> step 4 times
-        step_rate >>= 2;
-        step_loops = 4;
-      }
-      else if (step_rate > 10000) { // If steprate > 10kHz >> step 2 times
-        step_rate >>= 1;
-        step_loops = 2;
-      }
-      else {
-        step_loops = 1;
+    // STEPPER_TIMER_RATE / 'divisor', for divisors that keep the quotient within 16 bits.
+    // The dividend is a constant, so this is a 16 round shift-subtract with the low word of the
+    // dividend shifted out of the quotient register as the quotient bits are shifted in. That's
+    // about 220 cycles, against the 24-bit libgcc divide it replaces.
+    static inline uint16 __forceinline __flatten timer_reciprocal(const uint16 divisor) {
+      constexpr const uint24 dividend = STEPPER_TIMER_RATE;
+      static_assert(dividend <= type_trait<uint24>::max, "STEPPER_TIMER_RATE must fit in 24 bits");
+
+      uint16 quotient = uint16(dividend);
+      uint16 remainder = uint16(dividend >> 16);
+      uint8 count;
+
+      __asm__
+      (
+        "ldi %2, 16"      "\n\t"
+        "1:"              "\n\t"
+        "lsl %A0"         "\n\t" // Shift the next dividend bit into the remainder
+        "rol %B0"         "\n\t"
+        "rol %A1"         "\n\t"
+        "rol %B1"         "\n\t"
+        "brcs 2f"         "\n\t" // A 17-bit remainder is always larger than the divisor
+        "cp %A1, %A3"     "\n\t"
+        "cpc %B1, %B3"    "\n\t"
+        "brlo 3f"         "\n\t"
+        "2:"              "\n\t"
+        "sub %A1, %A3"    "\n\t"
+        "sbc %B1, %B3"    "\n\t"
+        "ori %A0, 1"      "\n\t" // Quotient bit
+        "3:"              "\n\t"
+        "dec %2"          "\n\t"
+        "brne 1b"         "\n\t"
+        : "+d" (quotient), "+r" (remainder), "=&d" (count)
+        : "r" (divisor)
+      );
+
+      return quotient;
+    }
+
+    #if ENABLED(S_CURVE_ACCELERATION)
+      // The step rate 'time' ticks into an S-curve ramp from 'start' to 'end'.
+      // The ramp position t is a Q16 fraction, eased by 10t^3 - 15t^4 + 6t^5 with 16x16 multiplies.
+      static inline uint16 __forceinline __flatten s_curve_rate(const uint24 time, const s_curve_t & __restrict curve, const uint16 start, const uint16 end) {
+        if (time >= curve.ticks) return end;
+
+        const uint16 t = uint16((uint32(uint16(time >> curve.shift)) * curve.inverse) >> 16);
+        const uint16 t2 = Tuna::intrinsic::mul_hi(t, t);
+        const uint16 t3 = Tuna::intrinsic::mul_hi(t2, t);
+        // 10 - 15t + 6t^2, in Q12. This stays between 1 and 10.
+        const uint16 poly = uint16(40960 + ((int32(t2) * 6 - int32(t) * 15) >> 4));
+        const uint16 eased = uint16(min((uint32(t3) * poly) >> 12, uint32(type_trait<uint16>::max)));
+
+        return (end >= start)
+          ? start + Tuna::intrinsic::mul_hi(uint16(end - start), eased)
+          : start - Tuna::intrinsic::mul_hi(uint16(start - end), eased);
       }
+    #endif
 
-      //while (step_rate > 20'000)
-      //{
-      //  step_rate >>= 1;
-      //  ++step_loops;
-      //}
+    // The ISR interval for 'step_rate' when taking 1 << 'shift' steps per ISR.
+    // The planner picks the shift for each part of the block (see MULTISTEP_RATE), so the
+    // thresholds aren't tested here.
+    static inline unsigned __forceinline __flatten short calc_timer(uint16/*24*/ step_rate, const uint8 shift) {
+      NOMORE(step_rate, MAX_STEP_FREQUENCY);
 
-      __assume(step_rate <= 20000);
+      step_rate >>= shift;
 
       // With a max value of 65535, this gives us a minimum step rate of 2,000,000 / X = 65535, 
       // which is ~30.518Hz. The counters are 16-bit, so it's not trivially possible to go lower than
       // this, though it can be done by requiring multiple ISR hits per step. I doubt that this is useful,
       // however. This would imply a speed of something like 0.3mm/sec on a 100 steps-per-mm stepper, which
       // would be incredibly slow. I imagine it is a speed that could only pop up during ramp-up/down.
-      return min(2'000'000_u24 / step_rate, uint24(type_trait<uint16>::max));
+      constexpr const uint16 min_timer_rate = (STEPPER_TIMER_RATE / type_trait<uint16>::max) + 1;
+      if (__unlikely(step_rate < min_timer_rate)) {
+        return type_trait<uint16>::max;
+      }
+      return timer_reciprocal(step_rate);
     }
 
     // Initialize the trapezoid generator from the current block.
@@ -285,20 +662,37 @@ class Stepper final {
 #if EXTRUDERS > 1
         last_extruder = current_block->active_extruder;
 #endif
+#if ENABLED(DIR_PORT_GROUPING)
+        set_directions(current_block->dir_port_bits);
+#else
         set_directions();
+#endif
       }
 
       deceleration_time = 0;
       // step_rate to timer interval
-      OCR1A_nominal = calc_timer(current_block->nominal_rate);
-      // make a note of the number of step loops required at nominal speed
-      step_loops_nominal = step_loops;
+      OCR1A_nominal = calc_timer(current_block->nominal_rate, current_block->nominal_step_shift);
+      set_step_shift(current_block->initial_step_shift);
       acc_step_rate = current_block->initial_rate;
-      acceleration_time = calc_timer(acc_step_rate);
+      acceleration_time = calc_timer(acc_step_rate, step_shift);
+
+      #if ENABLED(S_CURVE_ACCELERATION)
+        accel_curve = current_block->accel_curve;
+        decel_curve = current_block->decel_curve;
+        plateau_rate = uint16(min(current_block->plateau_rate, uint24(type_trait<uint16>::max)));
+      #endif
       _NEXT_ISR(acceleration_time);
 
+      #if ENABLED(RAMP_TABLES)
+        ramp_table = nullptr;
+        for (const ramp_table_t &table : ramp_tables) {
+          if (table.matches(current_block)) ramp_table = &table;
+        }
+        ramp_accel_index = ramp_decel_index = 0;
+      #endif
+
       #if ENABLED(LIN_ADVANCE)
-        if (current_block->use_advance_lead) {
+        if (TEST(current_block->flag, BLOCK_BIT_USE_ADVANCE_LEAD)) {
           current_estep_rate[current_block->active_extruder] = ((unsigned long)acc_step_rate * current_block->abs_adv_steps_multiplier8) >> 17;
           final_estep_rate = (current_block->nominal_rate * current_block->abs_adv_steps_multiplier8) >> 17;
         }
@@ -323,6 +717,15 @@ class Stepper final {
       static void microstep_init();
     #endif
 
+    #if ENABLED(STEP_RATE_CALIBRATION)
+      static void calibrate_step_rate();
+    #endif
+
+    #if ENABLED(BABYSTEPPING)
+      static void __forceinline __flatten babystep_isr();
+      static void __forceinline __flatten babystep_pulse(const AxisEnum axis, const bool direction);
+    #endif
+
 };
 
 #endif // STEPPER_H
@@ -257,6 +257,26 @@
   #define Z2_STEP_READ READ(Z2_STEP_PIN)
 #endif
 
+// XYZ step pins as output port and bit, for STEP_PORT_GROUPING
+#define _STEP_PORT(IO) DIO ## IO ## _WPORT
+#define _STEP_BIT(IO) DIO ## IO ## _PIN
+#define STEP_PORT(IO) _STEP_PORT(IO)
+#define STEP_BIT(IO) _STEP_BIT(IO)
+#define X_STEP_PORT STEP_PORT(X_STEP_PIN)
+#define X_STEP_BIT STEP_BIT(X_STEP_PIN)
+#define Y_STEP_PORT STEP_PORT(Y_STEP_PIN)
+#define Y_STEP_BIT STEP_BIT(Y_STEP_PIN)
+#define Z_STEP_PORT STEP_PORT(Z_STEP_PIN)
+#define Z_STEP_BIT STEP_BIT(Z_STEP_PIN)
+
+// XYZ direction pins as output port and bit, for DIR_PORT_GROUPING
+#define X_DIR_PORT STEP_PORT(X_DIR_PIN)
+#define X_DIR_BIT STEP_BIT(X_DIR_PIN)
+#define Y_DIR_PORT STEP_PORT(Y_DIR_PIN)
+#define Y_DIR_BIT STEP_BIT(Y_DIR_PIN)
+#define Z_DIR_PORT STEP_PORT(Z_DIR_PIN)
+#define Z_DIR_BIT STEP_BIT(Z_DIR_PIN)
+
 // E0 Stepper
 #if ENABLED(HAVE_L6470DRIVER) && ENABLED(E0_IS_L6470)
   extern L6470 stepperE0;
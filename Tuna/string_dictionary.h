@@ -0,0 +1,133 @@
+#pragma once
+
+// Generated by rbbuild/strings.rb from the serial messages: the words that save the most as
+// PACKED_STRINGS tokens. A rebuild makes it again.
+#define PACKED_STRING_WORDS \
+  " extrusion ", \
+  "prevented", \
+  " failed", \
+  "feedrate", \
+  "Acceleration", \
+  " to ", \
+  " acceleration ", \
+  " read ", \
+  "EEPROM", \
+  "error", \
+  "Cap:", \
+  " defaults ", \
+  " range", \
+  " out ", \
+  "Settings ", \
+  "max", \
+  "file", \
+  "min", \
+  " M200 ", \
+  " Leveling", \
+  " in ", \
+  " settings", \
+  " the ", \
+  "Mesh ", \
+  "extruder ", \
+  "retracted", \
+  " writing", \
+  "File", \
+  "Setting ", \
+  "advance ", \
+  "jerk", \
+  "open", \
+  " queue", \
+  " reset", \
+  " too ", \
+  "Steps", \
+  "Temperature", \
+  "limits", \
+  "units", \
+  " mismatch ", \
+  " segments:", \
+  " update", \
+  "Travel ", \
+  "current", \
+  " and ", \
+  " cold", \
+  " or", \
+  " printing", \
+  " M420 ", \
+  " Units", \
+  " be ", \
+  " bytes", \
+  "length", \
+  "rate", \
+  "used", \
+  " stopped", \
+  "Firmware", \
+  "firmware", \
+  " blocks", \
+  " for", \
+  " must", \
+  " string", \
+  " subdir", \
+  "Cannot ", \
+  "Printer", \
+  "Reset", \
+  "Retract", \
+  "long", \
+  "segment", \
+  "start", \
+  "time", \
+  " block", \
+  " checkpoint", \
+  " from ", \
+  " parameters", \
+  "Stats:", \
+  "retracting ", \
+  "stored", \
+  "travel", \
+  " avg", \
+  "slot", \
+  " Timeout:", \
+  " byte", \
+  " command:", \
+  " commands", \
+  " is", \
+  " more", \
+  " selected", \
+  " us", \
+  "Advanced:", \
+  "EMERGENCY", \
+  "No ", \
+  "Print", \
+  "accel", \
+  "benchmark", \
+  "busy:", \
+  "remainder", \
+  "swapping ", \
+  " cycles:", \
+  " prints:", \
+  " shaping", \
+  "Filament", \
+  "Invalid ", \
+  "Maximum ", \
+  "Thermal ", \
+  "Watchdog", \
+  "endstops", \
+  "position", \
+  "workDir ", \
+  " Count ", \
+  " Heater", \
+  " after ", \
+  " calls:", \
+  " index ", \
+  " meshes", \
+  " per", \
+  " total:", \
+  "Active ", \
+  "Advance", \
+  "Auto", \
+  "Bed", \
+  "PARSER:", \
+  "Planner", \
+  "STATUS:", \
+  "Set ", \
+  "amount ", \
+  "job", \
+  "offset:"
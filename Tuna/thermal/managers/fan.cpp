@@ -0,0 +1,237 @@
+#include <tuna.h>
+
+#include "fan.hpp"
+#include "log.hpp"
+
+#include "bi3_plus_lcd.h"
+
+#include "configuration_store.h"
+
+using namespace Tuna::Thermal;
+
+namespace
+{
+  using namespace Tuna;
+
+  constexpr const auto Tag = "FanCompensation"_p;
+
+  // Level 0 is the fan off, and level i of the table is at fan PWM 64 * i, the last at 255.
+  constexpr uint8 level_pwm(arg_type<uint8> level)
+  {
+    return uint8(min(uint16(level) * 64_u16, 255_u16));
+  }
+
+  constexpr const auto reach_timeout = 600000_ms24;  // to get to the target at the start
+  constexpr const auto settle_time = 60000_ms24;     // after each change of fan speed
+  constexpr const auto measure_time = 30000_ms24;    // the heater power is averaged over this
+  constexpr const temp_t reach_window = 1_C;
+
+  // SRAM
+  FanCompensation::calibration fan_calibration;
+  uint8 applied_speed = 0;
+  uint8 applied_power = 0;
+
+  uint8 interpolate(arg_type<uint8> pwm)
+  {
+    if (pwm == 0)
+    {
+      return 0;
+    }
+
+    const uint8 segment = pwm >> 6;
+    const uint8 low_pwm = segment << 6;
+    const uint8 span = level_pwm(segment + 1) - low_pwm;
+    const int16 low = (segment == 0) ? 0 : fan_calibration.Power_[segment - 1];
+    const int16 high = fan_calibration.Power_[segment];
+
+    return uint8(low + ((high - low) * int16(pwm - low_pwm)) / span);
+  }
+
+  // The calibration is a state machine that manage_heater() steps once per temperature update.
+  enum class Phase : uint8
+  {
+    Idle = 0,
+    Reach,      // Heating to the target with the fan off.
+    Settle,     // Letting the hotend settle at the current fan level.
+    Measure     // Averaging the heater power at the current fan level.
+  };
+
+  struct calibration_state final
+  {
+    Phase phase = Phase::Idle;
+    uint8 level = 0;
+    uint8 baseline = 0;         // mean heater power with the fan off
+    temp_t target = 0_C;
+    chrono::time_ms24 start_time;
+    uint32 power_sum = 0;
+    uint16 samples = 0;
+    FanCompensation::calibration result;
+  } cal;
+
+  void set_fan(arg_type<uint8> pwm)
+  {
+#if FAN_COUNT > 0
+    fanSpeeds[0] = pwm;
+#endif
+  }
+
+  void begin_phase(arg_type<Phase> phase)
+  {
+    cal.phase = phase;
+    cal.start_time = chrono::time_ms24::get();
+    cal.power_sum = 0;
+    cal.samples = 0;
+  }
+
+  void stop()
+  {
+    cal.phase = Phase::Idle;
+    set_fan(0);
+    Temperature::setTargetHotend(0_C);
+  }
+
+  void finish()
+  {
+    stop();
+
+    FanCompensation::SetCalibration(cal.result);
+
+    lcd::show_page(lcd::Page::PID_Finished);
+    enqueue_and_echo_command("M107");
+
+    settings.save();
+  }
+
+  void finish_level()
+  {
+    const uint8 mean = uint8(cal.power_sum / cal.samples);
+    if (cal.level == 0)
+    {
+      cal.baseline = mean;
+    }
+    else
+    {
+      cal.result.Power_[cal.level - 1] = (mean > cal.baseline) ? uint8(mean - cal.baseline) : 0_u8;
+    }
+    Log::d<1>(Tag, "Fan %u: heater %u"_p, level_pwm(cal.level), mean);
+
+    if (++cal.level > FanCompensation::levels)
+    {
+      finish();
+      return;
+    }
+
+    set_fan(level_pwm(cal.level));
+    begin_phase(Phase::Settle);
+  }
+}
+
+void FanCompensation::set_fan_speed(arg_type<uint8> pwm)
+{
+  if (__likely(pwm == applied_speed))
+  {
+    return;
+  }
+  applied_speed = pwm;
+  applied_power = interpolate(pwm);
+}
+
+__pure uint8 FanCompensation::fan_speed()
+{
+  return applied_speed;
+}
+
+__pure uint8 FanCompensation::power()
+{
+  // The calibration measures the heater without it.
+  return is_calibrating() ? 0_u8 : applied_power;
+}
+
+__pure const FanCompensation::calibration & FanCompensation::GetCalibration()
+{
+  return fan_calibration;
+}
+
+void FanCompensation::SetCalibration(arg_type<calibration> value)
+{
+  Log::d(Tag, "Current Calibration: %u %u %u %u"_p, value.Power_[0], value.Power_[1], value.Power_[2], value.Power_[3]);
+
+  fan_calibration = value;
+  applied_power = interpolate(applied_speed);
+}
+
+bool FanCompensation::calibrate(arg_type<temp_t> target)
+{
+  if (__unlikely(Temperature::is_calibrating()))
+  {
+    return false;
+  }
+
+  Log::d(Tag, "Starting Calibration"_p);
+
+  cal = {};
+  cal.target = target;
+  cal.result = fan_calibration;
+
+  set_fan(0);
+  Temperature::setTargetHotend(target);
+  begin_phase(Phase::Reach);
+
+  return true;
+}
+
+void FanCompensation::calibration_step()
+{
+  // A new target from anywhere else (M104, disable_all_heaters()) is taken as a cancel.
+  if (__unlikely(Temperature::degTargetHotend() != cal.target))
+  {
+    Log::d(Tag, "Calibration Aborted"_p);
+    cal.phase = Phase::Idle;
+    set_fan(0);
+    return;
+  }
+
+  const auto now = chrono::time_ms24::get();
+  const temp_t temperature = Temperature::degHotend();
+
+  switch (cal.phase)
+  {
+  case Phase::Reach:
+    if (temperature + reach_window >= cal.target)
+    {
+      begin_phase(Phase::Settle);
+    }
+    else if (__unlikely(cal.start_time.elapsed(now, reach_timeout)))
+    {
+      Log::d(Tag, "Calibration Failed: timeout"_p);
+      stop();
+    }
+    break;
+  case Phase::Settle:
+    if (cal.start_time.elapsed(now, settle_time))
+    {
+      begin_phase(Phase::Measure);
+    }
+    break;
+  case Phase::Measure:
+    cal.power_sum += Temperature::getHeaterPower<Temperature::Manager::Hotend>();
+    ++cal.samples;
+    if (cal.start_time.elapsed(now, measure_time))
+    {
+      finish_level();
+    }
+    break;
+  default:
+    break;
+  }
+}
+
+__pure bool FanCompensation::is_calibrating()
+{
+  return cal.phase != Phase::Idle;
+}
+
+__pure uint8 FanCompensation::calibration_progress()
+{
+  return uint8((uint16(cal.level) * 100_u16) / (levels + 1));
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "thermal/thermal.hpp"
+
+namespace Tuna::Thermal
+{
+  // Feed-forward for the part-cooling fan. The planner reports each fan speed it applies from a
+  // block, and the heater manager gets the extra power that speed takes at once, instead of
+  // reacting after the temperature has dropped. The extra power is measured at a few fan levels by
+  // M303 F and kept in EEPROM; between levels it is interpolated. The Model manager doesn't use the
+  // table, as its FanLoss_ term covers the same loss, but it does take the applied fan speed.
+  struct FanCompensation final : trait::ce_only
+  {
+    static constexpr const uint8 levels = 4; // fan PWM 64, 128, 192 and 255
+
+    struct calibration final
+    {
+      uint8 Power_[levels] = {};  // heater PWM added at each level
+    };
+
+    // Called by the planner when the part fan is set to a new PWM.
+    static void set_fan_speed(arg_type<uint8> pwm);
+    static __pure uint8 fan_speed();
+    // Heater PWM to add for the current fan speed.
+    static __pure uint8 power();
+
+    // Starts measuring the table at 'target', which manage_heater() then steps through with calibration_step().
+    static bool calibrate(arg_type<temp_t> target);
+    static void calibration_step();
+    static __pure bool is_calibrating();
+    static __pure uint8 calibration_progress(); // percent
+
+    static __pure const calibration & GetCalibration();
+    static void SetCalibration(arg_type<calibration> value);
+  };
+}
@@ -0,0 +1,80 @@
+#pragma once
+
+// TODO Establish a global logging system like this.
+// The thermal managers' log. 'tabs' is a message's depth: 0 for what a calibration does, 1 for the
+// steps in between. Messages as deep as LOG_LEVEL or deeper are compiled out, arguments and all.
+// Strings passed as arguments must be in flash, for %S.
+namespace Tuna::Log
+{
+#if ENABLED(LOG_BINARY)
+  namespace _internal
+  {
+    inline void write(const void * __restrict data, arg_type<uint8> size)
+    {
+      const uint8 * __restrict bytes = reinterpret_cast<const uint8 *>(data);
+      for (uint8 i = 0; i < size; ++i)
+      {
+        Serial.write(bytes[i]);
+      }
+    }
+
+    // Arguments are sent as printf would take them: up to 16 bits as 16, larger integers as 32,
+    // floats as they are, and pointers (flash strings) as their address.
+    template <typename T>
+    constexpr uint8 arg_size()
+    {
+      return (sizeof(T) <= sizeof(uint16)) ? 2 : 4;
+    }
+
+    template <typename T>
+    inline void write_arg(const T & __restrict value)
+    {
+      if constexpr (is_same<T, float>)
+      {
+        write(&value, sizeof(float));
+      }
+      else if constexpr (sizeof(T) <= sizeof(uint16))
+      {
+        const uint16 promoted = uint16(value);
+        write(&promoted, sizeof(promoted));
+      }
+      else
+      {
+        const uint32 promoted = uint32(value);
+        write(&promoted, sizeof(promoted));
+      }
+    }
+  }
+#endif
+
+  template <uint8 tabs = 0, typename ...Args>
+  inline void d(arg_type<flash_string> tag, arg_type<flash_string> format, Args... args)
+  {
+    if constexpr (tabs < LOG_LEVEL)
+    {
+      critical_section log_critsec;
+#if ENABLED(LOG_BINARY)
+      // "log:<length>", then the tag's and the format's flash addresses, the depth and the
+      // arguments, and a newline. decode_log.py reads the strings back out of the build's .hex.
+      constexpr const uint8 length = sizeof(uint16) * 2 + 1 + (0 + ... + _internal::arg_size<Args>());
+      Serial.print("log:"_p.fsh());
+      Serial.println(length);
+      const uint16 addresses[] = { uint16(tag.c_str()), uint16(format.c_str()) };
+      _internal::write(addresses, sizeof(addresses));
+      Serial.write(tabs);
+      (_internal::write_arg(args), ...);
+      Serial.println();
+#else
+      Serial.print(tag.fsh());
+      Serial.print(": "_p.fsh());
+      for (uint8 i = 0; i < tabs; ++i)
+      {
+        Serial.print("  "_p.fsh());
+      }
+      char buffer[128];
+      sprintf_P(buffer, format.c_str(), args...);
+      Serial.println(buffer);
+#endif
+    }
+  }
+}
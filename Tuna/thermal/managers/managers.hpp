@@ -0,0 +1,27 @@
+#pragma once
+
+// The manager the hotend is driven by. Each provides calibrate(), get_power(), debug_dump() and
+// Get/SetCalibration().
+#if ENABLED(MODEL_HEATER_MANAGER)
+  #include "model.hpp"
+#else
+  #include "simple.hpp"
+#endif
+#if ENABLED(PIDTEMPBED)
+  #include "pid.hpp"
+#endif
+#include "fan.hpp"
+
+namespace Tuna::Thermal
+{
+#if ENABLED(MODEL_HEATER_MANAGER)
+  using HeaterManager = Manager::Model;
+#else
+  using HeaterManager = Manager::Simple;
+#endif
+
+  // The bed's manager, when it isn't bang-bang.
+#if ENABLED(PIDTEMPBED)
+  using BedManager = Manager::Pid<Temperature::Manager::Bed>;
+#endif
+}
@@ -0,0 +1,404 @@
+#include <tuna.h>
+
+#if ENABLED(MODEL_HEATER_MANAGER)
+
+#include "model.hpp"
+#include "fan.hpp"
+#include "log.hpp"
+
+#include "bi3_plus_lcd.h"
+#include "planner.h"
+#include "stepper.h"
+
+#include "configuration_store.h"
+
+#include <math.h>
+
+using namespace Tuna::Thermal::Manager;
+
+namespace
+{
+  using namespace Tuna;
+
+  constexpr const auto Tag = "ModelManager"_p;
+
+  constexpr const float heater_power = MODEL_HEATER_POWER;                      // W
+  constexpr const float filament_heat_capacity = MODEL_FILAMENT_HEAT_CAPACITY;  // J/K per mm of filament
+  constexpr const float inverse_response_time = 1.0f / MODEL_RESPONSE_TIME;     // 1/s
+
+  // How far the prediction is pulled to the measured temperature each update, and how much of the
+  // remaining error moves the ambient estimate. Ambient only adapts near the target, where the model
+  // error is due to the losses rather than to the heater's lag.
+  constexpr const float measurement_gain = 0.5f;
+  constexpr const float ambient_gain = 0.02f;
+  constexpr const float ambient_adapt_band = 5.0f;
+  // Updates further apart than this are treated as a restart of the model.
+  constexpr const uint16 max_update_ms = 1000;
+
+  // SRAM
+  Model::calibration model_calibration;
+
+  struct state final
+  {
+    float temperature = 0.0f;     // predicted block temperature, C
+    float ambient = 25.0f;        // estimated ambient temperature, C
+    float power = 0.0f;           // heater duty applied since the last update, [0, 1]
+    int24 e_position = 0;         // E steps at the last update
+    chrono::time_ms16 last_update;
+    bool valid = false;
+  } model;
+
+  // During calibration the heater runs at a forced duty instead of the model's.
+  bool override_power = false;
+  uint8 forced_power = 0;
+
+  // The speed the planner last applied, which follows the blocks rather than the last M106.
+  uint8 __forceinline __flatten fan_speed()
+  {
+    return Tuna::Thermal::FanCompensation::fan_speed();
+  }
+
+  void set_fan_speed(arg_type<uint8> speed)
+  {
+#if FAN_COUNT > 0
+    fanSpeeds[0] = speed;
+#endif
+  }
+
+  // W/K lost from the block at the current fan speed and extrusion rate.
+  float __forceinline __flatten loss_coefficient(arg_type<float> extrusion_rate)
+  {
+    return model_calibration.AmbientLoss_ +
+      (model_calibration.FanLoss_ * (1.0f / 255.0f)) * fan_speed() +
+      filament_heat_capacity * extrusion_rate;
+  }
+}
+
+const __forceinline __flatten Model::calibration & Model::GetCalibration()
+{
+  return model_calibration;
+}
+
+void Model::SetCalibration(arg_type<calibration> value)
+{
+  Log::d(Tag, "Current Calibration: C %.4f J/K, k %.4f W/K, fan %.4f W/K"_p, value.HeatCapacity_, value.AmbientLoss_, value.FanLoss_);
+
+  model_calibration = value;
+  model.valid = false;
+}
+
+uint8 __forceinline __flatten Model::get_power(arg_type<temp_t> current, arg_type<temp_t> target)
+{
+  const chrono::time_ms16 now = chrono::time_ms16::get();
+  const int24 e_position = Stepper::position(E_AXIS);
+  const float measured = float(current);
+  uint16 elapsed_ms = (now - model.last_update).raw();
+
+  if (__unlikely(!model.valid || elapsed_ms > max_update_ms))
+  {
+    model.temperature = measured;
+    model.power = 0.0f;
+    model.e_position = e_position;
+    model.last_update = now;
+    model.valid = true;
+    elapsed_ms = 0;
+  }
+
+  if (elapsed_ms != 0)
+  {
+    const float dt = elapsed_ms * 0.001f;
+    const int24 e_steps = e_position - model.e_position;
+    const float extrusion_rate = (e_steps > 0) ? (e_steps * Planner::steps_to_mm[E_AXIS]) / dt : 0.0f;
+    const float loss = loss_coefficient(extrusion_rate);
+
+    // Predict where the power we applied took the block, then correct the prediction.
+    model.temperature += ((heater_power * model.power) - loss * (model.temperature - model.ambient)) * dt / model_calibration.HeatCapacity_;
+    const float error = measured - model.temperature;
+    model.temperature += error * measurement_gain;
+
+    if (fabs(float(target) - measured) < ambient_adapt_band)
+    {
+      // Running hotter than predicted means the losses were overestimated, which is the same as the air being warmer.
+      model.ambient += error * ambient_gain;
+    }
+
+    // The power that closes the gap within the response time, plus what the losses take at the target.
+    const float wanted = (model_calibration.HeatCapacity_ * (float(target) - model.temperature) * inverse_response_time) +
+      loss * (float(target) - model.ambient);
+
+    model.power = constrain(wanted * (1.0f / heater_power), 0.0f, 1.0f);
+    model.e_position = e_position;
+    model.last_update = now;
+  }
+
+  if (__unlikely(override_power))
+  {
+    model.power = forced_power * (1.0f / 255.0f);
+    return forced_power;
+  }
+
+  return uint8(model.power * 255.0f + 0.5f);
+}
+
+void Model::debug_dump()
+{
+}
+
+namespace
+{
+  constexpr const auto settle_time = 20000_ms24;
+  constexpr const auto hold_time = 60000_ms24;
+  constexpr const auto phase_timeout = 900000_ms24;
+  constexpr const auto ambient_sample_time = 10000_ms24;
+  constexpr const float dt_ambient = 10.0f;   // the slope is measured across [ambient + 10, ambient + 30]
+  constexpr const float slope_span = 20.0f;
+
+  // The calibration is a state machine that manage_heater() steps once per temperature update,
+  // so the printer keeps running while it goes on.
+  enum class Phase : uint8
+  {
+    Idle = 0,
+    Ambient,    // Cooling with the fan until the temperature stops falling.
+    Heating,    // Full power with the fan off, timing the rise across the slope window.
+    Hold,       // Bang-bang at the target; the mean duty covers the losses.
+    HoldFan     // The same with the fan on.
+  };
+
+  struct calibration_state final
+  {
+    Phase phase = Phase::Idle;
+    temp_t target = 0_C;
+    temp_t expected_target = 0_C; // what we last set; anything else means someone took over the hotend
+    chrono::time_ms24 start_time;   // of the phase
+
+    float ambient = 0.0f;
+    float last_temperature = 0.0f;
+    chrono::time_ms24 last_sample_time;
+    uint24 low_time = 0;
+    uint24 high_time = 0;
+    uint32 duty_sum = 0;
+    uint16 samples = 0;
+    float slope = 0.0f;
+
+    Model::calibration result;
+  } cal;
+
+  void set_target(arg_type<temp_t> temp)
+  {
+    Temperature::setTargetHotend(temp);
+    cal.expected_target = temp;
+  }
+
+  void begin_phase(arg_type<Phase> phase, arg_type<flash_string> name)
+  {
+    Log::d(Tag, "%S"_p, name.c_str());
+    cal.phase = phase;
+    cal.start_time = chrono::time_ms24::get();
+    cal.duty_sum = 0;
+    cal.samples = 0;
+  }
+
+  void stop()
+  {
+    cal.phase = Phase::Idle;
+    override_power = false;
+    set_fan_speed(0);
+    set_target(0_C);
+  }
+
+  void fail(arg_type<flash_string> reason)
+  {
+    Log::d(Tag, "Calibration Failed: %S"_p, reason.c_str());
+    stop();
+  }
+
+  // Holds the target with bang-bang control, and returns true with the mean duty once the hold is over.
+  bool hold(arg_type<float> temperature, arg_type<uint24> elapsed, float & __restrict duty)
+  {
+    forced_power = (temperature < float(cal.target)) ? 0xFF_u8 : 0x00_u8;
+    if (elapsed >= settle_time.raw())
+    {
+      cal.duty_sum += forced_power;
+      ++cal.samples;
+    }
+    if (elapsed < settle_time.raw() + hold_time.raw() || cal.samples == 0)
+    {
+      return false;
+    }
+    duty = float(cal.duty_sum) / (255.0f * cal.samples);
+    return true;
+  }
+
+  void finish()
+  {
+    // The loss across the slope window was small but not nothing.
+    const float window_loss = cal.result.AmbientLoss_ * (dt_ambient + slope_span * 0.5f);
+    cal.result.HeatCapacity_ = (heater_power - window_loss) / cal.slope;
+
+    stop();
+
+    Log::d<1>(Tag, "Heat Capacity: %.4f J/K"_p, cal.result.HeatCapacity_);
+    Log::d<1>(Tag, "Ambient Loss: %.4f W/K"_p, cal.result.AmbientLoss_);
+    Log::d<1>(Tag, "Fan Loss: %.4f W/K"_p, cal.result.FanLoss_);
+
+    Model::SetCalibration(cal.result);
+
+    lcd::show_page(lcd::Page::PID_Finished);
+    enqueue_and_echo_command("M107");
+
+    settings.save();
+  }
+}
+
+bool Model::calibrate(arg_type<temp_t> target)
+{
+  if (__unlikely(is_calibrating()))
+  {
+    return false;
+  }
+
+  Log::d(Tag, "Starting Calibration"_p);
+
+  cal = {};
+  cal.target = target;
+  cal.result = model_calibration;
+  cal.last_temperature = float(Temperature::degHotend());
+  override_power = true;
+
+  // Only the hotend is ours; the bed may be heating alongside.
+  set_target(0_C);
+  set_fan_speed(0xFF);
+  begin_phase(Phase::Ambient, "Measuring Ambient"_p);
+
+  return true;
+}
+
+void Model::calibration_step()
+{
+  // A new target from anywhere else (M104, disable_all_heaters()) is taken as a cancel.
+  if (__unlikely(Temperature::degTargetHotend() != cal.expected_target))
+  {
+    Log::d(Tag, "Calibration Aborted"_p);
+    cal.phase = Phase::Idle;
+    override_power = false;
+    return;
+  }
+
+  const auto now = chrono::time_ms24::get();
+  if (__unlikely(cal.start_time.elapsed(now, phase_timeout)))
+  {
+    fail("timeout"_p);
+    return;
+  }
+
+  const float temperature = float(Temperature::degHotend());
+  const uint24 elapsed = (now - cal.start_time).raw();
+
+  switch (cal.phase)
+  {
+  case Phase::Ambient:
+  {
+    if ((now - cal.last_sample_time).raw() < ambient_sample_time.raw())
+    {
+      break;
+    }
+    const bool steady = (cal.last_temperature - temperature) < 0.2f;
+    cal.last_temperature = temperature;
+    cal.last_sample_time = now;
+    if (!steady)
+    {
+      break;
+    }
+
+    cal.ambient = temperature;
+    Log::d<1>(Tag, "Ambient: %.2f"_p, cal.ambient);
+
+    if (float(cal.target) < cal.ambient + dt_ambient + slope_span + 10.0f)
+    {
+      fail("target too low"_p);
+      break;
+    }
+
+    set_fan_speed(0);
+    forced_power = 0xFF;
+    set_target(cal.target);
+    begin_phase(Phase::Heating, "Heating"_p);
+  } break;
+  case Phase::Heating:
+  {
+    if (cal.low_time == 0 && temperature >= cal.ambient + dt_ambient)
+    {
+      cal.low_time = elapsed | 1;
+    }
+    if (cal.high_time == 0 && temperature >= cal.ambient + dt_ambient + slope_span)
+    {
+      cal.high_time = elapsed | 1;
+    }
+    if (temperature < float(cal.target))
+    {
+      break;
+    }
+    if (cal.high_time <= cal.low_time)
+    {
+      fail("no slope"_p);
+      break;
+    }
+
+    cal.slope = slope_span * 1000.0f / float(cal.high_time - cal.low_time);   // K/s
+    Log::d<1>(Tag, "Slope: %.4f K/s"_p, cal.slope);
+    begin_phase(Phase::Hold, "Holding"_p);
+  } break;
+  case Phase::Hold:
+  {
+    float duty;
+    if (!hold(temperature, elapsed, duty))
+    {
+      break;
+    }
+
+    cal.result.AmbientLoss_ = heater_power * duty / (float(cal.target) - cal.ambient);
+    set_fan_speed(0xFF);
+    begin_phase(Phase::HoldFan, "Holding with Fan"_p);
+  } break;
+  case Phase::HoldFan:
+  {
+    float duty;
+    if (!hold(temperature, elapsed, duty))
+    {
+      break;
+    }
+
+    cal.result.FanLoss_ = max(0.0f, heater_power * duty / (float(cal.target) - cal.ambient) - cal.result.AmbientLoss_);
+    finish();
+  } break;
+  default:
+    break;
+  }
+}
+
+__pure bool Model::is_calibrating()
+{
+  return cal.phase != Phase::Idle;
+}
+
+__pure uint8 Model::calibration_progress()
+{
+  // A quarter each for the ambient and heating phases, which have no known length, and the rest over the holds.
+  constexpr const uint24 hold_total = settle_time.raw() + hold_time.raw();
+  const uint24 elapsed = (chrono::time_ms24::get() - cal.start_time).raw();
+  const uint8 hold_progress = uint8((uint32(min(elapsed, hold_total)) * 25) / hold_total);
+
+  switch (cal.phase)
+  {
+  case Phase::Heating:
+    return 25;
+  case Phase::Hold:
+    return 50 + hold_progress;
+  case Phase::HoldFan:
+    return 75 + hold_progress;
+  default:
+    return 0;
+  }
+}
+
+#endif
@@ -0,0 +1,33 @@
+#pragma once
+
+#include "thermal/thermal.hpp"
+
+namespace Tuna::Thermal::Manager
+{
+  // Drives the hotend from a lumped thermal model of it: a heater of known power heating a block of
+  // some heat capacity, which loses heat to the air (more so with the part fan on) and to the filament
+  // being pushed through it. Each update predicts the temperature from the power it last applied,
+  // corrects the prediction against the thermistor, and then asks for the power that would bring the
+  // block to the target within MODEL_RESPONSE_TIME while covering the losses at the target. Whatever
+  // the model gets wrong at steady state is absorbed into its estimate of the ambient temperature.
+  struct Model final : trait::ce_only
+  {
+    struct calibration final
+    {
+      float HeatCapacity_ = MODEL_HEAT_CAPACITY;   // J/K
+      float AmbientLoss_ = MODEL_AMBIENT_LOSS;     // W/K, with the fan off
+      float FanLoss_ = MODEL_FAN_LOSS;             // W/K, added at full fan
+    };
+
+    // Starts a calibration at 'target', which manage_heater() then steps through with calibration_step().
+    static bool calibrate(arg_type<temp_t> target);
+    static void calibration_step();
+    static __pure bool is_calibrating();
+    static __pure uint8 calibration_progress(); // percent
+    static uint8 __forceinline __flatten get_power(arg_type<temp_t> current, arg_type<temp_t> target);
+    static __pure void debug_dump();
+
+    static __pure const __forceinline __flatten calibration & GetCalibration();
+    static void SetCalibration(arg_type<calibration> val);
+  };
+}
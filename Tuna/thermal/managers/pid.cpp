@@ -0,0 +1,336 @@
+#include <tuna.h>
+
+#include "pid.hpp"
+#include "log.hpp"
+
+#include "bi3_plus_lcd.h"
+
+#include "configuration_store.h"
+
+#include <math.h>
+
+using namespace Tuna::Thermal::Manager;
+
+namespace
+{
+  using namespace Tuna;
+
+  using Heater_t = Temperature::Manager;
+
+#ifdef PID_FUNCTIONAL_RANGE
+  constexpr const float functional_range = PID_FUNCTIONAL_RANGE;
+#else
+  constexpr const float functional_range = 10.0f;
+#endif
+#ifdef K1
+  constexpr const float derivative_smoothing = K1;
+#else
+  constexpr const float derivative_smoothing = 0.95f;
+#endif
+
+  // The loop runs at this period rather than on every temperature update, so the derivative
+  // sees a change larger than the ADC noise.
+  constexpr const uint16 update_ms = 100;
+  // Updates further apart than this restart the loop.
+  constexpr const uint16 max_update_ms = 1000;
+
+  // Autotune
+  constexpr const uint16 min_half_cycle_ms = 5000;
+  constexpr const uint32 max_cycle_ms = 20UL * 60UL * 1000UL;
+  constexpr const float max_overshoot = 20.0f;
+
+  // What a PID needs to know about the heater it drives.
+  template <Heater_t Heater>
+  struct heater;
+
+#if ENABLED(PIDTEMP)
+  template <>
+  struct heater<Heater_t::Hotend> final : trait::ce_only
+  {
+    static constexpr const auto tag = "HotendPid"_p;
+    static constexpr const uint8 max_power = PID_MAX;
+    static constexpr const Pid<Heater_t::Hotend>::calibration defaults = { DEFAULT_Kp, DEFAULT_Ki, DEFAULT_Kd };
+
+    static __forceinline __flatten temp_t current() { return Temperature::degHotend(); }
+    static __forceinline __flatten temp_t target() { return Temperature::degTargetHotend(); }
+    static __forceinline __flatten void set_target(arg_type<temp_t> temp) { Temperature::setTargetHotend(temp); }
+  };
+#endif
+
+#if ENABLED(PIDTEMPBED)
+  template <>
+  struct heater<Heater_t::Bed> final : trait::ce_only
+  {
+    static constexpr const auto tag = "BedPid"_p;
+    static constexpr const uint8 max_power = MAX_BED_POWER;
+    static constexpr const Pid<Heater_t::Bed>::calibration defaults = { DEFAULT_bedKp, DEFAULT_bedKi, DEFAULT_bedKd };
+
+    static __forceinline __flatten temp_t current() { return Temperature::degBed(); }
+    static __forceinline __flatten temp_t target() { return Temperature::degTargetBed(); }
+    static __forceinline __flatten void set_target(arg_type<temp_t> temp) { Temperature::setTargetBed(temp); }
+  };
+#endif
+
+  template <Heater_t Heater>
+  struct pid_state final
+  {
+    typename Pid<Heater>::calibration gains = heater<Heater>::defaults;
+
+    float integral = 0.0f;            // C * s
+    float derivative = 0.0f;          // C / s, of the measurement, smoothed
+    float last_temperature = 0.0f;
+    chrono::time_ms16 last_update;
+    uint8 power = 0;
+    bool valid = false;
+
+    // Relay autotune: the heater swings between bias + d and bias - d around the target, and the
+    // amplitude and period of the oscillation give the ultimate gain and period.
+    struct autotune_state final
+    {
+      bool active = false;
+      bool heating = true;
+      uint8 cycles = 0;
+      uint8 cycle = 0;
+      uint8 power = 0;
+      int16 bias = 0;
+      int16 d = 0;
+      temp_t target = 0_C;
+      float max_temperature = 0.0f;
+      float min_temperature = 0.0f;
+      chrono::time_ms32 t1, t2;       // when it last started cooling and heating
+      uint32 t_high = 0, t_low = 0;
+      typename Pid<Heater>::calibration result;
+    } autotune;
+  };
+
+  template <Heater_t Heater>
+  pid_state<Heater> state;
+
+  template <Heater_t Heater>
+  void stop_autotune()
+  {
+    state<Heater>.autotune.active = false;
+    state<Heater>.valid = false;
+  }
+}
+
+template <Heater_t Heater>
+__pure const typename Pid<Heater>::calibration & Pid<Heater>::GetCalibration()
+{
+  return state<Heater>.gains;
+}
+
+template <Heater_t Heater>
+void Pid<Heater>::SetCalibration(arg_type<calibration> value)
+{
+  Log::d(heater<Heater>::tag, "Current Calibration: Kp %.4f Ki %.4f Kd %.4f"_p, value.Kp, value.Ki, value.Kd);
+
+  state<Heater>.gains = value;
+  state<Heater>.valid = false;
+}
+
+template <Heater_t Heater>
+uint8 Pid<Heater>::get_power(arg_type<temp_t> current, arg_type<temp_t> target)
+{
+  auto & __restrict s = state<Heater>;
+  constexpr const uint8 max_power = heater<Heater>::max_power;
+
+  if (__unlikely(s.autotune.active))
+  {
+    return s.autotune.power;
+  }
+
+  const float temperature = float(current);
+  const float error = float(target) - temperature;
+
+  // Far from the target, full on or off. The loop starts afresh once back in range.
+  if (error > functional_range)
+  {
+    s.valid = false;
+    return max_power;
+  }
+  if (error < -functional_range)
+  {
+    s.valid = false;
+    return 0;
+  }
+
+  const chrono::time_ms16 now = chrono::time_ms16::get();
+  uint16 elapsed_ms = (now - s.last_update).raw();
+
+  if (__unlikely(!s.valid || elapsed_ms > max_update_ms))
+  {
+    s.integral = 0.0f;
+    s.derivative = 0.0f;
+    s.last_temperature = temperature;
+    s.last_update = now;
+    s.valid = true;
+    elapsed_ms = update_ms;
+  }
+  else if (elapsed_ms < update_ms)
+  {
+    return s.power;
+  }
+
+  const float dt = elapsed_ms * 0.001f;
+  const auto & __restrict gains = s.gains;
+
+  s.derivative = (derivative_smoothing * s.derivative) + ((1.0f - derivative_smoothing) * (s.last_temperature - temperature) / dt);
+  s.last_temperature = temperature;
+  s.last_update = now;
+
+  // The integral alone may not drive the heater past its limits.
+  s.integral += error * dt;
+  if (gains.Ki > 0.0f)
+  {
+    s.integral = constrain(s.integral, 0.0f, float(max_power) / gains.Ki);
+  }
+
+  const float output = (gains.Kp * error) + (gains.Ki * s.integral) + (gains.Kd * s.derivative);
+  s.power = uint8(constrain(output, 0.0f, float(max_power)) + 0.5f);
+  return s.power;
+}
+
+template <Heater_t Heater>
+bool Pid<Heater>::calibrate(arg_type<temp_t> target, arg_type<uint8> cycles)
+{
+  if (__unlikely(is_calibrating()))
+  {
+    return false;
+  }
+
+  constexpr const uint8 max_power = heater<Heater>::max_power;
+  auto & __restrict a = state<Heater>.autotune;
+
+  Log::d(heater<Heater>::tag, "Starting Calibration: %u cycles"_p, cycles);
+
+  const auto now = chrono::time_ms32::get();
+  a = {};
+  a.active = true;
+  a.cycles = max(cycles, 3_u8);
+  a.bias = a.d = max_power / 2;
+  a.power = max_power / 2 + max_power / 2;
+  a.target = target;
+  a.max_temperature = 0.0f;
+  a.min_temperature = float(printer_max_temperature);
+  a.t1 = a.t2 = now;
+  a.result = state<Heater>.gains;
+
+  heater<Heater>::set_target(target);
+
+  return true;
+}
+
+template <Heater_t Heater>
+void Pid<Heater>::calibration_step()
+{
+  constexpr const auto Tag = heater<Heater>::tag;
+  constexpr const uint8 max_power = heater<Heater>::max_power;
+  auto & __restrict a = state<Heater>.autotune;
+
+  // A new target from anywhere else (M140, disable_all_heaters()) is taken as a cancel.
+  if (__unlikely(heater<Heater>::target() != a.target))
+  {
+    Log::d(Tag, "Calibration Aborted"_p);
+    stop_autotune<Heater>();
+    return;
+  }
+
+  const auto now = chrono::time_ms32::get();
+  const float temperature = float(heater<Heater>::current());
+  const float target = float(a.target);
+
+  a.max_temperature = max(a.max_temperature, temperature);
+  a.min_temperature = min(a.min_temperature, temperature);
+
+  if (a.heating && temperature > target && a.t2.elapsed(now, chrono::time_ms32{ min_half_cycle_ms }))
+  {
+    a.heating = false;
+    a.power = uint8(a.bias - a.d);
+    a.t1 = now;
+    a.t_high = (a.t1 - a.t2).raw();
+    a.max_temperature = target;
+  }
+
+  if (!a.heating && temperature < target && a.t1.elapsed(now, chrono::time_ms32{ min_half_cycle_ms }))
+  {
+    a.heating = true;
+    a.t2 = now;
+    a.t_low = (a.t2 - a.t1).raw();
+
+    if (a.cycle > 0)
+    {
+      // Shift the bias so the heating and cooling halves take equally long.
+      a.bias += int16((int32(a.d) * (int32(a.t_high) - int32(a.t_low))) / int32(a.t_low + a.t_high));
+      a.bias = constrain(a.bias, int16(20), int16(max_power - 20));
+      a.d = (a.bias > max_power / 2) ? int16(max_power - 1 - a.bias) : a.bias;
+
+      Log::d<1>(Tag, "bias: %d d: %d min: %.2f max: %.2f"_p, a.bias, a.d, a.min_temperature, a.max_temperature);
+
+      if (a.cycle > 2 && a.max_temperature > a.min_temperature)
+      {
+        const float Ku = (4.0f * a.d) / (float(M_PI) * (a.max_temperature - a.min_temperature) * 0.5f);
+        const float Tu = float(a.t_low + a.t_high) * 0.001f;
+        a.result.Kp = 0.6f * Ku;
+        a.result.Ki = 2.0f * a.result.Kp / Tu;
+        a.result.Kd = a.result.Kp * Tu * 0.125f;
+
+        Log::d<1>(Tag, "Ku: %.4f Tu: %.4f Kp: %.4f Ki: %.4f Kd: %.4f"_p, Ku, Tu, a.result.Kp, a.result.Ki, a.result.Kd);
+      }
+    }
+
+    a.power = uint8(a.bias + a.d);
+    ++a.cycle;
+    a.min_temperature = target;
+  }
+
+  if (__unlikely(temperature > target + max_overshoot))
+  {
+    Log::d(Tag, "Calibration Failed: overshoot"_p);
+    stop_autotune<Heater>();
+    heater<Heater>::set_target(0_C);
+    return;
+  }
+
+  if (__unlikely((now - ((a.t1 > a.t2) ? a.t1 : a.t2)).raw() > max_cycle_ms))
+  {
+    Log::d(Tag, "Calibration Failed: timeout"_p);
+    stop_autotune<Heater>();
+    heater<Heater>::set_target(0_C);
+    return;
+  }
+
+  if (a.cycle > a.cycles)
+  {
+    stop_autotune<Heater>();
+    heater<Heater>::set_target(0_C);
+
+    SetCalibration(a.result);
+
+    lcd::show_page(lcd::Page::PID_Finished);
+
+    settings.save();
+  }
+}
+
+template <Heater_t Heater>
+__pure bool Pid<Heater>::is_calibrating()
+{
+  return state<Heater>.autotune.active;
+}
+
+template <Heater_t Heater>
+__pure uint8 Pid<Heater>::calibration_progress()
+{
+  const auto & __restrict a = state<Heater>.autotune;
+  return uint8((uint16(a.cycle) * 100_u16) / (a.cycles + 1));
+}
+
+template <Heater_t Heater>
+void Pid<Heater>::debug_dump()
+{
+}
+
+#if ENABLED(PIDTEMPBED)
+  template struct Tuna::Thermal::Manager::Pid<Tuna::Temperature::Manager::Bed>;
+#endif
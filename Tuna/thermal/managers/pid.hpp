@@ -0,0 +1,31 @@
+#pragma once
+
+#include "thermal/thermal.hpp"
+
+namespace Tuna::Thermal::Manager
+{
+  // A PID loop for either heater, tuned by relay autotune. Outside PID_FUNCTIONAL_RANGE of the
+  // target the heater is simply full on or off. The gains are in per-second units, as Marlin's are.
+  template <Temperature::Manager Heater>
+  struct Pid final : trait::ce_only
+  {
+    struct calibration final
+    {
+      float Kp;
+      float Ki;   // per second
+      float Kd;   // seconds
+    };
+
+    // Starts a relay autotune at 'target' over 'cycles' oscillations, which manage_heater() then
+    // steps through with calibration_step().
+    static bool calibrate(arg_type<temp_t> target, arg_type<uint8> cycles = 5);
+    static void calibration_step();
+    static __pure bool is_calibrating();
+    static __pure uint8 calibration_progress(); // percent
+    static uint8 get_power(arg_type<temp_t> current, arg_type<temp_t> target);
+    static __pure void debug_dump();
+
+    static __pure const calibration & GetCalibration();
+    static void SetCalibration(arg_type<calibration> val);
+  };
+}
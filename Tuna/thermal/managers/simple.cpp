@@ -1,6 +1,8 @@
 #include <tuna.h>
 
 #include "simple.hpp"
+#include "fan.hpp"
+#include "log.hpp"
 
 #include "bi3_plus_lcd.h"
 
@@ -13,25 +15,6 @@
 
 using namespace Tuna::Thermal::Manager;
 
-// TODO Establish a global logging system like this.
-namespace Tuna::Log
-{
-  template <uint8 tabs = 0, typename ...Args>
-  inline void d(arg_type<flash_string> tag, arg_type<flash_string> format, Args... args)
-  {
-    critical_section log_critsec;
-    Serial.print(tag.fsh());
-    Serial.print(": "_p.fsh());
-    for (uint8 i = 0; i < tabs; ++i)
-    {
-      Serial.print("  "_p.fsh());
-    }
-    char buffer[128];
-    sprintf_P(buffer, format.c_str(), args...);
-    Serial.println(buffer);
-  }
-}
-
 namespace
 {
   using namespace Tuna;
@@ -99,13 +82,15 @@ void Simple::SetCalibration(arg_type<calibration> value)
 
   pwm_calibration = value;
 
-  const exponent_t inv_numTableEntries = 1.0_exponent / exponent_t(numTableEntries);
+  // fraction^exponent in fixed point; the exponent is converted once rather than going through pow() per entry.
+  constexpr const uint8 fraction_shift = fixed_math::fraction_bits - constant::log2<numTableEntries>;
+  const int32 exponent = fixed_math::from_float(value.Exponent_);
   for (tableidx_t i = 0; i < numTableEntries; ++i)
   {
-    const exponent_t fraction = exponent_t(i) * inv_numTableEntries;
-    __assume(fraction >= 0.0_exponent && fraction <= 1.0_exponent);
-    const float exponentiated = pow(fraction, value.Exponent_) * 255.5_exponent;
-    __assume(exponentiated >= 0.0_exponent && exponentiated <= 255.5f);
+    const uint32 fraction = uint32(i) << fraction_shift;
+    // * 255.5, saturating for negative exponents.
+    const uint32 exponentiated = (min(fixed_math::pow(fraction, exponent), fixed_math::one) * 511_u32) >> (fixed_math::fraction_bits + 1);
+    __assume(exponentiated <= 255);
     pwm_table[i] = uint8(exponentiated);
     //Log::d<1>(Tag, "%u"_p, pwm_table[i]);
   }
@@ -113,199 +98,176 @@ void Simple::SetCalibration(arg_type<calibration> value)
 
 namespace
 {
-  // This will return multiplier_t if it's given an exponent_t, and an exponent_t if given a multiplier_t
-  template <typename T>
-  struct _alternate_type;
-
-  template <>
-  struct _alternate_type<scalar_t> final : trait::ce_only
+  constexpr const exponent_t test_exponents[] =
   {
-    using type = exponent_t;
+    0.0_exponent,
+    0.1_exponent,
+    0.2_exponent,
+    0.3_exponent,
+    0.4_exponent,
+    0.5_exponent,
+    0.6_exponent,
+    0.7_exponent,
+    0.8_exponent,
+    0.9_exponent,
+    //1.0_exponent,
+    //1.1_exponent,
+    //1.2_exponent,
+    //1.3_exponent,
+    //1.4_exponent,
+    //1.5_exponent,
+    //1.6_exponent,
+    //1.7_exponent,
+    //1.8_exponent,
+    //1.9_exponent,
+    //2.0_exponent,
   };
 
-  template <>
-  struct _alternate_type<exponent_t> final : trait::ce_only
+  constexpr const scalar_t test_scalars[] =
   {
-    using type = scalar_t;
+    1_scalar,
+    2_scalar,
+    3_scalar,
+    4_scalar,
+    5_scalar
   };
 
-  template <typename T>
-  using alternate_type = typename _alternate_type<T>::type;
-
+  // Level 0 tests the base exponents, the following levels refine the best one, and the last
+  // level (exponent_levels) tests scalars with the final exponent.
+  constexpr const uint8 exponent_levels = 3;
+  constexpr const uint8 refine_count = 5;
+  constexpr const scalar_t exponent_test_scalar = 1_scalar;
+  constexpr const uint8 total_tests = array_size(test_exponents) + ((exponent_levels - 1) * refine_count) + array_size(test_scalars);
 
-  template <typename T, uint8 TN>
-  uint8 execute_test(arg_type<temp_t> target, const T (& __restrict test_array) [TN], arg_type<alternate_type<T>> test_alternate)
+  struct oscillation final
   {
-    using namespace Tuna::Thermal::Manager;
-
-    // If T is exponent_t, we are still processing exponents,
-    // otherwise we are now trying to find a multiplier.
-    constexpr const bool is_exponent_test = is_same<T, exponent_t>;
-    
-    using tempavg_t = type_trait<temp_t::type>::larger_type;
-    constexpr const uint16 TempAvgSampleCount = 256;
-
-    struct oscillation final
-    {
-      bool valid = false;
-
-      temp_t high = { 0 }; // how far it oscillates above target
-      temp_t low = { 0 }; // how far it oscillates below target
-    };
+    bool valid = false;
 
-    const auto average_append = [](auto & __restrict sum, const auto & __restrict new_val, const auto & __restrict N)
-    {
-      using sum_t = decltype(sum);
-      tempavg_t mean = sum / N;
-      sum -= mean;
-      sum += new_val;
-    };
+    temp_t high = { 0 }; // how far it oscillates above target
+    temp_t low = { 0 }; // how far it oscillates below target
+  };
 
-    const auto extract_average = [](const auto & __restrict sum, const auto & __restrict N) -> auto
-    {
-      return sum / N;
-    };
+  // The calibration is a state machine that manage_heater() steps once per temperature update,
+  // so the printer keeps running while it goes on.
+  enum class Phase : uint8
+  {
+    Idle = 0,
+    ReachLow,   // Getting back to the low target at full power, from either side.
+    Test        // Running the candidate table at the target for test_max_time.
+  };
 
-    const auto init_average = [](auto & __restrict sum, const auto & __restrict cur, const auto & __restrict N)
+  struct calibration_state final
+  {
+    Phase phase = Phase::Idle;
+    uint8 level = 0;
+    uint8 index = 0;            // test within the level
+    uint8 completed = 0;        // tests done over all levels
+    uint8 best_index = 0;
+    uint32 best_error = type_trait<uint32>::max;
+
+    temp_t target = 0_C;
+    temp_t low_target = 0_C;
+    temp_t expected_target = 0_C; // what we last set; anything else means someone took over the hotend
+
+    exponent_t exponent = 0.0_exponent;
+    exponent_t epsilon = 0.05_exponent;
+    exponent_t exponents[refine_count] = {};
+
+    oscillation error;
+    chrono::time_ms24 start_time;
+    Simple::calibration previous;
+  } cal;
+
+  uint8 level_size()
+  {
+    if (cal.level == 0)
     {
-      sum = cur;
-      sum *= N;
-    };
+      return array_size(test_exponents);
+    }
+    return (cal.level < exponent_levels) ? refine_count : array_size(test_scalars);
+  }
 
-    const auto set_temp_target = [&](arg_type<temp_t> temp, bool await)
+  exponent_t test_exponent(arg_type<uint8> i)
+  {
+    if (cal.level == 0)
     {
-      Temperature::setTargetHotend(temp);
+      return test_exponents[i];
+    }
+    return (cal.level < exponent_levels) ? cal.exponents[i] : cal.exponent;
+  }
 
-      if (!await)
-      {
-        return;
-      }
+  scalar_t test_scalar(arg_type<uint8> i)
+  {
+    return (cal.level < exponent_levels) ? exponent_test_scalar : test_scalars[i];
+  }
 
-      for (;;)
-      {
-        if (__unlikely(Temperature::manage_heater()))
-        {
-          const temp_t current_temperature = Temperature::degHotend();
+  void populate_pwm_table_const(uint8 value)
+  {
+    pwm_calibration.Exponent_ = -1.0f;
 
-          //average_append(tempAvg, current_temperature.raw(), TempAvgSampleCount);
+    for (tableidx_t i = 0; i < numTableEntries; ++i)
+    {
+      pwm_table[i] = value;
+    }
+  }
 
-          const Temperature::Trend temp_trend = Temperature::get_temperature_trend();
-          //Log::d(TagGraph, "%.6f, %.6f, %S%.6f"_p, float(current_temperature), float(temp_t::from(extract_average(tempAvg, TempAvgSampleCount))), temp_trend.second ? "+"_p : "-"_p, float(temp_trend.first));
+  void set_target(arg_type<temp_t> temp)
+  {
+    Temperature::setTargetHotend(temp);
+    cal.expected_target = temp;
+  }
 
-          lcd::update_graph();
+  void begin_test()
+  {
+    Log::d(Tag, "Executing Test: %u / %u *****************"_p, cal.completed + 1, total_tests);
+    Log::d<1>(Tag, "Exponent: %.6f"_p, float(test_exponent(cal.index)));
+
+    // Reset the PWM table to 0xFF for low-target setting.
+    populate_pwm_table_const(0xFF);
+    // Reset the target temperature to the lower target.
+    Log::d(Tag, "Reaching Low Target"_p);
+    set_target(cal.low_target);
+    cal.phase = Phase::ReachLow;
+  }
 
-          // We only care when we are above the temp target during an upswing. This guarantees we aren't polluting the test due to going 'down' first.
-          if (__unlikely(temp_trend == Temperature::Trend::Up && current_temperature >= Temperature::degTargetHotend()))
-          {
-            return;
-          }
-        }
-      }
-    };
+  void begin_level()
+  {
+    cal.index = 0;
+    cal.best_index = 0;
+    cal.best_error = type_trait<uint32>::max;
 
-    const auto populate_pwm_table_const = [](uint8 value)
+    if (cal.level != 0 && cal.level < exponent_levels)
     {
-      pwm_calibration.Exponent_ = -1.0f;
-
-      for (tableidx_t i = 0; i < numTableEntries; ++i)
+      for (uint8 i = 0; i < refine_count; ++i)
       {
-        pwm_table[i] = value;
+        cal.exponents[i] = cal.exponent + (cal.epsilon * (int8(i) - int8(refine_count / 2)));
       }
-    };
-
-    Temperature::disable_all_heaters();
-
-    // First, we set the target temperature to a value minus double the expected swing.
-    constexpr const temp_t double_swing = temp_t{ integer_swing * 2 };
-    const temp_t low_target = target - double_swing;
-
-    Log::d(Tag, "Calibration Parameters:"_p);
-    Log::d<1>(Tag, "test_max_time: %u"_p, test_max_time.raw());
-    Log::d<1>(Tag, "TempAvgSampleCount: %u"_p, TempAvgSampleCount);
-    Log::d<1>(Tag, "integer_swing: %u"_p, integer_swing);
-    Log::d<1>(Tag, "low_target: %.6f"_p, float(low_target));
-    Log::d<1>(Tag, "table entries: %u"_p, numTableEntries);
-    Log::d<1>(Tag, "pwm integer bits: %u"_p, integer_swing_bits);
-    Log::d<1>(Tag, "pwm fracion bits: %u"_p, relevant_fraction_bits);
-    Log::d<1>(Tag, "temp_t integer bits: %u"_p, temp_t::integer_bits);
-    Log::d<1>(Tag, "temp_t fraction bits: %u"_p, temp_t::fractional_bits);
-
-    const auto execute_test = [&, target](arg_type<exponent_t> exponent, oscillation & __restrict error, scalar_t scalar)
-    {
-      Log::d<1>(Tag, "Exponent: %.6f"_p, exponent);
+      cal.epsilon *= 0.5_exponent;
+    }
 
-      // Reset the PWM table to 0xFF for low-target setting.
-      populate_pwm_table_const(0xFF);
-      // Reset the target temperature to the lower target.
-      Log::d(Tag, "Reaching Low Target"_p);
-      set_temp_target(low_target, true);
-      Log::d(Tag, "Low Target Reached, beginning test"_p);
+    begin_test();
+  }
 
-      // Populate the PWM table.
-      Simple::SetCalibration({ exponent, scalar });
+  void finish(arg_type<scalar_t> scalar)
+  {
+    cal.phase = Phase::Idle;
 
-      // Set target temperature.
-      set_temp_target(target, false);
+    // Only the hotend is ours; the bed may be heating alongside.
+    Temperature::setTargetHotend(0_C);
 
-      const auto start_time = chrono::time_ms<uint24>::get();
+    Log::d<1>(Tag, "Best Exponent: %.6f  Scalar: %u"_p, float(cal.exponent), scalar);
 
-      // Once we pass the target temperature (defines as going from below to above the target temperature)
-      // we begin our analysis.
-      for (;;)
-      {
-        // manage_heater handles managing PWM values, reading temperature values
-        // and implements safeties.
-        // It returns true when new temperature data is available.
-        if (__unlikely(Temperature::manage_heater()))
-        {
-          // TODO FIXME use a running average (even though temperature is already an average)
-          // otherwise this will be quite noisy.
-
-          const temp_t current_temperature = Temperature::degHotend();
-          //average_append(tempAvg, current_temperature.raw(), TempAvgSampleCount);
-
-          //const Temperature::Trend temp_trend = Temperature::get_temperature_trend();
-          //Log::d(TagGraph, "%.6f, %.6f, %S%.6f"_p, float(current_temperature), float(temp_t::from(extract_average(tempAvg, TempAvgSampleCount))), temp_trend.second ? "+"_p : "-"_p, float(temp_trend.first));
-
-          lcd::update_graph();
-
-          if (current_temperature >= target)
-          {
-            error.valid = true;
-
-            if (current_temperature > target)
-            {
-              const temp_t differential = current_temperature - target;
-              error.high = max(error.high, differential);
-            }
-          }
-          else if (current_temperature < target)
-          {
-            const temp_t differential = target - current_temperature;
-            // We only track 'low' if we actually every break our temperature goal.
-            if (error.valid)
-            {
-              error.low = max(error.low, differential);
-            }
-          }
-        }
-
-        // Regardless, we also check the current time, to see if we've timed out.
-        if (__unlikely(start_time.elapsed(test_max_time)))
-        {
-          break;
-        }
-      }
-    };
+    Simple::SetCalibration({ cal.exponent, scalar });
 
-    constexpr const uint8 num_tests = TN;
+    lcd::show_page(lcd::Page::PID_Finished);
+    enqueue_and_echo_command("M107");
 
-    //temp_t best_high = temp_t{ printer_max_temperature };
-    //uint8 best_high_idx = 0;
-    //temp_t best_low = temp_t{ printer_max_temperature };
-    //uint8 best_low_idx = 0;
+    settings.save();
+  }
 
-    const auto errorCalculate = [&](arg_type<oscillation> error)->uint32
+  void finish_test()
+  {
+    const auto errorCalculate = [](arg_type<oscillation> error)->uint32
     {
       const auto highMean = error.high;
       const auto lowMean = error.low;
@@ -313,156 +275,153 @@ namespace
       return (uint32(highMean.raw()) * 5) + (uint32(lowMean.raw()) * 2);
     };
 
-    uint32 bestError = type_trait<uint32>::max;
-    uint8 bestIndex = 0;
+    ++cal.completed;
 
-    constexpr const auto total_tests = num_tests;
+    Log::d(Tag, "Test Complete: %u / %u"_p, cal.completed, total_tests);
+    Log::d<1>(Tag, "valid: %u"_p, cal.error.valid ? 1 : 0);
 
-    for (uint8 i = 0; i < num_tests; ++i)
+    if (__likely(cal.error.valid))
     {
-      const exponent_t & __restrict exponent = is_exponent_test ? test_array[i] : test_alternate;
-      const scalar_t scalar = is_exponent_test ? test_alternate : test_array[i];
-      oscillation error;
+      Log::d<1>(Tag, "high: %.6f"_p, float(cal.error.high));
+      Log::d<1>(Tag, "low: %.6f"_p, float(cal.error.low));
 
-      Log::d(Tag, "Executing Test: %u / %u *****************"_p, i + 1, total_tests);
-      execute_test(exponent, error, scalar);
-
-      Log::d(Tag, "Test Complete: %u / %u"_p, i + 1, total_tests);
-      Log::d<1>(Tag, "valid: %u"_p, error.valid ? 1 : 0);
-
-      if (__likely(error.valid))
+      const uint32 errorVal = errorCalculate(cal.error);
+      Log::d<1>(Tag, "error: %lu"_p, uint32(errorVal));
+      if (errorVal < cal.best_error)
       {
-        Log::d<1>(Tag, "high: %.6f"_p, float(error.high));
-        Log::d<1>(Tag, "low: %.6f"_p, float(error.low));
-
-        if constexpr (true)
-        {
-          const uint32 errorVal = errorCalculate(error);
-          Log::d<1>(Tag, "error: %lu"_p, uint32(errorVal));
-          if (errorVal < bestError)
-          {
-            Log::d<1>(Tag, "New Best &&&&&&&&&&&&&&"_p);
-            bestError = errorVal;
-            bestIndex = i;
-          }
-        }
-        else
-        {
-          const tempavg_t errorVal = tempavg_t(error.high.raw()) + tempavg_t(error.low.raw());
-          Log::d<1>(Tag, "error: %lu"_p, uint32(errorVal));
-          Log::d<1>(Tag, "New Best &&&&&&&&&&&&&&"_p);
-          if (errorVal < bestError)
-          {
-            bestError = errorVal;
-            bestIndex = i;
-          }
-        }
+        Log::d<1>(Tag, "New Best &&&&&&&&&&&&&&"_p);
+        cal.best_error = errorVal;
+        cal.best_index = cal.index;
       }
     }
 
-    // For now, choose the best high.
-    Log::d(Tag, "Local Best Index: %u"_p, bestIndex);
-
+    if (++cal.index < level_size())
     {
-      const exponent_t & __restrict exponent = is_exponent_test ? test_array[bestIndex] : test_alternate;
-      const scalar_t scalar = is_exponent_test ? test_alternate : test_array[bestIndex];
+      begin_test();
+      return;
+    }
 
-      Log::d<1>(Tag, "Exponent: %.6f  Scalar: %u"_p, float(exponent), scalar);
+    // For now, choose the best high.
+    Log::d(Tag, "Local Best Index: %u"_p, cal.best_index);
+    Log::d<1>(Tag, "Exponent: %.6f  Scalar: %u"_p, float(test_exponent(cal.best_index)), test_scalar(cal.best_index));
 
-      return bestIndex;
+    if (cal.level < exponent_levels)
+    {
+      cal.exponent = test_exponent(cal.best_index);
+      ++cal.level;
+      begin_level();
+      return;
     }
+
+    finish(test_scalars[cal.best_index]);
   }
 }
 
 bool Simple::calibrate(arg_type<temp_t> target)
 {
+  if (__unlikely(is_calibrating()))
+  {
+    return false;
+  }
+
   Log::d(Tag, "Starting Calibration"_p);
 
-  constexpr const exponent_t test_exponents[] =
-  {
-    0.0_exponent,
-    0.1_exponent,
-    0.2_exponent,
-    0.3_exponent,
-    0.4_exponent,
-    0.5_exponent,
-    0.6_exponent,
-    0.7_exponent,
-    0.8_exponent,
-    0.9_exponent,
-    //1.0_exponent,
-    //1.1_exponent,
-    //1.2_exponent,
-    //1.3_exponent,
-    //1.4_exponent,
-    //1.5_exponent,
-    //1.6_exponent,
-    //1.7_exponent,
-    //1.8_exponent,
-    //1.9_exponent,
-    //2.0_exponent,
-  };
+  // First, we set the target temperature to a value minus double the expected swing.
+  constexpr const temp_t double_swing = temp_t{ integer_swing * 2 };
 
-  constexpr const scalar_t test_scalars[] =
-  {
-    1_scalar,
-    2_scalar,
-    3_scalar,
-    4_scalar,
-    5_scalar
-  };
+  cal = {};
+  cal.previous = pwm_calibration;
+  cal.target = target;
+  cal.low_target = target - double_swing;
 
-  constexpr const uint8 exponent_levels = 3;
+  Log::d(Tag, "Calibration Parameters:"_p);
+  Log::d<1>(Tag, "test_max_time: %u"_p, test_max_time.raw());
+  Log::d<1>(Tag, "integer_swing: %u"_p, integer_swing);
+  Log::d<1>(Tag, "low_target: %.6f"_p, float(cal.low_target));
+  Log::d<1>(Tag, "table entries: %u"_p, numTableEntries);
+  Log::d<1>(Tag, "pwm integer bits: %u"_p, integer_swing_bits);
+  Log::d<1>(Tag, "pwm fracion bits: %u"_p, relevant_fraction_bits);
+  Log::d<1>(Tag, "temp_t integer bits: %u"_p, temp_t::integer_bits);
+  Log::d<1>(Tag, "temp_t fraction bits: %u"_p, temp_t::fractional_bits);
 
-  exponent_t exponent;
-  exponent_t epsilon = 0.05_exponent;
+  begin_level();
 
-  for (uint8 cur_level = 0; cur_level < exponent_levels; ++cur_level)
+  return true;
+}
+
+void Simple::calibration_step()
+{
+  // A new target from anywhere else (M104, disable_all_heaters()) is taken as a cancel.
+  if (__unlikely(Temperature::degTargetHotend() != cal.expected_target))
   {
-    constexpr const scalar_t test_scalar = 1_scalar;
+    Log::d(Tag, "Calibration Aborted"_p);
+    cal.phase = Phase::Idle;
+    SetCalibration(cal.previous);
+    return;
+  }
+
+  const temp_t current_temperature = Temperature::degHotend();
 
-    if (cur_level == 0)
+  switch (cal.phase)
+  {
+  case Phase::ReachLow:
+    // We only care when we are above the temp target during an upswing. This guarantees we aren't polluting the test due to going 'down' first.
+    if (__unlikely(Temperature::get_temperature_trend() == Temperature::Trend::Up && current_temperature >= cal.low_target))
     {
-      // test only the base exponents.
-      const uint8 best_idx = execute_test(target, test_exponents, test_scalar);
-      exponent = test_exponents[best_idx];
+      Log::d(Tag, "Low Target Reached, beginning test"_p);
+
+      // Populate the PWM table.
+      SetCalibration({ test_exponent(cal.index), test_scalar(cal.index) });
+
+      // Set target temperature.
+      set_target(cal.target);
+
+      cal.error = {};
+      cal.start_time = chrono::time_ms24::get();
+      cal.phase = Phase::Test;
+    }
+    break;
+  case Phase::Test:
+    // Once we pass the target temperature (defines as going from below to above the target temperature)
+    // we begin our analysis.
+    if (current_temperature >= cal.target)
+    {
+      cal.error.valid = true;
+
+      if (current_temperature > cal.target)
+      {
+        const temp_t differential = current_temperature - cal.target;
+        cal.error.high = max(cal.error.high, differential);
+      }
     }
     else
     {
-      const exponent_t exponents[] =
+      const temp_t differential = cal.target - current_temperature;
+      // We only track 'low' if we actually every break our temperature goal.
+      if (cal.error.valid)
       {
-        exponent - (epsilon * 2),
-        exponent - (epsilon * 1),
-        exponent,
-        exponent + (epsilon * 1),
-        exponent + (epsilon * 2),
-      };
-
-      epsilon *= 0.5_exponent;
+        cal.error.low = max(cal.error.low, differential);
+      }
+    }
 
-      const uint8 best_idx = execute_test(target, exponents, test_scalar);
-      exponent = exponents[best_idx];
+    if (__unlikely(cal.start_time.elapsed(test_max_time)))
+    {
+      finish_test();
     }
+    break;
+  default:
+    break;
   }
+}
 
-  // Now test scalars.
-
-  const uint8 best_scalar_idx = execute_test(target, test_scalars, exponent);
-  const scalar_t scalar = test_scalars[best_scalar_idx];
-
-  Temperature::disable_all_heaters();
-
-  Log::d<1>(Tag, "Best Exponent: %.6f  Scalar: %u"_p, float(exponent), scalar);
-
-  SetCalibration({ exponent, scalar });
-
-  lcd::show_page(lcd::Page::PID_Finished);
-  enqueue_and_echo_command("M107");
-  lcd::update();
-
-  settings.save();
+__pure bool Simple::is_calibrating()
+{
+  return cal.phase != Phase::Idle;
+}
 
-  return true;
+__pure uint8 Simple::calibration_progress()
+{
+  return uint8((uint16(cal.completed) * 100_u16) / total_tests);
 }
 
 uint8 __forceinline __flatten Simple::get_power(arg_type<temp_t> current, arg_type<temp_t> target)
@@ -508,9 +467,15 @@ uint8 __forceinline __flatten Simple::get_power(arg_type<temp_t> current, arg_ty
     }
   }
 
+  // Whenever the heater is on, it also covers what the part fan takes at its current speed.
+  if (out_temp != none)
+  {
+    out_temp = uint8(min(uint16(out_temp) + Tuna::Thermal::FanCompensation::power(), uint16(full)));
+  }
+
   if constexpr (tempLog)
   {
-    Log::d(Tag, "%u :: %.6f, %u, trend: %s"_p, 0, float(current), out_temp, (Temperature::get_temperature_trend() == Temperature::Trend::Up) ? "up" : "down");
+    Log::d(Tag, "%u :: %.6f, %u, trend: %S"_p, 0, float(current), out_temp, ((Temperature::get_temperature_trend() == Temperature::Trend::Up) ? flash_string("up"_p) : flash_string("down"_p)).c_str());
   }
 
   return out_temp;
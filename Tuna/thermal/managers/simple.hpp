@@ -16,7 +16,11 @@ namespace Tuna::Thermal::Manager
       scalar_t Scalar_ = 3_u8;
     };
 
+    // Starts a calibration at 'target', which manage_heater() then steps through with calibration_step().
     static bool calibrate(arg_type<temp_t> target);
+    static void calibration_step();
+    static __pure bool is_calibrating();
+    static __pure uint8 calibration_progress(); // percent
     static uint8 __forceinline __flatten get_power(arg_type<temp_t> current, arg_type<temp_t> target);
     static __pure void debug_dump();
 
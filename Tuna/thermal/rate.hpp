@@ -0,0 +1,72 @@
+#pragma once
+
+namespace Tuna::Thermal
+{
+  // Low-pass filtered dT/dt of one sensor. The temperature goes through a running average kept
+  // with 'extra_bits' more fractional bits than temp_t, the change of that average is scaled by
+  // the time since the last update, and the result goes through a second running average.
+  // The smoothed temperature moves by fractions of a temp_t step, so the rate doesn't jump
+  // between 0 and whole steps per update as a plain difference would.
+  class rate_filter final
+  {
+    static constexpr const uint8 extra_bits = 8;
+    static constexpr const uint8 temperature_shift = 3;   // of 8 updates
+    static constexpr const uint8 rate_shift = 2;          // of 4 updates
+
+    int32 m_Temperature = 0;    // temp_t raw << extra_bits
+    int32 m_RateSum = 0;        // (temp_t raw << extra_bits) per second, << rate_shift
+    uint16 m_LastMs = 0;
+    bool m_Valid = false;
+
+  public:
+    void update(arg_type<temp_t> temperature, arg_type<uint16> now_ms) __restrict
+    {
+      const int32 sample = int32(temperature.raw()) << extra_bits;
+
+      if (__unlikely(!m_Valid))
+      {
+        m_Temperature = sample;
+        m_RateSum = 0;
+        m_LastMs = now_ms;
+        m_Valid = true;
+        return;
+      }
+
+      const uint16 elapsed_ms = now_ms - m_LastMs;
+      if (__unlikely(elapsed_ms == 0))
+      {
+        return;
+      }
+      m_LastMs = now_ms;
+
+      const int32 change = (sample - m_Temperature) >> temperature_shift;
+      m_Temperature += change;
+
+      // |change| is at most (300 << 12) / 8, so 'change * 1000' stays well within int32.
+      m_RateSum -= m_RateSum >> rate_shift;
+      m_RateSum += (change * 1000) / elapsed_ms;
+    }
+
+    void reset() __restrict
+    {
+      m_Valid = false;
+    }
+
+    inline bool __forceinline __flatten is_falling() const __restrict
+    {
+      return m_RateSum < 0;
+    }
+
+    // temp_t raw units (1/16 C) per second.
+    inline int16 __forceinline __flatten raw() const __restrict
+    {
+      return int16(m_RateSum >> (rate_shift + extra_bits));
+    }
+
+    // Celsius per second.
+    inline float __forceinline __flatten celsius() const __restrict
+    {
+      return float(m_RateSum) * (1.0f / float(1_u32 << (rate_shift + extra_bits + temp_t::fractional_bits)));
+    }
+  };
+}
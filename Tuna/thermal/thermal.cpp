@@ -30,6 +30,8 @@
 #include "planner.h"
 #include "configuration_store.h"
 #include "watchdog.h"
+#include "interrupts.hpp"
+#include "fan_pwm.hpp"
 
 #define ENABLE_ERROR_1A 0
 #define ENABLE_ERROR_1B 0
@@ -39,9 +41,12 @@
 #define ENABLE_ERROR_4 1
 #define ENABLE_ERROR_5 1
 
-#include "managers/simple.hpp"
+#include "managers/managers.hpp"
 
-using HeaterManager = Tuna::Thermal::Manager::Simple;
+using HeaterManager = Tuna::Thermal::HeaterManager;
+#if ENABLED(PIDTEMPBED)
+using BedManager = Tuna::Thermal::BedManager;
+#endif
 
 temp_t Temperature::min_extrude_temp = (typename temp_t::type)EXTRUDE_MINTEMP;
 
@@ -58,7 +63,6 @@ millis_t Temperature::watch_bed_next_ms = 0;
 
 bool Temperature::allow_cold_extrude = false;
 
-millis_t Temperature::next_bed_check_ms;
 
 memory<uint8_t> Temperature::soft_pwm_amount = 0;
 volatile_conditional_type<uint8, has_bed_thermal_management> Temperature::soft_pwm_amount_bed = 0_u8;
@@ -68,37 +72,62 @@ namespace
 {
   struct interrupt final : trait::ce_only
   {
+    // What the handler's check of a reading against the limits found
+    enum limit : uint8
+    {
+      hotend_over = 1 << 0,
+      hotend_under = 1 << 1,
+      bed_over = 1 << 2,
+      bed_under = 1 << 3,
+      hotend_out = hotend_over | hotend_under,
+      bed_out = bed_over | bed_under,
+    };
+
+    struct adc_reading final
+    {
+      uint16 hotend;
+      uint16 bed;
+      uint8 limits;
+    };
+
     static memory<bool> ready_;
-    static memory<uint16> raw_adc_hotend;
-    static memory<uint16> raw_adc_bed;
+    // Only the temperature ISR (and the ADC ISR, when free running) writes it
+    static atomic_snapshot<adc_reading> raw_adc;
+    // The heaters over MAXTEMP in the latest reading, which the PWM keeps off
+    static memory<uint8> over_max_;
 
+    // Each reading is checked against MAXTEMP and MINTEMP here, as it's taken, in the ADC's own
+    // terms. A heater over MAXTEMP is cut straight away; manage_heater() raises the errors.
     static inline void __forceinline __flatten set_adc (arg_type<uint16> hotend, arg_type<uint16> bed)
     {
-      raw_adc_hotend.write_through(hotend);
-      raw_adc_bed.write_through(bed);
-      ready_.write_through(true);
-    }
-
-    static inline void __forceinline __flatten set_adc_hotend (arg_type<uint16> adc)
-    {
-      raw_adc_hotend.write_through(adc);
-      ready_.write_through(true);
-    }
+      const uint8 limits =
+        (Temperature::Hotend::adc::over_max(hotend) ? hotend_over : 0_u8) |
+        (Temperature::Hotend::adc::under_min(hotend) ? hotend_under : 0_u8) |
+        (Temperature::Bed::adc::over_max(bed) ? bed_over : 0_u8) |
+        (Temperature::Bed::adc::under_min(bed) ? bed_under : 0_u8);
+
+      over_max_.write_through(limits & (hotend_over | bed_over));
+#if ENABLED(HOTEND_HARDWARE_PWM)
+      if (__unlikely(limits & hotend_over))
+      {
+        // Timer 0 drives this heater, not the PWM below
+        CBI(TCCR0A, COM0B1);
+        WRITE_HEATER_0(LOW);
+      }
+#endif
 
-    static inline void __forceinline __flatten set_adc_bed (arg_type<uint16> adc)
-    {
-      raw_adc_bed.write_through(adc);
+      raw_adc.write({ hotend, bed, limits });
       ready_.write_through(true);
     }
 
-    static inline uint16 __forceinline __flatten __pure get_adc_hotend()
+    static inline uint8 __forceinline __flatten over_max()
     {
-      return raw_adc_hotend.read_through();
+      return over_max_.read_through();
     }
 
-    static inline uint16 __forceinline __flatten __pure get_adc_bed()
+    static inline adc_reading __forceinline __flatten get_adc()
     {
-      return raw_adc_bed.read_through();
+      return raw_adc.read();
     }
 
     static inline bool __forceinline __flatten __pure is_ready()
@@ -113,68 +142,61 @@ namespace
   };
 
   memory<bool> interrupt::ready_ = false;
-  memory<uint16> interrupt::raw_adc_hotend = 0_u16;
-  memory<uint16> interrupt::raw_adc_bed = 0_u16;
-}
-
-namespace
-{
-  class temp_trend final
-  {
-    static constexpr const auto MeanCount = make_uintsz<8>;
-    static constexpr const auto PrinterMaxTempT = temp_t{ printer_max_temperature }.raw();
-    using sum_t = uintsz<PrinterMaxTempT * MeanCount>;
-    using tempt_t = typename temp_t::type;
-
-    // positive hack because presently fixed-type doesn't support signed.
-    bool m_Positive = true;
-    sum_t m_MeanSum = 0;
-  public:
-
-    inline bool __forceinline __flatten is_positive () const __restrict
-    {
-      return m_Positive;
-    }
-
-    inline temp_t __forceinline __flatten getMean() const __restrict
-    {
-      return temp_t::from(m_MeanSum / MeanCount);
-    }
+  atomic_snapshot<interrupt::adc_reading> interrupt::raw_adc;
+  memory<uint8> interrupt::over_max_ = 0;
 
-    inline void __forceinline __flatten appendValue(arg_type<temp_t> value, bool positive) __restrict
-    {
-      const auto raw_value = value.raw();
-      m_MeanSum -= tempt_t(m_MeanSum / MeanCount);
-      if (positive == m_Positive)
-      {
-        m_MeanSum += raw_value;
-      }
-      else
-      {
-        if (raw_value > m_MeanSum)
-        {
-          m_MeanSum = raw_value - m_MeanSum;
-          m_Positive = !m_Positive;
-        }
-        else
-        {
-          m_MeanSum -= raw_value;
-        }
-      }
-    }
-  };
-  temp_trend temperatureTrendCalculator;
+  // The limits of the reading the current temperatures are from. Until the first, neither heater is in range.
+  uint8 reading_limits = interrupt::hotend_under | interrupt::bed_under;
 }
 
+Thermal::rate_filter Temperature::temperature_rate, Temperature::temperature_rate_bed;
+
 Temperature::Trend __forceinline __flatten Temperature::get_temperature_trend()
 {
-  return temperatureTrendCalculator.is_positive() ? Trend::Up : Trend::Down;
+  return temperature_rate.is_falling() ? Trend::Down : Trend::Up;
 }
 
-void Temperature::PID_autotune(arg_type<temp_t> temp, arg_type<int> ncycles, bool set_result/*=false*/) {
+void Temperature::PID_autotune(arg_type<temp_t> temp, arg_type<int8> hotend, arg_type<int> ncycles, bool set_result/*=false*/) {
+  if (hotend < 0)
+  {
+#if ENABLED(PIDTEMPBED)
+    BedManager::calibrate(temp, uint8(constrain(ncycles, 3, 20)));
+#else
+    SERIAL_ECHOLNPGM(MSG_PID_BAD_EXTRUDER_NUM);
+#endif
+    return;
+  }
   HeaterManager::calibrate(temp);
 }
 
+__pure bool Temperature::is_calibrating() {
+  if (Tuna::Thermal::FanCompensation::is_calibrating())
+  {
+    return true;
+  }
+#if ENABLED(PIDTEMPBED)
+  if (BedManager::is_calibrating())
+  {
+    return true;
+  }
+#endif
+  return HeaterManager::is_calibrating();
+}
+
+__pure uint8 Temperature::calibration_progress() {
+  if (Tuna::Thermal::FanCompensation::is_calibrating())
+  {
+    return Tuna::Thermal::FanCompensation::calibration_progress();
+  }
+#if ENABLED(PIDTEMPBED)
+  if (BedManager::is_calibrating())
+  {
+    return BedManager::calibration_progress();
+  }
+#endif
+  return HeaterManager::calibration_progress();
+}
+
 void Temperature::updatePID() {}
 
 template <Temperature::Manager manager_type>
@@ -205,6 +227,7 @@ template <Temperature::Manager manager_type>
 void Temperature::_temp_error(const char * __restrict const serial_msg, const char * __restrict const lcd_msg) {
 	static bool killed = false;
 	lcd::show_page(lcd::Page::Thermal_Runaway);
+	lcd::show_page_now(lcd::Page::Thermal_Runaway); // The heaters may be killed before update() runs
 	if (__likely(is_running())) {
 		SERIAL_ERROR_START();
 		serialprintPGM(serial_msg);
@@ -243,22 +266,12 @@ void Temperature::min_temp_error() {
 }
 
 /**
- * Manage heating activities for extruder hot-ends and a heated bed
- *  - Acquire updated temperature readings
- *    - Also resets the watchdog timer
- *  - Invoke thermal runaway protection
- *  - Manage extruder auto-fan
- *  - Apply filament width to the extrusion rate (may move)
- *  - Update the heated bed PID output value
+ * Thermal runaway protection and the heating watch, for the hotend and the bed.
+ * Their periods are in seconds, so they run from the main loop's scheduler
+ * (every HEATER_CHECK_INTERVAL ms) rather than on every temperature update.
  */
-bool Temperature::manage_heater() {
-
-  if (__likely(!updateTemperaturesFromRawValues()))
-  {
-    return false;
-  }
-
-	millis_t ms = millis();
+void Temperature::check_heaters() {
+	const millis_t ms = chrono::time_ms32::now().raw();
 
 	// Check for thermal runaway
 #if ENABLE_ERROR_2A
@@ -285,70 +298,231 @@ bool Temperature::manage_heater() {
 			start_watching_bed();
 	}
 
-	//if (PENDING(ms, next_bed_check_ms)) return true;
-	//next_bed_check_ms = ms + BED_CHECK_INTERVAL;
-
 #if ENABLE_ERROR_2B
 	thermal_runaway_protection<Manager::Bed>(thermal_runaway_bed_state_machine, thermal_runaway_bed_timer, current_temperature_bed, target_temperature_bed, THERMAL_PROTECTION_BED_PERIOD, THERMAL_PROTECTION_BED_HYSTERESIS);
 #endif
+}
 
-  // Failsafe to make sure fubar'd PID settings don't force the heater always on.
-  if (__unlikely(target_temperature == 0_C))
+/**
+ * Manage heating activities for extruder hot-ends and a heated bed
+ *  - Acquire updated temperature readings
+ *    - Also resets the watchdog timer
+ *  - Manage extruder auto-fan
+ *  - Apply filament width to the extrusion rate (may move)
+ *  - Update the heated bed PID output value
+ */
+bool Temperature::manage_heater() {
+
+  if (__likely(!updateTemperaturesFromRawValues()))
   {
-    soft_pwm_amount.write_through(0);
-    WRITE_HEATER_0(LOW);
+    return false;
   }
-  else if (__unlikely((current_temperature <= Hotend::min_temperature::Temperature || is_preheating()) || current_temperature >= Hotend::max_temperature::Temperature))
+
+  // A calibration in progress sets the target and the manager's parameters for this update.
+  if (__unlikely(HeaterManager::is_calibrating()))
   {
-    soft_pwm_amount.write_through(0);
+    HeaterManager::calibration_step();
   }
-  else
+#if ENABLED(PIDTEMPBED)
+  if (__unlikely(BedManager::is_calibrating()))
+  {
+    BedManager::calibration_step();
+  }
+#endif
+  if (__unlikely(Tuna::Thermal::FanCompensation::is_calibrating()))
   {
-    soft_pwm_amount.write_through(HeaterManager::get_power(current_temperature, target_temperature));
+    Tuna::Thermal::FanCompensation::calibration_step();
   }
 
+  // Both powers are worked out before either is set, so a power budget can share them out.
+  uint8 hotend_power = 0;
   // Failsafe to make sure fubar'd PID settings don't force the heater always on.
-  if (__unlikely(target_temperature_bed == 0_C))
+  const bool hotend_failsafe =
+    target_temperature == 0_C || is_preheating() ||
+    (reading_limits & interrupt::hotend_out);
+  if (__likely(!hotend_failsafe))
   {
-    if constexpr(has_bed_thermal_management)
-    {
-      soft_pwm_amount_bed = 0;
-    }
-    else
-    {
-      is_bed_heating = false;
-    }
-    WRITE_HEATER_BED(LOW);
+    hotend_power = HeaterManager::get_power(current_temperature, target_temperature);
   }
 
+  // The bed is on or off without bed thermal management, as 0 or 0xFF.
+  uint8 bed_power = 0;
+  // Failsafe to make sure fubar'd PID settings don't force the heater always on.
+  bool bed_failsafe = __unlikely(target_temperature_bed == 0_C);
+
 	// Check if temperature is within the correct range
-	if (__likely(WITHIN(current_temperature_bed, temp_t(Bed::min_temperature::Temperature), temp_t(Bed::max_temperature::Temperature))))
+	if (__likely(!(reading_limits & interrupt::bed_out)))
   {
-    if constexpr(has_bed_thermal_management)
-    {
-      soft_pwm_amount_bed = current_temperature_bed < target_temperature_bed ? MAX_BED_POWER >> 1 : 0;
-    }
-    else
-    {
-      is_bed_heating = current_temperature_bed < target_temperature_bed;
-    }
+#if ENABLED(PIDTEMPBED)
+    bed_power = BedManager::get_power(current_temperature_bed, target_temperature_bed);
+#else
+    bed_power = current_temperature_bed < target_temperature_bed ? 0xFF : 0;
+#endif
 	}
 	else
   {
-    if constexpr(has_bed_thermal_management)
+    bed_failsafe = true;
+	}
+  if (__unlikely(bed_failsafe))
+  {
+    bed_power = 0;
+  }
+
+#if ENABLED(HEATER_POWER_BUDGET)
+  budget_power(hotend_power, bed_power);
+#endif
+
+  set_hotend_power(hotend_power);
+  if constexpr(has_bed_thermal_management)
+  {
+    soft_pwm_amount_bed = bed_power;
+  }
+  else
+  {
+    is_bed_heating = bed_power != 0;
+  }
+  if (__unlikely(bed_failsafe))
+  {
+    WRITE_HEATER_BED(LOW);
+  }
+
+#if ENABLED(THERMAL_TELEMETRY)
+  record_telemetry();
+#endif
+
+  return true;
+}
+
+#if ENABLED(HEATER_POWER_BUDGET)
+
+// The powers are duties of 255, so the budget and the draw are counted in watts * 255. The heater
+// that is further from its target in time gets what it asks for as far as the budget goes, and the
+// other one gets what is left. A bed without bed thermal management is all or nothing, so it waits
+// while the hotend leaves too little for it.
+void Temperature::budget_power(uint8 & __restrict hotend_power, uint8 & __restrict bed_power)
+{
+  constexpr const uint32 budget = uint32(HEATER_POWER_BUDGET_WATTS) * 255;
+  constexpr const uint32 hotend_watts = HEATER_POWER_HOTEND_WATTS;
+  constexpr const uint32 bed_watts = HEATER_POWER_BED_WATTS;
+
+  if (__likely(hotend_watts * hotend_power + bed_watts * bed_power <= budget))
+  {
+    return;
+  }
+
+  // Time to target is distance over rate; the products compare them without dividing. A heater
+  // short of its target that isn't rising yet counts as the furthest off.
+  const int16 hotend_distance = max(int16(target_temperature.raw() - current_temperature.raw()), int16(0));
+  const int16 bed_distance = max(int16(target_temperature_bed.raw() - current_temperature_bed.raw()), int16(0));
+  const int16 hotend_rate = get_temperature_rate<Manager::Hotend>().raw();
+  const int16 bed_rate = get_temperature_rate<Manager::Bed>().raw();
+
+  bool bed_first;
+  if (bed_distance > 0 && bed_rate <= 0)
+  {
+    bed_first = true;
+  }
+  else if (hotend_distance > 0 && hotend_rate <= 0)
+  {
+    bed_first = false;
+  }
+  else
+  {
+    bed_first = int32(bed_distance) * max(hotend_rate, int16(1)) >= int32(hotend_distance) * max(bed_rate, int16(1));
+  }
+
+  if (bed_first)
+  {
+    // Each heater alone fits the budget, which SanityCheck makes sure of.
+    const uint32 left = budget - bed_watts * bed_power;
+    hotend_power = uint8(min(uint32(hotend_power), left / hotend_watts));
+  }
+  else
+  {
+    const uint32 left = budget - hotend_watts * hotend_power;
+    if constexpr (has_bed_thermal_management)
     {
-      soft_pwm_amount_bed = 0;
+      bed_power = uint8(min(uint32(bed_power), left / bed_watts));
     }
     else
     {
-      is_bed_heating = false;
+      bed_power = 0;
     }
-		WRITE_HEATER_BED(LOW);
-	}
+  }
+}
 
-  return true;
+#endif
+
+#if ENABLED(THERMAL_TELEMETRY)
+
+Temperature::telemetry_t Temperature::telemetry[THERMAL_TELEMETRY_LENGTH];
+spsc_ring<THERMAL_TELEMETRY_LENGTH> Temperature::telemetry_queue;
+uint16 Temperature::telemetry_interval = 0;
+uint16 Temperature::telemetry_next_ms = 0;
+
+void Temperature::record_telemetry()
+{
+  if (__likely(telemetry_interval == 0))
+  {
+    return;
+  }
+
+  const uint16 ms = millis16();
+  if (int16(ms - telemetry_next_ms) < 0)
+  {
+    return;
+  }
+  telemetry_next_ms += telemetry_interval;
+  // Fell behind (a long blocking command): restart the schedule rather than catch up.
+  if (int16(ms - telemetry_next_ms) >= 0)
+  {
+    telemetry_next_ms = ms + telemetry_interval;
+  }
+
+  if (telemetry_queue.full())
+  {
+    return;
+  }
+
+  telemetry_t & __restrict entry = telemetry[telemetry_queue.head()];
+  entry.time = ms;
+  entry.temperature = current_temperature.raw();
+  entry.target = target_temperature.raw();
+  entry.power = soft_pwm_amount;
+  entry.bed_power = getHeaterPower<Manager::Bed>();
+  telemetry_queue.push();
+}
+
+void Temperature::set_telemetry_interval(arg_type<uint16> interval_ms)
+{
+  telemetry_interval = interval_ms;
+  telemetry_next_ms = millis16();
+}
+
+/**
+ * Send the recorded samples, oldest first, as a line
+ *   telemetry:<count>
+ * followed by <count> raw 8-byte telemetry_t entries and a newline.
+ * Each entry is released once sent, so recording goes on meanwhile.
+ */
+void Temperature::report_telemetry()
+{
+  const uint8 count = uint8(telemetry_queue.count());
+  SERIAL_ECHOLNPAIR("telemetry:", uint16(count));
+  for (uint8 i = 0; i < count; ++i)
+  {
+    const uint8 * __restrict bytes = reinterpret_cast<const uint8 *>(&telemetry[telemetry_queue.tail()]);
+    for (uint8 b = 0; b < sizeof(telemetry_t); ++b)
+    {
+      SERIAL_CHAR(bytes[b]);
+    }
+    telemetry_queue.pop();
+  }
+  SERIAL_EOL();
 }
 
+#endif // THERMAL_TELEMETRY
+
 temp_t Temperature::adc_to_temperature(arg_type<uint16> raw)
 {
 	return Thermistor::adc_to_temperature(raw);
@@ -366,63 +540,37 @@ bool Temperature::updateTemperaturesFromRawValues() {
 	{
     HeaterManager::debug_dump();
 
-		uint16 temperature_raw;
-		uint16 temperature_bed_raw;
-		{
-			Tuna::critical_section_not_isr _critsec;
-      temperature_raw = interrupt::get_adc_hotend();
-			temperature_bed_raw = interrupt::get_adc_bed();
-      interrupt::set_ready(false);
-		}
+		// A reading that comes in after this only sets ready again
+		interrupt::set_ready(false);
+		const auto reading = interrupt::get_adc();
+		uint16 temperature_raw = reading.hotend;
+		uint16 temperature_bed_raw = reading.bed;
+		reading_limits = reading.limits;
 
+		// The ISR checked the reading against the limits as it took it
 #if ENABLE_ERROR_3
-		if constexpr (HEATER_0_RAW_LO_TEMP < HEATER_0_RAW_HI_TEMP)
-		{
-			if (__unlikely((temperature_raw >= Hotend::max_temperature::Adc) & (target_temperature > 0_C))) { max_temp_error<Manager::Hotend>(); }
-			if (__unlikely((Hotend::min_temperature::Adc >= temperature_raw) & (!is_preheating()) & (target_temperature > 0_C))) { min_temp_error<Manager::Hotend>(); }
-		}
-		else
-		{
-			if (__unlikely((temperature_raw <= Hotend::max_temperature::Adc) & (target_temperature > 0_C))) { max_temp_error<Manager::Hotend>(); }
-			if (__unlikely((Hotend::min_temperature::Adc <= temperature_raw) & (!is_preheating()) & (target_temperature > 0_C))) { min_temp_error<Manager::Hotend>(); }
-		}
+		if (__unlikely((reading.limits & interrupt::hotend_over) && (target_temperature > 0_C))) { max_temp_error<Manager::Hotend>(); }
+		if (__unlikely((reading.limits & interrupt::hotend_under) && !is_preheating() && (target_temperature > 0_C))) { min_temp_error<Manager::Hotend>(); }
 #endif
 
 #if ENABLE_ERROR_5
-		if constexpr (HEATER_BED_RAW_LO_TEMP < HEATER_BED_RAW_HI_TEMP)
-		{
-			if (__unlikely((temperature_bed_raw >= Bed::max_temperature::Adc) & (target_temperature_bed > 0_C))) { max_temp_error<Manager::Bed>(); }
-			if (__unlikely((Bed::min_temperature::Adc >= temperature_bed_raw) & (target_temperature_bed > 0_C))) { min_temp_error<Manager::Bed>(); }
-		}
-		else
-		{
-			if (__unlikely((temperature_bed_raw <= Bed::max_temperature::Adc) & (target_temperature_bed > 0_C))) { max_temp_error<Manager::Bed>(); }
-			if (__unlikely((Bed::min_temperature::Adc <= temperature_bed_raw) & (target_temperature_bed > 0_C))) { min_temp_error<Manager::Bed>(); }
-		}
+		if (__unlikely((reading.limits & interrupt::bed_over) && (target_temperature_bed > 0_C))) { max_temp_error<Manager::Bed>(); }
+		if (__unlikely((reading.limits & interrupt::bed_under) && (target_temperature_bed > 0_C))) { min_temp_error<Manager::Bed>(); }
 #endif
 
     // reading from constexpr here.
     temperature_raw = Thermistor::clamp_adc(temperature_raw);
     temperature_bed_raw = Thermistor::clamp_adc(temperature_bed_raw);
 
-    const auto previous_temperature = current_temperature;
-
 		current_temperature = Temperature::adc_to_temperature(temperature_raw);
 		current_temperature_bed = Temperature::adc_to_temperature(temperature_bed_raw);
 
-    if (current_temperature >= previous_temperature)
-    {
-      const temp_t temperatureDiff = current_temperature - previous_temperature;
-      temperatureTrendCalculator.appendValue(temperatureDiff, true);
-    }
-    else
-    {
-      const temp_t temperatureDiff = previous_temperature - current_temperature;
-      temperatureTrendCalculator.appendValue(temperatureDiff, false);
-    }
+    const uint16 now_ms = millis16();
+    temperature_rate.update(current_temperature, now_ms);
+    temperature_rate_bed.update(current_temperature_bed, now_ms);
 
 		// Reset the watchdog after we know we have a temperature measurement.
-		Tuna::intrinsic::wdr();
+		watchdog_reset();
 		return true;
 	}
 	return false;
@@ -437,23 +585,42 @@ void Temperature::init()
 	SET_OUTPUT(HEATER_0_PIN);
 	SET_OUTPUT(HEATER_BED_PIN);
 
+#if ENABLED(FAN_HARDWARE_PWM)
+	Tuna::fan_pwm::init();
+#else
 	SET_OUTPUT(FAN_PIN);
+#endif
 
 #define ANALOG_SELECT(pin) do{ SBI(DIDR0, pin); }while(0)
 
 	// Set analog inputs
+#if ENABLED(ADC_FREE_RUNNING)
+	// Free running from the hotend sensor; the ADC ISR takes it from here.
+	ADCSRB = (TEMP_0_PIN > 7) ? _BV(MUX5) : 0_u8;
+	ADMUX = _BV(REFS0) | (TEMP_0_PIN & 0x07_u8);
+	ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADATE) | _BV(ADIF) | _BV(ADIE) | 0x07;
+#else
 	ADCSRA = _BV(ADEN) | _BV(ADSC) | _BV(ADIF) | 0x07;
+#endif
 	DIDR0 = 0;
 	ANALOG_SELECT(TEMP_0_PIN);
 	ANALOG_SELECT(TEMP_BED_PIN);
 
 	// Use timer0 for temperature measurement
 	// Interleave temperature interrupt with millies interrupt
+#if ENABLED(HOTEND_HARDWARE_PWM)
+	// OCR0B is the heater's duty, so the interrupt runs off compare A instead.
+	OCR0A = 128;
+	SBI(TIMSK0, OCIE0A);
+#else
 	OCR0B = 128;
 	SBI(TIMSK0, OCIE0B);
+#endif
 
+#if DISABLED(FAST_BOOT)
 	// Wait for temperature measurement to settle
 	delay(250_u8);
+#endif
 }
 
 /**
@@ -531,10 +698,10 @@ void Temperature::thermal_runaway_protection(Temperature::TRState & __restrict s
 		// While the temperature is stable watch for a bad temperature
 	case TRStable:
 		if (current >= tr_target_temperature<manager_type> -hysteresis_degc) {
-			timer = millis() + period_seconds * 1000UL;
+			timer = chrono::time_ms32::now().raw() + period_seconds * 1000UL;
 			break;
 		}
-    else if (PENDING(millis(), timer))
+    else if (PENDING(chrono::time_ms32::now().raw(), timer))
     {
       break;
     }
@@ -562,8 +729,7 @@ void Temperature::disable_all_heaters() {
 	print_job_timer.stop();
 
 	setTargetHotend(0);
-	soft_pwm_amount.write_through(0);
-	WRITE_HEATER_0(LOW);
+	set_hotend_power(0);
 
 	target_temperature_bed = 0;
   if constexpr(has_bed_thermal_management)
@@ -615,48 +781,40 @@ inline void __forceinline __flatten start_adc()
   SBI(ADCSRA, ADSC);
 }
 
-template <uint8 pin, bool superscalar = false>
+template <uint8 pin>
 inline void __forceinline __flatten set_pin(bool state)
 {
-  // TODO figure out why their original code uses critical sections when the port address >= 0x100.
+  // The heaters are on PORTG and PORTE, in I/O space, so this is a single SBI or CBI.
+  Tuna::io::pins<pin>::write(state);
+}
 
-  volatile uint8 * __restrict port_ptr;
-  uint8 port_pin_mask;
+/**
+ * With HOTEND_HARDWARE_PWM the heater is on OC0B, and timer 0 (already in fast PWM mode
+ * for millis) drives it at 976Hz with the duty in OCR0B. Duty 0 disconnects the output,
+ * as OCR0B = 0 would still give a one-tick pulse every period; OCR0B = 255 is fully on.
+ * The register is only written from normal context.
+ */
+void Temperature::set_hotend_power(arg_type<uint8> power)
+{
+  soft_pwm_amount.write_through(power);
 
-  switch (pin)
+#if ENABLED(HOTEND_HARDWARE_PWM)
+  if (power == 0)
   {
-  case 4: { // HEATER_0_PIN
-    port_ptr = &DIO4_WPORT;
-    port_pin_mask = 1_u8 << uint8(DIO4_PIN);
-  } break;
-  case 3: { // HEATER_BED_PIN
-    port_ptr = &DIO3_WPORT;
-    port_pin_mask = 1_u8 << uint8(DIO3_PIN);
-  } break;
+    CBI(TCCR0A, COM0B1);
+    WRITE_HEATER_0(LOW);
   }
-
-  volatile uint8 & __restrict port = *port_ptr;
-
-  // For some reason, the superscalar version generates better code.
-  // https://graphics.stanford.edu/~seander/bithacks.html#ConditionalSetOrClearBitsWithoutBranching
-  // However, it can only be used in contexts where ISRs are disabled,
-  // as it is a load-store, rather than a direct alteration.
-
-  if constexpr(superscalar)
+  else
   {
-    port = (port & ~port_pin_mask) | ((state ? 0xFF_u8 : 0x00_u8) & port_pin_mask);
+    OCR0B = power;
+    SBI(TCCR0A, COM0B1);
   }
-  else
+#else
+  if (power == 0)
   {
-    if (state) // high
-    {
-      port |= port_pin_mask;
-    }
-    else // low
-    {
-      port &= ~port_pin_mask;
-    }
+    WRITE_HEATER_0(LOW);
   }
+#endif
 }
 
 /**
@@ -664,16 +822,36 @@ inline void __forceinline __flatten set_pin(bool state)
 *
 * This ISR uses the compare method so it runs at the base
 * frequency (16 MHz / 64 / 256 = 976.5625 Hz), but at the TCNT0 set
-* in OCR0B above (128 or halfway between OVFs).
+* in OCR0B above (128 or halfway between OVFs), or OCR0A with HOTEND_HARDWARE_PWM.
 *
 *  - Manage PWM to all the heaters and fan
 *  - Prepare or Measure one of the raw ADC sensor values
 *  - Check new temperature values for MIN/MAX errors (kill on error)
-*  - Step the babysteps value for each axis towards 0
 *  - For PINS_DEBUGGING, monitor and report endstop pins
 *  - For ENDSTOP_INTERRUPTS_FEATURE check endstops if flagged
 */
-__signal(TIMER0_COMPB) { Temperature::isr(); }
+#if ENABLED(HOTEND_HARDWARE_PWM)
+__signal(TIMER0_COMPA) {
+  constexpr const uint8 compare_flag = OCF0A;
+#else
+__signal(TIMER0_COMPB) {
+  constexpr const uint8 compare_flag = OCF0B;
+#endif
+#if ENABLED(NESTED_INTERRUPTS)
+  // The stepper gets in as soon as it's due, rather than after the heaters and the ADC.
+  const Tuna::interrupts::nested_isr<Tuna::interrupts::priority::temperature> _nested;
+#endif
+#if ENABLED(ISR_PROFILING)
+  // Timer 0 wraps every 256 ticks (1.024ms), longer than the handler ever runs.
+  // Another compare match pending on exit means the next call is already late.
+  const uint8 profile_start = TCNT0;
+  Temperature::isr();
+  Tuna::interrupts::temperature_timing.add(uint8(TCNT0 - profile_start), TEST(TIFR0, compare_flag));
+#else
+  UNUSED(compare_flag);
+  Temperature::isr();
+#endif
+}
 
 template <typename T, uint8 count>
 class running_average final
@@ -705,13 +883,73 @@ public:
   }
 };
 
+#if ENABLED(ADC_FREE_RUNNING)
+/**
+ * With ADC_FREE_RUNNING the ADC converts back to back (125kHz / 13 = 9.6kHz) and this
+ * ISR sums ADC_FREE_RUNNING_SAMPLES conversions of one sensor into each reading, then
+ * switches to the other. The conversion already under way when the channel changes still
+ * belongs to the old one, so the first result after a switch is dropped.
+ */
+__signal(ADC) {
+  static constexpr const uint8 samples = ADC_FREE_RUNNING_SAMPLES;
+
+  static running_average<uint16, 32> local_raw_adc_hotend;
+  static running_average<uint16, 32> local_raw_adc_bed;
+
+  static uint8 sample_count = 0;
+  static uint16 sample_sum = 0;
+  static bool reading_bed = false;
+
+  const uint16 value = ADC;
+
+  if (__unlikely(sample_count++ == 0))
+  {
+    return;
+  }
+
+  sample_sum += value;
+
+  if (__likely(sample_count <= samples))
+  {
+    return;
+  }
+
+#if ENABLED(NESTED_INTERRUPTS)
+  // The division and the channel switch are the long part; the stepper can preempt them.
+  const Tuna::interrupts::nested_isr<Tuna::interrupts::priority::temperature> _nested;
+#endif
+
+  // Scaled to OVERSAMPLENR samples, what the thermistor tables expect.
+  const uint16 reading = uint16((uint32(sample_sum) * OVERSAMPLENR) / samples);
+  sample_sum = 0;
+  sample_count = 0;
+
+  if (reading_bed)
+  {
+    local_raw_adc_bed += reading;
+    interrupt::set_adc(uint16(local_raw_adc_hotend), uint16(local_raw_adc_bed));
+    ADCSRB = (TEMP_0_PIN > 7) ? _BV(MUX5) : 0_u8;
+    ADMUX = _BV(REFS0) | (TEMP_0_PIN & 0x07_u8);
+  }
+  else
+  {
+    local_raw_adc_hotend += reading;
+    ADCSRB = (TEMP_BED_PIN > 7) ? _BV(MUX5) : 0_u8;
+    ADMUX = _BV(REFS0) | (TEMP_BED_PIN & 0x07_u8);
+  }
+  reading_bed = !reading_bed;
+}
+#endif
+
 void __forceinline __flatten Temperature::isr()
 {
 	static uint8 oversample_count = 0;
-  static sensor_state adc_sensor_state = sensor_state::initialize_hotend;
 
   static constexpr const uint8 temp_avg_count = 32;
 
+#if DISABLED(ADC_FREE_RUNNING)
+  static sensor_state adc_sensor_state = sensor_state::initialize_hotend;
+
   // ADC read/handle
   {
     /**
@@ -755,6 +993,7 @@ void __forceinline __flatten Temperature::isr()
     }
     }
   }
+#endif
 
   static constexpr const uint8 skip_mask = 8; // Only run every Nth times this ISR is hit.
   static uint8 skip_counter = 0;
@@ -763,8 +1002,13 @@ void __forceinline __flatten Temperature::isr()
     return;
   }
 
-  const uint8_t extruder_pwm = soft_pwm_amount.read_through();
-  const uint8_t bed_pwm = []() -> uint8 {
+  // With HOTEND_HARDWARE_PWM, timer 0 drives the hotend and only the bed is left to this ISR.
+  constexpr const bool software_hotend_pwm = DISABLED(HOTEND_HARDWARE_PWM);
+
+  // A heater over MAXTEMP stays off whatever its power, from the reading that found it.
+  const uint8 over_max = interrupt::over_max();
+  const uint8_t extruder_pwm = (software_hotend_pwm && __likely(!(over_max & interrupt::hotend_over))) ? soft_pwm_amount.read_through() : 0_u8;
+  const uint8_t bed_pwm = (over_max & interrupt::bed_over) ? 0_u8 : []() -> uint8 {
     if constexpr(has_bed_thermal_management)
     {
       return soft_pwm_amount_bed;
@@ -841,7 +1085,10 @@ void __forceinline __flatten Temperature::isr()
 
     ++pwm_counter;
 
-    set_pin<HEATER_0_PIN>(new_extruder_state);
+    if constexpr (software_hotend_pwm)
+    {
+      set_pin<HEATER_0_PIN>(new_extruder_state);
+    }
     set_pin<HEATER_BED_PIN>(new_bed_state);
   }
 }
@@ -48,11 +48,12 @@ namespace Tuna
 }
 
 #include "thermistors/thermistortables.h"
+#include "thermal/rate.hpp"
 
 namespace Tuna
 {
   // TODO move this to a better place
-  static constexpr const bool has_bed_thermal_management = false;
+  static constexpr const bool has_bed_thermal_management = ENABLED(PIDTEMPBED);
 
   class Temperature final : trait::ce_only
   {
@@ -86,12 +87,29 @@ namespace Tuna
 		  static constexpr const auto Adc = make_uintsz<Thermistor::ce_convert_temp_to_adc<Temperature.raw()>()>;
 	  };
 
+    // MAXTEMP and MINTEMP as raw readings, so a reading is checked against them without being
+    // converted. Whether the reading rises or falls with the temperature depends on the sensor.
+    template <typename Limits, bool AdcRises>
+    struct AdcLimits final : trait::ce_only
+    {
+      static constexpr bool __forceinline __flatten over_max(arg_type<uint16> raw)
+      {
+        return AdcRises ? (raw >= Limits::max_temperature::Adc) : (raw <= Limits::max_temperature::Adc);
+      }
+
+      static constexpr bool __forceinline __flatten under_min(arg_type<uint16> raw)
+      {
+        return AdcRises ? (raw <= Limits::min_temperature::Adc) : (raw >= Limits::min_temperature::Adc);
+      }
+    };
+
 	  struct Hotend final : trait::ce_only
 	  {
 		  using max_temperature = TemperatureValueConverter<HEATER_0_MAXTEMP>;
 		  using min_temperature = TemperatureValueConverter<HEATER_0_MINTEMP>;
       static_assert(max_temperature::Adc != min_temperature::Adc, "these values should never be equal.");
       static_assert(max_temperature::Temperature != min_temperature::Temperature, "these values should never be equal.");
+      using adc = AdcLimits<Hotend, (HEATER_0_RAW_LO_TEMP < HEATER_0_RAW_HI_TEMP)>;
 	  };
 
     struct Bed final : trait::ce_only
@@ -100,6 +118,7 @@ namespace Tuna
 		  using min_temperature = TemperatureValueConverter<BED_MINTEMP>;
       static_assert(max_temperature::Adc != min_temperature::Adc, "these values should never be equal.");
       static_assert(max_temperature::Temperature != min_temperature::Temperature, "these values should never be equal.");
+      using adc = AdcLimits<Bed, (HEATER_BED_RAW_LO_TEMP < HEATER_BED_RAW_HI_TEMP)>;
 	  };
 
     static temp_t current_temperature;
@@ -125,7 +144,7 @@ namespace Tuna
 	  }
 
   private:
-	  static millis_t next_bed_check_ms;
+	  static Thermal::rate_filter temperature_rate, temperature_rate_bed;
 
   public:
 	  /**
@@ -136,6 +155,23 @@ namespace Tuna
 
     static Trend __forceinline __flatten get_temperature_trend();
 
+	  /**
+	   * Low-pass filtered rate of change of a sensor, in temp_t units (1/16 C) per second,
+	   * for feed-forward and prediction. get_temperature_trend() is the sign of the hotend's.
+	   */
+	  template <Manager manager>
+	  static __forceinline __flatten const Thermal::rate_filter & get_temperature_rate()
+	  {
+		  if constexpr (manager == Manager::Hotend)
+		  {
+			  return temperature_rate;
+		  }
+		  else
+		  {
+			  return temperature_rate_bed;
+		  }
+	  }
+
 	  /**
 	   * Static (class) methods
 	   */
@@ -151,6 +187,11 @@ namespace Tuna
 	   */
 	  static bool manage_heater();
 
+	  /**
+	   * Thermal runaway and heating watch checks. Run every HEATER_CHECK_INTERVAL ms
+	   */
+	  static void check_heaters();
+
 	  /**
 	   * Preheating hotends
 	   */
@@ -204,8 +245,33 @@ namespace Tuna
 
 	  /**
 	   * Perform auto-tuning for hotend or bed in response to M303
+	   * This only starts the calibration; manage_heater() carries it out.
+	   * A negative 'hotend' selects the bed.
 	   */
-	  static void PID_autotune(arg_type<temp_t> temp, arg_type<int> ncycles, bool set_result = false);
+	  static void PID_autotune(arg_type<temp_t> temp, arg_type<int8> hotend, arg_type<int> ncycles, bool set_result = false);
+
+	  static __pure bool is_calibrating();
+	  static __pure uint8 calibration_progress(); // percent
+
+#if ENABLED(THERMAL_TELEMETRY)
+	  // One sample of the hotend, as sent by report_telemetry(); 8 bytes, little-endian.
+	  struct telemetry_t final
+	  {
+		  uint16 time;          // millis(), wrapping
+		  uint16 temperature;   // temp_t raw value (1/16 C)
+		  uint16 target;        // temp_t raw value
+		  uint8 power;          // hotend PWM
+		  uint8 bed_power;      // bed PWM, or 0xFF while the bed is heating
+	  };
+	  static_assert(sizeof(telemetry_t) == 8, "the host reads 8-byte entries");
+
+	  // Recorded by manage_heater(), read and released by report_telemetry()
+	  static telemetry_t telemetry[THERMAL_TELEMETRY_LENGTH];
+	  static spsc_ring<THERMAL_TELEMETRY_LENGTH> telemetry_queue;
+
+	  static void set_telemetry_interval(arg_type<uint16> interval_ms);
+	  static void report_telemetry();
+#endif
 
 	  /**
 	   * Update the temp manager when PID values change
@@ -215,14 +281,30 @@ namespace Tuna
   private:
 	  static bool updateTemperaturesFromRawValues();
 
+	  // Sets the hotend duty; 0 also switches the heater off immediately.
+	  static void set_hotend_power(arg_type<uint8> power);
+
+#if ENABLED(HEATER_POWER_BUDGET)
+	  // Lowers the powers manage_heater() worked out so the heaters draw no more than the budget.
+	  static void budget_power(uint8 & __restrict hotend_power, uint8 & __restrict bed_power);
+#endif
+
+#if ENABLED(THERMAL_TELEMETRY)
+	  static uint16 telemetry_interval;       // ms between samples, 0 when not recording
+	  static uint16 telemetry_next_ms;
+
+	  static void record_telemetry();
+#endif
+
 	  static void checkExtruderAutoFans();
 
+	  // Only reached on a fault, so out of line and with the cold code
 	  template <Manager manager_type>
-	  static void _temp_error(const char * __restrict const serial_msg, const char * __restrict const lcd_msg);
+	  static void __cold __no_inline _temp_error(const char * __restrict const serial_msg, const char * __restrict const lcd_msg);
 	  template <Manager manager_type>
-	  static void min_temp_error();
+	  static void __cold __no_inline min_temp_error();
 	  template <Manager manager_type>
-	  static void max_temp_error();
+	  static void __cold __no_inline max_temp_error();
 
 	  typedef enum TRState { TRInactive, TRFirstHeating, TRStable, TRRunaway } TRstate;
 
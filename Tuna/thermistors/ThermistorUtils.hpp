@@ -13,4 +13,149 @@ namespace Tuna::_ThermistorUtils
       Adc(_ADC * OVERSAMPLENR), Temperature(_Temperature << temp_t::fractional_bits)
     {}
   };
+
+  // The (oversampled) ADC value and the temperature in Celsius of a table entry, for both the
+  // TablePairBase tables and the raw Marlin { adc, celsius } tables.
+  template <typename T>
+  constexpr float pair_adc(const TablePairBase<T> & pair) { return float(pair.Adc.get()); }
+  template <typename T>
+  constexpr float pair_celsius(const TablePairBase<T> & pair) { return float(pair.Temperature.get()) / (1 << temp_t::fractional_bits); }
+  constexpr float pair_adc(const short (& pair)[2]) { return float(pair[0]); }
+  constexpr float pair_celsius(const short (& pair)[2]) { return float(pair[1]); }
+
+  // Natural logarithm for the compile-time tables. Scales 'x' into [1, 2) by powers of two, then
+  // sums the atanh series, which converges quickly there.
+  constexpr float ce_log(float x)
+  {
+    constexpr const float ln2 = 0.69314718f;
+    int8 exponent = 0;
+    while (x >= 2.0f) { x *= 0.5f; ++exponent; }
+    while (x < 1.0f) { x *= 2.0f; --exponent; }
+
+    const float y = (x - 1.0f) / (x + 1.0f), y2 = y * y;
+    float term = y, sum = 0.0f;
+    for (uint8 n = 1; n < 16; n += 2)
+    {
+      sum += term / n;
+      term *= y2;
+    }
+    return 2.0f * sum + exponent * ln2;
+  }
+
+  // One entry of a uniform table: the temperature at the entry's ADC value, and the change to the next entry.
+  struct UniformEntry final
+  {
+    uint16 temperature;   // temp_t raw value
+    int16 delta;
+  };
+
+  // Temperatures at evenly spaced ADC values: entry i is at FirstAdc + (i << Shift). A conversion is a
+  // subtract, a shift, one flash read and an interpolation, whatever the sensor, with no search.
+  template <uint8 Shift, uint16 FirstAdc, uint16 Size>
+  struct UniformTable final
+  {
+    static constexpr const uint8 shift = Shift;
+    static constexpr const uint16 first_adc = FirstAdc;
+    static constexpr const uint16 last_adc = FirstAdc + ((Size - 2) << Shift);
+    static constexpr const uint16 size = Size;
+
+    flash_array<UniformEntry, Size> entries;
+
+    // 'adc' must be within [first_adc, last_adc + (1 << Shift)).
+    inline temp_t __forceinline __flatten lookup(arg_type<uint16> adc) const __restrict
+    {
+      __assume(adc >= first_adc);
+
+      const uint16 offset = adc - first_adc;
+      const UniformEntry entry = entries[offset >> Shift];
+      const uint8 fraction = uint8(offset & ((1 << Shift) - 1));
+      return temp_t::from(uint16(entry.temperature + int16((int32(entry.delta) * fraction) >> Shift)));
+    }
+  };
+
+  // Samples 'celsius_at(adc)' into a uniform table covering [FirstAdc, LastAdc]. Temperatures are clamped
+  // to [0, printer_max_temperature], which is all temp_t holds.
+  template <uint8 Shift, uint16 FirstAdc, uint16 LastAdc, typename Function>
+  constexpr UniformTable<Shift, FirstAdc, ((LastAdc - FirstAdc) >> Shift) + 2> make_uniform_table(Function celsius_at)
+  {
+    static_assert(LastAdc > FirstAdc, "the table must cover some range");
+
+    using table_t = UniformTable<Shift, FirstAdc, ((LastAdc - FirstAdc) >> Shift) + 2>;
+    table_t table = {};
+
+    const auto raw_at = [&](uint16 i) -> uint16
+    {
+      float celsius = celsius_at(float(FirstAdc + (uint32(i) << Shift)));
+      if (celsius < 0.0f) celsius = 0.0f;
+      if (celsius > float(printer_max_temperature)) celsius = float(printer_max_temperature);
+      return uint16(celsius * (1 << temp_t::fractional_bits) + 0.5f);
+    };
+
+    uint16 raw = raw_at(0);
+    for (uint16 i = 0; i < table_t::size; ++i)
+    {
+      const uint16 next = (i + 1 < table_t::size) ? raw_at(i + 1) : raw;
+      table.entries.m_Data[i] = { raw, int16(int32(next) - raw) };
+      raw = next;
+    }
+    return table;
+  }
+
+  // Resamples a table of entries sorted by ADC value, interpolating linearly between them as the search did.
+  template <uint8 Shift, const auto & Pairs>
+  constexpr auto resample_table()
+  {
+    constexpr const usize count = array_size(Pairs);
+    constexpr const uint16 first_adc = uint16(pair_adc(Pairs[0]));
+    constexpr const uint16 last_adc = uint16(pair_adc(Pairs[count - 1]));
+
+    return make_uniform_table<Shift, first_adc, last_adc>([](const float adc) -> float
+    {
+      if (adc <= pair_adc(Pairs[0])) return pair_celsius(Pairs[0]);
+      for (usize i = 1; i < count; ++i)
+      {
+        const float a0 = pair_adc(Pairs[i - 1]), a1 = pair_adc(Pairs[i]);
+        if (adc <= a1)
+        {
+          const float t0 = pair_celsius(Pairs[i - 1]), t1 = pair_celsius(Pairs[i]);
+          return (a1 > a0) ? t0 + (t1 - t0) * (adc - a0) / (a1 - a0) : t1;
+        }
+      }
+      return pair_celsius(Pairs[count - 1]);
+    });
+  }
+
+  // A thermistor on the low side of a 'Pullup' ohm divider, over ADC counts 1 to 1022, from a
+  // function giving 1 / Kelvin for a resistance in ohms.
+  template <uint8 Shift, typename Function>
+  constexpr auto make_resistance_table(const float pullup, Function inverse_kelvin_at)
+  {
+    constexpr const float adc_max = 1024.0f * OVERSAMPLENR;
+    return make_uniform_table<Shift, 1 * OVERSAMPLENR, 1022 * OVERSAMPLENR>([=](const float adc) -> float
+    {
+      const float resistance = pullup * adc / (adc_max - adc);
+      return 1.0f / inverse_kelvin_at(resistance) - 273.15f;
+    });
+  }
+
+  // A thermistor given by its resistance at 25C and its beta.
+  template <uint8 Shift>
+  constexpr auto make_beta_table(const float r25, const float beta, const float pullup)
+  {
+    return make_resistance_table<Shift>(pullup, [=](const float resistance) -> float
+    {
+      return 1.0f / 298.15f + ce_log(resistance / r25) / beta;
+    });
+  }
+
+  // A thermistor given by its Steinhart-Hart coefficients.
+  template <uint8 Shift>
+  constexpr auto make_steinhart_hart_table(const float a, const float b, const float c, const float pullup)
+  {
+    return make_resistance_table<Shift>(pullup, [=](const float resistance) -> float
+    {
+      const float ln_r = ce_log(resistance);
+      return a + b * ln_r + c * ln_r * ln_r * ln_r;
+    });
+  }
 }
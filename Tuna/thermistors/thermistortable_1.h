@@ -493,8 +493,14 @@ namespace Tuna::Thermistor
     }
   }
 
+  // Every 32 oversampled ADC units (2 ADC counts). Within 0.1C of the table below 250C, and 1.25C above.
+  constexpr const uint8 uniform_table_shift = 5;
+  constexpr const __flashmem auto uniform_table = _ThermistorUtils::resample_table<uniform_table_shift, temp_table>();
+  static_assert(uniform_table.first_adc == min_adc, "the uniform table must start where the table does.");
+
+  // 'adc' must be clamped with clamp_adc() first.
   inline temp_t __forceinline __flatten adc_to_temperature(arg_type<uint16_t> adc)
   {
-    return binsearch_temp_get(adc);
+    return uniform_table.lookup(adc);
   }
 }
@@ -21,7 +21,7 @@
  */
 
 // Pt1000 with 1k0 pullup
-const short temptable_1010[][2] __flashmem = {
+constexpr const short temptable_1010[][2] __flashmem = {
   PtLine(  0, 1000, 1000)
   PtLine( 25, 1000, 1000)
   PtLine( 50, 1000, 1000)
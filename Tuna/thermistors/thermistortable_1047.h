@@ -21,7 +21,7 @@
  */
 
 // Pt1000 with 4k7 pullup
-const short temptable_1047[][2] __flashmem = {
+constexpr const short temptable_1047[][2] __flashmem = {
   // only a few values are needed as the curve is very flat
   PtLine(  0, 1000, 4700)
   PtLine( 50, 1000, 4700)
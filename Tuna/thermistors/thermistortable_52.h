@@ -24,7 +24,7 @@
 // Verified by linagee. Source: http://shop.arcol.hu/static/datasheets/thermistors.pdf
 // Calculated using 1kohm pullup, voltage divider math, and manufacturer provided temp/resistance
 // Advantage: More resolution and better linearity from 150C to 200C
-const short temptable_52[][2] __flashmem = {
+constexpr const short temptable_52[][2] __flashmem = {
   {    1 * OVERSAMPLENR, 500 },
   {  125 * OVERSAMPLENR, 300 }, // top rating 300C
   {  142 * OVERSAMPLENR, 290 },
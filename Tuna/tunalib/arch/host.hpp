@@ -0,0 +1,55 @@
+#pragma once
+
+// The intrinsics in portable C++, for building tunalib's headers off the chip, such as to check
+// the templates and the fixed-point math with a desktop compiler. Interrupts, sleep and the
+// watchdog don't exist there, so those do nothing; the arithmetic gives what the AVR gives.
+
+namespace Tuna::intrinsic
+{
+  constexpr inline __forceinline __flatten void sei() {}
+
+  constexpr inline __forceinline __flatten void cli() {}
+
+  constexpr inline __forceinline __flatten void nop() {}
+
+  constexpr inline __forceinline __flatten void sleep() {}
+
+  constexpr inline __forceinline __flatten void wdr() {}
+
+  constexpr inline __forceinline __flatten uint8 nibble_swap(uint8 val)
+  {
+    return uint8((val << 4) | (val >> 4));
+  }
+
+  // The FMUL family multiplies 1.7 fractions: the product, shifted left once.
+  constexpr inline __forceinline __flatten uint16 fmul(uint8 val0, uint8 val1)
+  {
+    return uint16((uint16(val0) * val1) << 1);
+  }
+
+  constexpr inline __forceinline __flatten int16 fmuls(int8 val0, int8 val1)
+  {
+    return int16(uint16(int16(val0) * val1) << 1);
+  }
+
+  constexpr inline __forceinline __flatten int16 fmulsu(int8 val0, uint8 val1)
+  {
+    return int16(uint16(int16(val0) * val1) << 1);
+  }
+
+  constexpr inline __forceinline __flatten void delay_cycles(arg_type<uint32>) {}
+
+  // Bit i of the result is bit 'n' of 'bits', where n is nibble i of 'map', or bit i of 'val' where
+  // that nibble is 0xF.
+  constexpr inline __forceinline __flatten uint8 insert_bits(arg_type<uint32> map, uint8 bits, uint8 val)
+  {
+    uint8 result = 0;
+    for (uint8 i = 0; i < 8; ++i)
+    {
+      const uint8 source = uint8((map >> (i * 4)) & 0xF);
+      const uint8 bit = (source == 0xF) ? ((val >> i) & 1) : ((bits >> (source & 7)) & 1);
+      result |= uint8(bit << i);
+    }
+    return result;
+  }
+}
@@ -47,4 +47,36 @@ namespace Tuna
       intrinsic::sei();
     }
   };
+
+  // Holds off only the interrupts whose enable bits are 'mask' in 'reg' (such as OCIE0B in TIMSK0,
+  // or RXCIE0 in UCSR0B), so every other handler, the stepper's among them, keeps running. Use it
+  // where the data is shared with that one handler alone. An interrupt that comes due meanwhile
+  // runs once the bits are set again, as it would after a critical_section. The bits are only
+  // changed with interrupts off, as handlers may write the same register. 'flags' are bits that a
+  // write of 1 clears, such as ADIF in ADCSRA, and are written as 0 to leave them be.
+  class interrupt_mask final
+  {
+    volatile uint8 & __restrict m_Register;
+    const uint8 m_Flags;
+    uint8 m_Masked;
+  public:
+    interrupt_mask(const interrupt_mask &) = delete;
+    interrupt_mask(interrupt_mask &&) = delete;
+    interrupt_mask & operator = (const interrupt_mask &) = delete;
+    interrupt_mask & operator = (interrupt_mask &&) = delete;
+
+    inline __forceinline __flatten interrupt_mask(volatile uint8 & __restrict reg, arg_type<uint8> mask, arg_type<uint8> flags = 0) :
+      m_Register(reg), m_Flags(flags)
+    {
+      critical_section _critsec;
+      const uint8 value = m_Register;
+      m_Masked = value & mask;
+      m_Register = value & ~(mask | m_Flags);
+    }
+    inline __forceinline __flatten ~interrupt_mask()
+    {
+      critical_section _critsec;
+      m_Register = (m_Register & ~m_Flags) | m_Masked;
+    }
+  };
 }
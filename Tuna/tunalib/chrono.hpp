@@ -4,6 +4,18 @@ namespace Tuna::chrono
 {
   template <typename T> class time_ms;
 
+  namespace _internal
+  {
+    // millis32() at the start of this pass of idle(). Only written and read by the main loop.
+    extern uint32 now_ms;
+  }
+
+  // Reads the clock for this pass of idle(), for time_ms<T>::now() in everything it calls.
+  inline void __forceinline __flatten update_now()
+  {
+    _internal::now_ms = millis32();
+  }
+
   // TODO FIXME Change this later
   template <typename T> using duration_ms = time_ms<T>;
 
@@ -53,6 +65,13 @@ namespace Tuna::chrono
       }
     }
 
+    // The time this pass of idle() began, without the critical section of get(). For the
+    // periodic work idle() runs, where that is close enough; call get() where it isn't.
+    static inline time_ms __forceinline __flatten now()
+    {
+      return { T(_internal::now_ms) };
+    }
+
     constexpr inline time_ms __forceinline __flatten operator - (arg_type<time_ms> other) const __restrict
     {
       return T(m_Value) - T(other.m_Value);
@@ -132,6 +151,68 @@ namespace Tuna::chrono
   using time_ms16 = time_ms<uint16>;
   using time_ms24 = time_ms<uint24>;
   using time_ms32 = time_ms<uint32>;
+
+  // Timer 5, left running free at F_CPU / 8 by start(): half a microsecond a tick at 16 MHz, wrapping
+  // every 32.768 ms, for timing anything shorter. Nothing else uses Timer 5, and each 16-bit timer
+  // latches its own high byte, so get() needs no critical section, unlike millis() and micros().
+  class time_ticks final
+  {
+    uint16 m_Value = 0;
+
+  public:
+    static constexpr const uint8 prescaler = 8;
+    static constexpr const uint8 per_us = uint8(F_CPU / 1000000UL / prescaler);
+
+    static_assert(per_us > 0, "ticks are shorter than a microsecond");
+
+    constexpr time_ticks() = default;
+    constexpr time_ticks(arg_type<uint16> value) : m_Value(value) {}
+
+    // Normal mode, counting to the top and wrapping, without interrupts.
+    static inline void start()
+    {
+      TIMSK5 = 0;
+      TCCR5A = 0;
+      TCCR5B = _BV(CS51);
+    }
+
+    static inline time_ticks __forceinline __flatten get()
+    {
+      return { uint16(TCNT5) };
+    }
+
+    inline uint16 __forceinline __flatten raw() const __restrict
+    {
+      return m_Value;
+    }
+
+    static constexpr inline uint16 __forceinline __flatten to_us(arg_type<uint16> ticks)
+    {
+      return ticks / per_us;
+    }
+
+    // Ticks from this time to 'other', across a wrap.
+    constexpr inline uint16 __forceinline __flatten operator - (arg_type<time_ticks> other) const __restrict
+    {
+      return uint16(m_Value - other.m_Value);
+    }
+
+    // Ticks since this time, and whether there have been 'ticks' of them.
+    inline uint16 __forceinline __flatten since() const __restrict
+    {
+      return get() - *this;
+    }
+
+    inline bool __forceinline __flatten elapsed(arg_type<uint16> ticks) const __restrict
+    {
+      return since() >= ticks;
+    }
+
+    inline uint16 __forceinline __flatten since_us() const __restrict
+    {
+      return to_us(since());
+    }
+  };
 }
 
 namespace Tuna
@@ -21,8 +21,15 @@ namespace Tuna::debug
     template <bool tabulate = false, typename T, uint8 base = 10>
     char * int_to_string(char * __restrict buffer, arg_type<T> in_value)
     {
-      typename type_trait<T>::unsigned_type value = in_value;
       constexpr const bool is_signed = type_trait<T>::is_signed;
+      typename type_trait<T>::unsigned_type value = in_value;
+      if constexpr (is_signed && base == 10)
+      {
+        if (in_value < 0)
+        {
+          value = -value;
+        }
+      }
 
       static constexpr const char lookup[] = R"(0123456789ABCDEF)";
 
@@ -56,10 +63,24 @@ namespace Tuna::debug
         }
       };
 
-      while (value)
+      // Division is a library call on AVR, and a 16-bit one is a third the cost of a 32-bit one,
+      // so the digits that fit 16 bits are done in 16 bits.
+      if constexpr (sizeof(value) > sizeof(uint16))
+      {
+        while (value > type_trait<uint16>::max)
+        {
+          const uint8 idx = (value % base);
+          value /= base;
+
+          buffer[written++] = lookup[idx];
+        }
+      }
+
+      uint16 short_value = value;
+      while (short_value)
       {
-        const uint8 idx = (value % base);
-        value /= base;
+        const uint8 idx = (short_value % base);
+        short_value /= base;
 
         buffer[written++] = lookup[idx];
       }
@@ -80,6 +101,99 @@ namespace Tuna::debug
       buffer[written] = '\0';
       return &buffer[written];
     }
+
+    constexpr const float decimal_scale[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f };
+    constexpr const uint8 max_decimals = array_size(decimal_scale) - 1;
+
+    // Writes 'magnitude' / 10^decimals with all 'decimals' digits after the point.
+    inline char * decimal_to_string(char * __restrict buffer, uint32 magnitude, arg_type<bool> negative, arg_type<uint8> decimals)
+    {
+      char digits[12];
+      uint8 written = 0;
+
+      do
+      {
+        if (written == decimals && decimals != 0)
+        {
+          digits[written++] = '.';
+        }
+        if (magnitude > type_trait<uint16>::max)
+        {
+          digits[written++] = '0' + uint8(magnitude % 10);
+          magnitude /= 10;
+        }
+        else
+        {
+          uint16 short_magnitude = magnitude;
+          digits[written++] = '0' + uint8(short_magnitude % 10);
+          magnitude = short_magnitude / 10;
+        }
+      } while (magnitude || written <= decimals);
+
+      if (negative)
+      {
+        *buffer++ = '-';
+      }
+      while (written)
+      {
+        *buffer++ = digits[--written];
+      }
+      *buffer = '\0';
+      return buffer;
+    }
+  }
+
+  // The formatters below write a number and a terminating '\0' into 'buffer', and return a pointer
+  // to the '\0'. They take whole integers and a single rounding step rather than the digit-at-a-time
+  // float arithmetic of printf() and Print.
+
+  // 'value' with 'decimals' digits after the point, rounded half away from zero, as Print does.
+  // Returns nullptr when 'decimals' is over 6 or the scaled value doesn't fit 32 bits; the caller
+  // then has to take the slow path.
+  inline char * float_to_string(char * __restrict buffer, float value, arg_type<uint8> decimals)
+  {
+    if (__unlikely(decimals > _internal::max_decimals))
+    {
+      return nullptr;
+    }
+
+    const bool negative = value < 0.0f;
+    const float scaled = (negative ? -value : value) * _internal::decimal_scale[decimals] + 0.5f;
+    // Also false for nan.
+    if (__unlikely(!(scaled < 4294967040.0f)))
+    {
+      return nullptr;
+    }
+
+    const uint32 magnitude = uint32(scaled);
+    return _internal::decimal_to_string(buffer, magnitude, negative && magnitude != 0, decimals);
+  }
+
+  // A fixed-point value, such as temp_t, with 'decimals' digits after the point. It is converted
+  // with one multiply and shift of its raw value, without going through float.
+  template <typename T, uint8 fraction_bits>
+  inline char * fixed_to_string(char * __restrict buffer, arg_type<fixed<T, fraction_bits>> value, arg_type<uint8> decimals = 2)
+  {
+    static_assert(sizeof(T) <= sizeof(uint16), "fixed_to_string takes 8 and 16-bit fixed-point values");
+
+    constexpr const uint32 half = (1_u32 << fraction_bits) >> 1;
+    constexpr const uint16 scale[] = { 1, 10, 100, 1000 };
+
+    const auto raw = value.raw();
+    bool negative = false;
+    uint32 magnitude = raw;
+    if constexpr (type_trait<T>::is_signed)
+    {
+      if (raw < 0)
+      {
+        negative = true;
+        magnitude = uint32(-int32(raw));
+      }
+    }
+
+    const uint8 d = min(decimals, uint8(array_size(scale) - 1));
+    magnitude = ((magnitude * scale[d]) + half) >> fraction_bits;
+    return _internal::decimal_to_string(buffer, magnitude, negative && magnitude != 0, d);
   }
 
   namespace internal
@@ -195,6 +195,36 @@ namespace Tuna
     return retValue;
   }
 
+  // Reads a U from anywhere in flash, past the first 64 KiB as well: ELPM through RAMPZ:Z. Only
+  // needed for data the linker put that high, as the near reads are a cycle cheaper per byte and
+  // don't have to set RAMPZ. Get the address of a table with pgm_get_far_address().
+  template <typename U>
+  static inline __forceinline __flatten U read_pgm_far(uint32 address)
+  {
+    U retValue;
+    uint8 *retValuePtr = (uint8 *)&retValue;
+    uint16 ptr = uint16(address);
+#ifdef RAMPZ
+    RAMPZ = uint8(address >> 16);
+    for (uint8 i = 0; i < uint8(sizeof(U)); ++i)
+    {
+      __asm__ __volatile__
+      (
+        "elpm %0, Z+" "\n\t"
+        : "=r" (retValuePtr[i]), "=z" (ptr)
+        : "1" (ptr)
+      );
+    }
+#else
+    // All of flash is near
+    for (uint8 i = 0; i < uint8(sizeof(U)); ++i)
+    {
+      retValuePtr[i] = read_pgm_ptr<uint8>(ptr++);
+    }
+#endif
+    return retValue;
+  }
+
   template <typename U, typename T>
   static inline __forceinline __flatten U read_pgm(arg_type<flash_ptr<T>> value)
   {
@@ -395,6 +425,42 @@ namespace Tuna
     }
   };
 
+  // A table in flash, declared __flashmem and brace-initialized as a plain array would be. Indexing
+  // reads the element with LPM, or folds it at compile time when the index and the table are both
+  // constant, so lookups can't read the flash address out of SRAM by mistake as a plain array would.
+  template <typename T, usize N>
+  struct flash_array final
+  {
+    using type = T;
+    static constexpr const usize length = N;
+
+    T m_Data[N];
+
+    constexpr __forceinline __flatten T operator [] (arg_type<usize> index) const __restrict
+    {
+      if (__builtin_constant_p(index) && __builtin_constant_p(m_Data[index]))
+      {
+        return m_Data[index];
+      }
+      else
+      {
+        return read_pgm_ptr<T>(uint16(&m_Data[index]));
+      }
+    }
+
+    // The element at 'index' of a table linked past the first 64 KiB, at 'address' from
+    // pgm_get_far_address(table).
+    static inline __forceinline __flatten T far(arg_type<uint32> address, arg_type<usize> index)
+    {
+      return read_pgm_far<T>(address + uint32(index) * sizeof(T));
+    }
+
+    static constexpr __forceinline __flatten usize size()
+    {
+      return N;
+    }
+  };
+
   template<typename T, usize N>
   constexpr inline __forceinline __flatten usize array_size(T(& __restrict)[N])
   {
@@ -0,0 +1,87 @@
+#pragma once
+
+namespace Tuna::format
+{
+  namespace _internal
+  {
+    template <typename T>
+    constexpr uint8 digits(T value)
+    {
+      uint8 count = 1;
+      while (value >= 10)
+      {
+        value /= 10;
+        ++count;
+      }
+      return count;
+    }
+
+    // The most characters a part of type 'T' can take, known at compile time.
+    template <typename T>
+    struct max_length final : trait::ce_only
+    {
+      static_assert(type_trait<T>::is_integral, "format parts are flash strings, chars, integers, or fixed-point values");
+      static constexpr const usize value = (type_trait<T>::is_signed ? 1 : 0) + digits(type_trait<typename type_trait<T>::unsigned_type>::max);
+    };
+
+    template <usize N>
+    struct max_length<flash_char_array<N>> final : trait::ce_only
+    {
+      static constexpr const usize value = N;
+    };
+
+    template <>
+    struct max_length<char> final : trait::ce_only
+    {
+      static constexpr const usize value = 1;
+    };
+
+    // As written by debug::fixed_to_string(), with 2 decimals.
+    template <typename T, uint8 fraction_bits>
+    struct max_length<fixed<T, fraction_bits>> final : trait::ce_only
+    {
+      static constexpr const usize value = (type_trait<T>::is_signed ? 1 : 0) + digits(type_trait<T>::max >> fraction_bits) + 3;
+    };
+
+    template <usize N>
+    inline __forceinline __flatten char * append(char * __restrict buffer, arg_type<flash_char_array<N>> str)
+    {
+      memcpy_P(buffer, str.c_str(), N);
+      return buffer + N;
+    }
+
+    inline __forceinline __flatten char * append(char * __restrict buffer, arg_type<char> c)
+    {
+      *buffer = c;
+      return buffer + 1;
+    }
+
+    template <typename T, uint8 fraction_bits>
+    inline __forceinline __flatten char * append(char * __restrict buffer, arg_type<fixed<T, fraction_bits>> value)
+    {
+      return debug::fixed_to_string(buffer, value);
+    }
+
+    template <typename T>
+    inline __forceinline __flatten char * append(char * __restrict buffer, arg_type<T> value)
+    {
+      return debug::_internal::int_to_string<false, T>(buffer, value);
+    }
+  }
+
+  // Sends a line assembled from 'parts' in one serial write. The parts are "..."_p flash strings, chars,
+  // integers and fixed-point values; the stack buffer is sized at compile time from the longest each
+  // can be, so the whole response is formatted before the transmit buffer is touched.
+  template <uint8 Port = 0, typename... Parts>
+  inline void write(const Parts & __restrict ... parts)
+  {
+    constexpr const usize length = (_internal::max_length<Parts>::value + ... + 0);
+    static_assert(length <= type_trait<uint8>::max, "a formatted response is written with a uint8 length");
+
+    char buffer[length + 1]; // the number formatters end in '\0'
+    char * __restrict end = buffer;
+    ((end = _internal::append(end, parts)), ...);
+
+    serial<Port>::write((const char *)buffer, uint8(end - buffer));
+  }
+}
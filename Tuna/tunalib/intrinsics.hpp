@@ -1,7 +1,10 @@
 #pragma once
 
-// TODO add other platforms.
-#include "arch/avr.hpp"
+#if defined(__AVR__)
+# include "arch/avr.hpp"
+#else
+# include "arch/host.hpp"
+#endif
 
 namespace Tuna::intrinsic
 {
@@ -54,4 +57,46 @@ namespace Tuna::intrinsic
   {
     __builtin___clear_cache(begin, end);
   }
+
+  // (a * b) >> shift, exactly, for unsigned operands of up to 24 bits. The widths are the
+  // operands' types, and the result is the narrowest type that holds the largest result.
+  // A product that fits in 32 bits is a single multiply. avr-gcc widens any wider product to 64
+  // bits, a libgcc call of several hundred cycles. So wider ones with a shift of 16 to 32 are split
+  // into 16-bit low and 8-bit high parts instead: three 16-bit multiplies and an 8x8. The
+  // low parts' carries are taken up before the shift.
+  template <uint8 shift, typename A, typename B>
+  constexpr inline __forceinline __flatten auto mul_shift(arg_type<A> a, arg_type<B> b)
+  {
+    static_assert(type_trait<A>::is_unsigned && type_trait<B>::is_unsigned, "mul_shift is unsigned");
+    static_assert(type_trait<A>::bits <= 24 && type_trait<B>::bits <= 24, "mul_shift takes operands of up to 24 bits");
+
+    constexpr const uint64 max_product = uint64(type_trait<A>::max) * type_trait<B>::max;
+    using result_t = uintsz<(max_product >> shift)>;
+
+    if constexpr (max_product <= type_trait<uint32>::max)
+    {
+      return result_t((uint32(a) * b) >> shift);
+    }
+    else
+    {
+      static_assert(shift >= 16 && shift <= 32, "A product over 32 bits needs a shift of 16 to 32");
+
+      const uint16 a_low = uint16(a), b_low = uint16(b);
+      const uint8 a_high = uint8(uint32(a) >> 16), b_high = uint8(uint32(b) >> 16);
+
+      // Bits 16 and up: the top of the low product and the cross products, under 2^26
+      const uint32 middle = (uint32(a_low) * b_low >> 16) + uint32(a_high) * b_low + uint32(b_high) * a_low;
+      // Bits 32 and up, a multiple of 2^(shift - 16), so it's added after the shift
+      const uint16 high = uint16(uint16(a_high) * b_high);
+
+      return result_t((middle >> (shift - 16)) + (uint32(high) << (32 - shift)));
+    }
+  }
+
+  // The high half of a * b, in the operands' type: (a * b) >> 16 for uint16, >> 24 for uint24.
+  template <typename T>
+  constexpr inline __forceinline __flatten T mul_hi(arg_type<T> a, arg_type<T> b)
+  {
+    return T(mul_shift<type_trait<T>::bits, T, T>(a, b));
+  }
 }
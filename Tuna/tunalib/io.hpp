@@ -0,0 +1,225 @@
+#pragma once
+
+// Pins as compile-time groups. pins<X_ENABLE_PIN, Y_ENABLE_PIN, ...> sorts its pins by port when
+// it is instantiated, and sets, clears or toggles each port once:
+//  - a toggle writes the port's bits to its PIN register, which flips them in one store;
+//  - up to two bits of a port in I/O space (A to G) are set and cleared by SBI/CBI, one each;
+//  - anything else is a read-modify-write, in a critical section as WRITE() does above 0x100.
+// Pins are the Arduino numbers of the pins files, looked up through fastio's DIOn_ macros.
+namespace Tuna::io
+{
+  // A pin's registers, as data addresses, and its bit.
+  template <uint8 io> struct pin;
+
+#pragma push_macro("_MMIO_BYTE")
+#undef _MMIO_BYTE
+#define _MMIO_BYTE(mem_addr) (mem_addr)
+
+#define _TUNA_IO_PIN(N) \
+  template <> struct pin<N> final \
+  { \
+    static constexpr const uint16 input = DIO##N##_RPORT; \
+    static constexpr const uint16 output = DIO##N##_WPORT; \
+    static constexpr const uint16 direction = DIO##N##_DDR; \
+    static constexpr const uint8 mask = 1_u8 << uint8(DIO##N##_PIN); \
+  };
+#define _TUNA_IO_PINS10(D) \
+  _TUNA_IO_PIN(D##0) _TUNA_IO_PIN(D##1) _TUNA_IO_PIN(D##2) _TUNA_IO_PIN(D##3) _TUNA_IO_PIN(D##4) \
+  _TUNA_IO_PIN(D##5) _TUNA_IO_PIN(D##6) _TUNA_IO_PIN(D##7) _TUNA_IO_PIN(D##8) _TUNA_IO_PIN(D##9)
+
+#if AVR_ATmega2560_FAMILY
+  _TUNA_IO_PINS10() _TUNA_IO_PINS10(1) _TUNA_IO_PINS10(2) _TUNA_IO_PINS10(3)
+  _TUNA_IO_PINS10(4) _TUNA_IO_PINS10(5) _TUNA_IO_PINS10(6) _TUNA_IO_PINS10(7)
+  _TUNA_IO_PIN(80) _TUNA_IO_PIN(81) _TUNA_IO_PIN(82) _TUNA_IO_PIN(83) _TUNA_IO_PIN(84) _TUNA_IO_PIN(85)
+#else
+  #error "Tuna::io only knows the ATmega1280/2560's pins"
+#endif
+
+#undef _TUNA_IO_PINS10
+#undef _TUNA_IO_PIN
+#pragma pop_macro("_MMIO_BYTE")
+
+  namespace _internal
+  {
+    template <uint16 address>
+    inline __forceinline volatile uint8 & reg()
+    {
+      return *reinterpret_cast<volatile uint8 *>(address);
+    }
+
+    // SBI and CBI reach the first 32 I/O registers, data 0x20 to 0x3F.
+    constexpr bool bit_addressable(arg_type<uint16> address)
+    {
+      return address >= 0x20 && address < 0x40;
+    }
+
+    constexpr uint8 bit_count(uint8 mask)
+    {
+      uint8 count = 0;
+      for (; mask != 0; mask &= uint8(mask - 1))
+      {
+        ++count;
+      }
+      return count;
+    }
+
+    // Two SBIs are 4 cycles. Three would be 6, as much as IN, OR and OUT with SREG saved
+    // and restored around them, and that doesn't grow with the bits.
+    constexpr const uint8 max_bit_writes = 2;
+
+    template <uint16 address, uint8 mask>
+    inline __forceinline void set_bits()
+    {
+      if constexpr (mask == 0)
+      {
+      }
+      else if constexpr (bit_addressable(address) && bit_count(mask) <= max_bit_writes)
+      {
+        reg<address>() |= uint8(mask & -mask);
+        set_bits<address, uint8(mask & (mask - 1))>();
+      }
+      else
+      {
+        critical_section _critsec;
+        reg<address>() |= mask;
+      }
+    }
+
+    template <uint16 address, uint8 mask>
+    inline __forceinline void clear_bits()
+    {
+      if constexpr (mask == 0)
+      {
+      }
+      else if constexpr (bit_addressable(address) && bit_count(mask) <= max_bit_writes)
+      {
+        reg<address>() &= uint8(~uint8(mask & -mask));
+        clear_bits<address, uint8(mask & (mask - 1))>();
+      }
+      else
+      {
+        critical_section _critsec;
+        reg<address>() &= uint8(~mask);
+      }
+    }
+  }
+
+  template <uint8 ...ios>
+  class pins final
+  {
+    static_assert(sizeof...(ios) != 0, "a pin group needs a pin");
+
+    static constexpr const uint8 count = sizeof...(ios);
+    static constexpr const uint8 numbers[] = { ios... };
+    static constexpr const uint16 outputs[] = { pin<ios>::output... };
+    static constexpr const uint8 masks[] = { pin<ios>::mask... };
+
+    // The group's bits on the port at 'output'.
+    static constexpr uint8 port_mask(arg_type<uint16> output)
+    {
+      uint8 mask = 0;
+      for (uint8 i = 0; i < count; ++i)
+      {
+        if (outputs[i] == output)
+        {
+          mask |= masks[i];
+        }
+      }
+      return mask;
+    }
+
+    // Whether 'io' is the group's first pin on its port, which writes the whole port for the rest.
+    static constexpr bool leads(arg_type<uint8> io)
+    {
+      for (uint8 i = 0; i < count; ++i)
+      {
+        if (outputs[i] == outputs[index_of(io)])
+        {
+          return numbers[i] == io;
+        }
+      }
+      return false;
+    }
+
+    static constexpr uint8 index_of(arg_type<uint8> io)
+    {
+      for (uint8 i = 0; i < count; ++i)
+      {
+        if (numbers[i] == io)
+        {
+          return i;
+        }
+      }
+      return 0;
+    }
+
+    enum class op : uint8
+    {
+      set,
+      clear,
+      toggle,
+      output
+    };
+
+    template <op o, uint8 io>
+    static inline __forceinline void on_port()
+    {
+      if constexpr (leads(io))
+      {
+        constexpr const uint8 mask = port_mask(pin<io>::output);
+        if constexpr (o == op::set)
+        {
+          _internal::set_bits<pin<io>::output, mask>();
+        }
+        else if constexpr (o == op::clear)
+        {
+          _internal::clear_bits<pin<io>::output, mask>();
+        }
+        else if constexpr (o == op::toggle)
+        {
+          _internal::reg<pin<io>::input>() = mask;
+        }
+        else
+        {
+          _internal::set_bits<pin<io>::direction, mask>();
+        }
+      }
+    }
+
+  public:
+    pins() = delete;
+
+    static inline __forceinline void set()
+    {
+      (on_port<op::set, ios>(), ...);
+    }
+
+    static inline __forceinline void clear()
+    {
+      (on_port<op::clear, ios>(), ...);
+    }
+
+    static inline __forceinline void toggle()
+    {
+      (on_port<op::toggle, ios>(), ...);
+    }
+
+    static inline __forceinline void write(arg_type<bool> state)
+    {
+      if (state)
+      {
+        set();
+      }
+      else
+      {
+        clear();
+      }
+    }
+
+    // Makes every pin of the group an output.
+    static inline __forceinline void set_output()
+    {
+      (on_port<op::output, ios>(), ...);
+    }
+  };
+}
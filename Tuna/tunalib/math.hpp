@@ -52,4 +52,523 @@ namespace Tuna
       return result;
     }
   }
+
+  // 1 / sqrt() of a positive float, from the estimate that halving the exponent bits gives, and
+  // 'iterations' Newton steps of three multiplies each. It's good to 3.5% with none, 0.18% with
+  // one, and 5e-6 (a few float ulps) with two. That's cheaper than sqrt() and a divide, for
+  // normalizing a vector. 0 gives 0, not infinity, so a zero vector stays zero.
+  template <uint8 iterations = 2>
+  inline __forceinline __flatten float rsqrt(arg_type<float> value)
+  {
+    if (value <= 0.0f)
+    {
+      return 0.0f;
+    }
+    const float half = value * 0.5f;
+    float result = bitwise_as<float>(0x5F3759DF_u32 - (bitwise_as<uint32>(value) >> 1));
+    for (uint8 i = 0; i < iterations; ++i)
+    {
+      result *= 1.5f - (half * result * result);
+    }
+    return result;
+  }
+
+  // sqrt() as value / sqrt(value), to the precision of rsqrt().
+  template <uint8 iterations = 2>
+  inline __forceinline __flatten float fast_sqrt(arg_type<float> value)
+  {
+    return value * rsqrt<iterations>(value);
+  }
+
+  // sqrt() for constant expressions, such as tables built at compile time. Newton's steps fall
+  // towards the root from above, until they stop getting smaller.
+  constexpr inline float constexpr_sqrt(arg_type<float> value)
+  {
+    if (!(value > 0.0f))
+    {
+      return 0.0f;
+    }
+    float result = (value < 1.0f) ? 1.0f : value;
+    for (uint8 i = 0; i < 160; ++i)
+    {
+      const float next = 0.5f * (result + (value / result));
+      if (next >= result)
+      {
+        break;
+      }
+      result = next;
+    }
+    return result;
+  }
+
+  constexpr inline float constexpr_rsqrt(arg_type<float> value)
+  {
+    return (value > 0.0f) ? 1.0f / constexpr_sqrt(value) : 0.0f;
+  }
+
+  c_static_assert(constexpr_sqrt(0.0f) == 0.0f && constexpr_sqrt(4.0f) == 2.0f && constexpr_sqrt(0.25f) == 0.5f);
+  c_static_assert(constexpr_sqrt(1e6f) == 1000.0f && constexpr_rsqrt(16.0f) == 0.25f);
+
+  // Fixed-point logarithms and powers on Q16.16 values, for tables that would otherwise be
+  // built with soft-float pow(). Results are good to roughly 0.3%, which is far below a PWM step.
+  namespace fixed_math
+  {
+    constexpr const uint8 fraction_bits = 16;
+    constexpr const uint32 one = 1_u32 << fraction_bits;
+
+    // log2 of an unsigned Q16.16 'value', which must not be 0.
+    // The integer part comes from the position of the top bit. The fraction is taken one bit at a
+    // time: squaring a mantissa in [1, 2) doubles its logarithm, so each square that reaches 2
+    // yields a 1 bit.
+    constexpr inline int32 log2(arg_type<uint32> value)
+    {
+      __assume(value != 0);
+
+      int8 top_bit = 31;
+      while ((value & (1_u32 << top_bit)) == 0)
+      {
+        --top_bit;
+      }
+
+      // Mantissa as Q1.15.
+      uint32 mantissa = (top_bit >= 15) ? (value >> (top_bit - 15)) : (value << (15 - top_bit));
+      uint16 fraction = 0;
+      for (uint8 i = 0; i < fraction_bits; ++i)
+      {
+        mantissa = (mantissa * mantissa) >> 15;
+        fraction <<= 1;
+        if (mantissa >= (2_u32 << 15))
+        {
+          mantissa >>= 1;
+          fraction |= 1;
+        }
+      }
+
+      return (int32(top_bit - 15 - 1) << fraction_bits) + fraction;
+    }
+
+    // 2 to the power of a signed Q16.16 'exponent', as an unsigned Q16.16, saturating at the top.
+    // The fraction goes through a cubic fit of 2^f over [0, 1), exact at both ends.
+    constexpr inline uint32 exp2(arg_type<int32> exponent)
+    {
+      const int16 whole = int16(exponent >> fraction_bits);
+      const uint32 fraction = uint32(exponent) & (one - 1);
+
+      constexpr const uint32 c1 = 45579, c2 = 14883, c3 = 5074; // sum to 'one'
+      const uint32 power = one + ((fraction * (c1 + ((fraction * (c2 + ((fraction * c3) >> 16))) >> 16))) >> 16);
+
+      if (whole >= 0)
+      {
+        return (whole >= 16) ? type_trait<uint32>::max : (power << whole);
+      }
+      return (whole <= -18) ? 0 : (power >> -whole);
+    }
+
+    // 'base' to the power of 'exponent', both Q16.16, as an unsigned Q16.16.
+    constexpr inline uint32 pow(arg_type<uint32> base, arg_type<int32> exponent)
+    {
+      if (base == 0)
+      {
+        return (exponent > 0) ? 0 : ((exponent == 0) ? one : type_trait<uint32>::max);
+      }
+      return exp2(int32((int64(log2(base)) * exponent) >> fraction_bits));
+    }
+
+    constexpr inline int32 from_float(arg_type<float> value)
+    {
+      return int32(value * float(one) + ((value >= 0.0f) ? 0.5f : -0.5f));
+    }
+
+    namespace _internal
+    {
+      c_static_assert(log2(one) == 0);
+      c_static_assert(log2(one * 4) == int32(one * 2));
+      c_static_assert(log2(one / 2) == -int32(one));
+      c_static_assert(exp2(0) == one);
+      c_static_assert(exp2(-int32(one)) == one / 2);
+      c_static_assert(pow(one / 4, int32(one / 2)) == one / 2);
+    }
+
+    // Unsigned fixed-point arithmetic for the planner, on raw values with 'fraction' fraction
+    // bits: Q16.16 by default, or Q24.8 for distances and speeds that need the range. Results are
+    // truncated, and saturate at the top rather than wrapping.
+    namespace _internal
+    {
+      // The 64-bit product of 'a' and 'b', as two halves. avr-gcc would do this in libgcc's
+      // generic 64-bit multiply; this is the 16 byte products, each added in with its carries.
+      inline __forceinline __flatten void multiply(arg_type<uint32> a, arg_type<uint32> b, uint32 & __restrict low, uint32 & __restrict high)
+      {
+        if (__builtin_constant_p(a) && __builtin_constant_p(b))
+        {
+          const uint64 product = uint64(a) * b;
+          low = uint32(product);
+          high = uint32(product >> 32);
+          return;
+        }
+
+        uint8 zero;
+        __asm__
+        (
+          "clr %A[low]"                 "\n\t"
+          "clr %B[low]"                 "\n\t"
+          "clr %C[low]"                 "\n\t"
+          "clr %D[low]"                 "\n\t"
+          "clr %A[high]"                "\n\t"
+          "clr %B[high]"                "\n\t"
+          "clr %C[high]"                "\n\t"
+          "clr %D[high]"                "\n\t"
+          "clr %[zero]"                 "\n\t"
+          "mul %A[a], %A[b]"            "\n\t"
+          "add %A[low], r0"             "\n\t"
+          "adc %B[low], r1"             "\n\t"
+          "adc %C[low], %[zero]"        "\n\t"
+          "adc %D[low], %[zero]"        "\n\t"
+          "adc %A[high], %[zero]"       "\n\t"
+          "adc %B[high], %[zero]"       "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %A[a], %B[b]"            "\n\t"
+          "add %B[low], r0"             "\n\t"
+          "adc %C[low], r1"             "\n\t"
+          "adc %D[low], %[zero]"        "\n\t"
+          "adc %A[high], %[zero]"       "\n\t"
+          "adc %B[high], %[zero]"       "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %B[a], %A[b]"            "\n\t"
+          "add %B[low], r0"             "\n\t"
+          "adc %C[low], r1"             "\n\t"
+          "adc %D[low], %[zero]"        "\n\t"
+          "adc %A[high], %[zero]"       "\n\t"
+          "adc %B[high], %[zero]"       "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %A[a], %C[b]"            "\n\t"
+          "add %C[low], r0"             "\n\t"
+          "adc %D[low], r1"             "\n\t"
+          "adc %A[high], %[zero]"       "\n\t"
+          "adc %B[high], %[zero]"       "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %B[a], %B[b]"            "\n\t"
+          "add %C[low], r0"             "\n\t"
+          "adc %D[low], r1"             "\n\t"
+          "adc %A[high], %[zero]"       "\n\t"
+          "adc %B[high], %[zero]"       "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %C[a], %A[b]"            "\n\t"
+          "add %C[low], r0"             "\n\t"
+          "adc %D[low], r1"             "\n\t"
+          "adc %A[high], %[zero]"       "\n\t"
+          "adc %B[high], %[zero]"       "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %A[a], %D[b]"            "\n\t"
+          "add %D[low], r0"             "\n\t"
+          "adc %A[high], r1"            "\n\t"
+          "adc %B[high], %[zero]"       "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %B[a], %C[b]"            "\n\t"
+          "add %D[low], r0"             "\n\t"
+          "adc %A[high], r1"            "\n\t"
+          "adc %B[high], %[zero]"       "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %C[a], %B[b]"            "\n\t"
+          "add %D[low], r0"             "\n\t"
+          "adc %A[high], r1"            "\n\t"
+          "adc %B[high], %[zero]"       "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %D[a], %A[b]"            "\n\t"
+          "add %D[low], r0"             "\n\t"
+          "adc %A[high], r1"            "\n\t"
+          "adc %B[high], %[zero]"       "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %B[a], %D[b]"            "\n\t"
+          "add %A[high], r0"            "\n\t"
+          "adc %B[high], r1"            "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %C[a], %C[b]"            "\n\t"
+          "add %A[high], r0"            "\n\t"
+          "adc %B[high], r1"            "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %D[a], %B[b]"            "\n\t"
+          "add %A[high], r0"            "\n\t"
+          "adc %B[high], r1"            "\n\t"
+          "adc %C[high], %[zero]"       "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %C[a], %D[b]"            "\n\t"
+          "add %B[high], r0"            "\n\t"
+          "adc %C[high], r1"            "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %D[a], %C[b]"            "\n\t"
+          "add %B[high], r0"            "\n\t"
+          "adc %C[high], r1"            "\n\t"
+          "adc %D[high], %[zero]"       "\n\t"
+          "mul %D[a], %D[b]"            "\n\t"
+          "add %C[high], r0"            "\n\t"
+          "adc %D[high], r1"            "\n\t"
+          "clr __zero_reg__"            "\n\t"
+          : [low] "=&r" (low), [high] "=&r" (high), [zero] "=&r" (zero)
+          : [a] "r" (a), [b] "r" (b)
+          : "r0"
+        );
+      }
+    }
+
+    // 'a' times 'b'.
+    template <uint8 fraction = fraction_bits>
+    inline __forceinline __flatten uint32 mul(arg_type<uint32> a, arg_type<uint32> b)
+    {
+      static_assert(fraction >= 1 && fraction < 32, "fraction must be 1 to 31 bits");
+
+      uint32 low, high;
+      _internal::multiply(a, b, low, high);
+      if ((high >> fraction) != 0)
+      {
+        return type_trait<uint32>::max;
+      }
+      return (high << (32 - fraction)) | (low >> fraction);
+    }
+
+    // 1 / 'value'. 1 / 0, and a result past the top, give the largest value.
+    template <uint8 fraction = fraction_bits>
+    constexpr inline uint32 reciprocal(arg_type<uint32> value)
+    {
+      static_assert(fraction >= 1 && fraction <= 16, "fraction must be 1 to 16 bits");
+
+      if (value <= 1)
+      {
+        return (value == 1 && fraction < 16) ? (type_trait<uint32>::max >> (32 - (fraction * 2))) + 1 : type_trait<uint32>::max;
+      }
+      if constexpr (fraction < 16)
+      {
+        return (1_u32 << (fraction * 2)) / value;
+      }
+      else
+      {
+        // 2^32 doesn't fit, but it's one more than the largest value: fix the quotient up
+        // when that one is what makes the division come out even
+        const uint32 quotient = type_trait<uint32>::max / value;
+        const uint32 remainder = type_trait<uint32>::max - (quotient * value);
+        return (remainder + 1 == value) ? quotient + 1 : quotient;
+      }
+    }
+
+    // The square root of an integer, rounded down. Two bits of the value at a time, with no
+    // multiplies.
+    constexpr inline uint16 isqrt(arg_type<uint32> value)
+    {
+      uint32 remainder = value;
+      uint32 root = 0;
+      uint32 bit = 1_u32 << 30;
+      while (bit > value)
+      {
+        bit >>= 2;
+      }
+      for (; bit != 0; bit >>= 2)
+      {
+        if (remainder >= root + bit)
+        {
+          remainder -= root + bit;
+          root = (root >> 1) + bit;
+        }
+        else
+        {
+          root >>= 1;
+        }
+      }
+      return uint16(root);
+    }
+
+    // isqrt() on 24 bits, for step counts and rates: three-byte arithmetic, and 12 steps at most.
+    constexpr inline uint16 isqrt24(arg_type<uint24> value)
+    {
+      uint24 remainder = value;
+      uint24 root = 0;
+      uint24 bit = uint24(1) << 22;
+      while (bit > value)
+      {
+        bit >>= 2;
+      }
+      for (; bit != 0; bit >>= 2)
+      {
+        if (remainder >= root + bit)
+        {
+          remainder -= root + bit;
+          root = (root >> 1) + bit;
+        }
+        else
+        {
+          root >>= 1;
+        }
+      }
+      return uint16(root);
+    }
+
+    // The square root of 'value', rounded down. This is isqrt() of 'value' shifted up by
+    // 'fraction' bits, with the bits below 'value' taken as 0, so the root keeps 'fraction' bits
+    // while the remainder stays within 32 bits.
+    template <uint8 fraction = fraction_bits>
+    constexpr inline uint32 sqrt(arg_type<uint32> value)
+    {
+      static_assert(fraction >= 2 && fraction <= 24 && (fraction % 2) == 0, "fraction must be an even 2 to 24 bits");
+
+      constexpr const uint8 steps = (32 + fraction) / 2;
+      uint32 remainder = 0;
+      uint32 root = 0;
+      for (uint8 i = 0; i < steps; ++i)
+      {
+        const uint8 pair = (i < 16) ? uint8((value >> (30 - (i * 2))) & 3) : 0;
+        remainder = (remainder << 2) | pair;
+        const uint32 trial = (root << 2) | 1;
+        root <<= 1;
+        if (remainder >= trial)
+        {
+          remainder -= trial;
+          root |= 1;
+        }
+      }
+      return root;
+    }
+
+    // The rounded integer of 'value', saturating at the largest uint24 for step counts and rates.
+    template <uint8 fraction = fraction_bits>
+    constexpr inline uint24 to_uint24(arg_type<uint32> value)
+    {
+      static_assert(fraction >= 1 && fraction < 32, "fraction must be 1 to 31 bits");
+
+      constexpr const uint32 top = uint32(type_trait<uint24>::max);
+      const uint32 whole = (value >> fraction) + ((value >> (fraction - 1)) & 1);
+      return uint24(min(whole, top));
+    }
+
+    // As above, with negative values giving 0.
+    template <uint8 fraction = fraction_bits>
+    constexpr inline uint24 to_uint24(arg_type<int32> value)
+    {
+      return (value <= 0) ? uint24(0) : to_uint24<fraction>(uint32(value));
+    }
+
+    // The same on Tuna::fixed values.
+    template <uint8 N>
+    inline __forceinline __flatten fixed<uint32, N> mul(arg_type<fixed<uint32, N>> a, arg_type<fixed<uint32, N>> b)
+    {
+      return fixed<uint32, N>::from(mul<N>(a.raw(), b.raw()));
+    }
+
+    template <uint8 N>
+    constexpr inline fixed<uint32, N> reciprocal(arg_type<fixed<uint32, N>> value)
+    {
+      return fixed<uint32, N>::from(reciprocal<N>(value.raw()));
+    }
+
+    template <uint8 N>
+    constexpr inline fixed<uint32, N> sqrt(arg_type<fixed<uint32, N>> value)
+    {
+      return fixed<uint32, N>::from(sqrt<N>(value.raw()));
+    }
+
+    template <uint8 N>
+    constexpr inline uint24 to_uint24(arg_type<fixed<uint32, N>> value)
+    {
+      return to_uint24<N>(value.raw());
+    }
+
+    namespace _internal
+    {
+      c_static_assert(reciprocal(one) == one);
+      c_static_assert(reciprocal(one * 4) == one / 4);
+      c_static_assert(reciprocal(2) == 1_u32 << 31);
+      c_static_assert(reciprocal<8>(1_u32 << 8) == 1_u32 << 8);
+      c_static_assert(isqrt(0) == 0 && isqrt(15) == 3 && isqrt(16) == 4 && isqrt(type_trait<uint32>::max) == 65535);
+      c_static_assert(isqrt24(0) == 0 && isqrt24(99) == 9 && isqrt24(100) == 10 && isqrt24(type_trait<uint24>::max) == 4095);
+      c_static_assert(sqrt(one * 4) == one * 2);
+      c_static_assert(sqrt(one / 4) == one / 2);
+      c_static_assert(sqrt<8>(100_u32 << 8) == 10_u32 << 8);
+      c_static_assert(to_uint24(one + one / 2) == 2 && to_uint24<8>(type_trait<uint32>::max) == type_trait<uint24>::max);
+      c_static_assert(to_uint24(-int32(one)) == 0);
+    }
+
+    // CORDIC rotations of int32 vectors, for arcs without sin(), cos() or atan2(). Angles are
+    // binary fractions of a turn, 2^32 being 360 degrees, so they wrap as a uint32 does. Each
+    // step is a shift and an add; the steps are unrolled, so the shifts are constants.
+    // The vector comes out 'gain' (1.6468) times longer, so scale it by inverse_gain before a
+    // rotation that has to keep its length. Components must stay under 2^31 / gain.
+    namespace cordic
+    {
+      using angle_t = uint32;
+
+      constexpr const uint8 steps = 24;                           // to within 2^-23 radians
+      constexpr const float inverse_gain = 0.60725293f;
+      constexpr const float radians_to_angle = 683565275.58f;     // 2^32 / 2pi
+      constexpr const float angle_to_radians = 1.0f / radians_to_angle;
+
+      namespace _internal
+      {
+        // atan(2^-i) as angle_t
+        constexpr const int32 atan_table[steps] = {
+          536870912, 316933406, 167458907, 85004756, 42667331, 21354465, 10679838, 5340245,
+          2670163, 1335087, 667544, 333772, 166886, 83443, 41722, 20861,
+          10430, 5215, 2608, 1304, 652, 326, 163, 81
+        };
+
+        // Turns (x, y) by atan(2^-i) at a time, towards 'z' at 0 (rotating) or 'y' at 0 (vectoring).
+        // 'z' keeps the angle still to turn, or the angle turned through.
+        template <bool vectoring, uint8 i = 0>
+        inline __forceinline __flatten void turn(int32 & __restrict x, int32 & __restrict y, int32 & __restrict z)
+        {
+          const int32 dx = y >> i, dy = x >> i;
+          if (vectoring ? (y > 0) : (z < 0))
+          {
+            // clockwise
+            x += dx; y -= dy; z += atan_table[i];
+          }
+          else
+          {
+            x -= dx; y += dy; z -= atan_table[i];
+          }
+          if constexpr (i + 1 < steps)
+          {
+            turn<vectoring, i + 1>(x, y, z);
+          }
+        }
+      }
+
+      // Turns (x, y) counterclockwise by 'angle'.
+      inline void rotate(int32 & __restrict x, int32 & __restrict y, arg_type<angle_t> angle)
+      {
+        // The steps converge within about 90 degrees, so the far half turn starts with a flip.
+        int32 z = int32(angle);
+        if (angle_t(angle + (1_u32 << 30)) >= (1_u32 << 31))
+        {
+          x = -x;
+          y = -y;
+          z = int32(angle + (1_u32 << 31));
+        }
+        _internal::turn<false>(x, y, z);
+      }
+
+      // The angle of (x, y), which leaves x as its length times the gain and y near 0.
+      inline angle_t vector(int32 & __restrict x, int32 & __restrict y)
+      {
+        angle_t base = 0;
+        if (x < 0)
+        {
+          x = -x;
+          y = -y;
+          base = 1_u32 << 31;
+        }
+        int32 z = 0;
+        _internal::turn<true>(x, y, z);
+        return base + angle_t(z);
+      }
+    }
+  }
 }
@@ -0,0 +1,120 @@
+#pragma once
+
+namespace Tuna::parse
+{
+  namespace _internal
+  {
+    // Powers of ten that a float holds exactly (5^10 < 2^24).
+    constexpr const float exact_pow10[] = { 1e0f, 1e1f, 1e2f, 1e3f, 1e4f, 1e5f, 1e6f, 1e7f, 1e8f, 1e9f, 1e10f };
+    constexpr const uint8 max_pow10 = array_size(exact_pow10) - 1;
+
+    // Digits that always fit in the uint32 accumulator.
+    constexpr const uint8 max_digits = 9;
+
+    inline __forceinline __flatten bool is_digit(arg_type<char> c)
+    {
+      return uint8(c - '0') < 10;
+    }
+
+    // Skips leading blanks and reads the sign, as strtod() and strtol() do.
+    inline __forceinline __flatten bool read_sign(const char * __restrict & p)
+    {
+      while (*p == ' ' || *p == '\t') ++p;
+      const bool negative = (*p == '-');
+      if (negative || *p == '+') ++p;
+      return negative;
+    }
+  }
+
+  // Reads a G-code number, [+-]digits[.digits], into a float in one pass. There is no exponent,
+  // hex, inf or nan, so a following 'E' parameter ends the number. The first 9 significant digits
+  // go into a uint32, which is converted and scaled once by an exact power of ten; with up to 7
+  // significant digits, which is all a float holds, the result is the correctly rounded value
+  // strtod() gives. 'end' is set to the first character after the number.
+  inline float decimal(const char * __restrict p, const char * __restrict & end)
+  {
+    using namespace _internal;
+
+    const bool negative = read_sign(p);
+
+    uint32 mantissa = 0;
+    uint8 digits = 0;             // significant digits in 'mantissa'
+    int8 scale = 0;               // power of ten 'mantissa' is multiplied by
+
+    for (; is_digit(*p); ++p)
+    {
+      if (digits < max_digits)
+      {
+        mantissa = (mantissa * 10) + uint8(*p - '0');
+        digits += (mantissa != 0);
+      }
+      else if (scale < 38)
+      {
+        ++scale;
+      }
+    }
+
+    if (*p == '.')
+    {
+      for (++p; is_digit(*p); ++p)
+      {
+        if (digits < max_digits && scale > -45)
+        {
+          mantissa = (mantissa * 10) + uint8(*p - '0');
+          digits += (mantissa != 0);
+          --scale;
+        }
+      }
+    }
+
+    end = p;
+
+    float value = float(mantissa);
+    if (scale < 0)
+    {
+      for (; scale < -int8(max_pow10); scale += max_pow10)
+      {
+        value /= exact_pow10[max_pow10];
+      }
+      value /= exact_pow10[-scale];
+    }
+    else if (scale > 0)
+    {
+      for (; scale > int8(max_pow10); scale -= max_pow10)
+      {
+        value *= exact_pow10[max_pow10];
+      }
+      value *= exact_pow10[scale];
+    }
+
+    return negative ? -value : value;
+  }
+
+  inline float decimal(const char * __restrict p)
+  {
+    const char * end;
+    return decimal(p, end);
+  }
+
+  // Reads [+-]digits as strtol(p, nullptr, 10) does, without its overflow clamping.
+  inline int32 integer(const char * __restrict p)
+  {
+    using namespace _internal;
+
+    const bool negative = read_sign(p);
+
+    uint32 value = 0;
+    for (; is_digit(*p); ++p)
+    {
+      value = (value * 10) + uint8(*p - '0');
+    }
+
+    return negative ? -int32(value) : int32(value);
+  }
+
+  // As strtoul(p, nullptr, 10), which also takes a minus sign and negates the result.
+  inline uint32 unsigned_integer(const char * __restrict p)
+  {
+    return uint32(integer(p));
+  }
+}
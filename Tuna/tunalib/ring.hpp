@@ -0,0 +1,167 @@
+#pragma once
+
+namespace Tuna
+{
+  // Index arithmetic for a ring buffer of 'N' entries.
+  // Power-of-two sizes wrap with a mask. Any other size wraps by subtracting N under a mask
+  // built from the comparison, so neither variant branches.
+  template <usize N>
+  struct ring_index final : trait::ce_only
+  {
+    static_assert(N >= 2, "A ring needs at least two entries");
+
+    using type = uintsz<N - 1>;
+
+    static constexpr const usize size = N;
+    static constexpr const bool is_pow2 = constant::is_pow2<N>;
+
+  private:
+    // Wide enough to hold any sum of two indices.
+    using calc_t = uintsz<(N - 1) * 2>;
+
+    // Brings a value in [0, 2N) back into [0, N).
+    static constexpr inline __forceinline __flatten type wrap(arg_type<calc_t> value)
+    {
+      if constexpr (is_pow2)
+      {
+        return type(value & (N - 1));
+      }
+      else
+      {
+        return type(value - (calc_t(N) & calc_t(-calc_t(value >= N))));
+      }
+    }
+
+  public:
+    static constexpr inline __forceinline __flatten type next(arg_type<type> index)
+    {
+      return wrap(calc_t(index) + 1);
+    }
+
+    static constexpr inline __forceinline __flatten type prev(arg_type<type> index)
+    {
+      return wrap(calc_t(index) + (N - 1));
+    }
+
+    // 'count' must be less than N.
+    static constexpr inline __forceinline __flatten type advance(arg_type<type> index, arg_type<type> count)
+    {
+      return wrap(calc_t(index) + count);
+    }
+
+    // Number of entries from 'from' up to, but not including, 'to'.
+    static constexpr inline __forceinline __flatten type distance(arg_type<type> from, arg_type<type> to)
+    {
+      return wrap(calc_t(to) + (N - from));
+    }
+  };
+
+  // As ring_index, for a ring whose size is only known at run time and is read from 'Size'.
+  // 'Size' must be set, to between 2 and 255, before the ring is used, and not change while it
+  // holds entries. Wraps by a comparison rather than a mask.
+  template <const uint8 & Size>
+  struct runtime_ring_index final : trait::ce_only
+  {
+    using type = uint8;
+
+    static inline __forceinline __flatten type size() { return Size; }
+
+  private:
+    // Brings a value in [0, 2 * Size) back into [0, Size).
+    static inline __forceinline __flatten type wrap(arg_type<uint16> value)
+    {
+      return type((value >= Size) ? (value - Size) : value);
+    }
+
+  public:
+    static inline __forceinline __flatten type next(arg_type<type> index)
+    {
+      const type result = index + 1;
+      return (result == Size) ? 0 : result;
+    }
+
+    static inline __forceinline __flatten type prev(arg_type<type> index)
+    {
+      return (index == 0) ? type(Size - 1) : type(index - 1);
+    }
+
+    // 'count' must be less than Size.
+    static inline __forceinline __flatten type advance(arg_type<type> index, arg_type<type> count)
+    {
+      return wrap(uint16(index) + count);
+    }
+
+    // Number of entries from 'from' up to, but not including, 'to'.
+    static inline __forceinline __flatten type distance(arg_type<type> from, arg_type<type> to)
+    {
+      return wrap(uint16(to) + (Size - from));
+    }
+  };
+
+  // The shared indices of a ring with one producer and one consumer, such as a ring filled by the
+  // main loop and drained by an interrupt. Each side writes only its own index, and each index is a
+  // single byte, so neither side has to disable interrupts to use it. The producer fills the entry at
+  // head() and then push()es it; the consumer is done with the entry at tail() before it pop()s it.
+  // The barriers keep the compiler from moving accesses to the entry across the publishing store.
+  // 'Ring' is the index arithmetic; spsc_ring<N> is the usual ring of N entries.
+  template <typename Ring>
+  struct spsc_ring_of final
+  {
+    using ring = Ring;
+    using type = typename ring::type;
+
+    static_assert(sizeof(type) == 1, "Both sides must read and write the indices atomically");
+
+  private:
+    volatile type head_ = 0;
+    volatile type tail_ = 0;
+
+  public:
+    inline __forceinline __flatten type head() const { return head_; }
+    inline __forceinline __flatten type tail() const { return tail_; }
+
+    inline __forceinline __flatten bool empty() const { return head_ == tail_; }
+    inline __forceinline __flatten bool full() const { return ring::next(head_) == tail_; }
+    inline __forceinline __flatten type count() const { return ring::distance(tail_, head_); }
+
+    // Producer: publishes the entry at head().
+    inline __forceinline __flatten void push()
+    {
+      __memorybarrier;
+      head_ = ring::next(head_);
+    }
+
+    // Consumer: releases the entry at tail().
+    inline __forceinline __flatten void pop()
+    {
+      __memorybarrier;
+      tail_ = ring::next(tail_);
+    }
+
+    // Only safe while the consumer is stopped.
+    inline __forceinline __flatten void clear()
+    {
+      head_ = 0;
+      tail_ = 0;
+    }
+
+    // Makes the entries from 'tail' up to 'head' the ring's. Only safe while the consumer is stopped.
+    inline __forceinline __flatten void reset(arg_type<type> tail, arg_type<type> head)
+    {
+      tail_ = tail;
+      head_ = head;
+    }
+  };
+
+  template <usize N>
+  using spsc_ring = spsc_ring_of<ring_index<N>>;
+
+  namespace _internal
+  {
+    c_static_assert(ring_index<24>::next(23) == 0);
+    c_static_assert(ring_index<24>::prev(0) == 23);
+    c_static_assert(ring_index<24>::distance(20, 4) == 8);
+    c_static_assert(ring_index<32>::distance(4, 20) == 16);
+    c_static_assert(ring_index<32>::advance(30, 3) == 1);
+  }
+}
@@ -0,0 +1,128 @@
+#pragma once
+
+namespace Tuna
+{
+  // A fixed set of periodic tasks polled from the main loop. 'Task' is an enum of the slots, ending
+  // in 'count', in priority order: when several are due, the first runs first. Each slot holds a
+  // callback, a period in milliseconds, where 0 stops it, and a budget in microseconds, what the
+  // task may take. poll() only starts a task if its budget still fits in what's left of the pass,
+  // so a slow pass pushes the rest to the next one rather than holding up the commands; a budget
+  // of 0 is never pushed back, for tasks that have to keep their cadence.
+  // poll() keeps the earliest deadline, so a pass with nothing due costs one comparison.
+  // Periods must be below 2^31 ms, as deadlines are compared by their signed difference.
+  // running() is the task in its callback, or 'size' between them, for the watchdog to report.
+  template <typename Task>
+  class scheduler final
+  {
+  public:
+    using callback_t = void (*)();
+    using time_t = chrono::time_ms32;
+
+    static constexpr const uint8 size = uint8(Task::count);
+
+  private:
+    struct slot final
+    {
+      callback_t callback = nullptr;
+      uint32 period = 0;
+      time_t due;
+      uint16 budget_us = 0;
+    };
+
+    slot m_Slots[size];
+    time_t m_NextDue;
+    bool m_Active = false;
+    volatile uint8 m_Running = size;
+
+    static inline __forceinline __flatten bool reached(arg_type<time_t> now, arg_type<time_t> due)
+    {
+      return int32(now.raw() - due.raw()) >= 0;
+    }
+
+    void update_next_due() __restrict
+    {
+      m_Active = false;
+      for (const slot & __restrict s : m_Slots)
+      {
+        if (!s.period)
+        {
+          continue;
+        }
+        if (!m_Active || int32(s.due.raw() - m_NextDue.raw()) < 0)
+        {
+          m_NextDue = s.due;
+          m_Active = true;
+        }
+      }
+    }
+
+  public:
+    uint8 running() const __restrict
+    {
+      return m_Running;
+    }
+
+    // Runs 'callback' every 'period_ms', the first time 'period_ms' from now.
+    void set(arg_type<Task> task, callback_t callback, arg_type<uint32> period_ms, arg_type<uint16> budget_us = 0) __restrict
+    {
+      slot & __restrict s = m_Slots[uint8(task)];
+      s.callback = callback;
+      s.period = period_ms;
+      s.due = time_t::get().raw() + period_ms;
+      s.budget_us = budget_us;
+      update_next_due();
+    }
+
+    // Changes the period of a task, keeping its callback and budget. The next run is 'period_ms' from now.
+    void set_period(arg_type<Task> task, arg_type<uint32> period_ms) __restrict
+    {
+      set(task, m_Slots[uint8(task)].callback, period_ms, m_Slots[uint8(task)].budget_us);
+    }
+
+    void stop(arg_type<Task> task) __restrict
+    {
+      set_period(task, 0);
+    }
+
+    // Runs the tasks that are due, within 'pass_budget_us' for those with a budget.
+    void poll(arg_type<uint16> pass_budget_us = type_trait<uint16>::max) __restrict
+    {
+      if (__likely(!m_Active))
+      {
+        return;
+      }
+
+      const time_t now = time_t::now();
+      if (__likely(!reached(now, m_NextDue)))
+      {
+        return;
+      }
+
+      const chrono::time_ticks start = chrono::time_ticks::get();
+      for (slot & __restrict s : m_Slots)
+      {
+        if (!s.period || !reached(now, s.due))
+        {
+          continue;
+        }
+        // Still due, so it's first in line next pass
+        if (s.budget_us && uint32(start.since_us()) + s.budget_us > pass_budget_us)
+        {
+          continue;
+        }
+        // Keep to the period, but after a stall (a blocking move, a long G-code) run once and
+        // start over rather than catching up on every missed run.
+        s.due = s.due.raw() + s.period;
+        if (reached(now, s.due))
+        {
+          s.due = now.raw() + s.period;
+        }
+        m_Running = uint8(&s - m_Slots);
+        s.callback();
+        m_Running = size;
+      }
+
+      update_next_due();
+    }
+  };
+}
@@ -0,0 +1,100 @@
+#pragma once
+
+namespace Tuna
+{
+  // One static block for short-lived buffers, taken from the top like a second stack. A buffer is
+  // given back as its scope ends, so they come back in the reverse order they were taken, and the
+  // arena is empty again between the idle tasks that use it. Buffers that are never in use at the
+  // same time share the same bytes, where each would otherwise be a static of its own.
+  template <usize Size>
+  class scratch_arena final
+  {
+    uint8 m_Data[Size];
+    usize m_Top = 0;
+    usize m_Peak = 0;
+
+  public:
+    static constexpr const usize size = Size;
+
+    scratch_arena() = default;
+    scratch_arena(const scratch_arena &) = delete;
+    scratch_arena & operator = (const scratch_arena &) = delete;
+
+    // 'bytes' from the top, or nullptr if they don't fit.
+    inline __forceinline __flatten uint8 *take(arg_type<usize> bytes)
+    {
+      if (__unlikely(bytes > Size - m_Top))
+      {
+        return nullptr;
+      }
+      uint8 * const data = m_Data + m_Top;
+      m_Top += bytes;
+      if (m_Top > m_Peak)
+      {
+        m_Peak = m_Top;
+      }
+      return data;
+    }
+
+    // Gives back 'data', which take() returned, and everything taken after it.
+    inline __forceinline __flatten void release(const uint8 *data)
+    {
+      m_Top = usize(data - m_Data);
+    }
+
+    inline __forceinline __flatten usize used() const
+    {
+      return m_Top;
+    }
+
+    // The most that was ever taken at once.
+    inline __forceinline __flatten usize peak() const
+    {
+      return m_Peak;
+    }
+  };
+
+  // Called when 'arena' has no room for a scratch buffer. The firmware defines it; a buffer that
+  // doesn't fit is a bug, as the arena is sized for the buffers that can be taken at once.
+  void scratch_full();
+
+  // N 'T's from 'arena' for the scope it's declared in.
+  template <typename T, usize N, auto &arena>
+  class scratch final
+  {
+    static_assert(sizeof(T) * N <= arena.size, "The buffer is larger than the arena");
+
+    T * __restrict m_Data;
+
+  public:
+    static constexpr const usize count = N;
+
+    scratch(const scratch &) = delete;
+    scratch(scratch &&) = delete;
+    scratch & operator = (const scratch &) = delete;
+    scratch & operator = (scratch &&) = delete;
+
+    inline __forceinline __flatten scratch() : m_Data(reinterpret_cast<T *>(arena.take(sizeof(T) * N)))
+    {
+      if (__unlikely(!m_Data))
+      {
+        scratch_full();
+      }
+    }
+
+    inline __forceinline __flatten ~scratch()
+    {
+      arena.release(reinterpret_cast<const uint8 *>(m_Data));
+    }
+
+    inline __forceinline __flatten T *data() const
+    {
+      return m_Data;
+    }
+
+    inline __forceinline __flatten operator T * () const
+    {
+      return m_Data;
+    }
+  };
+}
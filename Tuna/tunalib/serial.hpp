@@ -11,37 +11,111 @@
 
 namespace Tuna
 {
+  // The baud rates HardwareSerial::begin() gets in double speed (U2X) mode, where
+  // UBRR = F_CPU / (8 * baud) - 1, rounded. At 16 MHz, 250000, 500000 and 1000000
+  // are exact, 115200 is 2.1% fast and 230400 is 3.5% slow.
+  namespace uart
+  {
+    constexpr const uint32 min_baud = 2400;
+    constexpr const uint32 max_baud = F_CPU / 8;
+
+    // An 8N1 frame stays readable with up to about 2.5% between the two ends.
+    constexpr const int16 max_error_permille = 25;
+
+    constexpr inline uint16 ubrr(arg_type<uint32> baud)
+    {
+      return uint16(((F_CPU / 4 / baud) - 1) / 2);
+    }
+
+    constexpr inline uint32 actual_baud(arg_type<uint32> baud)
+    {
+      return F_CPU / 8 / (uint32(ubrr(baud)) + 1);
+    }
+
+    // How far the real rate is from 'baud', in tenths of a percent.
+    constexpr inline int16 error_permille(arg_type<uint32> baud)
+    {
+      return int16(((int32(actual_baud(baud)) - int32(baud)) * 1000) / int32(baud));
+    }
+
+    constexpr inline bool usable(arg_type<uint32> baud)
+    {
+      return baud >= min_baud && baud <= max_baud &&
+        error_permille(baud) <= max_error_permille && error_permille(baud) >= -max_error_permille;
+    }
+
+    namespace _internal
+    {
+#if F_CPU == 16000000UL
+      c_static_assert(error_permille(250000) == 0 && error_permille(500000) == 0 && error_permille(1000000) == 0);
+      c_static_assert(error_permille(115200) == 21 && usable(115200));
+      c_static_assert(!usable(230400));
+#endif
+    }
+  }
+
+  // serial<usb_port> is the native USB (CDC) port of an MCU that has one.
+  constexpr const uint8 usb_port = type_trait<uint8>::max;
+  // The port the host is on: SERIAL_PORT, where -1 is native USB.
+  constexpr const uint8 host_port = (SERIAL_PORT < 0) ? usb_port : uint8(SERIAL_PORT);
+
   template <uint8 SerialNumber = 0>
   struct serial final : trait::ce_only
   {
-#if defined(SerialUSB)
-    constexpr static const uint8 USB = type_trait<uint8>::max;
-#endif
+    constexpr static const uint8 USB = usb_port;
 
     constexpr static const uint8 number = SerialNumber;
 
+    // Each port is its own HardwareSerial type, sized by its SERIALn_RX/TX_BUFFER_SIZE.
     constexpr static __forceinline __flatten auto & __restrict get_serial_device()
     {
-      switch (number)
+      if constexpr (false) {}
+#if defined(HAVE_HWSERIAL0)
+      else if constexpr (number == 0)
       {
-      case 0:
         return Serial;
-      case 1:
+      }
+#endif
+#if defined(HAVE_HWSERIAL1)
+      else if constexpr (number == 1)
+      {
         return Serial1;
-      case 2:
+      }
+#endif
+#if defined(HAVE_HWSERIAL2)
+      else if constexpr (number == 2)
+      {
         return Serial2;
-      case 3:
+      }
+#endif
+#if defined(HAVE_HWSERIAL3)
+      else if constexpr (number == 3)
+      {
         return Serial3;
+      }
+#endif
 #if defined(SerialUSB)
-      case USB:
+      else if constexpr (number == USB)
+      {
         return SerialUSB;
+      }
+#elif defined(USBCON)
+      else if constexpr (number == USB)
+      {
+        return Serial; // the core's CDC port
+      }
 #endif
+      else
+      {
+        static_assert(number != number, "This serial port isn't built: give it a SERIALn_RX_BUFFER_SIZE");
       }
     }
 
+    // USB takes the rate the host asks for, and transfers at full speed regardless.
     template <uint32 baud>
     static inline __forceinline __flatten void begin()
     {
+      static_assert(number == USB || uart::usable(baud), "This baud rate is more than 2.5% off at F_CPU");
       get_serial_device().begin(baud);
     }
 
@@ -96,6 +170,40 @@ namespace Tuna
       return uint8(min(get_serial_device().available(), 255)) >= length;
     }
 
+    // Whether write() can take 'length' bytes without waiting for the transmit buffer to drain.
+    static inline __forceinline __flatten bool writable(uint8 length)
+    {
+      return get_serial_device().availableForWrite() >= length;
+    }
+
+    // Whether anything is waiting to be read. While the port is idle, this is one test of its
+    // serial_rx_pending bit; the bit is only cleared once the buffer is found empty.
+    static inline __forceinline __flatten bool rx_pending()
+    {
+      if constexpr (number == USB)
+      {
+        return get_serial_device().available() > 0;
+      }
+      else
+      {
+        constexpr const uint8 bit = 1_u8 << number;
+        if (__likely(!(serial_rx_pending & bit)))
+        {
+          return false;
+        }
+        if (get_serial_device().available() > 0)
+        {
+          return true;
+        }
+        // Clear the bit before looking again, so a byte stored in between sets it anew.
+        {
+          critical_section _critsec;
+          serial_rx_pending &= ~bit;
+        }
+        return get_serial_device().available() > 0;
+      }
+    }
+
     // TODO handle -1. Didn't want this to be an int.
     static inline __forceinline __flatten uint8 read()
     {
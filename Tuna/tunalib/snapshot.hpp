@@ -0,0 +1,85 @@
+#pragma once
+
+namespace Tuna
+{
+  // A count of the writes to data that one interrupt handler changes and the main loop reads, so
+  // the reader can take a consistent copy without turning interrupts off. The handler holds a
+  // writer while it changes the data, which counts one write as it goes. The reader copies the data
+  // between two reads of the count, and copies again if a write came in between. The main loop
+  // can't interrupt a handler, so the data is never seen half written.
+  //
+  // Readers must not be handlers that can preempt the writer. A copy that loses to the writer
+  // 'max_tries' times in a row is taken with interrupts off, so a slow reader still finishes.
+  class sequence_count final
+  {
+    volatile uint8 m_Count = 0;
+
+  public:
+    static constexpr const uint8 max_tries = 4;
+
+    class writer final
+    {
+      sequence_count & __restrict m_Sequence;
+
+    public:
+      writer(const writer &) = delete;
+      writer(writer &&) = delete;
+      writer & operator = (const writer &) = delete;
+      writer & operator = (writer &&) = delete;
+
+      inline __forceinline __flatten writer(sequence_count & __restrict sequence) : m_Sequence(sequence) {}
+
+      inline __forceinline __flatten ~writer()
+      {
+        __memorybarrier;
+        m_Sequence.m_Count = uint8(m_Sequence.m_Count + 1);
+      }
+    };
+
+    // Calls 'copy' until it runs without a write, or in a critical section after max_tries.
+    template <typename F>
+    inline __forceinline __flatten void read(F && __restrict copy) const
+    {
+      for (uint8 tries = max_tries; tries != 0; --tries)
+      {
+        const uint8 start = m_Count;
+        __memorybarrier;
+        copy();
+        __memorybarrier;
+        if (__likely(m_Count == start))
+        {
+          return;
+        }
+      }
+
+      critical_section _critsec;
+      copy();
+    }
+  };
+
+  // A value of 'T' written whole by one interrupt handler and read by the main loop, as above.
+  template <typename T>
+  class atomic_snapshot final
+  {
+    T m_Value {};
+    sequence_count m_Sequence;
+
+  public:
+    constexpr atomic_snapshot() = default;
+    constexpr atomic_snapshot(arg_type<T> value) : m_Value(value) {}
+
+    // From the writing handler.
+    inline __forceinline __flatten void write(arg_type<T> value)
+    {
+      const sequence_count::writer _written(m_Sequence);
+      m_Value = value;
+    }
+
+    inline __forceinline __flatten T read() const
+    {
+      T value;
+      m_Sequence.read([&]() { value = m_Value; });
+      return value;
+    }
+  };
+}
@@ -0,0 +1,95 @@
+#pragma once
+
+namespace Tuna::sram
+{
+  // The chip's SRAM: .data and .bss from the bottom, then the heap, and the stack down from the top.
+  constexpr const usize size = usize(RAMEND - RAMSTART + 1);
+
+  // One entry of a static SRAM budget: a short name for the boot report, and its bytes.
+  // Budgets are kept in flash, so total() and fits() may only be used at compile time, and
+  // bytes() reads one at run time.
+  struct region final
+  {
+    char name[12];
+    usize bytes;
+  };
+
+  template <usize N>
+  constexpr usize total(const region (&regions)[N])
+  {
+    usize sum = 0;
+    for (const region &entry : regions)
+    {
+      sum += entry.bytes;
+    }
+    return sum;
+  }
+
+  template <usize N>
+  constexpr bool fits(const region (&regions)[N], arg_type<usize> reserve)
+  {
+    return total(regions) <= size && reserve <= size - total(regions);
+  }
+
+  // .data and .bss as linked, everything static, listed in a budget or not.
+  inline usize static_bytes()
+  {
+    extern char __bss_end;
+    return usize(reinterpret_cast<usize>(&__bss_end) - RAMSTART);
+  }
+
+  // The bytes of regions[index], which is in flash.
+  template <usize N>
+  inline usize bytes(const region (&regions)[N], arg_type<uint8> index)
+  {
+    return read_pgm<usize>(regions[index].bytes);
+  }
+
+  // What STACK_PAINTING fills the free SRAM with at boot, before anything runs.
+  constexpr const uint8 stack_canary = 0xC5;
+
+  // The lowest the stack may reach: the end of the heap, or where it would start. Above .noinit,
+  // which painting has to leave alone.
+  inline uint8 *stack_floor()
+  {
+    extern char __heap_start;
+    extern char *__brkval;
+    return reinterpret_cast<uint8 *>(__brkval ? __brkval : &__heap_start);
+  }
+
+  // The bytes above the floor the stack has never reached since it was painted, counted up to the
+  // first one that isn't the canary. A pushed byte that happens to be 0xC5 reads as unused, so it
+  // may be a byte or two high.
+  inline usize stack_unused()
+  {
+    const volatile uint8 *p = stack_floor();
+    const uint8 *const top = reinterpret_cast<const uint8 *>(RAMEND);
+    usize unused = 0;
+    while (p <= top && *p == stack_canary)
+    {
+      ++p;
+      ++unused;
+    }
+    return unused;
+  }
+
+  // The most the stack has held since it was painted, from the top of SRAM down.
+  inline usize stack_peak()
+  {
+    return usize(RAMEND + 1 - reinterpret_cast<usize>(stack_floor())) - stack_unused();
+  }
+
+  // Paints everything below the stack pointer again, for a fresh high-water mark. Interrupts stay
+  // off, as their frames would be pushed right into it. The writes are volatile, so they aren't
+  // turned into a call to memset, whose own return address would be under the paint.
+  inline void repaint_stack()
+  {
+    critical_section _critsec;
+    volatile uint8 *p = stack_floor();
+    const uint8 *const end = reinterpret_cast<const uint8 *>(SP);
+    while (p < end)
+    {
+      *p++ = stack_canary;
+    }
+  }
+}
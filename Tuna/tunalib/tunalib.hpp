@@ -17,6 +17,13 @@
 #include "tunalib/serial.hpp"
 #include "tunalib/algorithm_impl.hpp"
 #include "tunalib/debug.hpp"
+#include "tunalib/format.hpp"
 #include "tunalib/memory.hpp"
+#include "tunalib/sram.hpp"
+#include "tunalib/ring.hpp"
+#include "tunalib/snapshot.hpp"
+#include "tunalib/scratch.hpp"
+#include "tunalib/scheduler.hpp"
+#include "tunalib/parse.hpp"
 
 using namespace Tuna;
@@ -42,3 +42,34 @@ namespace Tuna
     return (volatile uint8 & __restrict)::timer0_millis;
   }
 }
+
+namespace Tuna::chrono::_internal
+{
+  uint32 now_ms = 0;
+}
+
+#if ENABLED(STACK_PAINTING)
+namespace Tuna::sram
+{
+  // Fills the SRAM from the heap's start to the top with the canary. .init3 runs after the stack
+  // pointer is set and r1 is cleared, and before .data and .bss are set up or anything is called,
+  // so nothing is on the stack yet. Init sections fall through into each other: it's naked, has no
+  // ret, and only uses registers.
+  extern "C" void __attribute__((naked, used, section(".init3"))) __tuna_paint_stack()
+  {
+    __asm__ __volatile__(
+      "ldi r30, lo8(__heap_start)" "\n\t"
+      "ldi r31, hi8(__heap_start)" "\n\t"
+      "ldi r24, %[canary]"         "\n\t"
+      "ldi r25, hi8(%[end])"       "\n\t"
+      "1: st Z+, r24"              "\n\t"
+      "cpi r30, lo8(%[end])"       "\n\t"
+      "cpc r31, r25"               "\n\t"
+      "brne 1b"                    "\n\t"
+      :
+      : [canary] "M" (stack_canary), [end] "n" (RAMEND + 1)
+      : "r24", "r25", "r30", "r31", "memory"
+    );
+  }
+}
+#endif
@@ -25,6 +25,10 @@
 #include "utility.h"
 #include "thermal/thermal.hpp"
 
+#if ENABLED(EEPROM_SETTINGS)
+  #include <util/crc16.h>
+#endif
+
 void __forceinline safe_delay(millis_t ms) {
   while (ms > 50) {
     ms -= 50;
@@ -37,13 +41,12 @@ void __forceinline safe_delay(millis_t ms) {
 
 #if ENABLED(EEPROM_SETTINGS)
 
+  // CRC-16/XMODEM (0x1021, MSB first), as before, with avr-libc's loop-free update for each byte.
   void crc16(uint16_t * __restrict crc, const void * const __restrict data, uint16_t cnt) {
     const uint8_t * __restrict ptr = (const uint8_t * __restrict)data;
-    while (cnt--) {
-      *crc = (uint16_t)(*crc ^ (uint16_t)(((uint16_t)*ptr++) << 8));
-      for (uint8_t x = 0; x < 8; x++)
-        *crc = (uint16_t)((*crc & 0x8000) ? ((uint16_t)(*crc << 1) ^ 0x1021) : (*crc << 1));
-    }
+    uint16_t value = *crc;
+    while (cnt--) value = _crc_xmodem_update(value, *ptr++);
+    *crc = value;
   }
 
 #endif // EEPROM_SETTINGS
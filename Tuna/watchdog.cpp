@@ -26,9 +26,74 @@
 
 #include "watchdog.h"
 
+#if ENABLED(WATCHDOG_STALL_REPORT)
+
+  /**
+   * What the watchdog interrupt caught, kept over its reset in .noinit. The interrupt comes at
+   * 2 seconds and leaves WDIE cleared, so it resets at 4 unless the loop feeds it first. 'pc' is
+   * the word address the loop was at, without bit 16 (__builtin_return_address is 16 bits), and
+   * 'stalled_ms' stays 0 if it never came back. A stall with interrupts off resets without one.
+   */
+  struct stall_record {
+    uint16_t magic;
+    uint16_t pc;
+    uint8_t task;
+    millis_t caught_ms;
+    millis_t stalled_ms;
+  };
+
+  static constexpr uint16_t stall_magic = 0x57A1;
+  static stall_record stall __attribute__((section(".noinit")));
+
+  volatile bool watchdog_stalled = false;
+
+  static void print_stall() {
+    SERIAL_ECHOPGM("Main loop stalled");
+    if (stall.task != 0xFF) SERIAL_ECHOPAIR(" in task ", stall.task);
+    SERIAL_ECHOPGM(" at 0x");
+    SERIAL_ECHO_F(uint32_t(stall.pc) << 1, HEX);
+    if (stall.stalled_ms) {
+      SERIAL_ECHOPAIR(" for ", stall.stalled_ms);
+      SERIAL_ECHOLNPGM("ms");
+    }
+    else
+      SERIAL_ECHOLNPGM(", reset");
+  }
+
+  // Fed again: how long it was stuck, from the 2 seconds it took to catch it
+  void watchdog_recovered() {
+    stall.stalled_ms = 2000 + (millis() - stall.caught_ms);
+    watchdog_stalled = false;
+    _WD_CONTROL_REG |= _BV(WDIE);
+
+    SERIAL_ECHO_START();
+    print_stall();
+  }
+
+  void watchdog_report_stall(const uint8_t mcusr) {
+    const bool reset = TEST(mcusr, WDRF);
+    if (stall.magic == stall_magic && (reset || stall.stalled_ms)) {
+      SERIAL_ECHO_START();
+      print_stall();
+    }
+    else if (reset) {
+      SERIAL_ECHO_START();
+      SERIAL_ECHOLNPGM("Watchdog reset with interrupts off, no stall caught");
+    }
+    stall.magic = 0;
+  }
+
+#endif // WATCHDOG_STALL_REPORT
+
 // Initialize watchdog with a 4 sec interrupt time
 void watchdog_init() {
-  #if ENABLED(WATCHDOG_RESET_MANUAL)
+  #if ENABLED(WATCHDOG_STALL_REPORT)
+    // Interrupt and reset: the interrupt at 2 seconds, the reset a period later, as before
+    critical_section _critsec;
+    wdt_reset();
+    _WD_CONTROL_REG = _BV(_WD_CHANGE_BIT) | _BV(WDE);
+    _WD_CONTROL_REG = _BV(WDIE) | _BV(WDE) | WDTO_2S;
+  #elif ENABLED(WATCHDOG_RESET_MANUAL)
     // We enable the watchdog timer, but only for the interrupt.
     // Take care, as this requires the correct order of operation, with interrupts disabled. See the datasheet of any AVR chip for details.
     wdt_reset();
@@ -52,6 +117,16 @@ __signal(WDT_vect)
     kill(PSTR("ERR:Please Reset")); //kill blocks //16 characters so it fits on a 16x2 display
     while (1); //wait for user or serial reset
   }
+#elif ENABLED(WATCHDOG_STALL_REPORT)
+__signal(WDT_vect)
+  {
+    stall.magic = stall_magic;
+    stall.pc = uint16_t(__builtin_return_address(0));
+    stall.task = watchdog_task();
+    stall.caught_ms = millis();
+    stall.stalled_ms = 0;
+    watchdog_stalled = true;
+  }
 #endif // WATCHDOG_RESET_MANUAL
 
 #endif // USE_WATCHDOG
@@ -28,4 +28,22 @@
 // Initialize watchdog with a 4 second interrupt time
 void watchdog_init();
 
+#if ENABLED(WATCHDOG_STALL_REPORT)
+  // Set by the watchdog interrupt when the main loop is 2 seconds late feeding it, until it does
+  extern volatile bool watchdog_stalled;
+  void watchdog_recovered();
+  // The last stall, reported in setup(), whether it reset the board or the loop came back
+  void watchdog_report_stall(const uint8_t mcusr);
+  // The idle() task that was running, or 0xFF for none; Marlin_main has the scheduler
+  uint8_t watchdog_task();
+#endif
+
+// Feed the watchdog, once there's a fresh temperature to keep the heaters safe with
+inline void watchdog_reset() {
+  #if ENABLED(WATCHDOG_STALL_REPORT)
+    if (__unlikely(watchdog_stalled)) watchdog_recovered();
+  #endif
+  Tuna::intrinsic::wdr();
+}
+
 #endif
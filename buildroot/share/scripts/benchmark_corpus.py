@@ -0,0 +1,239 @@
+#!/usr/bin/env python3
+
+""" Write the G-code benchmark corpus, so every benchmark measures the same work.
+
+Each workload stands for a kind of file that is hard on some part of the
+firmware. They're generated, the same bytes every time for a version of this
+script, rather than taken from a slicer, so they can be made again anywhere:
+
+  TINYSEG.GCO  Circles in 0.1 mm segments, as from a finely tessellated STL:
+               the parser and planner at their highest line rate
+  ARCS.GCO     The same circles and rounded corners as G2/G3, as ArcWelder
+               writes them: the arc code (build with ARC_SUPPORT)
+  VASE.GCO     A spiral vase, Z rising on every segment: no layer changes
+               and every block moving three axes
+  GYROID.GCO   Gyroid infill: long runs of short curving segments with
+               direction and speed changing on every one
+  RETRACT.GCO  A plate of 16 small parts: retract, travel and prime for each
+               part of each layer, so short blocks and junction stops
+  THUMBS.GCO   Three large base64 thumbnails, then a layer of TINYSEG: the
+               comment handling of the serial and SD readers
+
+Every file starts with "; corpus <name> v<version>". Results are only
+comparable between the same versions; the version goes up whenever the
+output changes. The files heat nothing and home nothing: they start with G92
+and are meant to be run dry (M111 S8), with the moves but not the filament.
+
+The metrics, as cycle_benchmark.py --corpus reports them for each workload:
+
+  lines_per_s       Lines the firmware took per second, timed by the host
+                    from the first line sent to the "ok" of the M400 after
+                    the last, one line in flight
+  parse_us          Microseconds per line parsed (M291, PIPELINE_PROFILING)
+  blocks_per_s      Planner blocks added per second (M296, PLANNER_PROFILING)
+  lowest_depth      The fewest blocks the planner held while it ran (M296)
+  stepper_isr_load  Percent of the CPU in the stepper ISR over the run
+                    (M297, ISR_PROFILING)
+  sd_kb_s           File read kB/s of the workload on the card (M288 with it
+                    selected by M23, SD_BENCHMARK; with --sd only)
+
+Higher is better for lines_per_s, blocks_per_s, lowest_depth and sd_kb_s;
+lower is better for parse_us and stepper_isr_load.
+"""
+
+import argparse
+import base64
+import math
+import os
+import random
+
+VERSION = 1
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument('output', nargs='?', default='corpus', help='Directory to write the workloads to (default=corpus)')
+parser.add_argument('--center', type=float, nargs=2, default=(100, 100), metavar=('X', 'Y'), help='Center of the prints (default=100 100)')
+args = parser.parse_args()
+
+CX, CY = args.center
+LAYER = 0.2
+WIDTH = 0.45
+FILAMENT = 1.75
+E_PER_MM = WIDTH * LAYER / (math.pi * (FILAMENT / 2) ** 2)
+
+
+class Writer:
+    """ Absolute XYZ and E, with E from the length of each extruding move. """
+
+    def __init__(self, name):
+        self.lines = ['; corpus %s v%d' % (name, VERSION), 'G21', 'G90', 'M82', 'G92 X%.3f Y%.3f Z0 E0' % (CX, CY)]
+        self.x, self.y, self.z, self.e = CX, CY, 0.0, 0.0
+
+    def travel(self, x, y, z=None, f=9000):
+        self.z = self.z if z is None else z
+        self.lines.append('G0 X%.3f Y%.3f Z%.3f F%d' % (x, y, self.z, f))
+        self.x, self.y = x, y
+
+    def extrude(self, x, y, z=None, f=None):
+        z = self.z if z is None else z
+        self.e += math.sqrt((x - self.x) ** 2 + (y - self.y) ** 2 + (z - self.z) ** 2) * E_PER_MM
+        line = 'G1 X%.3f Y%.3f' % (x, y)
+        if z != self.z:
+            line += ' Z%.3f' % z
+        line += ' E%.5f' % self.e
+        if f:
+            line += ' F%d' % f
+        self.lines.append(line)
+        self.x, self.y, self.z = x, y, z
+
+    def arc(self, clockwise, x, y, i, j, length, f=None):
+        self.e += length * E_PER_MM
+        line = '%s X%.3f Y%.3f I%.3f J%.3f E%.5f' % ('G2' if clockwise else 'G3', x, y, i, j, self.e)
+        if f:
+            line += ' F%d' % f
+        self.lines.append(line)
+        self.x, self.y = x, y
+
+    def retract(self, length=0.8, f=2400):
+        self.e -= length
+        self.lines.append('G1 E%.5f F%d' % (self.e, f))
+
+    def prime(self, length=0.8, f=2400):
+        self.e += length
+        self.lines.append('G1 E%.5f F%d' % (self.e, f))
+
+    def save(self, filename):
+        with open(os.path.join(args.output, filename), 'w') as f:
+            f.write('\n'.join(self.lines + ['M400', '']))
+        print('%s: %d lines' % (filename, len(self.lines) + 1))
+
+
+def circles(w, layers, radii, segment):
+    for layer in range(layers):
+        z = (layer + 1) * LAYER
+        for r in radii:
+            steps = max(8, int(2 * math.pi * r / segment))
+            w.travel(CX + r, CY, z)
+            for s in range(1, steps + 1):
+                a = 2 * math.pi * s / steps
+                w.extrude(CX + r * math.cos(a), CY + r * math.sin(a), f=4800 if s == 1 else None)
+
+
+def tiny_segments():
+    w = Writer('TINYSEG')
+    circles(w, 10, (5, 10, 20, 30), 0.1)
+    w.save('TINYSEG.GCO')
+
+
+def arcs():
+    w = Writer('ARCS')
+    for layer in range(40):
+        z = (layer + 1) * LAYER
+        for r in (5, 10, 20, 30):
+            # A circle in four quarters
+            w.travel(CX + r, CY, z)
+            for q in range(1, 5):
+                a = math.pi / 2 * q
+                w.arc(False, CX + r * math.cos(a), CY + r * math.sin(a), CX - w.x, CY - w.y, math.pi / 2 * r, f=4800 if q == 1 else None)
+        # A 60 x 40 rectangle with 5 mm round corners, lines and arcs in turn
+        hx, hy, c = 30, 20, 5
+        w.travel(CX - hx + c, CY - hy)
+        for (x1, y1), (x2, y2), (ci, cj) in (
+                ((CX + hx - c, CY - hy), (CX + hx, CY - hy + c), (0, c)),
+                ((CX + hx, CY + hy - c), (CX + hx - c, CY + hy), (-c, 0)),
+                ((CX - hx + c, CY + hy), (CX - hx, CY + hy - c), (0, -c)),
+                ((CX - hx, CY - hy + c), (CX - hx + c, CY - hy), (c, 0))):
+            w.extrude(x1, y1)
+            w.arc(False, x2, y2, ci, cj, math.pi / 2 * c)
+    w.save('ARCS.GCO')
+
+
+def vase():
+    w = Writer('VASE')
+    r, segment, layers = 25.0, 0.5, 100
+    steps = int(2 * math.pi * r / segment)
+    w.travel(CX + r, CY, LAYER)
+    for s in range(1, steps * layers + 1):
+        a = 2 * math.pi * s / steps
+        # A slow wave in the wall, so the segments aren't all the same
+        rs = r + 2 * math.sin(s * 2 * math.pi / (steps * 10))
+        w.extrude(CX + rs * math.cos(a), CY + rs * math.sin(a), LAYER + LAYER * s / steps, f=2400 if s == 1 else None)
+    w.save('VASE.GCO')
+
+
+def gyroid():
+    w = Writer('GYROID')
+    size, period, segment = 40.0, 10.0, 0.4
+    k = 2 * math.pi / period
+    for layer in range(20):
+        z = (layer + 1) * LAYER
+        gz = z * k
+        # sin(x)cos(y) + sin(y)cos(z) + sin(z)cos(x) = 0, solved for y on one branch, for each
+        # period of y across the square; every other line back the other way
+        lines = int(size / period) + 1
+        for n in range(lines):
+            xs = [i * segment for i in range(int(size / segment) + 1)]
+            if n % 2:
+                xs.reverse()
+            points = []
+            for x in xs:
+                gx = x * k
+                a, b, c = math.sin(gx), math.cos(gz), math.sin(gz) * math.cos(gx)
+                r = math.hypot(a, b)
+                if r == 0 or abs(c) > r:
+                    continue
+                y = (math.atan2(b, a) + math.acos(-c / r)) / k + n * period
+                if 0 <= y <= size:
+                    points.append((CX - size / 2 + x, CY - size / 2 + y))
+            # Where the branch leaves the square or has no solution, the line breaks into runs
+            runs = []
+            for p in points:
+                if runs and math.hypot(p[0] - runs[-1][-1][0], p[1] - runs[-1][-1][1]) < 3 * segment:
+                    runs[-1].append(p)
+                else:
+                    runs.append([p])
+            for run in runs:
+                if len(run) < 2:
+                    continue
+                w.travel(run[0][0], run[0][1], z)
+                for i, (x, y) in enumerate(run[1:]):
+                    w.extrude(x, y, f=6000 if i == 0 else None)
+    w.save('GYROID.GCO')
+
+
+def retraction_plate():
+    w = Writer('RETRACT')
+    side, pitch = 5.0, 15.0
+    for layer in range(30):
+        z = (layer + 1) * LAYER
+        for part in range(16):
+            px = CX - 1.5 * pitch + (part % 4) * pitch
+            py = CY - 1.5 * pitch + (part // 4) * pitch
+            w.retract()
+            w.travel(px, py, z)
+            w.prime()
+            for x, y in ((px + side, py), (px + side, py + side), (px, py + side), (px, py)):
+                w.extrude(x, y, f=3000)
+    w.save('RETRACT.GCO')
+
+
+def thumbnails():
+    w = Writer('THUMBS')
+    rng = random.Random(VERSION)
+    header = []
+    for width, height, size in ((16, 16, 1024), (220, 124, 24000), (300, 300, 64000)):
+        data = base64.b64encode(bytes(rng.getrandbits(8) for _ in range(size))).decode('ascii')
+        header.append('; thumbnail begin %dx%d %d' % (width, height, len(data)))
+        header += ['; ' + data[i:i + 78] for i in range(0, len(data), 78)]
+        header += ['; thumbnail end', ';']
+    w.lines[1:1] = header
+    circles(w, 1, (5, 10, 20, 30), 0.1)
+    w.save('THUMBS.GCO')
+
+
+os.makedirs(args.output, exist_ok=True)
+tiny_segments()
+arcs()
+vase()
+gyroid()
+retraction_plate()
+thumbnails()
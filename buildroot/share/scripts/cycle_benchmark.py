@@ -0,0 +1,206 @@
+#!/usr/bin/env python3
+
+""" Measure the firmware's cycle costs and compare them to a stored baseline.
+
+The printer does the timing itself, with the profiling options of
+Configuration_adv.h, so the numbers include the soft-float and the interrupts
+as they really run. Any of them can be left out; the script skips what the
+build doesn't answer:
+
+  ISR_PROFILING       M297: cycles per Stepper, Advance and Temperature ISR
+  PIPELINE_PROFILING  M291: microseconds per G1 parsed and run, and per parse
+  PLANNER_PROFILING   M296: microseconds per planner segment
+
+It homes nothing and extrudes nothing: it sets the position with G92 and moves
+X back and forth at each --rates step rate, then replays a G-code file if one
+is given. The port can be a printer, or the UART of a simulator running the
+same .hex, such as a simavr or simulavr pty.
+
+With --corpus, it then runs each workload of benchmark_corpus.py's corpus
+dry (M111 S8), and reports the corpus metrics that script defines for each,
+as <workload>.<metric>. With --sd, the workloads are also on the card, under
+the same names, and M288 reads each one.
+
+Results are printed and, with --save, stored as JSON. With --baseline, every
+value is compared to the stored one, and the script exits with 1 if any is
+worse than it by more than --tolerance percent: higher for the costs, lower
+for the corpus rates. It needs pyserial.
+"""
+
+import argparse
+import json
+import os
+import re
+import sys
+import time
+
+import serial
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument('port', help='Serial port of the printer or simulator')
+parser.add_argument('-b', '--baud', type=int, default=250000, help='Baud rate (default=250000)')
+parser.add_argument('-g', '--gcode', help='G-code file to replay after the step rate runs')
+parser.add_argument('--corpus', help='Directory of the benchmark_corpus.py workloads to run after the rest')
+parser.add_argument('--sd', action='store_true', help='The corpus is also on the card: time reading it with M288')
+parser.add_argument('--rates', type=int, nargs='+', default=[2000, 8000, 20000, 40000], help='X step rates to time the stepper ISR at (default=2000 8000 20000 40000)')
+parser.add_argument('--steps-per-mm', type=float, default=80, help='X steps per mm of the printer (default=80)')
+parser.add_argument('--length', type=float, default=50, help='mm of each X move (default=50)')
+parser.add_argument('--moves', type=int, default=20, help='Moves at each step rate (default=20)')
+parser.add_argument('--cpu', type=float, default=16, help='F_CPU in MHz, to turn microseconds into cycles (default=16)')
+parser.add_argument('--save', help='Write the results to this JSON file')
+parser.add_argument('--baseline', help='Compare to the results in this JSON file')
+parser.add_argument('--tolerance', type=float, default=2.0, help='Percent over the baseline allowed (default=2)')
+parser.add_argument('-t', '--timeout', type=float, default=30.0, help='Seconds to wait for an "ok" (default=30)')
+args = parser.parse_args()
+
+port = serial.Serial(args.port, args.baud, timeout=args.timeout)
+FIELD = re.compile(r'(\w+):(-?[0-9.]+)')
+
+
+def command(line):
+    """ Send a line, and return what it answered before its "ok", without "echo:". """
+    port.write((line + '\n').encode('ascii'))
+    replies = []
+    while True:
+        reply = port.readline().decode('ascii', 'replace').strip()
+        if not reply:
+            sys.exit('No "ok" to %s' % line)
+        if reply.startswith('ok'):
+            return replies
+        replies.append(reply[5:] if reply.startswith('echo:') else reply)
+
+
+def report(line):
+    """ The report of 'line' as { name: { field: value } }, or None if the build doesn't have it. """
+    replies = command(line)
+    if any('Unknown command' in r for r in replies):
+        return None
+    sections = {}
+    for r in replies:
+        name = r.split(' ', 1)[0]
+        fields = {k: float(v) for k, v in FIELD.findall(r)}
+        if fields:
+            sections[name.rstrip(':')] = fields
+    return sections
+
+
+results = {}
+available = {code: report(code + ' R') is not None for code in ('M297', 'M296', 'M291')}
+if not any(available.values()):
+    sys.exit('The build has none of ISR_PROFILING, PIPELINE_PROFILING and PLANNER_PROFILING')
+
+command('G21')
+command('G90')
+command('G92 X0 Y0 Z0 E0')
+
+for rate in args.rates:
+    feedrate = rate / args.steps_per_mm * 60
+    for code in ('M297', 'M296', 'M291'):
+        if available[code]:
+            report(code + ' R')
+    for i in range(args.moves):
+        command('G1 X%.3f F%.0f' % (args.length if i % 2 == 0 else 0, feedrate))
+    command('M400')
+    if available['M297']:
+        isrs = report('M297')
+        stepper = isrs.get('Stepper', {})
+        if stepper.get('calls'):
+            results['stepper_isr_cycles@%d' % rate] = stepper['avg']
+            results['stepper_isr_max_cycles@%d' % rate] = stepper['max']
+            results['stepper_isr_overruns@%d' % rate] = stepper.get('overruns', 0)
+        temperature = isrs.get('Temperature', {})
+        if temperature.get('calls'):
+            results['temperature_isr_cycles@%d' % rate] = temperature['avg']
+
+if args.gcode:
+    for code in ('M297', 'M296', 'M291'):
+        if available[code]:
+            report(code + ' R')
+    with open(args.gcode) as f:
+        for raw in f:
+            line = raw.split(';', 1)[0].strip()
+            if line:
+                command(line)
+    command('M400')
+
+if available['M291']:
+    pipeline = report('M291')
+    for name, key in (('G0/G1', 'g1_cycles'), ('Parse', 'parse_cycles')):
+        section = pipeline.get(name, {})
+        if section.get('calls'):
+            results[key] = section['avg'] * args.cpu
+if available['M296']:
+    planner = report('M296').get('Planner', {})
+    if planner.get('segments'):
+        results['planner_segment_cycles'] = planner['avg_us'] * args.cpu
+if available['M297'] and args.gcode:
+    isrs = report('M297')
+    for name in ('Stepper', 'Advance', 'Temperature'):
+        section = isrs.get(name, {})
+        if section.get('calls'):
+            results['%s_isr_cycles' % name.lower()] = section['avg']
+
+# Corpus metrics where more is better; every other value is a cost
+HIGHER_IS_BETTER = ('lines_per_s', 'blocks_per_s', 'lowest_depth', 'sd_kb_s')
+
+if args.corpus:
+    command('M111 S8')
+    for filename in sorted(f for f in os.listdir(args.corpus) if f.upper().endswith('.GCO')):
+        workload = filename[:-4].upper()
+        with open(os.path.join(args.corpus, filename)) as f:
+            lines = [line for line in (raw.split(';', 1)[0].strip() for raw in f) if line]
+        for code in ('M297', 'M296', 'M291'):
+            if available[code]:
+                report(code + ' R')
+        start = time.monotonic()
+        for line in lines:
+            command(line)
+        command('M400')
+        elapsed = time.monotonic() - start
+        results[workload + '.lines_per_s'] = len(lines) / elapsed
+        if available['M291']:
+            parse = report('M291').get('Parse', {})
+            if parse.get('calls'):
+                results[workload + '.parse_us'] = parse['avg']
+        if available['M296']:
+            planner = report('M296').get('Planner', {})
+            if planner.get('segments'):
+                results[workload + '.blocks_per_s'] = planner['per_s']
+                results[workload + '.lowest_depth'] = planner['lowest_depth']
+        if available['M297']:
+            stepper = report('M297').get('Stepper', {})
+            if stepper.get('calls'):
+                results[workload + '.stepper_isr_load'] = stepper['calls'] * stepper['avg'] * 100.0 / (elapsed * args.cpu * 1e6)
+        if args.sd:
+            command('M23 ' + filename)
+            for r in command('M288'):
+                match = re.match(r'SD file read .*kB/s:([0-9.]+)', r)
+                if match:
+                    results[workload + '.sd_kb_s'] = float(match.group(1))
+    command('M111 S0')
+
+baseline = {}
+if args.baseline:
+    with open(args.baseline) as f:
+        baseline = json.load(f)
+
+regressions = 0
+for key in sorted(results):
+    value = results[key]
+    line = '%-34s %10.1f' % (key, value)
+    if key in baseline and baseline[key]:
+        change = (value - baseline[key]) * 100.0 / baseline[key]
+        line += '  %+6.1f%%' % change
+        worse = -change if key.rsplit('.', 1)[-1] in HIGHER_IS_BETTER else change
+        if worse > args.tolerance:
+            line += '  over'
+            regressions += 1
+    print(line)
+
+if args.save:
+    with open(args.save, 'w') as f:
+        json.dump(results, f, indent=2, sort_keys=True)
+
+if regressions:
+    print('%d over the baseline by more than %g%%' % (regressions, args.tolerance), file=sys.stderr)
+    sys.exit(1)
@@ -0,0 +1,123 @@
+#!/usr/bin/env python3
+
+""" Decode the LOG_BINARY thermal log in a capture of the printer's serial output.
+
+With LOG_BINARY, each message is a line "log:<length>" followed by <length>
+bytes, little-endian, and a newline:
+
+  uint16 tag address, uint16 format address (both in flash), uint8 depth,
+  then the arguments: 16 bits for %d %u %x %c, 32 for %l and %f, and a flash
+  address for %S
+
+The strings are read from the firmware's .hex, which has to be of the same
+build. Other lines are passed through, so the output reads as the text log
+would have. The capture can come from any terminal that saves raw bytes.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument('hex', help='The firmware .hex the printer runs')
+parser.add_argument('input', nargs='?', help='Serial capture to decode (default=stdin)')
+parser.add_argument('-q', '--quiet', action='store_true', help='Only print the log, not the other lines')
+args = parser.parse_args()
+
+CONVERSION = re.compile(rb'%([-+ #0]*[0-9]*(?:\.[0-9]+)?)(l?)([diouxXcsSfFeEgG%])')
+
+
+def read_hex(path):
+    """ The flash image of an Intel HEX file, as a dict of address to byte. """
+    flash = {}
+    base = 0
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith(':'):
+                continue
+            record = bytes.fromhex(line[1:])
+            count, address, kind = record[0], (record[1] << 8) | record[2], record[3]
+            data = record[4:4 + count]
+            if kind == 0:
+                for i, b in enumerate(data):
+                    flash[base + address + i] = b
+            elif kind == 2:
+                base = ((data[0] << 8) | data[1]) << 4
+            elif kind == 4:
+                base = ((data[0] << 8) | data[1]) << 16
+    return flash
+
+
+flash = read_hex(args.hex)
+
+
+def string_at(address):
+    """ The '\\0'-terminated string at 'address' in flash. """
+    out = bytearray()
+    while flash.get(address, 0):
+        out.append(flash[address])
+        address += 1
+    return bytes(out)
+
+
+def format_message(fmt, data):
+    """ printf 'fmt' with the arguments packed in 'data'. """
+    out = bytearray()
+    pos = 0
+    offset = 0
+    for m in CONVERSION.finditer(fmt):
+        out += fmt[pos:m.start()]
+        pos = m.end()
+        flags, long, kind = m.group(1).decode(), m.group(2), m.group(3).decode()
+        if kind == '%':
+            out += b'%'
+            continue
+        if kind in 'fFeEgG':
+            value, = struct.unpack_from('<f', data, offset)
+            offset += 4
+        elif long:
+            value, = struct.unpack_from('<i' if kind in 'di' else '<I', data, offset)
+            offset += 4
+        else:
+            value, = struct.unpack_from('<h' if kind in 'di' else '<H', data, offset)
+            offset += 2
+        if kind == 'S':
+            out += ('%' + flags + 's').encode() % string_at(value)
+        elif kind == 's':
+            out += b'<0x%04x>' % value
+        elif kind == 'u':
+            out += ('%' + flags + 'd').encode() % value
+        else:
+            out += ('%' + flags + kind).encode() % value
+    return bytes(out + fmt[pos:])
+
+
+with (open(args.input, 'rb') if args.input else sys.stdin.buffer) as capture:
+    stream = capture.read()
+
+out = sys.stdout.buffer
+pos = 0
+while pos < len(stream):
+    end = stream.find(b'\n', pos)
+    if end < 0:
+        end = len(stream)
+    line = stream[pos:end].rstrip(b'\r')
+    m = re.match(rb'(?:echo:)?log:(\d+)$', line)
+    if not m:
+        if not args.quiet:
+            out.write(line + b'\n')
+        pos = end + 1
+        continue
+    length = int(m.group(1))
+    record = stream[end + 1:end + 1 + length]
+    pos = end + 1 + length
+    if stream[pos:pos + 2] == b'\r\n':
+        pos += 2
+    elif stream[pos:pos + 1] == b'\n':
+        pos += 1
+    if len(record) < 5:
+        break
+    tag, fmt, depth = struct.unpack_from('<HHB', record)
+    out.write(string_at(tag) + b': ' + b'  ' * depth + format_message(string_at(fmt), record[5:]) + b'\n')
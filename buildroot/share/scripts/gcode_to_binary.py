@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+
+""" Convert a G-code file to a pre-parsed .tgc file for SD_BINARY_FILES.
+
+The file starts with "TGC" and the format version, 1, then holds a record for
+each command, with comments and blank lines dropped:
+
+  length, payload                 a command
+  0x80 | length, text             a line that has to stay text, without its newline
+
+The payload is as for BINARY_STREAMING: the letter and the code as a
+little-endian uint16, then the parameters. 'A'-'Z' is followed by an int32,
+'A'-'Z' | 0x80 by a float, 'a'-'z' | 0x80 by an int24 of thousandths, and
+'a'-'z' is a parameter without a value. Values are written in thousandths when
+that's exact, which the printer reads as the same float the text would give.
+
+Lines with string arguments, subcodes, or more values than the printer's
+PARSED_COMMAND_VALUES are kept as text.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument('input', help='G-code file to convert')
+parser.add_argument('output', nargs='?', help='Output file (default=input with .tgc)')
+parser.add_argument('--values', type=int, default=5, help='PARSED_COMMAND_VALUES of the printer (default=5)')
+parser.add_argument('--max-line', type=int, default=96, help='MAX_CMD_SIZE of the printer (default=96)')
+args = parser.parse_args()
+
+MAGIC = b'TGC\x01'
+STRING_CODES = {23, 28, 30, 32, 117, 118, 928}
+WORD = re.compile(r'([A-Z])\s*([-+]?[0-9]*\.?[0-9]*)')
+
+
+def value(name, text):
+    """ A parameter with a value, in the shortest form that reads back exactly. """
+    if '.' not in text:
+        return name.encode('ascii') + struct.pack('<i', int(text))
+    whole, _, fraction = text.partition('.')
+    if len(fraction.rstrip('0')) <= 3:
+        sign = -1 if whole.startswith('-') else 1
+        thousandths = int(whole.lstrip('+-') or '0') * 1000 + int((fraction + '000')[:3])
+        thousandths *= sign
+        if -(1 << 23) <= thousandths < (1 << 23):
+            return bytes([ord(name.lower()) | 0x80]) + struct.pack('<i', thousandths)[:3]
+    return bytes([ord(name) | 0x80]) + struct.pack('<f', float(text))
+
+
+def encode(line):
+    """ Pack a line as a payload, or return None if it has to stay text. """
+    m = re.match(r'([GMT])\s*(\d+)\s*(.*)$', line)
+    if not m:
+        return None
+    letter, code, rest = m.group(1), int(m.group(2)), m.group(3)
+    if letter == 'M' and code in STRING_CODES:
+        return None
+    payload = bytearray(letter.encode('ascii')) + struct.pack('<H', code)
+    values = 0
+    pos = 0
+    for word in WORD.finditer(rest):
+        if rest[pos:word.start()].strip():
+            return None
+        pos = word.end()
+        name, text = word.group(1), word.group(2)
+        if not text:
+            payload += name.lower().encode('ascii')
+            continue
+        if not re.search(r'\d', text):
+            return None
+        values += 1
+        if values > args.values:
+            return None
+        payload += value(name, text)
+    if rest[pos:].strip() or len(payload) > 3 + 5 * args.values + 26:
+        return None
+    return bytes(payload)
+
+
+def strip(line):
+    """ The line without its comment, line number, and checksum. """
+    line = line.split(';', 1)[0].split('*', 1)[0].strip()
+    return re.sub(r'^N\d+\s*', '', line)
+
+
+output = args.output or re.sub(r'\.[^./\\]*$', '', args.input) + '.tgc'
+records = text = size_in = 0
+with open(args.input, 'rb') as gcode, open(output, 'wb') as tgc:
+    tgc.write(MAGIC)
+    for raw in gcode:
+        size_in += len(raw)
+        line = strip(raw.decode('ascii', 'replace'))
+        if not line:
+            continue
+        payload = encode(line)
+        if payload is None:
+            data = line.encode('ascii', 'replace')[:min(127, args.max_line - 1)]
+            tgc.write(bytes([0x80 | len(data)]) + data)
+            text += 1
+        else:
+            tgc.write(bytes([len(payload)]) + payload)
+        records += 1
+    size_out = tgc.tell()
+
+print('%d records, %d as text: %d bytes to %d (%.1fx smaller)' % (
+    records, text, size_in, size_out, size_in / size_out if size_out else 0), file=sys.stderr)
@@ -0,0 +1,87 @@
+#!/usr/bin/env python3
+
+""" Write the G-code of a tower for finding the INPUT_SHAPING frequencies.
+
+The tower is a single-wall square, printed fast with sharp corners and a high
+acceleration, so every corner leaves ringing on the walls after it. It is
+printed in bands, and each band sets both shapers to the next frequency with
+M593 F<Hz>, from --start to --end. The ringing after the corners is least in
+the band of the axis's own frequency:
+
+  X rings on the front and back walls, just after the left and right corners
+  Y rings on the left and right walls, just after the front and back corners
+
+Measure from the bottom: band N is at (N - 1) * --band mm, with the first at
+the bed. Set the frequencies with M593 X F<Hz> and M593 Y F<Hz>, and save them
+with M500. The print ends with M501, so the stored settings come back.
+"""
+
+import argparse
+import math
+import sys
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument('output', nargs='?', help='G-code file to write (default=stdout)')
+parser.add_argument('--start', type=float, default=20, help='Frequency of the first band in Hz (default=20)')
+parser.add_argument('--end', type=float, default=60, help='Frequency of the last band in Hz (default=60)')
+parser.add_argument('--step', type=float, default=5, help='Frequency step between bands in Hz (default=5)')
+parser.add_argument('--band', type=float, default=5, help='Height of each band in mm (default=5)')
+parser.add_argument('--damping', type=float, default=0.15, help='Damping ratio for M593 D (default=0.15)')
+parser.add_argument('--type', type=int, choices=(0, 1), default=0, help='Shaper for M593 T, 0: ZV, 1: MZV (default=0)')
+parser.add_argument('--size', type=float, default=60, help='Side of the square in mm (default=60)')
+parser.add_argument('--center', type=float, nargs=2, default=(100, 100), metavar=('X', 'Y'), help='Center of the square (default=100 100)')
+parser.add_argument('--speed', type=float, default=100, help='Print speed in mm/s (default=100)')
+parser.add_argument('--accel', type=float, default=5000, help='Print acceleration in mm/s^2 (default=5000)')
+parser.add_argument('--layer', type=float, default=0.2, help='Layer height in mm (default=0.2)')
+parser.add_argument('--width', type=float, default=0.45, help='Line width in mm (default=0.45)')
+parser.add_argument('--filament', type=float, default=1.75, help='Filament diameter in mm (default=1.75)')
+parser.add_argument('--hotend', type=int, default=205, help='Hotend temperature (default=205)')
+parser.add_argument('--bed', type=int, default=60, help='Bed temperature (default=60)')
+args = parser.parse_args()
+
+if args.step <= 0 or args.end < args.start:
+    sys.exit('--end must be at least --start, and --step above 0')
+if args.start < 10 or args.end > 200:
+    sys.exit('M593 takes frequencies from 10 to 200 Hz')
+
+bands = int((args.end - args.start) / args.step + 1e-6) + 1
+layers_per_band = max(1, int(round(args.band / args.layer)))
+e_per_mm = args.width * args.layer / (math.pi * (args.filament / 2) ** 2)
+
+cx, cy = args.center
+half = args.size / 2
+corners = [(cx - half, cy - half), (cx + half, cy - half), (cx + half, cy + half), (cx - half, cy + half)]
+
+out = open(args.output, 'w') if args.output else sys.stdout
+write = out.write
+
+write('; Input shaping tower: %d bands of %g mm, %g to %g Hz\n' % (bands, layers_per_band * args.layer, args.start, args.start + (bands - 1) * args.step))
+write('M140 S%d\nM104 S%d\nG28\nM190 S%d\nM109 S%d\n' % (args.bed, args.hotend, args.bed, args.hotend))
+write('G21\nG90\nM83\nG92 E0\n')
+write('M201 X%d Y%d\nM204 P%d T%d\n' % (args.accel, args.accel, args.accel, args.accel))
+write('M593 D%g T%d\n' % (args.damping, args.type))
+
+# Prime along the front of the bed, clear of the tower
+write('G1 Z0.3 F600\nG1 X%.2f Y%.2f F6000\n' % (cx - half, cy - half - 10))
+write('G1 X%.2f E%.5f F1200\n' % (cx + half, args.size * e_per_mm * 2))
+
+feed = args.speed * 60
+z = 0.0
+for band in range(bands):
+    frequency = args.start + band * args.step
+    write('M117 Shaping %g Hz\nM593 F%g\n' % (frequency, frequency))
+    for _ in range(layers_per_band):
+        z += args.layer
+        write('G1 Z%.3f F600\n' % z)
+        write('G1 X%.2f Y%.2f F%d\n' % (corners[0][0], corners[0][1], feed))
+        for x, y in corners[1:] + corners[:1]:
+            write('G1 X%.2f Y%.2f E%.5f\n' % (x, y, args.size * e_per_mm))
+
+write('M104 S0\nM140 S0\n')
+write('G1 Z%.3f F600\n' % (z + 10))
+write('M84\nM501\n')
+write('M117 Shaping tower done\n')
+
+if args.output:
+    out.close()
+    print('%d bands of %d layers, %g to %g Hz' % (bands, layers_per_band, args.start, args.start + (bands - 1) * args.step), file=sys.stderr)
@@ -0,0 +1,110 @@
+#!/usr/bin/env python3
+
+""" Make a FIRMWARE_UPDATE image from a build's .hex (or raw .bin) for the SD card.
+
+The image is a 24-byte header, the raw firmware, and an 8-byte tag:
+
+  char magic[4] "TUNA", uint32 size (of the firmware), char version[16]
+
+all little-endian, the version '\\0'-padded. The tag is the XTEA CBC-MAC, with a
+zero IV, of the header and the firmware padded with 0xFF to 8 bytes, under the
+printer's FIRMWARE_UPDATE_KEY. Give the key as the four words of the
+configuration, e.g. --key 0x01234567,0x89abcdef,0x01234567,0x89abcdef.
+
+The version must be the SHORT_BUILD_VERSION the firmware was built with, as the
+printer compares it to its own to tell whether the update is done. By default
+it's read from Tuna/Version.h. Copy the output to the root of the card as
+FIRMWARE.TUN.
+"""
+
+import argparse
+import os
+import re
+import struct
+import sys
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument('input', help='Firmware as Intel HEX (.hex) or raw binary (.bin)')
+parser.add_argument('output', nargs='?', default='FIRMWARE.TUN', help='Output file (default=FIRMWARE.TUN)')
+parser.add_argument('-k', '--key', required=True, help='FIRMWARE_UPDATE_KEY, four comma-separated words')
+parser.add_argument('-v', '--version', help='SHORT_BUILD_VERSION of the build (default=from Version.h)')
+args = parser.parse_args()
+
+MASK = 0xFFFFFFFF
+
+
+def read_hex(path):
+    """ The bytes of an Intel HEX file from address 0, with gaps as 0xFF. """
+    data = bytearray()
+    base = 0
+    with open(path) as f:
+        for line in f:
+            line = line.strip()
+            if not line.startswith(':'):
+                continue
+            record = bytes.fromhex(line[1:])
+            if sum(record) & 0xFF:
+                sys.exit('Bad checksum in %s: %s' % (path, line))
+            count, address, kind = record[0], (record[1] << 8) | record[2], record[3]
+            payload = record[4:4 + count]
+            if kind == 0:
+                start = base + address
+                if len(data) < start + count:
+                    data.extend(b'\xff' * (start + count - len(data)))
+                data[start:start + count] = payload
+            elif kind == 1:
+                break
+            elif kind == 2:
+                base = ((payload[0] << 8) | payload[1]) << 4
+            elif kind == 4:
+                base = ((payload[0] << 8) | payload[1]) << 16
+    return bytes(data)
+
+
+def build_version():
+    path = os.path.join(os.path.dirname(os.path.abspath(__file__)), '..', '..', '..', 'Tuna', 'Version.h')
+    with open(path) as f:
+        match = re.search(r'#define\s+SHORT_BUILD_VERSION\s+"([^"]*)"', f.read())
+    if not match:
+        sys.exit('No SHORT_BUILD_VERSION in %s, give --version' % path)
+    return match.group(1)
+
+
+def encipher(v0, v1, key):
+    total = 0
+    for _ in range(32):
+        v0 = (v0 + ((((v1 << 4) ^ (v1 >> 5)) + v1) ^ (total + key[total & 3]))) & MASK
+        total = (total + 0x9E3779B9) & MASK
+        v1 = (v1 + ((((v0 << 4) ^ (v0 >> 5)) + v0) ^ (total + key[(total >> 11) & 3]))) & MASK
+    return v0, v1
+
+
+def mac(data, key):
+    m0 = m1 = 0
+    for offset in range(0, len(data), 8):
+        b0, b1 = struct.unpack_from('<II', data, offset)
+        m0, m1 = encipher(m0 ^ b0, m1 ^ b1, key)
+    return struct.pack('<II', m0, m1)
+
+
+key = [int(word, 0) & MASK for word in args.key.split(',')]
+if len(key) != 4:
+    sys.exit('The key is four words')
+
+version = (args.version or build_version()).encode('ascii')
+if len(version) > 15:
+    sys.exit('The version is at most 15 characters')
+
+if args.input.lower().endswith('.hex'):
+    firmware = read_hex(args.input)
+else:
+    with open(args.input, 'rb') as f:
+        firmware = f.read()
+
+header = b'TUNA' + struct.pack('<I', len(firmware)) + version.ljust(16, b'\0')
+padded = firmware + b'\xff' * (-len(firmware) % 8)
+
+with open(args.output, 'wb') as f:
+    f.write(header + firmware + mac(header + padded, key))
+
+print('%s: %s, %d bytes' % (args.output, version.decode('ascii'), len(firmware)))
@@ -0,0 +1,69 @@
+#!/usr/bin/env python3
+
+""" Turn the M295 step trace in a serial log into a step rate profile.
+
+Every "trace:" line the firmware printed is one sample of the stepper ISR:
+
+  trace:<block>,<step_events_completed>,<interval>,<step_loops>,<direction_bits>
+
+The step rate at a sample is step_loops * timer_rate / interval. The samples are
+written out as CSV, and plotted against time when matplotlib is available.
+Times are only exact when every ISR was recorded (M295 S1); with M295 S<N> each
+sample is taken to stand for N intervals.
+"""
+
+import argparse
+import csv
+import sys
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument('log', nargs='+', help='Serial logs holding the M295 output')
+parser.add_argument('-n', '--every', type=int, default=1, help='The N of the M295 S<N> the trace was recorded with (default=1)')
+parser.add_argument('-r', '--timer-rate', type=int, default=2000000, help='Stepper timer rate in Hz, if the log has no trace_rate line (default=2000000)')
+parser.add_argument('-o', '--output', help='Write the samples as CSV to this file instead of stdout')
+parser.add_argument('-p', '--plot', action='store_true', help='Plot the step rate with matplotlib')
+args = parser.parse_args()
+
+timer_rate = args.timer_rate
+samples = []
+time = 0.0
+
+for name in args.log:
+    with open(name) as log:
+        for line in log:
+            line = line.strip()
+            if line.startswith('echo:'):
+                line = line[5:]
+            if line.startswith('trace_rate:'):
+                timer_rate = int(line[11:])
+            elif line.startswith('trace:'):
+                block, step, interval, loops, directions = (int(field) for field in line[6:].split(','))
+                if interval == 0:
+                    continue
+                rate = loops * timer_rate / interval
+                samples.append((time, block, step, interval, loops, directions, rate))
+                time += args.every * interval / timer_rate
+
+if not samples:
+    sys.exit('No trace: lines found')
+
+out = open(args.output, 'w', newline='') if args.output else sys.stdout
+writer = csv.writer(out)
+writer.writerow(('time_s', 'block', 'step_events_completed', 'interval', 'step_loops', 'direction_bits', 'step_rate'))
+for sample in samples:
+    writer.writerow(('%.6f' % sample[0],) + sample[1:6] + ('%.1f' % sample[6],))
+if args.output:
+    out.close()
+
+if args.plot:
+    import matplotlib.pyplot as plt
+
+    plt.plot([s[0] for s in samples], [s[6] for s in samples], drawstyle='steps-post')
+    # Mark where each block starts
+    for previous, sample in zip(samples, samples[1:]):
+        if sample[1] != previous[1]:
+            plt.axvline(sample[0], color='0.85', linewidth=0.5)
+    plt.xlabel('Time (s)')
+    plt.ylabel('Step rate (steps/s)')
+    plt.title('Stepper ISR step rate')
+    plt.show()
@@ -0,0 +1,89 @@
+#!/usr/bin/env python3
+
+""" Watch the M277 binary status frames of a printer and print them as CSV.
+
+Each frame is a line "status:<length>" followed by <length> bytes: a 35-byte
+frame, little-endian, then its CRC-16/XMODEM, low byte first:
+
+  uint16 time (ms, wrapping), uint8 flags,
+  uint16 temperature, target, bed temperature, bed target (all 1/16 C),
+  uint8 heater PWM, bed PWM, int24 X, Y, Z, E (steps),
+  uint32 SD position, SD size, uint8 planned moves, queued commands
+
+The flags are 1: stopped, 2: SD printing, 4: paused, 8: endstop hit, 16: busy.
+The script starts the frames with M277 S<interval> and stops them on exit.
+Frames that fail their CRC are skipped. It needs pyserial.
+"""
+
+import argparse
+import binascii
+import csv
+import struct
+import sys
+
+import serial
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument('port', help='Serial port of the printer')
+parser.add_argument('-b', '--baud', type=int, default=250000, help='Baud rate (default=250000)')
+parser.add_argument('-i', '--interval', type=int, default=1000, help='Milliseconds between frames (default=1000)')
+parser.add_argument('-o', '--output', help='Write the frames as CSV to this file instead of stdout')
+args = parser.parse_args()
+
+HEAD = struct.Struct('<HBHHHHBB')
+TAIL = struct.Struct('<IIBB')
+FRAME_SIZE = HEAD.size + 4 * 3 + TAIL.size
+
+port = serial.Serial(args.port, args.baud, timeout=2)
+out = open(args.output, 'w', newline='') if args.output else sys.stdout
+writer = csv.writer(out)
+writer.writerow(('time_ms', 'flags', 'temperature', 'target', 'bed', 'bed_target', 'power', 'bed_power',
+                 'x', 'y', 'z', 'e', 'sd_position', 'sd_size', 'planned', 'queued'))
+
+
+def command(line):
+    port.write((line + '\n').encode('ascii'))
+
+
+def int24(data, offset):
+    return int.from_bytes(data[offset:offset + 3], 'little', signed=True)
+
+
+def read_frame():
+    """ Read lines until a status header, then the frame it announces, or None. """
+    while True:
+        line = port.readline()
+        if not line:
+            return None
+        line = line.decode('ascii', 'replace').strip()
+        if line.startswith('echo:'):
+            line = line[5:]
+        if line.startswith('status:'):
+            data = port.read(int(line[7:]))
+            port.readline()  # the newline after the frame
+            if len(data) != FRAME_SIZE + 2:
+                continue
+            if binascii.crc_hqx(data[:FRAME_SIZE], 0) != struct.unpack_from('<H', data, FRAME_SIZE)[0]:
+                continue
+            head = HEAD.unpack_from(data, 0)
+            position = [int24(data, HEAD.size + 3 * i) for i in range(4)]
+            tail = TAIL.unpack_from(data, HEAD.size + 12)
+            return head, position, tail
+
+
+command('M277 S%d' % args.interval)
+try:
+    while True:
+        frame = read_frame()
+        if frame is None:
+            continue
+        (time, flags, temperature, target, bed, bed_target, power, bed_power), position, tail = frame
+        writer.writerow((time, flags, '%.4f' % (temperature / 16.0), '%.4f' % (target / 16.0),
+                         '%.4f' % (bed / 16.0), '%.4f' % (bed_target / 16.0), power, bed_power) + tuple(position) + tail)
+        out.flush()
+except KeyboardInterrupt:
+    pass
+finally:
+    command('M277 S0')
+    if args.output:
+        out.close()
@@ -0,0 +1,75 @@
+#!/usr/bin/env python3
+
+""" Pull the M294 thermal telemetry from a printer and write it out as CSV.
+
+M294 answers with a line "telemetry:<count>" followed by <count> binary entries
+of 8 bytes, little-endian:
+
+  uint16 time (ms, wrapping), uint16 temperature, uint16 target (both 1/16 C),
+  uint8 heater PWM, uint8 bed PWM (0xFF while a bang-bang bed is heating)
+
+The script starts recording with M294 S<interval>, then polls M294 until
+interrupted, unwrapping the timestamps as it goes. It needs pyserial.
+"""
+
+import argparse
+import csv
+import struct
+import sys
+
+import serial
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument('port', help='Serial port of the printer')
+parser.add_argument('-b', '--baud', type=int, default=250000, help='Baud rate (default=250000)')
+parser.add_argument('-i', '--interval', type=int, default=100, help='Milliseconds between samples (default=100)')
+parser.add_argument('-p', '--poll', type=float, default=2.0, help='Seconds between M294 requests (default=2)')
+parser.add_argument('-o', '--output', help='Write the samples as CSV to this file instead of stdout')
+args = parser.parse_args()
+
+ENTRY = struct.Struct('<HHHBB')
+
+port = serial.Serial(args.port, args.baud, timeout=args.poll)
+out = open(args.output, 'w', newline='') if args.output else sys.stdout
+writer = csv.writer(out)
+writer.writerow(('time_s', 'temperature', 'target', 'power', 'bed_power'))
+
+
+def command(line):
+    port.write((line + '\n').encode('ascii'))
+
+
+def read_burst():
+    """ Read lines until the telemetry header, then the entries it announces. """
+    while True:
+        line = port.readline()
+        if not line:
+            return []
+        line = line.decode('ascii', 'replace').strip()
+        if line.startswith('echo:'):
+            line = line[5:]
+        if line.startswith('telemetry:'):
+            count = int(line[10:])
+            data = port.read(count * ENTRY.size)
+            port.readline()  # the newline after the entries
+            return [ENTRY.unpack_from(data, i * ENTRY.size) for i in range(len(data) // ENTRY.size)]
+
+
+command('M294 S%d' % args.interval)
+last_time = None
+elapsed = 0
+try:
+    while True:
+        command('M294')
+        for time, temperature, target, power, bed_power in read_burst():
+            if last_time is not None:
+                elapsed += (time - last_time) & 0xFFFF
+            last_time = time
+            writer.writerow(('%.3f' % (elapsed / 1000.0), '%.4f' % (temperature / 16.0), '%.4f' % (target / 16.0), power, bed_power))
+        out.flush()
+except KeyboardInterrupt:
+    pass
+finally:
+    command('M294 S0')
+    if args.output:
+        out.close()
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+
+""" Measure how fast a printer takes G-code over serial, with the M289 dry run.
+
+M289 S1 has the printer read, check, queue and parse every line and answer
+"ok", without carrying any of it out, so the numbers are those of the serial
+link, the line checks and the parser alone. The script streams a fixed mix of
+lines (mostly G1 with X, Y, E and F, some G0, travel-only G1 and M105) with
+line numbers and checksums, keeping --window lines in flight, and reports:
+
+  lines per second, from the first line sent to the last "ok"
+  "ok" latency percentiles, from sending a line to its "ok"
+  resends the printer asked for, and lines never acknowledged
+
+then the printer's own M289 report. The mix is generated from a fixed seed,
+so runs are comparable. It needs pyserial.
+"""
+
+import argparse
+import random
+import sys
+import time
+
+import serial
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument('port', help='Serial port of the printer')
+parser.add_argument('-b', '--baud', type=int, default=250000, help='Baud rate (default=250000)')
+parser.add_argument('-n', '--lines', type=int, default=5000, help='Lines to send (default=5000)')
+parser.add_argument('-w', '--window', type=int, default=4, help='Lines in flight (default=4)')
+parser.add_argument('-t', '--timeout', type=float, default=2.0, help='Seconds to wait for an "ok" (default=2)')
+parser.add_argument('--no-checksum', action='store_true', help='Send bare lines, without N and checksum')
+args = parser.parse_args()
+
+
+def line_mix(count):
+    """ The standard mix, the same for every run. """
+    rng = random.Random(289)
+    x = y = e = 0.0
+    for i in range(count):
+        roll = rng.random()
+        if roll < 0.01:
+            yield 'M105'
+            continue
+        x = round(x + rng.uniform(-5, 5), 3)
+        y = round(y + rng.uniform(-5, 5), 3)
+        if roll < 0.06:
+            yield 'G0 X%.3f Y%.3f F9000' % (x, y)
+        elif roll < 0.12:
+            yield 'G1 X%.3f Y%.3f' % (x, y)
+        else:
+            e = round(e + rng.uniform(0.01, 0.2), 5)
+            feed = ' F%d' % rng.choice((1200, 1800, 2400)) if roll > 0.9 else ''
+            yield 'G1 X%.3f Y%.3f E%.5f%s' % (x, y, e, feed)
+
+
+def framed(number, line):
+    if args.no_checksum:
+        return line
+    text = 'N%d %s' % (number, line)
+    checksum = 0
+    for c in text.encode('ascii'):
+        checksum ^= c
+    return '%s*%d' % (text, checksum)
+
+
+port = serial.Serial(args.port, args.baud, timeout=args.timeout)
+
+
+def readline():
+    return port.readline().decode('ascii', 'replace').strip()
+
+
+def command(line):
+    """ Send a line and wait for its "ok", printing anything else it answers. """
+    port.write((line + '\n').encode('ascii'))
+    while True:
+        reply = readline()
+        if reply.startswith('ok'):
+            return
+        if reply:
+            print(reply.replace('echo:', ''))
+
+
+port.reset_input_buffer()
+command('M110 N0')
+command('M289 S1')
+
+lines = [framed(i + 1, line) for i, line in enumerate(line_mix(args.lines))]
+sent = {}               # line number -> time it was last sent
+in_flight = []          # line numbers, oldest first
+latencies = []
+resends = unacked = 0
+next_line = 1
+skip_ok = False         # a resend request is followed by an "ok" of its own
+
+start = time.monotonic()
+while next_line <= len(lines) or in_flight:
+    while next_line <= len(lines) and len(in_flight) < args.window:
+        port.write((lines[next_line - 1] + '\n').encode('ascii'))
+        sent[next_line] = time.monotonic()
+        in_flight.append(next_line)
+        next_line += 1
+
+    reply = readline()
+    if not reply:
+        # Nothing for a whole timeout: count what's in flight as lost and go on
+        unacked += len(in_flight)
+        in_flight.clear()
+        continue
+    if reply.lower().startswith(('resend:', 'rs:', 'rs ')):
+        resends += 1
+        wanted = int(reply.split(':')[-1].split()[-1])
+        # The printer drops everything after the line it asked for; send from there
+        in_flight = [n for n in in_flight if n < wanted]
+        next_line = max(1, min(wanted, next_line))
+        skip_ok = True
+        continue
+    if reply.startswith('ok') and skip_ok:
+        skip_ok = False
+    elif reply.startswith('ok') and in_flight:
+        number = in_flight.pop(0)
+        latencies.append(time.monotonic() - sent[number])
+    elif not reply.startswith(('ok', 'Error:')):
+        print(reply, file=sys.stderr)
+elapsed = time.monotonic() - start
+
+command('M289 S0')
+
+
+def percentile(values, p):
+    return values[min(len(values) - 1, int(len(values) * p))] * 1000 if values else 0
+
+
+latencies.sort()
+print('lines %d in %.2f s: %.0f lines/s' % (len(lines), elapsed, len(latencies) / elapsed if elapsed else 0))
+print('ok latency ms: p50 %.2f  p90 %.2f  p99 %.2f  max %.2f' % (
+    percentile(latencies, 0.50), percentile(latencies, 0.90), percentile(latencies, 0.99), percentile(latencies, 1.0)))
+print('resends %d, unacknowledged %d' % (resends, unacked))
@@ -0,0 +1,198 @@
+#!/usr/bin/env python3
+
+""" Print a G-code file over the BINARY_STREAMING protocol.
+
+M293 switches the printer to binary packets, each one command:
+
+  0xA5, seq, length, payload, CRC-16/XMODEM of seq, length and payload (low byte first)
+
+The payload is the letter and the code as a little-endian uint16, then the
+parameters: 'A'-'Z' and an int32, 'A'-'Z' | 0x80 and a float, or 'a'-'z' for a
+parameter without a value. An empty payload goes back to text lines.
+
+The printer answers "ack:<seq> B<free>" as each packet is queued, and
+"nak:<seq>" to have everything from <seq> sent again. Packets waiting to be
+queued sit in the printer's serial receive buffer, so the window has to fit it.
+Lines that can't be packed (string arguments) are sent as text in between.
+It needs pyserial.
+
+With HOST_PLANNED_BLOCKS, a line of 'B' and 13 integers is sent as a block the
+host planned: the direction bits, the X, Y, Z and E steps, the step events
+acceleration ends on and deceleration starts after, the initial, nominal and
+final rates, the acceleration, and the LIN_ADVANCE multiplier.
+
+With STEP_QUEUE_MODE, after M278 S1, a line of 'S' and groups of 4 integers
+is sent as runs of steps: the axis byte (0-3 for X, Y, Z, E, plus 128 to run
+backwards and 64 to only keep time), then the interval in 0.5us ticks, the
+count, and the add. Up to 6 runs fit a packet.
+"""
+
+import argparse
+import re
+import struct
+import sys
+
+import serial
+
+parser = argparse.ArgumentParser(description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+parser.add_argument('port', help='Serial port of the printer')
+parser.add_argument('file', help='G-code file to print')
+parser.add_argument('-b', '--baud', type=int, default=250000, help='Baud rate (default=250000)')
+parser.add_argument('-w', '--window', type=int, default=2, help='Packets in flight (default=2)')
+args = parser.parse_args()
+
+STRING_CODES = {23, 28, 30, 32, 117, 118, 928}
+WORD = re.compile(r'([A-Z])\s*([-+]?[0-9]*\.?[0-9]*)')
+
+
+def crc16(data):
+    crc = 0
+    for byte in data:
+        crc ^= byte << 8
+        for _ in range(8):
+            crc = ((crc << 1) ^ 0x1021) if crc & 0x8000 else (crc << 1)
+            crc &= 0xFFFF
+    return crc
+
+
+def encode(line):
+    """ Pack a line as a payload, or return None if it has to go as text. """
+    m = re.match(r'([GMT])\s*(\d+)\s*(.*)$', line)
+    if not m:
+        return None
+    letter, code, rest = m.group(1), int(m.group(2)), m.group(3)
+    if letter == 'M' and code in STRING_CODES:
+        return None
+    payload = bytearray(letter.encode('ascii')) + struct.pack('<H', code)
+    pos = 0
+    for word in WORD.finditer(rest):
+        if rest[pos:word.start()].strip():
+            return None
+        pos = word.end()
+        name, value = word.group(1), word.group(2)
+        if not value:
+            payload += name.lower().encode('ascii')
+        elif '.' in value:
+            payload += bytes([ord(name) | 0x80]) + struct.pack('<f', float(value))
+        else:
+            payload += name.encode('ascii') + struct.pack('<i', int(value))
+    if rest[pos:].strip():
+        return None
+    return bytes(payload)
+
+
+def encode_block(line):
+    """ Pack a 'B' line as a host-planned block, or return None. """
+    fields = line.split()
+    if fields[0] != 'B' or len(fields) != 14 or not all(f.isdigit() for f in fields[1:]):
+        return None
+    values = [int(f) for f in fields[1:]]
+    if values[0] > 0xFF or max(values[1:]) > 0xFFFFFF:
+        return None
+    return b'B' + bytes([values[0]]) + b''.join(struct.pack('<I', v)[:3] for v in values[1:])
+
+
+def encode_steps(line):
+    """ Pack an 'S' line as runs of steps, or return None. """
+    fields = line.split()
+    if fields[0] != 'S' or len(fields) < 5 or (len(fields) - 1) % 4:
+        return None
+    try:
+        values = [int(f) for f in fields[1:]]
+    except ValueError:
+        return None
+    payload = bytearray(b'S')
+    for i in range(0, len(values), 4):
+        flags, interval, count, add = values[i:i + 4]
+        if not (0 <= flags <= 0xFF and 0 <= interval <= 0xFFFFFF and 1 <= count <= 0xFFFF and -0x8000 <= add < 0x8000):
+            return None
+        payload += bytes([flags]) + struct.pack('<I', interval)[:3] + struct.pack('<Hh', count, add)
+    return bytes(payload)
+
+
+def packet(seq, payload):
+    body = bytes([seq, len(payload)]) + payload
+    return b'\xA5' + body + struct.pack('<H', crc16(body))
+
+
+port = serial.Serial(args.port, args.baud, timeout=5)
+
+
+def wait_for(prefix):
+    while True:
+        line = port.readline().decode('ascii', 'replace').strip()
+        if not line:
+            continue
+        if line.startswith(prefix):
+            return line
+        if not line.startswith(('ack:', 'nak:')):
+            print(line, file=sys.stderr)
+
+
+def text(line):
+    port.write((line + '\n').encode('ascii'))
+    wait_for('ok')
+
+
+class Stream:
+    def __init__(self):
+        self.active = False
+        self.seq = 0
+        self.in_flight = []         # (seq, payload), oldest first
+
+    def start(self):
+        text('M293')
+        self.active = True
+        self.seq = 0
+        self.in_flight = []
+
+    def reply(self):
+        line = wait_for(('ack:', 'nak:'))
+        seq = int(line[4:].split()[0])
+        if line.startswith('ack:'):
+            while self.in_flight and self.in_flight[0][0] != seq:
+                self.in_flight.pop(0)
+            if self.in_flight:
+                self.in_flight.pop(0)
+        else:
+            while self.in_flight and self.in_flight[0][0] != seq:
+                self.in_flight.pop(0)
+            for s, payload in self.in_flight:
+                port.write(packet(s, payload))
+
+    def send(self, payload):
+        if not self.active:
+            self.start()
+        while len(self.in_flight) >= args.window:
+            self.reply()
+        self.in_flight.append((self.seq, payload))
+        port.write(packet(self.seq, payload))
+        self.seq = (self.seq + 1) & 0xFF
+
+    def stop(self):
+        if not self.active:
+            return
+        self.send(b'')
+        while self.in_flight:
+            self.reply()
+        self.active = False
+
+
+stream = Stream()
+with open(args.file) as gcode:
+    for line in gcode:
+        line = line.split(';', 1)[0].strip()
+        if not line:
+            continue
+        if line.startswith('B'):
+            payload = encode_block(line)
+        elif line.startswith('S'):
+            payload = encode_steps(line)
+        else:
+            payload = encode(line)
+        if payload is None:
+            stream.stop()
+            text(line)
+        else:
+            stream.send(payload)
+stream.stop()